@@ -0,0 +1,51 @@
+# Exception-model benchmark: try blocks on the hot path that rarely raise.
+# Compare with: scripts/bench_exception_models.py
+
+class LimitError(Exception):
+    code: int
+
+def mix(x: int) -> int:
+    return (x * 31 + 7) % 1000003
+
+def checked_add(a: int, b: int, limit: int) -> int:
+    if a + b > limit:
+        raise LimitError("limit exceeded")
+    return a + b
+
+def bench_try_no_raise(n: int) -> int:
+    """try body never raises: may-raise elides all polling and the frame"""
+    total: int = 0
+    caught: int = 0
+    for i in range(n):
+        try:
+            total = mix(total + i)
+            total = total + 1
+        except Exception:
+            caught += 1
+    return total + caught
+
+def bench_try_may_raise(n: int) -> int:
+    """try body calls a raising function: only that call is polled"""
+    total: int = 0
+    caught: int = 0
+    for i in range(n):
+        try:
+            x: int = i % 1000
+            y: int = total % 1000
+            total = checked_add(x, y, 1990)
+            total = total + x
+        except LimitError:
+            caught += 1
+    return total + caught
+
+def bench_iterator_loop(n: int) -> int:
+    """range with a runtime step keeps the iterator protocol"""
+    step: int = 1
+    total: int = 0
+    for i in range(0, n, step):
+        total = (total + i) % 1000003
+    return total
+
+print(bench_try_no_raise(5000000))
+print(bench_try_may_raise(5000000))
+print(bench_iterator_loop(5000000))
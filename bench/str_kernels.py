@@ -0,0 +1,106 @@
+# String kernel microbenchmarks: one bench_* function per str kernel.
+# Most build a 4 KiB haystack once and call the method in a loop.
+# Run with: scripts/bench_str_kernels.py
+
+def make_text(copies: int) -> str:
+    """Prose-like ASCII text, about 64 bytes per copy"""
+    text: str = ""
+    for i in range(copies):
+        text = text + "the quick brown fox jumps over the lazy dog, again and again. "
+    return text
+
+def bench_find(n: int) -> int:
+    """Substring search that only matches at the very end"""
+    text: str = make_text(64) + "needle"
+    total: int = 0
+    for i in range(n):
+        total += text.find("needle")
+    return total
+
+def bench_find_char(n: int) -> int:
+    """Single-byte search"""
+    text: str = make_text(64) + "#"
+    total: int = 0
+    for i in range(n):
+        total += text.find("#")
+    return total
+
+def bench_count(n: int) -> int:
+    """Counting a multi-byte substring"""
+    text: str = make_text(64)
+    total: int = 0
+    for i in range(n):
+        total += text.count("the")
+    return total
+
+def bench_count_char(n: int) -> int:
+    """Counting a single byte"""
+    text: str = make_text(64)
+    total: int = 0
+    for i in range(n):
+        total += text.count(" ")
+    return total
+
+def bench_replace(n: int) -> int:
+    """Replacing a word that occurs once per sentence"""
+    text: str = make_text(64)
+    total: int = 0
+    for i in range(n):
+        total += len(text.replace("fox", "cat"))
+    return total
+
+def bench_strip(n: int) -> int:
+    """Stripping whitespace around a long string"""
+    text: str = "  \t\n" + make_text(64) + "\n\t  "
+    total: int = 0
+    for i in range(n):
+        total += len(text.strip())
+    return total
+
+def bench_isalpha(n: int) -> int:
+    """ASCII letter classification"""
+    text: str = make_text(64).replace(" ", "").replace(",", "").replace(".", "")
+    total: int = 0
+    for i in range(n):
+        if text.isalpha():
+            total += 1
+    return total
+
+def bench_isdigit(n: int) -> int:
+    """ASCII digit classification"""
+    digits: str = ""
+    for i in range(400):
+        digits = digits + "0123456789"
+    total: int = 0
+    for i in range(n):
+        if digits.isdigit():
+            total += 1
+    return total
+
+def bench_isspace(n: int) -> int:
+    """ASCII whitespace classification"""
+    spaces: str = ""
+    for i in range(1000):
+        spaces = spaces + " \t\n "
+    total: int = 0
+    for i in range(n):
+        if spaces.isspace():
+            total += 1
+    return total
+
+def bench_accumulate(n: int) -> int:
+    """Appending to a string in a loop (a string builder underneath)"""
+    text: str = ""
+    for i in range(n):
+        text = text + "word " + str(i) + "\n"
+    return len(text)
+
+def bench_join(n: int) -> int:
+    """Joining a 64-element list"""
+    words: list[str] = []
+    for i in range(64):
+        words.append("word" + str(i))
+    total: int = 0
+    for i in range(n):
+        total += len(", ".join(words))
+    return total
@@ -0,0 +1,25 @@
+# Allocating many short-lived objects and a list of long-lived ones
+
+N: int = 1000000
+
+class Point:
+    x: int
+    y: int
+
+    def __init__(self, x: int, y: int) -> None:
+        self.x = x
+        self.y = y
+
+def bench(n: int) -> int:
+    total: int = 0
+    for i in range(n):
+        p: Point = Point(i, i + 1)
+        total = (total + p.x * p.y) % 1000000007
+    kept: list[Point] = []
+    for i in range(n // 10):
+        kept.append(Point(i, i * 3))
+    for q in kept:
+        total = (total + q.y - q.x) % 1000000007
+    return total
+
+print(bench(N))
@@ -0,0 +1,23 @@
+# Raising and catching exceptions through a call
+
+N: int = 500000
+
+class LimitError(Exception):
+    code: int
+
+def check(x: int, limit: int) -> int:
+    if x > limit:
+        raise LimitError("limit exceeded")
+    return x
+
+def bench(n: int) -> int:
+    total: int = 0
+    caught: int = 0
+    for i in range(n):
+        try:
+            total = total + check(i % 100, 49)
+        except LimitError:
+            caught += 1
+    return total + caught
+
+print(bench(N))
@@ -0,0 +1,18 @@
+# Appending, indexing and updating list elements
+
+N: int = 200000
+
+def bench(n: int) -> int:
+    xs: list[int] = []
+    for i in range(n):
+        xs.append((i * 7919) % 10007)
+    total: int = 0
+    for r in range(20):
+        for i in range(1, len(xs)):
+            xs[i] = (xs[i] + xs[i - 1]) % 10007
+        total = total + xs[len(xs) - 1]
+    for x in xs:
+        total = total + x
+    return total
+
+print(bench(N))
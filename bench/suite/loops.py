@@ -0,0 +1,16 @@
+# Integer arithmetic in nested range and while loops
+
+N: int = 5000
+
+def bench(n: int) -> int:
+    total: int = 0
+    for i in range(n):
+        for j in range(n):
+            total = (total + i * j + (i ^ j)) % 1000000007
+    k: int = 0
+    while k < n * 100:
+        total = (total * 31 + k) % 1000000007
+        k += 1
+    return total
+
+print(bench(N))
@@ -0,0 +1,11 @@
+# Printing many short lines
+
+N: int = 200000
+
+def bench(n: int) -> int:
+    for i in range(n):
+        print(i)
+        print("line")
+    return n
+
+print(bench(N))
@@ -0,0 +1,18 @@
+# String building, searching and replacing
+
+N: int = 20000
+
+def bench(n: int) -> int:
+    text: str = ""
+    for i in range(256):
+        text = text + "the quick brown fox jumps over the lazy dog "
+    total: int = 0
+    for i in range(n):
+        total += text.find("lazy cat")
+        total += len(text.replace("fox", "wolf"))
+        word: str = "fox" + str(i % 10)
+        if word == "fox7":
+            total += 1
+    return total
+
+print(bench(N))
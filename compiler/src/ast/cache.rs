@@ -0,0 +1,898 @@
+//! On-disk cache of converted module ASTs
+//!
+//! Parsing goes through CPython's `ast.parse` and a conversion that walks the
+//! Python objects, both under the GIL. A module whose source has not changed
+//! converts to the same AST every time, so the converted `Module` is stored in
+//! a compact binary form and read back on the next build instead. A warm build
+//! whose modules all hit the cache never starts the Python interpreter.
+//!
+//! Entries are keyed by a hash of the compiler version, the search root, the
+//! module's path and name, and its source text. A module's AST does not depend
+//! on the contents of the modules it imports, so editing one module only
+//! invalidates its own entry. Import paths are resolved during conversion,
+//! so an entry whose imported files no longer exist is treated as a miss.
+
+use std::ffi::OsStr;
+use std::fs;
+use std::os::unix::ffi::OsStrExt;
+use std::path::{Path, PathBuf};
+
+use crate::ast::types::*;
+use crate::ast::{ImportAlias, ImportInfo, ImportKind, ModuleName};
+
+/// Bumped whenever the AST types or their encoding change
+const FORMAT_VERSION: u32 = 2;
+
+const MAGIC: &[u8; 6] = b"PYCAST";
+
+/// A directory of cached module ASTs
+pub struct ModuleCache {
+    dir: PathBuf,
+    /// Root the module names are relative to (the entry file's directory)
+    search_root: PathBuf,
+}
+
+impl ModuleCache {
+    pub fn new(dir: impl Into<PathBuf>, search_root: &Path) -> Self {
+        ModuleCache {
+            dir: dir.into(),
+            search_root: search_root.to_path_buf(),
+        }
+    }
+
+    /// The cached AST of the module at `path`, if its source is unchanged
+    pub fn load(&self, path: &Path, id: &ModuleName, source: &str) -> Option<Module> {
+        let key = self.key(path, id, source);
+        let data = fs::read(self.entry_path(key)).ok()?;
+
+        let mut reader = Reader::new(&data);
+        if reader.take(MAGIC.len())? != MAGIC
+            || reader.u32()? != FORMAT_VERSION
+            || reader.u64()? != key
+        {
+            return None;
+        }
+        let module = Module::decode(&mut reader)?;
+        if !reader.is_empty() || module.imports.iter().any(|i| !i.module_path.is_file()) {
+            return None;
+        }
+        Some(module)
+    }
+
+    /// Store the AST of a module converted from `source`. Failures only cost
+    /// a cache miss later, so they are ignored.
+    pub fn store(&self, module: &Module, source: &str) {
+        let key = self.key(&module.path, &module.id, source);
+        let mut writer = Writer::default();
+        writer.buf.extend_from_slice(MAGIC);
+        writer.u32(FORMAT_VERSION);
+        writer.u64(key);
+        module.encode(&mut writer);
+
+        // Write under a private name and rename, so a concurrent build never
+        // reads a partial entry
+        let path = self.entry_path(key);
+        let temp = path.with_extension(format!("tmp{}", std::process::id()));
+        if fs::create_dir_all(&self.dir).is_ok() && fs::write(&temp, &writer.buf).is_ok() {
+            if fs::rename(&temp, &path).is_err() {
+                let _ = fs::remove_file(&temp);
+            }
+        }
+    }
+
+    fn key(&self, path: &Path, id: &ModuleName, source: &str) -> u64 {
+        let mut hash = Fnv1a::default();
+        hash.write(env!("CARGO_PKG_VERSION").as_bytes());
+        hash.write(&FORMAT_VERSION.to_le_bytes());
+        hash.write(self.search_root.as_os_str().as_bytes());
+        hash.write(path.as_os_str().as_bytes());
+        hash.write(id.0.as_bytes());
+        hash.write(source.as_bytes());
+        hash.finish()
+    }
+
+    fn entry_path(&self, key: u64) -> PathBuf {
+        self.dir.join(format!("{key:016x}.ast"))
+    }
+}
+
+/// 64-bit FNV-1a. Stable across Rust versions, unlike `DefaultHasher`, which
+/// matters for keys that outlive the process. Each field is followed by its
+/// length so that fields cannot run into each other.
+pub(crate) struct Fnv1a(u64);
+
+impl Default for Fnv1a {
+    fn default() -> Self {
+        Fnv1a(0xcbf2_9ce4_8422_2325)
+    }
+}
+
+impl Fnv1a {
+    pub(crate) fn write(&mut self, bytes: &[u8]) {
+        for &byte in bytes.iter().chain(&(bytes.len() as u64).to_le_bytes()) {
+            self.0 ^= u64::from(byte);
+            self.0 = self.0.wrapping_mul(0x0100_0000_01b3);
+        }
+    }
+
+    pub(crate) fn finish(&self) -> u64 {
+        self.0
+    }
+}
+
+// ============================================================================
+// Binary encoding
+// ============================================================================
+
+#[derive(Default)]
+struct Writer {
+    buf: Vec<u8>,
+}
+
+impl Writer {
+    fn u8(&mut self, value: u8) {
+        self.buf.push(value);
+    }
+
+    fn u32(&mut self, value: u32) {
+        self.buf.extend_from_slice(&value.to_le_bytes());
+    }
+
+    fn u64(&mut self, value: u64) {
+        self.buf.extend_from_slice(&value.to_le_bytes());
+    }
+
+    fn bytes(&mut self, value: &[u8]) {
+        self.u64(value.len() as u64);
+        self.buf.extend_from_slice(value);
+    }
+}
+
+struct Reader<'a> {
+    data: &'a [u8],
+}
+
+impl<'a> Reader<'a> {
+    fn new(data: &'a [u8]) -> Self {
+        Reader { data }
+    }
+
+    fn is_empty(&self) -> bool {
+        self.data.is_empty()
+    }
+
+    fn take(&mut self, len: usize) -> Option<&'a [u8]> {
+        if len > self.data.len() {
+            return None;
+        }
+        let (head, rest) = self.data.split_at(len);
+        self.data = rest;
+        Some(head)
+    }
+
+    fn u8(&mut self) -> Option<u8> {
+        Some(self.take(1)?[0])
+    }
+
+    fn u32(&mut self) -> Option<u32> {
+        Some(u32::from_le_bytes(self.take(4)?.try_into().ok()?))
+    }
+
+    fn u64(&mut self) -> Option<u64> {
+        Some(u64::from_le_bytes(self.take(8)?.try_into().ok()?))
+    }
+
+    fn bytes(&mut self) -> Option<&'a [u8]> {
+        let len = usize::try_from(self.u64()?).ok()?;
+        self.take(len)
+    }
+}
+
+/// A value that can be stored in the cache. Decoding returns None for
+/// malformed data rather than panicking: a corrupt entry is just a miss.
+trait Encode: Sized {
+    fn encode(&self, w: &mut Writer);
+    fn decode(r: &mut Reader) -> Option<Self>;
+}
+
+impl Encode for bool {
+    fn encode(&self, w: &mut Writer) {
+        w.u8(*self as u8);
+    }
+    fn decode(r: &mut Reader) -> Option<Self> {
+        match r.u8()? {
+            0 => Some(false),
+            1 => Some(true),
+            _ => None,
+        }
+    }
+}
+
+impl Encode for i64 {
+    fn encode(&self, w: &mut Writer) {
+        w.u64(*self as u64);
+    }
+    fn decode(r: &mut Reader) -> Option<Self> {
+        Some(r.u64()? as i64)
+    }
+}
+
+impl Encode for f64 {
+    fn encode(&self, w: &mut Writer) {
+        w.u64(self.to_bits());
+    }
+    fn decode(r: &mut Reader) -> Option<Self> {
+        Some(f64::from_bits(r.u64()?))
+    }
+}
+
+impl Encode for String {
+    fn encode(&self, w: &mut Writer) {
+        w.bytes(self.as_bytes());
+    }
+    fn decode(r: &mut Reader) -> Option<Self> {
+        String::from_utf8(r.bytes()?.to_vec()).ok()
+    }
+}
+
+impl Encode for PathBuf {
+    fn encode(&self, w: &mut Writer) {
+        w.bytes(self.as_os_str().as_bytes());
+    }
+    fn decode(r: &mut Reader) -> Option<Self> {
+        Some(PathBuf::from(OsStr::from_bytes(r.bytes()?)))
+    }
+}
+
+impl Encode for ModuleName {
+    fn encode(&self, w: &mut Writer) {
+        self.0.encode(w);
+    }
+    fn decode(r: &mut Reader) -> Option<Self> {
+        Some(ModuleName(String::decode(r)?))
+    }
+}
+
+impl<T: Encode> Encode for Option<T> {
+    fn encode(&self, w: &mut Writer) {
+        match self {
+            None => w.u8(0),
+            Some(value) => {
+                w.u8(1);
+                value.encode(w);
+            }
+        }
+    }
+    fn decode(r: &mut Reader) -> Option<Self> {
+        match r.u8()? {
+            0 => Some(None),
+            1 => Some(Some(T::decode(r)?)),
+            _ => None,
+        }
+    }
+}
+
+impl<T: Encode> Encode for Box<T> {
+    fn encode(&self, w: &mut Writer) {
+        self.as_ref().encode(w);
+    }
+    fn decode(r: &mut Reader) -> Option<Self> {
+        Some(Box::new(T::decode(r)?))
+    }
+}
+
+impl<T: Encode> Encode for Vec<T> {
+    fn encode(&self, w: &mut Writer) {
+        w.u64(self.len() as u64);
+        for item in self {
+            item.encode(w);
+        }
+    }
+    fn decode(r: &mut Reader) -> Option<Self> {
+        let len = r.u64()?;
+        // Every item takes at least one byte, which bounds a corrupt length
+        if len > r.data.len() as u64 {
+            return None;
+        }
+        (0..len).map(|_| T::decode(r)).collect()
+    }
+}
+
+/// Encode a fieldless enum as its position in a fixed list of variants
+macro_rules! encode_unit_enum {
+    ($ty:ty { $($variant:ident),* $(,)? }) => {
+        impl Encode for $ty {
+            fn encode(&self, w: &mut Writer) {
+                const VARIANTS: &[$ty] = &[$(<$ty>::$variant),*];
+                let tag = VARIANTS.iter().position(|v| v == self).unwrap();
+                w.u8(tag as u8);
+            }
+            fn decode(r: &mut Reader) -> Option<Self> {
+                const VARIANTS: &[$ty] = &[$(<$ty>::$variant),*];
+                VARIANTS.get(r.u8()? as usize).copied()
+            }
+        }
+    };
+}
+
+encode_unit_enum!(BinOperator {
+    Add,
+    Sub,
+    Mult,
+    Div,
+    FloorDiv,
+    Mod,
+    Pow,
+    LShift,
+    RShift,
+    BitOr,
+    BitXor,
+    BitAnd,
+});
+encode_unit_enum!(CompareOp {
+    Eq,
+    NotEq,
+    Lt,
+    LtE,
+    Gt,
+    GtE,
+    In,
+    NotIn
+});
+encode_unit_enum!(BoolOp { And, Or });
+encode_unit_enum!(UnaryOp { Not, USub });
+
+impl Encode for Module {
+    fn encode(&self, w: &mut Writer) {
+        self.id.encode(w);
+        self.path.encode(w);
+        self.imports.encode(w);
+        self.body.encode(w);
+    }
+    fn decode(r: &mut Reader) -> Option<Self> {
+        Some(Module {
+            id: ModuleName::decode(r)?,
+            path: PathBuf::decode(r)?,
+            imports: Vec::decode(r)?,
+            body: Vec::decode(r)?,
+        })
+    }
+}
+
+impl Encode for ImportInfo {
+    fn encode(&self, w: &mut Writer) {
+        self.source_name.encode(w);
+        self.module_id.encode(w);
+        self.module_path.encode(w);
+        match &self.kind {
+            ImportKind::Module { alias } => {
+                w.u8(0);
+                alias.encode(w);
+            }
+            ImportKind::Names(names) => {
+                w.u8(1);
+                names.encode(w);
+            }
+            ImportKind::Star => w.u8(2),
+        }
+    }
+    fn decode(r: &mut Reader) -> Option<Self> {
+        let source_name = String::decode(r)?;
+        let module_id = ModuleName::decode(r)?;
+        let module_path = PathBuf::decode(r)?;
+        let kind = match r.u8()? {
+            0 => ImportKind::Module {
+                alias: Option::decode(r)?,
+            },
+            1 => ImportKind::Names(Vec::decode(r)?),
+            2 => ImportKind::Star,
+            _ => return None,
+        };
+        Some(ImportInfo {
+            source_name,
+            module_id,
+            module_path,
+            kind,
+        })
+    }
+}
+
+impl Encode for ImportAlias {
+    fn encode(&self, w: &mut Writer) {
+        self.name.encode(w);
+        self.alias.encode(w);
+    }
+    fn decode(r: &mut Reader) -> Option<Self> {
+        Some(ImportAlias {
+            name: String::decode(r)?,
+            alias: Option::decode(r)?,
+        })
+    }
+}
+
+impl Encode for TypeAnnotation {
+    fn encode(&self, w: &mut Writer) {
+        match self {
+            TypeAnnotation::Int => w.u8(0),
+            TypeAnnotation::Float => w.u8(1),
+            TypeAnnotation::Str => w.u8(2),
+            TypeAnnotation::Bool => w.u8(3),
+            TypeAnnotation::Bytes => w.u8(4),
+            TypeAnnotation::ByteArray => w.u8(5),
+            TypeAnnotation::List(elem) => {
+                w.u8(6);
+                elem.encode(w);
+            }
+            TypeAnnotation::Dict(key, value) => {
+                w.u8(7);
+                key.encode(w);
+                value.encode(w);
+            }
+            TypeAnnotation::Set(elem) => {
+                w.u8(8);
+                elem.encode(w);
+            }
+            TypeAnnotation::ClassName(name) => {
+                w.u8(9);
+                name.encode(w);
+            }
+        }
+    }
+    fn decode(r: &mut Reader) -> Option<Self> {
+        Some(match r.u8()? {
+            0 => TypeAnnotation::Int,
+            1 => TypeAnnotation::Float,
+            2 => TypeAnnotation::Str,
+            3 => TypeAnnotation::Bool,
+            4 => TypeAnnotation::Bytes,
+            5 => TypeAnnotation::ByteArray,
+            6 => TypeAnnotation::List(Box::decode(r)?),
+            7 => TypeAnnotation::Dict(Box::decode(r)?, Box::decode(r)?),
+            8 => TypeAnnotation::Set(Box::decode(r)?),
+            9 => TypeAnnotation::ClassName(String::decode(r)?),
+            _ => return None,
+        })
+    }
+}
+
+impl Encode for Arg {
+    fn encode(&self, w: &mut Writer) {
+        self.name.encode(w);
+        self.annotation.encode(w);
+    }
+    fn decode(r: &mut Reader) -> Option<Self> {
+        Some(Arg {
+            name: String::decode(r)?,
+            annotation: Option::decode(r)?,
+        })
+    }
+}
+
+impl Encode for ExceptHandler {
+    fn encode(&self, w: &mut Writer) {
+        self.exc_type.encode(w);
+        self.name.encode(w);
+        self.body.encode(w);
+    }
+    fn decode(r: &mut Reader) -> Option<Self> {
+        Some(ExceptHandler {
+            exc_type: Option::decode(r)?,
+            name: Option::decode(r)?,
+            body: Vec::decode(r)?,
+        })
+    }
+}
+
+impl Encode for ClassBodyItem {
+    fn encode(&self, w: &mut Writer) {
+        match self {
+            ClassBodyItem::FieldDef { name, annotation } => {
+                w.u8(0);
+                name.encode(w);
+                annotation.encode(w);
+            }
+            ClassBodyItem::MethodDef {
+                name,
+                args,
+                return_type,
+                body,
+            } => {
+                w.u8(1);
+                name.encode(w);
+                args.encode(w);
+                return_type.encode(w);
+                body.encode(w);
+            }
+        }
+    }
+    fn decode(r: &mut Reader) -> Option<Self> {
+        Some(match r.u8()? {
+            0 => ClassBodyItem::FieldDef {
+                name: String::decode(r)?,
+                annotation: TypeAnnotation::decode(r)?,
+            },
+            1 => ClassBodyItem::MethodDef {
+                name: String::decode(r)?,
+                args: Vec::decode(r)?,
+                return_type: Option::decode(r)?,
+                body: Vec::decode(r)?,
+            },
+            _ => return None,
+        })
+    }
+}
+
+impl Encode for Stmt {
+    fn encode(&self, w: &mut Writer) {
+        match self {
+            Stmt::FunctionDef {
+                name,
+                args,
+                return_type,
+                body,
+            } => {
+                w.u8(0);
+                name.encode(w);
+                args.encode(w);
+                return_type.encode(w);
+                body.encode(w);
+            }
+            Stmt::ClassDef { name, base, body } => {
+                w.u8(1);
+                name.encode(w);
+                base.encode(w);
+                body.encode(w);
+            }
+            Stmt::If { test, body, orelse } => {
+                w.u8(2);
+                test.encode(w);
+                body.encode(w);
+                orelse.encode(w);
+            }
+            Stmt::While { test, body } => {
+                w.u8(3);
+                test.encode(w);
+                body.encode(w);
+            }
+            Stmt::For { target, iter, body } => {
+                w.u8(4);
+                target.encode(w);
+                iter.encode(w);
+                body.encode(w);
+            }
+            Stmt::Return { value } => {
+                w.u8(5);
+                value.encode(w);
+            }
+            Stmt::Assign {
+                target,
+                value,
+                type_annotation,
+            } => {
+                w.u8(6);
+                target.encode(w);
+                value.encode(w);
+                type_annotation.encode(w);
+            }
+            Stmt::AugAssign { target, op, value } => {
+                w.u8(7);
+                target.encode(w);
+                op.encode(w);
+                value.encode(w);
+            }
+            Stmt::Expr { value } => {
+                w.u8(8);
+                value.encode(w);
+            }
+            Stmt::Try {
+                body,
+                handlers,
+                orelse,
+                finalbody,
+            } => {
+                w.u8(9);
+                body.encode(w);
+                handlers.encode(w);
+                orelse.encode(w);
+                finalbody.encode(w);
+            }
+            Stmt::Raise { exc } => {
+                w.u8(10);
+                exc.encode(w);
+            }
+        }
+    }
+    fn decode(r: &mut Reader) -> Option<Self> {
+        Some(match r.u8()? {
+            0 => Stmt::FunctionDef {
+                name: String::decode(r)?,
+                args: Vec::decode(r)?,
+                return_type: Option::decode(r)?,
+                body: Vec::decode(r)?,
+            },
+            1 => Stmt::ClassDef {
+                name: String::decode(r)?,
+                base: Option::decode(r)?,
+                body: Vec::decode(r)?,
+            },
+            2 => Stmt::If {
+                test: Expr::decode(r)?,
+                body: Vec::decode(r)?,
+                orelse: Vec::decode(r)?,
+            },
+            3 => Stmt::While {
+                test: Expr::decode(r)?,
+                body: Vec::decode(r)?,
+            },
+            4 => Stmt::For {
+                target: String::decode(r)?,
+                iter: Expr::decode(r)?,
+                body: Vec::decode(r)?,
+            },
+            5 => Stmt::Return {
+                value: Option::decode(r)?,
+            },
+            6 => Stmt::Assign {
+                target: Expr::decode(r)?,
+                value: Expr::decode(r)?,
+                type_annotation: Option::decode(r)?,
+            },
+            7 => Stmt::AugAssign {
+                target: String::decode(r)?,
+                op: BinOperator::decode(r)?,
+                value: Expr::decode(r)?,
+            },
+            8 => Stmt::Expr {
+                value: Expr::decode(r)?,
+            },
+            9 => Stmt::Try {
+                body: Vec::decode(r)?,
+                handlers: Vec::decode(r)?,
+                orelse: Vec::decode(r)?,
+                finalbody: Vec::decode(r)?,
+            },
+            10 => Stmt::Raise {
+                exc: Option::decode(r)?,
+            },
+            _ => return None,
+        })
+    }
+}
+
+impl Encode for Constant {
+    fn encode(&self, w: &mut Writer) {
+        match self {
+            Constant::Int(value) => {
+                w.u8(0);
+                value.encode(w);
+            }
+            Constant::Float(value) => {
+                w.u8(1);
+                value.encode(w);
+            }
+            Constant::Str(value) => {
+                w.u8(2);
+                value.encode(w);
+            }
+            Constant::Bool(value) => {
+                w.u8(3);
+                value.encode(w);
+            }
+            Constant::Bytes(value) => {
+                w.u8(4);
+                w.bytes(value);
+            }
+            Constant::None => w.u8(5),
+        }
+    }
+    fn decode(r: &mut Reader) -> Option<Self> {
+        Some(match r.u8()? {
+            0 => Constant::Int(i64::decode(r)?),
+            1 => Constant::Float(f64::decode(r)?),
+            2 => Constant::Str(String::decode(r)?),
+            3 => Constant::Bool(bool::decode(r)?),
+            4 => Constant::Bytes(r.bytes()?.to_vec()),
+            5 => Constant::None,
+            _ => return None,
+        })
+    }
+}
+
+impl Encode for Expr {
+    fn encode(&self, w: &mut Writer) {
+        match self {
+            Expr::Constant(value) => {
+                w.u8(0);
+                value.encode(w);
+            }
+            Expr::Name(name) => {
+                w.u8(1);
+                name.encode(w);
+            }
+            Expr::BinOp { left, op, right } => {
+                w.u8(2);
+                left.encode(w);
+                op.encode(w);
+                right.encode(w);
+            }
+            Expr::Compare {
+                left,
+                ops,
+                comparators,
+            } => {
+                w.u8(3);
+                left.encode(w);
+                ops.encode(w);
+                comparators.encode(w);
+            }
+            Expr::BoolOp { op, values } => {
+                w.u8(4);
+                op.encode(w);
+                values.encode(w);
+            }
+            Expr::UnaryOp { op, operand } => {
+                w.u8(5);
+                op.encode(w);
+                operand.encode(w);
+            }
+            Expr::Call { func, args } => {
+                w.u8(6);
+                func.encode(w);
+                args.encode(w);
+            }
+            Expr::List { elts } => {
+                w.u8(7);
+                elts.encode(w);
+            }
+            Expr::Dict { keys, values } => {
+                w.u8(8);
+                keys.encode(w);
+                values.encode(w);
+            }
+            Expr::Set { elts } => {
+                w.u8(9);
+                elts.encode(w);
+            }
+            Expr::Subscript { value, index } => {
+                w.u8(10);
+                value.encode(w);
+                index.encode(w);
+            }
+            Expr::Attribute { value, attr } => {
+                w.u8(11);
+                value.encode(w);
+                attr.encode(w);
+            }
+            Expr::Slice { lower, upper } => {
+                w.u8(12);
+                lower.encode(w);
+                upper.encode(w);
+            }
+        }
+    }
+    fn decode(r: &mut Reader) -> Option<Self> {
+        Some(match r.u8()? {
+            0 => Expr::Constant(Constant::decode(r)?),
+            1 => Expr::Name(String::decode(r)?),
+            2 => Expr::BinOp {
+                left: Box::decode(r)?,
+                op: BinOperator::decode(r)?,
+                right: Box::decode(r)?,
+            },
+            3 => Expr::Compare {
+                left: Box::decode(r)?,
+                ops: Vec::decode(r)?,
+                comparators: Vec::decode(r)?,
+            },
+            4 => Expr::BoolOp {
+                op: BoolOp::decode(r)?,
+                values: Vec::decode(r)?,
+            },
+            5 => Expr::UnaryOp {
+                op: UnaryOp::decode(r)?,
+                operand: Box::decode(r)?,
+            },
+            6 => Expr::Call {
+                func: Box::decode(r)?,
+                args: Vec::decode(r)?,
+            },
+            7 => Expr::List {
+                elts: Vec::decode(r)?,
+            },
+            8 => Expr::Dict {
+                keys: Vec::decode(r)?,
+                values: Vec::decode(r)?,
+            },
+            9 => Expr::Set {
+                elts: Vec::decode(r)?,
+            },
+            10 => Expr::Subscript {
+                value: Box::decode(r)?,
+                index: Box::decode(r)?,
+            },
+            11 => Expr::Attribute {
+                value: Box::decode(r)?,
+                attr: String::decode(r)?,
+            },
+            12 => Expr::Slice {
+                lower: Option::decode(r)?,
+                upper: Option::decode(r)?,
+            },
+            _ => return None,
+        })
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use tempfile::TempDir;
+
+    fn sample_module(dir: &Path) -> Module {
+        let helper = dir.join("helper.py");
+        fs::write(&helper, "").unwrap();
+        Module {
+            id: ModuleName::new("main"),
+            path: dir.join("main.py"),
+            imports: vec![ImportInfo {
+                source_name: "helper".to_string(),
+                module_id: ModuleName::new("helper"),
+                module_path: helper,
+                kind: ImportKind::Names(vec![ImportAlias {
+                    name: "f".to_string(),
+                    alias: Some("g".to_string()),
+                }]),
+            }],
+            body: vec![Stmt::FunctionDef {
+                name: "scale".to_string(),
+                args: vec![Arg {
+                    name: "xs".to_string(),
+                    annotation: Some(TypeAnnotation::List(Box::new(TypeAnnotation::Float))),
+                }],
+                return_type: Some(TypeAnnotation::Float),
+                body: vec![Stmt::Return {
+                    value: Some(Expr::BinOp {
+                        left: Box::new(Expr::Subscript {
+                            value: Box::new(Expr::Name("xs".to_string())),
+                            index: Box::new(Expr::Constant(Constant::Int(-1))),
+                        }),
+                        op: BinOperator::Mult,
+                        right: Box::new(Expr::Constant(Constant::Float(2.5))),
+                    }),
+                }],
+            }],
+        }
+    }
+
+    #[test]
+    fn test_round_trip() {
+        let dir = TempDir::new().unwrap();
+        let cache = ModuleCache::new(dir.path().join("cache"), dir.path());
+        let module = sample_module(dir.path());
+
+        cache.store(&module, "source");
+        let loaded = cache.load(&module.path, &module.id, "source").unwrap();
+        assert_eq!(format!("{:?}", loaded), format!("{:?}", module));
+    }
+
+    #[test]
+    fn test_miss_on_changed_source() {
+        let dir = TempDir::new().unwrap();
+        let cache = ModuleCache::new(dir.path().join("cache"), dir.path());
+        let module = sample_module(dir.path());
+
+        cache.store(&module, "source");
+        assert!(cache.load(&module.path, &module.id, "source 2").is_none());
+    }
+
+    #[test]
+    fn test_miss_on_removed_import() {
+        let dir = TempDir::new().unwrap();
+        let cache = ModuleCache::new(dir.path().join("cache"), dir.path());
+        let module = sample_module(dir.path());
+
+        cache.store(&module, "source");
+        fs::remove_file(&module.imports[0].module_path).unwrap();
+        assert!(cache.load(&module.path, &module.id, "source").is_none());
+    }
+}
@@ -577,7 +577,8 @@ impl AstConverter {
         })
     }
 
-    // expr = Constant | Name | BinOp | Compare | BoolOp | UnaryOp | Call | List | Subscript | Attribute
+    // expr = Constant | Name | BinOp | Compare | BoolOp | UnaryOp | Call | List | Dict | Set
+    //      | Subscript | Attribute
     fn convert_expr(&self, py_expr: &Bound<'_, PyAny>) -> Result<Expr> {
         Python::attach(|_py| {
             let class_name = py_expr.get_type().name().unwrap();
@@ -591,6 +592,8 @@ impl AstConverter {
                 "UnaryOp" => self.convert_unaryop(py_expr),
                 "Call" => self.convert_call(py_expr),
                 "List" => self.convert_list(py_expr),
+                "Dict" => self.convert_dict(py_expr),
+                "Set" => self.convert_set(py_expr),
                 "Subscript" => self.convert_subscript(py_expr),
                 "Attribute" => self.convert_attribute(py_expr),
                 _ => Err(CompilerError::UnsupportedFeature(format!(
@@ -754,11 +757,56 @@ impl AstConverter {
         })
     }
 
+    // Dict(expr?* keys, expr* values)
+    fn convert_dict(&self, node: &Bound<'_, PyAny>) -> Result<Expr> {
+        Python::attach(|_py| {
+            let keys_pylist = self.get_list_attr(node, "keys");
+            let values_pylist = self.get_list_attr(node, "values");
+
+            let mut keys = Vec::new();
+            for py_key in keys_pylist.iter() {
+                // A None key is a `**mapping` unpacking
+                if py_key.is_none() {
+                    return Err(CompilerError::UnsupportedFeature(
+                        "Dict unpacking (**) is not supported".to_string(),
+                    ));
+                }
+                keys.push(self.convert_expr(&py_key)?);
+            }
+
+            let mut values = Vec::new();
+            for py_value in values_pylist.iter() {
+                values.push(self.convert_expr(&py_value)?);
+            }
+
+            Ok(Expr::Dict { keys, values })
+        })
+    }
+
+    // Set(expr* elts)
+    fn convert_set(&self, node: &Bound<'_, PyAny>) -> Result<Expr> {
+        Python::attach(|_py| {
+            let elts_pylist = self.get_list_attr(node, "elts");
+
+            let mut elts = Vec::new();
+            for py_elt in elts_pylist.iter() {
+                elts.push(self.convert_expr(&py_elt)?);
+            }
+
+            Ok(Expr::Set { elts })
+        })
+    }
+
     // Subscript(expr value, expr slice, expr_context ctx)
     fn convert_subscript(&self, node: &Bound<'_, PyAny>) -> Result<Expr> {
         Python::attach(|_py| {
             let value = self.convert_expr(&node.getattr("value").unwrap())?;
-            let index = self.convert_expr(&node.getattr("slice").unwrap())?;
+            let slice = node.getattr("slice").unwrap();
+            let index = if slice.get_type().name().unwrap().to_string() == "Slice" {
+                self.convert_slice(&slice)?
+            } else {
+                self.convert_expr(&slice)?
+            };
 
             Ok(Expr::Subscript {
                 value: Box::new(value),
@@ -767,6 +815,29 @@ impl AstConverter {
         })
     }
 
+    // Slice(expr? lower, expr? upper, expr? step)
+    fn convert_slice(&self, node: &Bound<'_, PyAny>) -> Result<Expr> {
+        Python::attach(|_py| {
+            if !node.getattr("step").unwrap().is_none() {
+                return Err(CompilerError::UnsupportedFeature(
+                    "Slices with a step are not supported".to_string(),
+                ));
+            }
+            let bound = |name: &str| -> Result<Option<Box<Expr>>> {
+                let value = node.getattr(name).unwrap();
+                if value.is_none() {
+                    Ok(None)
+                } else {
+                    Ok(Some(Box::new(self.convert_expr(&value)?)))
+                }
+            };
+            Ok(Expr::Slice {
+                lower: bound("lower")?,
+                upper: bound("upper")?,
+            })
+        })
+    }
+
     // Attribute(expr value, identifier attr, expr_context ctx)
     fn convert_attribute(&self, node: &Bound<'_, PyAny>) -> Result<Expr> {
         Python::attach(|_py| {
@@ -819,6 +890,8 @@ impl AstConverter {
                 "LtE" => Ok(CompareOp::LtE),
                 "Gt" => Ok(CompareOp::Gt),
                 "GtE" => Ok(CompareOp::GtE),
+                "In" => Ok(CompareOp::In),
+                "NotIn" => Ok(CompareOp::NotIn),
                 _ => Err(CompilerError::UnsupportedFeature(format!(
                     "Unsupported comparison operator: {}",
                     class_name
@@ -827,7 +900,7 @@ impl AstConverter {
         })
     }
 
-    // Type annotations use Name or Subscript (e.g., int, list[int])
+    // Type annotations use Name or Subscript (e.g., int, list[int], dict[str, int])
     fn get_type_annotation(&self, py_annot: &Bound<'_, PyAny>) -> Result<TypeAnnotation> {
         Python::attach(|_py| {
             let class_name = py_annot.get_type().name().unwrap();
@@ -846,9 +919,38 @@ impl AstConverter {
                     }
                 }
                 "Subscript" => {
+                    let generic = py_annot.getattr("value").unwrap();
+                    let generic_name = if generic.get_type().name().unwrap().to_string() == "Name" {
+                        self.get_string_attr(&generic, "id")
+                    } else {
+                        String::new()
+                    };
                     let slice = py_annot.getattr("slice").unwrap();
+
+                    if generic_name == "dict" {
+                        // dict[K, V]: the slice is a Tuple of the two parameters
+                        let is_pair = slice.get_type().name().unwrap().to_string() == "Tuple"
+                            && self.get_list_attr(&slice, "elts").len() == 2;
+                        if !is_pair {
+                            return Err(CompilerError::UnsupportedFeature(
+                                "dict annotation needs key and value types: dict[K, V]".to_string(),
+                            ));
+                        }
+                        let params = self.get_list_attr(&slice, "elts");
+                        let key_type = self.get_type_annotation(&params.get_item(0).unwrap())?;
+                        let value_type = self.get_type_annotation(&params.get_item(1).unwrap())?;
+                        return Ok(TypeAnnotation::Dict(
+                            Box::new(key_type),
+                            Box::new(value_type),
+                        ));
+                    }
+
                     let inner_type = self.get_type_annotation(&slice)?;
-                    Ok(TypeAnnotation::List(Box::new(inner_type)))
+                    if generic_name == "set" {
+                        Ok(TypeAnnotation::Set(Box::new(inner_type)))
+                    } else {
+                        Ok(TypeAnnotation::List(Box::new(inner_type)))
+                    }
                 }
                 // Handle string annotations (forward references) like "ClassName"
                 "Constant" => {
@@ -1,3 +1,4 @@
+pub mod cache;
 pub mod converter;
 pub mod types;
 
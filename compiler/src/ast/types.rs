@@ -15,6 +15,10 @@ pub enum TypeAnnotation {
     ByteArray,
     /// list[int] type
     List(Box<TypeAnnotation>),
+    /// dict[str, int] type
+    Dict(Box<TypeAnnotation>, Box<TypeAnnotation>),
+    /// set[int] type
+    Set(Box<TypeAnnotation>),
     /// Class name type (e.g., Point, Rectangle)
     ClassName(String),
 }
@@ -89,6 +93,8 @@ pub enum CompareOp {
     LtE,   // <=
     Gt,    // >
     GtE,   // >=
+    In,    // in
+    NotIn, // not in
 }
 
 /// Boolean operators
@@ -221,9 +227,22 @@ pub enum Expr {
     /// List literal
     List { elts: Vec<Expr> },
 
+    /// Dict literal (keys and values pair up by position)
+    Dict { keys: Vec<Expr>, values: Vec<Expr> },
+
+    /// Set literal
+    Set { elts: Vec<Expr> },
+
     /// Subscript (e.g., list[0])
     Subscript { value: Box<Expr>, index: Box<Expr> },
 
+    /// Slice index of a subscript (e.g., the `1:n` of data[1:n]); either bound
+    /// may be left out
+    Slice {
+        lower: Option<Box<Expr>>,
+        upper: Option<Box<Expr>>,
+    },
+
     /// Attribute access (e.g., obj.field)
     Attribute { value: Box<Expr>, attr: String },
 }
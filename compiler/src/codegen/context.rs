@@ -8,7 +8,14 @@ use inkwell::types::StructType;
 use inkwell::values::{FunctionValue, PointerValue};
 use std::collections::HashMap;
 
-use crate::driver::Target as CompilerTarget;
+use super::profile::{ProfileHints, ProfileSites};
+use crate::driver::{GcConfig, Target as CompilerTarget};
+use crate::tir::dispatch::ClassHierarchy;
+use crate::tir::escape::EscapeAnalysis;
+use crate::tir::exception_ids::ExceptionIds;
+use crate::tir::layout::FieldLayout;
+use crate::tir::may_raise::MayRaise;
+use crate::tir::ClassId;
 
 /// Code generation context
 pub struct CodegenContext<'ctx> {
@@ -30,6 +37,39 @@ pub struct CodegenContext<'ctx> {
 
     /// Class name -> LLVM struct type
     pub(crate) class_types: HashMap<String, StructType<'ctx>>,
+
+    /// Interned string literals (text -> its read-only String global)
+    pub(crate) string_literals: HashMap<String, PointerValue<'ctx>>,
+
+    /// May-raise facts; None means every statement in a try body is polled
+    pub(crate) may_raise: Option<MayRaise>,
+
+    /// Parameter escape facts; None means every object goes on the heap
+    pub(crate) escape: Option<EscapeAnalysis>,
+
+    /// Type ids of the exception classes, used to raise and match exceptions
+    pub(crate) exception_ids: ExceptionIds,
+
+    /// Vtable layouts and the virtual methods calls may need to dispatch
+    pub(crate) dispatch: ClassHierarchy,
+
+    /// Class -> its vtable, for classes that have one
+    pub(crate) vtables: HashMap<ClassId, PointerValue<'ctx>>,
+
+    /// Field order of every class struct
+    pub(crate) layout: FieldLayout,
+
+    /// Collector configuration; main enables the collector when it is on
+    pub(crate) gc: GcConfig,
+
+    /// Skip the index checks of list and bytearray subscripts (`--unchecked`)
+    pub(crate) unchecked: bool,
+
+    /// Profile sites numbered so far; None leaves the program uninstrumented
+    pub(crate) profile: Option<ProfileSites>,
+
+    /// Flat profile of an earlier run, applied once functions are declared
+    pub(crate) profile_hints: Option<ProfileHints>,
 }
 
 impl<'ctx> CodegenContext<'ctx> {
@@ -60,6 +100,17 @@ impl<'ctx> CodegenContext<'ctx> {
             global_variables: HashMap::new(),
             functions: HashMap::new(),
             class_types: HashMap::new(),
+            string_literals: HashMap::new(),
+            may_raise: None,
+            escape: None,
+            exception_ids: ExceptionIds::default(),
+            dispatch: ClassHierarchy::default(),
+            vtables: HashMap::new(),
+            layout: FieldLayout::default(),
+            gc: GcConfig::default(),
+            unchecked: false,
+            profile: None,
+            profile_hints: None,
         }
     }
 
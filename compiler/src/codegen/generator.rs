@@ -8,10 +8,16 @@
 use inkwell::context::Context;
 use inkwell::module::Module as LLVMModule;
 
-use crate::driver::Target;
+use crate::driver::{ExceptionModel, GcConfig, Target};
+use crate::tir::dispatch::ClassHierarchy;
+use crate::tir::escape::EscapeAnalysis;
+use crate::tir::exception_ids::ExceptionIds;
+use crate::tir::layout::FieldLayout;
+use crate::tir::may_raise::MayRaise;
 use crate::tir::TirProgram;
 
 use super::context::CodegenContext;
+use super::profile::{ProfileHints, ProfileSites};
 
 /// Code generator
 ///
@@ -19,11 +25,65 @@ use super::context::CodegenContext;
 pub struct Codegen<'ctx> {
     context: &'ctx Context,
     target: Target,
+    exception_model: ExceptionModel,
+    gc: GcConfig,
+    unchecked: bool,
+    reorder_fields: bool,
+    profile: bool,
+    profile_hints: Option<ProfileHints>,
 }
 
 impl<'ctx> Codegen<'ctx> {
     pub fn new(context: &'ctx Context, target: Target) -> Self {
-        Codegen { context, target }
+        Codegen {
+            context,
+            target,
+            exception_model: ExceptionModel::default(),
+            gc: GcConfig::default(),
+            unchecked: false,
+            reorder_fields: false,
+            profile: false,
+            profile_hints: None,
+        }
+    }
+
+    /// Select how try bodies poll for pending exceptions
+    pub fn with_exception_model(mut self, exception_model: ExceptionModel) -> Self {
+        self.exception_model = exception_model;
+        self
+    }
+
+    /// Select how runtime objects are reclaimed
+    pub fn with_gc(mut self, gc: GcConfig) -> Self {
+        self.gc = gc;
+        self
+    }
+
+    /// Leave out the index checks of list and bytearray subscripts. An index out
+    /// of range is then undefined behavior instead of a panic.
+    pub fn with_unchecked(mut self, unchecked: bool) -> Self {
+        self.unchecked = unchecked;
+        self
+    }
+
+    /// Order the fields of each class by size and static use instead of by
+    /// declaration (see `tir::layout`)
+    pub fn with_reorder_fields(mut self, reorder_fields: bool) -> Self {
+        self.reorder_fields = reorder_fields;
+        self
+    }
+
+    /// Count entries, ticks, allocations and raises per function and loop at
+    /// run time (see `codegen::profile`)
+    pub fn with_profile(mut self, profile: bool) -> Self {
+        self.profile = profile;
+        self
+    }
+
+    /// Mark functions cold or hot from the flat profile of an earlier run
+    pub fn with_profile_hints(mut self, hints: Option<ProfileHints>) -> Self {
+        self.profile_hints = hints;
+        self
     }
 
     /// Generate code from a TIR program
@@ -31,6 +91,18 @@ impl<'ctx> Codegen<'ctx> {
     /// Since TIR has all types and symbols resolved, this operation is infallible.
     pub fn codegen_tir(self, program: &TirProgram) -> LLVMModule<'ctx> {
         let mut codegen = CodegenContext::new(self.context, "main", self.target);
+        let hierarchy = ClassHierarchy::analyze(program);
+        if self.exception_model == ExceptionModel::MayRaise {
+            codegen.may_raise = Some(MayRaise::analyze(program, &hierarchy));
+        }
+        codegen.escape = Some(EscapeAnalysis::analyze(program, &hierarchy));
+        codegen.exception_ids = ExceptionIds::analyze(program);
+        codegen.layout = FieldLayout::analyze(program, &hierarchy, self.reorder_fields);
+        codegen.dispatch = hierarchy;
+        codegen.gc = self.gc;
+        codegen.unchecked = self.unchecked;
+        codegen.profile = self.profile.then(ProfileSites::default);
+        codegen.profile_hints = self.profile_hints;
 
         // Declare runtime functions
         codegen.declare_runtime_functions();
@@ -47,7 +119,7 @@ impl<'ctx> CodegenContext<'ctx> {
     ///
     /// Pass 1: Declare all class struct types
     /// Pass 2: Declare all function signatures
-    /// Pass 3: Declare all global variables
+    /// Pass 3: Declare all global variables, the exception id table and vtables
     /// Pass 4: Generate all function bodies
     /// Pass 5: Generate module initialization functions
     /// Pass 6: Generate main entry point
@@ -61,11 +133,16 @@ impl<'ctx> CodegenContext<'ctx> {
         for func in &program.functions {
             self.declare_tir_function(func, program);
         }
+        if let Some(hints) = self.profile_hints.take() {
+            self.apply_profile_hints(&hints, program);
+        }
 
         // Pass 3: Declare all global variables (before function bodies)
         for module in &program.modules {
             self.declare_tir_module_globals(module, program);
         }
+        self.declare_exception_ids(program);
+        self.declare_vtables(program);
 
         // Pass 4: Generate all function bodies
         for func in &program.functions {
@@ -3,6 +3,8 @@ mod runtime;
 mod tir;
 
 pub mod generator;
+pub mod optimize;
+pub mod profile;
 
 pub use context::CodegenContext;
 pub use generator::Codegen;
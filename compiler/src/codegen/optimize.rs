@@ -0,0 +1,338 @@
+//! Whole-program optimization of the generated module
+//!
+//! The C runtime is compiled to LLVM bitcode by `runtime/build.rs`. Instead of
+//! leaving it to the link step, it is linked into the generated module before the
+//! optimization pipeline runs, so hot accessors (`list.__getitem__`, `list.__len__`,
+//! `str.__eq__`, `__pyc_has_exception`, ...) are visible to the inliner and inline
+//! straight into user loops.
+//!
+//! The pipeline level, CPU and target features come from the driver options.
+//! For profile-guided optimization the module is instrumented, or annotated
+//! with a merged profile, just before the pipeline (see [`Pgo`]).
+//!
+//! Once optimized, the program is checked for the ICU functions it can still
+//! reach, so the link step only pulls in as much of ICU as is needed (see
+//! [`trim_icu`]).
+
+use std::ffi::CString;
+use std::path::Path;
+
+use inkwell::attributes::AttributeLoc;
+use inkwell::module::{Linkage, Module};
+use inkwell::passes::PassBuilderOptions;
+use inkwell::targets::{CodeModel, RelocMode, Target as LLVMTarget, TargetMachine};
+use inkwell::values::{CallSiteValue, InstructionOpcode};
+use inkwell::GlobalVisibility;
+
+use crate::driver::OptLevel;
+use crate::error::{CompilerError, Result};
+
+/// Runtime functions we expect to be inlined into generated code
+pub const HOT_RUNTIME_FUNCTIONS: &[&str] = &[
+    "__pyc___builtin___list___getitem__",
+    "__pyc___builtin___list___setitem__",
+    "__pyc___builtin___list___len__",
+    "__pyc___builtin___list_append",
+    "__pyc___builtin___list_f64___getitem__",
+    "__pyc___builtin___list_f64___setitem__",
+    "__pyc___builtin___list_f64_append",
+    "__pyc___builtin___list_bool___getitem__",
+    "__pyc___builtin___list_ptr___getitem__",
+    "__pyc___builtin___list_str___getitem__",
+    "__pyc___builtin___dict___getitem__",
+    "__pyc___builtin___dict___contains__",
+    "__pyc___builtin___set___contains__",
+    "__pyc___builtin___str___eq__",
+    "__pyc___builtin___str___len__",
+    "__pyc___builtin___range___next__",
+    "__pyc___builtin___int___print__",
+    "__pyc___builtin___str___print__",
+    "__pyc___builtin___int___float__",
+    "__pyc___builtin___list_iterator___next__",
+    "__pyc_has_exception",
+    "__pyc_exception_matches",
+];
+
+/// Prefixes of the ICU C functions the runtime calls (ICU appends its version
+/// to each name)
+const ICU_PREFIXES: &[&str] = &["u_", "ucasemap_", "unorm2_", "utf8_"];
+
+/// Prefix of the normalizers that load their tables from the ICU data library
+const ICU_DATA_PREFIX: &str = "unorm2_getNFK";
+
+/// How much of ICU a program needs at link time
+#[derive(Debug, Clone, Copy, PartialEq, Eq, PartialOrd, Ord)]
+pub enum IcuUse {
+    /// No string operation of the program reaches ICU
+    None,
+    /// Character properties, case mapping and NFC/NFD, whose tables are
+    /// compiled into libicuuc; the ICU data library is left out
+    Core,
+    /// NFKC/NFKD normalization, which loads `nfkc.nrm` from the ICU data
+    Data,
+}
+
+/// Prefix of the globals the PGO instrumentation shares with the profile
+/// runtime (raw profile version, output file name)
+const PROFILE_RUNTIME_PREFIX: &str = "__llvm_profile_";
+
+/// Profile-guided optimization of the pipeline
+#[derive(Debug, Clone, Copy)]
+pub enum Pgo<'a> {
+    /// Instrument the program to write raw profiles into this directory
+    Generate(&'a Path),
+    /// Optimize with a profile merged by `llvm-profdata`
+    Use(&'a Path),
+}
+
+/// Link the runtime bitcode into the generated module.
+pub fn link_runtime(module: &Module<'_>, runtime_path: &Path) -> Result<()> {
+    let runtime =
+        Module::parse_bitcode_from_path(runtime_path, module.get_context()).map_err(|e| {
+            CompilerError::CodegenError(format!(
+                "Failed to load runtime bitcode {}: {}",
+                runtime_path.display(),
+                e
+            ))
+        })?;
+
+    // Adopt the runtime's data layout so the modules agree before linking
+    module.set_data_layout(&runtime.get_data_layout());
+
+    module
+        .link_in_module(runtime)
+        .map_err(|e| CompilerError::CodegenError(format!("Failed to link runtime bitcode: {e}")))
+}
+
+/// Tag every defined function with the selected CPU and features.
+///
+/// The attributes travel with the bitcode, so the final LTO code generation in
+/// the linker uses them too. Runtime and generated functions get the same values,
+/// which keeps them inline-compatible.
+pub fn set_target_attributes(module: &Module<'_>, cpu: &str, features: &str) {
+    let context = module.get_context();
+    for function in module.get_functions() {
+        if function.count_basic_blocks() == 0 {
+            continue;
+        }
+        if cpu != "generic" {
+            let attr = context.create_string_attribute("target-cpu", cpu);
+            function.add_attribute(AttributeLoc::Function, attr);
+        }
+        if !features.is_empty() {
+            let attr = context.create_string_attribute("target-features", features);
+            function.add_attribute(AttributeLoc::Function, attr);
+        }
+    }
+}
+
+fn target_machine(
+    module: &Module<'_>,
+    level: OptLevel,
+    cpu: &str,
+    features: &str,
+) -> Result<TargetMachine> {
+    let triple = module.get_triple();
+    let target = LLVMTarget::from_triple(&triple)
+        .map_err(|e| CompilerError::CodegenError(format!("Unknown LLVM target: {e}")))?;
+    target
+        .create_target_machine(
+            &triple,
+            cpu,
+            features,
+            level.codegen_level(),
+            RelocMode::Static,
+            CodeModel::Default,
+        )
+        .ok_or_else(|| CompilerError::CodegenError("Failed to create target machine".into()))
+}
+
+/// Run the LLVM `default<On>` pipeline over the (runtime-linked) module.
+///
+/// PGO instrumentation and profile use both run ahead of the pipeline, on
+/// the module as codegen left it, so the instrumented and the optimized
+/// build see the same control flow and the profile's function hashes match.
+pub fn run_pipeline(
+    module: &Module<'_>,
+    level: OptLevel,
+    cpu: &str,
+    features: &str,
+    pgo: Option<Pgo<'_>>,
+) -> Result<()> {
+    let machine = target_machine(module, level, cpu, features)?;
+    let passes = match pgo {
+        None => level.pipeline().to_string(),
+        Some(Pgo::Generate(dir)) => {
+            set_profile_filename(module, dir);
+            format!("pgo-instr-gen,instrprof,{}", level.pipeline())
+        }
+        Some(Pgo::Use(profile)) => {
+            // pgo-instr-use only takes its profile from this option
+            set_llvm_option(&format!("-pgo-test-profile-file={}", profile.display()))?;
+            format!("pgo-instr-use,{}", level.pipeline())
+        }
+    };
+    module
+        .run_passes(&passes, &machine, PassBuilderOptions::create())
+        .map_err(|e| CompilerError::CodegenError(format!("Optimization failed: {e}")))
+}
+
+/// Have the profile runtime write its raw profiles into `dir`, as clang's
+/// `-fprofile-generate=<dir>` does
+fn set_profile_filename(module: &Module<'_>, dir: &Path) {
+    let context = module.get_context();
+    let path = dir.join("default_%m.profraw");
+    let name = context.const_string(path.to_string_lossy().as_bytes(), true);
+    let global = module.add_global(name.get_type(), None, "__llvm_profile_filename");
+    global.set_initializer(&name);
+    global.set_constant(true);
+    global.set_linkage(Linkage::WeakAny);
+    global.set_visibility(GlobalVisibility::Hidden);
+}
+
+/// Set an LLVM command-line option, the only way some passes are configured
+fn set_llvm_option(option: &str) -> Result<()> {
+    let to_c_string = |arg: &str| {
+        CString::new(arg)
+            .map_err(|e| CompilerError::CodegenError(format!("Invalid LLVM option {arg}: {e}")))
+    };
+    let args = [to_c_string("pycc")?, to_c_string(option)?];
+    let argv: Vec<_> = args.iter().map(|arg| arg.as_ptr()).collect();
+    // argv points into `args`, which outlives the call
+    unsafe {
+        llvm_sys::support::LLVMParseCommandLineOptions(
+            argv.len() as i32,
+            argv.as_ptr(),
+            std::ptr::null(),
+        );
+    }
+    Ok(())
+}
+
+/// Find how much of ICU the optimized program can reach.
+///
+/// Every runtime function stays external through optimization, so the
+/// module refers to ICU whether or not the program uses it. A copy of the
+/// module is internalized, as the final link of the executable would, and
+/// stripped of unreferenced functions; the ICU calls left in it are the ones
+/// the program can make. When there are none, the module itself is stripped
+/// too, so the link needs neither ICU nor libstdc++. Otherwise it is left
+/// whole, since ICU calls back into the glibc shims of the runtime.
+pub fn trim_icu(module: &Module<'_>) -> Result<IcuUse> {
+    let probe = module.clone();
+    strip_unreferenced(&probe)?;
+    let icu = icu_use(&probe);
+    if icu == IcuUse::None {
+        strip_unreferenced(module)?;
+    }
+    Ok(icu)
+}
+
+/// Give every definition but `main` internal linkage and delete the ones
+/// nothing refers to. The globals the profile runtime looks up by name stay
+/// external.
+fn strip_unreferenced(module: &Module<'_>) -> Result<()> {
+    for function in module.get_functions() {
+        if function.count_basic_blocks() > 0 && function.get_name().to_bytes() != b"main" {
+            function.set_linkage(Linkage::Internal);
+        }
+    }
+    for global in module.get_globals() {
+        let name = global.get_name().to_bytes();
+        let special =
+            name.starts_with(b"llvm.") || name.starts_with(PROFILE_RUNTIME_PREFIX.as_bytes());
+        if global.get_initializer().is_some() && !special {
+            global.set_linkage(Linkage::Internal);
+        }
+    }
+
+    let machine = target_machine(module, OptLevel::O0, "generic", "")?;
+    module
+        .run_passes("globaldce", &machine, PassBuilderOptions::create())
+        .map_err(|e| CompilerError::CodegenError(format!("Optimization failed: {e}")))
+}
+
+/// The ICU support the calls made by the module's functions need
+fn icu_use(module: &Module<'_>) -> IcuUse {
+    let mut icu = IcuUse::None;
+    for function in module.get_functions() {
+        for block in function.get_basic_block_iter() {
+            for instruction in block.get_instructions() {
+                if instruction.get_opcode() != InstructionOpcode::Call {
+                    continue;
+                }
+                let Ok(call) = CallSiteValue::try_from(instruction) else {
+                    continue;
+                };
+                let Some(callee) = call.get_called_fn_value() else {
+                    continue;
+                };
+                let callee = callee.get_name().to_string_lossy();
+                if callee.starts_with(ICU_DATA_PREFIX) {
+                    icu = IcuUse::Data;
+                } else if ICU_PREFIXES.iter().any(|prefix| callee.starts_with(prefix)) {
+                    icu = icu.max(IcuUse::Core);
+                }
+            }
+        }
+    }
+    icu
+}
+
+/// Names of the functions defined by the generated module.
+///
+/// Must be called before [`link_runtime`] so runtime bodies are not included.
+pub fn generated_functions(module: &Module<'_>) -> Vec<String> {
+    module
+        .get_functions()
+        .filter(|f| f.count_basic_blocks() > 0)
+        .map(|f| f.get_name().to_string_lossy().into_owned())
+        .collect()
+}
+
+/// Count the call sites of each hot runtime function that remain in generated code.
+///
+/// Only calls made from `generated` functions are counted; a count of zero means
+/// every call was inlined or eliminated.
+pub fn inline_report(module: &Module<'_>, generated: &[String]) -> Vec<(&'static str, usize)> {
+    let mut counts: Vec<(&'static str, usize)> = HOT_RUNTIME_FUNCTIONS
+        .iter()
+        .map(|name| (*name, 0))
+        .collect();
+
+    for name in generated {
+        let Some(function) = module.get_function(name) else {
+            continue;
+        };
+
+        for block in function.get_basic_block_iter() {
+            for instruction in block.get_instructions() {
+                if instruction.get_opcode() != InstructionOpcode::Call {
+                    continue;
+                }
+                let Ok(call) = CallSiteValue::try_from(instruction) else {
+                    continue;
+                };
+                let Some(callee) = call.get_called_fn_value() else {
+                    continue;
+                };
+                let callee = callee.get_name().to_string_lossy();
+                if let Some(entry) = counts.iter_mut().find(|(name, _)| *name == callee) {
+                    entry.1 += 1;
+                }
+            }
+        }
+    }
+
+    counts
+}
+
+/// Format an inline report for display
+pub fn format_inline_report(counts: &[(&'static str, usize)]) -> String {
+    let mut report = String::from("=== Inline Report ===\n");
+    for (name, remaining) in counts {
+        let status = if *remaining == 0 { "inlined" } else { "called" };
+        report.push_str(&format!("{status:<8} {remaining:>4}  {name}\n"));
+    }
+    report
+}
@@ -0,0 +1,277 @@
+//! Profiling instrumentation and profile hints
+//!
+//! With `--profile`, every function, module body and loop of the program is a
+//! profile site. Generated code calls `__pyc_profile_enter(site)` on entry to
+//! a site, which returns the depth of the runtime's site stack, and
+//! `__pyc_profile_leave(depth)` when it leaves: at the end of a loop, and
+//! before each return, which also leaves the loops the return jumps out of.
+//! `main` hands the runtime the names of the sites; the runtime counts
+//! entries, ticks and allocations per site and writes the profile at exit
+//! (see runtime/src/profile.h).
+//!
+//! The flat profile it writes can be passed back with `--profile-use`:
+//! functions the run never entered are marked `cold`, and functions that
+//! took a large share of all calls `inlinehint`.
+
+use std::collections::HashMap;
+use std::fs;
+use std::path::Path;
+
+use inkwell::attributes::{Attribute, AttributeLoc};
+use inkwell::values::IntValue;
+use inkwell::AddressSpace;
+
+use super::context::CodegenContext;
+use super::tir::declarations::call_result_to_basic_value;
+use super::tir::function_gen::FunctionGenContext;
+use crate::error::{CompilerError, Result};
+use crate::tir::stmt::TirStmt;
+use crate::tir::TirProgram;
+
+/// First line of a flat profile
+const PROFILE_HEADER: &str = "# pyc profile";
+
+/// Share of all function calls above which a function is hot
+const HOT_CALL_SHARE: f64 = 0.01;
+
+/// Names of the profile sites, indexed by site id
+#[derive(Debug, Default)]
+pub(crate) struct ProfileSites {
+    names: Vec<String>,
+    /// Loops numbered so far in each function
+    loops: HashMap<String, u32>,
+}
+
+impl ProfileSites {
+    /// Add the site of a function or module body
+    pub(crate) fn function(&mut self, name: &str) -> u32 {
+        self.names.push(name.to_string());
+        (self.names.len() - 1) as u32
+    }
+
+    /// Add the site of the next loop of a function: `<function>:<kind><n>`
+    pub(crate) fn next_loop(&mut self, function: &str, kind: &str) -> u32 {
+        let n = self.loops.entry(function.to_string()).or_insert(0);
+        *n += 1;
+        let name = format!("{function}:{kind}{n}");
+        self.names.push(name);
+        (self.names.len() - 1) as u32
+    }
+}
+
+/// The profile site of the function being generated
+#[derive(Debug, Clone)]
+pub(crate) struct ProfileScope<'ctx> {
+    /// Site name of the function, which its loops are named after
+    name: String,
+    /// Site stack depth on entry to the function, left by its returns;
+    /// None in a parallel loop body, which has no returns
+    entry: Option<IntValue<'ctx>>,
+}
+
+impl<'ctx> ProfileScope<'ctx> {
+    pub(crate) fn entry(&self) -> Option<IntValue<'ctx>> {
+        self.entry
+    }
+
+    /// The scope of a loop body outlined into a function of its own
+    pub(crate) fn outlined(&self) -> Self {
+        ProfileScope {
+            name: self.name.clone(),
+            entry: None,
+        }
+    }
+}
+
+/// Function entry counts read back from a flat profile
+#[derive(Debug, Clone, Default)]
+pub struct ProfileHints {
+    calls: HashMap<String, u64>,
+}
+
+impl ProfileHints {
+    /// Read a flat profile written by a `--profile` build, or None when the
+    /// file is some other kind of profile (an llvm-profdata one)
+    pub fn load(path: &Path) -> Result<Option<Self>> {
+        let bytes = fs::read(path).map_err(CompilerError::IOError)?;
+        if !bytes.starts_with(PROFILE_HEADER.as_bytes()) {
+            return Ok(None);
+        }
+        Ok(Some(Self::parse(&String::from_utf8_lossy(&bytes))))
+    }
+
+    /// The site table of a flat profile: `calls self total self% site` rows up
+    /// to the first blank line. Loop sites are left out.
+    fn parse(text: &str) -> Self {
+        let mut calls = HashMap::new();
+        for line in text.lines().take_while(|line| !line.trim().is_empty()) {
+            if line.starts_with('#') {
+                continue;
+            }
+            let columns: Vec<&str> = line.split_whitespace().collect();
+            let (Some(count), Some(site)) = (columns.first(), columns.last()) else {
+                continue;
+            };
+            if columns.len() != 5 || site.contains(':') {
+                continue;
+            }
+            if let Ok(count) = count.parse() {
+                calls.insert(site.to_string(), count);
+            }
+        }
+        ProfileHints { calls }
+    }
+
+    /// Calls of a function in the profiled run, None if it was not in the program
+    fn calls(&self, function: &str) -> Option<u64> {
+        self.calls.get(function).copied()
+    }
+
+    fn total_calls(&self) -> u64 {
+        self.calls.values().sum()
+    }
+}
+
+impl<'ctx> CodegenContext<'ctx> {
+    /// Mark the functions the profile found cold or hot.
+    /// Must be called after all functions are declared.
+    pub(crate) fn apply_profile_hints(&self, hints: &ProfileHints, program: &TirProgram) {
+        let hot_calls = (hints.total_calls() as f64 * HOT_CALL_SHARE).max(1.0);
+        let attribute = |name: &str| {
+            self.context
+                .create_enum_attribute(Attribute::get_named_enum_kind_id(name), 0)
+        };
+        let (cold, hot) = (attribute("cold"), attribute("inlinehint"));
+        for func in &program.functions {
+            if func.runtime_name.is_some() {
+                continue;
+            }
+            let Some(calls) = hints.calls(&func.qualified_name) else {
+                continue;
+            };
+            let fn_value = self.functions[&func.qualified_name];
+            if calls == 0 {
+                fn_value.add_attribute(AttributeLoc::Function, cold);
+            } else if calls as f64 >= hot_calls {
+                fn_value.add_attribute(AttributeLoc::Function, hot);
+            }
+        }
+    }
+
+    /// Enter the site of a function or module body at the current position
+    /// (the end of its entry block). None when profiling is off.
+    pub(crate) fn profile_function_entry(&mut self, name: &str) -> Option<ProfileScope<'ctx>> {
+        let site = self.profile.as_mut()?.function(name);
+        let entry = self.profile_enter(site);
+        Some(ProfileScope {
+            name: name.to_string(),
+            entry: Some(entry),
+        })
+    }
+
+    fn profile_enter(&mut self, site: u32) -> IntValue<'ctx> {
+        let enter = self.module.get_function("__pyc_profile_enter").unwrap();
+        let site = self.context.i32_type().const_int(u64::from(site), false);
+        let call = self
+            .builder
+            .build_call(enter, &[site.into()], "profile.depth")
+            .unwrap();
+        let zero = self.context.i64_type().const_zero().into();
+        call_result_to_basic_value(call, zero).into_int_value()
+    }
+
+    pub(crate) fn profile_leave(&mut self, depth: IntValue<'ctx>) {
+        let leave = self.module.get_function("__pyc_profile_leave").unwrap();
+        self.builder.build_call(leave, &[depth.into()], "").unwrap();
+    }
+
+    /// Hand the runtime the site names and start profiling (in `main`)
+    pub(crate) fn generate_profile_init(&mut self) {
+        let Some(sites) = &self.profile else {
+            return;
+        };
+        let ptr_type = self.context.ptr_type(AddressSpace::default());
+        let names: Vec<_> = sites
+            .names
+            .iter()
+            .map(|name| {
+                self.builder
+                    .build_global_string_ptr(name, "profile.site")
+                    .unwrap()
+                    .as_pointer_value()
+            })
+            .collect();
+        let table_value = ptr_type.const_array(&names);
+        let table = self
+            .module
+            .add_global(table_value.get_type(), None, "__pyc_profile_sites");
+        table.set_initializer(&table_value);
+        table.set_constant(true);
+
+        let init = self.module.get_function("__pyc_profile_init").unwrap();
+        let count = self.context.i64_type().const_int(names.len() as u64, false);
+        self.builder
+            .build_call(init, &[table.as_pointer_value().into(), count.into()], "")
+            .unwrap();
+    }
+}
+
+impl<'ctx, 'a> FunctionGenContext<'ctx, 'a> {
+    /// Enter the site of a loop statement; returns the depth to leave after it
+    pub(crate) fn profile_loop_entry(&mut self, stmt: &TirStmt) -> Option<IntValue<'ctx>> {
+        let kind = match stmt {
+            TirStmt::While { .. } => "while",
+            TirStmt::ForRange { .. } | TirStmt::ForList { .. } => "for",
+            _ => return None,
+        };
+        let function = &self.profile.as_ref()?.name;
+        let site = self.ctx.profile.as_mut()?.next_loop(function, kind);
+        Some(self.ctx.profile_enter(site))
+    }
+
+    /// Leave a loop site after the loop, unless every path out of it returned
+    pub(crate) fn profile_loop_exit(&mut self, depth: Option<IntValue<'ctx>>) {
+        let Some(depth) = depth else {
+            return;
+        };
+        let open = self
+            .ctx
+            .builder
+            .get_insert_block()
+            .is_some_and(|bb| bb.get_terminator().is_none());
+        if open {
+            self.ctx.profile_leave(depth);
+        }
+    }
+
+    /// Leave the function's site (and any loops of it) before a return
+    pub(crate) fn profile_return(&mut self) {
+        if let Some(entry) = self.profile.as_ref().and_then(|scope| scope.entry) {
+            self.ctx.profile_leave(entry);
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn test_parse_flat_profile() {
+        let text = "# pyc profile\n\
+                    # ticks: cycles\n\
+                    #      calls      self ticks     total ticks   self%  site\n\
+                    \x20       1000          52000          52000   80.00  prof.square\n\
+                    \x20          1           9000          61000   13.85  prof.main:for1\n\
+                    \x20          0              0              0    0.00  prof.never\n\
+                    \n\
+                    # allocations by type\n\
+                    \x20          3            120  String\n";
+        let hints = ProfileHints::parse(text);
+        assert_eq!(hints.calls("prof.square"), Some(1000));
+        assert_eq!(hints.calls("prof.never"), Some(0));
+        assert_eq!(hints.calls("prof.main:for1"), None);
+        assert_eq!(hints.calls("String"), None);
+        assert_eq!(hints.total_calls(), 1000);
+    }
+}
@@ -3,6 +3,7 @@
 use inkwell::AddressSpace;
 
 use super::context::CodegenContext;
+use super::tir::elem_storage::ElemStorage;
 
 impl<'ctx> CodegenContext<'ctx> {
     /// Declare runtime functions
@@ -18,45 +19,9 @@ impl<'ctx> CodegenContext<'ctx> {
         let void_type = self.context.void_type();
         let i8_ptr_type = self.context.ptr_type(AddressSpace::default());
 
-        // List type: { i64*, i64, i64 }
-        let _list_type = self.context.struct_type(
-            &[
-                i8_ptr_type.into(), // data pointer (cast from i64*)
-                i64_type.into(),    // len
-                i64_type.into(),    // cap
-            ],
-            false,
-        );
+        // List type: { void*, i64, i64, i32 elem_size, i32 elem_kind }
         let list_ptr_type = self.context.ptr_type(AddressSpace::default());
 
-        // list_new() -> List*
-        declare_fn!(list_ptr_type, "__pyc___builtin___list___init__");
-
-        // list_append(List*, i64) -> void
-        declare_fn!(
-            void_type,
-            "__pyc___builtin___list_append",
-            list_ptr_type,
-            i64_type
-        );
-
-        // list_getitem(List*, i64) -> i64
-        declare_fn!(
-            i64_type,
-            "__pyc___builtin___list___getitem__",
-            list_ptr_type,
-            i64_type
-        );
-
-        // list_setitem(List*, i64, i64) -> void
-        declare_fn!(
-            void_type,
-            "__pyc___builtin___list___setitem__",
-            list_ptr_type,
-            i64_type,
-            i64_type
-        );
-
         // list_len(List*) -> i64
         declare_fn!(i64_type, "__pyc___builtin___list___len__", list_ptr_type);
 
@@ -117,12 +82,81 @@ impl<'ctx> CodegenContext<'ctx> {
             i64_type
         );
 
+        // Bulk bytes operations: bytes + bytes, b[lo:hi], find and count
+        declare_fn!(
+            bytes_ptr_type,
+            "__pyc___builtin___bytes___add__",
+            bytes_ptr_type,
+            bytes_ptr_type
+        );
+        declare_fn!(
+            bytes_ptr_type,
+            "__pyc___builtin___bytes___getslice__",
+            bytes_ptr_type,
+            i64_type,
+            i64_type
+        );
+        declare_fn!(
+            i64_type,
+            "__pyc___builtin___bytes_find",
+            bytes_ptr_type,
+            bytes_ptr_type
+        );
+        declare_fn!(
+            i64_type,
+            "__pyc___builtin___bytes_count",
+            bytes_ptr_type,
+            bytes_ptr_type
+        );
+
+        // Sized bytearray constructors: bytearray(b) and bytearray(n)
+        declare_fn!(
+            bytearray_ptr_type,
+            "__pyc___builtin___bytearray_from_bytes",
+            bytes_ptr_type
+        );
+        declare_fn!(
+            bytearray_ptr_type,
+            "__pyc___builtin___bytearray_zeros",
+            i64_type
+        );
+
+        // Bulk bytearray operations: extend(bytes), ba[lo:hi] and find
+        declare_fn!(
+            void_type,
+            "__pyc___builtin___bytearray_extend",
+            bytearray_ptr_type,
+            bytes_ptr_type
+        );
+        declare_fn!(
+            bytearray_ptr_type,
+            "__pyc___builtin___bytearray___getslice__",
+            bytearray_ptr_type,
+            i64_type,
+            i64_type
+        );
+        declare_fn!(
+            i64_type,
+            "__pyc___builtin___bytearray_find",
+            bytearray_ptr_type,
+            bytes_ptr_type
+        );
+
         // String* type (same layout as other pointer types)
         let string_ptr_type = self.context.ptr_type(AddressSpace::default());
 
         // str_len(String*) -> i64
         declare_fn!(i64_type, "__pyc___builtin___str___len__", string_ptr_type);
 
+        // str_free(String*) -> void (releases compiler-proven temporaries)
+        declare_fn!(void_type, "__pyc___builtin___str_free", string_ptr_type);
+
+        // gc_init(i64 threshold, i64 growth_percent) -> void
+        declare_fn!(void_type, "__pyc_gc_init", i64_type, i64_type);
+
+        // gc_add_root(void** slot) -> void
+        declare_fn!(void_type, "__pyc_gc_add_root", i8_ptr_type);
+
         // str_str(String*) -> String* (identity for __str__)
         declare_fn!(
             string_ptr_type,
@@ -153,6 +187,21 @@ impl<'ctx> CodegenContext<'ctx> {
             string_ptr_type
         );
 
+        // String builders for loops that only append to a string
+        let builder_ptr_type = self.context.ptr_type(AddressSpace::default());
+        declare_fn!(builder_ptr_type, "__pyc_str_builder_new", string_ptr_type);
+        declare_fn!(
+            void_type,
+            "__pyc_str_builder_append",
+            builder_ptr_type,
+            string_ptr_type
+        );
+        declare_fn!(
+            string_ptr_type,
+            "__pyc_str_builder_finish",
+            builder_ptr_type
+        );
+
         // String comparison operators
         declare_fn!(
             i8_type,
@@ -256,15 +305,47 @@ impl<'ctx> CodegenContext<'ctx> {
 
         declare_fn!(i8_type, "__pyc___builtin___str_isspace", string_ptr_type);
 
-        // int.__print__(i64) -> void (prints int without newline)
-        declare_fn!(void_type, "__pyc___builtin___int___print__", i64_type);
+        // int.__print__(i64, i8 end_line) -> void (prints int, then a space or newline)
+        declare_fn!(
+            void_type,
+            "__pyc___builtin___int___print__",
+            i64_type,
+            i8_type
+        );
 
-        // bool.__print__(i8) -> void (prints bool without newline)
-        declare_fn!(void_type, "__pyc___builtin___bool___print__", i8_type);
+        // bool.__print__(i8, i8 end_line) -> void
+        declare_fn!(
+            void_type,
+            "__pyc___builtin___bool___print__",
+            i8_type,
+            i8_type
+        );
 
-        // float.__print__(f64) -> void (prints float without newline)
+        // float.__print__(f64, i8 end_line) -> void
         let f64_type = self.context.f64_type();
-        declare_fn!(void_type, "__pyc___builtin___float___print__", f64_type);
+        declare_fn!(
+            void_type,
+            "__pyc___builtin___float___print__",
+            f64_type,
+            i8_type
+        );
+
+        // str.__print__(String*, i8 end_line) -> void
+        declare_fn!(
+            void_type,
+            "__pyc___builtin___str___print__",
+            string_ptr_type,
+            i8_type
+        );
+
+        // Conversions behind str(), int() and float()
+        declare_fn!(string_ptr_type, "__pyc___builtin___int___str__", i64_type);
+        declare_fn!(string_ptr_type, "__pyc___builtin___float___str__", f64_type);
+        declare_fn!(string_ptr_type, "__pyc___builtin___bool___str__", i8_type);
+        declare_fn!(i64_type, "__pyc___builtin___str___int__", string_ptr_type);
+        declare_fn!(f64_type, "__pyc___builtin___str___float__", string_ptr_type);
+        declare_fn!(i64_type, "__pyc___builtin___float___int__", f64_type);
+        declare_fn!(f64_type, "__pyc___builtin___int___float__", i64_type);
 
         // bytes.__str__(Bytes*) -> String*
         declare_fn!(
@@ -294,19 +375,41 @@ impl<'ctx> CodegenContext<'ctx> {
             bytearray_ptr_type
         );
 
-        // list.__str__(List*) -> String*
-        declare_fn!(
-            string_ptr_type,
-            "__pyc___builtin___list___str__",
-            list_ptr_type
-        );
-
-        // list.__repr__(List*) -> String*
-        declare_fn!(
-            string_ptr_type,
-            "__pyc___builtin___list___repr__",
-            list_ptr_type
-        );
+        // Typed list kernels, one set per element storage (see elem_storage.rs):
+        // __init__() -> List*, append(List*, T), __getitem__(List*, i64) -> T,
+        // __setitem__(List*, i64, T), __str__/__repr__(List*) -> String*,
+        // list_iterator.__next__(ListIterator*) -> T
+        for storage in ElemStorage::ALL {
+            let elem_type = self.elem_type(storage);
+            let list_fn = |method: &str| storage.list_method(method);
+
+            let fn_type = list_ptr_type.fn_type(&[], false);
+            self.module
+                .add_function(&list_fn("__init__"), fn_type, None);
+
+            let fn_type = void_type.fn_type(&[list_ptr_type.into(), elem_type.into()], false);
+            self.module.add_function(&list_fn("append"), fn_type, None);
+
+            let fn_type = elem_type.fn_type(&[list_ptr_type.into(), i64_type.into()], false);
+            self.module
+                .add_function(&list_fn("__getitem__"), fn_type, None);
+
+            let fn_type = void_type.fn_type(
+                &[list_ptr_type.into(), i64_type.into(), elem_type.into()],
+                false,
+            );
+            self.module
+                .add_function(&list_fn("__setitem__"), fn_type, None);
+
+            let fn_type = string_ptr_type.fn_type(&[list_ptr_type.into()], false);
+            self.module.add_function(&list_fn("__str__"), fn_type, None);
+            self.module
+                .add_function(&list_fn("__repr__"), fn_type, None);
+
+            let fn_type = elem_type.fn_type(&[list_ptr_type.into()], false);
+            self.module
+                .add_function(&storage.kernel("list_iterator", "__next__"), fn_type, None);
+        }
 
         // Low-level I/O functions (no newlines)
         // write_str_impl(const char*) -> void
@@ -366,6 +469,28 @@ impl<'ctx> CodegenContext<'ctx> {
         // __pyc_reraise() -> void (noreturn)
         declare_fn!(void_type, "__pyc_reraise");
 
+        // __pyc_parallel_for(i64 start, i64 stop, body(env, lo, hi), void* env) -> void
+        declare_fn!(
+            void_type,
+            "__pyc_parallel_for",
+            i64_type,
+            i64_type,
+            i8_ptr_type,
+            i8_ptr_type
+        );
+
+        // __pyc_parallel_poll() -> i32: exception pending or the loop cancelled
+        declare_fn!(i32_type, "__pyc_parallel_poll");
+
+        // __pyc_profile_init(const char** sites, i64 count) -> void
+        declare_fn!(void_type, "__pyc_profile_init", i8_ptr_type, i64_type);
+
+        // __pyc_profile_enter(i32 site) -> i64 (depth before entering)
+        declare_fn!(i64_type, "__pyc_profile_enter", i32_type);
+
+        // __pyc_profile_leave(i64 depth) -> void
+        declare_fn!(void_type, "__pyc_profile_leave", i64_type);
+
         // Exception.__init__(String* message) -> Exception*
         declare_fn!(
             exception_ptr_type,
@@ -373,13 +498,13 @@ impl<'ctx> CodegenContext<'ctx> {
             string_ptr_type
         );
 
-        // __pyc_exception_new(String* type_name, String* message, String* parent_types) -> Exception*
+        // __pyc_exception_new(String* type_name, String* message, i64 type_id) -> Exception*
         declare_fn!(
             exception_ptr_type,
             "__pyc_exception_new",
             string_ptr_type,
             string_ptr_type,
-            string_ptr_type
+            i64_type
         );
 
         // Exception.__str__(Exception*) -> String*
@@ -396,12 +521,13 @@ impl<'ctx> CodegenContext<'ctx> {
             exception_ptr_type
         );
 
-        // __pyc_exception_matches(Exception*, const char* type_name) -> i32
+        // __pyc_exception_matches(Exception*, i64 first, i64 last) -> i32
         declare_fn!(
             i32_type,
             "__pyc_exception_matches",
             exception_ptr_type,
-            i8_ptr_type
+            i64_type,
+            i64_type
         );
 
         // ================================================================
@@ -431,6 +557,24 @@ impl<'ctx> CodegenContext<'ctx> {
             i64_type
         );
 
+        // range_init(Range*, start, stop, step) -> void (stack ranges)
+        declare_fn!(
+            void_type,
+            "__pyc___builtin___range_init",
+            range_ptr_type,
+            i64_type,
+            i64_type,
+            i64_type
+        );
+
+        // range_iter_init(Range* it, Range* r) -> void (stack for-loop cursors)
+        declare_fn!(
+            void_type,
+            "__pyc___builtin___range_iter_init",
+            range_ptr_type,
+            range_ptr_type
+        );
+
         // range.__iter__(Range*) -> Range*
         declare_fn!(
             range_ptr_type,
@@ -486,13 +630,6 @@ impl<'ctx> CodegenContext<'ctx> {
             list_iterator_ptr_type
         );
 
-        // list_iterator.__next__(ListIterator*) -> i64
-        declare_fn!(
-            i64_type,
-            "__pyc___builtin___list_iterator___next__",
-            list_iterator_ptr_type
-        );
-
         // list_iterator.__dealloc__(ListIterator*) -> void
         declare_fn!(
             void_type,
@@ -500,6 +637,89 @@ impl<'ctx> CodegenContext<'ctx> {
             list_iterator_ptr_type
         );
 
+        // ================================================================
+        // Dict and set runtime functions
+        // ================================================================
+
+        // HashTable* and HashTableIterator* (dict.h)
+        let table_ptr_type = self.context.ptr_type(AddressSpace::default());
+        let i32_type = self.context.i32_type();
+
+        // Typed kernels, one set per key storage (see elem_storage.rs). Values
+        // are raw i64 slots:
+        // dict.__init__(i32 value_kind) -> Dict*, __setitem__(Dict*, K, i64),
+        // __getitem__(Dict*, K) -> i64, __contains__(Dict*, K) -> i8,
+        // get(Dict*, K, i64) -> i64, pop(Dict*, K) -> i64,
+        // set.__init__() -> Set*, add/discard/remove(Set*, K), __contains__(Set*, K) -> i8,
+        // dict_iterator/set_iterator.__next__(HashTableIterator*) -> K
+        for storage in ElemStorage::ALL {
+            let key_type = self.elem_type(storage);
+            let dict_fn = |method: &str| storage.kernel("dict", method);
+            let set_fn = |method: &str| storage.kernel("set", method);
+
+            let fn_type = table_ptr_type.fn_type(&[i32_type.into()], false);
+            self.module
+                .add_function(&dict_fn("__init__"), fn_type, None);
+
+            let fn_type = void_type.fn_type(
+                &[table_ptr_type.into(), key_type.into(), i64_type.into()],
+                false,
+            );
+            self.module
+                .add_function(&dict_fn("__setitem__"), fn_type, None);
+
+            let fn_type = i64_type.fn_type(&[table_ptr_type.into(), key_type.into()], false);
+            self.module
+                .add_function(&dict_fn("__getitem__"), fn_type, None);
+            self.module.add_function(&dict_fn("pop"), fn_type, None);
+
+            let fn_type = i64_type.fn_type(
+                &[table_ptr_type.into(), key_type.into(), i64_type.into()],
+                false,
+            );
+            self.module.add_function(&dict_fn("get"), fn_type, None);
+
+            let fn_type = i8_type.fn_type(&[table_ptr_type.into(), key_type.into()], false);
+            self.module
+                .add_function(&dict_fn("__contains__"), fn_type, None);
+            self.module
+                .add_function(&set_fn("__contains__"), fn_type, None);
+
+            let fn_type = table_ptr_type.fn_type(&[], false);
+            self.module.add_function(&set_fn("__init__"), fn_type, None);
+
+            let fn_type = void_type.fn_type(&[table_ptr_type.into(), key_type.into()], false);
+            self.module.add_function(&set_fn("add"), fn_type, None);
+            self.module.add_function(&set_fn("discard"), fn_type, None);
+            self.module.add_function(&set_fn("remove"), fn_type, None);
+
+            let fn_type = key_type.fn_type(&[table_ptr_type.into()], false);
+            self.module
+                .add_function(&storage.kernel("dict_iterator", "__next__"), fn_type, None);
+            self.module
+                .add_function(&storage.kernel("set_iterator", "__next__"), fn_type, None);
+        }
+
+        // Key-independent functions; dict.keys()/values() return a List*
+        for container in ["dict", "set"] {
+            let name = |method: &str| format!("__pyc___builtin___{}_{}", container, method);
+            declare_fn!(i64_type, &name("__len__"), table_ptr_type);
+            declare_fn!(string_ptr_type, &name("__str__"), table_ptr_type);
+            declare_fn!(string_ptr_type, &name("__repr__"), table_ptr_type);
+            declare_fn!(table_ptr_type, &name("__iter__"), table_ptr_type);
+
+            let iterator_name =
+                |method: &str| format!("__pyc___builtin___{}_iterator_{}", container, method);
+            declare_fn!(table_ptr_type, &iterator_name("__iter__"), table_ptr_type);
+            declare_fn!(void_type, &iterator_name("__dealloc__"), table_ptr_type);
+        }
+        declare_fn!(list_ptr_type, "__pyc___builtin___dict_keys", table_ptr_type);
+        declare_fn!(
+            list_ptr_type,
+            "__pyc___builtin___dict_values",
+            table_ptr_type
+        );
+
         // ================================================================
         // StopIteration exception runtime functions
         // ================================================================
@@ -526,5 +746,54 @@ impl<'ctx> CodegenContext<'ctx> {
             "__pyc___builtin___StopIteration___repr__",
             exception_ptr_type
         );
+
+        // ================================================================
+        // File runtime functions (TextIO and BinaryIO, see file.h)
+        // ================================================================
+
+        // File* type
+        let file_ptr_type = self.context.ptr_type(AddressSpace::default());
+
+        for class in ["TextIO", "BinaryIO"] {
+            let method = |name: &str| format!("__pyc___builtin___{}_{}", class, name);
+            // __init__(String* path, String* mode) -> File*
+            declare_fn!(
+                file_ptr_type,
+                &method("__init__"),
+                string_ptr_type,
+                string_ptr_type
+            );
+            // read(File*) -> String* or Bytes*, write(File*, String* or Bytes*) -> i64
+            declare_fn!(i8_ptr_type, &method("read"), file_ptr_type);
+            declare_fn!(i64_type, &method("write"), file_ptr_type, i8_ptr_type);
+            declare_fn!(void_type, &method("close"), file_ptr_type);
+        }
+
+        // Line iteration: readline, __next__ -> String*, __hasnext__ -> i8
+        declare_fn!(
+            string_ptr_type,
+            "__pyc___builtin___TextIO_readline",
+            file_ptr_type
+        );
+        declare_fn!(
+            file_ptr_type,
+            "__pyc___builtin___TextIO___iter__",
+            file_ptr_type
+        );
+        declare_fn!(
+            string_ptr_type,
+            "__pyc___builtin___TextIO___next__",
+            file_ptr_type
+        );
+        declare_fn!(
+            i8_type,
+            "__pyc___builtin___TextIO___hasnext__",
+            file_ptr_type
+        );
+        declare_fn!(
+            void_type,
+            "__pyc___builtin___TextIO___dealloc__",
+            file_ptr_type
+        );
     }
 }
@@ -3,7 +3,7 @@ use inkwell::values::{AnyValue, BasicValueEnum};
 
 use crate::codegen::context::CodegenContext;
 use crate::tir::decls::{TirClass, TirFunction};
-use crate::tir::{TirModule, TirProgram, TirType};
+use crate::tir::{ClassId, FieldId, TirModule, TirProgram, TirType};
 
 /// Helper to extract BasicValueEnum from a call site
 pub(crate) fn call_result_to_basic_value<'ctx>(
@@ -33,11 +33,40 @@ impl<'ctx> CodegenContext<'ctx> {
         }
     }
 
+    /// Define `__pyc_exception_ids`, the type ids of the exceptions the runtime
+    /// raises itself (indexed by `RtExceptionKind`, see `RUNTIME_EXCEPTIONS`)
+    pub(crate) fn declare_exception_ids(&mut self, program: &TirProgram) {
+        let i64_type = self.context.i64_type();
+        let ids: Vec<_> = self
+            .exception_ids
+            .runtime_ids(program)
+            .into_iter()
+            .map(|id| i64_type.const_int(id as u64, true))
+            .collect();
+        let table = i64_type.const_array(&ids);
+        let global = self
+            .module
+            .add_global(table.get_type(), None, "__pyc_exception_ids");
+        global.set_initializer(&table);
+        global.set_constant(true);
+    }
+
     pub(crate) fn declare_tir_class(&mut self, class: &TirClass, program: &TirProgram) {
-        // Create the struct type with all fields (inherited first, then own)
-        let field_types: Vec<BasicTypeEnum<'ctx>> = class
-            .all_fields()
-            .map(|(_, ty)| self.tir_type_to_llvm(ty, program))
+        // Create the struct type with all fields in layout order, after the
+        // vtable pointer if the class has one
+        let fields: Vec<_> = class.all_fields().collect();
+        let vtable: Option<BasicTypeEnum<'ctx>> = self
+            .layout
+            .has_vtable(class.id)
+            .then(|| self.context.ptr_type(Default::default()).into());
+        let field_types: Vec<BasicTypeEnum<'ctx>> = vtable
+            .into_iter()
+            .chain(
+                self.layout
+                    .fields(class.id)
+                    .iter()
+                    .map(|field| self.tir_type_to_llvm(&fields[field.index()].1, program)),
+            )
             .collect();
 
         let struct_type = self.context.opaque_struct_type(&class.qualified_name);
@@ -48,6 +77,11 @@ impl<'ctx> CodegenContext<'ctx> {
             .insert(class.qualified_name.clone(), struct_type);
     }
 
+    /// Struct index of a field of the class (see `tir::layout`)
+    pub(crate) fn field_slot(&self, class: ClassId, field: FieldId) -> u32 {
+        self.layout.slot(class, field)
+    }
+
     pub(crate) fn declare_tir_function(&mut self, func: &TirFunction, program: &TirProgram) {
         // Skip runtime functions - they're already declared by the runtime
         if func.runtime_name.is_some() {
@@ -0,0 +1,88 @@
+//! Vtables and virtual calls
+//!
+//! Classes of a hierarchy with a virtual method (see `tir::dispatch`) start with
+//! a pointer to a constant vtable `__pyc_vtable_<class>`, an array of function
+//! pointers indexed by slot, and lay out their fields after it. The pointer is
+//! stored when the instance is initialized, before its `__init__` runs, so
+//! calls made from `__init__` already dispatch on the final class.
+
+use inkwell::module::Linkage;
+use inkwell::values::{BasicValueEnum, PointerValue};
+
+use crate::codegen::context::CodegenContext;
+use crate::tir::{ClassId, TirProgram};
+
+use super::function_gen::FunctionGenContext;
+
+impl<'ctx> CodegenContext<'ctx> {
+    /// Define the vtable of every class that has one.
+    /// Must be called after all functions are declared.
+    pub(crate) fn declare_vtables(&mut self, program: &TirProgram) {
+        let ptr_type = self.context.ptr_type(Default::default());
+        for class in &program.classes {
+            let Some(entries) = self.dispatch.vtable(class.id) else {
+                continue;
+            };
+            let entries: Vec<_> = entries
+                .iter()
+                .map(|entry| match entry {
+                    Some(func) => self.functions[&program.function(*func).qualified_name]
+                        .as_global_value()
+                        .as_pointer_value(),
+                    // The slot's method is not defined on this class, so no
+                    // call reaches it
+                    None => ptr_type.const_null(),
+                })
+                .collect();
+            let table = ptr_type.const_array(&entries);
+            let name = format!("__pyc_vtable_{}", class.qualified_name.replace('.', "_"));
+            let global = self.module.add_global(table.get_type(), None, &name);
+            global.set_initializer(&table);
+            global.set_constant(true);
+            global.set_linkage(Linkage::Private);
+            self.vtables.insert(class.id, global.as_pointer_value());
+        }
+    }
+}
+
+impl<'ctx, 'a> FunctionGenContext<'ctx, 'a> {
+    /// Point a new instance at the vtable of its class, if the class has one
+    pub(crate) fn store_vtable(&mut self, class: ClassId, instance: BasicValueEnum<'ctx>) {
+        if let Some(&vtable) = self.ctx.vtables.get(&class) {
+            let instance = self.value_to_pointer(instance);
+            self.ctx.builder.build_store(instance, vtable).unwrap();
+        }
+    }
+
+    /// Load the method in a slot of the receiver's vtable
+    pub(crate) fn load_virtual_method(
+        &mut self,
+        receiver: BasicValueEnum<'ctx>,
+        slot: u32,
+    ) -> PointerValue<'ctx> {
+        let ptr_type = self.ctx.context.ptr_type(Default::default());
+        let receiver = self.value_to_pointer(receiver);
+        let vtable = self
+            .ctx
+            .builder
+            .build_load(ptr_type, receiver, "vtable")
+            .unwrap()
+            .into_pointer_value();
+        let entry = unsafe {
+            self.ctx
+                .builder
+                .build_in_bounds_gep(
+                    ptr_type,
+                    vtable,
+                    &[self.ctx.context.i64_type().const_int(slot as u64, false)],
+                    "vtable.entry",
+                )
+                .unwrap()
+        };
+        self.ctx
+            .builder
+            .build_load(ptr_type, entry, "method")
+            .unwrap()
+            .into_pointer_value()
+    }
+}
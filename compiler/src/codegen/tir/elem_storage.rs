@@ -0,0 +1,173 @@
+//! Unboxed container element storage
+//!
+//! Every `list[T]` shares the same TIR methods, whose runtime names are the
+//! `list[int]` kernels. The runtime has one kernel set per element storage
+//! (`list_f64_append`, `list_bool___getitem__`, ...), and codegen picks the set
+//! from the list's element type when it emits the call. `dict[K, V]` and
+//! `set[T]` work the same way, keyed on the key (element) type: the runtime has
+//! `dict_str___getitem__`, `set_f64_add`, ... Dict values are not part of the
+//! kernel name; they cross the ABI as a raw 8-byte slot.
+
+use inkwell::types::BasicTypeEnum;
+
+use crate::codegen::context::CodegenContext;
+use crate::tir::{TirProgram, TirType};
+
+/// How the runtime stores the elements of a list, or the keys of a dict or set
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub(crate) enum ElemStorage {
+    /// int64_t
+    Int,
+    /// double
+    Float,
+    /// One byte per element
+    Bool,
+    /// String*, printed with str.__repr__
+    Str,
+    /// Any other object pointer
+    Object,
+}
+
+/// Kernel families: runtime name prefix and the methods with one kernel per
+/// storage. Iterator prefixes come before the container they start with.
+const KERNEL_FAMILIES: &[(&str, &[&str])] = &[
+    ("list_iterator", &["__next__"]),
+    ("list", TYPED_LIST_METHODS),
+    ("dict_iterator", &["__next__"]),
+    ("dict", TYPED_DICT_METHODS),
+    ("set_iterator", &["__next__"]),
+    ("set", TYPED_SET_METHODS),
+];
+
+impl ElemStorage {
+    pub(crate) const ALL: [ElemStorage; 5] = [
+        ElemStorage::Int,
+        ElemStorage::Float,
+        ElemStorage::Bool,
+        ElemStorage::Str,
+        ElemStorage::Object,
+    ];
+
+    /// Storage for elements of type `elem`
+    pub(crate) fn of(elem: &TirType, program: &TirProgram) -> Self {
+        match elem {
+            TirType::Int | TirType::Void => ElemStorage::Int,
+            TirType::Float => ElemStorage::Float,
+            TirType::Bool => ElemStorage::Bool,
+            TirType::Class(id) if program.class(*id).qualified_name == "__builtin__.str" => {
+                ElemStorage::Str
+            }
+            TirType::Class(_) => ElemStorage::Object,
+        }
+    }
+
+    /// Storage of the container's first type parameter: the element type of a
+    /// `list[T]`, `set[T]` or their iterators, the key type of a `dict[K, V]`
+    pub(crate) fn of_container(ty: &TirType, program: &TirProgram) -> Self {
+        Self::of_type_param(ty, 0, program)
+    }
+
+    /// Storage of the values of a `dict[K, V]` type
+    pub(crate) fn of_dict_values(ty: &TirType, program: &TirProgram) -> Self {
+        Self::of_type_param(ty, 1, program)
+    }
+
+    fn of_type_param(ty: &TirType, index: usize, program: &TirProgram) -> Self {
+        match ty {
+            TirType::Class(id) => program
+                .class(*id)
+                .type_params
+                .get(index)
+                .map_or(ElemStorage::Int, |elem| ElemStorage::of(elem, program)),
+            _ => ElemStorage::Int,
+        }
+    }
+
+    /// Suffix appended to the container name in runtime kernel names
+    pub(crate) fn suffix(self) -> &'static str {
+        match self {
+            ElemStorage::Int => "",
+            ElemStorage::Float => "_f64",
+            ElemStorage::Bool => "_bool",
+            ElemStorage::Str => "_str",
+            ElemStorage::Object => "_ptr",
+        }
+    }
+
+    /// The runtime's ListElemKind for this storage (the enum order matches)
+    pub(crate) fn kind_index(self) -> u64 {
+        self as u64
+    }
+
+    /// Runtime name of `method` on a `container` (`list`, `dict_iterator`, ...)
+    /// with this storage
+    pub(crate) fn kernel(self, container: &str, method: &str) -> String {
+        format!(
+            "__pyc___builtin___{}{}_{}",
+            container,
+            self.suffix(),
+            method
+        )
+    }
+
+    /// Runtime name of `method` on a list with this storage
+    pub(crate) fn list_method(self, method: &str) -> String {
+        self.kernel("list", method)
+    }
+
+    /// Map an int-storage kernel named by TIR to this storage's kernel.
+    /// Returns None when the TIR name already is the right kernel
+    /// (int storage, or a storage-independent function such as `__len__`).
+    pub(crate) fn specialize(self, runtime_name: &str) -> Option<String> {
+        if self == ElemStorage::Int {
+            return None;
+        }
+        let name = runtime_name.strip_prefix("__pyc___builtin___")?;
+        KERNEL_FAMILIES.iter().find_map(|(container, methods)| {
+            let method = name.strip_prefix(container)?.strip_prefix('_')?;
+            Some(
+                methods
+                    .contains(&method)
+                    .then(|| self.kernel(container, method)),
+            )
+        })?
+    }
+}
+
+/// List methods with one kernel per storage
+pub(crate) const TYPED_LIST_METHODS: &[&str] = &[
+    "__init__",
+    "append",
+    "__getitem__",
+    "__setitem__",
+    "__repr__",
+    "__str__",
+];
+
+/// Dict methods with one kernel per key storage
+pub(crate) const TYPED_DICT_METHODS: &[&str] = &[
+    "__init__",
+    "__setitem__",
+    "__getitem__",
+    "__contains__",
+    "get",
+    "pop",
+];
+
+/// Set methods with one kernel per element storage
+pub(crate) const TYPED_SET_METHODS: &[&str] =
+    &["__init__", "add", "__contains__", "discard", "remove"];
+
+impl<'ctx> CodegenContext<'ctx> {
+    /// LLVM type of one stored element
+    pub(crate) fn elem_type(&self, storage: ElemStorage) -> BasicTypeEnum<'ctx> {
+        match storage {
+            ElemStorage::Int => self.context.i64_type().into(),
+            ElemStorage::Float => self.context.f64_type().into(),
+            ElemStorage::Bool => self.context.i8_type().into(),
+            ElemStorage::Str | ElemStorage::Object => {
+                self.context.ptr_type(Default::default()).into()
+            }
+        }
+    }
+}
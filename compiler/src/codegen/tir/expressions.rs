@@ -1,11 +1,15 @@
-use inkwell::values::BasicValueEnum;
+use inkwell::module::Linkage;
+use inkwell::values::{BasicMetadataValueEnum, BasicValueEnum, PointerValue};
 
 use crate::ast::UnaryOp;
+use crate::tir::dispatch::Binding;
 use crate::tir::expr::{TirConstant, TirExpr, TirExprKind};
-use crate::tir::{TirProgram, TirType};
+use crate::tir::{ClassId, TirProgram, TirType};
 
 use super::declarations::call_result_to_basic_value;
+use super::elem_storage::ElemStorage;
 use super::function_gen::FunctionGenContext;
+use super::temporaries::borrows_string_args;
 
 impl<'ctx, 'a> FunctionGenContext<'ctx, 'a> {
     pub(crate) fn codegen_expr(
@@ -39,6 +43,10 @@ impl<'ctx, 'a> FunctionGenContext<'ctx, 'a> {
                         .build_call(func, &[lhs.into(), rhs.into()], "str_concat")
                         .unwrap();
 
+                    // __add__ copies both operands, so intermediate results are dead
+                    self.free_if_string_temp(left, lhs, program);
+                    self.free_if_string_temp(right, rhs, program);
+
                     let default = self
                         .ctx
                         .context
@@ -83,6 +91,10 @@ impl<'ctx, 'a> FunctionGenContext<'ctx, 'a> {
                         CompareOp::LtE => "__pyc___builtin___str___le__",
                         CompareOp::Gt => "__pyc___builtin___str___gt__",
                         CompareOp::GtE => "__pyc___builtin___str___ge__",
+                        // Lowered to __contains__ calls
+                        CompareOp::In | CompareOp::NotIn => {
+                            unreachable!("membership test reached string comparison")
+                        }
                     };
 
                     let func = self
@@ -97,6 +109,9 @@ impl<'ctx, 'a> FunctionGenContext<'ctx, 'a> {
                         .build_call(func, &[lhs.into(), rhs.into()], "str_cmp")
                         .unwrap();
 
+                    self.free_if_string_temp(left, lhs, program);
+                    self.free_if_string_temp(right, rhs, program);
+
                     let default = self.ctx.context.i8_type().const_int(0, false).into();
                     return call_result_to_basic_value(result, default);
                 }
@@ -156,53 +171,133 @@ impl<'ctx, 'a> FunctionGenContext<'ctx, 'a> {
 
             TirExprKind::Call { func, args } => {
                 let func_def = program.function(*func);
+                let binding = self.call_bindings.get(expr);
 
-                // Get the LLVM function - either by runtime_name or qualified_name
+                if self.is_stack_object_dealloc(func_def, args) {
+                    return self.ctx.context.i64_type().const_int(0, false).into();
+                }
+
+                // Get the LLVM function - either by runtime_name or qualified_name.
+                // List methods resolve to the kernel for the receiver's element storage.
                 let fn_value = if let Some(runtime_name) = &func_def.runtime_name {
+                    let runtime_name = args
+                        .first()
+                        .and_then(|recv| {
+                            ElemStorage::of_container(&recv.ty, program).specialize(runtime_name)
+                        })
+                        .unwrap_or_else(|| runtime_name.clone());
                     self.ctx
                         .module
-                        .get_function(runtime_name)
+                        .get_function(&runtime_name)
                         .unwrap_or_else(|| panic!("Runtime function {} not found", runtime_name))
                 } else {
-                    self.ctx.functions[&func_def.qualified_name]
+                    let target = match binding {
+                        Some(Binding::Direct(target)) => target,
+                        _ => *func,
+                    };
+                    self.ctx.functions[&program.function(target).qualified_name]
                 };
 
                 // Get LLVM function parameter types for automatic type conversion
                 let fn_type = fn_value.get_type();
                 let param_types: Vec<_> = fn_type.get_param_types();
+                let i64_type = self.ctx.context.i64_type();
+
+                // Builtin methods declare their parameters without the receiver
+                let param_offset = args.len().saturating_sub(func_def.params.len());
 
                 // Evaluate args with automatic type conversion based on LLVM param types
-                let mut call_args = Vec::new();
+                let mut call_values = Vec::new();
+                let mut arg_values = Vec::new();
                 for (i, arg) in args.iter().enumerate() {
-                    let arg_val = self.codegen_expr(arg, program);
+                    let mut arg_val = self.codegen_expr(arg, program);
+                    arg_values.push(arg_val);
+
+                    // An int passed where the TIR signature takes a float
+                    let declared = i
+                        .checked_sub(param_offset)
+                        .and_then(|p| func_def.params.get(p));
+                    if arg.ty == TirType::Int
+                        && declared.is_some_and(|(_, ty)| *ty == TirType::Float)
+                    {
+                        arg_val = self.convert_to_float(arg_val).into();
+                    }
 
-                    // Convert value to match LLVM parameter type if needed
-                    let converted = if i < param_types.len() {
-                        let expected_type = param_types[i];
-                        if expected_type.is_int_type() && arg_val.is_pointer_value() {
-                            // LLVM expects i64 but we have a pointer - convert
+                    // Convert value to match LLVM parameter type if needed: an i64
+                    // parameter takes pointers, and raw slots (dict values) take any value
+                    let converted = match param_types.get(i) {
+                        Some(expected)
+                            if *expected == i64_type.into()
+                                && arg_val.get_type() != i64_type.into() =>
+                        {
                             self.value_to_i64(arg_val).into()
-                        } else {
-                            arg_val
                         }
-                    } else {
-                        arg_val
+                        _ => arg_val,
                     };
-                    call_args.push(converted.into());
+                    call_values.push(converted);
                 }
 
-                let call = self
-                    .ctx
-                    .builder
-                    .build_call(fn_value, &call_args, "call")
-                    .unwrap();
-                let default = self.ctx.context.i64_type().const_int(0, false).into();
-                let result = call_result_to_basic_value(call, default);
+                // Subscripts that need no check read or write the element in place
+                let inline = self.codegen_inline_subscript(expr, func_def, &call_values, program);
+                let result = if let Some(value) = inline {
+                    value
+                } else {
+                    let call_args: Vec<BasicMetadataValueEnum> =
+                        call_values.iter().map(|&value| value.into()).collect();
+                    let call = match binding {
+                        Some(Binding::Virtual(slot)) => {
+                            let method = self.load_virtual_method(call_values[0], slot);
+                            self.ctx
+                                .builder
+                                .build_indirect_call(fn_type, method, &call_args, "call")
+                                .unwrap()
+                        }
+                        _ => self
+                            .ctx
+                            .builder
+                            .build_call(fn_value, &call_args, "call")
+                            .unwrap(),
+                    };
 
-                // Convert result if TIR expects a Class but LLVM returned i64
-                if let TirType::Class(_) = &expr.ty {
-                    if result.is_int_value() {
-                        return self.value_to_pointer(result).into();
+                    if func_def
+                        .runtime_name
+                        .as_deref()
+                        .is_some_and(borrows_string_args)
+                    {
+                        for (arg, value) in args.iter().zip(arg_values) {
+                            self.free_if_string_temp(arg, value, program);
+                        }
+                    }
+
+                    let default = self.ctx.context.i64_type().const_int(0, false).into();
+                    call_result_to_basic_value(call, default)
+                };
+
+                // Convert result if LLVM returned an i64 slot (dict values) for
+                // another TIR type
+                if result.get_type() == i64_type.into() {
+                    match &expr.ty {
+                        TirType::Class(_) => return self.value_to_pointer(result).into(),
+                        TirType::Float => {
+                            return self
+                                .ctx
+                                .builder
+                                .build_bit_cast(result, self.ctx.context.f64_type(), "slot_to_f64")
+                                .unwrap();
+                        }
+                        TirType::Bool => {
+                            return self
+                                .ctx
+                                .builder
+                                .build_int_truncate(
+                                    result.into_int_value(),
+                                    self.ctx.context.i8_type(),
+                                    "slot_to_bool",
+                                )
+                                .unwrap()
+                                .into();
+                        }
+                        _ => {}
                     }
                 }
 
@@ -212,158 +307,31 @@ impl<'ctx, 'a> FunctionGenContext<'ctx, 'a> {
             TirExprKind::Construct { class, args } => {
                 let class_def = program.class(*class);
 
-                // Handle bytearray specially
+                // bytearray(), bytearray(b) and bytearray(n) each have a
+                // constructor that sizes the buffer once
                 if class_def.qualified_name == "__builtin__.bytearray" {
-                    if let Some(bytearray_new) = self
+                    let ctor = match args.first().map(|arg| &arg.ty) {
+                        None => "__pyc___builtin___bytearray___init__",
+                        Some(TirType::Int) => "__pyc___builtin___bytearray_zeros",
+                        Some(_) => "__pyc___builtin___bytearray_from_bytes",
+                    };
+                    let ctor_args: Vec<BasicMetadataValueEnum> = args
+                        .iter()
+                        .map(|arg| self.codegen_expr(arg, program).into())
+                        .collect();
+                    let ctor = self.ctx.module.get_function(ctor).unwrap();
+                    let call = self
                         .ctx
-                        .module
-                        .get_function("__pyc___builtin___bytearray___init__")
-                    {
-                        let call = self
-                            .ctx
-                            .builder
-                            .build_call(bytearray_new, &[], "bytearray")
-                            .unwrap();
-                        let default = self
-                            .ctx
-                            .context
-                            .ptr_type(Default::default())
-                            .const_null()
-                            .into();
-                        let ba_ptr = call_result_to_basic_value(call, default);
-
-                        // If there's a bytes argument, copy bytes into bytearray
-                        if !args.is_empty() {
-                            let bytes_ptr = self.codegen_expr(&args[0], program);
-
-                            // Get length using bytes_len(Bytes*)
-                            let bytes_len_fn = self
-                                .ctx
-                                .module
-                                .get_function("__pyc___builtin___bytes___len__")
-                                .expect("__pyc___builtin___bytes___len__ not declared");
-                            let len_call = self
-                                .ctx
-                                .builder
-                                .build_call(bytes_len_fn, &[bytes_ptr.into()], "len")
-                                .unwrap();
-                            let i64_type = self.ctx.context.i64_type();
-                            let len = call_result_to_basic_value(
-                                len_call,
-                                i64_type.const_int(0, false).into(),
-                            )
-                            .into_int_value();
-
-                            // Loop and append each byte using bytes_getitem
-                            if let Some(bytearray_append) = self
-                                .ctx
-                                .module
-                                .get_function("__pyc___builtin___bytearray_append")
-                            {
-                                if let Some(bytes_getitem) = self
-                                    .ctx
-                                    .module
-                                    .get_function("__pyc___builtin___bytes___getitem__")
-                                {
-                                    let zero = i64_type.const_int(0, false);
-                                    let one = i64_type.const_int(1, false);
-
-                                    // Create loop blocks
-                                    let current_fn = self.ctx.current_function.unwrap();
-                                    let loop_cond = self
-                                        .ctx
-                                        .context
-                                        .append_basic_block(current_fn, "ba_loop_cond");
-                                    let loop_body = self
-                                        .ctx
-                                        .context
-                                        .append_basic_block(current_fn, "ba_loop_body");
-                                    let loop_end = self
-                                        .ctx
-                                        .context
-                                        .append_basic_block(current_fn, "ba_loop_end");
-
-                                    // Allocate index
-                                    let idx_ptr =
-                                        self.ctx.builder.build_alloca(i64_type, "idx").unwrap();
-                                    self.ctx.builder.build_store(idx_ptr, zero).unwrap();
-                                    self.ctx
-                                        .builder
-                                        .build_unconditional_branch(loop_cond)
-                                        .unwrap();
-
-                                    // Loop condition
-                                    self.ctx.builder.position_at_end(loop_cond);
-                                    let idx = self
-                                        .ctx
-                                        .builder
-                                        .build_load(i64_type, idx_ptr, "idx_val")
-                                        .unwrap()
-                                        .into_int_value();
-                                    let cond = self
-                                        .ctx
-                                        .builder
-                                        .build_int_compare(
-                                            inkwell::IntPredicate::SLT,
-                                            idx,
-                                            len,
-                                            "cond",
-                                        )
-                                        .unwrap();
-                                    self.ctx
-                                        .builder
-                                        .build_conditional_branch(cond, loop_body, loop_end)
-                                        .unwrap();
-
-                                    // Loop body
-                                    self.ctx.builder.position_at_end(loop_body);
-                                    let call = self
-                                        .ctx
-                                        .builder
-                                        .build_call(
-                                            bytes_getitem,
-                                            &[bytes_ptr.into(), idx.into()],
-                                            "byte",
-                                        )
-                                        .unwrap();
-                                    let byte_val = call_result_to_basic_value(
-                                        call,
-                                        i64_type.const_int(0, false).into(),
-                                    );
-                                    self.ctx
-                                        .builder
-                                        .build_call(
-                                            bytearray_append,
-                                            &[ba_ptr.into(), byte_val.into()],
-                                            "",
-                                        )
-                                        .unwrap();
-                                    let next_idx = self
-                                        .ctx
-                                        .builder
-                                        .build_int_add(idx, one, "next_idx")
-                                        .unwrap();
-                                    self.ctx.builder.build_store(idx_ptr, next_idx).unwrap();
-                                    self.ctx
-                                        .builder
-                                        .build_unconditional_branch(loop_cond)
-                                        .unwrap();
-
-                                    // After loop
-                                    self.ctx.builder.position_at_end(loop_end);
-                                }
-                            }
-                        }
-
-                        return ba_ptr;
-                    } else {
-                        return self
-                            .ctx
-                            .context
-                            .ptr_type(Default::default())
-                            .const_null()
-                            .into();
-                    }
+                        .builder
+                        .build_call(ctor, &ctor_args, "bytearray")
+                        .unwrap();
+                    let default = self
+                        .ctx
+                        .context
+                        .ptr_type(Default::default())
+                        .const_null()
+                        .into();
+                    return call_result_to_basic_value(call, default);
                 }
 
                 // Note: range() is now handled by TirExprKind::Range
@@ -417,31 +385,7 @@ impl<'ctx, 'a> FunctionGenContext<'ctx, 'a> {
                 }
 
                 // Handle classes that inherit from Exception
-                // Check if this class has Exception as a parent (direct or indirect)
-                // and collect parent class names for inheritance matching
-                let (is_exception_subclass, parent_names) = {
-                    let mut current = class_def.parent;
-                    let mut is_exc = false;
-                    let mut parents = Vec::new();
-                    while let Some(parent_id) = current {
-                        let parent_class = program.class(parent_id);
-                        // Get the simple class name (last component of qualified_name)
-                        let parent_name = parent_class
-                            .qualified_name
-                            .rsplit('.')
-                            .next()
-                            .unwrap_or(&parent_class.qualified_name);
-                        parents.push(parent_name.to_string());
-                        if parent_class.qualified_name == "__builtin__.Exception" {
-                            is_exc = true;
-                            break;
-                        }
-                        current = parent_class.parent;
-                    }
-                    (is_exc, parents.join(","))
-                };
-
-                if is_exception_subclass {
+                if let Some(type_id) = self.ctx.exception_ids.get(*class) {
                     if let Some(exc_new) = self.ctx.module.get_function("__pyc_exception_new") {
                         // Get the class name (last component of qualified_name)
                         let class_name = class_def
@@ -458,15 +402,15 @@ impl<'ctx, 'a> FunctionGenContext<'ctx, 'a> {
                             self.create_string_constant("")
                         };
 
-                        // Create parent types string for inheritance matching
-                        let parent_types = self.create_string_constant(&parent_names);
+                        // Handlers match on the type id, see tir::exception_ids
+                        let type_id = self.ctx.context.i64_type().const_int(type_id as u64, true);
 
                         let call = self
                             .ctx
                             .builder
                             .build_call(
                                 exc_new,
-                                &[type_name.into(), msg_val.into(), parent_types.into()],
+                                &[type_name.into(), msg_val.into(), type_id.into()],
                                 "exception",
                             )
                             .unwrap();
@@ -498,27 +442,7 @@ impl<'ctx, 'a> FunctionGenContext<'ctx, 'a> {
                         .const_null()
                         .into();
                     let ptr = call_result_to_basic_value(call, default);
-
-                    // Call __init__ if it exists
-                    if let Some(init_func_id) = class_def.get_method("__init__") {
-                        let init_func = program.function(init_func_id);
-                        // Copy FunctionValue (it's Copy) to end the borrow before codegen_expr
-                        if let Some(&init_fn) = self.ctx.functions.get(&init_func.qualified_name) {
-                            let mut init_args: Vec<BasicValueEnum<'ctx>> = vec![ptr];
-                            for arg in args {
-                                init_args.push(self.codegen_expr(arg, program));
-                            }
-                            self.ctx
-                                .builder
-                                .build_call(
-                                    init_fn,
-                                    &init_args.iter().map(|v| (*v).into()).collect::<Vec<_>>(),
-                                    "",
-                                )
-                                .unwrap();
-                        }
-                    }
-
+                    self.codegen_init_call(*class, ptr, args, program);
                     ptr
                 } else {
                     self.ctx
@@ -592,6 +516,7 @@ impl<'ctx, 'a> FunctionGenContext<'ctx, 'a> {
                 let obj_val = self.codegen_expr(object, program);
                 let class_def = program.class(*class);
                 let class_type = self.ctx.class_types[&class_def.qualified_name];
+                let slot = self.ctx.field_slot(*class, *field);
 
                 // Convert to pointer if needed (e.g., from list_get which returns i64)
                 let obj_ptr = self.value_to_pointer(obj_val);
@@ -599,7 +524,7 @@ impl<'ctx, 'a> FunctionGenContext<'ctx, 'a> {
                 let field_ptr = self
                     .ctx
                     .builder
-                    .build_struct_gep(class_type, obj_ptr, field.index() as u32, "field_ptr")
+                    .build_struct_gep(class_type, obj_ptr, slot, "field_ptr")
                     .unwrap();
 
                 let field_ty = self.ctx.tir_type_to_llvm(&expr.ty, program);
@@ -613,46 +538,123 @@ impl<'ctx, 'a> FunctionGenContext<'ctx, 'a> {
                 elements,
                 elem_ty: _,
             } => {
-                // Create a new list
-                if let Some(list_new) = self
+                // Create a new list with the element type's unboxed storage. The
+                // list's class decides, exactly as it does for method calls on it.
+                let storage = ElemStorage::of_container(&expr.ty, program);
+                let list_new = self
                     .ctx
                     .module
-                    .get_function("__pyc___builtin___list___init__")
-                {
-                    let call = self.ctx.builder.build_call(list_new, &[], "list").unwrap();
-                    let default = self
-                        .ctx
-                        .context
-                        .ptr_type(Default::default())
-                        .const_null()
-                        .into();
-                    let list_ptr = call_result_to_basic_value(call, default);
+                    .get_function(&storage.list_method("__init__"))
+                    .expect("list __init__ kernel not declared");
+                let list_append = self
+                    .ctx
+                    .module
+                    .get_function(&storage.list_method("append"))
+                    .expect("list append kernel not declared");
 
-                    // Append each element
-                    if let Some(list_append) = self
-                        .ctx
-                        .module
-                        .get_function("__pyc___builtin___list_append")
-                    {
-                        for elem in elements {
-                            let val = self.codegen_expr(elem, program);
-                            // Convert value to i64 for list storage
-                            let val_i64 = self.value_to_i64(val);
-                            self.ctx
-                                .builder
-                                .build_call(list_append, &[list_ptr.into(), val_i64.into()], "")
-                                .unwrap();
-                        }
-                    }
+                let call = self.ctx.builder.build_call(list_new, &[], "list").unwrap();
+                let default = self
+                    .ctx
+                    .context
+                    .ptr_type(Default::default())
+                    .const_null()
+                    .into();
+                let list_ptr = call_result_to_basic_value(call, default);
 
-                    list_ptr
-                } else {
+                // Append each element
+                for elem in elements {
+                    let val = self.codegen_expr(elem, program);
                     self.ctx
-                        .context
-                        .ptr_type(Default::default())
-                        .const_null()
-                        .into()
+                        .builder
+                        .build_call(list_append, &[list_ptr.into(), val.into()], "")
+                        .unwrap();
+                }
+
+                list_ptr
+            }
+
+            TirExprKind::Dict { keys, values } => {
+                // The table's key kernels and its value kind come from the dict's
+                // class; values are stored as raw slots
+                let key_storage = ElemStorage::of_container(&expr.ty, program);
+                let value_storage = ElemStorage::of_dict_values(&expr.ty, program);
+                let dict_new = self
+                    .ctx
+                    .module
+                    .get_function(&key_storage.kernel("dict", "__init__"))
+                    .expect("dict __init__ kernel not declared");
+                let dict_setitem = self
+                    .ctx
+                    .module
+                    .get_function(&key_storage.kernel("dict", "__setitem__"))
+                    .expect("dict __setitem__ kernel not declared");
+
+                let value_kind = self
+                    .ctx
+                    .context
+                    .i32_type()
+                    .const_int(value_storage.kind_index(), false);
+                let call = self
+                    .ctx
+                    .builder
+                    .build_call(dict_new, &[value_kind.into()], "dict")
+                    .unwrap();
+                let default = self
+                    .ctx
+                    .context
+                    .ptr_type(Default::default())
+                    .const_null()
+                    .into();
+                let dict_ptr = call_result_to_basic_value(call, default);
+
+                for (key, value) in keys.iter().zip(values) {
+                    let key_val = self.codegen_expr(key, program);
+                    let value_val = self.codegen_expr(value, program);
+                    let value_slot = self.value_to_i64(value_val);
+                    self.ctx
+                        .builder
+                        .build_call(
+                            dict_setitem,
+                            &[dict_ptr.into(), key_val.into(), value_slot.into()],
+                            "",
+                        )
+                        .unwrap();
+                }
+
+                dict_ptr
+            }
+
+            TirExprKind::Set { elements } => {
+                let storage = ElemStorage::of_container(&expr.ty, program);
+                let set_new = self
+                    .ctx
+                    .module
+                    .get_function(&storage.kernel("set", "__init__"))
+                    .expect("set __init__ kernel not declared");
+                let set_add = self
+                    .ctx
+                    .module
+                    .get_function(&storage.kernel("set", "add"))
+                    .expect("set add kernel not declared");
+
+                let call = self.ctx.builder.build_call(set_new, &[], "set").unwrap();
+                let default = self
+                    .ctx
+                    .context
+                    .ptr_type(Default::default())
+                    .const_null()
+                    .into();
+                let set_ptr = call_result_to_basic_value(call, default);
+
+                for elem in elements {
+                    let val = self.codegen_expr(elem, program);
+                    self.ctx
+                        .builder
+                        .build_call(set_add, &[set_ptr.into(), val.into()], "")
+                        .unwrap();
                 }
+
+                set_ptr
             }
 
             TirExprKind::Bytes { data } => {
@@ -694,7 +696,7 @@ impl<'ctx, 'a> FunctionGenContext<'ctx, 'a> {
         }
     }
 
-    pub(crate) fn codegen_constant(&self, c: &TirConstant) -> BasicValueEnum<'ctx> {
+    pub(crate) fn codegen_constant(&mut self, c: &TirConstant) -> BasicValueEnum<'ctx> {
         match c {
             TirConstant::Int(n) => self
                 .ctx
@@ -703,66 +705,7 @@ impl<'ctx, 'a> FunctionGenContext<'ctx, 'a> {
                 .const_int(*n as u64, true)
                 .into(),
             TirConstant::Float(f) => self.ctx.context.f64_type().const_float(*f).into(),
-            TirConstant::Str(s) => {
-                // Create a static String struct: { i64 len, i32 cp_count, i16 flags, [N+1 x i8] data }
-                // This matches the C String struct layout with Unicode support
-                // +1 for null terminator for C compatibility
-                let i64_type = self.ctx.context.i64_type();
-                let i32_type = self.ctx.context.i32_type();
-                let i16_type = self.ctx.context.i16_type();
-                let i8_type = self.ctx.context.i8_type();
-                let str_bytes = s.as_bytes();
-                let len = str_bytes.len();
-
-                // Detect if string is ASCII-only
-                let is_ascii = str_bytes.iter().all(|&b| b < 128);
-                let flags: u16 = if is_ascii { 0x03 } else { 0x02 }; // ASCII_ONLY | VALID_UTF8 or just VALID_UTF8
-                let cp_count: i32 = if is_ascii { len as i32 } else { -1 }; // Known for ASCII, unknown for Unicode
-
-                // Array type includes null terminator
-                let array_type = i8_type.array_type((len + 1) as u32);
-
-                // Create struct type { i64 len, i32 cp_count, i16 flags, [N+1 x i8] data }
-                let string_struct_type = self.ctx.context.struct_type(
-                    &[
-                        i64_type.into(),
-                        i32_type.into(),
-                        i16_type.into(),
-                        array_type.into(),
-                    ],
-                    false, // not packed
-                );
-
-                // Build the constant values
-                let len_val = i64_type.const_int(len as u64, false);
-                let cp_count_val = i32_type.const_int(cp_count as u64, true); // signed
-                let flags_val = i16_type.const_int(flags as u64, false);
-                let mut char_values: Vec<_> = str_bytes
-                    .iter()
-                    .map(|&b| i8_type.const_int(b as u64, false))
-                    .collect();
-                char_values.push(i8_type.const_int(0, false)); // null terminator
-                let char_array = i8_type.const_array(&char_values);
-
-                // Create the struct constant
-                let struct_val = string_struct_type.const_named_struct(&[
-                    len_val.into(),
-                    cp_count_val.into(),
-                    flags_val.into(),
-                    char_array.into(),
-                ]);
-
-                // Create a global constant for this String struct
-                let global = self
-                    .ctx
-                    .module
-                    .add_global(string_struct_type, None, "str_literal");
-                global.set_initializer(&struct_val);
-                global.set_constant(true);
-
-                // Return pointer to the String struct (String*)
-                global.as_pointer_value().into()
-            }
+            TirConstant::Str(s) => self.create_string_constant(s),
             TirConstant::Bool(b) => self
                 .ctx
                 .context
@@ -778,13 +721,26 @@ impl<'ctx, 'a> FunctionGenContext<'ctx, 'a> {
         }
     }
 
-    /// Create a string constant and return a pointer to it
-    /// Creates a String struct matching the C layout: { i64 len, i32 cp_count, i16 flags, char[] data }
-    fn create_string_constant(&mut self, s: &str) -> inkwell::values::BasicValueEnum<'ctx> {
+    /// Return a pointer to the String constant for `s`. Each distinct text is
+    /// emitted once per module, so equal literals are the same object and
+    /// `str.__eq__` answers from its pointer comparison.
+    fn create_string_constant(&mut self, s: &str) -> BasicValueEnum<'ctx> {
+        if let Some(&global) = self.ctx.string_literals.get(s) {
+            return global.into();
+        }
+        let global = self.emit_string_constant(s);
+        self.ctx.string_literals.insert(s.to_string(), global);
+        global.into()
+    }
+
+    /// Emit a String global matching the C layout:
+    /// { i64 len, i32 cp_count, i16 flags, i32 hash, i64* cp_index, char[] data }
+    fn emit_string_constant(&self, s: &str) -> PointerValue<'ctx> {
         let i64_type = self.ctx.context.i64_type();
         let i32_type = self.ctx.context.i32_type();
         let i16_type = self.ctx.context.i16_type();
         let i8_type = self.ctx.context.i8_type();
+        let ptr_type = self.ctx.context.ptr_type(Default::default());
         let str_bytes = s.as_bytes();
         let len = str_bytes.len();
 
@@ -794,13 +750,15 @@ impl<'ctx, 'a> FunctionGenContext<'ctx, 'a> {
         // Array type includes null terminator
         let array_type = i8_type.array_type((len + 1) as u32);
 
-        // Create struct type { i64 len, i32 cp_count, i16 flags, [N+1 x i8] data }
-        // This matches the C String struct layout
+        // Create struct type { i64 len, i32 cp_count, i16 flags, i32 hash, ptr cp_index,
+        // [N+1 x i8] data }. This matches the C String struct layout
         let string_struct_type = self.ctx.context.struct_type(
             &[
                 i64_type.into(),
                 i32_type.into(),
                 i16_type.into(),
+                i32_type.into(),
+                ptr_type.into(),
                 array_type.into(),
             ],
             false,
@@ -808,11 +766,13 @@ impl<'ctx, 'a> FunctionGenContext<'ctx, 'a> {
 
         // Build the constant values
         let len_val = i64_type.const_int(len as u64, false);
-        // For ASCII strings, cp_count equals byte length; otherwise -1 (not computed)
-        let cp_count_val = if is_ascii {
-            i32_type.const_int(len as u64, false)
+        // Literals are read-only, so their codepoint count and index are computed here
+        let cp_count = s.chars().count();
+        let cp_count_val = i32_type.const_int(cp_count as u64, false);
+        let cp_index_val = if !is_ascii && cp_count > STR_INDEX_STRIDE {
+            self.create_codepoint_index(s)
         } else {
-            i32_type.const_int((-1i32) as u64, true)
+            ptr_type.const_null()
         };
         // Flags: 0x01 = ASCII_ONLY, 0x02 = VALID_UTF8
         let flags_val = if is_ascii {
@@ -820,6 +780,7 @@ impl<'ctx, 'a> FunctionGenContext<'ctx, 'a> {
         } else {
             i16_type.const_int(0x02, false) // VALID_UTF8 only
         };
+        let hash_val = i32_type.const_int(str_hash(str_bytes) as u64, false);
 
         let mut char_values: Vec<_> = str_bytes
             .iter()
@@ -833,6 +794,8 @@ impl<'ctx, 'a> FunctionGenContext<'ctx, 'a> {
             len_val.into(),
             cp_count_val.into(),
             flags_val.into(),
+            hash_val.into(),
+            cp_index_val.into(),
             char_array.into(),
         ]);
 
@@ -843,8 +806,82 @@ impl<'ctx, 'a> FunctionGenContext<'ctx, 'a> {
             .add_global(string_struct_type, None, "str_literal");
         global.set_initializer(&struct_val);
         global.set_constant(true);
+        global.set_linkage(Linkage::Private);
+        global.set_unnamed_addr(true);
+        // Matches the alignment of heap Strings, whose header starts with an i64
+        global.set_alignment(8);
+
+        global.as_pointer_value()
+    }
+
+    /// Create the codepoint index of a non-ASCII literal: the byte offset of
+    /// every STR_INDEX_STRIDE-th codepoint, as the runtime would build it
+    fn create_codepoint_index(&self, s: &str) -> PointerValue<'ctx> {
+        let i64_type = self.ctx.context.i64_type();
+        let offsets: Vec<_> = s
+            .char_indices()
+            .step_by(STR_INDEX_STRIDE)
+            .map(|(offset, _)| i64_type.const_int(offset as u64, false))
+            .collect();
+        let index_type = i64_type.array_type(offsets.len() as u32);
+        let global = self
+            .ctx
+            .module
+            .add_global(index_type, None, "str_literal_index");
+        global.set_initializer(&i64_type.const_array(&offsets));
+        global.set_constant(true);
+        global.set_linkage(Linkage::Private);
+        global.set_unnamed_addr(true);
+        global.as_pointer_value()
+    }
 
-        // Return pointer to the String struct (String*)
-        global.as_pointer_value().into()
+    /// Call the class's `__init__` (if any) on a newly created instance
+    pub(crate) fn codegen_init_call(
+        &mut self,
+        class: ClassId,
+        instance: BasicValueEnum<'ctx>,
+        args: &[TirExpr],
+        program: &TirProgram,
+    ) {
+        self.store_vtable(class, instance);
+        let Some(init_func_id) = program.class(class).get_method("__init__") else {
+            return;
+        };
+        let init_func = program.function(init_func_id);
+        // Copy FunctionValue (it's Copy) to end the borrow before codegen_expr
+        if let Some(&init_fn) = self.ctx.functions.get(&init_func.qualified_name) {
+            let mut init_args: Vec<BasicValueEnum<'ctx>> = vec![instance];
+            for arg in args {
+                init_args.push(self.codegen_expr(arg, program));
+            }
+            self.ctx
+                .builder
+                .build_call(
+                    init_fn,
+                    &init_args.iter().map(|v| (*v).into()).collect::<Vec<_>>(),
+                    "",
+                )
+                .unwrap();
+        }
+    }
+}
+
+/// Codepoints between entries of a string's codepoint index
+/// (`STR_INDEX_STRIDE` in str.h)
+const STR_INDEX_STRIDE: usize = 64;
+
+/// The runtime's string hash (`str_hash_bytes` in str.h): FNV-1a, folded to
+/// 32 bits, never 0
+fn str_hash(bytes: &[u8]) -> u32 {
+    let mut h: u64 = 0xcbf29ce484222325;
+    for &b in bytes {
+        h ^= b as u64;
+        h = h.wrapping_mul(0x100000001b3);
+    }
+    let folded = (h ^ (h >> 32)) as u32;
+    if folded == 0 {
+        1
+    } else {
+        folded
     }
 }
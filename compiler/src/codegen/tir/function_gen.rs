@@ -1,9 +1,16 @@
+use std::collections::HashMap;
+
 use inkwell::types::BasicTypeEnum;
-use inkwell::values::{BasicValueEnum, PointerValue};
+use inkwell::values::{BasicValueEnum, IntValue, PointerValue};
 
 use crate::codegen::context::CodegenContext;
+use crate::codegen::profile::ProfileScope;
+use crate::driver::GcMode;
+use crate::tir::bounds::SafeSubscripts;
 use crate::tir::decls::TirFunction;
-use crate::tir::{TirModule, TirProgram, TirType};
+use crate::tir::dispatch::CallBindings;
+use crate::tir::parallel::ParallelPlans;
+use crate::tir::{LocalId, TirModule, TirProgram, TirType};
 
 pub(crate) struct FunctionGenContext<'ctx, 'a> {
     /// The codegen context
@@ -14,6 +21,30 @@ pub(crate) struct FunctionGenContext<'ctx, 'a> {
 
     /// Parameters as values (not pointers)
     pub(crate) params: Vec<BasicValueEnum<'ctx>>,
+
+    /// `self` where it is not the first parameter (a parallel loop body)
+    pub(crate) self_value: Option<BasicValueEnum<'ctx>>,
+
+    /// Frame storage of locals whose objects do not escape
+    pub(crate) stack_objects: HashMap<LocalId, PointerValue<'ctx>>,
+
+    /// Subscripts of the body proven in range
+    pub(crate) safe_subscripts: SafeSubscripts,
+
+    /// How the parallel loops of the body share its locals
+    pub(crate) parallel_plans: ParallelPlans,
+
+    /// How the body's calls of virtual methods dispatch
+    pub(crate) call_bindings: CallBindings,
+
+    /// String builders of the accumulators of the loops being generated
+    pub(crate) str_builders: HashMap<LocalId, PointerValue<'ctx>>,
+
+    /// Number of enclosing try statements
+    pub(crate) try_depth: usize,
+
+    /// Profile site of the function; None when profiling is off
+    pub(crate) profile: Option<ProfileScope<'ctx>>,
 }
 
 impl<'ctx> CodegenContext<'ctx> {
@@ -44,6 +75,16 @@ impl<'ctx> CodegenContext<'ctx> {
             let ptr = self.builder.build_alloca(llvm_ty, name).unwrap();
             locals.push((ptr, llvm_ty));
         }
+        let stack_objects = self.alloc_stack_objects(&func.body, program);
+        let safe_subscripts = SafeSubscripts::analyze(&func.body, program);
+        let parallel_plans = ParallelPlans::analyze(&func.body, &func.locals);
+        let call_bindings = CallBindings::analyze(
+            &func.body,
+            func.class,
+            &func.locals,
+            &self.dispatch,
+            program,
+        );
 
         // Collect parameters
         let mut params: Vec<BasicValueEnum<'ctx>> = Vec::new();
@@ -52,12 +93,22 @@ impl<'ctx> CodegenContext<'ctx> {
             let param_value = fn_value.get_nth_param((i + param_offset) as u32).unwrap();
             params.push(param_value);
         }
+        let profile = self.profile_function_entry(&func.qualified_name);
+        let profile_entry = profile.as_ref().and_then(|scope| scope.entry());
 
         // Generate body
         let mut fn_ctx = FunctionGenContext {
             ctx: self,
             locals,
             params,
+            self_value: None,
+            stack_objects,
+            safe_subscripts,
+            parallel_plans,
+            call_bindings,
+            str_builders: HashMap::new(),
+            try_depth: 0,
+            profile,
         };
 
         for stmt in &func.body {
@@ -67,7 +118,7 @@ impl<'ctx> CodegenContext<'ctx> {
         // Only void functions need implicit return terminators.
         // Non-void functions must have explicit returns on all paths (validated during TIR lowering).
         if func.return_type == TirType::Void {
-            self.add_missing_terminators();
+            self.add_missing_terminators(profile_entry);
         }
 
         self.current_function = None;
@@ -94,11 +145,31 @@ impl<'ctx> CodegenContext<'ctx> {
             let ptr = self.builder.build_alloca(llvm_ty, name).unwrap();
             locals.push((ptr, llvm_ty));
         }
+        let stack_objects = self.alloc_stack_objects(&module.init_body, program);
+        let safe_subscripts = SafeSubscripts::analyze(&module.init_body, program);
+        let parallel_plans = ParallelPlans::analyze(&module.init_body, &module.init_locals);
+        let call_bindings = CallBindings::analyze(
+            &module.init_body,
+            None,
+            &module.init_locals,
+            &self.dispatch,
+            program,
+        );
+        let profile = self.profile_function_entry(&format!("{}.<module>", module.name));
+        let profile_entry = profile.as_ref().and_then(|scope| scope.entry());
 
         let mut fn_ctx = FunctionGenContext {
             ctx: self,
             locals,
             params: Vec::new(),
+            self_value: None,
+            stack_objects,
+            safe_subscripts,
+            parallel_plans,
+            call_bindings,
+            str_builders: HashMap::new(),
+            try_depth: 0,
+            profile,
         };
 
         for stmt in &module.init_body {
@@ -109,6 +180,9 @@ impl<'ctx> CodegenContext<'ctx> {
         // (e.g., if the last statement was a raise/unreachable)
         if let Some(current_block) = self.builder.get_insert_block() {
             if current_block.get_terminator().is_none() {
+                if let Some(entry) = profile_entry {
+                    self.profile_leave(entry);
+                }
                 self.builder.build_return(None).unwrap();
             }
         }
@@ -123,6 +197,11 @@ impl<'ctx> CodegenContext<'ctx> {
         let entry = self.context.append_basic_block(function, "entry");
         self.builder.position_at_end(entry);
 
+        if self.gc.mode == GcMode::MarkSweep {
+            self.generate_gc_init();
+        }
+        self.generate_profile_init();
+
         // Call all module init functions in order (they are already sorted by dependency)
         // This ensures globals are initialized before any function tries to use them
         for module in &program.modules {
@@ -137,10 +216,47 @@ impl<'ctx> CodegenContext<'ctx> {
         self.builder.build_return(Some(&zero)).unwrap();
     }
 
+    /// Enable the collector and register every pointer-typed global as a root
+    fn generate_gc_init(&mut self) {
+        let i64_type = self.context.i64_type();
+        let gc_init = self
+            .module
+            .get_function("__pyc_gc_init")
+            .expect("GC init function not declared");
+        let threshold = i64_type.const_int(self.gc.threshold.unwrap_or(0), false);
+        let growth = i64_type.const_int(u64::from(self.gc.growth_percent.unwrap_or(0)), false);
+        self.builder
+            .build_call(gc_init, &[threshold.into(), growth.into()], "")
+            .unwrap();
+
+        let add_root = self
+            .module
+            .get_function("__pyc_gc_add_root")
+            .expect("GC add_root function not declared");
+        let mut roots: Vec<_> = self
+            .global_variables
+            .iter()
+            .filter(|(_, ptr)| {
+                self.module
+                    .get_global(&ptr.get_name().to_string_lossy())
+                    .is_some_and(|g| g.get_value_type().is_pointer_type())
+            })
+            .collect();
+        // HashMap order is unstable; keep the emitted IR deterministic
+        roots.sort_by(|a, b| a.0.cmp(b.0));
+        let roots: Vec<PointerValue<'ctx>> = roots.into_iter().map(|(_, ptr)| *ptr).collect();
+        for slot in roots {
+            self.builder
+                .build_call(add_root, &[slot.into()], "")
+                .unwrap();
+        }
+    }
+
     /// Add implicit return terminators to basic blocks that don't have one.
     /// This is only valid for void functions - non-void functions must have
     /// explicit returns on all paths (validated during TIR lowering).
-    pub(crate) fn add_missing_terminators(&mut self) {
+    /// Each return first leaves the function's profile site, if it has one.
+    pub(crate) fn add_missing_terminators(&mut self, profile_entry: Option<IntValue<'ctx>>) {
         if let Some(func) = self.current_function {
             // Collect blocks that need terminators
             let mut blocks_needing_terminator = Vec::new();
@@ -155,6 +271,9 @@ impl<'ctx> CodegenContext<'ctx> {
             // Add implicit void returns
             for bb in blocks_needing_terminator {
                 self.builder.position_at_end(bb);
+                if let Some(entry) = profile_entry {
+                    self.profile_leave(entry);
+                }
                 self.builder.build_return(None).unwrap();
             }
         }
@@ -1,8 +1,15 @@
 // TIR-based code generation - submodules
 
 pub(crate) mod declarations;
+pub(crate) mod dispatch;
+pub(crate) mod elem_storage;
 pub(crate) mod expressions;
 pub(crate) mod function_gen;
 pub(crate) mod operators;
+pub(crate) mod parallel;
+pub(crate) mod stack_objects;
 pub(crate) mod statements;
+pub(crate) mod str_builders;
+pub(crate) mod subscripts;
+pub(crate) mod temporaries;
 pub(crate) mod value_utils;
@@ -233,6 +233,8 @@ impl<'ctx, 'a> FunctionGenContext<'ctx, 'a> {
             LtE => SLE,
             Gt => SGT,
             GtE => SGE,
+            // Lowered to __contains__ calls
+            In | NotIn => unreachable!("membership test reached integer comparison"),
         };
         // Get i1 result then extend to i8 for consistency with bool representation
         let cmp = self
@@ -261,6 +263,8 @@ impl<'ctx, 'a> FunctionGenContext<'ctx, 'a> {
             LtE => OLE,   // Ordered and less than or equal
             Gt => OGT,    // Ordered and greater than
             GtE => OGE,   // Ordered and greater than or equal
+            // Lowered to __contains__ calls
+            In | NotIn => unreachable!("membership test reached float comparison"),
         };
         // Get i1 result then extend to i8 for consistency with bool representation
         let cmp = self
@@ -0,0 +1,329 @@
+//! Parallel loops
+//!
+//! A `prange` loop (a ForRange with `parallel` set, see tir/parallel.rs) is
+//! outlined into an internal function `void body(void* env, i64 lo, i64 hi)`
+//! that runs iterations [lo, hi), and the loop itself becomes one call to the
+//! runtime's `__pyc_parallel_for`, which runs chunks of the range on its
+//! worker threads.
+//!
+//! `env` is an array of pointers into the caller's frame: the address of every
+//! local, then a spill slot for each parameter and one for `self`. The body
+//! function reads and writes shared locals through those addresses, while
+//! private locals and reductions get slots of its own. A reduction slot starts
+//! at 0 and is added to the caller's local with one atomic add at the end of the
+//! chunk.
+
+use std::collections::HashMap;
+
+use inkwell::module::Linkage;
+use inkwell::types::BasicTypeEnum;
+use inkwell::values::{BasicValueEnum, IntValue, PointerValue};
+use inkwell::AddressSpace;
+use inkwell::{AtomicOrdering, AtomicRMWBinOp, IntPredicate};
+
+use crate::codegen::profile::ProfileScope;
+use crate::tir::expr::VarRef;
+use crate::tir::stmt::TirStmt;
+use crate::tir::{LocalId, TirProgram};
+
+use super::function_gen::FunctionGenContext;
+
+impl<'ctx, 'a> FunctionGenContext<'ctx, 'a> {
+    /// Emit a parallel ForRange as a call to `__pyc_parallel_for`
+    pub(crate) fn codegen_parallel_for(&mut self, stmt: &TirStmt, program: &TirProgram) {
+        let TirStmt::ForRange { start, stop, .. } = stmt else {
+            unreachable!("only ForRange loops run in parallel")
+        };
+        let ptr_type = self.ctx.context.ptr_type(AddressSpace::default());
+        let i64_type = self.ctx.context.i64_type();
+
+        let start_val = self.codegen_expr(start, program).into_int_value();
+        let stop_val = self.codegen_expr(stop, program).into_int_value();
+
+        // Parameters and self are values; give them addresses the body can read
+        let self_value = self.load_var(&VarRef::SelfRef, program);
+        let values: Vec<BasicValueEnum<'ctx>> =
+            self.params.iter().copied().chain([self_value]).collect();
+        let mut captures: Vec<PointerValue<'ctx>> =
+            self.locals.iter().map(|&(ptr, _)| ptr).collect();
+        for value in &values {
+            let slot = self.entry_alloca(value.get_type(), "prange.spill");
+            self.ctx.builder.build_store(slot, *value).unwrap();
+            captures.push(slot);
+        }
+
+        let env = self.entry_alloca(
+            ptr_type.array_type(captures.len() as u32).into(),
+            "prange.env",
+        );
+        for (i, capture) in captures.iter().enumerate() {
+            let slot = unsafe {
+                self.ctx
+                    .builder
+                    .build_in_bounds_gep(
+                        ptr_type,
+                        env,
+                        &[i64_type.const_int(i as u64, false)],
+                        "prange.capture",
+                    )
+                    .unwrap()
+            };
+            self.ctx.builder.build_store(slot, *capture).unwrap();
+        }
+
+        let value_types: Vec<BasicTypeEnum<'ctx>> = values.iter().map(|v| v.get_type()).collect();
+        let body_fn = self.outline_parallel_body(stmt, &value_types, program);
+        let parallel_for = self.ctx.module.get_function("__pyc_parallel_for").unwrap();
+        self.ctx
+            .builder
+            .build_call(
+                parallel_for,
+                &[
+                    start_val.into(),
+                    stop_val.into(),
+                    body_fn.into(),
+                    env.into(),
+                ],
+                "",
+            )
+            .unwrap();
+    }
+
+    /// Generate the body function of a parallel loop and return its address.
+    /// `value_types` are the types of the spilled parameters and self.
+    fn outline_parallel_body(
+        &mut self,
+        stmt: &TirStmt,
+        value_types: &[BasicTypeEnum<'ctx>],
+        program: &TirProgram,
+    ) -> PointerValue<'ctx> {
+        let TirStmt::ForRange {
+            target,
+            counter,
+            body,
+            ..
+        } = stmt
+        else {
+            unreachable!("only ForRange loops run in parallel")
+        };
+        let plan = self.parallel_plans.get(stmt).cloned().unwrap_or_default();
+        let context = self.ctx.context;
+        let ptr_type = context.ptr_type(AddressSpace::default());
+        let i64_type = context.i64_type();
+
+        let caller = self.ctx.current_function.unwrap();
+        let fn_type = context
+            .void_type()
+            .fn_type(&[ptr_type.into(), i64_type.into(), i64_type.into()], false);
+        let name = format!("{}.prange", caller.get_name().to_string_lossy());
+        let function = self
+            .ctx
+            .module
+            .add_function(&name, fn_type, Some(Linkage::Internal));
+
+        let resume_block = self.ctx.builder.get_insert_block().unwrap();
+        self.ctx.current_function = Some(function);
+        let entry = context.append_basic_block(function, "entry");
+        self.ctx.builder.position_at_end(entry);
+
+        let env = function.get_nth_param(0).unwrap().into_pointer_value();
+        let lo = function.get_nth_param(1).unwrap().into_int_value();
+        let hi = function.get_nth_param(2).unwrap().into_int_value();
+        let load_capture = |this: &mut Self, index: usize| -> PointerValue<'ctx> {
+            let slot = unsafe {
+                this.ctx
+                    .builder
+                    .build_in_bounds_gep(
+                        ptr_type,
+                        env,
+                        &[i64_type.const_int(index as u64, false)],
+                        "prange.slot",
+                    )
+                    .unwrap()
+            };
+            this.ctx
+                .builder
+                .build_load(ptr_type, slot, "prange.capture")
+                .unwrap()
+                .into_pointer_value()
+        };
+
+        // Private locals and reductions live in this frame, the rest in the caller's.
+        // Private slots start zeroed, like the caller's frame before the loop.
+        let mut locals: Vec<(PointerValue<'ctx>, BasicTypeEnum<'ctx>)> = Vec::new();
+        let mut shared_reductions = Vec::new();
+        for i in 0..self.locals.len() {
+            let local = LocalId(i as u32);
+            let llvm_ty = self.locals[i].1;
+            let own_slot = plan.private.contains(&local) || plan.reductions.contains(&local);
+            if plan.reductions.contains(&local) {
+                shared_reductions.push((local, load_capture(self, i)));
+            }
+            let ptr = if own_slot {
+                let slot = self
+                    .ctx
+                    .builder
+                    .build_alloca(llvm_ty, "prange.local")
+                    .unwrap();
+                self.ctx
+                    .builder
+                    .build_store(slot, llvm_ty.const_zero())
+                    .unwrap();
+                slot
+            } else {
+                load_capture(self, i)
+            };
+            locals.push((ptr, llvm_ty));
+        }
+        let mut values = Vec::new();
+        for (i, &ty) in value_types.iter().enumerate() {
+            let slot = load_capture(self, self.locals.len() + i);
+            values.push(
+                self.ctx
+                    .builder
+                    .build_load(ty, slot, "prange.value")
+                    .unwrap(),
+            );
+        }
+        let self_value = values.pop();
+        let stack_objects = self.ctx.alloc_stack_objects(body, program);
+
+        let mut body_ctx = FunctionGenContext {
+            ctx: &mut *self.ctx,
+            locals,
+            params: values,
+            self_value,
+            stack_objects,
+            safe_subscripts: std::mem::take(&mut self.safe_subscripts),
+            parallel_plans: std::mem::take(&mut self.parallel_plans),
+            call_bindings: std::mem::take(&mut self.call_bindings),
+            str_builders: HashMap::new(),
+            try_depth: self.try_depth,
+            profile: self.profile.as_ref().map(ProfileScope::outlined),
+        };
+        body_ctx.codegen_chunk_loop(*target, *counter, lo, hi, body, program);
+
+        // Fold this chunk's partial sums into the caller's locals
+        for (local, shared) in shared_reductions {
+            let (partial_ptr, _) = body_ctx.locals[local.index()];
+            let partial = body_ctx
+                .ctx
+                .builder
+                .build_load(i64_type, partial_ptr, "prange.partial")
+                .unwrap()
+                .into_int_value();
+            body_ctx
+                .ctx
+                .builder
+                .build_atomicrmw(
+                    AtomicRMWBinOp::Add,
+                    shared,
+                    partial,
+                    AtomicOrdering::Monotonic,
+                )
+                .unwrap();
+        }
+        body_ctx.ctx.builder.build_return(None).unwrap();
+
+        self.safe_subscripts = std::mem::take(&mut body_ctx.safe_subscripts);
+        self.parallel_plans = std::mem::take(&mut body_ctx.parallel_plans);
+        self.call_bindings = std::mem::take(&mut body_ctx.call_bindings);
+        self.ctx.current_function = Some(caller);
+        self.ctx.builder.position_at_end(resume_block);
+        function.as_global_value().as_pointer_value()
+    }
+
+    /// The sequential loop over [lo, hi) inside a parallel body function
+    fn codegen_chunk_loop(
+        &mut self,
+        target: LocalId,
+        counter: LocalId,
+        lo: IntValue<'ctx>,
+        hi: IntValue<'ctx>,
+        body: &[TirStmt],
+        program: &TirProgram,
+    ) {
+        let i64_type = self.ctx.context.i64_type();
+        let func = self.ctx.current_function.unwrap();
+        let (counter_ptr, _) = self.locals[counter.index()];
+        let (target_ptr, _) = self.locals[target.index()];
+        self.ctx.builder.build_store(counter_ptr, lo).unwrap();
+
+        let cond_bb = self.ctx.context.append_basic_block(func, "prange.cond");
+        let body_bb = self.ctx.context.append_basic_block(func, "prange.body");
+        let step_bb = self.ctx.context.append_basic_block(func, "prange.step");
+        let end_bb = self.ctx.context.append_basic_block(func, "prange.end");
+        self.ctx
+            .builder
+            .build_unconditional_branch(cond_bb)
+            .unwrap();
+
+        self.ctx.builder.position_at_end(cond_bb);
+        let iv = self
+            .ctx
+            .builder
+            .build_load(i64_type, counter_ptr, "prange.iv")
+            .unwrap()
+            .into_int_value();
+        let in_range = self
+            .ctx
+            .builder
+            .build_int_compare(IntPredicate::SLT, iv, hi, "prange.inrange")
+            .unwrap();
+        self.ctx
+            .builder
+            .build_conditional_branch(in_range, body_bb, end_bb)
+            .unwrap();
+
+        self.ctx.builder.position_at_end(body_bb);
+        self.ctx.builder.build_store(target_ptr, iv).unwrap();
+        // Stop the chunk at the first raise, or once another chunk has raised,
+        // so the runtime records the first exception and skips the rest
+        self.codegen_loop_body(body, end_bb, "__pyc_parallel_poll", program);
+        if let Some(current_block) = self.ctx.builder.get_insert_block() {
+            if current_block.get_terminator().is_none() {
+                self.ctx
+                    .builder
+                    .build_unconditional_branch(step_bb)
+                    .unwrap();
+            }
+        }
+
+        self.ctx.builder.position_at_end(step_bb);
+        let iv = self
+            .ctx
+            .builder
+            .build_load(i64_type, counter_ptr, "prange.iv")
+            .unwrap()
+            .into_int_value();
+        let next = self
+            .ctx
+            .builder
+            .build_int_nsw_add(iv, i64_type.const_int(1, false), "prange.next")
+            .unwrap();
+        self.ctx.builder.build_store(counter_ptr, next).unwrap();
+        self.ctx
+            .builder
+            .build_unconditional_branch(cond_bb)
+            .unwrap();
+
+        self.ctx.builder.position_at_end(end_bb);
+    }
+
+    /// An alloca in the entry block of the current function, so a loop that
+    /// reaches it repeatedly does not grow the frame
+    fn entry_alloca(&mut self, ty: BasicTypeEnum<'ctx>, name: &str) -> PointerValue<'ctx> {
+        let entry = self
+            .ctx
+            .current_function
+            .unwrap()
+            .get_first_basic_block()
+            .unwrap();
+        let builder = self.ctx.context.create_builder();
+        match entry.get_first_instruction() {
+            Some(first) => builder.position_before(&first),
+            None => builder.position_at_end(entry),
+        }
+        builder.build_alloca(ty, name).unwrap()
+    }
+}
@@ -0,0 +1,134 @@
+//! Stack allocation of non-escaping objects
+//!
+//! Objects that escape analysis proves never outlive their creating function are
+//! given an alloca in the entry block instead of a heap allocation. Instances are
+//! zeroed and initialized in place; ranges and for-loop range cursors are filled
+//! by the runtime's `range_init`/`range_iter_init`. Once the runtime is linked in,
+//! SROA breaks these allocas up into SSA values wherever all uses are inlined.
+
+use std::collections::HashMap;
+
+use inkwell::types::BasicTypeEnum;
+use inkwell::values::{BasicValueEnum, PointerValue};
+
+use crate::codegen::context::CodegenContext;
+use crate::tir::escape::StackObject;
+use crate::tir::expr::{TirExpr, TirExprKind, VarRef};
+use crate::tir::stmt::TirStmt;
+use crate::tir::{LocalId, TirFunction, TirProgram};
+
+use super::function_gen::FunctionGenContext;
+
+/// Number of i64 fields in the runtime's Range struct (start, stop, step, current)
+const RANGE_FIELDS: u32 = 4;
+
+impl<'ctx> CodegenContext<'ctx> {
+    /// Allocate frame storage for every stack object of a body.
+    /// Must be called while positioned in the entry block.
+    pub(crate) fn alloc_stack_objects(
+        &mut self,
+        body: &[TirStmt],
+        program: &TirProgram,
+    ) -> HashMap<LocalId, PointerValue<'ctx>> {
+        let Some(escape) = &self.escape else {
+            return HashMap::new();
+        };
+
+        let mut objects: Vec<_> = escape.stack_locals(body, program).into_iter().collect();
+        // HashMap order is unstable; keep the emitted IR deterministic
+        objects.sort_by_key(|(local, _)| local.index());
+
+        objects
+            .into_iter()
+            .map(|(local, kind)| {
+                let storage_ty: BasicTypeEnum<'ctx> = match kind {
+                    StackObject::Instance(class) => {
+                        self.class_types[&program.class(class).qualified_name].into()
+                    }
+                    StackObject::Range => self.context.i64_type().array_type(RANGE_FIELDS).into(),
+                };
+                let storage = self.builder.build_alloca(storage_ty, "stack_obj").unwrap();
+                (local, storage)
+            })
+            .collect()
+    }
+}
+
+impl<'ctx, 'a> FunctionGenContext<'ctx, 'a> {
+    /// Build the object created by `init` in its frame storage
+    pub(crate) fn codegen_stack_object(
+        &mut self,
+        init: &TirExpr,
+        storage: PointerValue<'ctx>,
+        program: &TirProgram,
+    ) -> BasicValueEnum<'ctx> {
+        let i64_type = self.ctx.context.i64_type();
+        match &init.kind {
+            TirExprKind::Construct { class, args } => {
+                // class_new hands out zeroed memory; keep that guarantee
+                let class_type = self.ctx.class_types[&program.class(*class).qualified_name];
+                let size = class_type.size_of().unwrap();
+                self.ctx
+                    .builder
+                    .build_memset(storage, 8, self.ctx.context.i8_type().const_zero(), size)
+                    .unwrap();
+                self.codegen_init_call(*class, storage.into(), args, program);
+            }
+            TirExprKind::Range { start, stop, step } => {
+                let start_val = match start {
+                    Some(start) => self.codegen_expr(start, program),
+                    None => i64_type.const_int(0, false).into(),
+                };
+                let stop_val = self.codegen_expr(stop, program);
+                let step_val = match step {
+                    Some(step) => self.codegen_expr(step, program),
+                    None => i64_type.const_int(1, false).into(),
+                };
+                let range_init = self
+                    .ctx
+                    .module
+                    .get_function("__pyc___builtin___range_init")
+                    .expect("range_init function not declared");
+                self.ctx
+                    .builder
+                    .build_call(
+                        range_init,
+                        &[
+                            storage.into(),
+                            start_val.into(),
+                            stop_val.into(),
+                            step_val.into(),
+                        ],
+                        "",
+                    )
+                    .unwrap();
+            }
+            TirExprKind::Call { args, .. } => {
+                // range.__iter__(r): copy r into a cursor held in the frame
+                let source = self.codegen_expr(&args[0], program);
+                let iter_init = self
+                    .ctx
+                    .module
+                    .get_function("__pyc___builtin___range_iter_init")
+                    .expect("range_iter_init function not declared");
+                self.ctx
+                    .builder
+                    .build_call(iter_init, &[storage.into(), source.into()], "")
+                    .unwrap();
+            }
+            _ => {
+                unreachable!("escape analysis only selects constructors, ranges and range cursors")
+            }
+        }
+        storage.into()
+    }
+
+    /// Whether the call frees a stack range, which has no heap memory to release
+    pub(crate) fn is_stack_object_dealloc(&self, func: &TirFunction, args: &[TirExpr]) -> bool {
+        func.runtime_name.as_deref() == Some("__pyc___builtin___range___dealloc__")
+            && matches!(
+                args.first().map(|arg| &arg.kind),
+                Some(TirExprKind::Var(VarRef::Local(local))) if self.stack_objects.contains_key(local)
+            )
+    }
+}
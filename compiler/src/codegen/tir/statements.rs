@@ -1,16 +1,36 @@
+use inkwell::basic_block::BasicBlock;
 use inkwell::AddressSpace;
+use inkwell::IntPredicate;
 
 use crate::tir::stmt::TirStmt;
 use crate::tir::TirProgram;
 
 use super::declarations::call_result_to_basic_value;
+use super::elem_storage::ElemStorage;
 use super::function_gen::FunctionGenContext;
 
 impl<'ctx, 'a> FunctionGenContext<'ctx, 'a> {
     pub(crate) fn codegen_stmt(&mut self, stmt: &TirStmt, program: &TirProgram) {
+        if self.codegen_str_append(stmt, program) {
+            return;
+        }
+        let builders = self.begin_str_builders(stmt);
+        let profile_depth = self.profile_loop_entry(stmt);
+        let in_try = usize::from(matches!(stmt, TirStmt::Try { .. }));
+        self.try_depth += in_try;
+        self.codegen_stmt_kind(stmt, program);
+        self.try_depth -= in_try;
+        self.profile_loop_exit(profile_depth);
+        self.end_str_builders(builders);
+    }
+
+    fn codegen_stmt_kind(&mut self, stmt: &TirStmt, program: &TirProgram) {
         match stmt {
             TirStmt::Let { local, ty: _, init } => {
-                let value = self.codegen_expr(init, program);
+                let value = match self.stack_objects.get(local) {
+                    Some(&storage) => self.codegen_stack_object(init, storage, program),
+                    None => self.codegen_expr(init, program),
+                };
                 let (ptr, _) = self.locals[local.index()];
                 self.ctx.builder.build_store(ptr, value).unwrap();
             }
@@ -33,15 +53,19 @@ impl<'ctx, 'a> FunctionGenContext<'ctx, 'a> {
             }
 
             TirStmt::Expr(expr) => {
-                self.codegen_expr(expr, program);
+                let value = self.codegen_expr(expr, program);
+                // A discarded fresh string is never seen again
+                self.free_if_string_temp(expr, value, program);
             }
 
             TirStmt::Return(Some(expr)) => {
                 let value = self.codegen_expr(expr, program);
+                self.profile_return();
                 self.ctx.builder.build_return(Some(&value)).unwrap();
             }
 
             TirStmt::Return(None) => {
+                self.profile_return();
                 self.ctx.builder.build_return(None).unwrap();
             }
 
@@ -155,6 +179,269 @@ impl<'ctx, 'a> FunctionGenContext<'ctx, 'a> {
                 self.ctx.builder.position_at_end(end_bb);
             }
 
+            TirStmt::ForRange { parallel: true, .. } => self.codegen_parallel_for(stmt, program),
+
+            TirStmt::ForRange {
+                target,
+                counter,
+                start,
+                stop,
+                step,
+                body,
+                ..
+            } => {
+                // Plain induction-variable loop: no Range object, no StopIteration polling,
+                // only a poll after body statements that may raise. The step is a compile-time constant, so the exit test is a single
+                // signed comparison against the (once-evaluated) stop value.
+                let i64_type = self.ctx.context.i64_type();
+                let func = self.ctx.current_function.unwrap();
+
+                let start_val = self.codegen_expr(start, program).into_int_value();
+                let stop_val = self.codegen_expr(stop, program).into_int_value();
+                let (counter_ptr, _) = self.locals[counter.index()];
+                let (target_ptr, _) = self.locals[target.index()];
+                self.ctx
+                    .builder
+                    .build_store(counter_ptr, start_val)
+                    .unwrap();
+
+                let cond_bb = self.ctx.context.append_basic_block(func, "for.cond");
+                let body_bb = self.ctx.context.append_basic_block(func, "for.body");
+                let step_bb = self.ctx.context.append_basic_block(func, "for.step");
+                let end_bb = self.ctx.context.append_basic_block(func, "for.end");
+
+                self.ctx
+                    .builder
+                    .build_unconditional_branch(cond_bb)
+                    .unwrap();
+
+                // Condition block: iv < stop (positive step) or iv > stop (negative step)
+                self.ctx.builder.position_at_end(cond_bb);
+                let iv = self
+                    .ctx
+                    .builder
+                    .build_load(i64_type, counter_ptr, "for.iv")
+                    .unwrap()
+                    .into_int_value();
+                let predicate = if *step > 0 {
+                    IntPredicate::SLT
+                } else {
+                    IntPredicate::SGT
+                };
+                let in_range = self
+                    .ctx
+                    .builder
+                    .build_int_compare(predicate, iv, stop_val, "for.inrange")
+                    .unwrap();
+                self.ctx
+                    .builder
+                    .build_conditional_branch(in_range, body_bb, end_bb)
+                    .unwrap();
+
+                // Body block: bind the target from the induction variable
+                self.ctx.builder.position_at_end(body_bb);
+                self.ctx.builder.build_store(target_ptr, iv).unwrap();
+                self.codegen_loop_body(body, end_bb, "__pyc_has_exception", program);
+                if let Some(current_block) = self.ctx.builder.get_insert_block() {
+                    if current_block.get_terminator().is_none() {
+                        self.ctx
+                            .builder
+                            .build_unconditional_branch(step_bb)
+                            .unwrap();
+                    }
+                }
+
+                // Step block: iv += step. With a step of 1 (or -1) the test
+                // iv < stop (iv > stop) already rules out overflow. A larger
+                // step could wrap past stop back into range, so the loop ends
+                // first when the distance left to stop is no more than the step.
+                self.ctx.builder.position_at_end(step_bb);
+                let iv = self
+                    .ctx
+                    .builder
+                    .build_load(i64_type, counter_ptr, "for.iv")
+                    .unwrap()
+                    .into_int_value();
+                let step_val = i64_type.const_int(*step as u64, true);
+                let next = if step.unsigned_abs() == 1 {
+                    self.ctx
+                        .builder
+                        .build_int_nsw_add(iv, step_val, "for.next")
+                        .unwrap()
+                } else {
+                    // Exact as an unsigned value, since iv is on the near side of stop
+                    let (from, to) = if *step > 0 {
+                        (iv, stop_val)
+                    } else {
+                        (stop_val, iv)
+                    };
+                    let remaining = self
+                        .ctx
+                        .builder
+                        .build_int_sub(to, from, "for.remaining")
+                        .unwrap();
+                    let step_size = i64_type.const_int(step.unsigned_abs(), false);
+                    let has_next = self
+                        .ctx
+                        .builder
+                        .build_int_compare(IntPredicate::UGT, remaining, step_size, "for.hasnext")
+                        .unwrap();
+                    let advance_bb = self.ctx.context.append_basic_block(func, "for.advance");
+                    self.ctx
+                        .builder
+                        .build_conditional_branch(has_next, advance_bb, end_bb)
+                        .unwrap();
+                    self.ctx.builder.position_at_end(advance_bb);
+                    self.ctx
+                        .builder
+                        .build_int_add(iv, step_val, "for.next")
+                        .unwrap()
+                };
+                self.ctx.builder.build_store(counter_ptr, next).unwrap();
+                self.ctx
+                    .builder
+                    .build_unconditional_branch(cond_bb)
+                    .unwrap();
+
+                self.ctx.builder.position_at_end(end_bb);
+            }
+
+            TirStmt::ForList {
+                target,
+                index,
+                iterable,
+                body,
+            } => {
+                // Indexed walk over List { T* data; i64 len; ... } instead of
+                // allocating a ListIterator and polling for StopIteration. Elements
+                // are stored unboxed, so each one loads straight into the target.
+                let i64_type = self.ctx.context.i64_type();
+                let elem_type = self
+                    .ctx
+                    .elem_type(ElemStorage::of_container(&iterable.ty, program));
+                let ptr_type = self.ctx.context.ptr_type(AddressSpace::default());
+                let list_type = self
+                    .ctx
+                    .context
+                    .struct_type(&[ptr_type.into(), i64_type.into(), i64_type.into()], false);
+                let func = self.ctx.current_function.unwrap();
+
+                let list_val = self.codegen_expr(iterable, program);
+                let list_ptr = self.value_to_pointer(list_val);
+                let (index_ptr, _) = self.locals[index.index()];
+                let (target_ptr, _) = self.locals[target.index()];
+
+                // __len__ panics on a NULL list, matching list.__iter__'s checks
+                let len_fn = self
+                    .ctx
+                    .module
+                    .get_function("__pyc___builtin___list___len__")
+                    .unwrap();
+                self.ctx
+                    .builder
+                    .build_call(len_fn, &[list_ptr.into()], "")
+                    .unwrap();
+                self.ctx
+                    .builder
+                    .build_store(index_ptr, i64_type.const_zero())
+                    .unwrap();
+
+                let cond_bb = self.ctx.context.append_basic_block(func, "forlist.cond");
+                let body_bb = self.ctx.context.append_basic_block(func, "forlist.body");
+                let step_bb = self.ctx.context.append_basic_block(func, "forlist.step");
+                let end_bb = self.ctx.context.append_basic_block(func, "forlist.end");
+
+                self.ctx
+                    .builder
+                    .build_unconditional_branch(cond_bb)
+                    .unwrap();
+
+                // Condition block: idx < list->len (re-read so appends in the body are seen)
+                self.ctx.builder.position_at_end(cond_bb);
+                let idx = self
+                    .ctx
+                    .builder
+                    .build_load(i64_type, index_ptr, "forlist.idx")
+                    .unwrap()
+                    .into_int_value();
+                let len_ptr = self
+                    .ctx
+                    .builder
+                    .build_struct_gep(list_type, list_ptr, 1, "forlist.len_ptr")
+                    .unwrap();
+                let len = self
+                    .ctx
+                    .builder
+                    .build_load(i64_type, len_ptr, "forlist.len")
+                    .unwrap()
+                    .into_int_value();
+                let in_bounds = self
+                    .ctx
+                    .builder
+                    .build_int_compare(IntPredicate::SLT, idx, len, "forlist.inbounds")
+                    .unwrap();
+                self.ctx
+                    .builder
+                    .build_conditional_branch(in_bounds, body_bb, end_bb)
+                    .unwrap();
+
+                // Body block: target = list->data[idx]
+                self.ctx.builder.position_at_end(body_bb);
+                let data_ptr_ptr = self
+                    .ctx
+                    .builder
+                    .build_struct_gep(list_type, list_ptr, 0, "forlist.data_ptr")
+                    .unwrap();
+                let data_ptr = self
+                    .ctx
+                    .builder
+                    .build_load(ptr_type, data_ptr_ptr, "forlist.data")
+                    .unwrap()
+                    .into_pointer_value();
+                let elem_ptr = unsafe {
+                    self.ctx
+                        .builder
+                        .build_in_bounds_gep(elem_type, data_ptr, &[idx], "forlist.elem_ptr")
+                        .unwrap()
+                };
+                let elem = self
+                    .ctx
+                    .builder
+                    .build_load(elem_type, elem_ptr, "forlist.elem")
+                    .unwrap();
+                self.ctx.builder.build_store(target_ptr, elem).unwrap();
+                self.codegen_loop_body(body, end_bb, "__pyc_has_exception", program);
+                if let Some(current_block) = self.ctx.builder.get_insert_block() {
+                    if current_block.get_terminator().is_none() {
+                        self.ctx
+                            .builder
+                            .build_unconditional_branch(step_bb)
+                            .unwrap();
+                    }
+                }
+
+                // Step block: idx += 1
+                self.ctx.builder.position_at_end(step_bb);
+                let idx = self
+                    .ctx
+                    .builder
+                    .build_load(i64_type, index_ptr, "forlist.idx")
+                    .unwrap()
+                    .into_int_value();
+                let next = self
+                    .ctx
+                    .builder
+                    .build_int_nsw_add(idx, i64_type.const_int(1, false), "forlist.next")
+                    .unwrap();
+                self.ctx.builder.build_store(index_ptr, next).unwrap();
+                self.ctx
+                    .builder
+                    .build_unconditional_branch(cond_bb)
+                    .unwrap();
+
+                self.ctx.builder.position_at_end(end_bb);
+            }
+
             TirStmt::Try {
                 body,
                 handlers,
@@ -165,6 +452,23 @@ impl<'ctx, 'a> FunctionGenContext<'ctx, 'a> {
                 // After each statement in try body, check __pyc_has_exception() and branch to handlers if set.
                 // This avoids setjmp/longjmp which don't work in freestanding mode.
 
+                // If neither the body nor the else clause can raise, handlers are unreachable:
+                // run body, else and finally straight-line with no frame and no polling.
+                if !self.may_raise_body(body, program) && !self.may_raise_body(orelse, program) {
+                    for s in body.iter().chain(orelse).chain(finalbody) {
+                        self.codegen_stmt(s, program);
+                        if self
+                            .ctx
+                            .builder
+                            .get_insert_block()
+                            .is_some_and(|bb| bb.get_terminator().is_some())
+                        {
+                            break;
+                        }
+                    }
+                    return;
+                }
+
                 let func = self.ctx.current_function.unwrap();
                 let i32_type = self.ctx.context.i32_type();
 
@@ -217,6 +521,11 @@ impl<'ctx, 'a> FunctionGenContext<'ctx, 'a> {
                         break; // Block already terminated, no more statements to generate
                     }
 
+                    // Statements proven exception-free need no poll
+                    if !self.may_raise_stmt(s, program) {
+                        continue;
+                    }
+
                     // Poll for exception
                     let has_exc_call = self
                         .ctx
@@ -312,23 +621,14 @@ impl<'ctx, 'a> FunctionGenContext<'ctx, 'a> {
                                 unhandled_bb
                             };
 
-                            // Get the exception class name
-                            let class_def = program.class(exc_class);
-                            let class_name = class_def
-                                .qualified_name
-                                .rsplit('.')
-                                .next()
-                                .unwrap_or(&class_def.qualified_name);
+                            // The ids of the handler's class and its subclasses
+                            let (first, last) =
+                                self.ctx.exception_ids.range(exc_class).unwrap_or((0, -1));
+                            let i64_type = self.ctx.context.i64_type();
+                            let first = i64_type.const_int(first as u64, true);
+                            let last = i64_type.const_int(last as u64, true);
 
-                            // Create a global C string constant for the type name
-                            let type_name_ptr = self
-                                .ctx
-                                .builder
-                                .build_global_string_ptr(class_name, "exc_type_name")
-                                .unwrap()
-                                .as_pointer_value();
-
-                            // Call __pyc_exception_matches(exception, type_name)
+                            // Call __pyc_exception_matches(exception, first, last)
                             let matches_fn = self
                                 .ctx
                                 .module
@@ -339,7 +639,7 @@ impl<'ctx, 'a> FunctionGenContext<'ctx, 'a> {
                                 .builder
                                 .build_call(
                                     matches_fn,
-                                    &[exc_val.into(), type_name_ptr.into()],
+                                    &[exc_val.into(), first.into(), last.into()],
                                     "matches",
                                 )
                                 .unwrap();
@@ -412,6 +712,10 @@ impl<'ctx, 'a> FunctionGenContext<'ctx, 'a> {
                                 break;
                             }
 
+                            if !self.may_raise_stmt(s, program) {
+                                continue;
+                            }
+
                             // Poll for new exception raised in handler
                             let has_exc_call = self
                                 .ctx
@@ -560,4 +864,71 @@ impl<'ctx, 'a> FunctionGenContext<'ctx, 'a> {
             }
         }
     }
+
+    /// Generate the body of a counted loop. A raise only sets the pending
+    /// exception, so after each statement that may raise the loop is left for
+    /// `exit_bb`, where the enclosing try (or the caller) polls for it.
+    /// `poll` is the runtime function that says whether to leave:
+    /// `__pyc_has_exception`, or `__pyc_parallel_poll` in a parallel chunk.
+    pub(crate) fn codegen_loop_body(
+        &mut self,
+        body: &[TirStmt],
+        exit_bb: BasicBlock<'ctx>,
+        poll: &str,
+        program: &TirProgram,
+    ) {
+        let func = self.ctx.current_function.unwrap();
+        let i32_type = self.ctx.context.i32_type();
+        let has_exc_fn = self.ctx.module.get_function(poll).unwrap();
+        for s in body {
+            self.codegen_stmt(s, program);
+            let open = self
+                .ctx
+                .builder
+                .get_insert_block()
+                .is_some_and(|bb| bb.get_terminator().is_none());
+            if !open {
+                break;
+            }
+            if !self.may_raise_stmt(s, program) {
+                continue;
+            }
+            let has_exc_call = self
+                .ctx
+                .builder
+                .build_call(has_exc_fn, &[], "has_exc")
+                .unwrap();
+            let has_exc = call_result_to_basic_value(has_exc_call, i32_type.const_zero().into())
+                .into_int_value();
+            let has_exc_bool = self
+                .ctx
+                .builder
+                .build_int_compare(
+                    IntPredicate::NE,
+                    has_exc,
+                    i32_type.const_zero(),
+                    "loop.poll",
+                )
+                .unwrap();
+            let cont_bb = self.ctx.context.append_basic_block(func, "loop.cont");
+            self.ctx
+                .builder
+                .build_conditional_branch(has_exc_bool, exit_bb, cont_bb)
+                .unwrap();
+            self.ctx.builder.position_at_end(cont_bb);
+        }
+    }
+
+    /// Whether a statement may leave an exception pending (always true in polling mode)
+    fn may_raise_stmt(&self, stmt: &TirStmt, program: &TirProgram) -> bool {
+        self.ctx
+            .may_raise
+            .as_ref()
+            .is_none_or(|analysis| analysis.stmt(stmt, program))
+    }
+
+    /// Whether any statement in a block may leave an exception pending
+    fn may_raise_body(&self, stmts: &[TirStmt], program: &TirProgram) -> bool {
+        stmts.iter().any(|s| self.may_raise_stmt(s, program))
+    }
 }
@@ -0,0 +1,112 @@
+//! String builders for accumulator loops
+//!
+//! A loop whose accumulators (see `tir::accumulators`) would copy their whole
+//! string on every `s = s + t` gets one runtime StrBuilder per accumulator,
+//! created from the local's value before the loop. Appends inside the loop add
+//! their pieces to the builder, and the finished string is stored back into the
+//! local where the loop exits.
+//!
+//! Loops inside a `try` keep plain concatenation: a handler in the same function
+//! may run after an exception leaves the loop, and would see the stale local.
+
+use inkwell::values::BasicValueEnum;
+use inkwell::AddressSpace;
+
+use crate::tir::accumulators::{append_pieces, loop_accumulators};
+use crate::tir::stmt::TirStmt;
+use crate::tir::{LocalId, TirProgram};
+
+use super::declarations::call_result_to_basic_value;
+use super::function_gen::FunctionGenContext;
+
+impl<'ctx, 'a> FunctionGenContext<'ctx, 'a> {
+    /// Start a builder for each accumulator of `stmt` that has none yet.
+    /// Returns the locals to hand to `end_str_builders` after the loop.
+    pub(crate) fn begin_str_builders(&mut self, stmt: &TirStmt) -> Vec<LocalId> {
+        if self.try_depth > 0 {
+            return Vec::new();
+        }
+        let locals: Vec<LocalId> = loop_accumulators(stmt)
+            .into_iter()
+            .filter(|local| !self.str_builders.contains_key(local))
+            .collect();
+
+        let new_fn = self
+            .ctx
+            .module
+            .get_function("__pyc_str_builder_new")
+            .unwrap();
+        for &local in &locals {
+            let (ptr, ty) = self.locals[local.index()];
+            let base = self.ctx.builder.build_load(ty, ptr, "acc.base").unwrap();
+            let call = self
+                .ctx
+                .builder
+                .build_call(new_fn, &[base.into()], "acc.builder")
+                .unwrap();
+            let builder = call_result_to_basic_value(call, self.null_ptr());
+            self.str_builders
+                .insert(local, builder.into_pointer_value());
+        }
+        locals
+    }
+
+    /// Store the finished string of each builder started by `begin_str_builders`
+    pub(crate) fn end_str_builders(&mut self, locals: Vec<LocalId>) {
+        let finish_fn = self
+            .ctx
+            .module
+            .get_function("__pyc_str_builder_finish")
+            .unwrap();
+        for local in locals {
+            let builder = self.str_builders.remove(&local).unwrap();
+            let call = self
+                .ctx
+                .builder
+                .build_call(finish_fn, &[builder.into()], "acc.value")
+                .unwrap();
+            let value = call_result_to_basic_value(call, self.null_ptr());
+            let (ptr, _) = self.locals[local.index()];
+            self.ctx.builder.build_store(ptr, value).unwrap();
+        }
+    }
+
+    /// Emit `stmt` as appends if it extends a local that has a builder.
+    /// Returns false, emitting nothing, for any other statement.
+    pub(crate) fn codegen_str_append(&mut self, stmt: &TirStmt, program: &TirProgram) -> bool {
+        if self.str_builders.is_empty() || !matches!(stmt, TirStmt::Assign { .. }) {
+            return false;
+        }
+        let Some((builder, pieces)) = self
+            .str_builders
+            .iter()
+            .find_map(|(&local, &builder)| Some((builder, append_pieces(stmt, local)?)))
+        else {
+            return false;
+        };
+
+        let append_fn = self
+            .ctx
+            .module
+            .get_function("__pyc_str_builder_append")
+            .unwrap();
+        for piece in pieces {
+            let value = self.codegen_expr(piece, program);
+            self.ctx
+                .builder
+                .build_call(append_fn, &[builder.into(), value.into()], "")
+                .unwrap();
+            // The builder copies the piece
+            self.free_if_string_temp(piece, value, program);
+        }
+        true
+    }
+
+    fn null_ptr(&self) -> BasicValueEnum<'ctx> {
+        self.ctx
+            .context
+            .ptr_type(AddressSpace::default())
+            .const_null()
+            .into()
+    }
+}
@@ -0,0 +1,228 @@
+//! Inline subscripts
+//!
+//! `xs[i]` and `xs[i] = v` on lists, bytearrays and bytes are runtime calls that
+//! check the container for NULL and the index against its length. When the TIR
+//! bounds analysis proves a subscript in range (see tir/bounds.rs), or the
+//! program is built with `--unchecked`, codegen reads or writes the element in
+//! place instead. `--unchecked` covers the list and bytearray subscripts, whose
+//! checks only ever panic; an out-of-range `bytes` read is defined to return -1,
+//! so it keeps its kernel unless it is proven in range.
+
+use inkwell::types::BasicTypeEnum;
+use inkwell::values::{BasicMetadataValueEnum, BasicValueEnum, IntValue, PointerValue};
+use inkwell::AddressSpace;
+use inkwell::IntPredicate;
+
+use crate::tir::{TirExpr, TirExprKind, TirFunction, TirProgram};
+
+use super::elem_storage::ElemStorage;
+use super::function_gen::FunctionGenContext;
+
+/// Subscript kernels codegen can replace with an inline access
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+enum Subscript {
+    ListGet,
+    ListSet,
+    ByteArrayGet,
+    ByteArraySet,
+    BytesGet,
+}
+
+impl Subscript {
+    /// The subscript a TIR runtime name stands for (list kernels before
+    /// storage specialization)
+    fn of(runtime_name: &str) -> Option<Self> {
+        Some(match runtime_name {
+            "__pyc___builtin___list___getitem__" => Subscript::ListGet,
+            "__pyc___builtin___list___setitem__" => Subscript::ListSet,
+            "__pyc___builtin___bytearray___getitem__" => Subscript::ByteArrayGet,
+            "__pyc___builtin___bytearray___setitem__" => Subscript::ByteArraySet,
+            "__pyc___builtin___bytes___getitem__" => Subscript::BytesGet,
+            _ => return None,
+        })
+    }
+}
+
+impl<'ctx, 'a> FunctionGenContext<'ctx, 'a> {
+    /// Emit the subscript call `expr` as an inline access if it needs no check.
+    /// `args` are the converted call arguments; returns None when the caller
+    /// should call the kernel.
+    pub(crate) fn codegen_inline_subscript(
+        &mut self,
+        expr: &TirExpr,
+        func_def: &TirFunction,
+        args: &[BasicValueEnum<'ctx>],
+        program: &TirProgram,
+    ) -> Option<BasicValueEnum<'ctx>> {
+        let subscript = Subscript::of(func_def.runtime_name.as_deref()?)?;
+        let unchecked = self.ctx.unchecked && subscript != Subscript::BytesGet;
+        if !unchecked && !self.safe_subscripts.contains(expr) {
+            return None;
+        }
+
+        let TirExprKind::Call { args: tir_args, .. } = &expr.kind else {
+            return None;
+        };
+        let i64_type = self.ctx.context.i64_type();
+        let i8_type = self.ctx.context.i8_type();
+        let ptr_type = self.ctx.context.ptr_type(AddressSpace::default());
+        let container = args[0].into_pointer_value();
+        let index = args[1].into_int_value();
+
+        // List and ByteArray both start { T* data; i64 len; i64 cap; ... }
+        let growable_type = self
+            .ctx
+            .context
+            .struct_type(&[ptr_type.into(), i64_type.into(), i64_type.into()], false);
+        let elem_ptr = |this: &mut Self, elem_type: BasicTypeEnum<'ctx>| {
+            let data_ptr_ptr = this
+                .ctx
+                .builder
+                .build_struct_gep(growable_type, container, 0, "subscript.data_ptr")
+                .unwrap();
+            let data_ptr = this
+                .ctx
+                .builder
+                .build_load(ptr_type, data_ptr_ptr, "subscript.data")
+                .unwrap()
+                .into_pointer_value();
+            unsafe {
+                this.ctx
+                    .builder
+                    .build_in_bounds_gep(elem_type, data_ptr, &[index], "subscript.elem_ptr")
+                    .unwrap()
+            }
+        };
+
+        let unit: BasicValueEnum = i64_type.const_zero().into();
+        match subscript {
+            Subscript::ListGet => {
+                let elem_type = self
+                    .ctx
+                    .elem_type(ElemStorage::of_container(&tir_args[0].ty, program));
+                let ptr = elem_ptr(self, elem_type);
+                Some(
+                    self.ctx
+                        .builder
+                        .build_load(elem_type, ptr, "subscript.elem")
+                        .unwrap(),
+                )
+            }
+            Subscript::ListSet => {
+                let elem_type = self
+                    .ctx
+                    .elem_type(ElemStorage::of_container(&tir_args[0].ty, program));
+                let ptr = elem_ptr(self, elem_type);
+                self.ctx.builder.build_store(ptr, args[2]).unwrap();
+                Some(unit)
+            }
+            Subscript::ByteArrayGet => {
+                let ptr = elem_ptr(self, i8_type.into());
+                let byte = self
+                    .ctx
+                    .builder
+                    .build_load(i8_type, ptr, "subscript.byte")
+                    .unwrap()
+                    .into_int_value();
+                Some(
+                    self.ctx
+                        .builder
+                        .build_int_z_extend(byte, i64_type, "subscript.value")
+                        .unwrap()
+                        .into(),
+                )
+            }
+            Subscript::ByteArraySet => {
+                let value = args[2].into_int_value();
+                let in_byte_range = value.get_zero_extended_constant().is_some_and(|v| v <= 255);
+                if !in_byte_range && !self.ctx.unchecked {
+                    // The value still needs its 0-255 check; out of range, the
+                    // kernel reports the error
+                    let func = self.ctx.current_function.unwrap();
+                    let store_bb = self.ctx.context.append_basic_block(func, "subscript.store");
+                    let panic_bb = self
+                        .ctx
+                        .context
+                        .append_basic_block(func, "subscript.badbyte");
+                    let end_bb = self.ctx.context.append_basic_block(func, "subscript.end");
+                    let is_byte = self
+                        .ctx
+                        .builder
+                        .build_int_compare(
+                            IntPredicate::ULE,
+                            value,
+                            i64_type.const_int(255, false),
+                            "subscript.isbyte",
+                        )
+                        .unwrap();
+                    self.ctx
+                        .builder
+                        .build_conditional_branch(is_byte, store_bb, panic_bb)
+                        .unwrap();
+
+                    self.ctx.builder.position_at_end(panic_bb);
+                    let kernel = self
+                        .ctx
+                        .module
+                        .get_function("__pyc___builtin___bytearray___setitem__")
+                        .unwrap();
+                    let call_args: Vec<BasicMetadataValueEnum> =
+                        args.iter().map(|&arg| arg.into()).collect();
+                    self.ctx.builder.build_call(kernel, &call_args, "").unwrap();
+                    self.ctx.builder.build_unconditional_branch(end_bb).unwrap();
+
+                    self.ctx.builder.position_at_end(store_bb);
+                    let ptr = elem_ptr(self, i8_type.into());
+                    self.store_byte(ptr, value);
+                    self.ctx.builder.build_unconditional_branch(end_bb).unwrap();
+
+                    self.ctx.builder.position_at_end(end_bb);
+                } else {
+                    let ptr = elem_ptr(self, i8_type.into());
+                    self.store_byte(ptr, value);
+                }
+                Some(unit)
+            }
+            Subscript::BytesGet => {
+                // Bytes is { i64 len; u8 data[] }
+                let bytes_type = self
+                    .ctx
+                    .context
+                    .struct_type(&[i64_type.into(), i8_type.array_type(0).into()], false);
+                let data_ptr = self
+                    .ctx
+                    .builder
+                    .build_struct_gep(bytes_type, container, 1, "subscript.data")
+                    .unwrap();
+                let ptr = unsafe {
+                    self.ctx
+                        .builder
+                        .build_in_bounds_gep(i8_type, data_ptr, &[index], "subscript.elem_ptr")
+                        .unwrap()
+                };
+                let byte = self
+                    .ctx
+                    .builder
+                    .build_load(i8_type, ptr, "subscript.byte")
+                    .unwrap()
+                    .into_int_value();
+                Some(
+                    self.ctx
+                        .builder
+                        .build_int_z_extend(byte, i64_type, "subscript.value")
+                        .unwrap()
+                        .into(),
+                )
+            }
+        }
+    }
+
+    fn store_byte(&mut self, ptr: PointerValue<'ctx>, value: IntValue<'ctx>) {
+        let byte = self
+            .ctx
+            .builder
+            .build_int_truncate(value, self.ctx.context.i8_type(), "subscript.byte")
+            .unwrap();
+        self.ctx.builder.build_store(ptr, byte).unwrap();
+    }
+}
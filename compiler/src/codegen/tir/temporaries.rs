@@ -0,0 +1,88 @@
+//! Freeing of compiler-proven string temporaries
+//!
+//! A string is a temporary when it is produced by an expression that always
+//! allocates a new String (concatenation, or a runtime `__str__`/`__repr__` that
+//! formats into a new buffer) and is consumed directly by an operation that does
+//! not keep a reference to it. Such values are released with `str.free` as soon
+//! as their consumer returns, instead of leaking for the rest of the program.
+
+use inkwell::values::BasicValueEnum;
+
+use crate::ast::BinOperator;
+use crate::tir::expr::{TirExpr, TirExprKind};
+use crate::tir::{TirProgram, TirType};
+
+use super::function_gen::FunctionGenContext;
+
+/// Runtime functions that always return a newly allocated String
+/// (`bool.__str__` is not one: it returns static "True" and "False" strings)
+const FRESH_STRING_RUNTIME_FUNCS: &[&str] = &[
+    "__pyc___builtin___str___add__",
+    "__pyc___builtin___int___str__",
+    "__pyc___builtin___float___str__",
+    "__pyc___builtin___str___repr__",
+    "__pyc___builtin___list___str__",
+    "__pyc___builtin___list___repr__",
+    "__pyc___builtin___dict___str__",
+    "__pyc___builtin___dict___repr__",
+    "__pyc___builtin___set___str__",
+    "__pyc___builtin___set___repr__",
+    "__pyc___builtin___range___str__",
+    "__pyc___builtin___range___repr__",
+    "__pyc___builtin___bytes___str__",
+    "__pyc___builtin___bytes___repr__",
+    "__pyc___builtin___bytearray___str__",
+    "__pyc___builtin___bytearray___repr__",
+];
+
+/// Runtime functions that read their String arguments without retaining them
+const BORROWING_RUNTIME_FUNCS: &[&str] = &[
+    "write_string_impl",
+    "__pyc___builtin___str___print__",
+    "__pyc___builtin___str___len__",
+];
+
+/// Whether the expression yields a String that nothing else references
+pub(crate) fn is_fresh_string(expr: &TirExpr, program: &TirProgram) -> bool {
+    match &expr.kind {
+        // String concatenation (see codegen_expr's BinOp case)
+        TirExprKind::BinOp {
+            op: BinOperator::Add,
+            ..
+        } => matches!(expr.ty, TirType::Class(_)),
+        TirExprKind::Call { func, .. } => program
+            .function(*func)
+            .runtime_name
+            .as_deref()
+            .is_some_and(|name| FRESH_STRING_RUNTIME_FUNCS.contains(&name)),
+        _ => false,
+    }
+}
+
+/// Whether a call to the runtime function leaves its String arguments unreferenced
+pub(crate) fn borrows_string_args(runtime_name: &str) -> bool {
+    BORROWING_RUNTIME_FUNCS.contains(&runtime_name)
+}
+
+impl<'ctx, 'a> FunctionGenContext<'ctx, 'a> {
+    /// Release `value` if `expr` is a fresh string temporary whose consumer is done
+    pub(crate) fn free_if_string_temp(
+        &mut self,
+        expr: &TirExpr,
+        value: BasicValueEnum<'ctx>,
+        program: &TirProgram,
+    ) {
+        if !is_fresh_string(expr, program) || !value.is_pointer_value() {
+            return;
+        }
+        let free_fn = self
+            .ctx
+            .module
+            .get_function("__pyc___builtin___str_free")
+            .expect("String free function not declared");
+        self.ctx
+            .builder
+            .build_call(free_fn, &[value.into()], "")
+            .unwrap();
+    }
+}
@@ -36,6 +36,9 @@ impl<'ctx, 'a> FunctionGenContext<'ctx, 'a> {
                 self.ctx.context.i64_type().const_int(0, false).into()
             }
             VarRef::SelfRef => {
+                if let Some(value) = self.self_value {
+                    return value;
+                }
                 // Self is the first parameter for methods
                 if let Some(func) = self.ctx.current_function {
                     if let Some(param) = func.get_first_param() {
@@ -89,10 +92,11 @@ impl<'ctx, 'a> FunctionGenContext<'ctx, 'a> {
                 let obj_val = self.codegen_expr(object, program);
                 let class_def = program.class(*class);
                 let class_type = self.ctx.class_types[&class_def.qualified_name];
+                let slot = self.ctx.field_slot(*class, *field);
                 let obj_ptr = self.value_to_pointer(obj_val);
                 self.ctx
                     .builder
-                    .build_struct_gep(class_type, obj_ptr, field.index() as u32, "field_ptr")
+                    .build_struct_gep(class_type, obj_ptr, slot, "field_ptr")
                     .unwrap()
             }
         }
@@ -1,17 +1,28 @@
 use inkwell::context::Context;
+use inkwell::targets::TargetMachine;
 use std::collections::{HashMap, HashSet};
 use std::env;
 use std::fs;
+use std::os::unix::ffi::OsStrExt;
 use std::path::{Path, PathBuf};
 use std::process::Command;
 use std::str::FromStr;
+use std::thread;
+use std::time::{Duration, Instant, UNIX_EPOCH};
 
 use pyo3::Python;
 
+use crate::ast::cache::{Fnv1a, ModuleCache};
 use crate::ast::{AstConverter, Module, ModuleName};
 use crate::codegen::generator::Codegen;
+use crate::codegen::optimize::{self, IcuUse, Pgo};
+use crate::codegen::profile::ProfileHints;
 use crate::error::{CompilerError, Result};
+use crate::exe_cache::{ExecutableCache, DEFAULT_LIMIT_BYTES};
 use crate::python_ast::parse_python;
+use crate::tir::dispatch::ClassHierarchy;
+use crate::tir::fold::fold_program;
+use crate::tir::layout::FieldLayout;
 use crate::tir::lower_to_tir;
 
 /// Target-specific configuration
@@ -19,7 +30,15 @@ struct TargetConfig {
     triple: &'static str,
     clang_target: Option<&'static str>,
     runtime_filename: &'static str,
+    /// Empty ICU data package, linked when no data is needed
+    icu_stubdata_filename: &'static str,
+    /// ICU data package holding only the NFKC tables
+    icu_nfkc_filename: &'static str,
     qemu_command: Option<&'static str>,
+    /// `std::env::consts::ARCH` of a host that can run this target natively
+    host_arch: &'static str,
+    /// clang flag that selects the CPU (`-march` on x86, `-mcpu` on RISC-V)
+    cpu_flag: &'static str,
     musl_lib_path: &'static str,
     icu_lib_path: &'static str,
     libcxx_lib_path: &'static str,
@@ -29,7 +48,11 @@ const X86_64_CONFIG: TargetConfig = TargetConfig {
     triple: "x86_64-unknown-linux-musl",
     clang_target: None,
     runtime_filename: "runtime-x86_64.o",
+    icu_stubdata_filename: "icu-stubdata-x86_64.o",
+    icu_nfkc_filename: "icu-nfkc-x86_64.o",
     qemu_command: None,
+    host_arch: "x86_64",
+    cpu_flag: "-march",
     musl_lib_path: runtime::MUSL_X86_64_LIB,
     icu_lib_path: runtime::ICU_X86_64_LIB,
     libcxx_lib_path: runtime::LIBCXX_X86_64_LIB,
@@ -39,7 +62,11 @@ const RISCV64_CONFIG: TargetConfig = TargetConfig {
     triple: "riscv64-unknown-linux-musl",
     clang_target: Some("--target=riscv64-linux-musl"),
     runtime_filename: "runtime-riscv64.o",
+    icu_stubdata_filename: "icu-stubdata-riscv64.o",
+    icu_nfkc_filename: "icu-nfkc-riscv64.o",
     qemu_command: Some("qemu-riscv64"),
+    host_arch: "riscv64",
+    cpu_flag: "-mcpu",
     musl_lib_path: runtime::MUSL_RISCV64_LIB,
     icu_lib_path: runtime::ICU_RISCV64_LIB,
     libcxx_lib_path: runtime::LIBCXX_RISCV64_LIB,
@@ -73,10 +100,27 @@ impl Target {
         self.config().runtime_filename
     }
 
+    /// File name of the ICU data package, built with the runtime, that covers `icu`
+    pub fn icu_data_filename(&self, icu: IcuUse) -> &'static str {
+        match icu {
+            IcuUse::None | IcuUse::Core => self.config().icu_stubdata_filename,
+            IcuUse::Data => self.config().icu_nfkc_filename,
+        }
+    }
+
     pub fn qemu_command(&self) -> Option<&'static str> {
         self.config().qemu_command
     }
 
+    pub fn cpu_flag(&self) -> &'static str {
+        self.config().cpu_flag
+    }
+
+    /// Whether this target is the architecture the compiler runs on
+    pub fn is_host(&self) -> bool {
+        self.config().host_arch == env::consts::ARCH
+    }
+
     /// Get the musl library directory (set at compile time by runtime crate)
     pub fn musl_lib_dir(&self) -> PathBuf {
         PathBuf::from(self.config().musl_lib_path)
@@ -134,50 +178,265 @@ impl FromStr for Target {
     }
 }
 
+/// How try bodies detect a pending exception
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Default)]
+pub enum ExceptionModel {
+    /// Poll `__pyc_has_exception()` after every statement in a try body
+    Polling,
+    /// Poll only after statements the may-raise analysis cannot prove exception-free,
+    /// and skip the exception frame entirely for try blocks that cannot raise
+    #[default]
+    MayRaise,
+}
+
+impl FromStr for ExceptionModel {
+    type Err = CompilerError;
+
+    fn from_str(s: &str) -> std::result::Result<Self, Self::Err> {
+        match s.to_lowercase().as_str() {
+            "polling" | "poll" => Ok(ExceptionModel::Polling),
+            "may-raise" | "may_raise" | "analyzed" => Ok(ExceptionModel::MayRaise),
+            _ => Err(CompilerError::CodegenError(format!(
+                "Unknown exception model '{s}'. Supported: polling, may-raise"
+            ))),
+        }
+    }
+}
+
+/// Memory reclamation strategy for runtime objects
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Default)]
+pub enum GcMode {
+    /// Objects are only freed where the compiler proves them dead
+    #[default]
+    None,
+    /// Conservative mark-sweep collection of the whole object heap
+    MarkSweep,
+}
+
+impl FromStr for GcMode {
+    type Err = CompilerError;
+
+    fn from_str(s: &str) -> std::result::Result<Self, Self::Err> {
+        match s.to_lowercase().as_str() {
+            "none" | "off" => Ok(GcMode::None),
+            "mark-sweep" | "mark_sweep" | "marksweep" => Ok(GcMode::MarkSweep),
+            _ => Err(CompilerError::CodegenError(format!(
+                "Unknown GC mode '{s}'. Supported: none, mark-sweep"
+            ))),
+        }
+    }
+}
+
+/// Collector tuning baked into the executable
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Default)]
+pub struct GcConfig {
+    pub mode: GcMode,
+    /// Bytes allocated between collections (runtime default when None)
+    pub threshold: Option<u64>,
+    /// Minimum threshold after a collection, as a percentage of the live heap
+    pub growth_percent: Option<u32>,
+}
+
+/// Optimization level for the LLVM pipeline and the final link
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Default)]
+pub enum OptLevel {
+    O0,
+    O1,
+    #[default]
+    O2,
+    O3,
+}
+
+impl OptLevel {
+    /// New pass manager pipeline run over the runtime-linked module
+    pub fn pipeline(&self) -> &'static str {
+        match self {
+            OptLevel::O0 => "default<O0>",
+            OptLevel::O1 => "default<O1>",
+            OptLevel::O2 => "default<O2>",
+            OptLevel::O3 => "default<O3>",
+        }
+    }
+
+    /// Code generation level for the target machine
+    pub fn codegen_level(&self) -> inkwell::OptimizationLevel {
+        match self {
+            OptLevel::O0 => inkwell::OptimizationLevel::None,
+            OptLevel::O1 => inkwell::OptimizationLevel::Less,
+            OptLevel::O2 => inkwell::OptimizationLevel::Default,
+            OptLevel::O3 => inkwell::OptimizationLevel::Aggressive,
+        }
+    }
+
+    /// Flag passed to clang for the LTO link
+    pub fn clang_flag(&self) -> &'static str {
+        match self {
+            OptLevel::O0 => "-O0",
+            OptLevel::O1 => "-O1",
+            OptLevel::O2 => "-O2",
+            OptLevel::O3 => "-O3",
+        }
+    }
+}
+
+impl FromStr for OptLevel {
+    type Err = CompilerError;
+
+    fn from_str(s: &str) -> std::result::Result<Self, Self::Err> {
+        let level = s
+            .strip_prefix('O')
+            .or_else(|| s.strip_prefix('o'))
+            .unwrap_or(s);
+        match level {
+            "0" => Ok(OptLevel::O0),
+            "1" => Ok(OptLevel::O1),
+            "2" => Ok(OptLevel::O2),
+            "3" => Ok(OptLevel::O3),
+            _ => Err(CompilerError::CodegenError(format!(
+                "Unknown optimization level '{s}'. Supported: 0, 1, 2, 3"
+            ))),
+        }
+    }
+}
+
+/// Wall-clock time spent in each compilation phase (`--time-passes`)
+#[derive(Default)]
+struct PhaseTimes {
+    phases: Vec<(&'static str, Duration)>,
+}
+
+impl PhaseTimes {
+    fn time<T>(&mut self, phase: &'static str, f: impl FnOnce() -> T) -> T {
+        let start = Instant::now();
+        let result = f();
+        self.phases.push((phase, start.elapsed()));
+        result
+    }
+
+    fn report(&self) -> String {
+        let total: Duration = self.phases.iter().map(|(_, d)| *d).sum();
+        let mut report = String::from("=== Time Report ===\n");
+        for (phase, duration) in &self.phases {
+            let percent = if total.is_zero() {
+                0.0
+            } else {
+                100.0 * duration.as_secs_f64() / total.as_secs_f64()
+            };
+            report.push_str(&format!(
+                "{:>10.3}ms {percent:>5.1}%  {phase}\n",
+                duration.as_secs_f64() * 1000.0
+            ));
+        }
+        report.push_str(&format!(
+            "{:>10.3}ms 100.0%  total\n",
+            total.as_secs_f64() * 1000.0
+        ));
+        report
+    }
+}
+
 /// Build all modules starting from an entry file (handles cyclic imports)
+///
+/// Modules are loaded one import level at a time. The modules of a level are
+/// read and looked up in the cache in parallel; only the misses go through the
+/// Python parser, which holds the GIL and so runs one module at a time.
 pub fn build_modules(
     entry_path: &Path,
     entry_dir: &Path,
+    cache: Option<&ModuleCache>,
 ) -> Result<(HashMap<ModuleName, Module>, ModuleName)> {
     let mut modules = HashMap::new();
-    let mut visited = HashSet::new();
+    let mut visited = HashSet::from([entry_path.to_path_buf()]);
     let converter = AstConverter::new(entry_dir);
+    let entry_name = ModuleName::new(converter.path_to_module_id(entry_path));
+
+    let mut level = vec![entry_path.to_path_buf()];
+    while !level.is_empty() {
+        let loaded = load_sources(&level, &converter, cache);
+
+        let mut next_level = Vec::new();
+        for (path, module_name, source, cached) in loaded {
+            let module = match cached {
+                Some(module) => module,
+                None => match parse_module(&path, module_name, &source, &converter) {
+                    Ok(module) => {
+                        if let Some(cache) = cache {
+                            cache.store(&module, &source);
+                        }
+                        module
+                    }
+                    // Only errors in the entry module are reported; an imported
+                    // module that fails to parse is left out
+                    Err(e) if path == entry_path => return Err(e),
+                    Err(_) => continue,
+                },
+            };
+
+            for import in &module.imports {
+                if visited.insert(import.module_path.clone()) {
+                    next_level.push(import.module_path.clone());
+                }
+            }
+            modules.insert(module.id.clone(), module);
+        }
+        level = next_level;
+    }
 
-    let entry_name = parse_module_recursive(entry_path, &converter, &mut modules, &mut visited)?;
     Ok((modules, entry_name))
 }
 
-fn parse_module_recursive(
-    path: &Path,
+/// A module's path, name and source, with its AST when the cache has it
+type LoadedSource = (PathBuf, ModuleName, String, Option<Module>);
+
+/// Read the modules at `paths` and look each up in the cache, spreading the
+/// paths over the available cores
+fn load_sources(
+    paths: &[PathBuf],
     converter: &AstConverter,
-    modules: &mut HashMap<ModuleName, Module>,
-    visited: &mut HashSet<PathBuf>,
-) -> Result<ModuleName> {
-    let module_name = ModuleName::new(converter.path_to_module_id(path));
-    if visited.contains(path) {
-        return Ok(module_name);
+    cache: Option<&ModuleCache>,
+) -> Vec<LoadedSource> {
+    let load = |path: &PathBuf| {
+        let module_name = ModuleName::new(converter.path_to_module_id(path));
+        let source = fs::read_to_string(path).unwrap();
+        let cached = cache.and_then(|cache| cache.load(path, &module_name, &source));
+        (path.clone(), module_name, source, cached)
+    };
+
+    let threads = thread::available_parallelism().map_or(1, |n| n.get());
+    if paths.len() < 2 || threads < 2 {
+        return paths.iter().map(load).collect();
     }
-    visited.insert(path.to_path_buf());
-
-    let source = fs::read_to_string(path).unwrap();
-    let py_ast = parse_python(&source)?;
-
-    let parsed = Python::attach(|py| {
-        converter.convert_module(py_ast.bind(py), path.to_path_buf(), module_name.clone())
-    })?;
-
-    let dep_paths: Vec<_> = parsed
-        .imports
-        .iter()
-        .map(|i| i.module_path.clone())
-        .collect();
-    modules.insert(module_name.clone(), parsed);
+    let chunk_size = paths.len().div_ceil(threads);
+    thread::scope(|scope| {
+        let workers: Vec<_> = paths
+            .chunks(chunk_size)
+            .map(|chunk| scope.spawn(move || chunk.iter().map(load).collect::<Vec<_>>()))
+            .collect();
+        workers
+            .into_iter()
+            .flat_map(|worker| worker.join().unwrap())
+            .collect()
+    })
+}
 
-    for dep_path in dep_paths {
-        let _ = parse_module_recursive(&dep_path, converter, modules, visited);
-    }
+fn parse_module(
+    path: &Path,
+    module_name: ModuleName,
+    source: &str,
+    converter: &AstConverter,
+) -> Result<Module> {
+    let py_ast = parse_python(source)?;
+    Python::attach(|py| converter.convert_module(py_ast.bind(py), path.to_path_buf(), module_name))
+}
 
-    Ok(module_name)
+/// Default build cache directory: `$XDG_CACHE_HOME/typepython`, falling back
+/// to `~/.cache/typepython`
+pub fn default_cache_dir() -> Option<PathBuf> {
+    let base = env::var_os("XDG_CACHE_HOME")
+        .filter(|dir| !dir.is_empty())
+        .map(PathBuf::from)
+        .or_else(|| env::var_os("HOME").map(|home| PathBuf::from(home).join(".cache")))?;
+    Some(base.join("typepython"))
 }
 
 /// Compiler configuration options
@@ -186,6 +445,37 @@ pub struct CompilerOptions {
     pub emit_ast: bool,
     pub emit_llvm: bool,
     pub target: Target,
+    pub exception_model: ExceptionModel,
+    /// Print which hot runtime calls survived inlining
+    pub inline_report: bool,
+    pub opt_level: OptLevel,
+    /// CPU to generate code for (`native` for the host); generic when unset
+    pub target_cpu: Option<String>,
+    /// Extra LLVM target features, e.g. `+avx2` or `+v`
+    pub target_features: Option<String>,
+    /// Instrument the executable to write raw profiles into this directory
+    pub profile_generate: Option<PathBuf>,
+    /// Optimize using a merged `.profdata` profile, or the flat profile of a
+    /// `--profile` run
+    pub profile_use: Option<PathBuf>,
+    /// Instrument the executable to write a function, loop, allocation and
+    /// exception profile at exit
+    pub profile: bool,
+    /// Print how long each compilation phase took
+    pub time_passes: bool,
+    /// Garbage collector compiled into the executable
+    pub gc: GcConfig,
+    /// Leave out the index checks of list and bytearray subscripts
+    pub unchecked: bool,
+    /// Order class fields by size and use instead of declaration order
+    pub reorder_fields: bool,
+    /// Build cache: parsed module ASTs in `modules/` and the executables of
+    /// `run` in `bin/`. None parses and links everything on every build.
+    pub cache_dir: Option<PathBuf>,
+    /// Size bound of the executable cache in bytes (DEFAULT_LIMIT_BYTES when None)
+    pub exe_cache_limit: Option<u64>,
+    /// Print executable cache hit/miss counts after `run` looks up the cache
+    pub cache_stats: bool,
 }
 
 /// Main compiler - orchestrates parsing, type checking, codegen, and linking
@@ -200,45 +490,237 @@ impl Compiler {
 
     /// Compile a Python source file to an executable
     pub fn compile(&self, input_path: &Path, output_path: &Path) -> Result<()> {
-        self.with_llvm_module(input_path, |module| {
-            self.link_executable(module, output_path)
+        self.with_llvm_module(input_path, |module, icu| {
+            self.link_executable(module, icu, output_path)
         })
     }
 
-    /// Compile and run a Python file
+    /// Compile and run a Python file. With a cache directory, the executable is
+    /// cached and reused until any of its inputs change.
     pub fn run(&self, input_path: &Path, args: &[String]) -> Result<()> {
-        let temp_exe = env::temp_dir().join("pyc_temp_output");
-        self.compile(input_path, &temp_exe)?;
-        self.execute(&temp_exe, args)
+        let Some(cache) = self.executable_cache() else {
+            let temp_exe = env::temp_dir().join("pyc_temp_output");
+            self.compile(input_path, &temp_exe)?;
+            return self.execute(&temp_exe, args);
+        };
+
+        let canonical = self.validate_input(input_path)?;
+        let (modules, entry_name) = self.parse(&canonical)?;
+        let key = self.executable_key(&modules)?;
+        let exe = match cache.lookup(key) {
+            Some(exe) => exe,
+            None => {
+                let built = cache.build_path(key)?;
+                let published = self
+                    .with_modules(modules, entry_name, PhaseTimes::default(), |module, icu| {
+                        self.link_executable(module, icu, &built)
+                    })
+                    .and_then(|()| cache.insert(key, &built));
+                if published.is_err() {
+                    // Whatever the linker left behind is never published
+                    let _ = fs::remove_file(&built);
+                }
+                published?
+            }
+        };
+        if self.options.cache_stats {
+            eprintln!("executable cache: {}", cache.stats());
+        }
+        self.execute(&exe, args)
+    }
+
+    /// The executable cache of `run`. Options that report on the compilation
+    /// itself need a real build, and profile data is not part of the key, so
+    /// those bypass it.
+    fn executable_cache(&self) -> Option<ExecutableCache> {
+        let options = &self.options;
+        let reports =
+            options.emit_ast || options.emit_llvm || options.inline_report || options.time_passes;
+        let profiles = options.profile_generate.is_some() || options.profile_use.is_some();
+        if reports || profiles {
+            return None;
+        }
+        let dir = options.cache_dir.as_ref()?.join("bin");
+        let limit = options.exe_cache_limit.unwrap_or(DEFAULT_LIMIT_BYTES);
+        Some(ExecutableCache::new(dir, limit))
+    }
+
+    /// Hash of everything the executable of `modules` is built from: their
+    /// sources, the compiler and runtime builds, and the code generation
+    /// options. The system toolchain and libraries are assumed not to change.
+    fn executable_key(&self, modules: &HashMap<ModuleName, Module>) -> Result<u64> {
+        let mut hash = Fnv1a::default();
+        hash.write(env!("CARGO_PKG_VERSION").as_bytes());
+
+        // Rebuilds between version bumps are told apart by size and mtime
+        let builds = [
+            env::current_exe().map_err(CompilerError::IOError)?,
+            self.find_runtime_library()?,
+        ];
+        for path in builds {
+            let metadata = fs::metadata(&path).map_err(CompilerError::IOError)?;
+            let modified = metadata
+                .modified()
+                .ok()
+                .and_then(|time| time.duration_since(UNIX_EPOCH).ok())
+                .unwrap_or_default();
+            hash.write(path.as_os_str().as_bytes());
+            hash.write(&metadata.len().to_le_bytes());
+            hash.write(&modified.as_nanos().to_le_bytes());
+        }
+
+        let (cpu, features) = self.cpu_and_features()?;
+        let options = &self.options;
+        let settings = format!(
+            "{:?} {:?} {:?} {:?} {} {} {} {cpu} {features}",
+            options.target,
+            options.exception_model,
+            options.opt_level,
+            options.gc,
+            options.unchecked,
+            options.reorder_fields,
+            options.profile
+        );
+        hash.write(settings.as_bytes());
+
+        let mut paths: Vec<&Path> = modules.values().map(|m| m.path.as_path()).collect();
+        paths.sort();
+        for path in paths {
+            hash.write(path.as_os_str().as_bytes());
+            hash.write(&fs::read(path).map_err(CompilerError::IOError)?);
+        }
+        Ok(hash.finish())
+    }
+
+    /// Parse the entry file and every module it imports
+    fn parse(&self, canonical: &Path) -> Result<(HashMap<ModuleName, Module>, ModuleName)> {
+        let entry_dir = canonical.parent().unwrap();
+        let cache = self
+            .options
+            .cache_dir
+            .as_ref()
+            .map(|dir| ModuleCache::new(dir.join("modules"), entry_dir));
+        build_modules(canonical, entry_dir, cache.as_ref())
     }
 
     fn with_llvm_module<F>(&self, input_path: &Path, f: F) -> Result<()>
     where
-        F: for<'ctx> FnOnce(&inkwell::module::Module<'ctx>) -> Result<()>,
+        F: for<'ctx> FnOnce(&inkwell::module::Module<'ctx>, IcuUse) -> Result<()>,
     {
         let canonical = self.validate_input(input_path)?;
-        let entry_dir = canonical.parent().unwrap();
+        let mut times = PhaseTimes::default();
+        let (modules, entry_name) = times.time("parse", || self.parse(&canonical))?;
+        self.with_modules(modules, entry_name, times, f)
+    }
+
+    fn with_modules<F>(
+        &self,
+        modules: HashMap<ModuleName, Module>,
+        entry_name: ModuleName,
+        mut times: PhaseTimes,
+        f: F,
+    ) -> Result<()>
+    where
+        F: for<'ctx> FnOnce(&inkwell::module::Module<'ctx>, IcuUse) -> Result<()>,
+    {
+        if self.options.profile_generate.is_some() && self.options.profile_use.is_some() {
+            return Err(CompilerError::CodegenError(
+                "--profile-generate and --profile-use cannot be combined".to_string(),
+            ));
+        }
+        let (cpu, features) = self.cpu_and_features()?;
 
-        let (modules, entry_name) = build_modules(&canonical, entry_dir)?;
         if self.options.emit_ast {
             for module in modules.values() {
                 println!("=== Module {} AST ===\n{:#?}", module.id, module);
             }
         }
 
-        let tir_program = lower_to_tir(modules, entry_name)?;
+        let profile_hints = match &self.options.profile_use {
+            Some(path) => ProfileHints::load(path)?,
+            None => None,
+        };
+        // A flat profile is applied during codegen, an llvm-profdata one by
+        // the optimization pipeline
+        let pgo = match (&self.options.profile_generate, &self.options.profile_use) {
+            (Some(dir), _) => Some(Pgo::Generate(dir)),
+            (None, Some(profile)) if profile_hints.is_none() => Some(Pgo::Use(profile)),
+            _ => None,
+        };
+
+        let mut tir_program = times.time("lower to TIR", || lower_to_tir(modules, entry_name))?;
+        times.time("fold constants", || fold_program(&mut tir_program));
         let context = Context::create();
-        let codegen = Codegen::new(&context, self.options.target);
-        let llvm_module = codegen.codegen_tir(&tir_program);
+        let codegen = Codegen::new(&context, self.options.target)
+            .with_exception_model(self.options.exception_model)
+            .with_gc(self.options.gc)
+            .with_unchecked(self.options.unchecked)
+            .with_reorder_fields(self.options.reorder_fields)
+            .with_profile(self.options.profile)
+            .with_profile_hints(profile_hints);
+        let llvm_module = times.time("codegen", || codegen.codegen_tir(&tir_program));
 
         if self.options.emit_llvm {
             println!(
                 "=== LLVM IR ===\n{}",
                 llvm_module.print_to_string().to_string()
             );
+            let hierarchy = ClassHierarchy::analyze(&tir_program);
+            let layout =
+                FieldLayout::analyze(&tir_program, &hierarchy, self.options.reorder_fields);
+            print!("=== Class Layouts ===\n{}", layout.report(&tir_program));
+        }
+
+        // Link the runtime bitcode in before optimizing so its hot entry points
+        // can be inlined into generated code
+        let generated = optimize::generated_functions(&llvm_module);
+        let runtime_path = self.find_runtime_library()?;
+        times.time("link runtime", || {
+            optimize::link_runtime(&llvm_module, &runtime_path)
+        })?;
+        optimize::set_target_attributes(&llvm_module, &cpu, &features);
+        times.time("optimize", || {
+            optimize::run_pipeline(&llvm_module, self.options.opt_level, &cpu, &features, pgo)
+        })?;
+
+        if self.options.inline_report {
+            let counts = optimize::inline_report(&llvm_module, &generated);
+            eprint!("{}", optimize::format_inline_report(&counts));
         }
 
-        f(&llvm_module)
+        let icu = times.time("trim ICU", || optimize::trim_icu(&llvm_module))?;
+
+        let result = times.time("link executable", || f(&llvm_module, icu));
+
+        if self.options.time_passes {
+            eprint!("{}", times.report());
+        }
+        result
+    }
+
+    /// Resolve `--target-cpu`/`--target-features` into LLVM cpu and feature strings
+    fn cpu_and_features(&self) -> Result<(String, String)> {
+        let extra = self.options.target_features.clone().unwrap_or_default();
+
+        match self.options.target_cpu.as_deref() {
+            None => Ok(("generic".to_string(), extra)),
+            Some("native") => {
+                if !self.options.target.is_host() {
+                    return Err(CompilerError::CodegenError(format!(
+                        "--target-cpu native requires compiling for the host, not {}",
+                        self.options.target.triple()
+                    )));
+                }
+                let cpu = TargetMachine::get_host_cpu_name().to_string();
+                let mut features = TargetMachine::get_host_cpu_features().to_string();
+                if !extra.is_empty() {
+                    features.push(',');
+                    features.push_str(&extra);
+                }
+                Ok((cpu, features))
+            }
+            Some(cpu) => Ok((cpu.to_string(), extra)),
+        }
     }
 
     fn validate_input(&self, input_path: &Path) -> Result<PathBuf> {
@@ -278,12 +760,14 @@ impl Compiler {
         Ok(canonical)
     }
 
+    /// Link the optimized module into a static executable, with as much of
+    /// ICU as `icu` says the program reaches
     fn link_executable<'ctx>(
         &self,
         llvm_module: &inkwell::module::Module<'ctx>,
+        icu: IcuUse,
         output_path: &Path,
     ) -> Result<()> {
-        let runtime_path = self.find_runtime_library()?;
         let musl_lib = self.options.target.musl_lib_dir();
         let icu_lib = self.options.target.icu_lib_dir();
         let bc_path = output_path.with_extension("bc");
@@ -309,16 +793,18 @@ impl Compiler {
         cmd.arg(format!("{}/crt1.o", musl_lib.display()))
             .arg(format!("{}/crti.o", musl_lib.display()));
 
-        // Our compiled code and runtime
-        cmd.arg(&bc_path).arg(&runtime_path);
+        // Our compiled code (the runtime is already linked into it)
+        cmd.arg(&bc_path);
 
         // Library search paths
         cmd.arg(format!("-L{}", musl_lib.display()));
 
-        // Check if ICU is available (not a placeholder path)
+        // Link ICU only when it is available (not a placeholder path) and the
+        // program reaches it
         let icu_available = !icu_lib.to_string_lossy().contains("placeholder");
+        let link_icu = icu_available && icu != IcuUse::None;
 
-        if icu_available {
+        if link_icu {
             cmd.arg(format!("-L{}", icu_lib.display()));
 
             // Add GCC library path for libstdc++ (target-specific)
@@ -331,12 +817,15 @@ impl Compiler {
                 }
             }
 
-            // Static ICU libraries (order matters, use --start-group/--end-group for circular deps)
-            cmd.arg("-Wl,--start-group")
-                .arg("-l:libicui18n.a")
-                .arg("-l:libicuuc.a")
-                .arg("-l:libicudata.a")
-                .arg("-Wl,--end-group");
+            // Static ICU (use --start-group/--end-group for circular deps). The
+            // runtime only calls into libicuuc; its data comes from the smallest
+            // package the runtime build made that covers the program.
+            cmd.arg("-Wl,--start-group").arg("-l:libicuuc.a");
+            match self.icu_data_object(icu)? {
+                Some(object) => cmd.arg(object),
+                None => cmd.arg("-l:libicudata.a"),
+            };
+            cmd.arg("-Wl,--end-group");
 
             // Static libstdc++ for ICU's C++ code
             cmd.arg("-l:libstdc++.a")
@@ -346,7 +835,7 @@ impl Compiler {
 
         // For RISC-V, we always need libgcc for soft-float operations (128-bit float)
         // even without ICU, because musl's printf uses these
-        if matches!(self.options.target, Target::RiscV64) && !icu_available {
+        if matches!(self.options.target, Target::RiscV64) && !link_icu {
             cmd.arg("-L/usr/lib/gcc-cross/riscv64-linux-gnu/13")
                 .arg("-l:libgcc.a");
         }
@@ -361,7 +850,17 @@ impl Compiler {
         cmd.arg("-o").arg(output_path);
 
         // Optimization flags
-        cmd.args(["-flto", "-O2"]);
+        cmd.args(["-flto", self.options.opt_level.clang_flag()]);
+        let (cpu, _) = self.cpu_and_features()?;
+        if cpu != "generic" {
+            cmd.arg(format!("{}={cpu}", self.options.target.cpu_flag()));
+        }
+
+        // The module was instrumented before optimizing; clang only links
+        // the profile runtime
+        if self.options.profile_generate.is_some() {
+            cmd.arg("-fprofile-generate");
+        }
 
         let output = cmd.output().map_err(CompilerError::IOError)?;
         let _ = fs::remove_file(&bc_path);
@@ -375,6 +874,14 @@ impl Compiler {
         Ok(())
     }
 
+    /// The ICU data package the runtime build made for `icu`, or None when
+    /// it could not make one and the whole data library has to be linked
+    fn icu_data_object(&self, icu: IcuUse) -> Result<Option<PathBuf>> {
+        let runtime = self.find_runtime_library()?;
+        let object = runtime.with_file_name(self.options.target.icu_data_filename(icu));
+        Ok(object.exists().then_some(object))
+    }
+
     fn find_runtime_library(&self) -> Result<PathBuf> {
         let workspace = Target::find_workspace_root().ok_or_else(|| {
             CompilerError::IOError(std::io::Error::new(
@@ -446,6 +953,16 @@ mod tests {
         path
     }
 
+    #[test]
+    fn test_opt_level_prefix() {
+        for s in ["2", "O2", "o2"] {
+            assert_eq!(s.parse::<OptLevel>().ok(), Some(OptLevel::O2), "{s}");
+        }
+        for s in ["OO2", "oO3", "O", "O4"] {
+            assert!(s.parse::<OptLevel>().is_err(), "{s}");
+        }
+    }
+
     #[test]
     fn test_valid_py_file_uppercase() {
         let temp_dir = TempDir::new().unwrap();
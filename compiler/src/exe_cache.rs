@@ -0,0 +1,268 @@
+//! Cache of executables built by `pyrun`
+//!
+//! Running a script compiles and links it with LTO before it can start, which
+//! for a short job costs more than the job itself. `Compiler::run` keys each
+//! executable on everything that went into it (see `Compiler::executable_key`)
+//! and keeps it here, so re-running an unchanged script only has to hash its
+//! sources before starting the cached binary.
+//!
+//! The directory holds one executable per key, named by the key, plus a
+//! `stats` file of hit and miss counts. It is bounded in size: after each
+//! insertion the least recently used executables are removed until the rest
+//! fit. A hit refreshes the executable's modification time, which is what
+//! "recently used" goes by.
+//!
+//! Executables are built under a `.tmp` name and renamed into place. A build
+//! that fails removes its file; one whose process was killed leaves it behind,
+//! so eviction also removes `.tmp` files older than STALE_BUILD_AGE.
+
+use std::fs::{self, File};
+use std::path::{Path, PathBuf};
+use std::time::{Duration, SystemTime};
+
+use crate::error::{CompilerError, Result};
+
+/// Default size bound of the cache
+pub const DEFAULT_LIMIT_BYTES: u64 = 256 * 1024 * 1024;
+
+const STATS_FILE: &str = "stats";
+
+/// Age past which a `.tmp` build is taken to be abandoned rather than running
+const STALE_BUILD_AGE: Duration = Duration::from_secs(60 * 60);
+
+/// Usage counters and current contents of the cache
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq)]
+pub struct CacheStats {
+    pub hits: u64,
+    pub misses: u64,
+    pub entries: u64,
+    pub bytes: u64,
+}
+
+impl std::fmt::Display for CacheStats {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        write!(
+            f,
+            "{} hits, {} misses, {} executables, {:.1} MiB",
+            self.hits,
+            self.misses,
+            self.entries,
+            self.bytes as f64 / (1024.0 * 1024.0)
+        )
+    }
+}
+
+/// A size-bounded directory of executables
+pub struct ExecutableCache {
+    dir: PathBuf,
+    limit_bytes: u64,
+}
+
+impl ExecutableCache {
+    pub fn new(dir: impl Into<PathBuf>, limit_bytes: u64) -> Self {
+        ExecutableCache {
+            dir: dir.into(),
+            limit_bytes,
+        }
+    }
+
+    /// The cached executable for `key`, counting a hit or a miss
+    pub fn lookup(&self, key: u64) -> Option<PathBuf> {
+        let path = self.entry_path(key);
+        let hit = path.is_file();
+        self.record(hit);
+        if !hit {
+            return None;
+        }
+        if let Ok(file) = File::options().append(true).open(&path) {
+            let _ = file.set_modified(SystemTime::now());
+        }
+        Some(path)
+    }
+
+    /// Where to build the executable for `key` before `insert` publishes it.
+    /// The name is private to this process, so concurrent builds do not collide.
+    pub fn build_path(&self, key: u64) -> Result<PathBuf> {
+        fs::create_dir_all(&self.dir).map_err(CompilerError::IOError)?;
+        Ok(self
+            .dir
+            .join(format!("{key:016x}-{}.tmp", std::process::id())))
+    }
+
+    /// Publish the executable built at `built` as the entry for `key`, then
+    /// evict old entries down to the size bound
+    pub fn insert(&self, key: u64, built: &Path) -> Result<PathBuf> {
+        let path = self.entry_path(key);
+        fs::rename(built, &path).map_err(CompilerError::IOError)?;
+        self.evict(&path);
+        Ok(path)
+    }
+
+    /// Current counters and contents
+    pub fn stats(&self) -> CacheStats {
+        let (hits, misses) = self.read_counts();
+        let entries = self.entries();
+        CacheStats {
+            hits,
+            misses,
+            entries: entries.len() as u64,
+            bytes: entries.iter().map(|(_, len, _)| len).sum(),
+        }
+    }
+
+    fn entry_path(&self, key: u64) -> PathBuf {
+        self.dir.join(format!("{key:016x}"))
+    }
+
+    /// Published executables: (path, size, last use)
+    fn entries(&self) -> Vec<(PathBuf, u64, SystemTime)> {
+        let Ok(dir) = fs::read_dir(&self.dir) else {
+            return Vec::new();
+        };
+        dir.flatten()
+            .filter(|entry| {
+                let name = entry.file_name();
+                let name = name.to_string_lossy();
+                name.len() == 16 && name.bytes().all(|b| b.is_ascii_hexdigit())
+            })
+            .filter_map(|entry| {
+                let metadata = entry.metadata().ok()?;
+                let used = metadata.modified().ok()?;
+                Some((entry.path(), metadata.len(), used))
+            })
+            .collect()
+    }
+
+    /// Remove abandoned builds, then the least recently used executables until
+    /// the cache fits its bound. `keep`, the one just inserted, stays even if it
+    /// alone is larger.
+    fn evict(&self, keep: &Path) {
+        self.remove_stale_builds();
+        let mut entries = self.entries();
+        let mut total: u64 = entries.iter().map(|(_, len, _)| len).sum();
+        entries.sort_by_key(|(_, _, used)| *used);
+        for (path, len, _) in entries {
+            if total <= self.limit_bytes {
+                break;
+            }
+            if path != keep && fs::remove_file(&path).is_ok() {
+                total -= len;
+            }
+        }
+    }
+
+    fn remove_stale_builds(&self) {
+        let Ok(dir) = fs::read_dir(&self.dir) else {
+            return;
+        };
+        let now = SystemTime::now();
+        for entry in dir.flatten() {
+            if !entry.file_name().to_string_lossy().ends_with(".tmp") {
+                continue;
+            }
+            let stale = entry
+                .metadata()
+                .and_then(|metadata| metadata.modified())
+                .is_ok_and(|modified| {
+                    now.duration_since(modified).unwrap_or_default() > STALE_BUILD_AGE
+                });
+            if stale {
+                let _ = fs::remove_file(entry.path());
+            }
+        }
+    }
+
+    fn read_counts(&self) -> (u64, u64) {
+        let text = fs::read_to_string(self.dir.join(STATS_FILE)).unwrap_or_default();
+        let mut counts = text.split_whitespace().map(|n| n.parse().unwrap_or(0));
+        (counts.next().unwrap_or(0), counts.next().unwrap_or(0))
+    }
+
+    /// Count a lookup. The counters are advisory: concurrent runs may lose an
+    /// update, and a failure to write them is ignored.
+    fn record(&self, hit: bool) {
+        let (mut hits, mut misses) = self.read_counts();
+        if hit {
+            hits += 1;
+        } else {
+            misses += 1;
+        }
+        if fs::create_dir_all(&self.dir).is_ok() {
+            let _ = fs::write(self.dir.join(STATS_FILE), format!("{hits} {misses}\n"));
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use std::time::Duration;
+    use tempfile::TempDir;
+
+    fn build(cache: &ExecutableCache, key: u64, len: usize) -> PathBuf {
+        let path = cache.build_path(key).unwrap();
+        fs::write(&path, vec![0u8; len]).unwrap();
+        cache.insert(key, &path).unwrap()
+    }
+
+    #[test]
+    fn test_hit_after_insert() {
+        let dir = TempDir::new().unwrap();
+        let cache = ExecutableCache::new(dir.path(), DEFAULT_LIMIT_BYTES);
+
+        assert!(cache.lookup(1).is_none());
+        let path = build(&cache, 1, 10);
+        assert_eq!(cache.lookup(1), Some(path));
+
+        let stats = cache.stats();
+        assert_eq!((stats.hits, stats.misses), (1, 1));
+        assert_eq!((stats.entries, stats.bytes), (1, 10));
+    }
+
+    #[test]
+    fn test_evicts_least_recently_used() {
+        let dir = TempDir::new().unwrap();
+        let cache = ExecutableCache::new(dir.path(), 25);
+
+        let old = build(&cache, 1, 10);
+        let used = build(&cache, 2, 10);
+        let past = SystemTime::now() - Duration::from_secs(60);
+        for path in [&old, &used] {
+            File::options()
+                .append(true)
+                .open(path)
+                .unwrap()
+                .set_modified(past)
+                .unwrap();
+        }
+        // Using entry 2 makes entry 1 the one to evict
+        cache.lookup(2);
+        build(&cache, 3, 10);
+
+        assert!(!old.exists());
+        assert!(used.exists());
+        assert_eq!(cache.stats().entries, 2);
+    }
+
+    #[test]
+    fn test_removes_abandoned_builds() {
+        let dir = TempDir::new().unwrap();
+        let cache = ExecutableCache::new(dir.path(), DEFAULT_LIMIT_BYTES);
+
+        let abandoned = dir.path().join("0000000000000001-1.tmp");
+        let running = dir.path().join("0000000000000002-2.tmp");
+        for path in [&abandoned, &running] {
+            fs::write(path, b"partial").unwrap();
+        }
+        File::options()
+            .append(true)
+            .open(&abandoned)
+            .unwrap()
+            .set_modified(SystemTime::now() - STALE_BUILD_AGE * 2)
+            .unwrap();
+        build(&cache, 3, 10);
+
+        assert!(!abandoned.exists());
+        assert!(running.exists());
+    }
+}
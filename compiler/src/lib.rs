@@ -2,10 +2,14 @@ pub mod ast;
 pub mod codegen;
 pub mod driver;
 pub mod error;
+pub mod exe_cache;
 pub mod python_ast;
 pub mod tir;
 
 // Re-export for convenience
 pub use ast::ModuleName;
-pub use driver::{Compiler, CompilerOptions, Target};
+pub use driver::{
+    default_cache_dir, Compiler, CompilerOptions, ExceptionModel, GcConfig, GcMode, OptLevel,
+    Target,
+};
 pub use error::{CompilerError, Result};
@@ -0,0 +1,218 @@
+//! String accumulator loops
+//!
+//! Finds string locals that a loop only ever extends, as in
+//!
+//! ```python
+//! for line in lines:
+//!     out = out + line + "\n"
+//! ```
+//!
+//! Every concatenation copies the whole string built so far, so such a loop is
+//! quadratic. Codegen instead appends each piece to a runtime string builder and
+//! assigns the finished string to the local once the loop exits.
+//!
+//! A local is an accumulator of a loop when the loop contains at least one append
+//! `s = s + p1 + ... + pn` (`s += p` lowers to the same) whose pieces do not use
+//! `s`, and `s` occurs nowhere else in the loop: it is not read by the condition,
+//! the iterable, a return or any other statement, and never assigned another way.
+//! Locals are private to their function, so calls made by the loop cannot observe
+//! the unfinished value either.
+
+use crate::ast::BinOperator;
+
+use super::expr::{TirExpr, TirExprKind, VarRef};
+use super::ids::LocalId;
+use super::stmt::{TirLValue, TirStmt};
+use super::types::TirType;
+
+/// The accumulators of a loop statement, ordered by LocalId (empty for other statements)
+pub fn loop_accumulators(stmt: &TirStmt) -> Vec<LocalId> {
+    if !matches!(
+        stmt,
+        TirStmt::While { .. } | TirStmt::ForRange { .. } | TirStmt::ForList { .. }
+    ) {
+        return Vec::new();
+    }
+
+    let mut locals = Vec::new();
+    collect_append_targets(std::slice::from_ref(stmt), &mut locals);
+    locals.sort_by_key(|local| local.index());
+    locals.dedup();
+    locals.retain(|&local| !other_use(stmt, local));
+    locals
+}
+
+/// The pieces `stmt` appends to `local`, in order, if it is
+/// `local = local + p1 + ... + pn`
+pub fn append_pieces(stmt: &TirStmt, local: LocalId) -> Option<Vec<&TirExpr>> {
+    let TirStmt::Assign {
+        target: TirLValue::Var(VarRef::Local(target)),
+        value,
+    } = stmt
+    else {
+        return None;
+    };
+    if *target != local {
+        return None;
+    }
+
+    // `s + a + b` is `(s + a) + b`: walk down the left operands to `s`
+    let mut pieces = Vec::new();
+    let mut expr = value;
+    while let TirExprKind::BinOp {
+        left,
+        op: BinOperator::Add,
+        right,
+    } = &expr.kind
+    {
+        // Only string concatenation has a class-typed `+`
+        if !matches!(expr.ty, TirType::Class(_)) {
+            return None;
+        }
+        pieces.push(right.as_ref());
+        expr = left;
+    }
+    let reaches_local = matches!(expr.kind, TirExprKind::Var(VarRef::Local(l)) if l == local);
+    if pieces.is_empty() || !reaches_local {
+        return None;
+    }
+    pieces.reverse();
+    Some(pieces)
+}
+
+/// Record the target of every append in the statements
+fn collect_append_targets(body: &[TirStmt], locals: &mut Vec<LocalId>) {
+    for stmt in body {
+        match stmt {
+            TirStmt::Assign {
+                target: TirLValue::Var(VarRef::Local(local)),
+                ..
+            } => {
+                if append_pieces(stmt, *local).is_some() {
+                    locals.push(*local);
+                }
+            }
+            TirStmt::If {
+                then_body,
+                else_body,
+                ..
+            } => {
+                collect_append_targets(then_body, locals);
+                collect_append_targets(else_body, locals);
+            }
+            TirStmt::While { body, .. }
+            | TirStmt::ForRange { body, .. }
+            | TirStmt::ForList { body, .. } => collect_append_targets(body, locals),
+            TirStmt::Try {
+                body,
+                handlers,
+                orelse,
+                finalbody,
+            } => {
+                collect_append_targets(body, locals);
+                for handler in handlers {
+                    collect_append_targets(&handler.body, locals);
+                }
+                collect_append_targets(orelse, locals);
+                collect_append_targets(finalbody, locals);
+            }
+            _ => {}
+        }
+    }
+}
+
+/// Whether `local` occurs in the statement other than as the accumulator of an append
+fn other_use(stmt: &TirStmt, local: LocalId) -> bool {
+    if let Some(pieces) = append_pieces(stmt, local) {
+        return pieces.iter().any(|piece| uses(piece, local));
+    }
+
+    let any = |body: &[TirStmt]| body.iter().any(|s| other_use(s, local));
+    match stmt {
+        TirStmt::Let {
+            local: defined,
+            init,
+            ..
+        } => *defined == local || uses(init, local),
+        TirStmt::Assign { target, value } => {
+            let target_uses = match target {
+                TirLValue::Var(var) => *var == VarRef::Local(local),
+                TirLValue::Field { object, .. } => uses(object, local),
+            };
+            target_uses || uses(value, local)
+        }
+        TirStmt::AugAssign { target, value, .. } => {
+            *target == VarRef::Local(local) || uses(value, local)
+        }
+        TirStmt::Expr(expr) => uses(expr, local),
+        TirStmt::Return(expr) | TirStmt::Raise { exc: expr } => {
+            expr.as_ref().is_some_and(|e| uses(e, local))
+        }
+        TirStmt::If {
+            cond,
+            then_body,
+            else_body,
+        } => uses(cond, local) || any(then_body) || any(else_body),
+        TirStmt::While { cond, body } => uses(cond, local) || any(body),
+        TirStmt::ForRange {
+            target,
+            counter,
+            start,
+            stop,
+            body,
+            ..
+        } => {
+            *target == local
+                || *counter == local
+                || uses(start, local)
+                || uses(stop, local)
+                || any(body)
+        }
+        TirStmt::ForList {
+            target,
+            index,
+            iterable,
+            body,
+        } => *target == local || *index == local || uses(iterable, local) || any(body),
+        TirStmt::Try {
+            body,
+            handlers,
+            orelse,
+            finalbody,
+        } => {
+            any(body)
+                || handlers
+                    .iter()
+                    .any(|h| h.local == Some(local) || any(&h.body))
+                || any(orelse)
+                || any(finalbody)
+        }
+    }
+}
+
+/// Whether the expression reads `local`
+fn uses(expr: &TirExpr, local: LocalId) -> bool {
+    let operand = |e: &TirExpr| uses(e, local);
+    match &expr.kind {
+        TirExprKind::Var(var) => *var == VarRef::Local(local),
+        TirExprKind::Constant(_) | TirExprKind::Bytes { .. } => false,
+        TirExprKind::BinOp { left, right, .. } | TirExprKind::Compare { left, right, .. } => {
+            operand(left) || operand(right)
+        }
+        TirExprKind::BoolOp { values, .. } => values.iter().any(operand),
+        TirExprKind::UnaryOp { operand: inner, .. } => operand(inner),
+        TirExprKind::Call { args, .. } | TirExprKind::Construct { args, .. } => {
+            args.iter().any(operand)
+        }
+        TirExprKind::Range { start, stop, step } => {
+            start.as_deref().is_some_and(operand)
+                || operand(stop)
+                || step.as_deref().is_some_and(operand)
+        }
+        TirExprKind::FieldAccess { object, .. } => operand(object),
+        TirExprKind::List { elements, .. } | TirExprKind::Set { elements } => {
+            elements.iter().any(operand)
+        }
+        TirExprKind::Dict { keys, values } => keys.iter().chain(values).any(operand),
+    }
+}
@@ -0,0 +1,716 @@
+//! Bounds-check elimination
+//!
+//! Finds the list, bytearray and bytes subscripts whose index is provably in
+//! range, so codegen can load or store the element inline instead of calling the
+//! checked runtime kernel. The common shapes are
+//!
+//! ```python
+//! for i in range(len(xs)):      # also range(k, len(xs)) and
+//!     total = total + xs[i]     # range(len(xs) - 1, -1, -1)
+//!
+//! while i < len(xs) and xs[i] != 0:
+//!     i += 1
+//! ```
+//!
+//! A subscript `xs[i]`, with `xs` and `i` both locals or parameters, is in range
+//! when it is reached under a guard `i < len(xs)` (a loop header, a `while` or
+//! `if` condition, or an earlier operand of an `and`) and `i` is known to be
+//! non-negative. Neither variable may be rebound between the guard and the
+//! subscript. Other code cannot invalidate the guard: locals are private to their
+//! function, and no method of these containers makes them shorter, so a length
+//! only grows after it is read. A method that shrinks one would have to end the
+//! facts about every container of its type.
+//!
+//! Evaluating `len(xs)` in the guard also panics on a NULL container, so a safe
+//! subscript needs no NULL check either.
+//!
+//! An index is non-negative when a guard `i >= 0` covers it, or when every
+//! assignment to the local in the function stores a non-negative value: a
+//! constant, a length, a `//` or `%` of such values, the target of a counted
+//! loop that stays above zero. `int` arithmetic wraps, so a sum or product of
+//! non-negative values can be negative and does not count. The one exception is
+//! a counter: a local that starts small (a constant up to 2^32 or a length) and
+//! only ever steps up by a constant of at most MAX_COUNTER_STEP, as in `i = 0`
+//! followed by `i += 1`. It would have to take more than 2^58 steps to wrap,
+//! which no program runs for. This part is a fixpoint over the local's
+//! definitions.
+
+use std::collections::{HashMap, HashSet};
+
+use crate::ast::{BinOperator, BoolOp, CompareOp, UnaryOp};
+
+use super::expr::{TirConstant, TirExpr, TirExprKind, VarRef};
+use super::ids::LocalId;
+use super::program::TirProgram;
+use super::stmt::{TirLValue, TirStmt};
+
+/// Subscript kernels whose index is checked (list kernels before storage specialization)
+const SUBSCRIPT_FUNCS: &[&str] = &[
+    "__pyc___builtin___list___getitem__",
+    "__pyc___builtin___list___setitem__",
+    "__pyc___builtin___bytearray___getitem__",
+    "__pyc___builtin___bytearray___setitem__",
+    "__pyc___builtin___bytes___getitem__",
+];
+
+/// Largest constant a counter starts from
+const SMALL_MAX: i64 = 1 << 32;
+
+/// Largest step of a counter (`i += 1` up to `i += MAX_COUNTER_STEP`)
+const MAX_COUNTER_STEP: i64 = 16;
+
+/// Length functions of the containers in SUBSCRIPT_FUNCS
+const LEN_FUNCS: &[&str] = &[
+    "__pyc___builtin___list___len__",
+    "__pyc___builtin___bytearray___len__",
+    "__pyc___builtin___bytes___len__",
+];
+
+/// What is known about the variables at a program point
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+enum Fact {
+    /// The variable holds a value >= 0
+    NonNeg(VarRef),
+    /// The index variable is below the length of the container variable
+    Below(VarRef, VarRef),
+}
+
+impl Fact {
+    fn mentions(self, var: VarRef) -> bool {
+        match self {
+            Fact::NonNeg(v) => v == var,
+            Fact::Below(index, container) => index == var || container == var,
+        }
+    }
+}
+
+/// The in-range subscripts of one function body
+#[derive(Debug, Clone, Default)]
+pub struct SafeSubscripts {
+    /// Addresses of the subscript Call expressions, which stay put while
+    /// codegen borrows the program
+    calls: HashSet<*const TirExpr>,
+}
+
+impl SafeSubscripts {
+    /// Find the in-range subscripts of a function or module init body
+    pub fn analyze(body: &[TirStmt], program: &TirProgram) -> Self {
+        let mut analysis = Analysis {
+            program,
+            bounds: local_bounds(body, program),
+            safe: SafeSubscripts::default(),
+        };
+        analysis.body(body, &mut Vec::new());
+        analysis.safe
+    }
+
+    /// Whether the subscript call `expr` needs no bounds or NULL check
+    pub fn contains(&self, expr: &TirExpr) -> bool {
+        self.calls.contains(&(expr as *const TirExpr))
+    }
+}
+
+struct Analysis<'p> {
+    program: &'p TirProgram,
+    /// What is known about the values of each local
+    bounds: HashMap<LocalId, Bound>,
+    safe: SafeSubscripts,
+}
+
+impl Analysis<'_> {
+    fn body(&mut self, stmts: &[TirStmt], facts: &mut Vec<Fact>) {
+        for stmt in stmts {
+            self.stmt(stmt, facts);
+        }
+    }
+
+    /// Record the safe subscripts of the statement, then update the facts that
+    /// hold after it. Assignments happen after their operands are evaluated, so
+    /// the operands see the facts from before.
+    fn stmt(&mut self, stmt: &TirStmt, facts: &mut Vec<Fact>) {
+        match stmt {
+            TirStmt::Let { local, init, .. } => {
+                self.expr(init, facts);
+                kill(facts, VarRef::Local(*local));
+            }
+            TirStmt::Assign { target, value } => {
+                if let TirLValue::Field { object, .. } = target {
+                    self.expr(object, facts);
+                }
+                self.expr(value, facts);
+                if let TirLValue::Var(var) = target {
+                    kill(facts, *var);
+                }
+            }
+            TirStmt::AugAssign { target, value, .. } => {
+                self.expr(value, facts);
+                kill(facts, *target);
+            }
+            TirStmt::Expr(expr) => self.expr(expr, facts),
+            TirStmt::Return(expr) | TirStmt::Raise { exc: expr } => {
+                if let Some(expr) = expr {
+                    self.expr(expr, facts);
+                }
+            }
+            TirStmt::If {
+                cond,
+                then_body,
+                else_body,
+            } => {
+                self.expr(cond, facts);
+                let mut then_facts = facts.clone();
+                then_facts.extend(self.guards(cond));
+                self.body(then_body, &mut then_facts);
+                self.body(else_body, &mut facts.clone());
+                kill_assigned(facts, std::slice::from_ref(stmt));
+            }
+            TirStmt::While { cond, body } => {
+                // Only facts no iteration disturbs hold at every test of the condition
+                kill_assigned(facts, body);
+                self.expr(cond, facts);
+                let mut body_facts = facts.clone();
+                body_facts.extend(self.guards(cond));
+                self.body(body, &mut body_facts);
+            }
+            TirStmt::ForRange {
+                target,
+                counter,
+                start,
+                stop,
+                step,
+                body,
+                ..
+            } => {
+                self.expr(start, facts);
+                self.expr(stop, facts);
+                kill_assigned(facts, body);
+                kill(facts, VarRef::Local(*target));
+                kill(facts, VarRef::Local(*counter));
+                // The loop rebinds the target from the counter at the top of every
+                // iteration, so only the body rebinding the container ends these
+                let mut body_facts = facts.clone();
+                body_facts.extend(
+                    self.range_guards(*target, start, stop, *step)
+                        .into_iter()
+                        .filter(|fact| match fact {
+                            Fact::Below(_, container) => !assigns(body, *container),
+                            Fact::NonNeg(_) => true,
+                        }),
+                );
+                self.body(body, &mut body_facts);
+            }
+            TirStmt::ForList {
+                target,
+                index,
+                iterable,
+                body,
+            } => {
+                self.expr(iterable, facts);
+                kill_assigned(facts, body);
+                kill(facts, VarRef::Local(*target));
+                kill(facts, VarRef::Local(*index));
+                self.body(body, &mut facts.clone());
+            }
+            TirStmt::Try {
+                body,
+                handlers,
+                orelse,
+                finalbody,
+            } => {
+                // A handler or the finally body can start after any statement of
+                // the body, so all of them start from facts the whole try keeps
+                kill_assigned(facts, std::slice::from_ref(stmt));
+                self.body(body, &mut facts.clone());
+                for handler in handlers {
+                    self.body(&handler.body, &mut facts.clone());
+                }
+                self.body(orelse, &mut facts.clone());
+                self.body(finalbody, &mut facts.clone());
+            }
+        }
+    }
+
+    /// Record the safe subscripts in an expression evaluated under `facts`
+    fn expr(&mut self, expr: &TirExpr, facts: &[Fact]) {
+        match &expr.kind {
+            TirExprKind::Var(_) | TirExprKind::Constant(_) | TirExprKind::Bytes { .. } => {}
+            TirExprKind::BinOp { left, right, .. } | TirExprKind::Compare { left, right, .. } => {
+                self.expr(left, facts);
+                self.expr(right, facts);
+            }
+            TirExprKind::BoolOp {
+                op: BoolOp::And,
+                values,
+            } => {
+                // Each operand runs only if the ones before it held
+                let mut operand_facts = facts.to_vec();
+                for value in values {
+                    self.expr(value, &operand_facts);
+                    operand_facts.extend(self.guards(value));
+                }
+            }
+            TirExprKind::BoolOp { values, .. } => {
+                for value in values {
+                    self.expr(value, facts);
+                }
+            }
+            TirExprKind::UnaryOp { operand, .. } => self.expr(operand, facts),
+            TirExprKind::Call { args, .. } => {
+                for arg in args {
+                    self.expr(arg, facts);
+                }
+                if self.in_range(expr, facts) {
+                    self.safe.calls.insert(expr as *const TirExpr);
+                }
+            }
+            TirExprKind::Construct { args, .. } => {
+                for arg in args {
+                    self.expr(arg, facts);
+                }
+            }
+            TirExprKind::Range { start, stop, step } => {
+                for operand in [start.as_deref(), Some(stop.as_ref()), step.as_deref()]
+                    .into_iter()
+                    .flatten()
+                {
+                    self.expr(operand, facts);
+                }
+            }
+            TirExprKind::FieldAccess { object, .. } => self.expr(object, facts),
+            TirExprKind::List { elements, .. } | TirExprKind::Set { elements } => {
+                for element in elements {
+                    self.expr(element, facts);
+                }
+            }
+            TirExprKind::Dict { keys, values } => {
+                for operand in keys.iter().chain(values) {
+                    self.expr(operand, facts);
+                }
+            }
+        }
+    }
+
+    /// Whether `expr` is a subscript call whose index the facts keep in range
+    fn in_range(&self, expr: &TirExpr, facts: &[Fact]) -> bool {
+        let TirExprKind::Call { func, args } = &expr.kind else {
+            return false;
+        };
+        let is_subscript = self
+            .program
+            .function(*func)
+            .runtime_name
+            .as_deref()
+            .is_some_and(|name| SUBSCRIPT_FUNCS.contains(&name));
+        if !is_subscript {
+            return false;
+        }
+        let (Some(container), Some(index)) =
+            (args.first().and_then(var), args.get(1).and_then(var))
+        else {
+            return false;
+        };
+        let nonneg = match index {
+            VarRef::Local(local) => self.bounds.get(&local) >= Some(&Bound::NonNeg),
+            _ => false,
+        } || facts.contains(&Fact::NonNeg(index));
+        nonneg && facts.contains(&Fact::Below(index, container))
+    }
+
+    /// Facts that hold when the condition is true
+    fn guards(&self, cond: &TirExpr) -> Vec<Fact> {
+        match &cond.kind {
+            TirExprKind::BoolOp {
+                op: BoolOp::And,
+                values,
+            } => values.iter().flat_map(|value| self.guards(value)).collect(),
+            TirExprKind::Compare { left, op, right } => {
+                // Normalize `a > b` to `b < a` and `a >= b` to `b <= a`
+                let (low, op, high) = match op {
+                    CompareOp::Gt => (right, CompareOp::Lt, left),
+                    CompareOp::GtE => (right, CompareOp::LtE, left),
+                    _ => (left, *op, right),
+                };
+                let mut facts = Vec::new();
+                if let (CompareOp::Lt, Some(index), Some(container)) =
+                    (op, var(low), self.len_of(high))
+                {
+                    facts.push(Fact::Below(index, container));
+                }
+                let low_bound = match op {
+                    CompareOp::Lt => const_int(low).map(|c| c + 1),
+                    CompareOp::LtE => const_int(low),
+                    _ => None,
+                };
+                if let (Some(bound), Some(index)) = (low_bound, var(high)) {
+                    if bound >= 0 {
+                        facts.push(Fact::NonNeg(index));
+                    }
+                }
+                facts
+            }
+            _ => Vec::new(),
+        }
+    }
+
+    /// Facts about the target at the top of every iteration of
+    /// `for target in range(start, stop, step)`
+    fn range_guards(
+        &self,
+        target: LocalId,
+        start: &TirExpr,
+        stop: &TirExpr,
+        step: i64,
+    ) -> Vec<Fact> {
+        let target = VarRef::Local(target);
+        let mut facts = Vec::new();
+        if step > 0 {
+            // start <= target < stop
+            if let Some(container) = self.len_of(stop) {
+                facts.push(Fact::Below(target, container));
+            }
+        } else if let TirExprKind::BinOp {
+            left,
+            op: BinOperator::Sub,
+            right,
+        } = &start.kind
+        {
+            // stop < target <= len(xs) - c
+            if let (Some(container), Some(c)) = (self.len_of(left), const_int(right)) {
+                if c >= 1 {
+                    facts.push(Fact::Below(target, container));
+                }
+            }
+        }
+        if range_target_bound(start, stop, step, &self.bounds, self.program) >= Bound::NonNeg {
+            facts.push(Fact::NonNeg(target));
+        }
+        facts
+    }
+
+    /// The container `xs` if the expression is `len(xs)` on a subscriptable container
+    fn len_of(&self, expr: &TirExpr) -> Option<VarRef> {
+        match &expr.kind {
+            TirExprKind::Call { func, args } if args.len() == 1 => {
+                let name = self.program.function(*func).runtime_name.as_deref()?;
+                LEN_FUNCS.contains(&name).then(|| var(&args[0]))?
+            }
+            _ => None,
+        }
+    }
+}
+
+/// The variable an expression reads, if it is a local or parameter.
+/// Globals are left out: any call may rebind them.
+fn var(expr: &TirExpr) -> Option<VarRef> {
+    match expr.kind {
+        TirExprKind::Var(var @ (VarRef::Local(_) | VarRef::Param(_))) => Some(var),
+        _ => None,
+    }
+}
+
+/// The value of an integer constant, including a negated one
+fn const_int(expr: &TirExpr) -> Option<i64> {
+    match &expr.kind {
+        TirExprKind::Constant(TirConstant::Int(n)) => Some(*n),
+        TirExprKind::UnaryOp {
+            op: UnaryOp::USub,
+            operand,
+        } => const_int(operand)?.checked_neg(),
+        _ => None,
+    }
+}
+
+/// Drop the facts about `var`
+fn kill(facts: &mut Vec<Fact>, var: VarRef) {
+    facts.retain(|fact| !fact.mentions(var));
+}
+
+/// Drop the facts about every variable the statements may rebind
+fn kill_assigned(facts: &mut Vec<Fact>, stmts: &[TirStmt]) {
+    facts.retain(|fact| {
+        let vars = match *fact {
+            Fact::NonNeg(v) => [v, v],
+            Fact::Below(index, container) => [index, container],
+        };
+        !vars.iter().any(|&v| assigns(stmts, v))
+    });
+}
+
+/// Whether the statements may rebind `var`
+fn assigns(stmts: &[TirStmt], var: VarRef) -> bool {
+    let local = |l: &LocalId| VarRef::Local(*l) == var;
+    stmts.iter().any(|stmt| match stmt {
+        TirStmt::Let { local: l, .. } => local(l),
+        TirStmt::Assign {
+            target: TirLValue::Var(target),
+            ..
+        }
+        | TirStmt::AugAssign { target, .. } => *target == var,
+        TirStmt::Assign { .. } | TirStmt::Expr(_) | TirStmt::Return(_) | TirStmt::Raise { .. } => {
+            false
+        }
+        TirStmt::If {
+            then_body,
+            else_body,
+            ..
+        } => assigns(then_body, var) || assigns(else_body, var),
+        TirStmt::While { body, .. } => assigns(body, var),
+        TirStmt::ForRange {
+            target,
+            counter,
+            body,
+            ..
+        } => local(target) || local(counter) || assigns(body, var),
+        TirStmt::ForList {
+            target,
+            index,
+            body,
+            ..
+        } => local(target) || local(index) || assigns(body, var),
+        TirStmt::Try {
+            body,
+            handlers,
+            orelse,
+            finalbody,
+        } => {
+            assigns(body, var)
+                || handlers
+                    .iter()
+                    .any(|h| h.local.as_ref().is_some_and(local) || assigns(&h.body, var))
+                || assigns(orelse, var)
+                || assigns(finalbody, var)
+        }
+    })
+}
+
+/// One way a local gets a value
+enum Definition<'a> {
+    /// `local = value`
+    Value(&'a TirExpr),
+    /// `local op= value`
+    Aug(BinOperator, &'a TirExpr),
+    /// The target of `for local in range(start, stop, step)`
+    RangeTarget(&'a TirExpr, &'a TirExpr, i64),
+    /// A list element or a caught exception
+    Other,
+}
+
+/// What is known about the values of an integer local or expression
+#[derive(Debug, Clone, Copy, PartialEq, Eq, PartialOrd, Ord)]
+enum Bound {
+    /// May be negative
+    Any,
+    /// Non-negative, but may be near the top of the range
+    NonNeg,
+    /// Non-negative and at most SMALL_MAX or a length, plus the counter steps
+    /// taken since
+    Small,
+}
+
+/// What is known about every local defined in the body: start from `Small`
+/// and lower a local whenever one of its definitions may store a value outside
+/// its bound, until the rest agree
+fn local_bounds(body: &[TirStmt], program: &TirProgram) -> HashMap<LocalId, Bound> {
+    let mut definitions = Vec::new();
+    collect_definitions(body, &mut definitions);
+
+    let mut bounds: HashMap<LocalId, Bound> = definitions
+        .iter()
+        .map(|(local, _)| (*local, Bound::Small))
+        .collect();
+    let mut changed = true;
+    while changed {
+        changed = false;
+        for (local, definition) in &definitions {
+            let current = bounds[local];
+            if current == Bound::Any {
+                continue;
+            }
+            let stored = match definition {
+                Definition::Value(value) => match counter_step(*local, value) {
+                    Some(step) => step_bound(step, current),
+                    None => bound_expr(value, &bounds, program),
+                },
+                Definition::Aug(BinOperator::Add, value) => step_bound(value, current),
+                // Non-negative operands: the result is at most the old value
+                Definition::Aug(BinOperator::FloorDiv | BinOperator::Mod, value) => {
+                    if bound_expr(value, &bounds, program) >= Bound::NonNeg {
+                        current
+                    } else {
+                        Bound::Any
+                    }
+                }
+                Definition::Aug(..) => Bound::Any,
+                Definition::RangeTarget(start, stop, step) => {
+                    range_target_bound(start, stop, *step, &bounds, program)
+                }
+                Definition::Other => Bound::Any,
+            };
+            if stored < current {
+                bounds.insert(*local, stored);
+                changed = true;
+            }
+        }
+    }
+    bounds
+}
+
+/// The step of `local = local + step`, which counts like `local += step`
+fn counter_step(local: LocalId, value: &TirExpr) -> Option<&TirExpr> {
+    match &value.kind {
+        TirExprKind::BinOp {
+            left,
+            op: BinOperator::Add,
+            right,
+        } => match (&left.kind, &right.kind) {
+            (TirExprKind::Var(VarRef::Local(l)), _) if *l == local => Some(right),
+            (_, TirExprKind::Var(VarRef::Local(r))) if *r == local => Some(left),
+            _ => None,
+        },
+        _ => None,
+    }
+}
+
+/// The bound of a local of bound `current` after `local += step`: a small
+/// counter stays small; anything else may wrap
+fn step_bound(step: &TirExpr, current: Bound) -> Bound {
+    let small_step = const_int(step).is_some_and(|c| (0..=MAX_COUNTER_STEP).contains(&c));
+    if small_step && current == Bound::Small {
+        Bound::Small
+    } else {
+        Bound::Any
+    }
+}
+
+fn collect_definitions<'a>(stmts: &'a [TirStmt], definitions: &mut Vec<(LocalId, Definition<'a>)>) {
+    for stmt in stmts {
+        match stmt {
+            TirStmt::Let { local, init, .. } => definitions.push((*local, Definition::Value(init))),
+            TirStmt::Assign {
+                target: TirLValue::Var(VarRef::Local(local)),
+                value,
+            } => definitions.push((*local, Definition::Value(value))),
+            TirStmt::AugAssign {
+                target: VarRef::Local(local),
+                op,
+                value,
+            } => definitions.push((*local, Definition::Aug(*op, value))),
+            TirStmt::Assign { .. }
+            | TirStmt::AugAssign { .. }
+            | TirStmt::Expr(_)
+            | TirStmt::Return(_)
+            | TirStmt::Raise { .. } => {}
+            TirStmt::If {
+                then_body,
+                else_body,
+                ..
+            } => {
+                collect_definitions(then_body, definitions);
+                collect_definitions(else_body, definitions);
+            }
+            TirStmt::While { body, .. } => collect_definitions(body, definitions),
+            TirStmt::ForRange {
+                target,
+                start,
+                stop,
+                step,
+                body,
+                ..
+            } => {
+                definitions.push((*target, Definition::RangeTarget(start, stop, *step)));
+                collect_definitions(body, definitions);
+            }
+            TirStmt::ForList { target, body, .. } => {
+                definitions.push((*target, Definition::Other));
+                collect_definitions(body, definitions);
+            }
+            TirStmt::Try {
+                body,
+                handlers,
+                orelse,
+                finalbody,
+            } => {
+                collect_definitions(body, definitions);
+                for handler in handlers {
+                    if let Some(local) = handler.local {
+                        definitions.push((local, Definition::Other));
+                    }
+                    collect_definitions(&handler.body, definitions);
+                }
+                collect_definitions(orelse, definitions);
+                collect_definitions(finalbody, definitions);
+            }
+        }
+    }
+}
+
+/// The bound of the target of `for target in range(start, stop, step)`. It
+/// stays >= 0 when it rises from a non-negative start, or falls towards a stop
+/// of -1 or more, and it is small when the end it never passes is.
+fn range_target_bound(
+    start: &TirExpr,
+    stop: &TirExpr,
+    step: i64,
+    bounds: &HashMap<LocalId, Bound>,
+    program: &TirProgram,
+) -> Bound {
+    let (low, high) = if step > 0 {
+        (
+            bound_expr(start, bounds, program),
+            bound_expr(stop, bounds, program),
+        )
+    } else {
+        let low = if const_int(stop).is_some_and(|c| c >= -1) {
+            Bound::Small
+        } else {
+            bound_expr(stop, bounds, program)
+        };
+        (low, bound_expr(start, bounds, program))
+    };
+    if low == Bound::Any {
+        Bound::Any
+    } else {
+        high.max(Bound::NonNeg)
+    }
+}
+
+/// What is known about the value of an expression, given the bounds of the
+/// locals
+fn bound_expr(expr: &TirExpr, bounds: &HashMap<LocalId, Bound>, program: &TirProgram) -> Bound {
+    match &expr.kind {
+        TirExprKind::Constant(TirConstant::Int(n)) => match *n {
+            n if n < 0 => Bound::Any,
+            n if n <= SMALL_MAX => Bound::Small,
+            _ => Bound::NonNeg,
+        },
+        TirExprKind::Var(VarRef::Local(local)) => bounds.get(local).copied().unwrap_or(Bound::Any),
+        // Both operands non-negative: `a // b` is at most a, and `a % b` at
+        // most a and below b
+        TirExprKind::BinOp { left, op, right }
+            if matches!(op, BinOperator::FloorDiv | BinOperator::Mod) =>
+        {
+            let (left, right) = (
+                bound_expr(left, bounds, program),
+                bound_expr(right, bounds, program),
+            );
+            match (left, right) {
+                (Bound::Any, _) | (_, Bound::Any) => Bound::Any,
+                _ if *op == BinOperator::Mod => left.max(right),
+                _ => left,
+            }
+        }
+        TirExprKind::Call { func, .. } => {
+            let is_len = program
+                .function(*func)
+                .runtime_name
+                .as_deref()
+                .is_some_and(|name| LEN_FUNCS.contains(&name));
+            if is_len {
+                Bound::Small
+            } else {
+                Bound::Any
+            }
+        }
+        _ => Bound::Any,
+    }
+}
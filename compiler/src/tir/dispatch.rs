@@ -0,0 +1,453 @@
+//! Method dispatch
+//!
+//! Lowering binds every method call to a FuncId from the static type of its
+//! receiver. Types match exactly, so a receiver of type `C` holds a `C` or,
+//! since `self` in an inherited method is a subclass instance that can be
+//! passed anywhere a `C` goes, an instance of any class below `C`. A call of
+//! `m` on it may therefore run the `m` of any class in the subtree of `C`.
+//!
+//! Class-hierarchy analysis finds the implementations in that subtree. A call
+//! with a single one (every call on a leaf class, and every call of a method no
+//! subclass overrides) stays a direct call that LLVM can inline. So does a call
+//! whose receiver is known to be exactly its static class: a constructor, or a
+//! local only ever bound to constructors of its own class. The remaining calls
+//! load their target from the receiver's vtable.
+//!
+//! A method some subclass overrides is virtual, and gets a slot in the vtables
+//! of its hierarchy (the classes below its topmost ancestor). Every class of a
+//! hierarchy with a virtual method carries a pointer to its vtable before its
+//! fields; other classes keep their plain layout. `super().m()` is always a
+//! direct call: lowering types its receiver as the parent class, which tells it
+//! apart from `self.m()`.
+//!
+//! Overrides must keep the signature of the method they override to be called
+//! through the base class; a call reaches the nearest override along the way
+//! that does. Exceptions are built by the runtime and never get a vtable, so
+//! calls on them bind statically.
+
+use std::collections::{HashMap, HashSet};
+
+use super::expr::{TirExpr, TirExprKind, VarRef};
+use super::ids::{ClassId, FuncId, LocalId};
+use super::program::TirProgram;
+use super::stmt::{TirLValue, TirStmt};
+use super::types::TirType;
+
+/// The vtables and virtual methods of a program
+#[derive(Debug, Clone, Default)]
+pub struct ClassHierarchy {
+    /// Indexed by ClassId: the class and every class below it
+    subtrees: Vec<Vec<ClassId>>,
+    /// Indexed by ClassId: the vtable entries of the class, None if it has no
+    /// vtable. An entry is None where the slot's method is not defined on the class.
+    vtables: Vec<Option<Vec<Option<FuncId>>>>,
+    /// Slot of each virtual method in the vtables of its hierarchy
+    slots: HashMap<FuncId, u32>,
+    /// Every implementation a call bound to a virtual method may run
+    implementations: HashMap<FuncId, Vec<FuncId>>,
+}
+
+impl ClassHierarchy {
+    pub fn analyze(program: &TirProgram) -> Self {
+        let mut children: Vec<Vec<ClassId>> = vec![Vec::new(); program.classes.len()];
+        for class in &program.classes {
+            if let Some(parent) = class.parent {
+                children[parent.index()].push(class.id);
+            }
+        }
+        let mut hierarchy = ClassHierarchy {
+            subtrees: vec![Vec::new(); program.classes.len()],
+            vtables: vec![None; program.classes.len()],
+            ..Default::default()
+        };
+        for class in &program.classes {
+            let mut subtree = vec![class.id];
+            let mut next = 0;
+            while next < subtree.len() {
+                subtree.extend(&children[subtree[next].index()]);
+                next += 1;
+            }
+            hierarchy.subtrees[class.id.index()] = subtree;
+        }
+
+        // Virtual methods, grouped by the root of their hierarchy
+        let mut virtuals: HashMap<ClassId, Vec<FuncId>> = HashMap::new();
+        for func in &program.functions {
+            let Some(class) = func.class else { continue };
+            // Constructors run the `__init__` of the class they build, and
+            // super().__init__() is direct, so `__init__` never needs a slot
+            if func.runtime_name.is_some()
+                || func.name == "__init__"
+                || !user_hierarchy(class, program)
+            {
+                continue;
+            }
+            let targets = hierarchy.targets(class, func.id, program);
+            if targets.len() > 1 {
+                hierarchy.implementations.insert(func.id, targets);
+                virtuals
+                    .entry(root(class, program))
+                    .or_default()
+                    .push(func.id);
+            }
+        }
+
+        for (root, mut methods) in virtuals {
+            methods.sort_by_key(|func| func.0);
+            for (slot, func) in methods.iter().enumerate() {
+                hierarchy.slots.insert(*func, slot as u32);
+            }
+            for &class in &hierarchy.subtrees[root.index()] {
+                let entries = methods
+                    .iter()
+                    .map(|&func| implementation(class, func, program))
+                    .collect();
+                hierarchy.vtables[class.index()] = Some(entries);
+            }
+        }
+        hierarchy
+    }
+
+    /// Whether instances of the class start with a vtable pointer
+    pub fn has_vtable(&self, class: ClassId) -> bool {
+        self.vtable(class).is_some()
+    }
+
+    /// The entries of the class's vtable, by slot
+    pub fn vtable(&self, class: ClassId) -> Option<&[Option<FuncId>]> {
+        self.vtables.get(class.index())?.as_deref()
+    }
+
+    /// The implementations of every virtual method, for analyses that follow calls
+    pub fn override_sets(&self) -> HashMap<FuncId, Vec<FuncId>> {
+        self.implementations.clone()
+    }
+
+    /// The distinct implementations of `func` in the subtree of `class`
+    fn targets(&self, class: ClassId, func: FuncId, program: &TirProgram) -> Vec<FuncId> {
+        let mut targets: Vec<FuncId> = Vec::new();
+        for &sub in &self.subtrees[class.index()] {
+            if let Some(target) = implementation(sub, func, program) {
+                if !targets.contains(&target) {
+                    targets.push(target);
+                }
+            }
+        }
+        targets
+    }
+}
+
+/// How codegen emits a method call
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum Binding {
+    /// A direct call of this implementation
+    Direct(FuncId),
+    /// A call through this slot of the receiver's vtable
+    Virtual(u32),
+}
+
+/// The bindings of the calls of virtual methods in one function body, looked
+/// up by expression. Other calls run the function they are bound to.
+#[derive(Debug, Clone, Default)]
+pub struct CallBindings {
+    calls: HashMap<*const TirExpr, Binding>,
+}
+
+impl CallBindings {
+    /// Bind the virtual calls of a body; `class` is the class of the method
+    /// the body belongs to
+    pub fn analyze(
+        body: &[TirStmt],
+        class: Option<ClassId>,
+        locals: &[(String, TirType)],
+        hierarchy: &ClassHierarchy,
+        program: &TirProgram,
+    ) -> Self {
+        let mut bindings = CallBindings::default();
+        if hierarchy.slots.is_empty() {
+            return bindings;
+        }
+        let binder = Binder {
+            class,
+            exact: exact_locals(body, locals),
+            hierarchy,
+            program,
+        };
+        for_each_expr(body, &mut |expr| {
+            if let Some(binding) = binder.bind(expr) {
+                bindings.calls.insert(expr as *const TirExpr, binding);
+            }
+        });
+        bindings
+    }
+
+    /// The binding of a call expression of the analyzed body
+    pub fn get(&self, expr: &TirExpr) -> Option<Binding> {
+        self.calls.get(&(expr as *const TirExpr)).copied()
+    }
+}
+
+struct Binder<'a> {
+    class: Option<ClassId>,
+    exact: HashSet<LocalId>,
+    hierarchy: &'a ClassHierarchy,
+    program: &'a TirProgram,
+}
+
+impl Binder<'_> {
+    fn bind(&self, expr: &TirExpr) -> Option<Binding> {
+        let TirExprKind::Call { func, args } = &expr.kind else {
+            return None;
+        };
+        let slot = *self.hierarchy.slots.get(func)?;
+        let receiver = args.first()?;
+        let TirType::Class(static_class) = receiver.ty else {
+            return None;
+        };
+
+        let exact = match &receiver.kind {
+            // super().m(): the receiver is self typed as the parent class
+            TirExprKind::Var(VarRef::SelfRef) if self.class != Some(static_class) => {
+                return Some(Binding::Direct(*func));
+            }
+            TirExprKind::Construct { class, .. } => Some(*class),
+            TirExprKind::Var(VarRef::Local(local)) if self.exact.contains(local) => {
+                Some(static_class)
+            }
+            _ => None,
+        };
+        if let Some(class) = exact {
+            return implementation(class, *func, self.program).map(Binding::Direct);
+        }
+
+        match self.hierarchy.targets(static_class, *func, self.program)[..] {
+            [target] => Some(Binding::Direct(target)),
+            _ => Some(Binding::Virtual(slot)),
+        }
+    }
+}
+
+/// The method a call bound to `func` runs on an instance of `class`: the
+/// nearest definition with the same name and signature, or None if `class` is
+/// not below the class of `func`
+fn implementation(class: ClassId, func: FuncId, program: &TirProgram) -> Option<FuncId> {
+    let base = program.function(func);
+    let mut current = Some(class);
+    while let Some(id) = current {
+        if Some(id) == base.class {
+            return Some(func);
+        }
+        if let Some(found) = program.class(id).get_method(&base.name) {
+            let candidate = program.function(found);
+            if candidate
+                .params
+                .iter()
+                .map(|(_, ty)| ty)
+                .eq(base.params.iter().map(|(_, ty)| ty))
+                && candidate.return_type == base.return_type
+            {
+                return Some(found);
+            }
+        }
+        current = program.class(id).parent;
+    }
+    None
+}
+
+fn root(class: ClassId, program: &TirProgram) -> ClassId {
+    let mut root = class;
+    while let Some(parent) = program.class(root).parent {
+        root = parent;
+    }
+    root
+}
+
+/// Whether the class and its ancestors are all user classes
+pub(crate) fn user_hierarchy(class: ClassId, program: &TirProgram) -> bool {
+    let mut current = Some(class);
+    while let Some(id) = current {
+        let class_def = program.class(id);
+        if class_def.qualified_name.starts_with("__builtin__.") {
+            return false;
+        }
+        current = class_def.parent;
+    }
+    true
+}
+
+/// Locals of class type that are only ever bound to constructors of their own class
+fn exact_locals(body: &[TirStmt], locals: &[(String, TirType)]) -> HashSet<LocalId> {
+    let mut bindings = LocalBindings {
+        locals,
+        constructed: HashSet::new(),
+        other: HashSet::new(),
+    };
+    bindings.collect(body);
+    bindings
+        .constructed
+        .difference(&bindings.other)
+        .copied()
+        .collect()
+}
+
+/// The locals of a body, split by whether a binding may not be a constructor
+/// of their own class
+struct LocalBindings<'a> {
+    locals: &'a [(String, TirType)],
+    constructed: HashSet<LocalId>,
+    other: HashSet<LocalId>,
+}
+
+impl LocalBindings<'_> {
+    fn bind(&mut self, local: LocalId, value: Option<&TirExpr>) {
+        let is_own_constructor = match (value.map(|v| &v.kind), self.locals.get(local.index())) {
+            (Some(TirExprKind::Construct { class, .. }), Some((_, TirType::Class(ty)))) => {
+                class == ty
+            }
+            _ => false,
+        };
+        if is_own_constructor {
+            self.constructed.insert(local);
+        } else {
+            self.other.insert(local);
+        }
+    }
+
+    fn collect(&mut self, body: &[TirStmt]) {
+        for stmt in body {
+            match stmt {
+                TirStmt::Let { local, init, .. } => self.bind(*local, Some(init)),
+                TirStmt::Assign {
+                    target: TirLValue::Var(VarRef::Local(local)),
+                    value,
+                } => self.bind(*local, Some(value)),
+                TirStmt::AugAssign {
+                    target: VarRef::Local(local),
+                    ..
+                } => self.bind(*local, None),
+                TirStmt::ForRange { target, body, .. } | TirStmt::ForList { target, body, .. } => {
+                    self.bind(*target, None);
+                    self.collect(body);
+                }
+                TirStmt::If {
+                    then_body,
+                    else_body,
+                    ..
+                } => {
+                    self.collect(then_body);
+                    self.collect(else_body);
+                }
+                TirStmt::While { body, .. } => self.collect(body),
+                TirStmt::Try {
+                    body,
+                    handlers,
+                    orelse,
+                    finalbody,
+                } => {
+                    self.collect(body);
+                    for handler in handlers {
+                        if let Some(local) = handler.local {
+                            self.bind(local, None);
+                        }
+                        self.collect(&handler.body);
+                    }
+                    self.collect(orelse);
+                    self.collect(finalbody);
+                }
+                _ => {}
+            }
+        }
+    }
+}
+
+/// Call `f` on every expression of a body, subexpressions included
+fn for_each_expr(body: &[TirStmt], f: &mut impl FnMut(&TirExpr)) {
+    for stmt in body {
+        match stmt {
+            TirStmt::Let { init: expr, .. }
+            | TirStmt::AugAssign { value: expr, .. }
+            | TirStmt::Expr(expr)
+            | TirStmt::Return(Some(expr))
+            | TirStmt::Raise { exc: Some(expr) } => visit_expr(expr, f),
+            TirStmt::Assign { target, value } => {
+                if let TirLValue::Field { object, .. } = target {
+                    visit_expr(object, f);
+                }
+                visit_expr(value, f);
+            }
+            TirStmt::If {
+                cond,
+                then_body,
+                else_body,
+            } => {
+                visit_expr(cond, f);
+                for_each_expr(then_body, f);
+                for_each_expr(else_body, f);
+            }
+            TirStmt::While { cond, body } => {
+                visit_expr(cond, f);
+                for_each_expr(body, f);
+            }
+            TirStmt::ForRange {
+                start, stop, body, ..
+            } => {
+                visit_expr(start, f);
+                visit_expr(stop, f);
+                for_each_expr(body, f);
+            }
+            TirStmt::ForList { iterable, body, .. } => {
+                visit_expr(iterable, f);
+                for_each_expr(body, f);
+            }
+            TirStmt::Try {
+                body,
+                handlers,
+                orelse,
+                finalbody,
+            } => {
+                for_each_expr(body, f);
+                for handler in handlers {
+                    for_each_expr(&handler.body, f);
+                }
+                for_each_expr(orelse, f);
+                for_each_expr(finalbody, f);
+            }
+            TirStmt::Return(None) | TirStmt::Raise { exc: None } => {}
+        }
+    }
+}
+
+/// Call `f` on `expr` and each of its subexpressions
+fn visit_expr(expr: &TirExpr, f: &mut impl FnMut(&TirExpr)) {
+    f(expr);
+    match &expr.kind {
+        TirExprKind::Constant(_) | TirExprKind::Var(_) | TirExprKind::Bytes { .. } => {}
+        TirExprKind::BinOp { left, right, .. } | TirExprKind::Compare { left, right, .. } => {
+            visit_expr(left, f);
+            visit_expr(right, f);
+        }
+        TirExprKind::UnaryOp { operand, .. } => visit_expr(operand, f),
+        TirExprKind::FieldAccess { object, .. } => visit_expr(object, f),
+        TirExprKind::Range { start, stop, step } => {
+            for e in start.iter().chain(Some(stop)).chain(step) {
+                visit_expr(e, f);
+            }
+        }
+        TirExprKind::BoolOp { values: exprs, .. }
+        | TirExprKind::Call { args: exprs, .. }
+        | TirExprKind::Construct { args: exprs, .. }
+        | TirExprKind::List {
+            elements: exprs, ..
+        }
+        | TirExprKind::Set { elements: exprs } => {
+            for e in exprs {
+                visit_expr(e, f);
+            }
+        }
+        TirExprKind::Dict { keys, values, .. } => {
+            for e in keys.iter().chain(values) {
+                visit_expr(e, f);
+            }
+        }
+    }
+}
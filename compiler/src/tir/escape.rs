@@ -0,0 +1,395 @@
+//! Escape analysis
+//!
+//! Finds objects whose lifetime is bounded by the function that creates them, so
+//! codegen can place them in the creating function's frame instead of the heap.
+//!
+//! An object is stack-allocatable when it is created by the `Let` of a local
+//! that is never reassigned, and every use of that local is one of:
+//! - a field read or field store through it (`x.f`, `x.f = v`)
+//! - an argument to a function whose corresponding parameter does not escape
+//!
+//! Anything else - returning it, storing it in a variable, field or list, or
+//! passing it where it may be retained - makes the object escape.
+//!
+//! Parameter escape facts are computed as a fixpoint over the call graph, starting
+//! from "nothing escapes" and adding escapes until nothing changes, so recursion
+//! is handled. A call of a virtual method retains an argument if any of its
+//! overrides may.
+
+use std::collections::HashMap;
+
+use super::decls::TirFunction;
+use super::dispatch::ClassHierarchy;
+use super::expr::{TirExpr, TirExprKind, VarRef};
+use super::ids::{ClassId, FuncId, LocalId};
+use super::program::TirProgram;
+use super::stmt::{TirLValue, TirStmt};
+
+/// Runtime functions that never retain any of their arguments
+const NON_CAPTURING_RUNTIME_FUNCS: &[&str] = &[
+    // __iter__ copies the range into a fresh cursor
+    "__pyc___builtin___range___iter__",
+    "__pyc___builtin___range___next__",
+    "__pyc___builtin___range___len__",
+    "__pyc___builtin___range___str__",
+    "__pyc___builtin___range___repr__",
+    "__pyc___builtin___range___dealloc__",
+];
+
+/// The range `__iter__` called by for-loop desugaring
+const RANGE_ITER_FUNC: &str = "__pyc___builtin___range___iter__";
+
+/// The storage a stack-allocated object needs
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum StackObject {
+    /// An instance of a user class (constructed in place, then `__init__`)
+    Instance(ClassId),
+    /// A `range(...)` object or a for-loop cursor copied from one
+    Range,
+}
+
+/// Per-parameter escape facts for a whole program
+#[derive(Debug, Clone)]
+pub struct EscapeAnalysis {
+    /// Indexed by FuncId, then by call argument position (receiver first for methods)
+    args: Vec<Vec<bool>>,
+    /// Every implementation a call of a virtual method may run
+    overrides: HashMap<FuncId, Vec<FuncId>>,
+}
+
+impl EscapeAnalysis {
+    /// Compute which parameters of every function may escape
+    pub fn analyze(program: &TirProgram, hierarchy: &ClassHierarchy) -> Self {
+        let mut analysis = EscapeAnalysis {
+            args: program.functions.iter().map(runtime_arg_escapes).collect(),
+            overrides: hierarchy.override_sets(),
+        };
+
+        let mut changed = true;
+        while changed {
+            changed = false;
+            for func in &program.functions {
+                if func.runtime_name.is_some() {
+                    continue;
+                }
+                for pos in 0..analysis.args[func.id.index()].len() {
+                    if analysis.args[func.id.index()][pos] {
+                        continue;
+                    }
+                    let var = param_var(func, pos);
+                    if analysis.var_escapes(var, &func.body, program) {
+                        analysis.args[func.id.index()][pos] = true;
+                        changed = true;
+                    }
+                }
+            }
+        }
+
+        analysis
+    }
+
+    /// Whether the function may retain its argument at call position `pos`
+    pub fn arg_escapes(&self, func: FuncId, pos: usize) -> bool {
+        match self.overrides.get(&func) {
+            Some(targets) => targets.iter().any(|&target| self.own_arg_escapes(target, pos)),
+            None => self.own_arg_escapes(func, pos),
+        }
+    }
+
+    /// Whether the function body itself may retain its argument at `pos`
+    fn own_arg_escapes(&self, func: FuncId, pos: usize) -> bool {
+        self.args
+            .get(func.index())
+            .and_then(|args| args.get(pos))
+            .copied()
+            .unwrap_or(true)
+    }
+
+    /// Locals of a function or module body whose objects can live on the stack
+    pub fn stack_locals(
+        &self,
+        body: &[TirStmt],
+        program: &TirProgram,
+    ) -> HashMap<LocalId, StackObject> {
+        let mut candidates = HashMap::new();
+        let mut definitions: HashMap<LocalId, usize> = HashMap::new();
+        collect_definitions(body, program, &mut candidates, &mut definitions);
+
+        candidates
+            .into_iter()
+            .filter(|(local, kind)| {
+                definitions.get(local) == Some(&1)
+                    && self.construction_is_local(*kind, program)
+                    && !self.var_escapes(VarRef::Local(*local), body, program)
+            })
+            .collect()
+    }
+
+    /// Whether building the object in place can leak it (its `__init__` receives it)
+    fn construction_is_local(&self, kind: StackObject, program: &TirProgram) -> bool {
+        match kind {
+            StackObject::Instance(class) => program
+                .class(class)
+                .get_method("__init__")
+                .is_none_or(|init| !self.arg_escapes(init, 0)),
+            StackObject::Range => true,
+        }
+    }
+
+    fn var_escapes(&self, var: VarRef, body: &[TirStmt], program: &TirProgram) -> bool {
+        body.iter().any(|s| self.stmt_escapes(var, s, program))
+    }
+
+    fn stmt_escapes(&self, var: VarRef, stmt: &TirStmt, program: &TirProgram) -> bool {
+        match stmt {
+            TirStmt::Let { init, .. } => self.operand_escapes(var, init, program),
+            TirStmt::Assign { target, value } => {
+                self.lvalue_escapes(var, target, program)
+                    || self.operand_escapes(var, value, program)
+            }
+            TirStmt::AugAssign { target, value, .. } => {
+                *target == var || self.operand_escapes(var, value, program)
+            }
+            // A discarded `x` by itself is harmless
+            TirStmt::Expr(expr) => self.expr_escapes(var, expr, program),
+            TirStmt::Return(expr) => expr
+                .as_ref()
+                .is_some_and(|e| self.operand_escapes(var, e, program)),
+            TirStmt::If {
+                cond,
+                then_body,
+                else_body,
+            } => {
+                self.operand_escapes(var, cond, program)
+                    || self.var_escapes(var, then_body, program)
+                    || self.var_escapes(var, else_body, program)
+            }
+            TirStmt::While { cond, body } => {
+                self.operand_escapes(var, cond, program) || self.var_escapes(var, body, program)
+            }
+            TirStmt::ForRange {
+                start, stop, body, ..
+            } => {
+                self.operand_escapes(var, start, program)
+                    || self.operand_escapes(var, stop, program)
+                    || self.var_escapes(var, body, program)
+            }
+            TirStmt::ForList { iterable, body, .. } => {
+                self.operand_escapes(var, iterable, program) || self.var_escapes(var, body, program)
+            }
+            TirStmt::Try {
+                body,
+                handlers,
+                orelse,
+                finalbody,
+            } => {
+                self.var_escapes(var, body, program)
+                    || handlers
+                        .iter()
+                        .any(|h| self.var_escapes(var, &h.body, program))
+                    || self.var_escapes(var, orelse, program)
+                    || self.var_escapes(var, finalbody, program)
+            }
+            TirStmt::Raise { exc } => exc
+                .as_ref()
+                .is_some_and(|e| self.operand_escapes(var, e, program)),
+        }
+    }
+
+    /// Whether `var` escapes through an expression whose value is kept or consumed
+    /// (a bare `var` here escapes)
+    fn operand_escapes(&self, var: VarRef, expr: &TirExpr, program: &TirProgram) -> bool {
+        is_var(expr, var) || self.expr_escapes(var, expr, program)
+    }
+
+    /// Whether evaluating the expression lets `var` escape through one of its
+    /// subexpressions. Only field accesses and non-escaping call arguments may
+    /// use a bare `var`.
+    fn expr_escapes(&self, var: VarRef, expr: &TirExpr, program: &TirProgram) -> bool {
+        let operand = |e: &TirExpr| self.operand_escapes(var, e, program);
+        match &expr.kind {
+            TirExprKind::Constant(_) | TirExprKind::Var(_) | TirExprKind::Bytes { .. } => false,
+            TirExprKind::BinOp { left, right, .. } | TirExprKind::Compare { left, right, .. } => {
+                operand(left) || operand(right)
+            }
+            TirExprKind::BoolOp { values, .. } => values.iter().any(operand),
+            TirExprKind::UnaryOp { operand: inner, .. } => operand(inner),
+            TirExprKind::Call { func, args } => args.iter().enumerate().any(|(pos, arg)| {
+                if is_var(arg, var) {
+                    self.arg_escapes(*func, pos)
+                } else {
+                    self.expr_escapes(var, arg, program)
+                }
+            }),
+            TirExprKind::Construct { class, args } => {
+                // Constructor arguments become __init__ arguments after self
+                let init = user_init(*class, program);
+                args.iter().enumerate().any(|(pos, arg)| {
+                    if is_var(arg, var) {
+                        init.is_none_or(|init| self.arg_escapes(init, pos + 1))
+                    } else {
+                        self.expr_escapes(var, arg, program)
+                    }
+                })
+            }
+            TirExprKind::Range { start, stop, step } => {
+                start.as_deref().is_some_and(operand)
+                    || operand(stop)
+                    || step.as_deref().is_some_and(operand)
+            }
+            TirExprKind::FieldAccess { object, .. } => self.expr_escapes(var, object, program),
+            TirExprKind::List { elements, .. } | TirExprKind::Set { elements } => {
+                elements.iter().any(operand)
+            }
+            TirExprKind::Dict { keys, values } => keys.iter().chain(values).any(operand),
+        }
+    }
+
+    fn lvalue_escapes(&self, var: VarRef, lvalue: &TirLValue, program: &TirProgram) -> bool {
+        match lvalue {
+            // Rebinding the variable is handled by the single-definition check
+            TirLValue::Var(target) => *target == var,
+            TirLValue::Field { object, .. } => self.expr_escapes(var, object, program),
+        }
+    }
+}
+
+fn is_var(expr: &TirExpr, var: VarRef) -> bool {
+    matches!(expr.kind, TirExprKind::Var(v) if v == var)
+}
+
+/// The variable a function body uses for its argument at call position `pos`
+fn param_var(func: &TirFunction, pos: usize) -> VarRef {
+    match (func.class.is_some(), pos) {
+        (true, 0) => VarRef::SelfRef,
+        (true, pos) => VarRef::Param((pos - 1) as u32),
+        (false, pos) => VarRef::Param(pos as u32),
+    }
+}
+
+fn runtime_arg_escapes(func: &TirFunction) -> Vec<bool> {
+    let arity = func.params.len() + usize::from(func.class.is_some());
+    let escapes = func
+        .runtime_name
+        .as_deref()
+        .is_some_and(|name| !NON_CAPTURING_RUNTIME_FUNCS.contains(&name));
+    vec![escapes; arity]
+}
+
+/// The `__init__` of a user class that codegen constructs with `class_new`.
+/// Builtin and exception classes are built by the runtime, which keeps its
+/// arguments, so they report None and never become stack objects.
+fn user_init(class: ClassId, program: &TirProgram) -> Option<FuncId> {
+    if stack_instance_class(class, program) {
+        program.class(class).get_method("__init__")
+    } else {
+        None
+    }
+}
+
+fn stack_instance_class(class: ClassId, program: &TirProgram) -> bool {
+    let mut current = Some(class);
+    while let Some(id) = current {
+        let class_def = program.class(id);
+        if class_def.qualified_name.starts_with("__builtin__.") {
+            return false;
+        }
+        current = class_def.parent;
+    }
+    true
+}
+
+/// The object a `Let` initializer creates, if it is one codegen can build in place
+fn stack_object(init: &TirExpr, program: &TirProgram) -> Option<StackObject> {
+    match &init.kind {
+        TirExprKind::Construct { class, .. } if stack_instance_class(*class, program) => {
+            Some(StackObject::Instance(*class))
+        }
+        TirExprKind::Range { .. } => Some(StackObject::Range),
+        TirExprKind::Call { func, .. }
+            if program.function(*func).runtime_name.as_deref() == Some(RANGE_ITER_FUNC) =>
+        {
+            Some(StackObject::Range)
+        }
+        _ => None,
+    }
+}
+
+fn define(definitions: &mut HashMap<LocalId, usize>, local: LocalId) {
+    *definitions.entry(local).or_insert(0) += 1;
+}
+
+/// Record stack-object candidates and count every definition of each local
+fn collect_definitions(
+    body: &[TirStmt],
+    program: &TirProgram,
+    candidates: &mut HashMap<LocalId, StackObject>,
+    definitions: &mut HashMap<LocalId, usize>,
+) {
+    for stmt in body {
+        match stmt {
+            TirStmt::Let { local, init, .. } => {
+                define(definitions, *local);
+                if let Some(kind) = stack_object(init, program) {
+                    candidates.insert(*local, kind);
+                }
+            }
+            TirStmt::Assign {
+                target: TirLValue::Var(VarRef::Local(local)),
+                ..
+            }
+            | TirStmt::AugAssign {
+                target: VarRef::Local(local),
+                ..
+            } => define(definitions, *local),
+            TirStmt::ForRange {
+                target,
+                counter,
+                body,
+                ..
+            } => {
+                define(definitions, *target);
+                define(definitions, *counter);
+                collect_definitions(body, program, candidates, definitions);
+            }
+            TirStmt::ForList {
+                target,
+                index,
+                body,
+                ..
+            } => {
+                define(definitions, *target);
+                define(definitions, *index);
+                collect_definitions(body, program, candidates, definitions);
+            }
+            TirStmt::If {
+                then_body,
+                else_body,
+                ..
+            } => {
+                collect_definitions(then_body, program, candidates, definitions);
+                collect_definitions(else_body, program, candidates, definitions);
+            }
+            TirStmt::While { body, .. } => {
+                collect_definitions(body, program, candidates, definitions);
+            }
+            TirStmt::Try {
+                body,
+                handlers,
+                orelse,
+                finalbody,
+            } => {
+                collect_definitions(body, program, candidates, definitions);
+                for handler in handlers {
+                    if let Some(local) = handler.local {
+                        define(definitions, local);
+                    }
+                    collect_definitions(&handler.body, program, candidates, definitions);
+                }
+                collect_definitions(orelse, program, candidates, definitions);
+                collect_definitions(finalbody, program, candidates, definitions);
+            }
+            _ => {}
+        }
+    }
+}
@@ -0,0 +1,98 @@
+//! Exception type ids
+//!
+//! Numbers every class descending from `Exception` so that an `except` clause
+//! matches with two integer compares instead of comparing class names.
+//!
+//! The numbers are a preorder walk of the exception hierarchy, rooted at
+//! `Exception`, visiting children in ClassId order. The descendants of a class
+//! then occupy the ids right after its own, so class `C` catches an exception
+//! with id `x` exactly when `first(C) <= x <= last(C)`, where `last(C)` is the
+//! largest id in its subtree. Raised exceptions carry only their class's id.
+//!
+//! User classes may inherit from the builtin errors, which moves their ids
+//! around, so the runtime reads the ids of the exceptions it raises itself from
+//! a table the compiler emits (see RUNTIME_EXCEPTIONS).
+
+use super::ids::ClassId;
+use super::program::TirProgram;
+
+/// Exceptions the runtime raises itself, in the order of `RtExceptionKind`
+/// (runtime/src/exception.h)
+pub const RUNTIME_EXCEPTIONS: &[&str] = &[
+    "Exception",
+    "StopIteration",
+    "KeyError",
+    "ValueError",
+    "OverflowError",
+    "OSError",
+    "FileNotFoundError",
+];
+
+/// Id ranges of the exception classes of a program
+#[derive(Debug, Clone, Default)]
+pub struct ExceptionIds {
+    /// Indexed by ClassId: (own id, last id in the subtree), None for other classes
+    ranges: Vec<Option<(i64, i64)>>,
+}
+
+impl ExceptionIds {
+    /// Number the exception classes of the program
+    pub fn analyze(program: &TirProgram) -> Self {
+        let mut children: Vec<Vec<ClassId>> = vec![Vec::new(); program.classes.len()];
+        for class in &program.classes {
+            if let Some(parent) = class.parent {
+                children[parent.index()].push(class.id);
+            }
+        }
+
+        let mut ids = ExceptionIds {
+            ranges: vec![None; program.classes.len()],
+        };
+        let root = program
+            .classes
+            .iter()
+            .find(|class| class.qualified_name == "__builtin__.Exception");
+        if let Some(root) = root {
+            let mut next = 0;
+            ids.number(root.id, &children, &mut next);
+        }
+        ids
+    }
+
+    /// Give `class` the next id and its descendants the ids after it
+    fn number(&mut self, class: ClassId, children: &[Vec<ClassId>], next: &mut i64) {
+        let first = *next;
+        *next += 1;
+        for &child in &children[class.index()] {
+            self.number(child, children, next);
+        }
+        self.ranges[class.index()] = Some((first, *next - 1));
+    }
+
+    /// The id carried by exceptions of `class`, None if it is not an exception
+    pub fn get(&self, class: ClassId) -> Option<i64> {
+        self.range(class).map(|(first, _)| first)
+    }
+
+    /// The ids of `class` and its descendants: (first, last), both inclusive
+    pub fn range(&self, class: ClassId) -> Option<(i64, i64)> {
+        self.ranges.get(class.index()).copied().flatten()
+    }
+
+    /// The ids of RUNTIME_EXCEPTIONS, in order. The lowering always creates
+    /// these classes; one missing from the program gets an id no class catches.
+    pub fn runtime_ids(&self, program: &TirProgram) -> Vec<i64> {
+        RUNTIME_EXCEPTIONS
+            .iter()
+            .map(|name| {
+                let qualified_name = format!("__builtin__.{}", name);
+                program
+                    .classes
+                    .iter()
+                    .find(|class| class.qualified_name == qualified_name)
+                    .and_then(|class| self.get(class.id))
+                    .unwrap_or(-1)
+            })
+            .collect()
+    }
+}
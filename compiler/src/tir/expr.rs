@@ -119,6 +119,16 @@ pub enum TirExprKind {
         elem_ty: TirType,
     },
 
+    /// Dict literal: {k1: v1, k2: v2}
+    /// keys[i] maps to values[i]; the dict type is the expression's type
+    Dict {
+        keys: Vec<TirExpr>,
+        values: Vec<TirExpr>,
+    },
+
+    /// Set literal: {a, b, c}
+    Set { elements: Vec<TirExpr> },
+
     /// Bytes literal: b"hello"
     Bytes { data: Vec<u8> },
 }
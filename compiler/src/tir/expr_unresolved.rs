@@ -93,6 +93,16 @@ pub enum TirExprKindUnresolved {
         elem_ty: TirTypeUnresolved,
     },
 
+    /// Dict literal: {k1: v1, k2: v2}
+    /// keys[i] maps to values[i]; the dict type is the expression's type
+    Dict {
+        keys: Vec<TirExprUnresolved>,
+        values: Vec<TirExprUnresolved>,
+    },
+
+    /// Set literal: {a, b, c}
+    Set { elements: Vec<TirExprUnresolved> },
+
     /// Bytes literal: b"hello"
     Bytes { data: Vec<u8> },
 }
@@ -0,0 +1,557 @@
+//! Constant folding
+//!
+//! Replaces expressions whose value is known at compile time with constants:
+//! arithmetic, comparisons and boolean operators over constants, concatenation
+//! of string literals, and calls of pure functions (see `purity`) with constant
+//! arguments, which are evaluated by interpreting their TIR. A module-level
+//! `TABLE_SIZE: int = fib(20)` is then a constant in the binary.
+//!
+//! Folding computes exactly what the generated code would: `int` arithmetic
+//! wraps at 64 bits and `//` and `%` truncate, as in codegen. Whatever codegen
+//! leaves undefined or hands to the runtime (division by zero, shifts by 64 or
+//! more, float `**`) is not folded. Evaluation gives up on calls that run for
+//! too long, recurse too deep or build very long strings, and those calls are
+//! left to run at startup.
+
+use std::collections::HashMap;
+
+use crate::ast::{BinOperator, BoolOp, CompareOp, UnaryOp};
+
+use super::decls::TirFunction;
+use super::expr::{TirConstant, TirExpr, TirExprKind, VarRef};
+use super::ids::FuncId;
+use super::program::TirProgram;
+use super::purity::Purity;
+use super::stmt::{TirLValue, TirStmt};
+use super::types::TirType;
+
+/// Statements and expressions one folded call may evaluate
+const CALL_FUEL: u64 = 1_000_000;
+
+/// Statements and expressions evaluated for the whole program
+const PROGRAM_FUEL: u64 = 20_000_000;
+
+/// Deepest call nesting evaluated
+const MAX_DEPTH: u32 = 200;
+
+/// Longest string a folded expression may produce
+const MAX_STR_LEN: usize = 1 << 16;
+
+/// Fold the constant expressions of every function and module body
+pub fn fold_program(program: &mut TirProgram) {
+    let purity = Purity::analyze(program);
+    // Calls are evaluated on the bodies as lowered while they are being folded
+    let functions = program.functions.clone();
+    let mut folder = Folder {
+        eval: Evaluator::new(&functions, &purity),
+    };
+    for func in &mut program.functions {
+        folder.body(&mut func.body);
+    }
+    for module in &mut program.modules {
+        folder.body(&mut module.init_body);
+    }
+}
+
+struct Folder<'a> {
+    eval: Evaluator<'a>,
+}
+
+impl Folder<'_> {
+    fn body(&mut self, stmts: &mut [TirStmt]) {
+        for stmt in stmts {
+            self.stmt(stmt);
+        }
+    }
+
+    fn stmt(&mut self, stmt: &mut TirStmt) {
+        match stmt {
+            TirStmt::Let { init: expr, .. }
+            | TirStmt::AugAssign { value: expr, .. }
+            | TirStmt::Expr(expr)
+            | TirStmt::Return(Some(expr))
+            | TirStmt::Raise { exc: Some(expr) } => self.expr(expr),
+            TirStmt::Assign { target, value } => {
+                if let TirLValue::Field { object, .. } = target {
+                    self.expr(object);
+                }
+                self.expr(value);
+            }
+            TirStmt::If {
+                cond,
+                then_body,
+                else_body,
+            } => {
+                self.expr(cond);
+                self.body(then_body);
+                self.body(else_body);
+            }
+            TirStmt::While { cond, body } => {
+                self.expr(cond);
+                self.body(body);
+            }
+            TirStmt::ForRange {
+                start, stop, body, ..
+            } => {
+                self.expr(start);
+                self.expr(stop);
+                self.body(body);
+            }
+            TirStmt::ForList { iterable, body, .. } => {
+                self.expr(iterable);
+                self.body(body);
+            }
+            TirStmt::Try {
+                body,
+                handlers,
+                orelse,
+                finalbody,
+            } => {
+                self.body(body);
+                for handler in handlers {
+                    self.body(&mut handler.body);
+                }
+                self.body(orelse);
+                self.body(finalbody);
+            }
+            TirStmt::Return(None) | TirStmt::Raise { exc: None } => {}
+        }
+    }
+
+    /// Fold the subexpressions, then the expression itself
+    fn expr(&mut self, expr: &mut TirExpr) {
+        match &mut expr.kind {
+            TirExprKind::Constant(_) | TirExprKind::Var(_) | TirExprKind::Bytes { .. } => {}
+            TirExprKind::BinOp { left, right, .. } | TirExprKind::Compare { left, right, .. } => {
+                self.expr(left);
+                self.expr(right);
+            }
+            TirExprKind::UnaryOp { operand, .. } => self.expr(operand),
+            TirExprKind::FieldAccess { object, .. } => self.expr(object),
+            TirExprKind::Range { start, stop, step } => {
+                for e in start.iter_mut().chain(Some(stop)).chain(step.iter_mut()) {
+                    self.expr(e);
+                }
+            }
+            TirExprKind::BoolOp { values: exprs, .. }
+            | TirExprKind::Call { args: exprs, .. }
+            | TirExprKind::Construct { args: exprs, .. }
+            | TirExprKind::List {
+                elements: exprs, ..
+            }
+            | TirExprKind::Set { elements: exprs } => {
+                for e in exprs {
+                    self.expr(e);
+                }
+            }
+            TirExprKind::Dict { keys, values } => {
+                for e in keys.iter_mut().chain(values.iter_mut()) {
+                    self.expr(e);
+                }
+            }
+        }
+
+        let value = match &expr.kind {
+            TirExprKind::BinOp { left, op, right } => {
+                binop(constant(left), *op, constant(right), &expr.ty)
+            }
+            TirExprKind::Compare { left, op, right } => {
+                compare(constant(left), *op, constant(right))
+            }
+            TirExprKind::UnaryOp { op, operand } => unary(*op, constant(operand)),
+            TirExprKind::BoolOp { op, values } => boolop(*op, values),
+            TirExprKind::Call { func, args } if self.eval.purity.func(*func) => args
+                .iter()
+                .map(|arg| constant(arg).cloned())
+                .collect::<Option<Vec<_>>>()
+                .and_then(|args| self.eval.call_site(*func, args)),
+            _ => None,
+        };
+        if let Some(value) = value.filter(|value| fits(value, &expr.ty)) {
+            expr.kind = TirExprKind::Constant(value);
+        }
+    }
+}
+
+fn constant(expr: &TirExpr) -> Option<&TirConstant> {
+    match &expr.kind {
+        TirExprKind::Constant(value) => Some(value),
+        _ => None,
+    }
+}
+
+/// Whether a folded value can replace an expression of the type
+fn fits(value: &TirConstant, ty: &TirType) -> bool {
+    match (value, ty) {
+        (TirConstant::Int(_), TirType::Int)
+        | (TirConstant::Float(_), TirType::Float)
+        | (TirConstant::Bool(_), TirType::Bool) => true,
+        (TirConstant::Str(s), TirType::Class(_)) => s.len() <= MAX_STR_LEN,
+        _ => false,
+    }
+}
+
+/// A binary operation as codegen computes it
+fn binop(
+    left: Option<&TirConstant>,
+    op: BinOperator,
+    right: Option<&TirConstant>,
+    ty: &TirType,
+) -> Option<TirConstant> {
+    use TirConstant::{Float, Int, Str};
+    let (left, right) = (left?, right?);
+    if let (Str(l), Str(r)) = (left, right) {
+        return (op == BinOperator::Add && l.len() + r.len() <= MAX_STR_LEN)
+            .then(|| Str(format!("{l}{r}")));
+    }
+    if *ty == TirType::Float || matches!(left, Float(_)) || matches!(right, Float(_)) {
+        let (l, r) = (as_float(left)?, as_float(right)?);
+        let value = match op {
+            BinOperator::Add => l + r,
+            BinOperator::Sub => l - r,
+            BinOperator::Mult => l * r,
+            BinOperator::Div => l / r,
+            BinOperator::FloorDiv => (l / r).floor(),
+            BinOperator::Mod => l % r,
+            // llvm.pow is left to the target's libm
+            _ => return None,
+        };
+        return Some(Float(value));
+    }
+    let (Int(l), Int(r)) = (left, right) else {
+        return None;
+    };
+    let (l, r) = (*l, *r);
+    let value = match op {
+        BinOperator::Add => l.wrapping_add(r),
+        BinOperator::Sub => l.wrapping_sub(r),
+        BinOperator::Mult => l.wrapping_mul(r),
+        // sdiv and srem: truncating, undefined on zero and MIN / -1
+        BinOperator::Div | BinOperator::FloorDiv => l.checked_div(r)?,
+        BinOperator::Mod => l.checked_rem(r)?,
+        BinOperator::LShift => l.checked_shl(u32::try_from(r).ok()?)?,
+        BinOperator::RShift => l.checked_shr(u32::try_from(r).ok()?)?,
+        BinOperator::BitOr => l | r,
+        BinOperator::BitXor => l ^ r,
+        BinOperator::BitAnd => l & r,
+        BinOperator::Pow => int_pow(l, r),
+    };
+    Some(Int(value))
+}
+
+/// Exponentiation by squaring, as `codegen_pow` emits it: 1 for exponents
+/// below 1, wrapping on overflow
+fn int_pow(mut base: i64, mut exp: i64) -> i64 {
+    let mut result: i64 = 1;
+    while exp > 0 {
+        if exp & 1 != 0 {
+            result = result.wrapping_mul(base);
+        }
+        base = base.wrapping_mul(base);
+        exp >>= 1;
+    }
+    result
+}
+
+fn as_float(value: &TirConstant) -> Option<f64> {
+    match value {
+        TirConstant::Int(n) => Some(*n as f64),
+        TirConstant::Float(x) => Some(*x),
+        _ => None,
+    }
+}
+
+/// A comparison as codegen computes it: floats with ordered predicates, so any
+/// comparison with NaN is false
+fn compare(
+    left: Option<&TirConstant>,
+    op: CompareOp,
+    right: Option<&TirConstant>,
+) -> Option<TirConstant> {
+    use std::cmp::Ordering;
+    use TirConstant::{Bool, Float, Int, Str};
+    let (left, right) = (left?, right?);
+    let ordering = match (left, right) {
+        (Str(l), Str(r)) => Some(l.cmp(r)),
+        (Int(l), Int(r)) => Some(l.cmp(r)),
+        (Bool(l), Bool(r)) => Some(l.cmp(r)),
+        (Float(_), Int(_) | Float(_)) | (Int(_), Float(_)) => {
+            as_float(left)?.partial_cmp(&as_float(right)?)
+        }
+        _ => return None,
+    };
+    let result = match (op, ordering) {
+        (CompareOp::In | CompareOp::NotIn, _) => return None,
+        (_, None) => false,
+        (CompareOp::Eq, Some(o)) => o == Ordering::Equal,
+        (CompareOp::NotEq, Some(o)) => o != Ordering::Equal,
+        (CompareOp::Lt, Some(o)) => o == Ordering::Less,
+        (CompareOp::LtE, Some(o)) => o != Ordering::Greater,
+        (CompareOp::Gt, Some(o)) => o == Ordering::Greater,
+        (CompareOp::GtE, Some(o)) => o != Ordering::Less,
+    };
+    Some(TirConstant::Bool(result))
+}
+
+fn unary(op: UnaryOp, operand: Option<&TirConstant>) -> Option<TirConstant> {
+    match (op, operand?) {
+        (UnaryOp::Not, value) => Some(TirConstant::Bool(!truthy(value)?)),
+        (UnaryOp::USub, TirConstant::Int(n)) => Some(TirConstant::Int(n.wrapping_neg())),
+        (UnaryOp::USub, TirConstant::Float(x)) => Some(TirConstant::Float(-x)),
+        _ => None,
+    }
+}
+
+/// `and`/`or` with short-circuiting: known once a constant operand decides it,
+/// or once every operand is a constant
+fn boolop(op: BoolOp, values: &[TirExpr]) -> Option<TirConstant> {
+    let deciding = op == BoolOp::Or;
+    for value in values {
+        if truthy(constant(value)?)? == deciding {
+            return Some(TirConstant::Bool(deciding));
+        }
+    }
+    Some(TirConstant::Bool(!deciding))
+}
+
+/// Truth value of an `int` or `bool` (compared to zero, as `convert_to_bool`)
+fn truthy(value: &TirConstant) -> Option<bool> {
+    match value {
+        TirConstant::Bool(b) => Some(*b),
+        TirConstant::Int(n) => Some(*n != 0),
+        _ => None,
+    }
+}
+
+/// Interpreter for the bodies of pure functions
+struct Evaluator<'a> {
+    /// Indexed by FuncId
+    functions: &'a [TirFunction],
+    purity: &'a Purity,
+    /// Evaluation steps left for the program, then for the current call site
+    program_fuel: u64,
+    fuel: u64,
+    depth: u32,
+    /// Results of evaluated calls, None once a call gave up
+    results: HashMap<(FuncId, String), Option<TirConstant>>,
+}
+
+/// How control leaves a statement
+enum Flow {
+    Next,
+    Return(TirConstant),
+}
+
+/// Values of a call's parameters and locals
+struct Frame {
+    params: Vec<TirConstant>,
+    locals: Vec<Option<TirConstant>>,
+}
+
+impl Frame {
+    fn get(&self, var: &VarRef) -> Option<TirConstant> {
+        match var {
+            VarRef::Local(local) => self.locals.get(local.index())?.clone(),
+            VarRef::Param(index) => self.params.get(*index as usize).cloned(),
+            VarRef::Global(..) | VarRef::SelfRef => None,
+        }
+    }
+
+    fn set(&mut self, var: &VarRef, value: TirConstant) -> Option<()> {
+        match var {
+            VarRef::Local(local) => *self.locals.get_mut(local.index())? = Some(value),
+            VarRef::Param(index) => *self.params.get_mut(*index as usize)? = value,
+            VarRef::Global(..) | VarRef::SelfRef => return None,
+        }
+        Some(())
+    }
+}
+
+impl<'a> Evaluator<'a> {
+    fn new(functions: &'a [TirFunction], purity: &'a Purity) -> Self {
+        Evaluator {
+            functions,
+            purity,
+            program_fuel: PROGRAM_FUEL,
+            fuel: 0,
+            depth: 0,
+            results: HashMap::new(),
+        }
+    }
+
+    /// Evaluate a call found in the program, within the fuel of one call site
+    fn call_site(&mut self, func: FuncId, args: Vec<TirConstant>) -> Option<TirConstant> {
+        self.fuel = CALL_FUEL.min(self.program_fuel);
+        let start = self.fuel;
+        let result = self.call(func, args);
+        self.program_fuel -= start - self.fuel;
+        result
+    }
+
+    fn call(&mut self, func: FuncId, args: Vec<TirConstant>) -> Option<TirConstant> {
+        let key = (func, format!("{args:?}"));
+        if let Some(result) = self.results.get(&key) {
+            return result.clone();
+        }
+        if self.depth == MAX_DEPTH {
+            return None;
+        }
+        let func_def = &self.functions[func.index()];
+        // An int argument of a float parameter is converted by the call
+        let params = args
+            .into_iter()
+            .zip(&func_def.params)
+            .map(|(arg, (_, ty))| match (arg, ty) {
+                (TirConstant::Int(n), TirType::Float) => TirConstant::Float(n as f64),
+                (arg, _) => arg,
+            })
+            .collect();
+        let mut frame = Frame {
+            params,
+            locals: vec![None; func_def.locals.len()],
+        };
+        self.depth += 1;
+        let result = match self.body(&func_def.body, &mut frame) {
+            Some(Flow::Return(value)) => Some(value),
+            _ => None,
+        };
+        self.depth -= 1;
+        self.results.insert(key, result.clone());
+        result
+    }
+
+    fn step(&mut self) -> Option<()> {
+        self.fuel = self.fuel.checked_sub(1)?;
+        Some(())
+    }
+
+    fn body(&mut self, stmts: &[TirStmt], frame: &mut Frame) -> Option<Flow> {
+        for stmt in stmts {
+            if let Flow::Return(value) = self.stmt(stmt, frame)? {
+                return Some(Flow::Return(value));
+            }
+        }
+        Some(Flow::Next)
+    }
+
+    fn stmt(&mut self, stmt: &TirStmt, frame: &mut Frame) -> Option<Flow> {
+        self.step()?;
+        match stmt {
+            TirStmt::Let { local, init, .. } => {
+                let value = self.expr(init, frame)?;
+                frame.set(&VarRef::Local(*local), value)?;
+            }
+            TirStmt::Assign {
+                target: TirLValue::Var(var),
+                value,
+            } => {
+                let value = self.expr(value, frame)?;
+                frame.set(var, value)?;
+            }
+            // codegen updates an int in place
+            TirStmt::AugAssign { target, op, value } => {
+                let rhs = self.expr(value, frame)?;
+                let lhs = frame.get(target)?;
+                let result = binop(Some(&lhs), *op, Some(&rhs), &TirType::Int)?;
+                frame.set(target, result)?;
+            }
+            TirStmt::Expr(expr) => {
+                self.expr(expr, frame)?;
+            }
+            TirStmt::Return(Some(expr)) => return Some(Flow::Return(self.expr(expr, frame)?)),
+            TirStmt::If {
+                cond,
+                then_body,
+                else_body,
+            } => {
+                let branch = if truthy(&self.expr(cond, frame)?)? {
+                    then_body
+                } else {
+                    else_body
+                };
+                return self.body(branch, frame);
+            }
+            TirStmt::While { cond, body } => {
+                while truthy(&self.expr(cond, frame)?)? {
+                    if let Flow::Return(value) = self.body(body, frame)? {
+                        return Some(Flow::Return(value));
+                    }
+                }
+            }
+            TirStmt::ForRange {
+                target,
+                counter,
+                start,
+                stop,
+                step,
+                body,
+                ..
+            } => {
+                let TirConstant::Int(mut i) = self.expr(start, frame)? else {
+                    return None;
+                };
+                let TirConstant::Int(stop) = self.expr(stop, frame)? else {
+                    return None;
+                };
+                while (*step > 0 && i < stop) || (*step < 0 && i > stop) {
+                    self.step()?;
+                    frame.set(&VarRef::Local(*counter), TirConstant::Int(i))?;
+                    frame.set(&VarRef::Local(*target), TirConstant::Int(i))?;
+                    if let Flow::Return(value) = self.body(body, frame)? {
+                        return Some(Flow::Return(value));
+                    }
+                    i = i.checked_add(*step)?;
+                }
+            }
+            // Not pure
+            TirStmt::Assign { .. }
+            | TirStmt::Return(None)
+            | TirStmt::ForList { .. }
+            | TirStmt::Try { .. }
+            | TirStmt::Raise { .. } => return None,
+        }
+        Some(Flow::Next)
+    }
+
+    fn expr(&mut self, expr: &TirExpr, frame: &mut Frame) -> Option<TirConstant> {
+        self.step()?;
+        let value = match &expr.kind {
+            TirExprKind::Constant(value) => value.clone(),
+            TirExprKind::Var(var) => frame.get(var)?,
+            TirExprKind::BinOp { left, op, right } => {
+                let l = self.expr(left, frame)?;
+                let r = self.expr(right, frame)?;
+                binop(Some(&l), *op, Some(&r), &expr.ty)?
+            }
+            TirExprKind::Compare { left, op, right } => {
+                let l = self.expr(left, frame)?;
+                let r = self.expr(right, frame)?;
+                compare(Some(&l), *op, Some(&r))?
+            }
+            TirExprKind::UnaryOp { op, operand } => {
+                let operand = self.expr(operand, frame)?;
+                unary(*op, Some(&operand))?
+            }
+            TirExprKind::BoolOp { op, values } => {
+                let deciding = *op == BoolOp::Or;
+                let mut result = !deciding;
+                for value in values {
+                    if truthy(&self.expr(value, frame)?)? == deciding {
+                        result = deciding;
+                        break;
+                    }
+                }
+                TirConstant::Bool(result)
+            }
+            TirExprKind::Call { func, args } if self.purity.func(*func) => {
+                let args = args
+                    .iter()
+                    .map(|arg| self.expr(arg, frame))
+                    .collect::<Option<Vec<_>>>()?;
+                self.call(*func, args)?
+            }
+            _ => return None,
+        };
+        fits(&value, &expr.ty).then_some(value)
+    }
+}
@@ -0,0 +1,340 @@
+//! Class field layout
+//!
+//! Decides the order of the fields in each class's struct. By default a class is
+//! laid out in declaration order, inherited fields first. With reordering on,
+//! each class sorts its own fields by alignment, largest first, so `bool` fields
+//! (one byte) gather at the end instead of each padding out a word, and puts the
+//! most used fields of each alignment first.
+//!
+//! A subclass instance is accessed through its parent's struct type in inherited
+//! methods, so a class's layout always starts with its parent's layout unchanged,
+//! vtable pointer included. Only the fields a class declares itself move.
+//!
+//! Use is estimated statically: every field access in the program counts, eight
+//! times more for each loop it is nested in. Accesses through a subclass count
+//! for the class that declares the field.
+
+use std::cmp::Reverse;
+use std::collections::HashMap;
+use std::fmt::Write;
+
+use super::dispatch::{user_hierarchy, ClassHierarchy};
+use super::expr::{TirExpr, TirExprKind};
+use super::ids::{ClassId, FieldId};
+use super::program::TirProgram;
+use super::stmt::{TirLValue, TirStmt};
+use super::types::TirType;
+
+/// Deepest loop nesting that still weighs more
+const MAX_WEIGHTED_DEPTH: u32 = 4;
+
+/// The struct layouts of every class of a program
+#[derive(Debug, Clone, Default)]
+pub struct FieldLayout {
+    /// Indexed by ClassId: the fields in struct order
+    order: Vec<Vec<FieldId>>,
+    /// Indexed by ClassId, then FieldId: the struct index of the field
+    slots: Vec<Vec<u32>>,
+    /// Indexed by ClassId: whether the struct starts with a vtable pointer
+    vtable: Vec<bool>,
+}
+
+impl FieldLayout {
+    /// Lay out every class, reordering own fields when `reorder` is set
+    pub fn analyze(program: &TirProgram, hierarchy: &ClassHierarchy, reorder: bool) -> Self {
+        let uses = if reorder {
+            field_uses(program)
+        } else {
+            HashMap::new()
+        };
+        let mut layout = FieldLayout {
+            order: vec![Vec::new(); program.classes.len()],
+            slots: vec![Vec::new(); program.classes.len()],
+            vtable: program
+                .classes
+                .iter()
+                .map(|class| hierarchy.has_vtable(class.id))
+                .collect(),
+        };
+        let mut done = vec![false; program.classes.len()];
+        for class in &program.classes {
+            layout.lay_out(class.id, reorder, &uses, &mut done, program);
+        }
+        layout
+    }
+
+    /// Struct index of a field of the class
+    pub fn slot(&self, class: ClassId, field: FieldId) -> u32 {
+        self.slots[class.index()][field.index()]
+    }
+
+    /// The fields of the class, in struct order
+    pub fn fields(&self, class: ClassId) -> &[FieldId] {
+        &self.order[class.index()]
+    }
+
+    /// Whether the class's struct starts with a vtable pointer
+    pub fn has_vtable(&self, class: ClassId) -> bool {
+        self.vtable[class.index()]
+    }
+
+    /// Offset, size and name of every field of each user class, with the size
+    /// of the instance and of declaration order
+    pub fn report(&self, program: &TirProgram) -> String {
+        let mut report = String::new();
+        for class in &program.classes {
+            if class.qualified_name.starts_with("__builtin__.") {
+                continue;
+            }
+            let fields: Vec<_> = class.all_fields().collect();
+            let declared: Vec<FieldId> = (0..fields.len() as u32).map(FieldId).collect();
+            let vtable = self.has_vtable(class.id);
+            let (offsets, size) = struct_offsets(vtable, self.fields(class.id), &fields);
+            let (_, declared_size) = struct_offsets(vtable, &declared, &fields);
+            let _ = writeln!(
+                report,
+                "{}: {} bytes (declaration order: {} bytes)",
+                class.qualified_name, size, declared_size
+            );
+            if vtable {
+                let _ = writeln!(report, "  {:>4}  <vtable>", 0);
+            }
+            for (&field, offset) in self.fields(class.id).iter().zip(offsets) {
+                let (name, ty) = fields[field.index()];
+                let _ = writeln!(
+                    report,
+                    "  {:>4}  {}: {}",
+                    offset,
+                    name,
+                    type_name(ty, program)
+                );
+            }
+        }
+        report
+    }
+
+    fn lay_out(
+        &mut self,
+        class: ClassId,
+        reorder: bool,
+        uses: &HashMap<(ClassId, FieldId), u64>,
+        done: &mut [bool],
+        program: &TirProgram,
+    ) {
+        if done[class.index()] {
+            return;
+        }
+        done[class.index()] = true;
+        let class_def = program.class(class);
+        let mut order = match class_def.parent {
+            Some(parent) => {
+                self.lay_out(parent, reorder, uses, done, program);
+                self.order[parent.index()].clone()
+            }
+            None => Vec::new(),
+        };
+
+        let inherited = class_def.inherited_fields.len() as u32;
+        let own = class_def.fields.len() as u32;
+        let mut fields: Vec<FieldId> = (inherited..inherited + own).map(FieldId).collect();
+        if reorder && user_hierarchy(class, program) {
+            fields.sort_by_key(|&field| {
+                let (_, ty) = &class_def.fields[(field.0 - inherited) as usize];
+                let uses = uses.get(&(class, field)).copied().unwrap_or(0);
+                (Reverse(field_size(ty)), Reverse(uses), field.0)
+            });
+        }
+        order.extend(fields);
+
+        let first = self.vtable[class.index()] as u32;
+        let mut slots = vec![0; order.len()];
+        for (slot, field) in order.iter().enumerate() {
+            slots[field.index()] = first + slot as u32;
+        }
+        self.order[class.index()] = order;
+        self.slots[class.index()] = slots;
+    }
+}
+
+/// Size and alignment of a field of this type on the 64-bit targets
+fn field_size(ty: &TirType) -> u64 {
+    match ty {
+        TirType::Bool => 1,
+        TirType::Int | TirType::Float | TirType::Void | TirType::Class(_) => 8,
+    }
+}
+
+/// Offsets of the fields in this order, and the size of the struct
+fn struct_offsets(
+    vtable: bool,
+    order: &[FieldId],
+    fields: &[&(String, TirType)],
+) -> (Vec<u64>, u64) {
+    let mut offset: u64 = if vtable { 8 } else { 0 };
+    let mut align = offset.max(1);
+    let offsets = order
+        .iter()
+        .map(|field| {
+            let size = field_size(&fields[field.index()].1);
+            offset = offset.next_multiple_of(size);
+            let start = offset;
+            offset += size;
+            align = align.max(size);
+            start
+        })
+        .collect();
+    (offsets, offset.next_multiple_of(align))
+}
+
+fn type_name(ty: &TirType, program: &TirProgram) -> String {
+    match ty {
+        TirType::Int => "int".to_string(),
+        TirType::Float => "float".to_string(),
+        TirType::Bool => "bool".to_string(),
+        TirType::Void => "None".to_string(),
+        TirType::Class(id) => {
+            let name = &program.class(*id).qualified_name;
+            name.strip_prefix("__builtin__.")
+                .unwrap_or(name)
+                .to_string()
+        }
+    }
+}
+
+/// Weighted access counts of every field, by the class that declares it
+fn field_uses(program: &TirProgram) -> HashMap<(ClassId, FieldId), u64> {
+    let mut uses = FieldUses {
+        program,
+        counts: HashMap::new(),
+    };
+    for func in &program.functions {
+        uses.body(&func.body, 0);
+    }
+    for module in &program.modules {
+        uses.body(&module.init_body, 0);
+    }
+    uses.counts
+}
+
+struct FieldUses<'a> {
+    program: &'a TirProgram,
+    counts: HashMap<(ClassId, FieldId), u64>,
+}
+
+impl FieldUses<'_> {
+    fn count(&mut self, class: ClassId, field: FieldId, depth: u32) {
+        // Inherited fields are declared by the nearest ancestor that has them
+        let mut owner = class;
+        while inherits_field(self.program, owner, field) {
+            owner = self.program.class(owner).parent.unwrap();
+        }
+        *self.counts.entry((owner, field)).or_insert(0) += 8u64.pow(depth.min(MAX_WEIGHTED_DEPTH));
+    }
+
+    fn body(&mut self, stmts: &[TirStmt], depth: u32) {
+        for stmt in stmts {
+            match stmt {
+                TirStmt::Let { init: expr, .. }
+                | TirStmt::AugAssign { value: expr, .. }
+                | TirStmt::Expr(expr)
+                | TirStmt::Return(Some(expr))
+                | TirStmt::Raise { exc: Some(expr) } => self.expr(expr, depth),
+                TirStmt::Assign { target, value } => {
+                    if let TirLValue::Field {
+                        object,
+                        class,
+                        field,
+                    } = target
+                    {
+                        self.count(*class, *field, depth);
+                        self.expr(object, depth);
+                    }
+                    self.expr(value, depth);
+                }
+                TirStmt::If {
+                    cond,
+                    then_body,
+                    else_body,
+                } => {
+                    self.expr(cond, depth);
+                    self.body(then_body, depth);
+                    self.body(else_body, depth);
+                }
+                TirStmt::While { cond, body } => {
+                    self.expr(cond, depth + 1);
+                    self.body(body, depth + 1);
+                }
+                TirStmt::ForRange {
+                    start, stop, body, ..
+                } => {
+                    self.expr(start, depth);
+                    self.expr(stop, depth);
+                    self.body(body, depth + 1);
+                }
+                TirStmt::ForList { iterable, body, .. } => {
+                    self.expr(iterable, depth);
+                    self.body(body, depth + 1);
+                }
+                TirStmt::Try {
+                    body,
+                    handlers,
+                    orelse,
+                    finalbody,
+                } => {
+                    self.body(body, depth);
+                    for handler in handlers {
+                        self.body(&handler.body, depth);
+                    }
+                    self.body(orelse, depth);
+                    self.body(finalbody, depth);
+                }
+                TirStmt::Return(None) | TirStmt::Raise { exc: None } => {}
+            }
+        }
+    }
+
+    fn expr(&mut self, expr: &TirExpr, depth: u32) {
+        match &expr.kind {
+            TirExprKind::Constant(_) | TirExprKind::Var(_) | TirExprKind::Bytes { .. } => {}
+            TirExprKind::FieldAccess {
+                object,
+                class,
+                field,
+            } => {
+                self.count(*class, *field, depth);
+                self.expr(object, depth);
+            }
+            TirExprKind::BinOp { left, right, .. } | TirExprKind::Compare { left, right, .. } => {
+                self.expr(left, depth);
+                self.expr(right, depth);
+            }
+            TirExprKind::UnaryOp { operand, .. } => self.expr(operand, depth),
+            TirExprKind::Range { start, stop, step } => {
+                for e in start.iter().chain(Some(stop)).chain(step) {
+                    self.expr(e, depth);
+                }
+            }
+            TirExprKind::BoolOp { values: exprs, .. }
+            | TirExprKind::Call { args: exprs, .. }
+            | TirExprKind::Construct { args: exprs, .. }
+            | TirExprKind::List {
+                elements: exprs, ..
+            }
+            | TirExprKind::Set { elements: exprs } => {
+                for e in exprs {
+                    self.expr(e, depth);
+                }
+            }
+            TirExprKind::Dict { keys, values, .. } => {
+                for e in keys.iter().chain(values) {
+                    self.expr(e, depth);
+                }
+            }
+        }
+    }
+}
+
+/// Whether the class inherits the field from its parent
+fn inherits_field(program: &TirProgram, class: ClassId, field: FieldId) -> bool {
+    field.index() < program.class(class).inherited_fields.len()
+}
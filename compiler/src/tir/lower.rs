@@ -18,6 +18,7 @@ mod stmt_lowering;
 mod symbols;
 
 use body_lowerer::BodyLowerer;
+use builtins::BUILTIN_ERROR_CLASSES;
 use passes::{BodyLoweringPass, DefinitionCollector, ScopeBuilder};
 use std::collections::HashMap;
 use symbols::{ClassKey, GlobalSymbols};
@@ -45,8 +46,16 @@ pub fn lower_to_tir(
     module_order.sort_by(|a, b| a.0.cmp(&b.0));
 
     // Pre-create builtin classes that can be used as base classes
-    // This ensures Exception is available when user classes inherit from it
+    // This ensures Exception is available when user classes inherit from it,
+    // and gives every exception the runtime raises a type id
     symbols.get_or_create_exception_class();
+    symbols.get_or_create_stop_iteration_class();
+    for name in BUILTIN_ERROR_CLASSES {
+        symbols.get_or_create_builtin_error_class(name);
+    }
+    // open() results, which annotations name TextIO and BinaryIO
+    symbols.get_or_create_textio_class();
+    symbols.get_or_create_binaryio_class();
 
     // Collect all definitions (types, functions, methods, fields, globals)
     let mut collector = DefinitionCollector::new(&mut symbols);
@@ -178,7 +187,8 @@ pub fn lower_to_tir(
             tir_classes.push(TirClass {
                 id: class_id,
                 qualified_name: class_data.qualified_name.clone(),
-                parent: None, // Builtin classes don't have parents
+                // Only the builtin exceptions have one (Exception)
+                parent: class_data.parent,
                 inherited_fields: vec![],
                 fields: vec![],
                 methods,
@@ -238,10 +248,12 @@ pub fn lower_to_tir(
 
     let entry_mod_id = symbols.modules[&entry_name.0];
 
-    Ok(TirProgram {
+    let program = TirProgram {
         functions: tir_functions,
         classes: tir_classes,
         modules: tir_modules,
         entry: entry_mod_id,
-    })
+    };
+    super::parallel::check_program(&program)?;
+    Ok(program)
 }
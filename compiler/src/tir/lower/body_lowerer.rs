@@ -151,6 +151,17 @@ impl<'a> BodyLowerer<'a> {
                     .get_or_create_list_class(&elem_ty.to_tir_type());
                 TirTypeUnresolved::Class(class_id)
             }
+            ast::TypeAnnotation::Dict(key, value) => {
+                let key_ty = self.convert_annotation(key).to_tir_type();
+                let value_ty = self.convert_annotation(value).to_tir_type();
+                let class_id = self.symbols.get_or_create_dict_class(&key_ty, &value_ty);
+                TirTypeUnresolved::Class(class_id)
+            }
+            ast::TypeAnnotation::Set(inner) => {
+                let elem_ty = self.convert_annotation(inner);
+                let class_id = self.symbols.get_or_create_set_class(&elem_ty.to_tir_type());
+                TirTypeUnresolved::Class(class_id)
+            }
             ast::TypeAnnotation::ClassName(name) => {
                 // Look up class in scope
                 if let Some(&class_id) = self.scope.classes.get(name) {
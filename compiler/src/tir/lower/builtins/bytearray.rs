@@ -13,6 +13,8 @@ impl GlobalSymbols {
 
         let str_class_id = self.get_or_create_str_class();
         let str_type = TirType::Class(str_class_id);
+        let bytes_type = TirType::Class(self.get_or_create_bytes_class());
+        let bytearray_type = TirType::Class(class_id);
 
         register_methods!(self, class_id, "bytearray",
             shared "append" => (vec![TirType::Int], TirType::Void),
@@ -21,6 +23,9 @@ impl GlobalSymbols {
             shared "__repr__" => (vec![], str_type),
             shared "__getitem__" => (vec![TirType::Int], TirType::Int),
             shared "__setitem__" => (vec![TirType::Int, TirType::Int], TirType::Void),
+            shared "extend" => (vec![bytes_type.clone()], TirType::Void),
+            shared "__getslice__" => (vec![TirType::Int, TirType::Int], bytearray_type),
+            shared "find" => (vec![bytes_type], TirType::Int),
         );
 
         class_id
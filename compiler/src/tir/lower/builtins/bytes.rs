@@ -13,12 +13,17 @@ impl GlobalSymbols {
 
         let str_class_id = self.get_or_create_str_class();
         let str_type = TirType::Class(str_class_id);
+        let bytes_type = TirType::Class(class_id);
 
         register_methods!(self, class_id, "bytes",
             shared "__len__" => (vec![], TirType::Int),
             shared "__str__" => (vec![], str_type.clone()),
             shared "__repr__" => (vec![], str_type),
             shared "__getitem__" => (vec![TirType::Int], TirType::Int),
+            shared "__add__" => (vec![bytes_type.clone()], bytes_type.clone()),
+            shared "__getslice__" => (vec![TirType::Int, TirType::Int], bytes_type.clone()),
+            shared "find" => (vec![bytes_type.clone()], TirType::Int),
+            shared "count" => (vec![bytes_type], TirType::Int),
         );
 
         class_id
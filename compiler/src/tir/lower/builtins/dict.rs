@@ -0,0 +1,64 @@
+//! Dict built-in class implementation
+
+use crate::tir::ids::ClassId;
+use crate::tir::types::TirType;
+
+use super::super::symbols::{ClassKey, GlobalSymbols};
+
+impl GlobalSymbols {
+    /// Get or create a ClassId for a dict type with the given key and value types.
+    /// Each unique dict[K, V] gets its own ClassId.
+    pub(crate) fn get_or_create_dict_class(
+        &mut self,
+        key_type: &TirType,
+        value_type: &TirType,
+    ) -> ClassId {
+        // Check cache first using ClassKey
+        let key = ClassKey::builtin_generic("dict", vec![key_type.clone(), value_type.clone()]);
+        if let Some(&class_id) = self.classes.get(&key) {
+            return class_id;
+        }
+
+        // Allocate new class for this dict type
+        let class_id = self.alloc_class();
+        self.classes.insert(key, class_id);
+        self.class_data[class_id.index()].qualified_name = "__builtin__.dict".to_string();
+        self.class_data[class_id.index()].type_params = vec![key_type.clone(), value_type.clone()];
+
+        let str_class_id = self.get_or_create_str_class();
+        let str_type = TirType::Class(str_class_id);
+
+        let keys_type = TirType::Class(self.get_or_create_list_class(key_type));
+        let values_type = TirType::Class(self.get_or_create_list_class(value_type));
+
+        // Iterating a dict yields its keys
+        let dict_iter_class_id = self.get_or_create_dict_iterator_class(key_type);
+        let dict_iter_type = TirType::Class(dict_iter_class_id);
+
+        // Methods taking or returning a key or value are unique per dict[K, V];
+        // codegen picks the runtime kernel for the key storage
+        register_methods!(self, class_id, "dict",
+            unique "__setitem__" => (vec![key_type.clone(), value_type.clone()], TirType::Void),
+            unique "__getitem__" => (vec![key_type.clone()], value_type.clone()),
+            unique "__contains__" => (vec![key_type.clone()], TirType::Bool),
+            unique "get" => (vec![key_type.clone(), value_type.clone()], value_type.clone()),
+            unique "pop" => (vec![key_type.clone()], value_type.clone()),
+            unique "keys" => (vec![], keys_type),
+            unique "values" => (vec![], values_type),
+            unique "__iter__" => (vec![], dict_iter_type),
+            shared "__len__" => (vec![], TirType::Int),
+            shared "__str__" => (vec![], str_type.clone()),
+            shared "__repr__" => (vec![], str_type),
+        );
+
+        class_id
+    }
+
+    /// Check if a class ID corresponds to a dict[K, V] class.
+    pub(crate) fn is_dict_class(&self, class_id: ClassId) -> bool {
+        self.class_data
+            .get(class_id.index())
+            .map(|c| c.qualified_name == "__builtin__.dict")
+            .unwrap_or(false)
+    }
+}
@@ -5,6 +5,20 @@ use crate::tir::types::TirType;
 
 use super::super::symbols::{ClassKey, GlobalSymbols};
 
+/// Exceptions the runtime raises by name, beyond StopIteration:
+/// - KeyError: dict and set lookups of a missing key
+/// - ValueError: int() and float() of malformed text
+/// - OverflowError: int() of a value outside the int64 range
+/// - OSError: open() and file reads and writes that fail
+/// - FileNotFoundError: open() of a missing file, a subclass of OSError
+pub(crate) const BUILTIN_ERROR_CLASSES: &[&str] = &[
+    "KeyError",
+    "ValueError",
+    "OverflowError",
+    "OSError",
+    "FileNotFoundError",
+];
+
 impl GlobalSymbols {
     /// Get or create the ClassId for Exception type.
     pub(crate) fn get_or_create_exception_class(&mut self) -> ClassId {
@@ -56,4 +70,37 @@ impl GlobalSymbols {
 
         class_id
     }
+
+    /// Get or create the ClassId for a builtin error raised by the runtime
+    /// (one of BUILTIN_ERROR_CLASSES). Each inherits from Exception, except
+    /// FileNotFoundError, which inherits from OSError.
+    pub(crate) fn get_or_create_builtin_error_class(&mut self, name: &str) -> ClassId {
+        debug_assert!(BUILTIN_ERROR_CLASSES.contains(&name));
+        let key = ClassKey::builtin(name);
+        if let Some(&class_id) = self.classes.get(&key) {
+            return class_id;
+        }
+
+        let parent_id = match name {
+            "FileNotFoundError" => self.get_or_create_builtin_error_class("OSError"),
+            _ => self.get_or_create_exception_class(),
+        };
+
+        let class_id = self.alloc_class();
+        self.classes.insert(key, class_id);
+        self.class_data[class_id.index()].qualified_name = format!("__builtin__.{}", name);
+        self.set_parent(class_id, parent_id);
+
+        let str_class_id = self.get_or_create_str_class();
+        let str_type = TirType::Class(str_class_id);
+
+        // The runtime has no per-error functions: every exception object is
+        // an Exception, so these share the Exception functions
+        register_methods!(self, class_id, "Exception",
+            shared "__str__" => (vec![], str_type.clone()),
+            shared "__repr__" => (vec![], str_type),
+        );
+
+        class_id
+    }
 }
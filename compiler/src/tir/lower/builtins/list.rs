@@ -43,4 +43,12 @@ impl GlobalSymbols {
 
         class_id
     }
+
+    /// Check if a class ID corresponds to a list[T] class.
+    pub(crate) fn is_list_class(&self, class_id: ClassId) -> bool {
+        self.class_data
+            .get(class_id.index())
+            .map(|c| c.qualified_name == "__builtin__.list")
+            .unwrap_or(false)
+    }
 }
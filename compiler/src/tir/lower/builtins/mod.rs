@@ -1,7 +1,7 @@
 //! Built-in class definitions for GlobalSymbols
 //!
 //! This module contains the implementation of built-in Python types
-//! (list, bytearray, bytes, str) as separate files for better organization.
+//! (list, dict, set, bytearray, bytes, str, files) as separate files for better organization.
 
 /// Register methods on a builtin class with auto-incrementing MethodId.
 /// Supports both shared and unique methods for generic types.
@@ -109,10 +109,16 @@ macro_rules! init_builtin_class {
 
 mod bytearray;
 mod bytes;
+mod dict;
+mod dict_iterator;
 mod exception;
 mod list;
 mod list_iterator;
 mod range;
+mod set;
+mod set_iterator;
 mod str_class;
+mod textio;
 
-// Re-export nothing - all methods are impl blocks on GlobalSymbols
+// Everything else is impl blocks on GlobalSymbols
+pub(crate) use exception::BUILTIN_ERROR_CLASSES;
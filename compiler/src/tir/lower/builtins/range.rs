@@ -30,4 +30,12 @@ impl GlobalSymbols {
 
         class_id
     }
+
+    /// Check if a class ID corresponds to the range class.
+    pub(crate) fn is_range_class(&self, class_id: ClassId) -> bool {
+        self.class_data
+            .get(class_id.index())
+            .map(|c| c.qualified_name == "__builtin__.range")
+            .unwrap_or(false)
+    }
 }
@@ -0,0 +1,51 @@
+//! Set built-in class implementation
+
+use crate::tir::ids::ClassId;
+use crate::tir::types::TirType;
+
+use super::super::symbols::{ClassKey, GlobalSymbols};
+
+impl GlobalSymbols {
+    /// Get or create a ClassId for a set type with the given element type.
+    /// Each unique set[T] gets its own ClassId.
+    pub(crate) fn get_or_create_set_class(&mut self, element_type: &TirType) -> ClassId {
+        // Check cache first using ClassKey
+        let key = ClassKey::builtin_generic("set", vec![element_type.clone()]);
+        if let Some(&class_id) = self.classes.get(&key) {
+            return class_id;
+        }
+
+        // Allocate new class for this set type
+        let class_id = self.alloc_class();
+        self.classes.insert(key, class_id);
+        self.class_data[class_id.index()].qualified_name = "__builtin__.set".to_string();
+        self.class_data[class_id.index()].type_params = vec![element_type.clone()];
+
+        let str_class_id = self.get_or_create_str_class();
+        let str_type = TirType::Class(str_class_id);
+
+        let set_iter_class_id = self.get_or_create_set_iterator_class(element_type);
+        let set_iter_type = TirType::Class(set_iter_class_id);
+
+        register_methods!(self, class_id, "set",
+            unique "add" => (vec![element_type.clone()], TirType::Void),
+            unique "__contains__" => (vec![element_type.clone()], TirType::Bool),
+            unique "discard" => (vec![element_type.clone()], TirType::Void),
+            unique "remove" => (vec![element_type.clone()], TirType::Void),
+            unique "__iter__" => (vec![], set_iter_type),
+            shared "__len__" => (vec![], TirType::Int),
+            shared "__str__" => (vec![], str_type.clone()),
+            shared "__repr__" => (vec![], str_type),
+        );
+
+        class_id
+    }
+
+    /// Check if a class ID corresponds to a set[T] class.
+    pub(crate) fn is_set_class(&self, class_id: ClassId) -> bool {
+        self.class_data
+            .get(class_id.index())
+            .map(|c| c.qualified_name == "__builtin__.set")
+            .unwrap_or(false)
+    }
+}
@@ -12,6 +12,7 @@ impl GlobalSymbols {
         let class_id = init_builtin_class!(self, key, "str");
 
         let str_type = TirType::Class(class_id);
+        let str_list_type = TirType::Class(self.get_or_create_list_class(&str_type));
 
         register_methods!(self, class_id, "str",
             // Core methods
@@ -29,11 +30,17 @@ impl GlobalSymbols {
 
             // String search methods (Phase 3)
             shared "find" => (vec![str_type.clone()], TirType::Int),
+            shared "count" => (vec![str_type.clone()], TirType::Int),
             shared "startswith" => (vec![str_type.clone()], TirType::Bool),
             shared "endswith" => (vec![str_type.clone()], TirType::Bool),
 
             // String modification (Phase 3)
             shared "replace" => (vec![str_type.clone(), str_type.clone()], str_type.clone()),
+            shared "join" => (vec![str_list_type], str_type.clone()),
+
+            // int(s) and float(s)
+            shared "__int__" => (vec![], TirType::Int),
+            shared "__float__" => (vec![], TirType::Float),
 
             // Character classification (Phase 3)
             shared "isalpha" => (vec![], TirType::Bool),
@@ -0,0 +1,59 @@
+//! TextIO and BinaryIO built-in class implementation (files returned by open())
+
+use crate::tir::ids::ClassId;
+use crate::tir::types::TirType;
+
+use super::super::symbols::{ClassKey, GlobalSymbols};
+
+impl GlobalSymbols {
+    /// Get or create the ClassId for TextIO type (files opened in text mode).
+    pub(crate) fn get_or_create_textio_class(&mut self) -> ClassId {
+        let key = ClassKey::builtin("TextIO");
+        let class_id = init_builtin_class!(self, key, "TextIO");
+
+        let str_type = TirType::Class(self.get_or_create_str_class());
+        let file_type = TirType::Class(class_id);
+
+        register_methods!(self, class_id, "TextIO",
+            // __init__ takes the path and the mode and returns the file
+            shared "__init__" => (vec![str_type.clone(), str_type.clone()], file_type.clone()),
+            shared "read" => (vec![], str_type.clone()),
+            shared "readline" => (vec![], str_type.clone()),
+            shared "write" => (vec![str_type.clone()], TirType::Int),
+            shared "close" => (vec![], TirType::Void),
+            shared "__iter__" => (vec![], file_type),
+            shared "__next__" => (vec![], str_type),
+            shared "__hasnext__" => (vec![], TirType::Bool),
+            shared "__dealloc__" => (vec![], TirType::Void),
+        );
+
+        class_id
+    }
+
+    /// Get or create the ClassId for BinaryIO type (files opened in "b" modes).
+    pub(crate) fn get_or_create_binaryio_class(&mut self) -> ClassId {
+        let key = ClassKey::builtin("BinaryIO");
+        let class_id = init_builtin_class!(self, key, "BinaryIO");
+
+        let str_type = TirType::Class(self.get_or_create_str_class());
+        let bytes_type = TirType::Class(self.get_or_create_bytes_class());
+        let file_type = TirType::Class(class_id);
+
+        register_methods!(self, class_id, "BinaryIO",
+            shared "__init__" => (vec![str_type.clone(), str_type], file_type),
+            shared "read" => (vec![], bytes_type.clone()),
+            shared "write" => (vec![bytes_type], TirType::Int),
+            shared "close" => (vec![], TirType::Void),
+        );
+
+        class_id
+    }
+
+    /// Check if a class ID corresponds to the TextIO class.
+    pub(crate) fn is_textio_class(&self, class_id: ClassId) -> bool {
+        self.class_data
+            .get(class_id.index())
+            .map(|c| c.qualified_name == "__builtin__.TextIO")
+            .unwrap_or(false)
+    }
+}
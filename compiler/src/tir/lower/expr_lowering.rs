@@ -1,10 +1,11 @@
-use crate::ast::{BoolOp, Constant, Expr, UnaryOp};
+use crate::ast::{BoolOp, CompareOp, Constant, Expr, UnaryOp};
 use crate::error::{CompilerError, Result};
 use crate::tir::expr::VarRef;
 use crate::tir::expr_unresolved::{TirExprKindUnresolved, TirExprUnresolved};
 use crate::tir::types_unresolved::TirTypeUnresolved;
 
 use super::body_lowerer::BodyLowerer;
+use super::builtins::BUILTIN_ERROR_CLASSES;
 
 impl<'a> BodyLowerer<'a> {
     pub(crate) fn lower_expr(&mut self, expr: &Expr) -> Result<TirExprUnresolved> {
@@ -64,6 +65,23 @@ impl<'a> BodyLowerer<'a> {
                     let str_class_id = self.symbols.get_or_create_str_class();
                     let str_type = TirTypeUnresolved::Class(str_class_id);
 
+                    // bytes + bytes is bytes.__add__
+                    if let (TirTypeUnresolved::Class(left_id), TirTypeUnresolved::Class(right_id)) =
+                        (&left_expr.ty, &right_expr.ty)
+                    {
+                        if self.symbols.is_bytes_class(*left_id)
+                            && self.symbols.is_bytes_class(*right_id)
+                        {
+                            let ty = left_expr.ty.clone();
+                            return call_dunder_method!(
+                                self.symbols,
+                                &ty,
+                                "__add__",
+                                vec![left_expr, right_expr]
+                            );
+                        }
+                    }
+
                     // Check if both operands are strings
                     if left_expr.ty == str_type && right_expr.ty == str_type {
                         // String concatenation
@@ -129,23 +147,7 @@ impl<'a> BodyLowerer<'a> {
                 if ops.len() == 1 && comparators.len() == 1 {
                     // Single comparison
                     let right_expr = self.lower_expr(&comparators[0])?;
-
-                    // Check that operands are compatible for comparison
-                    if !left_expr.ty.is_compatible_with(&right_expr.ty) {
-                        return Err(CompilerError::TypeErrorSimple(format!(
-                            "Cannot compare {:?} with {:?}",
-                            left_expr.ty, right_expr.ty
-                        )));
-                    }
-
-                    Ok(TirExprUnresolved::new(
-                        TirExprKindUnresolved::Compare {
-                            left: Box::new(left_expr),
-                            op: ops[0],
-                            right: Box::new(right_expr),
-                        },
-                        TirTypeUnresolved::Bool,
-                    ))
+                    self.lower_comparison(left_expr, ops[0], right_expr)
                 } else {
                     // Chained comparison - desugar to AND of comparisons
                     // a < b < c  =>  (a < b) and (b < c)
@@ -156,24 +158,7 @@ impl<'a> BodyLowerer<'a> {
 
                     for (op, comp) in ops.iter().zip(comparators.iter()) {
                         let right_expr = self.lower_expr(comp)?;
-
-                        // Check that operands are compatible
-                        if !current_left.ty.is_compatible_with(&right_expr.ty) {
-                            return Err(CompilerError::TypeErrorSimple(format!(
-                                "Cannot compare {:?} with {:?}",
-                                current_left.ty, right_expr.ty
-                            )));
-                        }
-
-                        let cmp = TirExprUnresolved::new(
-                            TirExprKindUnresolved::Compare {
-                                left: Box::new(current_left),
-                                op: *op,
-                                right: Box::new(right_expr.clone()),
-                            },
-                            TirTypeUnresolved::Bool,
-                        );
-
+                        let cmp = self.lower_comparison(current_left, *op, right_expr.clone())?;
                         comparisons.push(cmp);
 
                         // For next iteration, use the right side as the new left
@@ -195,24 +180,12 @@ impl<'a> BodyLowerer<'a> {
 
             Expr::List { elts } => {
                 if elts.is_empty() {
-                    // Empty list: create list[TypeVar] with a fresh type variable
-                    // The element type will be inferred from usage (e.g., append calls)
-                    let elem_type_var = self.constraints.fresh_type_var();
-
-                    // Get or create list class with this type parameter
-                    // Convert TirTypeUnresolved to TirType for the symbols API
-                    let elem_type_var_tir = elem_type_var.to_tir_type();
-                    let list_class_id = self.symbols.get_or_create_list_class(&elem_type_var_tir);
-
-                    // Note: get_or_create_list_class already sets type_params via ClassKey
-
-                    // Create empty list literal
-                    Ok(TirExprUnresolved::new(
-                        TirExprKindUnresolved::List {
-                            elements: vec![],
-                            elem_ty: elem_type_var,
-                        },
-                        TirTypeUnresolved::Class(list_class_id),
+                    // Without a declared type there is nothing to take the element type
+                    // from; lower_expr_expecting handles `xs: list[T] = []`.
+                    Err(CompilerError::TypeInferenceError(
+                        "Cannot infer the element type of an empty list; \
+                         annotate it, e.g. `xs: list[int] = []`"
+                            .to_string(),
                     ))
                 } else {
                     // Non-empty list: infer element type from first element
@@ -245,8 +218,65 @@ impl<'a> BodyLowerer<'a> {
                 }
             }
 
+            Expr::Dict { keys, values } => {
+                if keys.is_empty() {
+                    // lower_expr_expecting handles `d: dict[K, V] = {}`
+                    return Err(CompilerError::TypeInferenceError(
+                        "Cannot infer the key and value types of an empty dict; \
+                         annotate it, e.g. `d: dict[str, int] = {}`"
+                            .to_string(),
+                    ));
+                }
+
+                // Keys and values are stored unboxed, so every key must have the
+                // first key's type and every value the first value's (no int/float mixing)
+                let lowered_keys = self.lower_uniform(keys, "Dict key")?;
+                let lowered_values = self.lower_uniform(values, "Dict value")?;
+                let key_ty = lowered_keys[0].ty.to_tir_type();
+                let value_ty = lowered_values[0].ty.to_tir_type();
+
+                let dict_class_id = self.symbols.get_or_create_dict_class(&key_ty, &value_ty);
+                Ok(TirExprUnresolved::new(
+                    TirExprKindUnresolved::Dict {
+                        keys: lowered_keys,
+                        values: lowered_values,
+                    },
+                    TirTypeUnresolved::Class(dict_class_id),
+                ))
+            }
+
+            Expr::Set { elts } => {
+                // `{}` is a dict, so a set literal always has an element
+                let elements = self.lower_uniform(elts, "Set element")?;
+                let elem_ty = elements[0].ty.to_tir_type();
+
+                let set_class_id = self.symbols.get_or_create_set_class(&elem_ty);
+                Ok(TirExprUnresolved::new(
+                    TirExprKindUnresolved::Set { elements },
+                    TirTypeUnresolved::Class(set_class_id),
+                ))
+            }
+
             Expr::Subscript { value, index } => {
                 let container_expr = self.lower_expr(value)?;
+
+                // xs[lo:hi] calls __getslice__(lo, hi); a left-out bound is 0 or
+                // the end, and the runtime clamps both to the container
+                if let Expr::Slice { lower, upper } = index.as_ref() {
+                    let mut bound_expr = |bound: &Option<Box<Expr>>, default: i64| match bound {
+                        Some(expr) => self.lower_expr(expr),
+                        None => self.lower_expr(&Expr::Constant(Constant::Int(default))),
+                    };
+                    let lower_expr = bound_expr(lower, 0)?;
+                    let upper_expr = bound_expr(upper, i64::MAX)?;
+                    return call_dunder_method!(
+                        self.symbols,
+                        &container_expr.ty,
+                        "__getslice__",
+                        vec![container_expr, lower_expr, upper_expr]
+                    );
+                }
+
                 let index_expr = self.lower_expr(index)?;
 
                 // Look up __getitem__ method and convert to a Call
@@ -260,6 +290,10 @@ impl<'a> BodyLowerer<'a> {
 
             Expr::Attribute { value, attr } => self.lower_attribute(value, attr),
 
+            Expr::Slice { .. } => Err(CompilerError::UnsupportedFeature(
+                "A slice can only be the index of a subscript".to_string(),
+            )),
+
             Expr::BoolOp { op, values } => {
                 let mut lowered_values = Vec::new();
                 for val in values {
@@ -325,6 +359,186 @@ impl<'a> BodyLowerer<'a> {
         }
     }
 
+    /// Lower one comparison of already-lowered operands. Membership tests
+    /// (`in`, `not in`) become a `__contains__` call on the right operand.
+    fn lower_comparison(
+        &mut self,
+        left: TirExprUnresolved,
+        op: CompareOp,
+        right: TirExprUnresolved,
+    ) -> Result<TirExprUnresolved> {
+        if matches!(op, CompareOp::In | CompareOp::NotIn) {
+            let container_ty = right.ty.clone();
+            let contains = call_dunder_method!(
+                self.symbols,
+                &container_ty,
+                "__contains__",
+                vec![right, left],
+                TirTypeUnresolved::Bool
+            )?;
+            if op == CompareOp::In {
+                return Ok(contains);
+            }
+            return Ok(TirExprUnresolved::new(
+                TirExprKindUnresolved::UnaryOp {
+                    op: UnaryOp::Not,
+                    operand: Box::new(contains),
+                },
+                TirTypeUnresolved::Bool,
+            ));
+        }
+
+        // Check that operands are compatible for comparison
+        if !left.ty.is_compatible_with(&right.ty) {
+            return Err(CompilerError::TypeErrorSimple(format!(
+                "Cannot compare {:?} with {:?}",
+                left.ty, right.ty
+            )));
+        }
+
+        Ok(TirExprUnresolved::new(
+            TirExprKindUnresolved::Compare {
+                left: Box::new(left),
+                op,
+                right: Box::new(right),
+            },
+            TirTypeUnresolved::Bool,
+        ))
+    }
+
+    /// Lower the elements of a dict or set literal, which must all have exactly
+    /// the type of the first one
+    fn lower_uniform(&mut self, exprs: &[Expr], what: &str) -> Result<Vec<TirExprUnresolved>> {
+        let mut lowered: Vec<TirExprUnresolved> = Vec::new();
+        for (i, expr) in exprs.iter().enumerate() {
+            let expr = self.lower_expr(expr)?;
+            if let Some(first) = lowered.first() {
+                if expr.ty != first.ty {
+                    return Err(CompilerError::TypeErrorSimple(format!(
+                        "{} type mismatch at index {}: expected {:?}, got {:?}",
+                        what, i, first.ty, expr.ty
+                    )));
+                }
+            }
+            lowered.push(expr);
+        }
+        Ok(lowered)
+    }
+
+    /// Lower an expression whose type is already known from its destination,
+    /// such as the annotation of the variable it is assigned to. Empty
+    /// container literals take their type from `expected`; everything else
+    /// lowers as usual and is checked by the caller.
+    pub(crate) fn lower_expr_expecting(
+        &mut self,
+        expr: &Expr,
+        expected: Option<&TirTypeUnresolved>,
+    ) -> Result<TirExprUnresolved> {
+        let Some(TirTypeUnresolved::Class(class_id)) = expected else {
+            return self.lower_expr(expr);
+        };
+        let class_id = *class_id;
+        let empty = TirTypeUnresolved::Class(class_id);
+
+        match expr {
+            Expr::List { elts } if elts.is_empty() && self.symbols.is_list_class(class_id) => {
+                let elem_ty = self.symbols.get_type_params(class_id).remove(0);
+                Ok(TirExprUnresolved::new(
+                    TirExprKindUnresolved::List {
+                        elements: vec![],
+                        elem_ty,
+                    },
+                    empty,
+                ))
+            }
+            Expr::Dict { keys, .. } if keys.is_empty() && self.symbols.is_dict_class(class_id) => {
+                Ok(TirExprUnresolved::new(
+                    TirExprKindUnresolved::Dict {
+                        keys: vec![],
+                        values: vec![],
+                    },
+                    empty,
+                ))
+            }
+            // `dict()` and `set()` with no arguments
+            Expr::Call { func, args } if args.is_empty() => match func.as_ref() {
+                Expr::Name(name) if name == "dict" && self.symbols.is_dict_class(class_id) => {
+                    Ok(TirExprUnresolved::new(
+                        TirExprKindUnresolved::Dict {
+                            keys: vec![],
+                            values: vec![],
+                        },
+                        empty,
+                    ))
+                }
+                Expr::Name(name) if name == "set" && self.symbols.is_set_class(class_id) => Ok(
+                    TirExprUnresolved::new(TirExprKindUnresolved::Set { elements: vec![] }, empty),
+                ),
+                _ => self.lower_expr(expr),
+            },
+            _ => self.lower_expr(expr),
+        }
+    }
+
+    /// Lower str(x), int(x) or float(x) of an already-lowered value. Between
+    /// primitives this calls the runtime formatter or cast; on a class it calls
+    /// the `__str__`, `__int__` or `__float__` method, which is how text is
+    /// parsed (str defines `__int__` and `__float__`).
+    fn lower_conversion(
+        &mut self,
+        target: &str,
+        value: TirExprUnresolved,
+    ) -> Result<TirExprUnresolved> {
+        let str_class_id = self.symbols.get_or_create_str_class();
+        let str_type = TirTypeUnresolved::Class(str_class_id);
+        let runtime_call = |func, value, ty| {
+            Ok(TirExprUnresolved::new(
+                TirExprKindUnresolved::Call {
+                    func,
+                    args: vec![value],
+                },
+                ty,
+            ))
+        };
+
+        match (target, &value.ty) {
+            ("str", TirTypeUnresolved::Class(class_id)) if *class_id == str_class_id => Ok(value),
+            ("int", TirTypeUnresolved::Int) | ("float", TirTypeUnresolved::Float) => Ok(value),
+            ("str", TirTypeUnresolved::Int) => {
+                runtime_call(self.symbols.get_int_str_func(), value, str_type)
+            }
+            ("str", TirTypeUnresolved::Float) => {
+                runtime_call(self.symbols.get_float_str_func(), value, str_type)
+            }
+            ("str", TirTypeUnresolved::Bool) => {
+                runtime_call(self.symbols.get_bool_str_func(), value, str_type)
+            }
+            ("int", TirTypeUnresolved::Float) => runtime_call(
+                self.symbols.get_float_int_func(),
+                value,
+                TirTypeUnresolved::Int,
+            ),
+            ("float", TirTypeUnresolved::Int) => runtime_call(
+                self.symbols.get_int_float_func(),
+                value,
+                TirTypeUnresolved::Float,
+            ),
+            (_, TirTypeUnresolved::Class(_)) => {
+                let (method, ty) = match target {
+                    "str" => ("__str__", str_type),
+                    "int" => ("__int__", TirTypeUnresolved::Int),
+                    _ => ("__float__", TirTypeUnresolved::Float),
+                };
+                let value_ty = value.ty.clone();
+                call_dunder_method!(self.symbols, &value_ty, method, vec![value], ty)
+            }
+            _ => Err(CompilerError::TypeErrorSimple(format!(
+                "{}() argument must be int, float or str, got {:?}",
+                target, value.ty
+            ))),
+        }
+    }
+
     fn lower_call(&mut self, func: &Expr, args: &[Expr]) -> Result<TirExprUnresolved> {
         // Handle super().__method__(...) calls
         if let Expr::Attribute { value, attr } = func {
@@ -420,22 +634,39 @@ impl<'a> BodyLowerer<'a> {
                 return call_dunder_method!(self.symbols, &receiver.ty, "__next__", vec![receiver]);
             }
 
-            // Check if it's an Exception constructor
-            if name == "Exception" {
-                let class_id = self.symbols.get_or_create_exception_class();
+            // str(x), int(x) and float(x) conversions
+            if name == "str" || name == "int" || name == "float" {
+                if lowered_args.len() != 1 {
+                    return Err(CompilerError::TypeErrorSimple(format!(
+                        "{}() takes exactly one argument",
+                        name
+                    )));
+                }
+                let value = lowered_args.into_iter().next().unwrap();
+                return self.lower_conversion(name, value);
+            }
+
+            // Check if it's a builtin exception constructor
+            if name == "Exception" || BUILTIN_ERROR_CLASSES.contains(&name.as_str()) {
+                let class_id = if name == "Exception" {
+                    self.symbols.get_or_create_exception_class()
+                } else {
+                    self.symbols.get_or_create_builtin_error_class(name)
+                };
                 // Exception() can take 0 or 1 argument (message)
                 if lowered_args.len() > 1 {
-                    return Err(CompilerError::TypeErrorSimple(
-                        "Exception() takes at most 1 argument (message)".to_string(),
-                    ));
+                    return Err(CompilerError::TypeErrorSimple(format!(
+                        "{}() takes at most 1 argument (message)",
+                        name
+                    )));
                 }
                 // If there's an argument, it must be a string
                 if lowered_args.len() == 1 {
                     let str_class_id = self.symbols.get_or_create_str_class();
                     if lowered_args[0].ty != TirTypeUnresolved::Class(str_class_id) {
                         return Err(CompilerError::TypeErrorSimple(format!(
-                            "Exception() argument must be a string, got {:?}",
-                            lowered_args[0].ty
+                            "{}() argument must be a string, got {:?}",
+                            name, lowered_args[0].ty
                         )));
                     }
                 }
@@ -457,14 +688,15 @@ impl<'a> BodyLowerer<'a> {
                         "bytearray() takes at most 1 argument".to_string(),
                     ));
                 }
-                // If there's an argument, it must be bytes
+                // If there's an argument, it must be bytes or a length
                 if lowered_args.len() == 1 {
                     match &lowered_args[0].ty {
+                        TirTypeUnresolved::Int => {}
                         TirTypeUnresolved::Class(class_id)
                             if self.symbols.is_bytes_class(*class_id) => {}
                         _ => {
                             return Err(CompilerError::TypeErrorSimple(format!(
-                                "bytearray() argument must be bytes, got {:?}",
+                                "bytearray() argument must be bytes or int, got {:?}",
                                 lowered_args[0].ty
                             )));
                         }
@@ -479,6 +711,57 @@ impl<'a> BodyLowerer<'a> {
                 ));
             }
 
+            // open(path) and open(path, mode): the mode picks the file class, so
+            // it must be a literal
+            if name == "open" {
+                if lowered_args.is_empty() || lowered_args.len() > 2 {
+                    return Err(CompilerError::TypeErrorSimple(
+                        "open() takes a path and an optional mode".to_string(),
+                    ));
+                }
+                let str_class_id = self.symbols.get_or_create_str_class();
+                if lowered_args[0].ty != TirTypeUnresolved::Class(str_class_id) {
+                    return Err(CompilerError::TypeErrorSimple(format!(
+                        "open() path must be a string, got {:?}",
+                        lowered_args[0].ty
+                    )));
+                }
+                let mode = match args.get(1) {
+                    None => "r".to_string(),
+                    Some(Expr::Constant(Constant::Str(mode))) => mode.clone(),
+                    Some(_) => {
+                        return Err(CompilerError::TypeErrorSimple(
+                            "open() mode must be a string literal".to_string(),
+                        ));
+                    }
+                };
+                let Some(binary) = open_mode_is_binary(&mode) else {
+                    return Err(CompilerError::TypeErrorSimple(format!(
+                        "open() mode must be one of r, w, a or x, optionally with b or t, got '{}'",
+                        mode
+                    )));
+                };
+                let class_id = if binary {
+                    self.symbols.get_or_create_binaryio_class()
+                } else {
+                    self.symbols.get_or_create_textio_class()
+                };
+                let (_, init_func_id) = self.symbols.methods[&(class_id, "__init__".to_string())];
+                let mut call_args = lowered_args;
+                call_args.truncate(1);
+                call_args.push(TirExprUnresolved::new(
+                    TirExprKindUnresolved::Constant(Constant::Str(mode)),
+                    TirTypeUnresolved::Class(str_class_id),
+                ));
+                return Ok(TirExprUnresolved::new(
+                    TirExprKindUnresolved::Call {
+                        func: init_func_id,
+                        args: call_args,
+                    },
+                    TirTypeUnresolved::Class(class_id),
+                ));
+            }
+
             // Check if it's a class constructor
             if let Some(&class_id) = self.scope.classes.get(name) {
                 // Check if class has an __init__ method
@@ -822,10 +1105,11 @@ impl<'a> BodyLowerer<'a> {
             }
         }
 
-        // Create Call with self as first argument (self is passed through to parent)
+        // Create Call with self as first argument (self is passed through to parent).
+        // Typing it as the parent class marks the call as non-virtual for dispatch.
         let self_expr = TirExprUnresolved::new(
             TirExprKindUnresolved::Var(VarRef::SelfRef),
-            TirTypeUnresolved::Class(class_id),
+            TirTypeUnresolved::Class(parent_id),
         );
         let mut call_args = vec![self_expr];
         call_args.extend(lowered_args);
@@ -839,3 +1123,17 @@ impl<'a> BodyLowerer<'a> {
         ))
     }
 }
+
+/// Whether an open() mode is binary, or None when the runtime does not support
+/// the mode: one of r, w, a or x, then optionally b or t
+fn open_mode_is_binary(mode: &str) -> Option<bool> {
+    let mut chars = mode.chars();
+    if !matches!(chars.next(), Some('r' | 'w' | 'a' | 'x')) {
+        return None;
+    }
+    match chars.as_str() {
+        "" | "t" => Some(false),
+        "b" => Some(true),
+        _ => None,
+    }
+}
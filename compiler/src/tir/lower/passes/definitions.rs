@@ -337,6 +337,17 @@ pub fn convert_annotation_simple(
             let class_id = symbols.get_or_create_list_class(&elem_ty);
             TirType::Class(class_id)
         }
+        ast::TypeAnnotation::Dict(key, value) => {
+            let key_ty = convert_annotation_simple(key, symbols, current_mod);
+            let value_ty = convert_annotation_simple(value, symbols, current_mod);
+            let class_id = symbols.get_or_create_dict_class(&key_ty, &value_ty);
+            TirType::Class(class_id)
+        }
+        ast::TypeAnnotation::Set(inner) => {
+            let elem_ty = convert_annotation_simple(inner, symbols, current_mod);
+            let class_id = symbols.get_or_create_set_class(&elem_ty);
+            TirType::Class(class_id)
+        }
         ast::TypeAnnotation::ClassName(name) => {
             // First try current module, then global lookup
             if let Some(class_id) = symbols.lookup_class(current_mod, name) {
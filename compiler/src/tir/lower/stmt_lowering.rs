@@ -1,13 +1,15 @@
-use crate::ast::{Constant, Expr, Stmt, UnaryOp};
+use crate::ast::{BinOperator, Constant, Expr, Stmt, UnaryOp};
 use crate::error::{CompilerError, Result};
 use crate::tir::expr::VarRef;
 use crate::tir::expr_unresolved::{TirExprKindUnresolved, TirExprUnresolved};
+use crate::tir::ids::{ClassId, FuncId};
 use crate::tir::stmt_unresolved::{
     TirExceptHandlerUnresolved, TirLValueUnresolved, TirStmtUnresolved,
 };
 use crate::tir::types_unresolved::TirTypeUnresolved;
 
 use super::body_lowerer::BodyLowerer;
+use super::builtins::BUILTIN_ERROR_CLASSES;
 
 impl<'a> BodyLowerer<'a> {
     pub(crate) fn lower_stmt(&mut self, stmt: &Stmt) -> Result<Vec<TirStmtUnresolved>> {
@@ -17,10 +19,15 @@ impl<'a> BodyLowerer<'a> {
                 value,
                 type_annotation,
             } => {
-                let value_expr = self.lower_expr(value)?;
-
                 match target {
                     Expr::Name(name) => {
+                        // The declared type, if any, types an empty list on the right
+                        let declared_ty = match type_annotation {
+                            Some(annot) => Some(self.convert_annotation(annot)),
+                            None => self.resolve_var(name).map(|(_, ty)| ty),
+                        };
+                        let value_expr = self.lower_expr_expecting(value, declared_ty.as_ref())?;
+
                         // Check if this is a new variable or existing
                         if let Some((var_ref, var_ty)) = self.resolve_var(name) {
                             // Existing variable - check type compatibility
@@ -36,8 +43,7 @@ impl<'a> BodyLowerer<'a> {
                             }])
                         } else {
                             // New variable - create Let
-                            let ty = if let Some(annot) = type_annotation {
-                                let declared_ty = self.convert_annotation(annot);
+                            let ty = if let Some(declared_ty) = declared_ty {
                                 // Check that value type matches declared type
                                 if !value_expr.ty.is_compatible_with(&declared_ty) {
                                     return Err(CompilerError::TypeErrorSimple(format!(
@@ -84,6 +90,9 @@ impl<'a> BodyLowerer<'a> {
                                     )
                                 };
 
+                                let value_expr =
+                                    self.lower_expr_expecting(value, Some(&field_ty))?;
+
                                 // Check compatibility
                                 if !value_expr.ty.is_compatible_with(&field_ty) {
                                     return Err(CompilerError::TypeErrorSimple(format!(
@@ -112,6 +121,7 @@ impl<'a> BodyLowerer<'a> {
                         value: container,
                         index,
                     } => {
+                        let value_expr = self.lower_expr(value)?;
                         let container_expr = self.lower_expr(container)?;
                         let index_expr = self.lower_expr(index)?;
 
@@ -135,6 +145,25 @@ impl<'a> BodyLowerer<'a> {
             Stmt::AugAssign { target, op, value } => {
                 let value_expr = self.lower_expr(value)?;
                 if let Some((var_ref, var_ty)) = self.resolve_var(target) {
+                    // `s += t` on strings is plain concatenation: `s = s + t`
+                    let str_type = TirTypeUnresolved::Class(self.symbols.get_or_create_str_class());
+                    if *op == BinOperator::Add && var_ty == str_type && value_expr.ty == str_type {
+                        let current =
+                            TirExprUnresolved::new(TirExprKindUnresolved::Var(var_ref), var_ty);
+                        let concat = TirExprUnresolved::new(
+                            TirExprKindUnresolved::BinOp {
+                                left: Box::new(current),
+                                op: *op,
+                                right: Box::new(value_expr),
+                            },
+                            str_type,
+                        );
+                        return Ok(vec![TirStmtUnresolved::Assign {
+                            target: TirLValueUnresolved::Var(var_ref),
+                            value: concat,
+                        }]);
+                    }
+
                     // Check that both target and value are numeric for augmented assignment
                     if !var_ty.is_numeric() {
                         return Err(CompilerError::TypeErrorSimple(format!(
@@ -259,9 +288,33 @@ impl<'a> BodyLowerer<'a> {
 
                 let mut result = Vec::new();
 
+                // prange() marks a loop whose iterations may run in parallel
+                if let Expr::Call { func, args } = iter {
+                    if matches!(func.as_ref(), Expr::Name(name) if name == "prange")
+                        && self.resolve_var("prange").is_none()
+                    {
+                        return self.lower_for_prange(target, args, body);
+                    }
+                }
+
                 // Lower the iterable expression
                 let iterable_expr = self.lower_expr(iter)?;
 
+                // range() with a constant step becomes a counted loop
+                if let Some(loop_stmts) = self.lower_for_range(target, &iterable_expr, body)? {
+                    return Ok(loop_stmts);
+                }
+
+                // Builtin lists are walked by index without a ListIterator
+                if let Some(class_id) = iterable_expr.ty.class_id() {
+                    if self.symbols.is_list_class(class_id) {
+                        return self.lower_for_list(target, class_id, iterable_expr, body);
+                    }
+                    if self.symbols.is_textio_class(class_id) {
+                        return self.lower_for_file(target, iterable_expr, body);
+                    }
+                }
+
                 // Call __iter__ on the iterable
                 let iter_call = call_dunder_method!(
                     self.symbols,
@@ -469,67 +522,303 @@ impl<'a> BodyLowerer<'a> {
         }
     }
 
+    /// Lower `for target in range(...)` to a counted ForRange loop.
+    ///
+    /// Only applies when the iterable is a direct range() construction whose step is
+    /// absent or an integer literal, so the loop direction is known at compile time.
+    /// Returns None to fall back to the iterator protocol otherwise.
+    fn lower_for_range(
+        &mut self,
+        target: &str,
+        iterable: &TirExprUnresolved,
+        body: &[Stmt],
+    ) -> Result<Option<Vec<TirStmtUnresolved>>> {
+        let args = match &iterable.kind {
+            TirExprKindUnresolved::Construct { class, args }
+                if self.symbols.is_range_class(*class) =>
+            {
+                args
+            }
+            _ => return Ok(None),
+        };
+
+        let zero = TirExprUnresolved::new(
+            TirExprKindUnresolved::Constant(Constant::Int(0)),
+            TirTypeUnresolved::Int,
+        );
+        let (start, stop, step) = match args.as_slice() {
+            [stop] => (zero, stop.clone(), 1),
+            [start, stop] => (start.clone(), stop.clone(), 1),
+            [start, stop, step] => match constant_int(step) {
+                Some(step) => (start.clone(), stop.clone(), step),
+                None => return Ok(None),
+            },
+            _ => return Ok(None),
+        };
+
+        if step == 0 {
+            return Err(CompilerError::TypeErrorSimple(
+                "range() step argument must not be zero".to_string(),
+            ));
+        }
+
+        let counter_name = format!("_for_iv_{}", self.next_local_id);
+        let counter = self.alloc_local(&counter_name, TirTypeUnresolved::Int);
+
+        self.enter_scope();
+        let target_local = self.alloc_local(target, TirTypeUnresolved::Int);
+        let mut loop_body = Vec::new();
+        for stmt in body {
+            loop_body.extend(self.lower_stmt(stmt)?);
+        }
+        self.exit_scope();
+
+        Ok(Some(vec![TirStmtUnresolved::ForRange {
+            target: target_local,
+            counter,
+            start,
+            stop,
+            step,
+            parallel: false,
+            body: loop_body,
+        }]))
+    }
+
+    /// Lower `for target in prange(...)` to a parallel ForRange loop.
+    ///
+    /// `prange(stop)` and `prange(start, stop)` count like range() with step
+    /// 1. `prange(xs)` on a list walks the indices of xs, evaluated once, and
+    /// binds the target to each element. Which iterations may share what is
+    /// checked once types are resolved (tir/parallel.rs).
+    fn lower_for_prange(
+        &mut self,
+        target: &str,
+        args: &[Expr],
+        body: &[Stmt],
+    ) -> Result<Vec<TirStmtUnresolved>> {
+        let mut lowered_args = Vec::new();
+        for arg in args {
+            lowered_args.push(self.lower_expr(arg)?);
+        }
+
+        let over_list = matches!(lowered_args.as_slice(), [xs]
+            if xs.ty.class_id().is_some_and(|class_id| self.symbols.is_list_class(class_id)));
+        let zero = TirExprUnresolved::new(
+            TirExprKindUnresolved::Constant(Constant::Int(0)),
+            TirTypeUnresolved::Int,
+        );
+        let mut result = Vec::new();
+        let mut list = None;
+        let (start, stop) = match lowered_args.as_slice() {
+            [xs] if over_list => {
+                // The list is evaluated once, into a hidden local the
+                // iterations read from
+                let list_name = format!("_prange_list_{}", self.next_local_id);
+                let list_local = self.alloc_local(&list_name, xs.ty.clone());
+                let list_var = TirExprUnresolved::new(
+                    TirExprKindUnresolved::Var(VarRef::Local(list_local)),
+                    xs.ty.clone(),
+                );
+                result.push(TirStmtUnresolved::Let {
+                    local: list_local,
+                    ty: xs.ty.clone(),
+                    init: xs.clone(),
+                });
+                let len = call_dunder_method!(
+                    self.symbols,
+                    &list_var.ty,
+                    "__len__",
+                    vec![list_var.clone()],
+                    TirTypeUnresolved::Int
+                )?;
+                list = Some(list_var);
+                (zero, len)
+            }
+            [stop] if stop.ty == TirTypeUnresolved::Int => (zero, stop.clone()),
+            [start, stop]
+                if start.ty == TirTypeUnresolved::Int && stop.ty == TirTypeUnresolved::Int =>
+            {
+                (start.clone(), stop.clone())
+            }
+            _ => {
+                return Err(CompilerError::TypeErrorSimple(
+                    "prange() takes a list, or one or two int arguments (stop or start, stop)"
+                        .to_string(),
+                ))
+            }
+        };
+
+        let counter_name = format!("_for_iv_{}", self.next_local_id);
+        let counter = self.alloc_local(&counter_name, TirTypeUnresolved::Int);
+
+        self.enter_scope();
+        let mut loop_body = Vec::new();
+        let index = match list {
+            None => self.alloc_local(target, TirTypeUnresolved::Int),
+            Some(list_var) => {
+                // The loop counts indices; the body starts by binding the element
+                let index_name = format!("_prange_idx_{}", self.next_local_id);
+                let index = self.alloc_local(&index_name, TirTypeUnresolved::Int);
+                let index_var = TirExprUnresolved::new(
+                    TirExprKindUnresolved::Var(VarRef::Local(index)),
+                    TirTypeUnresolved::Int,
+                );
+                let list_ty = list_var.ty.clone();
+                let elem = call_dunder_method!(
+                    self.symbols,
+                    &list_ty,
+                    "__getitem__",
+                    vec![list_var, index_var]
+                )?;
+                let target_local = self.alloc_local(target, elem.ty.clone());
+                loop_body.push(TirStmtUnresolved::Let {
+                    local: target_local,
+                    ty: elem.ty.clone(),
+                    init: elem,
+                });
+                index
+            }
+        };
+        for stmt in body {
+            loop_body.extend(self.lower_stmt(stmt)?);
+        }
+        self.exit_scope();
+
+        result.push(TirStmtUnresolved::ForRange {
+            target: index,
+            counter,
+            start,
+            stop,
+            step: 1,
+            parallel: true,
+            body: loop_body,
+        });
+        Ok(result)
+    }
+
+    /// Lower `for target in some_list` to an indexed ForList loop.
+    fn lower_for_list(
+        &mut self,
+        target: &str,
+        list_class: ClassId,
+        iterable: TirExprUnresolved,
+        body: &[Stmt],
+    ) -> Result<Vec<TirStmtUnresolved>> {
+        // The element type is whatever list[T].__getitem__ yields
+        let (_, getitem_func) = self
+            .symbols
+            .resolve_method(list_class, "__getitem__")
+            .ok_or_else(|| CompilerError::TypeErrorSimple("list has no __getitem__".into()))?;
+        let elem_ty =
+            TirTypeUnresolved::from_tir_type(&self.symbols.get_func_signature(getitem_func).1);
+
+        let index_name = format!("_for_idx_{}", self.next_local_id);
+        let index = self.alloc_local(&index_name, TirTypeUnresolved::Int);
+
+        self.enter_scope();
+        let target_local = self.alloc_local(target, elem_ty);
+        let mut loop_body = Vec::new();
+        for stmt in body {
+            loop_body.extend(self.lower_stmt(stmt)?);
+        }
+        self.exit_scope();
+
+        Ok(vec![TirStmtUnresolved::ForList {
+            target: target_local,
+            index,
+            iterable,
+            body: loop_body,
+        }])
+    }
+
+    /// Lower `for line in f` over a TextIO to a loop that reads lines straight
+    /// from the file's buffer, without the iterator protocol's try/except:
+    ///   _file = f
+    ///   while _file.__hasnext__():
+    ///       line = _file.readline()
+    ///       <body>
+    fn lower_for_file(
+        &mut self,
+        target: &str,
+        iterable: TirExprUnresolved,
+        body: &[Stmt],
+    ) -> Result<Vec<TirStmtUnresolved>> {
+        let file_ty = iterable.ty.clone();
+        let file_name = format!("_for_file_{}", self.next_local_id);
+        let file_local = self.alloc_local(&file_name, file_ty.clone());
+        let file_var = TirExprUnresolved::new(
+            TirExprKindUnresolved::Var(VarRef::Local(file_local)),
+            file_ty.clone(),
+        );
+
+        let cond = call_dunder_method!(
+            self.symbols,
+            &file_ty,
+            "__hasnext__",
+            vec![file_var.clone()]
+        )?;
+        let readline = call_dunder_method!(self.symbols, &file_ty, "readline", vec![file_var])?;
+
+        self.enter_scope();
+        let target_local = self.alloc_local(target, readline.ty.clone());
+        let mut loop_body = vec![TirStmtUnresolved::Let {
+            local: target_local,
+            ty: readline.ty.clone(),
+            init: readline,
+        }];
+        for stmt in body {
+            loop_body.extend(self.lower_stmt(stmt)?);
+        }
+        self.exit_scope();
+
+        Ok(vec![
+            TirStmtUnresolved::Let {
+                local: file_local,
+                ty: file_ty,
+                init: iterable,
+            },
+            TirStmtUnresolved::While {
+                cond,
+                body: loop_body,
+            },
+        ])
+    }
+
     /// Expand print(args...) into multiple TIR statements
     ///
-    /// print(x, y, z) becomes:
-    ///   call(int_print, x)     or call(write_string_impl, x.__str__())
-    ///   call(write_space_impl)
-    ///   call(int_print, y)     or call(write_string_impl, y.__str__())
-    ///   call(write_space_impl)
-    ///   call(int_print, z)     or call(write_string_impl, z.__str__())
-    ///   call(write_newline_impl)
+    /// Each argument becomes one call that prints the value followed by its
+    /// separator, so print(x, y, z) becomes:
+    ///   call(int_print, x, False)   or call(str_print, x.__str__(), False)
+    ///   call(int_print, y, False)   or call(str_print, y.__str__(), False)
+    ///   call(int_print, z, True)    or call(str_print, z.__str__(), True)
+    /// where the flag selects a newline instead of a space. Adjacent string
+    /// literals are joined at compile time, so print("total:", n) is a single
+    /// str_print of "total:" and an int_print of n. print() is
+    /// call(write_newline_impl).
     fn expand_print_stmt(&mut self, args: &[Expr]) -> Result<Vec<TirStmtUnresolved>> {
-        let mut stmts = Vec::new();
-
         // Get FuncIds for print helpers
         let int_print_func = self.symbols.get_int_print_func();
         let float_print_func = self.symbols.get_float_print_func();
         let bool_print_func = self.symbols.get_bool_print_func();
-        let write_string_func = self.symbols.get_write_string_func();
-        let write_space_func = self.symbols.get_write_space_func();
-        let write_newline_func = self.symbols.get_write_newline_func();
+        let str_print_func = self.symbols.get_str_print_func();
 
         let str_class_id = self.symbols.get_or_create_str_class();
         let str_type = TirTypeUnresolved::Class(str_class_id);
 
-        for (i, arg) in args.iter().enumerate() {
-            // Add space separator between arguments
-            if i > 0 {
-                stmts.push(TirStmtUnresolved::Expr(TirExprUnresolved::new(
-                    TirExprKindUnresolved::Call {
-                        func: write_space_func,
-                        args: vec![],
-                    },
-                    TirTypeUnresolved::Void,
-                )));
-            }
-
+        // (print function, value) per output segment
+        let mut pieces: Vec<(FuncId, TirExprUnresolved)> = Vec::new();
+        for arg in args {
             // Lower the argument
             let lowered_arg = self.lower_expr(arg)?;
 
-            // Generate the appropriate print call based on type
-            let print_stmt = match &lowered_arg.ty {
-                TirTypeUnresolved::Int => TirStmtUnresolved::Expr(TirExprUnresolved::new(
-                    TirExprKindUnresolved::Call {
-                        func: int_print_func,
-                        args: vec![lowered_arg],
-                    },
-                    TirTypeUnresolved::Void,
-                )),
-                TirTypeUnresolved::Float => TirStmtUnresolved::Expr(TirExprUnresolved::new(
-                    TirExprKindUnresolved::Call {
-                        func: float_print_func,
-                        args: vec![lowered_arg],
-                    },
-                    TirTypeUnresolved::Void,
-                )),
-                TirTypeUnresolved::Bool => TirStmtUnresolved::Expr(TirExprUnresolved::new(
-                    TirExprKindUnresolved::Call {
-                        func: bool_print_func,
-                        args: vec![lowered_arg],
-                    },
-                    TirTypeUnresolved::Void,
-                )),
+            // Pick the print function based on type
+            let piece = match &lowered_arg.ty {
+                TirTypeUnresolved::Int => (int_print_func, lowered_arg),
+                TirTypeUnresolved::Float => (float_print_func, lowered_arg),
+                TirTypeUnresolved::Bool => (bool_print_func, lowered_arg),
+                TirTypeUnresolved::Class(class_id) if *class_id == str_class_id => {
+                    (str_print_func, lowered_arg)
+                }
                 TirTypeUnresolved::Class(class_id) => {
                     // For classes, call __str__ or __repr__ to convert to String*
                     let str_expr = if let Some((_method_id, func_id)) =
@@ -562,14 +851,7 @@ impl<'a> BodyLowerer<'a> {
                             str_type.clone(),
                         )
                     };
-
-                    TirStmtUnresolved::Expr(TirExprUnresolved::new(
-                        TirExprKindUnresolved::Call {
-                            func: write_string_func,
-                            args: vec![str_expr],
-                        },
-                        TirTypeUnresolved::Void,
-                    ))
+                    (str_print_func, str_expr)
                 }
                 TirTypeUnresolved::TypeVar(_) => {
                     // TypeVars should only appear inside Class type_params, never as top-level types
@@ -582,19 +864,54 @@ impl<'a> BodyLowerer<'a> {
                 }
             };
 
-            stmts.push(print_stmt);
+            // Join a string literal onto a preceding one
+            if let (
+                Some((
+                    _,
+                    TirExprUnresolved {
+                        kind: TirExprKindUnresolved::Constant(Constant::Str(prev)),
+                        ..
+                    },
+                )),
+                TirExprKindUnresolved::Constant(Constant::Str(text)),
+            ) = (pieces.last_mut(), &piece.1.kind)
+            {
+                prev.push(' ');
+                prev.push_str(text);
+                continue;
+            }
+            pieces.push(piece);
         }
 
-        // Add final newline
-        stmts.push(TirStmtUnresolved::Expr(TirExprUnresolved::new(
-            TirExprKindUnresolved::Call {
-                func: write_newline_func,
-                args: vec![],
-            },
-            TirTypeUnresolved::Void,
-        )));
+        if pieces.is_empty() {
+            let write_newline_func = self.symbols.get_write_newline_func();
+            return Ok(vec![TirStmtUnresolved::Expr(TirExprUnresolved::new(
+                TirExprKindUnresolved::Call {
+                    func: write_newline_func,
+                    args: vec![],
+                },
+                TirTypeUnresolved::Void,
+            ))]);
+        }
 
-        Ok(stmts)
+        let last = pieces.len() - 1;
+        Ok(pieces
+            .into_iter()
+            .enumerate()
+            .map(|(i, (func, value))| {
+                let end_line = TirExprUnresolved::new(
+                    TirExprKindUnresolved::Constant(Constant::Bool(i == last)),
+                    TirTypeUnresolved::Bool,
+                );
+                TirStmtUnresolved::Expr(TirExprUnresolved::new(
+                    TirExprKindUnresolved::Call {
+                        func,
+                        args: vec![value, end_line],
+                    },
+                    TirTypeUnresolved::Void,
+                ))
+            })
+            .collect())
     }
 
     /// Resolve an exception class name to a ClassId
@@ -603,6 +920,9 @@ impl<'a> BodyLowerer<'a> {
         if name == "Exception" {
             return Ok(self.symbols.get_or_create_exception_class());
         }
+        if BUILTIN_ERROR_CLASSES.contains(&name) {
+            return Ok(self.symbols.get_or_create_builtin_error_class(name));
+        }
 
         // Check if there's a user-defined class with this name in scope
         if let Some(&class_id) = self.scope.classes.get(name) {
@@ -624,3 +944,18 @@ impl<'a> BodyLowerer<'a> {
         Ok(self.symbols.get_or_create_exception_class())
     }
 }
+
+/// Extract the value of an integer literal, including a negated one (`-2`).
+fn constant_int(expr: &TirExprUnresolved) -> Option<i64> {
+    match &expr.kind {
+        TirExprKindUnresolved::Constant(Constant::Int(n)) => Some(*n),
+        TirExprKindUnresolved::UnaryOp {
+            op: UnaryOp::USub,
+            operand,
+        } => match &operand.kind {
+            TirExprKindUnresolved::Constant(Constant::Int(n)) => n.checked_neg(),
+            _ => None,
+        },
+        _ => None,
+    }
+}
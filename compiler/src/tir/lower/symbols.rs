@@ -295,50 +295,97 @@ impl GlobalSymbols {
     // Print-related runtime function helpers
     // ============================================================
 
-    /// Get the FuncId for int.__print__ (prints int without newline)
+    /// Get the FuncId for int.__print__ (prints an int, then a space or newline)
     pub(crate) fn get_int_print_func(&mut self) -> FuncId {
         self.get_or_create_runtime_func(
             "__pyc___builtin___int___print__",
-            vec![TirType::Int],
+            vec![TirType::Int, TirType::Bool],
             TirType::Void,
         )
     }
 
-    /// Get the FuncId for bool.__print__ (prints bool without newline)
+    /// Get the FuncId for bool.__print__ (prints a bool, then a space or newline)
     pub(crate) fn get_bool_print_func(&mut self) -> FuncId {
         self.get_or_create_runtime_func(
             "__pyc___builtin___bool___print__",
-            vec![TirType::Bool],
+            vec![TirType::Bool, TirType::Bool],
             TirType::Void,
         )
     }
 
-    /// Get the FuncId for float.__print__ (prints float without newline)
+    /// Get the FuncId for float.__print__ (prints a float, then a space or newline)
     pub(crate) fn get_float_print_func(&mut self) -> FuncId {
         self.get_or_create_runtime_func(
             "__pyc___builtin___float___print__",
-            vec![TirType::Float],
+            vec![TirType::Float, TirType::Bool],
             TirType::Void,
         )
     }
 
-    /// Get the FuncId for write_string_impl (prints String* without newline)
-    pub(crate) fn get_write_string_func(&mut self) -> FuncId {
+    /// Get the FuncId for str.__print__ (prints a String*, then a space or newline)
+    pub(crate) fn get_str_print_func(&mut self) -> FuncId {
         let str_class_id = self.get_or_create_str_class();
         self.get_or_create_runtime_func(
-            "write_string_impl",
-            vec![TirType::Class(str_class_id)],
+            "__pyc___builtin___str___print__",
+            vec![TirType::Class(str_class_id), TirType::Bool],
             TirType::Void,
         )
     }
 
-    /// Get the FuncId for write_space_impl (prints a single space)
-    pub(crate) fn get_write_space_func(&mut self) -> FuncId {
-        self.get_or_create_runtime_func("write_space_impl", vec![], TirType::Void)
-    }
-
     /// Get the FuncId for write_newline_impl (prints a newline)
     pub(crate) fn get_write_newline_func(&mut self) -> FuncId {
         self.get_or_create_runtime_func("write_newline_impl", vec![], TirType::Void)
     }
+
+    // ============================================================
+    // Conversion runtime function helpers (str(), int(), float())
+    // ============================================================
+
+    /// Get the FuncId for int.__str__ (formats an int into a new String)
+    pub(crate) fn get_int_str_func(&mut self) -> FuncId {
+        let str_class_id = self.get_or_create_str_class();
+        self.get_or_create_runtime_func(
+            "__pyc___builtin___int___str__",
+            vec![TirType::Int],
+            TirType::Class(str_class_id),
+        )
+    }
+
+    /// Get the FuncId for float.__str__ (formats repr(x) into a new String)
+    pub(crate) fn get_float_str_func(&mut self) -> FuncId {
+        let str_class_id = self.get_or_create_str_class();
+        self.get_or_create_runtime_func(
+            "__pyc___builtin___float___str__",
+            vec![TirType::Float],
+            TirType::Class(str_class_id),
+        )
+    }
+
+    /// Get the FuncId for bool.__str__ ("True" or "False")
+    pub(crate) fn get_bool_str_func(&mut self) -> FuncId {
+        let str_class_id = self.get_or_create_str_class();
+        self.get_or_create_runtime_func(
+            "__pyc___builtin___bool___str__",
+            vec![TirType::Bool],
+            TirType::Class(str_class_id),
+        )
+    }
+
+    /// Get the FuncId for float.__int__ (truncates towards zero)
+    pub(crate) fn get_float_int_func(&mut self) -> FuncId {
+        self.get_or_create_runtime_func(
+            "__pyc___builtin___float___int__",
+            vec![TirType::Float],
+            TirType::Int,
+        )
+    }
+
+    /// Get the FuncId for int.__float__
+    pub(crate) fn get_int_float_func(&mut self) -> FuncId {
+        self.get_or_create_runtime_func(
+            "__pyc___builtin___int___float__",
+            vec![TirType::Int],
+            TirType::Float,
+        )
+    }
 }
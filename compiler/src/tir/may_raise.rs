@@ -0,0 +1,194 @@
+//! May-raise analysis
+//!
+//! Determines which functions, statements and expressions can leave an exception
+//! pending in the global exception state. Exceptions only originate from `raise`
+//! statements and from the few runtime functions that call `__pyc_raise`, so
+//! everything else is known not to raise and needs no `__pyc_has_exception` poll.
+//!
+//! The result is a conservative over-approximation: a function may raise if its
+//! body contains a raise or a call (direct or through a constructor's `__init__`)
+//! to a function that may raise. It is computed as a fixpoint over the call graph
+//! so that recursion is handled. A call of a virtual method may raise if any of
+//! its overrides may.
+
+use std::collections::HashMap;
+
+use super::decls::TirFunction;
+use super::dispatch::ClassHierarchy;
+use super::expr::{TirExpr, TirExprKind};
+use super::ids::FuncId;
+use super::program::TirProgram;
+use super::stmt::{TirLValue, TirStmt};
+
+/// Runtime functions that can call `__pyc_raise` (iterator exhaustion, missing
+/// keys, failed conversions, file errors).
+const RAISING_RUNTIME_FUNCS: &[&str] = &[
+    "__pyc___builtin___range___next__",
+    "__pyc___builtin___list_iterator___next__",
+    "__pyc___builtin___dict_iterator___next__",
+    "__pyc___builtin___set_iterator___next__",
+    // KeyError
+    "__pyc___builtin___dict___getitem__",
+    "__pyc___builtin___dict_pop",
+    "__pyc___builtin___set_remove",
+    // ValueError / OverflowError
+    "__pyc___builtin___str___int__",
+    "__pyc___builtin___str___float__",
+    "__pyc___builtin___float___int__",
+    // OSError / FileNotFoundError, and ValueError on a closed file
+    "__pyc___builtin___TextIO___init__",
+    "__pyc___builtin___TextIO_read",
+    "__pyc___builtin___TextIO_readline",
+    "__pyc___builtin___TextIO_write",
+    "__pyc___builtin___TextIO_close",
+    "__pyc___builtin___TextIO___next__",
+    "__pyc___builtin___TextIO___hasnext__",
+    "__pyc___builtin___BinaryIO___init__",
+    "__pyc___builtin___BinaryIO_read",
+    "__pyc___builtin___BinaryIO_write",
+    "__pyc___builtin___BinaryIO_close",
+];
+
+/// Per-function may-raise facts for a whole program
+#[derive(Debug, Clone)]
+pub struct MayRaise {
+    /// Indexed by FuncId
+    funcs: Vec<bool>,
+    /// Every implementation a call of a virtual method may run
+    overrides: HashMap<FuncId, Vec<FuncId>>,
+}
+
+impl MayRaise {
+    /// Run the analysis over every function in the program
+    pub fn analyze(program: &TirProgram, hierarchy: &ClassHierarchy) -> Self {
+        let mut analysis = MayRaise {
+            funcs: program.functions.iter().map(runtime_may_raise).collect(),
+            overrides: hierarchy.override_sets(),
+        };
+
+        // Propagate through the call graph until nothing changes
+        let mut changed = true;
+        while changed {
+            changed = false;
+            for func in &program.functions {
+                if func.runtime_name.is_some() || analysis.own(func.id) {
+                    continue;
+                }
+                if analysis.body(&func.body, program) {
+                    analysis.funcs[func.id.index()] = true;
+                    changed = true;
+                }
+            }
+        }
+
+        analysis
+    }
+
+    /// Whether calling the function can leave an exception pending
+    pub fn func(&self, id: FuncId) -> bool {
+        match self.overrides.get(&id) {
+            Some(targets) => targets.iter().any(|&target| self.own(target)),
+            None => self.own(id),
+        }
+    }
+
+    /// Whether the function body itself can leave an exception pending
+    fn own(&self, id: FuncId) -> bool {
+        self.funcs.get(id.index()).copied().unwrap_or(true)
+    }
+
+    /// Whether any statement in the list may raise
+    pub fn body(&self, stmts: &[TirStmt], program: &TirProgram) -> bool {
+        stmts.iter().any(|s| self.stmt(s, program))
+    }
+
+    /// Whether executing the statement may raise
+    pub fn stmt(&self, stmt: &TirStmt, program: &TirProgram) -> bool {
+        match stmt {
+            TirStmt::Let { init, .. } => self.expr(init, program),
+            TirStmt::Assign { target, value } => {
+                self.lvalue(target, program) || self.expr(value, program)
+            }
+            TirStmt::AugAssign { value, .. } => self.expr(value, program),
+            TirStmt::Expr(expr) => self.expr(expr, program),
+            TirStmt::Return(expr) => expr.as_ref().is_some_and(|e| self.expr(e, program)),
+            TirStmt::If {
+                cond,
+                then_body,
+                else_body,
+            } => {
+                self.expr(cond, program)
+                    || self.body(then_body, program)
+                    || self.body(else_body, program)
+            }
+            TirStmt::While { cond, body } => self.expr(cond, program) || self.body(body, program),
+            TirStmt::ForRange {
+                start, stop, body, ..
+            } => self.expr(start, program) || self.expr(stop, program) || self.body(body, program),
+            TirStmt::ForList { iterable, body, .. } => {
+                self.expr(iterable, program) || self.body(body, program)
+            }
+            // Handlers may not match and finally re-raises, so a try is only
+            // exception-free if none of its parts can raise.
+            TirStmt::Try {
+                body,
+                handlers,
+                orelse,
+                finalbody,
+            } => {
+                self.body(body, program)
+                    || handlers.iter().any(|h| self.body(&h.body, program))
+                    || self.body(orelse, program)
+                    || self.body(finalbody, program)
+            }
+            TirStmt::Raise { .. } => true,
+        }
+    }
+
+    /// Whether evaluating the expression may raise
+    pub fn expr(&self, expr: &TirExpr, program: &TirProgram) -> bool {
+        match &expr.kind {
+            TirExprKind::Constant(_) | TirExprKind::Var(_) | TirExprKind::Bytes { .. } => false,
+            TirExprKind::BinOp { left, right, .. } | TirExprKind::Compare { left, right, .. } => {
+                self.expr(left, program) || self.expr(right, program)
+            }
+            TirExprKind::BoolOp { values, .. } => values.iter().any(|v| self.expr(v, program)),
+            TirExprKind::UnaryOp { operand, .. } => self.expr(operand, program),
+            TirExprKind::Call { func, args } => {
+                self.func(*func) || args.iter().any(|a| self.expr(a, program))
+            }
+            TirExprKind::Construct { class, args } => {
+                let init_raises = program
+                    .class(*class)
+                    .get_method("__init__")
+                    .is_some_and(|init| self.func(init));
+                init_raises || args.iter().any(|a| self.expr(a, program))
+            }
+            TirExprKind::Range { start, stop, step } => {
+                start.as_ref().is_some_and(|e| self.expr(e, program))
+                    || self.expr(stop, program)
+                    || step.as_ref().is_some_and(|e| self.expr(e, program))
+            }
+            TirExprKind::FieldAccess { object, .. } => self.expr(object, program),
+            TirExprKind::List { elements, .. } | TirExprKind::Set { elements } => {
+                elements.iter().any(|e| self.expr(e, program))
+            }
+            TirExprKind::Dict { keys, values } => {
+                keys.iter().chain(values).any(|e| self.expr(e, program))
+            }
+        }
+    }
+
+    fn lvalue(&self, lvalue: &TirLValue, program: &TirProgram) -> bool {
+        match lvalue {
+            TirLValue::Var(_) => false,
+            TirLValue::Field { object, .. } => self.expr(object, program),
+        }
+    }
+}
+
+fn runtime_may_raise(func: &TirFunction) -> bool {
+    func.runtime_name
+        .as_deref()
+        .is_some_and(|name| RAISING_RUNTIME_FUNCS.contains(&name))
+}
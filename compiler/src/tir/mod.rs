@@ -17,14 +17,24 @@
 //!   compile-time guarantee that all types are fully resolved. Codegen only accepts this
 //!   representation, making it impossible for unresolved types to reach code generation.
 
+pub mod accumulators;
+pub mod bounds;
 pub mod decls;
 pub mod decls_unresolved;
+pub mod dispatch;
+pub mod escape;
+pub mod exception_ids;
 pub mod expr;
 pub mod expr_unresolved;
+pub mod fold;
 pub mod ids;
+pub mod layout;
 pub mod lower;
+pub mod may_raise;
+pub mod parallel;
 pub mod program;
 pub mod program_unresolved;
+pub mod purity;
 pub mod resolve;
 pub mod stmt;
 pub mod stmt_unresolved;
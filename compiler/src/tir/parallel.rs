@@ -0,0 +1,608 @@
+//! Parallel loops
+//!
+//! `for i in prange(n)` lowers to a ForRange with `parallel` set (the list form
+//! `for x in prange(xs)` counts the indices of `xs`). Codegen outlines the body
+//! and the runtime runs chunks of iterations on a pool of threads, in no
+//! particular order, so the iterations may only share state in ways that do
+//! not depend on that order:
+//!
+//! - A local first assigned in the body, the loop target included, is private:
+//!   every thread has its own copy, and it is gone after the loop.
+//! - A local of the enclosing function that the body only updates with
+//!   `total += e` or `total -= e` is a reduction, if it is an int that the body
+//!   does not otherwise use. Each chunk accumulates into a private copy that
+//!   starts at 0 and adds it to the local once, atomically.
+//! - Everything else from outside the loop may be read, and list and bytearray
+//!   elements may be stored (`out[i] = v`); the containers cannot change size.
+//!
+//! check_program rejects loops that break these rules directly: other writes to
+//! enclosing locals, writes to globals, `return`, and field stores or resizing
+//! calls (`append`, dict and set updates) on objects the body did not create.
+//! Functions the body calls are not inspected; they must not write shared
+//! state either.
+
+use std::collections::{HashMap, HashSet};
+
+use crate::ast::BinOperator;
+use crate::error::{CompilerError, Result};
+
+use super::expr::{TirExpr, TirExprKind, VarRef};
+use super::ids::LocalId;
+use super::program::TirProgram;
+use super::stmt::{TirLValue, TirStmt};
+use super::types::TirType;
+
+/// Runtime functions that resize their receiver (args[0])
+const RESIZING_FUNCS: &[&str] = &[
+    "__pyc___builtin___list_append",
+    "__pyc___builtin___bytearray_append",
+    "__pyc___builtin___bytearray_extend",
+    "__pyc___builtin___dict___setitem__",
+    "__pyc___builtin___dict_pop",
+    "__pyc___builtin___set_add",
+    "__pyc___builtin___set_discard",
+    "__pyc___builtin___set_remove",
+];
+
+/// How the locals of a function are shared by the iterations of one parallel loop
+#[derive(Debug, Clone, Default)]
+pub struct ParallelPlan {
+    /// Locals each thread gets its own copy of
+    pub private: HashSet<LocalId>,
+    /// Enclosing int locals the loop sums into, ordered by LocalId
+    pub reductions: Vec<LocalId>,
+}
+
+impl ParallelPlan {
+    /// The plan of a parallel ForRange over `locals`, the locals of the
+    /// function containing it
+    pub fn of(stmt: &TirStmt, locals: &[(String, TirType)]) -> Self {
+        let TirStmt::ForRange {
+            target,
+            counter,
+            body,
+            ..
+        } = stmt
+        else {
+            return Self::default();
+        };
+
+        let mut private = HashSet::from([*target, *counter]);
+        collect_definitions(body, &mut private);
+
+        let mut uses = Uses::default();
+        uses.body(body);
+        let mut reductions: Vec<LocalId> = uses
+            .sums
+            .iter()
+            .copied()
+            .filter(|local| {
+                !private.contains(local)
+                    && !uses.reads.contains(local)
+                    && !uses.writes.contains(local)
+                    && locals[local.index()].1 == TirType::Int
+            })
+            .collect();
+        reductions.sort_by_key(|local| local.index());
+
+        ParallelPlan {
+            private,
+            reductions,
+        }
+    }
+}
+
+/// The plans of the parallel loops of one function body, looked up by statement
+#[derive(Debug, Clone, Default)]
+pub struct ParallelPlans {
+    plans: HashMap<*const TirStmt, ParallelPlan>,
+}
+
+impl ParallelPlans {
+    pub fn analyze(body: &[TirStmt], locals: &[(String, TirType)]) -> Self {
+        let mut plans = HashMap::new();
+        for_each_parallel_loop(body, &mut |stmt| {
+            plans.insert(stmt as *const TirStmt, ParallelPlan::of(stmt, locals));
+        });
+        ParallelPlans { plans }
+    }
+
+    /// The plan of a parallel ForRange of the analyzed body
+    pub fn get(&self, stmt: &TirStmt) -> Option<&ParallelPlan> {
+        self.plans.get(&(stmt as *const TirStmt))
+    }
+}
+
+/// Reject parallel loops whose iterations could interfere (see the module docs)
+pub fn check_program(program: &TirProgram) -> Result<()> {
+    let bodies = program
+        .functions
+        .iter()
+        .map(|func| (&func.body, &func.locals))
+        .chain(
+            program
+                .modules
+                .iter()
+                .map(|module| (&module.init_body, &module.init_locals)),
+        );
+    for (body, locals) in bodies {
+        let mut result = Ok(());
+        for_each_parallel_loop(body, &mut |stmt| {
+            if result.is_ok() {
+                result = check_loop(stmt, locals, program);
+            }
+        });
+        result?;
+    }
+    Ok(())
+}
+
+fn check_loop(stmt: &TirStmt, locals: &[(String, TirType)], program: &TirProgram) -> Result<()> {
+    let TirStmt::ForRange { body, .. } = stmt else {
+        return Ok(());
+    };
+    let plan = ParallelPlan::of(stmt, locals);
+    let checker = Checker {
+        fresh: fresh_locals(body, &plan.private),
+        plan: &plan,
+        locals,
+        program,
+    };
+    checker.body(body)
+}
+
+/// Call `f` on every parallel loop in `body`, outer loops before the loops
+/// nested in them
+fn for_each_parallel_loop(body: &[TirStmt], f: &mut impl FnMut(&TirStmt)) {
+    for stmt in body {
+        match stmt {
+            TirStmt::If {
+                then_body,
+                else_body,
+                ..
+            } => {
+                for_each_parallel_loop(then_body, f);
+                for_each_parallel_loop(else_body, f);
+            }
+            TirStmt::ForRange { parallel, body, .. } => {
+                if *parallel {
+                    f(stmt);
+                }
+                for_each_parallel_loop(body, f);
+            }
+            TirStmt::While { body, .. } | TirStmt::ForList { body, .. } => {
+                for_each_parallel_loop(body, f)
+            }
+            TirStmt::Try {
+                body,
+                handlers,
+                orelse,
+                finalbody,
+            } => {
+                for_each_parallel_loop(body, f);
+                for handler in handlers {
+                    for_each_parallel_loop(&handler.body, f);
+                }
+                for_each_parallel_loop(orelse, f);
+                for_each_parallel_loop(finalbody, f);
+            }
+            _ => {}
+        }
+    }
+}
+
+/// Add every local `body` defines (its own loop variables included)
+fn collect_definitions(body: &[TirStmt], defined: &mut HashSet<LocalId>) {
+    for stmt in body {
+        match stmt {
+            TirStmt::Let { local, .. } => {
+                defined.insert(*local);
+            }
+            TirStmt::If {
+                then_body,
+                else_body,
+                ..
+            } => {
+                collect_definitions(then_body, defined);
+                collect_definitions(else_body, defined);
+            }
+            TirStmt::While { body, .. } => collect_definitions(body, defined),
+            TirStmt::ForRange {
+                target,
+                counter,
+                body,
+                ..
+            } => {
+                defined.insert(*target);
+                defined.insert(*counter);
+                collect_definitions(body, defined);
+            }
+            TirStmt::ForList {
+                target,
+                index,
+                body,
+                ..
+            } => {
+                defined.insert(*target);
+                defined.insert(*index);
+                collect_definitions(body, defined);
+            }
+            TirStmt::Try {
+                body,
+                handlers,
+                orelse,
+                finalbody,
+            } => {
+                collect_definitions(body, defined);
+                for handler in handlers {
+                    defined.extend(handler.local);
+                    collect_definitions(&handler.body, defined);
+                }
+                collect_definitions(orelse, defined);
+                collect_definitions(finalbody, defined);
+            }
+            _ => {}
+        }
+    }
+}
+
+/// Private locals that only ever hold objects the body itself creates
+fn fresh_locals(body: &[TirStmt], private: &HashSet<LocalId>) -> HashSet<LocalId> {
+    let mut assigned = Vec::new();
+    collect_assignments(body, &mut assigned);
+    let mut fresh: HashSet<LocalId> = private.clone();
+    for (local, value) in assigned {
+        let creates = matches!(
+            value.map(|v| &v.kind),
+            Some(
+                TirExprKind::Construct { .. }
+                    | TirExprKind::List { .. }
+                    | TirExprKind::Dict { .. }
+                    | TirExprKind::Set { .. }
+            )
+        );
+        if !creates {
+            fresh.remove(&local);
+        }
+    }
+    fresh
+}
+
+/// Every binding of a local in `body` with the value bound (None for loop
+/// variables and handler locals)
+fn collect_assignments<'a>(body: &'a [TirStmt], out: &mut Vec<(LocalId, Option<&'a TirExpr>)>) {
+    for stmt in body {
+        match stmt {
+            TirStmt::Let { local, init, .. } => out.push((*local, Some(init))),
+            TirStmt::Assign {
+                target: TirLValue::Var(VarRef::Local(local)),
+                value,
+            } => out.push((*local, Some(value))),
+            TirStmt::AugAssign {
+                target: VarRef::Local(local),
+                ..
+            } => out.push((*local, None)),
+            TirStmt::If {
+                then_body,
+                else_body,
+                ..
+            } => {
+                collect_assignments(then_body, out);
+                collect_assignments(else_body, out);
+            }
+            TirStmt::While { body, .. } => collect_assignments(body, out),
+            TirStmt::ForRange {
+                target,
+                counter,
+                body,
+                ..
+            } => {
+                out.push((*target, None));
+                out.push((*counter, None));
+                collect_assignments(body, out);
+            }
+            TirStmt::ForList {
+                target,
+                index,
+                body,
+                ..
+            } => {
+                out.push((*target, None));
+                out.push((*index, None));
+                collect_assignments(body, out);
+            }
+            TirStmt::Try {
+                body,
+                handlers,
+                orelse,
+                finalbody,
+            } => {
+                collect_assignments(body, out);
+                for handler in handlers {
+                    if let Some(local) = handler.local {
+                        out.push((local, None));
+                    }
+                    collect_assignments(&handler.body, out);
+                }
+                collect_assignments(orelse, out);
+                collect_assignments(finalbody, out);
+            }
+            _ => {}
+        }
+    }
+}
+
+/// How a loop body uses locals
+#[derive(Default)]
+struct Uses {
+    /// Targets of `+=` and `-=`
+    sums: HashSet<LocalId>,
+    /// Locals read by any expression
+    reads: HashSet<LocalId>,
+    /// Targets of every other assignment
+    writes: HashSet<LocalId>,
+}
+
+impl Uses {
+    fn body(&mut self, body: &[TirStmt]) {
+        for stmt in body {
+            self.stmt(stmt);
+        }
+    }
+
+    fn stmt(&mut self, stmt: &TirStmt) {
+        match stmt {
+            TirStmt::Let { init, .. } => self.expr(init),
+            TirStmt::Assign { target, value } => {
+                match target {
+                    TirLValue::Var(VarRef::Local(local)) => {
+                        self.writes.insert(*local);
+                    }
+                    TirLValue::Var(_) => {}
+                    TirLValue::Field { object, .. } => self.expr(object),
+                }
+                self.expr(value);
+            }
+            TirStmt::AugAssign { target, op, value } => {
+                if let VarRef::Local(local) = target {
+                    if matches!(op, BinOperator::Add | BinOperator::Sub) {
+                        self.sums.insert(*local);
+                    } else {
+                        self.writes.insert(*local);
+                    }
+                }
+                self.expr(value);
+            }
+            TirStmt::Expr(expr) | TirStmt::Return(Some(expr)) => self.expr(expr),
+            TirStmt::Return(None) => {}
+            TirStmt::If {
+                cond,
+                then_body,
+                else_body,
+            } => {
+                self.expr(cond);
+                self.body(then_body);
+                self.body(else_body);
+            }
+            TirStmt::While { cond, body } => {
+                self.expr(cond);
+                self.body(body);
+            }
+            TirStmt::ForRange {
+                start, stop, body, ..
+            } => {
+                self.expr(start);
+                self.expr(stop);
+                self.body(body);
+            }
+            TirStmt::ForList { iterable, body, .. } => {
+                self.expr(iterable);
+                self.body(body);
+            }
+            TirStmt::Try {
+                body,
+                handlers,
+                orelse,
+                finalbody,
+            } => {
+                self.body(body);
+                for handler in handlers {
+                    self.body(&handler.body);
+                }
+                self.body(orelse);
+                self.body(finalbody);
+            }
+            TirStmt::Raise { exc } => {
+                if let Some(exc) = exc {
+                    self.expr(exc);
+                }
+            }
+        }
+    }
+
+    fn expr(&mut self, expr: &TirExpr) {
+        visit_expr(expr, &mut |e| {
+            if let TirExprKind::Var(VarRef::Local(local)) = &e.kind {
+                self.reads.insert(*local);
+            }
+        });
+    }
+}
+
+/// Call `f` on `expr` and each of its subexpressions
+fn visit_expr(expr: &TirExpr, f: &mut impl FnMut(&TirExpr)) {
+    f(expr);
+    match &expr.kind {
+        TirExprKind::Constant(_) | TirExprKind::Var(_) | TirExprKind::Bytes { .. } => {}
+        TirExprKind::BinOp { left, right, .. } | TirExprKind::Compare { left, right, .. } => {
+            visit_expr(left, f);
+            visit_expr(right, f);
+        }
+        TirExprKind::UnaryOp { operand, .. } => visit_expr(operand, f),
+        TirExprKind::FieldAccess { object, .. } => visit_expr(object, f),
+        TirExprKind::Range { start, stop, step } => {
+            for e in start.iter().chain(Some(stop)).chain(step) {
+                visit_expr(e, f);
+            }
+        }
+        TirExprKind::BoolOp { values: exprs, .. }
+        | TirExprKind::Call { args: exprs, .. }
+        | TirExprKind::Construct { args: exprs, .. }
+        | TirExprKind::List {
+            elements: exprs, ..
+        }
+        | TirExprKind::Set { elements: exprs } => {
+            for e in exprs {
+                visit_expr(e, f);
+            }
+        }
+        TirExprKind::Dict { keys, values, .. } => {
+            for e in keys.iter().chain(values) {
+                visit_expr(e, f);
+            }
+        }
+    }
+}
+
+/// Checks the body of one parallel loop against its plan
+struct Checker<'a> {
+    plan: &'a ParallelPlan,
+    fresh: HashSet<LocalId>,
+    locals: &'a [(String, TirType)],
+    program: &'a TirProgram,
+}
+
+impl Checker<'_> {
+    fn error(&self, message: String) -> Result<()> {
+        Err(CompilerError::TypeErrorSimple(format!(
+            "prange loop: {}",
+            message
+        )))
+    }
+
+    fn name(&self, local: LocalId) -> &str {
+        &self.locals[local.index()].0
+    }
+
+    fn body(&self, body: &[TirStmt]) -> Result<()> {
+        for stmt in body {
+            self.stmt(stmt)?;
+        }
+        Ok(())
+    }
+
+    fn stmt(&self, stmt: &TirStmt) -> Result<()> {
+        match stmt {
+            TirStmt::Let { init, .. } => self.expr(init),
+            TirStmt::Assign { target, value } => {
+                match target {
+                    TirLValue::Var(var) => self.write(var, false)?,
+                    TirLValue::Field { object, .. } => {
+                        if !self.is_fresh(object) {
+                            return self.error(
+                                "cannot store to a field of an object shared by the iterations"
+                                    .to_string(),
+                            );
+                        }
+                        self.expr(object)?;
+                    }
+                }
+                self.expr(value)
+            }
+            TirStmt::AugAssign { target, op, value } => {
+                self.write(target, matches!(op, BinOperator::Add | BinOperator::Sub))?;
+                self.expr(value)
+            }
+            TirStmt::Expr(expr) => self.expr(expr),
+            TirStmt::Return(_) => self.error("cannot return from the loop body".to_string()),
+            TirStmt::If {
+                cond,
+                then_body,
+                else_body,
+            } => {
+                self.expr(cond)?;
+                self.body(then_body)?;
+                self.body(else_body)
+            }
+            TirStmt::While { cond, body } => {
+                self.expr(cond)?;
+                self.body(body)
+            }
+            TirStmt::ForRange {
+                start, stop, body, ..
+            } => {
+                self.expr(start)?;
+                self.expr(stop)?;
+                self.body(body)
+            }
+            TirStmt::ForList { iterable, body, .. } => {
+                self.expr(iterable)?;
+                self.body(body)
+            }
+            TirStmt::Try {
+                body,
+                handlers,
+                orelse,
+                finalbody,
+            } => {
+                self.body(body)?;
+                for handler in handlers {
+                    self.body(&handler.body)?;
+                }
+                self.body(orelse)?;
+                self.body(finalbody)
+            }
+            TirStmt::Raise { exc } => match exc {
+                Some(exc) => self.expr(exc),
+                None => Ok(()),
+            },
+        }
+    }
+
+    /// An assignment to `var`; `sum` for `+=` and `-=`
+    fn write(&self, var: &VarRef, sum: bool) -> Result<()> {
+        match var {
+            VarRef::Local(local) if self.plan.private.contains(local) => Ok(()),
+            VarRef::Local(local) if sum && self.plan.reductions.contains(local) => Ok(()),
+            VarRef::Local(local) if sum => self.error(format!(
+                "'{}' is shared by the iterations; only an int the loop does not \
+                 otherwise use can be summed into with += or -=",
+                self.name(*local)
+            )),
+            VarRef::Local(local) => self.error(format!(
+                "cannot assign to '{}', which is shared by the iterations",
+                self.name(*local)
+            )),
+            VarRef::Global(..) => self.error("cannot assign to a global variable".to_string()),
+            VarRef::Param(_) | VarRef::SelfRef => {
+                self.error("cannot assign to a parameter".to_string())
+            }
+        }
+    }
+
+    fn expr(&self, expr: &TirExpr) -> Result<()> {
+        let mut result = Ok(());
+        visit_expr(expr, &mut |e| {
+            let TirExprKind::Call { func, args } = &e.kind else {
+                return;
+            };
+            let resizes = self
+                .program
+                .function(*func)
+                .runtime_name
+                .as_deref()
+                .is_some_and(|name| RESIZING_FUNCS.contains(&name));
+            if resizes && result.is_ok() && !args.first().is_some_and(|arg| self.is_fresh(arg)) {
+                result = self.error(
+                    "cannot add to or remove from a container shared by the iterations".to_string(),
+                );
+            }
+        });
+        result
+    }
+
+    /// Whether `expr` is a private local holding an object the body created
+    fn is_fresh(&self, expr: &TirExpr) -> bool {
+        matches!(&expr.kind, TirExprKind::Var(VarRef::Local(local)) if self.fresh.contains(local))
+    }
+}
@@ -0,0 +1,153 @@
+//! Purity analysis
+//!
+//! Finds the functions whose result depends only on their arguments: free
+//! functions over `int`, `float`, `bool` and `str` values whose bodies use only
+//! locals and parameters, arithmetic, comparisons, branches, `while` and
+//! `for ... in range(...)` loops, and calls of other pure functions. They read no
+//! globals or objects and write nothing but their locals, so a call with
+//! constant arguments can be evaluated at compile time (see `fold`).
+//!
+//! Pure is not total: a pure function may still loop forever or trap (division
+//! by zero), so a call whose result is unused is kept, and `fold` leaves such a
+//! call to run when its evaluation fails or runs out of fuel.
+//!
+//! Like the may-raise analysis, it is a fixpoint over the call graph, but from
+//! the other end: every candidate starts pure and loses it when its body calls a
+//! function that is not, so recursive functions can be pure.
+
+use super::decls::TirFunction;
+use super::expr::{TirConstant, TirExpr, TirExprKind, VarRef};
+use super::ids::FuncId;
+use super::program::TirProgram;
+use super::stmt::{TirLValue, TirStmt};
+use super::types::TirType;
+
+/// Per-function purity facts for a whole program
+#[derive(Debug, Clone)]
+pub struct Purity {
+    /// Indexed by FuncId
+    funcs: Vec<bool>,
+}
+
+impl Purity {
+    /// Run the analysis over every function in the program
+    pub fn analyze(program: &TirProgram) -> Self {
+        let mut analysis = Purity {
+            funcs: program
+                .functions
+                .iter()
+                .map(|func| pure_signature(func, program))
+                .collect(),
+        };
+
+        let mut changed = true;
+        while changed {
+            changed = false;
+            for func in &program.functions {
+                if analysis.funcs[func.id.index()] && !analysis.body(&func.body, program) {
+                    analysis.funcs[func.id.index()] = false;
+                    changed = true;
+                }
+            }
+        }
+
+        analysis
+    }
+
+    /// Whether the function's result depends only on its arguments
+    pub fn func(&self, id: FuncId) -> bool {
+        self.funcs.get(id.index()).copied().unwrap_or(false)
+    }
+
+    fn body(&self, stmts: &[TirStmt], program: &TirProgram) -> bool {
+        stmts.iter().all(|s| self.stmt(s, program))
+    }
+
+    fn stmt(&self, stmt: &TirStmt, program: &TirProgram) -> bool {
+        match stmt {
+            TirStmt::Let { init, .. } => self.expr(init, program),
+            TirStmt::Assign {
+                target: TirLValue::Var(var),
+                value,
+            }
+            | TirStmt::AugAssign {
+                target: var, value, ..
+            } => local_var(var) && self.expr(value, program),
+            TirStmt::Assign { .. } => false,
+            TirStmt::Expr(expr) | TirStmt::Return(Some(expr)) => self.expr(expr, program),
+            TirStmt::If {
+                cond,
+                then_body,
+                else_body,
+            } => {
+                self.expr(cond, program)
+                    && self.body(then_body, program)
+                    && self.body(else_body, program)
+            }
+            TirStmt::While { cond, body } => self.expr(cond, program) && self.body(body, program),
+            TirStmt::ForRange {
+                start,
+                stop,
+                parallel,
+                body,
+                ..
+            } => {
+                !parallel
+                    && self.expr(start, program)
+                    && self.expr(stop, program)
+                    && self.body(body, program)
+            }
+            TirStmt::Return(None)
+            | TirStmt::ForList { .. }
+            | TirStmt::Try { .. }
+            | TirStmt::Raise { .. } => false,
+        }
+    }
+
+    fn expr(&self, expr: &TirExpr, program: &TirProgram) -> bool {
+        match &expr.kind {
+            TirExprKind::Constant(constant) => *constant != TirConstant::None,
+            TirExprKind::Var(var) => local_var(var),
+            TirExprKind::BinOp { left, right, .. } | TirExprKind::Compare { left, right, .. } => {
+                self.expr(left, program) && self.expr(right, program)
+            }
+            TirExprKind::BoolOp { values, .. } => values.iter().all(|v| self.expr(v, program)),
+            TirExprKind::UnaryOp { operand, .. } => self.expr(operand, program),
+            TirExprKind::Call { func, args } => {
+                self.func(*func) && args.iter().all(|a| self.expr(a, program))
+            }
+            TirExprKind::Construct { .. }
+            | TirExprKind::Range { .. }
+            | TirExprKind::FieldAccess { .. }
+            | TirExprKind::List { .. }
+            | TirExprKind::Dict { .. }
+            | TirExprKind::Set { .. }
+            | TirExprKind::Bytes { .. } => false,
+        }
+    }
+}
+
+/// Whether values of the type are immutable scalars or strings
+pub fn is_value_type(ty: &TirType, program: &TirProgram) -> bool {
+    match ty {
+        TirType::Int | TirType::Float | TirType::Bool => true,
+        TirType::Class(id) => program.class(*id).qualified_name == "__builtin__.str",
+        TirType::Void => false,
+    }
+}
+
+/// A free user function that takes, returns and stores only values
+fn pure_signature(func: &TirFunction, program: &TirProgram) -> bool {
+    func.runtime_name.is_none()
+        && func.class.is_none()
+        && is_value_type(&func.return_type, program)
+        && func
+            .params
+            .iter()
+            .chain(&func.locals)
+            .all(|(_, ty)| is_value_type(ty, program))
+}
+
+fn local_var(var: &VarRef) -> bool {
+    matches!(var, VarRef::Local(_) | VarRef::Param(_))
+}
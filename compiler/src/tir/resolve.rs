@@ -76,6 +76,34 @@ fn resolve_stmt(
             cond: resolve_expr(cond, substitutions, symbols)?,
             body: resolve_body(body, substitutions, symbols)?,
         }),
+        TirStmtUnresolved::ForRange {
+            target,
+            counter,
+            start,
+            stop,
+            step,
+            parallel,
+            body,
+        } => Ok(TirStmt::ForRange {
+            target,
+            counter,
+            start: resolve_expr(start, substitutions, symbols)?,
+            stop: resolve_expr(stop, substitutions, symbols)?,
+            step,
+            parallel,
+            body: resolve_body(body, substitutions, symbols)?,
+        }),
+        TirStmtUnresolved::ForList {
+            target,
+            index,
+            iterable,
+            body,
+        } => Ok(TirStmt::ForList {
+            target,
+            index,
+            iterable: resolve_expr(iterable, substitutions, symbols)?,
+            body: resolve_body(body, substitutions, symbols)?,
+        }),
         TirStmtUnresolved::Try {
             body,
             handlers,
@@ -266,6 +294,22 @@ fn resolve_expr(
                 elem_ty: resolve_type(&elem_ty, substitutions, symbols)?,
             }
         }
+        TirExprKindUnresolved::Dict { keys, values } => TirExprKind::Dict {
+            keys: keys
+                .into_iter()
+                .map(|key| resolve_expr(key, substitutions, symbols))
+                .collect::<Result<Vec<_>>>()?,
+            values: values
+                .into_iter()
+                .map(|value| resolve_expr(value, substitutions, symbols))
+                .collect::<Result<Vec<_>>>()?,
+        },
+        TirExprKindUnresolved::Set { elements } => TirExprKind::Set {
+            elements: elements
+                .into_iter()
+                .map(|elem| resolve_expr(elem, substitutions, symbols))
+                .collect::<Result<Vec<_>>>()?,
+        },
         TirExprKindUnresolved::Bytes { data } => TirExprKind::Bytes { data },
     };
 
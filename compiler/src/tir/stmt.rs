@@ -72,6 +72,31 @@ pub enum TirStmt {
     /// While loop
     While { cond: TirExpr, body: Vec<TirStmt> },
 
+    /// Counted loop: `for target in range(start, stop, step)` with a constant step.
+    /// `counter` is a hidden induction variable so that rebinding `target` in
+    /// the body does not affect iteration. `stop` is evaluated once.
+    /// `parallel` loops come from `prange` and always have step 1; their
+    /// iterations run concurrently (see tir/parallel.rs).
+    ForRange {
+        target: LocalId,
+        counter: LocalId,
+        start: TirExpr,
+        stop: TirExpr,
+        step: i64,
+        parallel: bool,
+        body: Vec<TirStmt>,
+    },
+
+    /// Indexed loop over a builtin list: `for target in some_list`.
+    /// `index` is a hidden position counter; the list length is re-read on every
+    /// iteration so appends made by the body are observed, as with the iterator.
+    ForList {
+        target: LocalId,
+        index: LocalId,
+        iterable: TirExpr,
+        body: Vec<TirStmt>,
+    },
+
     /// Try/except/finally statement
     Try {
         body: Vec<TirStmt>,
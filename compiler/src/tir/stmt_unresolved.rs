@@ -83,6 +83,26 @@ pub enum TirStmtUnresolved {
         body: Vec<TirStmtUnresolved>,
     },
 
+    /// Counted loop over range(start, stop, step) with a constant, non-zero step,
+    /// or over prange(start, stop) when `parallel`
+    ForRange {
+        target: LocalId,
+        counter: LocalId,
+        start: TirExprUnresolved,
+        stop: TirExprUnresolved,
+        step: i64,
+        parallel: bool,
+        body: Vec<TirStmtUnresolved>,
+    },
+
+    /// Indexed loop over a builtin list
+    ForList {
+        target: LocalId,
+        index: LocalId,
+        iterable: TirExprUnresolved,
+        body: Vec<TirStmtUnresolved>,
+    },
+
     /// Try/except/finally statement
     Try {
         body: Vec<TirStmtUnresolved>,
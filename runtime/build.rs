@@ -638,17 +638,27 @@ fn build_runtime_for_target(
     manifest_dir: &Path,
     musl_prefix: &Path,
     icu_prefix: &Path,
+    icu_lib_dir: &Path,
     target: &str,
 ) -> PathBuf {
     let c_files = [
         "src/list.c",
+        "src/dict.c",
         "src/builtins.c",
+        "src/io.c",
+        "src/format.c",
         "src/class.c",
         "src/bytearray.c",
         "src/str.c",
+        "src/strkernel.c",
         "src/bytes.c",
         "src/exception.c",
         "src/range.c",
+        "src/memory.c",
+        "src/gc.c",
+        "src/parallel.c",
+        "src/file.c",
+        "src/profile.c",
         "src/glibc_compat.c", // Compatibility shims for glibc functions (needed for system ICU)
     ];
 
@@ -671,6 +681,16 @@ fn build_runtime_for_target(
         _ => panic!("Unsupported target: {}", target),
     };
 
+    let clang_path = if target == "riscv64" {
+        if let Ok(llvm_prefix) = env::var("LLVM_SYS_211_PREFIX") {
+            format!("{}/bin/clang", llvm_prefix)
+        } else {
+            "clang".to_string()
+        }
+    } else {
+        "clang".to_string()
+    };
+
     // Compile each C file to LLVM bitcode (.bc)
     for c_file in &c_files {
         let bc_file = out_path.join(format!(
@@ -679,16 +699,6 @@ fn build_runtime_for_target(
             target
         ));
 
-        let clang_path = if target == "riscv64" {
-            if let Ok(llvm_prefix) = env::var("LLVM_SYS_211_PREFIX") {
-                format!("{}/bin/clang", llvm_prefix)
-            } else {
-                "clang".to_string()
-            }
-        } else {
-            "clang".to_string()
-        };
-
         let mut cmd = Command::new(&clang_path);
         cmd.args(["-c", "-emit-llvm", "-O2"]);
 
@@ -711,6 +721,11 @@ fn build_runtime_for_target(
             cmd.arg("-DNO_ICU=1");
         }
 
+        // PYC_ALLOCATOR=system swaps the pooled allocator for plain malloc/free
+        if env::var("PYC_ALLOCATOR").as_deref() == Ok("system") {
+            cmd.arg("-DPYC_ALLOCATOR_SYSTEM=1");
+        }
+
         let c_file_path = manifest_dir.join(c_file);
         cmd.arg(&c_file_path).arg("-o").arg(&bc_file);
 
@@ -748,9 +763,184 @@ fn build_runtime_for_target(
         panic!("Failed to link runtime bitcode files for {}", target);
     }
 
+    // ICU data packages the compiler links in place of libicudata.a
+    if icu_available {
+        let compiler = ObjectCompiler {
+            clang_path: &clang_path,
+            clang_target,
+            include_paths: &include_paths,
+            target,
+        };
+        build_icu_data_objects(out_path, manifest_dir, icu_lib_dir, &compiler);
+    }
+
     output_file
 }
 
+/// How to compile a C or assembly file to a native object for a target
+struct ObjectCompiler<'a> {
+    clang_path: &'a str,
+    clang_target: Option<&'a str>,
+    include_paths: &'a [PathBuf],
+    target: &'a str,
+}
+
+impl ObjectCompiler<'_> {
+    fn compile(&self, source: &Path, object: &Path) -> bool {
+        let mut cmd = Command::new(self.clang_path);
+        cmd.args(["-c", "-O2", "-nostdinc"]);
+        for include_path in self.include_paths {
+            cmd.arg(format!("-isystem{}", include_path.display()));
+        }
+        if let Some(target_flag) = self.clang_target {
+            cmd.arg(target_flag);
+        }
+        if self.target == "riscv64" {
+            cmd.arg("-mabi=lp64d");
+        }
+        cmd.arg(source).arg("-o").arg(object);
+
+        eprintln!("Running: {:?}", cmd);
+        cmd.status().is_ok_and(|status| status.success())
+    }
+}
+
+/// Build the ICU data packages a program can link instead of all of
+/// libicudata.a (see the compiler's `IcuUse`):
+///   icu-stubdata-{target}.o  an empty package, for programs that only use the
+///                            tables compiled into libicuuc
+///   icu-nfkc-{target}.o      only the NFKC tables, for NFKC/NFKD normalization;
+///                            left out when the ICU tools or the full package
+///                            cannot be found, and such programs link it all
+fn build_icu_data_objects(
+    out_path: &Path,
+    manifest_dir: &Path,
+    icu_lib_dir: &Path,
+    compiler: &ObjectCompiler,
+) {
+    let target = compiler.target;
+    let stub = out_path.join(format!("icu-stubdata-{}.o", target));
+    if !compiler.compile(&manifest_dir.join("src/icu_stubdata.c"), &stub) {
+        panic!("Failed to compile the ICU stub data for {}", target);
+    }
+
+    let nfkc = out_path.join(format!("icu-nfkc-{}.o", target));
+    fs::remove_file(&nfkc).ok();
+    let Some((package, entry_point)) = build_icu_nfkc_package(out_path, icu_lib_dir, target) else {
+        eprintln!(
+            "NOTE: no NFKC-only ICU data for {}; NFKC/NFKD programs link all of libicudata.a",
+            target
+        );
+        return;
+    };
+    let source = out_path.join(format!("icu-nfkc-{}.S", target));
+    let assembly = format!(
+        ".section .rodata\n.balign 16\n.globl {entry_point}\n{entry_point}:\n.incbin \"{}\"\n",
+        package.display()
+    );
+    fs::write(&source, assembly).expect("Failed to write the ICU NFKC data source");
+    if !compiler.compile(&source, &nfkc) {
+        fs::remove_file(&nfkc).ok();
+        eprintln!(
+            "NOTE: failed to compile the NFKC-only ICU data for {}",
+            target
+        );
+    }
+}
+
+/// Cut an ICU data package holding only nfkc.nrm out of the full one.
+/// Returns the package and the symbol ICU looks it up by.
+fn build_icu_nfkc_package(
+    out_path: &Path,
+    icu_lib_dir: &Path,
+    target: &str,
+) -> Option<(PathBuf, String)> {
+    let work = out_path.join(format!("icu-data-{}", target));
+    fs::remove_dir_all(&work).ok();
+    for dir in ["full", "items", "subset"] {
+        fs::create_dir_all(work.join(dir)).ok()?;
+    }
+
+    let full = find_icu_data_package(out_path, icu_lib_dir, &work)?;
+    let name = full.file_stem()?.to_str()?.to_string(); // e.g. icudt74l
+
+    // Prefer the icupkg of an ICU source build, which matches its data
+    let native_icupkg = out_path.join("icu-native-build/bin/icupkg");
+    let icupkg = if native_icupkg.exists() {
+        native_icupkg
+    } else {
+        PathBuf::from("icupkg")
+    };
+    let run = |cmd: &mut Command| cmd.status().is_ok_and(|status| status.success());
+
+    let items = work.join("items");
+    if !run(Command::new(&icupkg)
+        .args(["-x", "nfkc.nrm", "-d"])
+        .arg(&items)
+        .arg(&full))
+    {
+        return None;
+    }
+    let list = work.join("nfkc.lst");
+    fs::write(&list, "nfkc.nrm\n").ok()?;
+    let package = work.join("subset").join(format!("{}.dat", name));
+    if !run(Command::new(&icupkg)
+        .arg("-s")
+        .arg(&items)
+        .arg("-a")
+        .arg(&list)
+        .arg("new")
+        .arg(&package))
+    {
+        return None;
+    }
+
+    // icudt74l -> icudt74_dat: the entry point drops the endianness letter
+    let entry_point = format!("{}_dat", &name[..name.len() - 1]);
+    Some((package, entry_point))
+}
+
+/// The full ICU data package: the .dat file of an ICU source build, or the
+/// contents of the one object in libicudata.a
+fn find_icu_data_package(out_path: &Path, icu_lib_dir: &Path, work: &Path) -> Option<PathBuf> {
+    let source_data = out_path.join(format!("icu-{}/source/data/in", ICU_VERSION));
+    if let Ok(entries) = fs::read_dir(&source_data) {
+        for entry in entries.flatten() {
+            let file_name = entry.file_name().to_string_lossy().into_owned();
+            if file_name.starts_with("icudt") && file_name.ends_with(".dat") {
+                return Some(entry.path());
+            }
+        }
+    }
+
+    let archive = icu_lib_dir.join("libicudata.a");
+    let output = Command::new("ar").arg("t").arg(&archive).output().ok()?;
+    if !output.status.success() {
+        return None;
+    }
+    let members = String::from_utf8_lossy(&output.stdout);
+    let member = members.lines().next()?.trim().to_string(); // e.g. icudt74l_dat.o
+    let name = member.strip_suffix("_dat.o")?;
+    let status = Command::new("ar")
+        .arg("x")
+        .arg(&archive)
+        .arg(&member)
+        .current_dir(work)
+        .status()
+        .ok()?;
+    if !status.success() {
+        return None;
+    }
+    let package = work.join("full").join(format!("{}.dat", name));
+    let status = Command::new("llvm-objcopy")
+        .args(["-O", "binary", "--only-section=.rodata"])
+        .arg(work.join(&member))
+        .arg(&package)
+        .status()
+        .ok()?;
+    status.success().then_some(package)
+}
+
 fn main() {
     let out_dir = env::var("OUT_DIR").unwrap();
     let out_path = PathBuf::from(&out_dir);
@@ -813,7 +1003,14 @@ fn main() {
         eprintln!("Set {} = {}", libcxx_var, libcxx_lib);
 
         // Build C runtime for this architecture
-        build_runtime_for_target(&out_path, &manifest_path, &musl_prefix, &icu_prefix, target);
+        build_runtime_for_target(
+            &out_path,
+            &manifest_path,
+            &musl_prefix,
+            &icu_prefix,
+            &icu_lib_dir,
+            target,
+        );
     }
 
     // Tell cargo to rerun if C files change
@@ -822,16 +1019,36 @@ fn main() {
     println!("cargo:rerun-if-changed=src/class.c");
     println!("cargo:rerun-if-changed=src/bytearray.c");
     println!("cargo:rerun-if-changed=src/str.c");
+    println!("cargo:rerun-if-changed=src/strkernel.c");
+    println!("cargo:rerun-if-changed=src/strkernel.h");
     println!("cargo:rerun-if-changed=src/bytes.c");
     println!("cargo:rerun-if-changed=src/runtime.h");
     println!("cargo:rerun-if-changed=src/types.h");
     println!("cargo:rerun-if-changed=src/memory.h");
+    println!("cargo:rerun-if-changed=src/io.c");
     println!("cargo:rerun-if-changed=src/io.h");
+    println!("cargo:rerun-if-changed=src/format.c");
+    println!("cargo:rerun-if-changed=src/format.h");
     println!("cargo:rerun-if-changed=src/str.h");
     println!("cargo:rerun-if-changed=src/bytes.h");
     println!("cargo:rerun-if-changed=src/exception.c");
     println!("cargo:rerun-if-changed=src/exception.h");
     println!("cargo:rerun-if-changed=src/range.c");
+    println!("cargo:rerun-if-changed=src/memory.c");
+    println!("cargo:rerun-if-changed=src/gc.c");
+    println!("cargo:rerun-if-changed=src/parallel.c");
+    println!("cargo:rerun-if-changed=src/parallel.h");
+    println!("cargo:rerun-if-changed=src/file.c");
+    println!("cargo:rerun-if-changed=src/file.h");
+    println!("cargo:rerun-if-changed=src/gc.h");
+    println!("cargo:rerun-if-changed=src/dict.c");
+    println!("cargo:rerun-if-changed=src/dict.h");
+    println!("cargo:rerun-if-changed=src/profile.c");
+    println!("cargo:rerun-if-changed=src/profile.h");
+    println!("cargo:rerun-if-changed=src/icu_stubdata.c");
+
+    // Rerun if the allocator selection changes
+    println!("cargo:rerun-if-env-changed=PYC_ALLOCATOR");
 
     // Rerun if musl environment variables change
     println!("cargo:rerun-if-env-changed=MUSL_X86_64_PREFIX");
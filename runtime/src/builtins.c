@@ -4,26 +4,174 @@
 
 // ============================================================================
 // Built-in print functions
+//
+// print(a, b, c) lowers to one call per argument; each call appends the value
+// and the separator that follows it (a space, or the newline after the last
+// argument) to the stdout buffer in a single step. While a parallel loop runs
+// the values go to the thread's line instead, which the last argument appends
+// to stdout as a whole (see rt_print_parallel).
 // ============================================================================
 
-void __pyc___builtin___int___print__(int64_t value) {
-    char buffer[21];
-    snprintf(buffer, sizeof(buffer), "%ld", value);
-    write_stdout(buffer, strlen(buffer));
+static inline void print_separator(int8_t end_line) {
+    if (end_line) {
+        write_line_end();
+    } else {
+        write_char(' ');
+    }
 }
 
-void __pyc___builtin___bool___print__(int8_t value) {
-    if (value) {
-        write_stdout("True", 4);
-    } else {
-        write_stdout("False", 5);
+void __pyc___builtin___int___print__(int64_t value, int8_t end_line) {
+    if (rt_parallel_running()) {
+        char digits[20];
+        rt_print_parallel(digits, rt_format_int64(value, digits), end_line);
+        return;
+    }
+    // 20 characters for the value, one for the separator
+    char* out = rt_stdout_reserve(21);
+    size_t len = rt_format_int64(value, out);
+    out[len] = end_line ? '\n' : ' ';
+    rt_stdout_len += len + 1;
+    if (end_line && rt_stdout_line_buffered) {
+        rt_stdout_flush();
+    }
+}
+
+void __pyc___builtin___bool___print__(int8_t value, int8_t end_line) {
+    const char* text = value ? "True" : "False";
+    size_t len = value ? 4 : 5;
+    if (rt_parallel_running()) {
+        rt_print_parallel(text, len, end_line);
+        return;
+    }
+    write_stdout(text, len);
+    print_separator(end_line);
+}
+
+void __pyc___builtin___float___print__(double value, int8_t end_line) {
+    if (rt_parallel_running()) {
+        char repr[RT_FLOAT_MAX_CHARS];
+        rt_print_parallel(repr, rt_format_float(value, repr), end_line);
+        return;
+    }
+    // The longest repr, one character for the separator
+    char* out = rt_stdout_reserve(RT_FLOAT_MAX_CHARS + 1);
+    size_t len = rt_format_float(value, out);
+    out[len] = end_line ? '\n' : ' ';
+    rt_stdout_len += len + 1;
+    if (end_line && rt_stdout_line_buffered) {
+        rt_stdout_flush();
+    }
+}
+
+void __pyc___builtin___str___print__(String* str, int8_t end_line) {
+    const char* data = str != NULL ? str->data : "";
+    size_t len = str != NULL ? (size_t)str->len : 0;
+    if (rt_parallel_running()) {
+        rt_print_parallel(data, len, end_line);
+        return;
+    }
+    write_stdout(data, len);
+    print_separator(end_line);
+}
+
+// ============================================================================
+// Conversions: str(), int() and float()
+// ============================================================================
+
+// A String of `len` ASCII characters, to be filled in by the caller
+static String* ascii_string_alloc(size_t len) {
+    String* s = string_alloc((int64_t)len);
+    s->len = (int64_t)len;
+    s->flags = STR_FLAG_ASCII_ONLY | STR_FLAG_VALID_UTF8;
+    s->cp_count = (int32_t)len;
+    s->data[len] = '\0';
+    return s;
+}
+
+String* __pyc___builtin___int___str__(int64_t value) {
+    String* s = ascii_string_alloc(rt_int64_len(value));
+    rt_format_int64(value, s->data);
+    return s;
+}
+
+String* __pyc___builtin___float___str__(double value) {
+    char buffer[RT_FLOAT_MAX_CHARS];
+    size_t len = rt_format_float(value, buffer);
+    String* s = ascii_string_alloc(len);
+    memcpy(s->data, buffer, len);
+    return s;
+}
+
+STATIC_STRING(true_string, "True");
+STATIC_STRING(false_string, "False");
+
+String* __pyc___builtin___bool___str__(int8_t value) {
+    return value ? true_string : false_string;
+}
+
+static void raise_conversion_error(RtExceptionKind kind, const char* prefix, String* text) {
+    size_t prefix_len = strlen(prefix);
+    String* repr = text ? STR_METHOD(__repr__)(text) : NULL;
+    size_t repr_len = repr ? (size_t)repr->len : 0;
+
+    String* message = string_alloc((int64_t)(prefix_len + repr_len));
+    message->len = (int64_t)(prefix_len + repr_len);
+    message->flags = repr ? repr->flags : (STR_FLAG_ASCII_ONLY | STR_FLAG_VALID_UTF8);
+    message->cp_count = -1;
+    memcpy(message->data, prefix, prefix_len);
+    if (repr) {
+        memcpy(message->data + prefix_len, repr->data, repr_len);
+        STR_METHOD(free)(repr);
     }
+    message->data[prefix_len + repr_len] = '\0';
+
+    __pyc_raise(rt_exception_new(kind, message));
 }
 
-void __pyc___builtin___float___print__(double value) {
-    char buffer[32];
-    snprintf(buffer, sizeof(buffer), "%g", value);
-    write_stdout(buffer, strlen(buffer));
+int64_t STR_METHOD(__int__)(String* s) {
+    int64_t value = 0;
+    switch (rt_parse_int64(s->data, (size_t)s->len, &value)) {
+        case RT_PARSE_OK:
+            break;
+        case RT_PARSE_INVALID:
+            raise_conversion_error(RT_EXC_VALUE_ERROR,
+                                   "invalid literal for int() with base 10: ", s);
+            break;
+        case RT_PARSE_OVERFLOW:
+            raise_conversion_error(RT_EXC_OVERFLOW_ERROR, "int too large to convert: ", s);
+            break;
+    }
+    return value;
+}
+
+double STR_METHOD(__float__)(String* s) {
+    double value = 0.0;
+    if (rt_parse_float(s->data, (size_t)s->len, &value) != RT_PARSE_OK) {
+        raise_conversion_error(RT_EXC_VALUE_ERROR, "could not convert string to float: ", s);
+    }
+    return value;
+}
+
+int64_t __pyc___builtin___float___int__(double value) {
+    if (value != value) {
+        raise_conversion_error(RT_EXC_VALUE_ERROR, "cannot convert float NaN to integer", NULL);
+        return 0;
+    }
+    // The int64 range is [-2^63, 2^63)
+    if (!(value >= -9223372036854775808.0 && value < 9223372036854775808.0)) {
+        if (value == __builtin_inf() || value == -__builtin_inf()) {
+            raise_conversion_error(RT_EXC_OVERFLOW_ERROR,
+                                   "cannot convert float infinity to integer", NULL);
+        } else {
+            raise_conversion_error(RT_EXC_OVERFLOW_ERROR, "int too large to convert", NULL);
+        }
+        return 0;
+    }
+    return (int64_t)value;
+}
+
+double __pyc___builtin___int___float__(int64_t value) {
+    return (double)value;
 }
 
 // ============================================================================
@@ -45,14 +193,19 @@ void write_char_impl(char c) {
 }
 
 void write_newline_impl(void) {
-    putchar('\n');
+    // print() with no arguments
+    if (rt_parallel_running()) {
+        rt_print_parallel("", 0, 1);
+        return;
+    }
+    write_line_end();
 }
 
 void write_space_impl(void) {
-    putchar(' ');
+    write_char(' ');
 }
 
 char* int64_to_str_impl(int64_t value, char* buffer) {
-    snprintf(buffer, 21, "%ld", value);
+    buffer[rt_format_int64(value, buffer)] = '\0';
     return buffer;
 }
@@ -1,16 +1,18 @@
 #include "runtime.h"
+#include "strkernel.h"
 #include <stdlib.h>
 #include <string.h>
 
-ByteArray* BYTEARRAY_METHOD(__init__)(void) {
-    ByteArray* ba = (ByteArray*)malloc(sizeof(ByteArray));
+// A bytearray of len bytes (left uninitialized) with room for cap
+static ByteArray* bytearray_alloc(int64_t len, int64_t cap) {
+    ByteArray* ba = (ByteArray*)rt_alloc_object(sizeof(ByteArray), RT_KIND_BYTEARRAY);
     if (ba == NULL) {
         rt_panic("Failed to allocate memory for bytearray");
     }
 
-    ba->cap = 8;
-    ba->len = 0;
-    ba->data = (uint8_t*)malloc(ba->cap);
+    ba->cap = cap < 8 ? 8 : cap;
+    ba->len = len;
+    ba->data = (uint8_t*)rt_alloc((size_t)ba->cap);
 
     if (ba->data == NULL) {
         rt_panic("Failed to allocate memory for bytearray data");
@@ -19,6 +21,36 @@ ByteArray* BYTEARRAY_METHOD(__init__)(void) {
     return ba;
 }
 
+// Grow the buffer to hold at least need bytes, at least doubling it so a run
+// of appends or extends costs amortized O(1) per byte
+static void bytearray_reserve(ByteArray* ba, int64_t need) {
+    if (need <= ba->cap) return;
+    int64_t cap = ba->cap * 2;
+    if (cap < need) cap = need;
+    ba->data = (uint8_t*)rt_realloc(ba->data, (size_t)ba->cap, (size_t)cap);
+    ba->cap = cap;
+}
+
+ByteArray* BYTEARRAY_METHOD(__init__)(void) {
+    return bytearray_alloc(0, 8);
+}
+
+ByteArray* BYTEARRAY_METHOD(from_bytes)(Bytes* b) {
+    int64_t len = b ? b->len : 0;
+    ByteArray* ba = bytearray_alloc(len, len);
+    if (len > 0) memcpy(ba->data, b->data, (size_t)len);
+    return ba;
+}
+
+ByteArray* BYTEARRAY_METHOD(zeros)(int64_t len) {
+    if (len < 0) {
+        rt_panic("negative count");
+    }
+    ByteArray* ba = bytearray_alloc(len, len);
+    memset(ba->data, 0, (size_t)len);
+    return ba;
+}
+
 void BYTEARRAY_METHOD(append)(ByteArray* ba, int64_t value) {
     if (ba == NULL) {
         rt_panic("Cannot append to NULL bytearray");
@@ -27,16 +59,19 @@ void BYTEARRAY_METHOD(append)(ByteArray* ba, int64_t value) {
         rt_panic("bytearray value out of range (0-255)");
     }
 
-    if (ba->len == ba->cap) {
-        ba->cap *= 2;
-        uint8_t* new_data = (uint8_t*)realloc(ba->data, ba->cap);
-        if (new_data == NULL) {
-            rt_panic("Failed to reallocate memory for bytearray");
-        }
-        ba->data = new_data;
+    bytearray_reserve(ba, ba->len + 1);
+    ba->data[ba->len++] = (uint8_t)value;
+}
+
+void BYTEARRAY_METHOD(extend)(ByteArray* ba, Bytes* b) {
+    if (ba == NULL) {
+        rt_panic("Cannot extend NULL bytearray");
     }
+    if (b == NULL || b->len == 0) return;
 
-    ba->data[ba->len++] = (uint8_t)value;
+    bytearray_reserve(ba, ba->len + b->len);
+    memcpy(ba->data + ba->len, b->data, (size_t)b->len);
+    ba->len += b->len;
 }
 
 int64_t BYTEARRAY_METHOD(__getitem__)(ByteArray* ba, int64_t index) {
@@ -69,10 +104,28 @@ int64_t BYTEARRAY_METHOD(__len__)(ByteArray* ba) {
     return ba->len;
 }
 
+ByteArray* BYTEARRAY_METHOD(__getslice__)(ByteArray* ba, int64_t lo, int64_t hi) {
+    if (ba == NULL) {
+        rt_panic("Cannot slice NULL bytearray");
+    }
+    int64_t len = rt_slice_bounds(ba->len, &lo, &hi);
+    ByteArray* result = bytearray_alloc(len, len);
+    if (len > 0) memcpy(result->data, ba->data + lo, (size_t)len);
+    return result;
+}
+
+int64_t BYTEARRAY_METHOD(find)(ByteArray* ba, Bytes* sub) {
+    if (ba == NULL) {
+        rt_panic("Cannot search NULL bytearray");
+    }
+    if (sub == NULL) return -1;
+    return rt_find((const char*)ba->data, (size_t)ba->len, (const char*)sub->data, (size_t)sub->len);
+}
+
 void BYTEARRAY_METHOD(free)(ByteArray* ba) {
     if (ba != NULL) {
-        free(ba->data);
-        free(ba);
+        rt_free(ba->data, (size_t)ba->cap);
+        rt_free_object(ba, sizeof(ByteArray));
     }
 }
 
@@ -94,7 +147,7 @@ String* BYTEARRAY_METHOD(__repr__)(ByteArray* ba) {
         }
     }
 
-    String* result = (String*)malloc(sizeof(String) + out_len + 1);
+    String* result = string_alloc(out_len);
     if (result == NULL) return NULL;
 
     result->len = out_len;
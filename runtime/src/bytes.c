@@ -1,4 +1,5 @@
 #include "bytes.h"
+#include "strkernel.h"
 #include <stdlib.h>
 #include <string.h>
 
@@ -9,7 +10,7 @@
 Bytes* BYTES_METHOD(__init__)(const uint8_t* data, int64_t len) {
     if (len < 0) return NULL;
 
-    Bytes* b = (Bytes*)malloc(sizeof(Bytes) + len);
+    Bytes* b = (Bytes*)rt_alloc_object(sizeof(Bytes) + len, RT_KIND_BYTES);
     if (b == NULL) return NULL;
 
     b->len = len;
@@ -20,7 +21,9 @@ Bytes* BYTES_METHOD(__init__)(const uint8_t* data, int64_t len) {
 }
 
 void BYTES_METHOD(free)(Bytes* b) {
-    free(b);
+    if (b != NULL) {
+        rt_free_object(b, sizeof(Bytes) + (size_t)b->len);
+    }
 }
 
 int64_t BYTES_METHOD(__len__)(Bytes* b) {
@@ -52,7 +55,7 @@ String* BYTES_METHOD(__repr__)(Bytes* b) {
         }
     }
 
-    String* result = (String*)malloc(sizeof(String) + out_len + 1);
+    String* result = string_alloc(out_len);
     if (result == NULL) return NULL;
 
     result->len = out_len;
@@ -84,3 +87,32 @@ String* BYTES_METHOD(__repr__)(Bytes* b) {
 String* BYTES_METHOD(__str__)(Bytes* b) {
     return BYTES_METHOD(__repr__)(b);
 }
+
+Bytes* BYTES_METHOD(__add__)(Bytes* a, Bytes* b) {
+    int64_t a_len = a ? a->len : 0;
+    int64_t b_len = b ? b->len : 0;
+    Bytes* result = BYTES_METHOD(__init__)(NULL, a_len + b_len);
+    if (result == NULL) return NULL;
+
+    if (a_len > 0) memcpy(result->data, a->data, (size_t)a_len);
+    if (b_len > 0) memcpy(result->data + a_len, b->data, (size_t)b_len);
+    return result;
+}
+
+Bytes* BYTES_METHOD(__getslice__)(Bytes* b, int64_t lo, int64_t hi) {
+    if (b == NULL) return BYTES_METHOD(__init__)(NULL, 0);
+    int64_t len = rt_slice_bounds(b->len, &lo, &hi);
+    return BYTES_METHOD(__init__)(b->data + lo, len);
+}
+
+int64_t BYTES_METHOD(find)(Bytes* b, Bytes* sub) {
+    if (b == NULL || sub == NULL) return -1;
+    return rt_find((const char*)b->data, (size_t)b->len, (const char*)sub->data, (size_t)sub->len);
+}
+
+int64_t BYTES_METHOD(count)(Bytes* b, Bytes* sub) {
+    if (b == NULL || sub == NULL) return 0;
+    // The empty sequence matches between every pair of bytes and at both ends
+    if (sub->len == 0) return b->len + 1;
+    return rt_count((const char*)b->data, (size_t)b->len, (const char*)sub->data, (size_t)sub->len);
+}
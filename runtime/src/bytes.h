@@ -24,4 +24,26 @@ int64_t BYTES_METHOD(__getitem__)(Bytes* b, int64_t index);
 String* BYTES_METHOD(__str__)(Bytes* b);
 String* BYTES_METHOD(__repr__)(Bytes* b);
 
+// a + b: one allocation and two copies
+Bytes* BYTES_METHOD(__add__)(Bytes* a, Bytes* b);
+
+// b[lo:hi], bounds as rt_slice_bounds takes them
+Bytes* BYTES_METHOD(__getslice__)(Bytes* b, int64_t lo, int64_t hi);
+
+// Byte offset of the first sub, or -1; non-overlapping occurrences of sub.
+// Both run on the string search kernels.
+int64_t BYTES_METHOD(find)(Bytes* b, Bytes* sub);
+int64_t BYTES_METHOD(count)(Bytes* b, Bytes* sub);
+
+// Clamp the bounds of a [lo:hi] slice of a len-byte sequence to [0, len], as
+// Python does: a negative bound counts from the end, and a bound the source
+// left out arrives as 0 (lo) or INT64_MAX (hi). Returns the slice length.
+static inline int64_t rt_slice_bounds(int64_t len, int64_t* lo, int64_t* hi) {
+    if (*lo < 0) *lo = *lo + len < 0 ? 0 : *lo + len;
+    if (*hi < 0) *hi = *hi + len < 0 ? 0 : *hi + len;
+    if (*lo > len) *lo = len;
+    if (*hi > len) *hi = len;
+    return *hi > *lo ? *hi - *lo : 0;
+}
+
 #endif // BYTES_H
@@ -4,10 +4,7 @@
 
 // Allocate memory for a new class instance
 void* class_new(int64_t size) {
-    void* instance = malloc((size_t)size);
-    if (instance == NULL) {
-        rt_panic("Failed to allocate memory for class instance");
-    }
+    void* instance = rt_alloc_object((size_t)size, RT_KIND_INSTANCE);
     // Zero-initialize all fields
     memset(instance, 0, (size_t)size);
     return instance;
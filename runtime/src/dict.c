@@ -0,0 +1,584 @@
+#include "runtime.h"
+#include <string.h>
+
+// ============================================================================
+// Control-byte groups
+// A group is HT_GROUP_WIDTH consecutive control bytes, matched all at once.
+// Masks have one bit (SSE2) or one byte (SWAR) per matching slot.
+// ============================================================================
+
+#if defined(__SSE2__)
+
+// -nostdinc keeps <emmintrin.h> out of reach, so SSE2 is reached through
+// vector extensions: == is pcmpeqb and the builtin is pmovmskb.
+#define HT_GROUP_WIDTH 16
+
+typedef char HtGroup __attribute__((vector_size(16)));
+typedef uint32_t HtMask;
+
+static inline HtGroup group_load(const uint8_t* ctrl) {
+    HtGroup g;
+    memcpy(&g, ctrl, sizeof(g));
+    return g;
+}
+
+static inline HtMask group_match(HtGroup g, uint8_t tag) {
+    HtGroup splat;
+    memset(&splat, tag, sizeof(splat));
+    return (HtMask)__builtin_ia32_pmovmskb128((HtGroup)(g == splat));
+}
+
+static inline HtMask group_match_empty(HtGroup g) {
+    return group_match(g, HT_CTRL_EMPTY);
+}
+
+// EMPTY and DELETED are the only control bytes with the high bit set
+static inline HtMask group_match_free(HtGroup g) {
+    return (HtMask)__builtin_ia32_pmovmskb128(g);
+}
+
+static inline size_t mask_lowest(HtMask m) {
+    return (size_t)__builtin_ctz(m);
+}
+
+#else
+
+// Portable fallback: eight control bytes in a word
+#define HT_GROUP_WIDTH 8
+#define HT_LSBS 0x0101010101010101ULL
+#define HT_MSBS 0x8080808080808080ULL
+
+typedef uint64_t HtGroup;
+typedef uint64_t HtMask;
+
+static inline HtGroup group_load(const uint8_t* ctrl) {
+    HtGroup g;
+    memcpy(&g, ctrl, sizeof(g));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    g = __builtin_bswap64(g);
+#endif
+    return g;
+}
+
+// May report a false match next to a real one; callers compare keys anyway
+static inline HtMask group_match(HtGroup g, uint8_t tag) {
+    HtGroup x = g ^ (HT_LSBS * tag);
+    return (x - HT_LSBS) & ~x & HT_MSBS;
+}
+
+// EMPTY (0x80) is the only control byte with the high bit set and bit 6 clear
+static inline HtMask group_match_empty(HtGroup g) {
+    return g & ~(g << 6) & HT_MSBS;
+}
+
+static inline HtMask group_match_free(HtGroup g) {
+    return g & HT_MSBS;
+}
+
+static inline size_t mask_lowest(HtMask m) {
+    return (size_t)__builtin_ctzll(m) / 8;
+}
+
+#endif
+
+// ============================================================================
+// Hashing
+// ============================================================================
+
+// Folded multiply: spreads every input bit over both the 7-bit tag (low bits)
+// and the probe start (high bits)
+static inline uint64_t ht_mix(uint64_t x) {
+    __uint128_t product = (__uint128_t)(x ^ 0x9e3779b97f4a7c15ULL) * 0xbf58476d1ce4e5b9ULL;
+    return (uint64_t)product ^ (uint64_t)(product >> 64);
+}
+
+static inline uint64_t str_key_hash(uint64_t slot) {
+    return ht_mix(string_hash((String*)(uintptr_t)slot));
+}
+
+static inline int str_key_eq(uint64_t a, uint64_t b) {
+    String* x = (String*)(uintptr_t)a;
+    String* y = (String*)(uintptr_t)b;
+    return x == y || (x->len == y->len && string_hash(x) == string_hash(y) &&
+                      memcmp(x->data, y->data, (size_t)x->len) == 0);
+}
+
+// Every other kind hashes and compares the slot itself: the integer, the bits
+// of the double (with -0.0 folded into 0.0 by the caller), or the identity
+static inline uint64_t slot_key_hash(uint64_t slot) {
+    return ht_mix(slot);
+}
+
+static inline int slot_key_eq(uint64_t a, uint64_t b) {
+    return a == b;
+}
+
+static uint64_t key_hash(ListElemKind kind, uint64_t slot) {
+    return kind == LIST_ELEM_STR ? str_key_hash(slot) : slot_key_hash(slot);
+}
+
+// ============================================================================
+// Table storage
+// ============================================================================
+
+// Entries a table holds before it is rebuilt: 7/8 of the index
+static inline int64_t entry_cap(int64_t index_cap) {
+    return index_cap - index_cap / 8;
+}
+
+static void ht_alloc_index(HashTable* t, int64_t index_cap) {
+    t->index_cap = index_cap;
+    t->ctrl = (uint8_t*)rt_alloc((size_t)index_cap + HT_GROUP_WIDTH);
+    t->slots = (int32_t*)rt_alloc(sizeof(int32_t) * (size_t)index_cap);
+    if (t->ctrl == NULL || t->slots == NULL) {
+        rt_panic("Failed to allocate memory for hash table");
+    }
+    memset(t->ctrl, HT_CTRL_EMPTY, (size_t)index_cap + HT_GROUP_WIDTH);
+}
+
+static void ht_free_index(HashTable* t) {
+    rt_free(t->ctrl, (size_t)t->index_cap + HT_GROUP_WIDTH);
+    rt_free(t->slots, sizeof(int32_t) * (size_t)t->index_cap);
+}
+
+static HashTable* ht_new(ListElemKind key_kind, int32_t value_kind) {
+    HashTable* t = (HashTable*)rt_alloc_object(sizeof(HashTable), RT_KIND_HASH_TABLE);
+    if (t == NULL) {
+        rt_panic("Failed to allocate memory for hash table");
+    }
+    t->len = 0;
+    t->used = 0;
+    t->key_kind = key_kind;
+    t->value_kind = value_kind;
+
+    size_t entries = (size_t)entry_cap(HT_MIN_CAPACITY);
+    t->keys = (uint64_t*)rt_alloc(sizeof(uint64_t) * entries);
+    if (value_kind >= 0) {
+        t->values = (uint64_t*)rt_alloc(sizeof(uint64_t) * entries);
+    } else {
+        t->values = NULL;
+    }
+    t->live = (uint8_t*)rt_alloc(entries);
+    ht_alloc_index(t, HT_MIN_CAPACITY);
+    return t;
+}
+
+void rt_hash_table_release(HashTable* t) {
+    if (t->ctrl == NULL) return;
+    size_t entries = (size_t)entry_cap(t->index_cap);
+    ht_free_index(t);
+    rt_free(t->keys, sizeof(uint64_t) * entries);
+    if (t->values != NULL) {
+        rt_free(t->values, sizeof(uint64_t) * entries);
+    }
+    rt_free(t->live, entries);
+    t->ctrl = NULL;
+}
+
+// Write a control byte, keeping the copy of the first group after the end in
+// sync so group loads near the end never wrap
+static inline void set_ctrl(HashTable* t, size_t pos, uint8_t value) {
+    size_t mask = (size_t)t->index_cap - 1;
+    t->ctrl[pos] = value;
+    t->ctrl[((pos - HT_GROUP_WIDTH) & mask) + HT_GROUP_WIDTH] = value;
+}
+
+// First EMPTY or DELETED slot on the probe sequence of hash
+static inline size_t find_free(HashTable* t, uint64_t hash) {
+    size_t mask = (size_t)t->index_cap - 1;
+    size_t pos = (size_t)(hash >> 7) & mask;
+    size_t stride = 0;
+    for (;;) {
+        HtMask free_slots = group_match_free(group_load(t->ctrl + pos));
+        if (free_slots) {
+            return (pos + mask_lowest(free_slots)) & mask;
+        }
+        stride += HT_GROUP_WIDTH;
+        pos = (pos + stride) & mask;
+    }
+}
+
+// Index the first `used` entries into a fresh (all EMPTY) index
+static void reindex(HashTable* t) {
+    for (int64_t e = 0; e < t->used; e++) {
+        uint64_t hash = key_hash((ListElemKind)t->key_kind, t->keys[e]);
+        size_t pos = find_free(t, hash);
+        set_ctrl(t, pos, (uint8_t)(hash & 0x7f));
+        t->slots[pos] = (int32_t)e;
+    }
+}
+
+// Called when every entry is in use: drop removed entries, and double the
+// table unless removals freed at least half of it
+static void ht_rebuild(HashTable* t) {
+    int64_t old_entries = entry_cap(t->index_cap);
+    int64_t new_cap = t->index_cap;
+    if (t->len >= old_entries / 2) {
+        new_cap *= 2;
+        if (entry_cap(new_cap) > INT32_MAX) {
+            rt_panic("Hash table too large");
+        }
+    }
+    int64_t new_entries = entry_cap(new_cap);
+
+    int64_t kept = 0;
+    for (int64_t e = 0; e < t->used; e++) {
+        if (t->live[e]) {
+            t->keys[kept] = t->keys[e];
+            if (t->values != NULL) {
+                t->values[kept] = t->values[e];
+            }
+            kept++;
+        }
+    }
+    memset(t->live, 1, (size_t)kept);
+    t->used = kept;
+
+    if (new_entries != old_entries) {
+        t->keys = (uint64_t*)rt_realloc(t->keys, sizeof(uint64_t) * (size_t)old_entries,
+                                        sizeof(uint64_t) * (size_t)new_entries);
+        if (t->values != NULL) {
+            t->values = (uint64_t*)rt_realloc(t->values, sizeof(uint64_t) * (size_t)old_entries,
+                                              sizeof(uint64_t) * (size_t)new_entries);
+        }
+        t->live = (uint8_t*)rt_realloc(t->live, (size_t)old_entries, (size_t)new_entries);
+    }
+
+    ht_free_index(t);
+    ht_alloc_index(t, new_cap);
+    reindex(t);
+}
+
+// Append a new entry for a key known to be absent; returns its entry number
+static inline int64_t ht_insert_new(HashTable* t, uint64_t key, uint64_t hash) {
+    if (t->used == entry_cap(t->index_cap)) {
+        ht_rebuild(t);
+    }
+    int64_t e = t->used++;
+    t->keys[e] = key;
+    t->live[e] = 1;
+    t->len++;
+
+    size_t pos = find_free(t, hash);
+    set_ctrl(t, pos, (uint8_t)(hash & 0x7f));
+    t->slots[pos] = (int32_t)e;
+    return e;
+}
+
+static inline void ht_remove_at(HashTable* t, size_t pos) {
+    t->live[t->slots[pos]] = 0;
+    set_ctrl(t, pos, HT_CTRL_DELETED);
+    t->len--;
+}
+
+// Index slot holding key, or -1. HASH and EQ are the key kind's functions,
+// so each kernel family gets its own copy with both inlined.
+#define HT_FIND(NAME, HASH, EQ) \
+    static inline int64_t NAME(HashTable* t, uint64_t key, uint64_t* hash_out) { \
+        uint64_t hash = HASH(key); \
+        *hash_out = hash; \
+        uint8_t tag = (uint8_t)(hash & 0x7f); \
+        size_t mask = (size_t)t->index_cap - 1; \
+        size_t pos = (size_t)(hash >> 7) & mask; \
+        size_t stride = 0; \
+        for (;;) { \
+            HtGroup group = group_load(t->ctrl + pos); \
+            for (HtMask m = group_match(group, tag); m; m &= m - 1) { \
+                size_t slot = (pos + mask_lowest(m)) & mask; \
+                if (EQ(t->keys[t->slots[slot]], key)) { \
+                    return (int64_t)slot; \
+                } \
+            } \
+            if (group_match_empty(group)) { \
+                return -1; \
+            } \
+            stride += HT_GROUP_WIDTH; \
+            pos = (pos + stride) & mask; \
+        } \
+    }
+
+HT_FIND(find_slot_key, slot_key_hash, slot_key_eq)
+HT_FIND(find_str_key, str_key_hash, str_key_eq)
+
+// ============================================================================
+// Key conversions
+// ============================================================================
+
+static inline uint64_t int_to_slot(int64_t key) { return (uint64_t)key; }
+static inline int64_t int_from_slot(uint64_t slot) { return (int64_t)slot; }
+
+static inline uint64_t f64_to_slot(double key) {
+    if (key == 0.0) key = 0.0;  // -0.0 == 0.0, so they must share a slot
+    uint64_t slot;
+    memcpy(&slot, &key, sizeof(slot));
+    return slot;
+}
+
+static inline double f64_from_slot(uint64_t slot) {
+    double key;
+    memcpy(&key, &slot, sizeof(key));
+    return key;
+}
+
+static inline uint64_t bool_to_slot(int8_t key) { return key ? 1 : 0; }
+static inline int8_t bool_from_slot(uint64_t slot) { return (int8_t)slot; }
+
+static inline uint64_t ptr_to_slot(const void* key) { return (uint64_t)(uintptr_t)key; }
+static inline void* ptr_from_slot(uint64_t slot) { return (void*)(uintptr_t)slot; }
+
+static void raise_key_error(ListElemKind kind, uint64_t key) {
+    ReprBuffer buf;
+    rt_repr_init(&buf);
+    rt_repr_append_slot(&buf, kind, key);
+    __pyc_raise(rt_exception_new(RT_EXC_KEY_ERROR, rt_repr_finish(&buf)));
+}
+
+static inline HashTableIterator* iterator_new(HashTable* t) {
+    HashTableIterator* iter = (HashTableIterator*)rt_alloc_object(sizeof(HashTableIterator),
+                                                                  RT_KIND_HASH_ITERATOR);
+    if (iter == NULL) {
+        rt_panic("Failed to allocate memory for hash table iterator");
+    }
+    iter->table = t;
+    iter->index = 0;
+    return iter;
+}
+
+// Next live entry, or -1 at the end
+static inline int64_t iterator_advance(HashTableIterator* iter) {
+    HashTable* t = iter->table;
+    while (iter->index < t->used && !t->live[iter->index]) {
+        iter->index++;
+    }
+    if (iter->index >= t->used) {
+        return -1;
+    }
+    return iter->index++;
+}
+
+// ============================================================================
+// Typed kernels
+// One set per key storage; SUFFIX is empty for int keys so those keep the
+// plain DICT_METHOD/SET_METHOD names.
+// ============================================================================
+
+#define DICT_KERNELS(SUFFIX, K, KIND, TO_SLOT, FROM_SLOT, FIND) \
+    Dict* __pyc___builtin___dict##SUFFIX##___init__(int32_t value_kind) { \
+        return ht_new(KIND, value_kind); \
+    } \
+    \
+    void __pyc___builtin___dict##SUFFIX##___setitem__(Dict* d, K key, uint64_t value) { \
+        uint64_t slot = TO_SLOT(key); \
+        uint64_t hash; \
+        int64_t pos = FIND(d, slot, &hash); \
+        if (pos >= 0) { \
+            d->values[d->slots[pos]] = value; \
+            return; \
+        } \
+        int64_t e = ht_insert_new(d, slot, hash); \
+        d->values[e] = value; \
+    } \
+    \
+    uint64_t __pyc___builtin___dict##SUFFIX##___getitem__(Dict* d, K key) { \
+        uint64_t slot = TO_SLOT(key); \
+        uint64_t hash; \
+        int64_t pos = FIND(d, slot, &hash); \
+        if (pos < 0) { \
+            raise_key_error(KIND, slot); \
+            return 0; \
+        } \
+        return d->values[d->slots[pos]]; \
+    } \
+    \
+    int8_t __pyc___builtin___dict##SUFFIX##___contains__(Dict* d, K key) { \
+        uint64_t hash; \
+        return FIND(d, TO_SLOT(key), &hash) >= 0; \
+    } \
+    \
+    uint64_t __pyc___builtin___dict##SUFFIX##_get(Dict* d, K key, uint64_t fallback) { \
+        uint64_t hash; \
+        int64_t pos = FIND(d, TO_SLOT(key), &hash); \
+        return pos >= 0 ? d->values[d->slots[pos]] : fallback; \
+    } \
+    \
+    uint64_t __pyc___builtin___dict##SUFFIX##_pop(Dict* d, K key) { \
+        uint64_t slot = TO_SLOT(key); \
+        uint64_t hash; \
+        int64_t pos = FIND(d, slot, &hash); \
+        if (pos < 0) { \
+            raise_key_error(KIND, slot); \
+            return 0; \
+        } \
+        uint64_t value = d->values[d->slots[pos]]; \
+        ht_remove_at(d, (size_t)pos); \
+        return value; \
+    } \
+    \
+    K __pyc___builtin___dict_iterator##SUFFIX##___next__(HashTableIterator* iter) { \
+        int64_t e = iterator_advance(iter); \
+        if (e < 0) { \
+            __pyc_raise(__pyc_stop_iteration()); \
+            return FROM_SLOT(0); \
+        } \
+        return FROM_SLOT(iter->table->keys[e]); \
+    }
+
+#define SET_KERNELS(SUFFIX, K, KIND, TO_SLOT, FROM_SLOT, FIND) \
+    Set* __pyc___builtin___set##SUFFIX##___init__(void) { \
+        return ht_new(KIND, -1); \
+    } \
+    \
+    void __pyc___builtin___set##SUFFIX##_add(Set* s, K key) { \
+        uint64_t slot = TO_SLOT(key); \
+        uint64_t hash; \
+        if (FIND(s, slot, &hash) < 0) { \
+            ht_insert_new(s, slot, hash); \
+        } \
+    } \
+    \
+    int8_t __pyc___builtin___set##SUFFIX##___contains__(Set* s, K key) { \
+        uint64_t hash; \
+        return FIND(s, TO_SLOT(key), &hash) >= 0; \
+    } \
+    \
+    void __pyc___builtin___set##SUFFIX##_discard(Set* s, K key) { \
+        uint64_t hash; \
+        int64_t pos = FIND(s, TO_SLOT(key), &hash); \
+        if (pos >= 0) { \
+            ht_remove_at(s, (size_t)pos); \
+        } \
+    } \
+    \
+    void __pyc___builtin___set##SUFFIX##_remove(Set* s, K key) { \
+        uint64_t slot = TO_SLOT(key); \
+        uint64_t hash; \
+        int64_t pos = FIND(s, slot, &hash); \
+        if (pos < 0) { \
+            raise_key_error(KIND, slot); \
+            return; \
+        } \
+        ht_remove_at(s, (size_t)pos); \
+    } \
+    \
+    K __pyc___builtin___set_iterator##SUFFIX##___next__(HashTableIterator* iter) { \
+        int64_t e = iterator_advance(iter); \
+        if (e < 0) { \
+            __pyc_raise(__pyc_stop_iteration()); \
+            return FROM_SLOT(0); \
+        } \
+        return FROM_SLOT(iter->table->keys[e]); \
+    }
+
+#define str_to_slot(key)   ptr_to_slot(key)
+#define str_from_slot(key) ((String*)ptr_from_slot(key))
+
+DICT_KERNELS(, int64_t, LIST_ELEM_INT, int_to_slot, int_from_slot, find_slot_key)
+DICT_KERNELS(_f64, double, LIST_ELEM_FLOAT, f64_to_slot, f64_from_slot, find_slot_key)
+DICT_KERNELS(_bool, int8_t, LIST_ELEM_BOOL, bool_to_slot, bool_from_slot, find_slot_key)
+DICT_KERNELS(_str, String*, LIST_ELEM_STR, str_to_slot, str_from_slot, find_str_key)
+DICT_KERNELS(_ptr, void*, LIST_ELEM_OBJECT, ptr_to_slot, ptr_from_slot, find_slot_key)
+
+SET_KERNELS(, int64_t, LIST_ELEM_INT, int_to_slot, int_from_slot, find_slot_key)
+SET_KERNELS(_f64, double, LIST_ELEM_FLOAT, f64_to_slot, f64_from_slot, find_slot_key)
+SET_KERNELS(_bool, int8_t, LIST_ELEM_BOOL, bool_to_slot, bool_from_slot, find_slot_key)
+SET_KERNELS(_str, String*, LIST_ELEM_STR, str_to_slot, str_from_slot, find_str_key)
+SET_KERNELS(_ptr, void*, LIST_ELEM_OBJECT, ptr_to_slot, ptr_from_slot, find_slot_key)
+
+// ============================================================================
+// Key-independent operations
+// ============================================================================
+
+int64_t DICT_METHOD(__len__)(Dict* d) {
+    return d->len;
+}
+
+int64_t SET_METHOD(__len__)(Set* s) {
+    return s->len;
+}
+
+// "{" + entries separated by ", " + "}"; dict entries print as "key: value"
+static String* ht_repr(HashTable* t) {
+    ReprBuffer buf;
+    rt_repr_init(&buf);
+    rt_repr_append(&buf, "{", 1);
+    int first = 1;
+    for (int64_t e = 0; e < t->used; e++) {
+        if (!t->live[e]) continue;
+        if (!first) {
+            rt_repr_append(&buf, ", ", 2);
+        }
+        first = 0;
+        rt_repr_append_slot(&buf, (ListElemKind)t->key_kind, t->keys[e]);
+        if (t->values != NULL) {
+            rt_repr_append(&buf, ": ", 2);
+            rt_repr_append_slot(&buf, (ListElemKind)t->value_kind, t->values[e]);
+        }
+    }
+    rt_repr_append(&buf, "}", 1);
+    return rt_repr_finish(&buf);
+}
+
+String* DICT_METHOD(__repr__)(Dict* d) {
+    return ht_repr(d);
+}
+
+String* DICT_METHOD(__str__)(Dict* d) {
+    return ht_repr(d);
+}
+
+String* SET_METHOD(__repr__)(Set* s) {
+    if (s->len == 0) {
+        return STR_METHOD(from_literal)("set()", 5);
+    }
+    return ht_repr(s);
+}
+
+String* SET_METHOD(__str__)(Set* s) {
+    return SET_METHOD(__repr__)(s);
+}
+
+static List* collect_live(HashTable* t, const uint64_t* column, ListElemKind kind) {
+    List* list = rt_list_new(kind);
+    for (int64_t e = 0; e < t->used; e++) {
+        if (t->live[e]) {
+            rt_list_append_slot(list, column[e]);
+        }
+    }
+    return list;
+}
+
+List* DICT_METHOD(keys)(Dict* d) {
+    return collect_live(d, d->keys, (ListElemKind)d->key_kind);
+}
+
+List* DICT_METHOD(values)(Dict* d) {
+    return collect_live(d, d->values, (ListElemKind)d->value_kind);
+}
+
+// ============================================================================
+// Iterators
+// ============================================================================
+
+HashTableIterator* DICT_METHOD(__iter__)(Dict* d) {
+    return iterator_new(d);
+}
+
+HashTableIterator* DICT_ITERATOR_METHOD(__iter__)(HashTableIterator* iter) {
+    return iter;
+}
+
+void DICT_ITERATOR_METHOD(__dealloc__)(HashTableIterator* iter) {
+    rt_free_object(iter, sizeof(HashTableIterator));
+}
+
+HashTableIterator* SET_METHOD(__iter__)(Set* s) {
+    return iterator_new(s);
+}
+
+HashTableIterator* SET_ITERATOR_METHOD(__iter__)(HashTableIterator* iter) {
+    return iter;
+}
+
+void SET_ITERATOR_METHOD(__dealloc__)(HashTableIterator* iter) {
+    rt_free_object(iter, sizeof(HashTableIterator));
+}
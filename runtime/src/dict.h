@@ -0,0 +1,113 @@
+#ifndef DICT_H
+#define DICT_H
+
+// Included from runtime.h, after List and ListElemKind
+#include "types.h"
+#include "str.h"
+
+// ============================================================================
+// Hash tables backing dict[K, V] and set[T]
+//
+// Both are the same HashTable: a dense entry array in insertion order (so a
+// dict iterates and prints in the order its keys were added) plus a
+// Swiss-table index over it. The index is one control byte per slot (EMPTY,
+// DELETED, or the low 7 hash bits of a FULL slot) and the dense entry number
+// of each FULL slot. A lookup compares a whole group of control bytes against
+// the 7-bit tag at once (16 with SSE2, 8 with SWAR on other targets) and only
+// touches the keys of matching slots.
+//
+// Keys and values are stored unboxed in 8-byte slots: int64_t, the bits of a
+// double, 0/1 for bool, or a pointer. The kind of each is a ListElemKind,
+// recorded at creation. Kernels that take or return a key are generated per
+// key kind by DICT_KERNELS/SET_KERNELS in dict.c, with the hash and equality
+// inlined: int keys (the suffix-free names) hash the integer directly and
+// compare it in one instruction; str keys use the hash cached in the String
+// header and compare bytes only on a hash match; object keys compare by
+// identity. Values cross the ABI as the raw 8-byte slot; codegen converts
+// them from and to their TIR type.
+//
+// Mutating a table while iterating over it is not detected: the iterator
+// visits entries by position and stops at the end of the entry array.
+// ============================================================================
+
+#define HT_CTRL_EMPTY   0x80
+#define HT_CTRL_DELETED 0xFE
+#define HT_MIN_CAPACITY 16
+
+typedef struct {
+    uint8_t* ctrl;       // index_cap control bytes, then a copy of the first group
+    int32_t* slots;      // Dense entry number of each FULL slot
+    uint64_t* keys;      // Entry keys in insertion order
+    uint64_t* values;    // Entry values (NULL for sets)
+    uint8_t* live;       // 0 once an entry has been removed
+    int64_t len;         // Live entries
+    int64_t used;        // Entries written, including removed ones
+    int64_t index_cap;   // Slots in the index: a power of two, >= HT_MIN_CAPACITY
+    int32_t key_kind;    // ListElemKind
+    int32_t value_kind;  // ListElemKind, or -1 for sets
+} HashTable;
+
+typedef HashTable Dict;
+typedef HashTable Set;
+
+// Walks the entries of a dict (yielding keys) or a set
+typedef struct {
+    HashTable* table;
+    int64_t index;
+} HashTableIterator;
+
+#define DICT_METHOD(name)          BUILTIN_METHOD(dict, name)
+#define DICT_ITERATOR_METHOD(name) BUILTIN_METHOD(dict_iterator, name)
+#define SET_METHOD(name)           BUILTIN_METHOD(set, name)
+#define SET_ITERATOR_METHOD(name)  BUILTIN_METHOD(set_iterator, name)
+
+#define DICT_KERNEL_DECLS(SUFFIX, K) \
+    Dict* __pyc___builtin___dict##SUFFIX##___init__(int32_t value_kind); \
+    void __pyc___builtin___dict##SUFFIX##___setitem__(Dict* d, K key, uint64_t value); \
+    uint64_t __pyc___builtin___dict##SUFFIX##___getitem__(Dict* d, K key); \
+    int8_t __pyc___builtin___dict##SUFFIX##___contains__(Dict* d, K key); \
+    uint64_t __pyc___builtin___dict##SUFFIX##_get(Dict* d, K key, uint64_t fallback); \
+    uint64_t __pyc___builtin___dict##SUFFIX##_pop(Dict* d, K key); \
+    K __pyc___builtin___dict_iterator##SUFFIX##___next__(HashTableIterator* iter);
+
+#define SET_KERNEL_DECLS(SUFFIX, K) \
+    Set* __pyc___builtin___set##SUFFIX##___init__(void); \
+    void __pyc___builtin___set##SUFFIX##_add(Set* s, K key); \
+    int8_t __pyc___builtin___set##SUFFIX##___contains__(Set* s, K key); \
+    void __pyc___builtin___set##SUFFIX##_discard(Set* s, K key); \
+    void __pyc___builtin___set##SUFFIX##_remove(Set* s, K key); \
+    K __pyc___builtin___set_iterator##SUFFIX##___next__(HashTableIterator* iter);
+
+DICT_KERNEL_DECLS(, int64_t)
+DICT_KERNEL_DECLS(_f64, double)
+DICT_KERNEL_DECLS(_bool, int8_t)
+DICT_KERNEL_DECLS(_str, String*)
+DICT_KERNEL_DECLS(_ptr, void*)
+
+SET_KERNEL_DECLS(, int64_t)
+SET_KERNEL_DECLS(_f64, double)
+SET_KERNEL_DECLS(_bool, int8_t)
+SET_KERNEL_DECLS(_str, String*)
+SET_KERNEL_DECLS(_ptr, void*)
+
+// Key-independent operations
+int64_t DICT_METHOD(__len__)(Dict* d);
+String* DICT_METHOD(__str__)(Dict* d);
+String* DICT_METHOD(__repr__)(Dict* d);
+List* DICT_METHOD(keys)(Dict* d);
+List* DICT_METHOD(values)(Dict* d);
+HashTableIterator* DICT_METHOD(__iter__)(Dict* d);
+HashTableIterator* DICT_ITERATOR_METHOD(__iter__)(HashTableIterator* iter);
+void DICT_ITERATOR_METHOD(__dealloc__)(HashTableIterator* iter);
+
+int64_t SET_METHOD(__len__)(Set* s);
+String* SET_METHOD(__str__)(Set* s);
+String* SET_METHOD(__repr__)(Set* s);
+HashTableIterator* SET_METHOD(__iter__)(Set* s);
+HashTableIterator* SET_ITERATOR_METHOD(__iter__)(HashTableIterator* iter);
+void SET_ITERATOR_METHOD(__dealloc__)(HashTableIterator* iter);
+
+// Release the buffers owned by a table (the collector's finalizer)
+void rt_hash_table_release(HashTable* t);
+
+#endif // DICT_H
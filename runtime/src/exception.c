@@ -5,13 +5,35 @@
 #include <stdio.h>
 
 // ============================================================================
-// Global exception state
+// Exception state
+// Each thread has its own handler chain and pending exception; the workers of
+// a parallel loop hand theirs to the calling thread (see parallel.c).
 // ============================================================================
 
-static ExceptionFrame* current_frame = NULL;
-static Exception* current_exception = NULL;
+static _Thread_local ExceptionFrame* current_frame = NULL;
+static _Thread_local Exception* current_exception = NULL;
 static Exception* stop_iteration_singleton = NULL;
 
+STATIC_STRING(exception_name, "Exception");
+STATIC_STRING(stop_iteration_name, "StopIteration");
+STATIC_STRING(key_error_name, "KeyError");
+STATIC_STRING(value_error_name, "ValueError");
+STATIC_STRING(overflow_error_name, "OverflowError");
+STATIC_STRING(os_error_name, "OSError");
+STATIC_STRING(file_not_found_error_name, "FileNotFoundError");
+STATIC_STRING(empty_string, "");
+STATIC_STRING(null_exception_repr, "Exception()");
+
+// The pending exception and the StopIteration singleton live outside the
+// stack, so the collector has to be told about them. Only the main thread's
+// pending exception is a root: the collector does not run during a parallel
+// loop, and a worker's exception has moved to the main thread by the end of it.
+__attribute__((constructor))
+static void register_exception_roots(void) {
+    __pyc_gc_add_root((void**)&current_exception);
+    __pyc_gc_add_root((void**)&stop_iteration_singleton);
+}
+
 // ============================================================================
 // Stubs for setjmp/longjmp (polling-based, no actual jumps)
 // ============================================================================
@@ -41,6 +63,10 @@ void __pyc_pop_exception_frame(void) {
     }
 }
 
+void rt_exception_set_frame(ExceptionFrame* frame) {
+    current_frame = frame;
+}
+
 ExceptionFrame* __pyc_get_exception_frame(void) {
     return current_frame;
 }
@@ -69,11 +95,12 @@ int __pyc_has_exception(void) {
 // Raise exception
 // ============================================================================
 
-void __pyc_raise(Exception* exc) {
+static void raise_pending(Exception* exc) {
     current_exception = exc;
 
     if (!current_frame) {
         // No handler - print error and exit
+        rt_stdout_flush();
         fputs("Uncaught exception", stderr);
         if (exc && exc->type_name) {
             fputs(": ", stderr);
@@ -88,10 +115,19 @@ void __pyc_raise(Exception* exc) {
     }
 }
 
+void __pyc_raise(Exception* exc) {
+    if (rt_profile_enabled) {
+        rt_profile_raise(exc);
+    }
+    raise_pending(exc);
+}
+
+// Re-raising is not counted again by the profile
 void __pyc_reraise(void) {
     if (current_exception) {
-        __pyc_raise(current_exception);
+        raise_pending(current_exception);
     } else {
+        rt_stdout_flush();
         fputs("RuntimeError: No active exception to re-raise\n", stderr);
         exit(1);
     }
@@ -102,34 +138,50 @@ void __pyc_reraise(void) {
 // ============================================================================
 
 Exception* EXCEPTION_METHOD(__init__)(String* message) {
-    return __pyc_exception_new(STR_METHOD(from_literal)("Exception", 9), message, NULL);
+    return rt_exception_new(RT_EXC_EXCEPTION, message);
 }
 
-Exception* __pyc_exception_new(String* type_name, String* message, String* parent_types) {
-    Exception* exc = (Exception*)malloc(sizeof(Exception));
+Exception* __pyc_exception_new(String* type_name, String* message, int64_t type_id) {
+    Exception* exc = (Exception*)rt_alloc_object(sizeof(Exception), RT_KIND_EXCEPTION);
     exc->type_name = type_name;
     exc->message = message;
-    exc->parent_types = parent_types;
+    exc->type_id = type_id;
     return exc;
 }
 
+static String* runtime_exception_name(RtExceptionKind kind) {
+    switch (kind) {
+        case RT_EXC_STOP_ITERATION: return stop_iteration_name;
+        case RT_EXC_KEY_ERROR: return key_error_name;
+        case RT_EXC_VALUE_ERROR: return value_error_name;
+        case RT_EXC_OVERFLOW_ERROR: return overflow_error_name;
+        case RT_EXC_OS_ERROR: return os_error_name;
+        case RT_EXC_FILE_NOT_FOUND_ERROR: return file_not_found_error_name;
+        default: return exception_name;
+    }
+}
+
+Exception* rt_exception_new(RtExceptionKind kind, String* message) {
+    return __pyc_exception_new(runtime_exception_name(kind), message, __pyc_exception_ids[kind]);
+}
+
 String* EXCEPTION_METHOD(__str__)(Exception* exc) {
     if (exc && exc->message) {
         return exc->message;
     }
-    return STR_METHOD(from_literal)("", 0);
+    return empty_string;
 }
 
 String* EXCEPTION_METHOD(__repr__)(Exception* exc) {
     if (!exc) {
-        return STR_METHOD(from_literal)("Exception()", 11);
+        return null_exception_repr;
     }
 
     int64_t type_len = exc->type_name ? exc->type_name->len : 9;
     int64_t msg_len = exc->message ? exc->message->len : 0;
     int64_t total_len = type_len + 4 + msg_len;  // "Type('msg')"
 
-    String* result = (String*)malloc(sizeof(String) + total_len + 1);
+    String* result = string_alloc(total_len);
     result->len = total_len;
 
     char* p = result->data;
@@ -161,59 +213,23 @@ String* __pyc_exception_type(Exception* exc) {
     if (exc && exc->type_name) {
         return exc->type_name;
     }
-    return STR_METHOD(from_literal)("Exception", 9);
+    return exception_name;
 }
 
 Exception* __pyc_stop_iteration(void) {
-    if (!stop_iteration_singleton) {
-        stop_iteration_singleton = __pyc_exception_new(
-            STR_METHOD(from_literal)("StopIteration", 13),
-            STR_METHOD(from_literal)("", 0),
-            NULL
-        );
-    }
-    return stop_iteration_singleton;
-}
-
-int __pyc_exception_matches(Exception* exc, const char* type_name) {
-    if (!exc || !exc->type_name || !type_name) {
-        return 0;
-    }
-
-    // "Exception" is the base class and matches all exceptions
-    if (strcmp(type_name, "Exception") == 0) {
-        return 1;
-    }
-
-    // Exact match for specific exception types
-    if (strcmp(exc->type_name->data, type_name) == 0) {
-        return 1;
-    }
-
-    // Check parent types (comma-separated list like "MiddleError,BaseError,Exception")
-    if (exc->parent_types && exc->parent_types->len > 0) {
-        const char* parents = exc->parent_types->data;
-        size_t type_len = strlen(type_name);
-        const char* p = parents;
-        const char* end = parents + exc->parent_types->len;
-
-        while (p < end) {
-            // Find end of current parent name (comma or end of string)
-            const char* comma = p;
-            while (comma < end && *comma != ',') {
-                comma++;
-            }
-            size_t parent_len = comma - p;
-
-            // Compare with type_name
-            if (parent_len == type_len && memcmp(p, type_name, type_len) == 0) {
-                return 1;
-            }
-
-            // Move to next parent (skip comma)
-            p = comma < end ? comma + 1 : end;
+    Exception* exc = __atomic_load_n(&stop_iteration_singleton, __ATOMIC_ACQUIRE);
+    if (!exc) {
+        // Threads in a parallel loop may race to create it; one wins
+        Exception* expected = NULL;
+        exc = rt_exception_new(RT_EXC_STOP_ITERATION, empty_string);
+        if (!__atomic_compare_exchange_n(&stop_iteration_singleton, &expected, exc, 0,
+                                         __ATOMIC_RELEASE, __ATOMIC_ACQUIRE)) {
+            exc = expected;
         }
     }
+    return exc;
+}
 
-    return 0;
+int __pyc_exception_matches(Exception* exc, int64_t first, int64_t last) {
+    return exc && exc->type_id >= first && exc->type_id <= last;
 }
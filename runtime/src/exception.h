@@ -25,12 +25,32 @@ typedef struct {
 // Exception structure
 // ============================================================================
 
+// Type ids number the exception classes in preorder from Exception (id 0), so
+// the ids of a class and its subclasses form one range (see the compiler's
+// tir/exception_ids.rs). Matching an except clause compares against that range.
 typedef struct {
-    String* type_name;    // Exception type name (e.g., "ValueError")
+    String* type_name;    // Exception type name (e.g., "ValueError"), for printing
     String* message;      // Exception message
-    String* parent_types; // Comma-separated parent type names (e.g., "BaseError,Exception")
+    int64_t type_id;      // Type id of the exception's class
 } Exception;
 
+// Exception classes the runtime raises itself
+typedef enum {
+    RT_EXC_EXCEPTION,
+    RT_EXC_STOP_ITERATION,
+    RT_EXC_KEY_ERROR,
+    RT_EXC_VALUE_ERROR,
+    RT_EXC_OVERFLOW_ERROR,
+    RT_EXC_OS_ERROR,
+    RT_EXC_FILE_NOT_FOUND_ERROR,
+    RT_EXC_COUNT,
+} RtExceptionKind;
+
+// Type ids of those classes, indexed by RtExceptionKind. User classes can
+// inherit from them, so the ids depend on the program: the compiler defines
+// this table in every generated module.
+extern const int64_t __pyc_exception_ids[RT_EXC_COUNT];
+
 // ============================================================================
 // Exception frame for try block (linked list stack)
 // ============================================================================
@@ -63,6 +83,10 @@ void __pyc_pop_exception_frame(void);
 // Get the current exception frame (for longjmp target)
 ExceptionFrame* __pyc_get_exception_frame(void);
 
+// Make frame the innermost handler of this thread without linking it; parallel
+// loop workers run under the handler of the thread that started the loop
+void rt_exception_set_frame(ExceptionFrame* frame);
+
 // ============================================================================
 // Exception state management
 // ============================================================================
@@ -98,8 +122,11 @@ void __pyc_reraise(void);
 // Create a new exception: Exception(message)
 Exception* EXCEPTION_METHOD(__init__)(String* message);
 
-// Create a new exception with type name and parent types
-Exception* __pyc_exception_new(String* type_name, String* message, String* parent_types);
+// Create a new exception of the class with the given type id
+Exception* __pyc_exception_new(String* type_name, String* message, int64_t type_id);
+
+// Create a new exception of a class the runtime raises itself
+Exception* rt_exception_new(RtExceptionKind kind, String* message);
 
 // Exception.__str__()
 String* EXCEPTION_METHOD(__str__)(Exception* exc);
@@ -110,8 +137,9 @@ String* EXCEPTION_METHOD(__repr__)(Exception* exc);
 // Get exception type name
 String* __pyc_exception_type(Exception* exc);
 
-// Check if exception matches a type (by name comparison)
-int __pyc_exception_matches(Exception* exc, const char* type_name);
+// Check if exception matches a handler class, given the range of type ids
+// [first, last] of the class and its subclasses
+int __pyc_exception_matches(Exception* exc, int64_t first, int64_t last);
 
 // Get the singleton StopIteration exception (avoids repeated allocations)
 Exception* __pyc_stop_iteration(void);
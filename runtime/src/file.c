@@ -0,0 +1,449 @@
+#include "file.h"
+#include "runtime.h"
+#include "strkernel.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// ============================================================================
+// Errors
+// ============================================================================
+
+static void raise_message(RtExceptionKind kind, const char* message) {
+    __pyc_raise(rt_exception_new(kind, STR_METHOD(from_literal)(message, (int64_t)strlen(message))));
+}
+
+// OSError for errno err, as Python words it: "[Errno 2] No such file or
+// directory: 'data.csv'"
+static void raise_os_error(int err, String* path) {
+    char message[512];
+    if (path != NULL) {
+        snprintf(message, sizeof(message), "[Errno %d] %s: '%.*s'", err, strerror(err),
+                 (int)(path->len < 256 ? path->len : 256), path->data);
+    } else {
+        snprintf(message, sizeof(message), "[Errno %d] %s", err, strerror(err));
+    }
+    raise_message(err == ENOENT ? RT_EXC_FILE_NOT_FOUND_ERROR : RT_EXC_OS_ERROR, message);
+}
+
+// A file that can be read, or raise. NULL is a file whose open() raised; the
+// exception is already pending.
+static int check_readable(File* f) {
+    if (f == NULL) return 0;
+    if (f->fd < 0) {
+        raise_message(RT_EXC_VALUE_ERROR, "I/O operation on closed file.");
+        return 0;
+    }
+    if (!f->readable) {
+        raise_message(RT_EXC_OS_ERROR, "not readable");
+        return 0;
+    }
+    return 1;
+}
+
+static int check_writable(File* f) {
+    if (f == NULL) return 0;
+    if (f->fd < 0) {
+        raise_message(RT_EXC_VALUE_ERROR, "I/O operation on closed file.");
+        return 0;
+    }
+    if (!f->writable) {
+        raise_message(RT_EXC_OS_ERROR, "not writable");
+        return 0;
+    }
+    return 1;
+}
+
+// Lock a file for one method call if a parallel loop is running; returns
+// whether the lock was taken, for file_unlock
+static inline int file_lock(File* f) {
+    if (f == NULL || !rt_parallel_running()) return 0;
+    pthread_mutex_lock(&f->lock);
+    return 1;
+}
+
+static inline void file_unlock(File* f, int locked) {
+    if (locked) pthread_mutex_unlock(&f->lock);
+}
+
+// ============================================================================
+// Open and close
+// ============================================================================
+
+// Files with pending output, flushed at exit
+static File* open_writers = NULL;
+static int flush_registered = 0;
+static pthread_mutex_t open_writers_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void flush_writes(File* f) {
+    if (f->len == 0) return;
+    int err = rt_write_all(f->fd, f->buf, (size_t)f->len);
+    f->len = 0;
+    if (err != 0) {
+        raise_os_error(err, NULL);
+    }
+}
+
+static void flush_open_writers(void) {
+    pthread_mutex_lock(&open_writers_lock);
+    for (File* f = open_writers; f != NULL; f = f->next) {
+        if (f->len > 0) {
+            rt_write_all(f->fd, f->buf, (size_t)f->len);
+            f->len = 0;
+        }
+    }
+    pthread_mutex_unlock(&open_writers_lock);
+}
+
+static File* file_open(String* path, String* mode, int binary) {
+    int flags;
+    int readable = 0, writable = 0;
+    switch (mode->len > 0 ? mode->data[0] : '\0') {
+        case 'r': flags = O_RDONLY; readable = 1; break;
+        case 'w': flags = O_WRONLY | O_CREAT | O_TRUNC; writable = 1; break;
+        case 'a': flags = O_WRONLY | O_CREAT | O_APPEND; writable = 1; break;
+        case 'x': flags = O_WRONLY | O_CREAT | O_EXCL; writable = 1; break;
+        default: rt_panic("invalid file mode");
+    }
+    for (int64_t i = 1; i < mode->len; i++) {
+        if (mode->data[i] != 'b' && mode->data[i] != 't') {
+            rt_panic("invalid file mode");
+        }
+    }
+    (void)binary;
+
+    int fd;
+    do {
+        fd = open(path->data, flags | O_CLOEXEC, 0666);
+    } while (fd < 0 && errno == EINTR);
+    if (fd < 0) {
+        raise_os_error(errno, path);
+        return NULL;
+    }
+
+    File* f = (File*)rt_alloc_object(sizeof(File), RT_KIND_FILE);
+    f->fd = fd;
+    f->readable = (uint8_t)readable;
+    f->writable = (uint8_t)writable;
+    f->buf = (char*)rt_alloc(RT_FILE_BUFFER_SIZE);
+    f->pos = 0;
+    f->len = 0;
+    pthread_mutex_init(&f->lock, NULL);
+    f->prev = NULL;
+    f->next = NULL;
+    if (writable) {
+        pthread_mutex_lock(&open_writers_lock);
+        if (!flush_registered) {
+            atexit(flush_open_writers);
+            flush_registered = 1;
+        }
+        f->next = open_writers;
+        if (open_writers != NULL) open_writers->prev = f;
+        open_writers = f;
+        pthread_mutex_unlock(&open_writers_lock);
+    }
+    return f;
+}
+
+File* TEXTIO_METHOD(__init__)(String* path, String* mode) {
+    return file_open(path, mode, 0);
+}
+
+File* BINARYIO_METHOD(__init__)(String* path, String* mode) {
+    return file_open(path, mode, 1);
+}
+
+// Close without raising: pending output that cannot be written is dropped
+static void file_close(File* f) {
+    if (f->fd < 0) return;
+    if (f->writable) {
+        pthread_mutex_lock(&open_writers_lock);
+        if (f->prev != NULL) f->prev->next = f->next;
+        else open_writers = f->next;
+        if (f->next != NULL) f->next->prev = f->prev;
+        pthread_mutex_unlock(&open_writers_lock);
+    }
+    close(f->fd);
+    f->fd = -1;
+    rt_free(f->buf, RT_FILE_BUFFER_SIZE);
+    f->buf = NULL;
+    f->pos = f->len = 0;
+}
+
+static void close_checked(File* f) {
+    if (f == NULL || f->fd < 0) return;
+    if (f->writable) {
+        int err = f->len > 0 ? rt_write_all(f->fd, f->buf, (size_t)f->len) : 0;
+        f->len = 0;
+        file_close(f);
+        if (err != 0) raise_os_error(err, NULL);
+        return;
+    }
+    file_close(f);
+}
+
+void TEXTIO_METHOD(close)(File* f) {
+    int locked = file_lock(f);
+    close_checked(f);
+    file_unlock(f, locked);
+}
+
+void BINARYIO_METHOD(close)(File* f) {
+    int locked = file_lock(f);
+    close_checked(f);
+    file_unlock(f, locked);
+}
+
+void rt_file_release(File* f) {
+    if (f->fd >= 0 && f->writable && f->len > 0) {
+        rt_write_all(f->fd, f->buf, (size_t)f->len);
+        f->len = 0;
+    }
+    file_close(f);
+}
+
+// ============================================================================
+// Reading
+// ============================================================================
+
+// Refill the read-ahead buffer once it is used up; returns the bytes now
+// unread in it, 0 at the end of the file (or after raising on an error)
+static int64_t fill(File* f) {
+    if (f->pos < f->len) return f->len - f->pos;
+    f->pos = f->len = 0;
+    for (;;) {
+        ssize_t n = read(f->fd, f->buf, RT_FILE_BUFFER_SIZE);
+        if (n >= 0) {
+            f->len = n;
+            return n;
+        }
+        if (errno != EINTR) {
+            raise_os_error(errno, NULL);
+            return 0;
+        }
+    }
+}
+
+// Map the rest of a regular file as the payload of an object of the given kind
+// whose header is `header` bytes, handed to the collector to unmap; NULL when
+// the file is small, not regular, partly read or cannot be mapped
+static void* map_file(File* f, size_t header, RtObjectKind kind, int64_t* out_len) {
+    struct stat st;
+    if (f->pos < f->len || fstat(f->fd, &st) != 0 || !S_ISREG(st.st_mode) ||
+        st.st_size < RT_FILE_MMAP_MIN) {
+        return NULL;
+    }
+    off_t offset = lseek(f->fd, 0, SEEK_CUR);
+    if (offset != 0) return NULL;
+
+    size_t len = (size_t)st.st_size;
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    // One page for the header, then the data and at least one zero byte: the
+    // tail of the last file page and any page after it read as zeros
+    size_t total = page + ((len + 1 + page - 1) / page) * page;
+    char* base = (char*)mmap(NULL, total, PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) return NULL;
+    if (mmap(base + page, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, f->fd, 0) ==
+        MAP_FAILED) {
+        munmap(base, total);
+        return NULL;
+    }
+    lseek(f->fd, (off_t)len, SEEK_SET);
+    *out_len = (int64_t)len;
+    void* obj = base + page - header;
+    rt_adopt_mapped_object(obj, header + len + 1, kind, base, total);
+    return obj;
+}
+
+// Read the rest of the file into a heap buffer of *out_cap bytes
+static char* read_rest(File* f, int64_t* out_len, size_t* out_cap) {
+    size_t cap = RT_FILE_BUFFER_SIZE;
+    struct stat st;
+    if (fstat(f->fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        cap = (size_t)st.st_size + 1;
+    }
+    size_t len = (size_t)(f->len - f->pos);
+    if (cap < len + 1) cap = len + 1;
+    char* data = (char*)rt_alloc(cap);
+    memcpy(data, f->buf + f->pos, len);
+    f->pos = f->len = 0;
+
+    for (;;) {
+        if (len == cap) {
+            data = (char*)rt_realloc(data, cap, cap * 2);
+            cap *= 2;
+        }
+        ssize_t n = read(f->fd, data + len, cap - len);
+        if (n == 0) break;
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            raise_os_error(errno, NULL);
+            break;
+        }
+        len += (size_t)n;
+    }
+    *out_len = (int64_t)len;
+    *out_cap = cap;
+    return data;
+}
+
+static String* read_text(File* f) {
+    if (!check_readable(f)) return STR_METHOD(from_literal)("", 0);
+
+    int64_t len;
+    String* s = (String*)map_file(f, offsetof(String, data), RT_KIND_STRING, &len);
+    if (s != NULL) {
+        s->len = len;
+        s->cp_count = -1;
+        s->flags = rt_str_detect_flags(s->data, len);
+        s->hash = 0;
+        s->cp_index = NULL;
+        return s;
+    }
+
+    size_t cap;
+    char* data = read_rest(f, &len, &cap);
+    s = STR_METHOD(from_literal)(data, len);
+    rt_free(data, cap);
+    return s;
+}
+
+static Bytes* read_binary(File* f) {
+    if (!check_readable(f)) return BYTES_METHOD(__init__)(NULL, 0);
+
+    int64_t len;
+    Bytes* b = (Bytes*)map_file(f, offsetof(Bytes, data), RT_KIND_BYTES, &len);
+    if (b != NULL) {
+        b->len = len;
+        return b;
+    }
+
+    size_t cap;
+    char* data = read_rest(f, &len, &cap);
+    b = BYTES_METHOD(__init__)((const uint8_t*)data, len);
+    rt_free(data, cap);
+    return b;
+}
+
+static String* read_line(File* f) {
+    if (!check_readable(f)) return STR_METHOD(from_literal)("", 0);
+
+    // A line that spans buffer refills is gathered here
+    char* line = NULL;
+    size_t line_len = 0;
+    size_t line_cap = 0;
+    for (;;) {
+        int64_t avail = fill(f);
+        if (avail == 0) break;
+        const char* start = f->buf + f->pos;
+        int64_t nl = rt_find_byte(start, (size_t)avail, '\n');
+        int64_t take = nl < 0 ? avail : nl + 1;
+        if (nl >= 0 && line == NULL) {
+            // The whole line is in the buffer
+            f->pos += take;
+            return STR_METHOD(from_literal)(start, take);
+        }
+        if (line_len + (size_t)take > line_cap) {
+            size_t cap = line_cap ? line_cap * 2 : RT_FILE_BUFFER_SIZE;
+            while (cap < line_len + (size_t)take) cap *= 2;
+            line = (char*)(line ? rt_realloc(line, line_cap, cap) : rt_alloc(cap));
+            line_cap = cap;
+        }
+        memcpy(line + line_len, start, (size_t)take);
+        line_len += (size_t)take;
+        f->pos += take;
+        if (nl >= 0) break;
+    }
+    String* s = STR_METHOD(from_literal)(line ? line : "", (int64_t)line_len);
+    if (line != NULL) rt_free(line, line_cap);
+    return s;
+}
+
+String* TEXTIO_METHOD(read)(File* f) {
+    int locked = file_lock(f);
+    String* s = read_text(f);
+    file_unlock(f, locked);
+    return s;
+}
+
+Bytes* BINARYIO_METHOD(read)(File* f) {
+    int locked = file_lock(f);
+    Bytes* b = read_binary(f);
+    file_unlock(f, locked);
+    return b;
+}
+
+String* TEXTIO_METHOD(readline)(File* f) {
+    int locked = file_lock(f);
+    String* s = read_line(f);
+    file_unlock(f, locked);
+    return s;
+}
+
+File* TEXTIO_METHOD(__iter__)(File* f) {
+    return f;
+}
+
+String* TEXTIO_METHOD(__next__)(File* f) {
+    String* line = TEXTIO_METHOD(readline)(f);
+    if (line->len == 0 && f != NULL && f->fd >= 0) {
+        __pyc_raise(__pyc_stop_iteration());
+    }
+    return line;
+}
+
+int8_t TEXTIO_METHOD(__hasnext__)(File* f) {
+    int locked = file_lock(f);
+    int8_t more = check_readable(f) && fill(f) > 0;
+    file_unlock(f, locked);
+    return more;
+}
+
+void TEXTIO_METHOD(__dealloc__)(File* f) {
+    // The loop does not own the file
+    (void)f;
+}
+
+// ============================================================================
+// Writing
+// ============================================================================
+
+static void file_write(File* f, const char* data, size_t len) {
+    if (len > (size_t)(RT_FILE_BUFFER_SIZE - f->len)) {
+        flush_writes(f);
+        if (len >= RT_FILE_BUFFER_SIZE) {
+            int err = rt_write_all(f->fd, data, len);
+            if (err != 0) raise_os_error(err, NULL);
+            return;
+        }
+    }
+    memcpy(f->buf + f->len, data, len);
+    f->len += (int64_t)len;
+}
+
+int64_t TEXTIO_METHOD(write)(File* f, String* s) {
+    int locked = file_lock(f);
+    int64_t written = 0;
+    if (check_writable(f) && s != NULL) {
+        file_write(f, s->data, (size_t)s->len);
+        written = str_cp_count(s);
+    }
+    file_unlock(f, locked);
+    return written;
+}
+
+int64_t BINARYIO_METHOD(write)(File* f, Bytes* b) {
+    int locked = file_lock(f);
+    int64_t written = 0;
+    if (check_writable(f) && b != NULL) {
+        file_write(f, (const char*)b->data, (size_t)b->len);
+        written = b->len;
+    }
+    file_unlock(f, locked);
+    return written;
+}
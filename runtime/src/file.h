@@ -0,0 +1,88 @@
+#ifndef FILE_H
+#define FILE_H
+
+// ============================================================================
+// Files
+//
+// open(path, mode) returns a TextIO for the text modes and a BinaryIO for the
+// "b" modes. Either wraps a file descriptor and one RT_FILE_BUFFER_SIZE
+// buffer, which holds read-ahead for files opened for reading and pending
+// output for files opened for writing.
+//
+// read() of a whole regular file of at least RT_FILE_MMAP_MIN bytes maps the
+// file instead of copying it: the String or Bytes header sits at the end of
+// an anonymous page placed right before the mapped data, so the object is a
+// view of the page cache. The collector unmaps a mapped object when it sweeps
+// it (without the collector it stays mapped, as other objects stay
+// allocated), and the file must not shrink while one is in use.
+// Smaller files, and the rest of a file that has been partly read, are read
+// into one heap object.
+//
+// readline() and `for line in f` find line ends in the read-ahead buffer with
+// the vectorized byte search and copy each line out once.
+//
+// Writes are buffered like stdout (see io.h): a write that does not fit
+// flushes the buffer first, and one at least as large as the buffer goes
+// straight to write(2). Files with pending output are flushed at exit.
+//
+// While a parallel loop runs, every method holds the file's lock, so
+// iterations sharing a file each read or write whole lines and values, in no
+// particular order.
+// ============================================================================
+
+#include <pthread.h>
+
+#include "types.h"
+#include "str.h"
+#include "bytes.h"
+
+#define TEXTIO_METHOD(name)   BUILTIN_METHOD(TextIO, name)
+#define BINARYIO_METHOD(name) BUILTIN_METHOD(BinaryIO, name)
+
+#define RT_FILE_BUFFER_SIZE (64 * 1024)
+#define RT_FILE_MMAP_MIN (64 * 1024)
+
+typedef struct File {
+    int fd;                // -1 once closed
+    uint8_t readable;
+    uint8_t writable;
+    char* buf;             // RT_FILE_BUFFER_SIZE bytes
+    int64_t pos;           // Reading: first unread byte of buf
+    int64_t len;           // Reading: bytes read into buf; writing: bytes pending
+    pthread_mutex_t lock;  // Taken only while a parallel loop runs
+    struct File* prev;     // Files opened for writing, flushed at exit
+    struct File* next;
+} File;
+
+// open(path, mode); raises FileNotFoundError or OSError and returns NULL on
+// failure. The compiler checks the mode, so a bad one is a runtime panic.
+File* TEXTIO_METHOD(__init__)(String* path, String* mode);
+File* BINARYIO_METHOD(__init__)(String* path, String* mode);
+
+// Everything from the current position to the end of the file
+String* TEXTIO_METHOD(read)(File* f);
+Bytes* BINARYIO_METHOD(read)(File* f);
+
+// The next line including its "\n", or "" at the end of the file
+String* TEXTIO_METHOD(readline)(File* f);
+
+// Returns the number of codepoints (text) or bytes (binary) written
+int64_t TEXTIO_METHOD(write)(File* f, String* s);
+int64_t BINARYIO_METHOD(write)(File* f, Bytes* b);
+
+// Flush and close; closing again does nothing
+void TEXTIO_METHOD(close)(File* f);
+void BINARYIO_METHOD(close)(File* f);
+
+// Line iteration. The compiler lowers `for line in f` to
+// `while f.__hasnext__(): line = f.readline()`; __iter__ and __next__ serve
+// iter() and next().
+File* TEXTIO_METHOD(__iter__)(File* f);
+String* TEXTIO_METHOD(__next__)(File* f);
+int8_t TEXTIO_METHOD(__hasnext__)(File* f);
+void TEXTIO_METHOD(__dealloc__)(File* f);
+
+// Flush and close a file the collector found unreachable
+void rt_file_release(File* f);
+
+#endif // FILE_H
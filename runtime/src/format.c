@@ -0,0 +1,646 @@
+#include "format.h"
+#include "memory.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ============================================================================
+// Integers
+// ============================================================================
+
+static const char DIGIT_PAIRS[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+// Write the digits of n ending just before `end`, returning where they start
+static char* format_digits_backwards(uint64_t n, char* end) {
+    char* p = end;
+    while (n >= 100) {
+        uint64_t pair = (n % 100) * 2;
+        n /= 100;
+        p -= 2;
+        p[0] = DIGIT_PAIRS[pair];
+        p[1] = DIGIT_PAIRS[pair + 1];
+    }
+    if (n >= 10) {
+        p -= 2;
+        p[0] = DIGIT_PAIRS[n * 2];
+        p[1] = DIGIT_PAIRS[n * 2 + 1];
+    } else {
+        *--p = (char)('0' + n);
+    }
+    return p;
+}
+
+static size_t digit_count(uint64_t n) {
+    size_t count = 1;
+    while (n >= 10000) {
+        n /= 10000;
+        count += 4;
+    }
+    if (n >= 1000) return count + 3;
+    if (n >= 100) return count + 2;
+    if (n >= 10) return count + 1;
+    return count;
+}
+
+// Magnitude as unsigned, so INT64_MIN needs no special case
+static inline uint64_t magnitude(int64_t value) {
+    return value < 0 ? 0 - (uint64_t)value : (uint64_t)value;
+}
+
+size_t rt_format_int64(int64_t value, char* out) {
+    size_t len = (value < 0) + digit_count(magnitude(value));
+    format_digits_backwards(magnitude(value), out + len);
+    if (value < 0) {
+        out[0] = '-';
+    }
+    return len;
+}
+
+size_t rt_int64_len(int64_t value) {
+    return (value < 0) + digit_count(magnitude(value));
+}
+
+// ============================================================================
+// Floats: shortest round-trip digits (Grisu3)
+//
+// Follows Loitsch, "Printing Floating-Point Numbers Quickly and Accurately
+// with Integers" (PLDI 2010), as implemented in double-conversion. The value
+// and its rounding boundaries are scaled by a cached power of ten into a
+// 64-bit fixed-point range, and digits are generated until the result lies
+// strictly inside the boundaries. Grisu3 detects the ~0.5% of inputs where
+// the fixed-point error leaves the answer undecided; those go to an exact
+// search with snprintf/strtod instead.
+// ============================================================================
+
+typedef struct {
+    uint64_t f;
+    int e;
+} DiyFp;
+
+#define DOUBLE_HIDDEN_BIT   ((uint64_t)1 << 52)
+#define DOUBLE_FRAC_MASK    (DOUBLE_HIDDEN_BIT - 1)
+#define DOUBLE_EXP_BIAS     1075  // 1023 + 52 fraction bits
+#define GRISU_MIN_TARGET_EXPONENT (-60)
+#define GRISU_MAX_TARGET_EXPONENT (-32)
+
+// Normalized 64-bit approximations of 10^k for k = -348, -340, ..., 340
+typedef struct {
+    uint64_t significand;
+    int16_t binary_exponent;
+    int16_t decimal_exponent;
+} CachedPower;
+
+static const CachedPower CACHED_POWERS[] = {
+    {0xfa8fd5a0081c0288ULL, -1220, -348},
+    {0xbaaee17fa23ebf76ULL, -1193, -340},
+    {0x8b16fb203055ac76ULL, -1166, -332},
+    {0xcf42894a5dce35eaULL, -1140, -324},
+    {0x9a6bb0aa55653b2dULL, -1113, -316},
+    {0xe61acf033d1a45dfULL, -1087, -308},
+    {0xab70fe17c79ac6caULL, -1060, -300},
+    {0xff77b1fcbebcdc4fULL, -1034, -292},
+    {0xbe5691ef416bd60cULL, -1007, -284},
+    {0x8dd01fad907ffc3cULL, -980, -276},
+    {0xd3515c2831559a83ULL, -954, -268},
+    {0x9d71ac8fada6c9b5ULL, -927, -260},
+    {0xea9c227723ee8bcbULL, -901, -252},
+    {0xaecc49914078536dULL, -874, -244},
+    {0x823c12795db6ce57ULL, -847, -236},
+    {0xc21094364dfb5637ULL, -821, -228},
+    {0x9096ea6f3848984fULL, -794, -220},
+    {0xd77485cb25823ac7ULL, -768, -212},
+    {0xa086cfcd97bf97f4ULL, -741, -204},
+    {0xef340a98172aace5ULL, -715, -196},
+    {0xb23867fb2a35b28eULL, -688, -188},
+    {0x84c8d4dfd2c63f3bULL, -661, -180},
+    {0xc5dd44271ad3cdbaULL, -635, -172},
+    {0x936b9fcebb25c996ULL, -608, -164},
+    {0xdbac6c247d62a584ULL, -582, -156},
+    {0xa3ab66580d5fdaf6ULL, -555, -148},
+    {0xf3e2f893dec3f126ULL, -529, -140},
+    {0xb5b5ada8aaff80b8ULL, -502, -132},
+    {0x87625f056c7c4a8bULL, -475, -124},
+    {0xc9bcff6034c13053ULL, -449, -116},
+    {0x964e858c91ba2655ULL, -422, -108},
+    {0xdff9772470297ebdULL, -396, -100},
+    {0xa6dfbd9fb8e5b88fULL, -369, -92},
+    {0xf8a95fcf88747d94ULL, -343, -84},
+    {0xb94470938fa89bcfULL, -316, -76},
+    {0x8a08f0f8bf0f156bULL, -289, -68},
+    {0xcdb02555653131b6ULL, -263, -60},
+    {0x993fe2c6d07b7facULL, -236, -52},
+    {0xe45c10c42a2b3b06ULL, -210, -44},
+    {0xaa242499697392d3ULL, -183, -36},
+    {0xfd87b5f28300ca0eULL, -157, -28},
+    {0xbce5086492111aebULL, -130, -20},
+    {0x8cbccc096f5088ccULL, -103, -12},
+    {0xd1b71758e219652cULL, -77, -4},
+    {0x9c40000000000000ULL, -50, 4},
+    {0xe8d4a51000000000ULL, -24, 12},
+    {0xad78ebc5ac620000ULL, 3, 20},
+    {0x813f3978f8940984ULL, 30, 28},
+    {0xc097ce7bc90715b3ULL, 56, 36},
+    {0x8f7e32ce7bea5c70ULL, 83, 44},
+    {0xd5d238a4abe98068ULL, 109, 52},
+    {0x9f4f2726179a2245ULL, 136, 60},
+    {0xed63a231d4c4fb27ULL, 162, 68},
+    {0xb0de65388cc8ada8ULL, 189, 76},
+    {0x83c7088e1aab65dbULL, 216, 84},
+    {0xc45d1df942711d9aULL, 242, 92},
+    {0x924d692ca61be758ULL, 269, 100},
+    {0xda01ee641a708deaULL, 295, 108},
+    {0xa26da3999aef774aULL, 322, 116},
+    {0xf209787bb47d6b85ULL, 348, 124},
+    {0xb454e4a179dd1877ULL, 375, 132},
+    {0x865b86925b9bc5c2ULL, 402, 140},
+    {0xc83553c5c8965d3dULL, 428, 148},
+    {0x952ab45cfa97a0b3ULL, 455, 156},
+    {0xde469fbd99a05fe3ULL, 481, 164},
+    {0xa59bc234db398c25ULL, 508, 172},
+    {0xf6c69a72a3989f5cULL, 534, 180},
+    {0xb7dcbf5354e9beceULL, 561, 188},
+    {0x88fcf317f22241e2ULL, 588, 196},
+    {0xcc20ce9bd35c78a5ULL, 614, 204},
+    {0x98165af37b2153dfULL, 641, 212},
+    {0xe2a0b5dc971f303aULL, 667, 220},
+    {0xa8d9d1535ce3b396ULL, 694, 228},
+    {0xfb9b7cd9a4a7443cULL, 720, 236},
+    {0xbb764c4ca7a44410ULL, 747, 244},
+    {0x8bab8eefb6409c1aULL, 774, 252},
+    {0xd01fef10a657842cULL, 800, 260},
+    {0x9b10a4e5e9913129ULL, 827, 268},
+    {0xe7109bfba19c0c9dULL, 853, 276},
+    {0xac2820d9623bf429ULL, 880, 284},
+    {0x80444b5e7aa7cf85ULL, 907, 292},
+    {0xbf21e44003acdd2dULL, 933, 300},
+    {0x8e679c2f5e44ff8fULL, 960, 308},
+    {0xd433179d9c8cb841ULL, 986, 316},
+    {0x9e19db92b4e31ba9ULL, 1013, 324},
+    {0xeb96bf6ebadf77d9ULL, 1039, 332},
+    {0xaf87023b9bf0ee6bULL, 1066, 340},
+};
+
+#define CACHED_POWERS_OFFSET 348
+#define CACHED_POWERS_STEP   8
+
+static DiyFp diy_normalize(DiyFp v) {
+    while ((v.f & ((uint64_t)1 << 63)) == 0) {
+        v.f <<= 1;
+        v.e--;
+    }
+    return v;
+}
+
+// Product rounded to the upper 64 bits
+static DiyFp diy_multiply(DiyFp x, DiyFp y) {
+    const uint64_t mask = 0xFFFFFFFFu;
+    uint64_t a = x.f >> 32, b = x.f & mask;
+    uint64_t c = y.f >> 32, d = y.f & mask;
+    uint64_t ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+    uint64_t mid = (bd >> 32) + (ad & mask) + (bc & mask) + ((uint64_t)1 << 31);
+    DiyFp result = {ac + (ad >> 32) + (bc >> 32) + (mid >> 32), x.e + y.e + 64};
+    return result;
+}
+
+// A cached 10^k that brings a value with binary exponent e into the target range
+static DiyFp cached_power_for(int e, int* decimal_exponent) {
+    int min_exponent = GRISU_MIN_TARGET_EXPONENT - (e + 64);
+    double k = (min_exponent + 63) * 0.30102999566398114;  // log10(2)
+    int ki = (int)k;
+    if (ki < k) ki++;
+    int index = (CACHED_POWERS_OFFSET + ki - 1) / CACHED_POWERS_STEP + 1;
+    const CachedPower* power = &CACHED_POWERS[index];
+    *decimal_exponent = power->decimal_exponent;
+    DiyFp result = {power->significand, power->binary_exponent};
+    return result;
+}
+
+// Nudge the last digit towards w; fails when the result is not provably closest
+static int round_weed(char* buffer, int length, uint64_t distance_too_high_w,
+                      uint64_t unsafe_interval, uint64_t rest, uint64_t ten_kappa,
+                      uint64_t unit) {
+    uint64_t small_distance = distance_too_high_w - unit;
+    uint64_t big_distance = distance_too_high_w + unit;
+    while (rest < small_distance && unsafe_interval - rest >= ten_kappa &&
+           (rest + ten_kappa < small_distance ||
+            small_distance - rest >= rest + ten_kappa - small_distance)) {
+        buffer[length - 1]--;
+        rest += ten_kappa;
+    }
+    if (rest < big_distance && unsafe_interval - rest >= ten_kappa &&
+        (rest + ten_kappa < big_distance ||
+         big_distance - rest > rest + ten_kappa - big_distance)) {
+        return 0;
+    }
+    return 2 * unit <= rest && rest <= unsafe_interval - 4 * unit;
+}
+
+static int digit_gen(DiyFp low, DiyFp w, DiyFp high, char* buffer, int* length, int* kappa) {
+    uint64_t unit = 1;
+    DiyFp too_low = {low.f - unit, low.e};
+    DiyFp too_high = {high.f + unit, high.e};
+    uint64_t unsafe_interval = too_high.f - too_low.f;
+    int shift = -w.e;
+    uint64_t one = (uint64_t)1 << shift;
+    uint32_t integrals = (uint32_t)(too_high.f >> shift);
+    uint64_t fractionals = too_high.f & (one - 1);
+
+    uint32_t divisor = 0;
+    *kappa = 0;
+    if (integrals != 0) {
+        divisor = 1;
+        *kappa = 1;
+        while (divisor <= integrals / 10) {
+            divisor *= 10;
+            (*kappa)++;
+        }
+    }
+
+    *length = 0;
+    while (*kappa > 0) {
+        buffer[(*length)++] = (char)('0' + integrals / divisor);
+        integrals %= divisor;
+        (*kappa)--;
+        uint64_t rest = ((uint64_t)integrals << shift) + fractionals;
+        if (rest < unsafe_interval) {
+            return round_weed(buffer, *length, too_high.f - w.f, unsafe_interval, rest,
+                              (uint64_t)divisor << shift, unit);
+        }
+        divisor /= 10;
+    }
+
+    for (;;) {
+        fractionals *= 10;
+        unit *= 10;
+        unsafe_interval *= 10;
+        buffer[(*length)++] = (char)('0' + (fractionals >> shift));
+        fractionals &= one - 1;
+        (*kappa)--;
+        if (fractionals < unsafe_interval) {
+            return round_weed(buffer, *length, (too_high.f - w.f) * unit, unsafe_interval,
+                              fractionals, one, unit);
+        }
+    }
+}
+
+// Digits of a positive finite double: value = digits * 10^exponent
+static int grisu3(uint64_t bits, char* buffer, int* length, int* exponent) {
+    int biased = (int)((bits >> 52) & 0x7FF);
+    uint64_t frac = bits & DOUBLE_FRAC_MASK;
+    DiyFp v;
+    if (biased == 0) {
+        v.f = frac;
+        v.e = 1 - DOUBLE_EXP_BIAS;
+    } else {
+        v.f = frac | DOUBLE_HIDDEN_BIT;
+        v.e = biased - DOUBLE_EXP_BIAS;
+    }
+
+    DiyFp plus = {(v.f << 1) + 1, v.e - 1};
+    plus = diy_normalize(plus);
+    DiyFp minus;
+    if (frac == 0 && biased > 1) {
+        // The next lower double is half as far away
+        minus.f = (v.f << 2) - 1;
+        minus.e = v.e - 2;
+    } else {
+        minus.f = (v.f << 1) - 1;
+        minus.e = v.e - 1;
+    }
+    minus.f <<= minus.e - plus.e;
+    minus.e = plus.e;
+    DiyFp w = diy_normalize(v);
+
+    int mk;
+    DiyFp ten_mk = cached_power_for(w.e, &mk);
+    DiyFp scaled_w = diy_multiply(w, ten_mk);
+    DiyFp scaled_minus = diy_multiply(minus, ten_mk);
+    DiyFp scaled_plus = diy_multiply(plus, ten_mk);
+
+    int kappa;
+    if (!digit_gen(scaled_minus, scaled_w, scaled_plus, buffer, length, &kappa)) {
+        return 0;
+    }
+    *exponent = kappa - mk;
+    return 1;
+}
+
+// Exact fallback: the shortest %.*e output that reads back as the value
+static void shortest_by_search(double value, char* buffer, int* length, int* exponent) {
+    char text[40];
+    for (int precision = 0; precision < 17; precision++) {
+        snprintf(text, sizeof(text), "%.*e", precision, value);
+        if (strtod(text, NULL) == value || precision == 16) {
+            break;
+        }
+    }
+    // text is "d.ddde[+-]xx"
+    int n = 0;
+    const char* p = text;
+    for (; *p != 'e'; p++) {
+        if (*p != '.') buffer[n++] = *p;
+    }
+    int exp10 = atoi(p + 1);
+    while (n > 1 && buffer[n - 1] == '0') n--;
+    *length = n;
+    *exponent = exp10 - (n - 1);
+}
+
+size_t rt_format_float(double value, char* out) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    size_t pos = 0;
+    if (bits >> 63) {
+        out[pos++] = '-';
+        bits &= ~((uint64_t)1 << 63);
+    }
+
+    if ((bits >> 52) == 0x7FF) {
+        if (bits & DOUBLE_FRAC_MASK) {
+            memcpy(out, "nan", 3);  // repr(nan) has no sign
+            return 3;
+        }
+        memcpy(out + pos, "inf", 3);
+        return pos + 3;
+    }
+    if (bits == 0) {
+        memcpy(out + pos, "0.0", 3);
+        return pos + 3;
+    }
+
+    char digits[18];
+    int length, exponent;
+    if (!grisu3(bits, digits, &length, &exponent)) {
+        double magnitude_value;
+        memcpy(&magnitude_value, &bits, sizeof(bits));
+        shortest_by_search(magnitude_value, digits, &length, &exponent);
+    }
+
+    // Position of the decimal point relative to the first digit
+    int point = exponent + length;
+    if (point > -4 && point <= 16) {
+        if (point <= 0) {
+            // 0.000ddd
+            out[pos++] = '0';
+            out[pos++] = '.';
+            for (int i = point; i < 0; i++) out[pos++] = '0';
+            memcpy(out + pos, digits, (size_t)length);
+            pos += (size_t)length;
+        } else if (point >= length) {
+            // ddd000.0
+            memcpy(out + pos, digits, (size_t)length);
+            pos += (size_t)length;
+            for (int i = length; i < point; i++) out[pos++] = '0';
+            out[pos++] = '.';
+            out[pos++] = '0';
+        } else {
+            // ddd.ddd
+            memcpy(out + pos, digits, (size_t)point);
+            pos += (size_t)point;
+            out[pos++] = '.';
+            memcpy(out + pos, digits + point, (size_t)(length - point));
+            pos += (size_t)(length - point);
+        }
+        return pos;
+    }
+
+    // d.ddde+XX, with at least two exponent digits
+    out[pos++] = digits[0];
+    if (length > 1) {
+        out[pos++] = '.';
+        memcpy(out + pos, digits + 1, (size_t)(length - 1));
+        pos += (size_t)(length - 1);
+    }
+    int exp10 = point - 1;
+    out[pos++] = 'e';
+    out[pos++] = exp10 < 0 ? '-' : '+';
+    if (exp10 < 0) exp10 = -exp10;
+    if (exp10 >= 100) {
+        out[pos++] = (char)('0' + exp10 / 100);
+        exp10 %= 100;
+    }
+    out[pos++] = DIGIT_PAIRS[exp10 * 2];
+    out[pos++] = DIGIT_PAIRS[exp10 * 2 + 1];
+    return pos;
+}
+
+// ============================================================================
+// Parsing
+// ============================================================================
+
+static inline int is_space(char c) {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+static inline int is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+// Trim ASCII whitespace from both ends of [*start, *end)
+static void trim(const char** start, const char** end) {
+    while (*start < *end && is_space(**start)) (*start)++;
+    while (*end > *start && is_space((*end)[-1])) (*end)--;
+}
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+// Eight ASCII digits loaded little-endian, or -1 if any byte is not a digit
+static inline int64_t parse_eight_digits(const char* p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    if (((v & 0xF0F0F0F0F0F0F0F0ULL) | (((v + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) !=
+        0x3333333333333333ULL) {
+        return -1;
+    }
+    v -= 0x3030303030303030ULL;
+    v = (v * 10) + (v >> 8);
+    v = (((v & 0x000000FF000000FFULL) * (100 + (1000000ULL << 32))) +
+         (((v >> 16) & 0x000000FF000000FFULL) * (1 + (10000ULL << 32)))) >> 32;
+    return (int64_t)v;
+}
+#endif
+
+// Digits with single underscores between them, accumulated into *value. Only
+// the first 19 significant digits are kept exactly; the count of every digit
+// after the leading zeros goes to *significant. Returns the end of the run,
+// or NULL if an underscore is misplaced.
+static const char* scan_digits(const char* p, const char* end, uint64_t* value, int* significant) {
+    const char* start = p;
+    for (;;) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        while (end - p >= 8 && *significant + 8 <= 19) {
+            int64_t chunk = parse_eight_digits(p);
+            if (chunk < 0) break;
+            *value = *value * 100000000 + (uint64_t)chunk;
+            if (*significant > 0) {
+                *significant += 8;
+            } else if (*value != 0) {
+                *significant = (int)digit_count(*value);  // Skip the leading zeros
+            }
+            p += 8;
+        }
+#endif
+        if (p < end && is_digit(*p)) {
+            if (*significant < 19) {
+                *value = *value * 10 + (uint64_t)(*p - '0');
+            }
+            if (*significant > 0 || *p != '0') (*significant)++;
+            p++;
+            continue;
+        }
+        if (p < end && *p == '_') {
+            if (p == start || p + 1 >= end || !is_digit(p[1])) return NULL;
+            p++;
+            continue;
+        }
+        return p;
+    }
+}
+
+RtParseResult rt_parse_int64(const char* text, size_t len, int64_t* out) {
+    const char* p = text;
+    const char* end = text + len;
+    trim(&p, &end);
+
+    int negative = 0;
+    if (p < end && (*p == '+' || *p == '-')) {
+        negative = *p == '-';
+        p++;
+    }
+    if (p == end || !is_digit(*p)) {
+        return RT_PARSE_INVALID;
+    }
+
+    uint64_t value = 0;
+    int significant = 0;
+    p = scan_digits(p, end, &value, &significant);
+    if (p != end) {
+        return RT_PARSE_INVALID;
+    }
+
+    uint64_t limit = negative ? (uint64_t)INT64_MAX + 1 : (uint64_t)INT64_MAX;
+    if (significant > 19 || value > limit) {
+        return RT_PARSE_OVERFLOW;
+    }
+    *out = negative ? (int64_t)(0 - value) : (int64_t)value;
+    return RT_PARSE_OK;
+}
+
+// Case-insensitive match of the whole of [p, end) against a lowercase word
+static int matches_word(const char* p, const char* end, const char* word) {
+    size_t len = strlen(word);
+    if ((size_t)(end - p) != len) return 0;
+    for (size_t i = 0; i < len; i++) {
+        if ((p[i] | 0x20) != word[i]) return 0;
+    }
+    return 1;
+}
+
+// Powers of ten that are exact doubles
+static const double EXACT_POWERS_OF_TEN[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+RtParseResult rt_parse_float(const char* text, size_t len, double* out) {
+    const char* p = text;
+    const char* end = text + len;
+    trim(&p, &end);
+
+    const char* number = p;
+    int negative = 0;
+    if (p < end && (*p == '+' || *p == '-')) {
+        negative = *p == '-';
+        p++;
+    }
+
+    if (matches_word(p, end, "inf") || matches_word(p, end, "infinity")) {
+        *out = negative ? -__builtin_inf() : __builtin_inf();
+        return RT_PARSE_OK;
+    }
+    if (matches_word(p, end, "nan")) {
+        *out = __builtin_nan("");
+        return RT_PARSE_OK;
+    }
+
+    uint64_t mantissa = 0;
+    int significant = 0;
+    int exp10 = 0;
+    int any_digits = 0;
+    if (p < end && is_digit(*p)) {
+        p = scan_digits(p, end, &mantissa, &significant);
+        if (p == NULL) return RT_PARSE_INVALID;
+        any_digits = 1;
+    }
+    if (p < end && *p == '.') {
+        p++;
+        if (p < end && is_digit(*p)) {
+            const char* fraction = p;
+            p = scan_digits(p, end, &mantissa, &significant);
+            if (p == NULL) return RT_PARSE_INVALID;
+            for (const char* q = fraction; q < p; q++) {
+                exp10 -= *q != '_';
+            }
+            any_digits = 1;
+        }
+    }
+    if (!any_digits) {
+        return RT_PARSE_INVALID;
+    }
+
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        p++;
+        int exp_negative = 0;
+        if (p < end && (*p == '+' || *p == '-')) {
+            exp_negative = *p == '-';
+            p++;
+        }
+        if (p == end || !is_digit(*p)) {
+            return RT_PARSE_INVALID;
+        }
+        uint64_t exp_value = 0;
+        int exp_digits = 0;
+        p = scan_digits(p, end, &exp_value, &exp_digits);
+        if (p == NULL) return RT_PARSE_INVALID;
+        if (exp_digits > 6) exp_value = 1000000;  // Far outside the double range
+        exp10 += exp_negative ? -(int)exp_value : (int)exp_value;
+    }
+    if (p != end) {
+        return RT_PARSE_INVALID;
+    }
+
+    // Clinger's fast path: an exact mantissa times an exact power of ten is a
+    // single correctly rounded operation
+    if (significant == 0) {
+        *out = negative ? -0.0 : 0.0;
+        return RT_PARSE_OK;
+    }
+    if (significant <= 19 && mantissa <= ((uint64_t)1 << 53) && exp10 >= -22 && exp10 <= 22) {
+        double value = (double)mantissa;
+        value = exp10 >= 0 ? value * EXACT_POWERS_OF_TEN[exp10]
+                           : value / EXACT_POWERS_OF_TEN[-exp10];
+        *out = negative ? -value : value;
+        return RT_PARSE_OK;
+    }
+
+    // Everything else is already validated; strtod rounds it exactly
+    size_t count = (size_t)(end - number);
+    char* copy = (char*)rt_alloc(count + 1);
+    size_t n = 0;
+    for (const char* q = number; q < end; q++) {
+        if (*q != '_') copy[n++] = *q;
+    }
+    copy[n] = '\0';
+    *out = strtod(copy, NULL);
+    rt_free(copy, count + 1);
+    return RT_PARSE_OK;
+}
@@ -0,0 +1,42 @@
+#ifndef FORMAT_H
+#define FORMAT_H
+
+// ============================================================================
+// Number formatting and parsing
+//
+// int and float conversions to and from text, without going through stdio.
+// Integers are formatted two digits at a time. Floats are formatted like
+// Python's repr(): the shortest digit string that reads back as the same
+// double (Grisu3, with an exact fallback for the rare inputs it cannot
+// decide), in fixed notation for exponents -4 <= e < 16 and scientific
+// notation otherwise. The parsers accept the same syntax as int() and
+// float() in base 10, including surrounding whitespace and underscores
+// between digits.
+// ============================================================================
+
+#include "types.h"
+
+// Longest output of each formatter ("-9223372036854775808",
+// "-2.2250738585072014e-308"); buffers of these sizes need no terminator
+#define RT_INT64_MAX_CHARS 20
+#define RT_FLOAT_MAX_CHARS 24
+
+// Write `value` in decimal at `out`, returning the number of characters
+size_t rt_format_int64(int64_t value, char* out);
+
+// Number of characters rt_format_int64 writes for `value`
+size_t rt_int64_len(int64_t value);
+
+// Write repr(value) at `out`, returning the number of characters
+size_t rt_format_float(double value, char* out);
+
+typedef enum {
+    RT_PARSE_OK,
+    RT_PARSE_INVALID,   // Not a base-10 literal
+    RT_PARSE_OVERFLOW,  // Valid, but outside the int64 range
+} RtParseResult;
+
+RtParseResult rt_parse_int64(const char* text, size_t len, int64_t* out);
+RtParseResult rt_parse_float(const char* text, size_t len, double* out);
+
+#endif // FORMAT_H
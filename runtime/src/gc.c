@@ -0,0 +1,456 @@
+#include "gc.h"
+#include "runtime.h"
+#include <pthread.h>
+#include <setjmp.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <time.h>
+
+extern char** environ;
+
+#define GC_DEFAULT_THRESHOLD (8 * 1024 * 1024)
+#define GC_DEFAULT_GROWTH    200
+
+// ============================================================================
+// Object header (precedes the payload when the collector is enabled)
+// ============================================================================
+
+typedef struct GcHeader {
+    struct GcHeader* prev;
+    struct GcHeader* next;
+    uint32_t size;  // Payload bytes
+    uint8_t kind;   // RtObjectKind
+    uint8_t marked;
+    uint8_t mapped;  // Lives in a MappedRegion, not the heap
+    uint8_t reserved;
+} GcHeader;
+
+// Where an adopted object's mapping starts, stored right before its GcHeader
+typedef struct {
+    void* base;
+    size_t total;
+} MappedRegion;
+
+_Static_assert(sizeof(MappedRegion) + sizeof(GcHeader) <= RT_MAPPED_OBJECT_PREFIX,
+               "mapped objects leave too little room for their header");
+
+#define HEADER_OF(ptr)  ((GcHeader*)(ptr) - 1)
+#define PAYLOAD_OF(hdr) ((void*)((GcHeader*)(hdr) + 1))
+
+static int gc_enabled = 0;
+static GcHeader* objects = NULL;
+static int64_t threshold = GC_DEFAULT_THRESHOLD;
+static int64_t min_threshold = GC_DEFAULT_THRESHOLD;
+static int64_t growth_percent = GC_DEFAULT_GROWTH;
+static int64_t allocated_since_gc = 0;
+static char* stack_top = NULL;
+static RtGcStats stats;
+
+// Serializes the object list while a parallel loop runs. Collections wait
+// until the loop is over, since only the calling thread's stack is scanned.
+static pthread_mutex_t parallel_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Registered roots
+static void*** roots = NULL;
+static int64_t roots_len = 0;
+static int64_t roots_cap = 0;
+
+// ============================================================================
+// Allocation
+// ============================================================================
+
+static void link_object(GcHeader* hdr) {
+    hdr->prev = NULL;
+    hdr->next = objects;
+    if (objects) objects->prev = hdr;
+    objects = hdr;
+}
+
+static void unlink_object(GcHeader* hdr) {
+    if (hdr->prev) hdr->prev->next = hdr->next;
+    else objects = hdr->next;
+    if (hdr->next) hdr->next->prev = hdr->prev;
+}
+
+void* rt_alloc_object(size_t size, RtObjectKind kind) {
+    if (rt_profile_enabled) {
+        rt_profile_alloc(kind, size);
+    }
+    if (!gc_enabled) {
+        return rt_alloc(size);
+    }
+
+    int parallel = rt_parallel_running();
+    if (parallel) {
+        pthread_mutex_lock(&parallel_lock);
+    } else if (allocated_since_gc >= threshold) {
+        __pyc_gc_collect();
+    }
+
+    // Every object gets at least one byte so each payload has a unique address
+    if (size == 0) size = 1;
+
+    GcHeader* hdr = (GcHeader*)rt_alloc(sizeof(GcHeader) + size);
+    hdr->size = (uint32_t)size;
+    hdr->kind = (uint8_t)kind;
+    hdr->marked = 0;
+    hdr->mapped = 0;
+    hdr->reserved = 0;
+    link_object(hdr);
+
+    stats.live_objects++;
+    stats.live_bytes += (int64_t)size;
+    allocated_since_gc += (int64_t)size;
+    if (parallel) {
+        pthread_mutex_unlock(&parallel_lock);
+    }
+    return PAYLOAD_OF(hdr);
+}
+
+void rt_adopt_mapped_object(void* obj, size_t size, RtObjectKind kind, void* base, size_t total) {
+    if (rt_profile_enabled) {
+        rt_profile_alloc(kind, size);
+    }
+    if (!gc_enabled) return;
+
+    int parallel = rt_parallel_running();
+    if (parallel) {
+        pthread_mutex_lock(&parallel_lock);
+    } else if (allocated_since_gc >= threshold) {
+        __pyc_gc_collect();
+    }
+
+    GcHeader* hdr = HEADER_OF(obj);
+    MappedRegion* region = (MappedRegion*)hdr - 1;
+    region->base = base;
+    region->total = total;
+    hdr->size = (uint32_t)size;
+    hdr->kind = (uint8_t)kind;
+    hdr->marked = 0;
+    hdr->mapped = 1;
+    hdr->reserved = 0;
+    link_object(hdr);
+
+    // Counted like a heap object, so reading many files triggers collections
+    stats.live_objects++;
+    stats.live_bytes += (int64_t)size;
+    allocated_since_gc += (int64_t)size;
+    if (parallel) {
+        pthread_mutex_unlock(&parallel_lock);
+    }
+}
+
+// Release an owned buffer when its object dies
+static void finalize_object(GcHeader* hdr) {
+    void* obj = PAYLOAD_OF(hdr);
+    switch ((RtObjectKind)hdr->kind) {
+        case RT_KIND_LIST: {
+            List* list = (List*)obj;
+            rt_free(list->data, (size_t)list->elem_size * list->cap);
+            break;
+        }
+        case RT_KIND_BYTEARRAY: {
+            ByteArray* ba = (ByteArray*)obj;
+            rt_free(ba->data, (size_t)ba->cap);
+            break;
+        }
+        case RT_KIND_HASH_TABLE:
+            rt_hash_table_release((HashTable*)obj);
+            break;
+        case RT_KIND_STRING:
+            rt_string_release((String*)obj);
+            break;
+        case RT_KIND_STR_BUILDER:
+            rt_str_builder_release((StrBuilder*)obj);
+            break;
+        case RT_KIND_FILE:
+            rt_file_release((File*)obj);
+            break;
+        default:
+            break;
+    }
+}
+
+static void destroy_object(GcHeader* hdr) {
+    unlink_object(hdr);
+    stats.live_objects--;
+    stats.live_bytes -= hdr->size;
+    if (hdr->mapped) {
+        MappedRegion* region = (MappedRegion*)hdr - 1;
+        munmap(region->base, region->total);
+    } else {
+        rt_free(hdr, sizeof(GcHeader) + hdr->size);
+    }
+}
+
+void rt_free_object(void* ptr, size_t size) {
+    if (ptr == NULL) return;
+    if (!gc_enabled) {
+        rt_free(ptr, size);
+        return;
+    }
+    // The caller has already released owned buffers
+    int parallel = rt_parallel_running();
+    if (parallel) pthread_mutex_lock(&parallel_lock);
+    destroy_object(HEADER_OF(ptr));
+    if (parallel) pthread_mutex_unlock(&parallel_lock);
+}
+
+// ============================================================================
+// Roots
+// ============================================================================
+
+void __pyc_gc_add_root(void** slot) {
+    if (roots_len == roots_cap) {
+        roots_cap = roots_cap ? roots_cap * 2 : 64;
+        roots = (void***)realloc(roots, sizeof(void**) * (size_t)roots_cap);
+        if (roots == NULL) {
+            rt_panic("Out of memory");
+        }
+    }
+    roots[roots_len++] = slot;
+}
+
+// ============================================================================
+// Marking
+// ============================================================================
+
+// Objects sorted by address for the duration of a collection
+static GcHeader** sorted = NULL;
+static int64_t sorted_len = 0;
+
+// Grey objects waiting to be scanned
+static GcHeader** worklist = NULL;
+static int64_t worklist_len = 0;
+static int64_t worklist_cap = 0;
+
+static int compare_headers(const void* a, const void* b) {
+    uintptr_t x = (uintptr_t)*(GcHeader* const*)a;
+    uintptr_t y = (uintptr_t)*(GcHeader* const*)b;
+    return (x > y) - (x < y);
+}
+
+// Find the object whose payload contains addr
+static GcHeader* find_object(uintptr_t addr) {
+    int64_t lo = 0;
+    int64_t hi = sorted_len - 1;
+    while (lo <= hi) {
+        int64_t mid = lo + (hi - lo) / 2;
+        GcHeader* hdr = sorted[mid];
+        uintptr_t start = (uintptr_t)PAYLOAD_OF(hdr);
+        if (addr < start) {
+            hi = mid - 1;
+        } else if (addr >= start + hdr->size) {
+            lo = mid + 1;
+        } else {
+            return hdr;
+        }
+    }
+    return NULL;
+}
+
+static void mark_word(uintptr_t word) {
+    GcHeader* hdr = find_object(word);
+    if (hdr == NULL || hdr->marked) return;
+
+    hdr->marked = 1;
+    if (worklist_len == worklist_cap) {
+        worklist_cap = worklist_cap ? worklist_cap * 2 : 256;
+        worklist = (GcHeader**)realloc(worklist, sizeof(GcHeader*) * (size_t)worklist_cap);
+        if (worklist == NULL) {
+            rt_panic("Out of memory");
+        }
+    }
+    worklist[worklist_len++] = hdr;
+}
+
+// Conservative scans read whole stack frames, including sanitizer redzones
+__attribute__((no_sanitize("address")))
+static void mark_range(const void* begin, const void* end) {
+    uintptr_t p = ((uintptr_t)begin + sizeof(uintptr_t) - 1) & ~(uintptr_t)(sizeof(uintptr_t) - 1);
+    for (; p + sizeof(uintptr_t) <= (uintptr_t)end; p += sizeof(uintptr_t)) {
+        mark_word(*(const uintptr_t*)p);
+    }
+}
+
+static void scan_object(GcHeader* hdr) {
+    void* obj = PAYLOAD_OF(hdr);
+    switch ((RtObjectKind)hdr->kind) {
+        case RT_KIND_LIST: {
+            // Only pointer storage can reference other objects
+            List* list = (List*)obj;
+            if (list->data && (list->elem_kind == LIST_ELEM_STR ||
+                               list->elem_kind == LIST_ELEM_OBJECT)) {
+                mark_range(list->data, (void**)list->data + list->len);
+            }
+            break;
+        }
+        case RT_KIND_LIST_ITERATOR:
+            mark_word((uintptr_t)((ListIterator*)obj)->list);
+            break;
+        case RT_KIND_HASH_TABLE: {
+            HashTable* t = (HashTable*)obj;
+            if (t->key_kind == LIST_ELEM_STR || t->key_kind == LIST_ELEM_OBJECT) {
+                mark_range(t->keys, t->keys + t->used);
+            }
+            if (t->values && (t->value_kind == LIST_ELEM_STR ||
+                              t->value_kind == LIST_ELEM_OBJECT)) {
+                mark_range(t->values, t->values + t->used);
+            }
+            break;
+        }
+        case RT_KIND_HASH_ITERATOR:
+            mark_word((uintptr_t)((HashTableIterator*)obj)->table);
+            break;
+        case RT_KIND_STR_BUILDER:
+            // The buffer holds only bytes
+            mark_word((uintptr_t)((StrBuilder*)obj)->base);
+            break;
+        case RT_KIND_EXCEPTION:
+        case RT_KIND_INSTANCE:
+            mark_range(obj, (char*)obj + hdr->size);
+            break;
+        case RT_KIND_STRING:
+        case RT_KIND_RANGE:
+        case RT_KIND_BYTES:
+        case RT_KIND_BYTEARRAY:
+        case RT_KIND_FILE:
+            break;
+    }
+}
+
+// Kept out of line so the jmp_buf holding the spilled registers stays in the
+// caller's frame, inside the scanned stack range
+__attribute__((noinline))
+static void mark_roots(const void* stack_bottom) {
+    for (int64_t i = 0; i < roots_len; i++) {
+        mark_word((uintptr_t)*roots[i]);
+    }
+    mark_range(stack_bottom, stack_top);
+
+    while (worklist_len > 0) {
+        scan_object(worklist[--worklist_len]);
+    }
+}
+
+// ============================================================================
+// Collection
+// ============================================================================
+
+static int64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void sweep(void) {
+    GcHeader* hdr = objects;
+    while (hdr != NULL) {
+        GcHeader* next = hdr->next;
+        if (hdr->marked) {
+            hdr->marked = 0;
+        } else {
+            stats.objects_freed++;
+            stats.bytes_freed += hdr->size;
+            finalize_object(hdr);
+            destroy_object(hdr);
+        }
+        hdr = next;
+    }
+}
+
+void __pyc_gc_collect(void) {
+    if (!gc_enabled || rt_parallel_running()) return;
+
+    int64_t start = now_ns();
+
+    // Spill callee-saved registers so pointers held only in registers are seen
+    jmp_buf registers;
+    setjmp(registers);
+
+    sorted_len = stats.live_objects;
+    sorted = (GcHeader**)realloc(sorted, sizeof(GcHeader*) * (size_t)(sorted_len ? sorted_len : 1));
+    if (sorted == NULL) {
+        rt_panic("Out of memory");
+    }
+    int64_t n = 0;
+    for (GcHeader* hdr = objects; hdr != NULL; hdr = hdr->next) {
+        sorted[n++] = hdr;
+    }
+    qsort(sorted, (size_t)sorted_len, sizeof(GcHeader*), compare_headers);
+
+    mark_roots(&registers);
+    sweep();
+
+    // Grow the threshold with the surviving heap so collection cost stays linear
+    int64_t grown = stats.live_bytes * growth_percent / 100;
+    threshold = grown > min_threshold ? grown : min_threshold;
+    allocated_since_gc = 0;
+
+    int64_t pause = now_ns() - start;
+    stats.collections++;
+    stats.total_pause_ns += pause;
+    if (pause > stats.max_pause_ns) {
+        stats.max_pause_ns = pause;
+    }
+}
+
+// ============================================================================
+// Initialization and statistics
+// ============================================================================
+
+void rt_gc_stats(RtGcStats* out) {
+    *out = stats;
+    out->threshold = threshold;
+}
+
+static void print_gc_stats(void) {
+    int64_t avg = stats.collections ? stats.total_pause_ns / stats.collections : 0;
+    fprintf(stderr,
+            "=== GC Stats ===\n"
+            "collections:   %ld\n"
+            "total pause:   %.3f ms\n"
+            "max pause:     %.3f ms\n"
+            "avg pause:     %.3f ms\n"
+            "objects freed: %ld\n"
+            "bytes freed:   %ld\n"
+            "live objects:  %ld\n"
+            "live bytes:    %ld\n"
+            "threshold:     %ld\n",
+            stats.collections, stats.total_pause_ns / 1e6, stats.max_pause_ns / 1e6,
+            avg / 1e6, stats.objects_freed, stats.bytes_freed, stats.live_objects,
+            stats.live_bytes, threshold);
+}
+
+static int64_t env_int(const char* name, int64_t fallback) {
+    const char* value = getenv(name);
+    if (value == NULL || value[0] == '\0') return fallback;
+    char* end;
+    long long parsed = strtoll(value, &end, 10);
+    return (*end == '\0' && parsed > 0) ? (int64_t)parsed : fallback;
+}
+
+void __pyc_gc_init(int64_t initial_threshold, int64_t growth) {
+    if (gc_enabled) return;
+
+    // The environment block sits above every frame of the initial stack
+    char here;
+    stack_top = (char*)environ;
+    if (stack_top == NULL || stack_top < &here) {
+        rt_panic("Cannot locate the stack for garbage collection");
+    }
+
+    min_threshold = initial_threshold > 0 ? initial_threshold : GC_DEFAULT_THRESHOLD;
+    min_threshold = env_int("PYC_GC_THRESHOLD", min_threshold);
+    growth_percent = growth > 0 ? growth : GC_DEFAULT_GROWTH;
+    growth_percent = env_int("PYC_GC_GROWTH", growth_percent);
+    threshold = min_threshold;
+    gc_enabled = 1;
+
+    const char* report = getenv("PYC_GC_STATS");
+    if (report != NULL && report[0] != '\0' && report[0] != '0') {
+        atexit(print_gc_stats);
+    }
+}
@@ -0,0 +1,95 @@
+#ifndef GC_H
+#define GC_H
+
+// ============================================================================
+// Runtime objects and the mark-sweep collector
+//
+// Runtime objects (String, List, Range, ListIterator, Exception, Bytes,
+// ByteArray, dict/set tables and their iterators, string builders and class
+// instances) are allocated with rt_alloc_object. Buffers owned by an object
+// (list, bytearray, hash table and builder data) stay plain rt_alloc memory and
+// are released with their owner.
+//
+// The collector is off unless the compiled program calls __pyc_gc_init (pycc
+// --gc mark-sweep). Without it, objects are ordinary rt_alloc allocations.
+// With it, each object carries a GcHeader and the heap is collected whenever
+// allocation since the last collection exceeds the threshold.
+//
+// Marking is conservative: the machine stack, registered roots and the
+// payloads of reachable objects are scanned for words that point into a live
+// object (interior pointers included). Only lists with pointer storage
+// (list[str] and lists of objects) have their elements scanned, and likewise
+// only pointer keys and values of dicts and sets.
+// ============================================================================
+
+#include "types.h"
+
+typedef enum {
+    RT_KIND_STRING,
+    RT_KIND_LIST,
+    RT_KIND_LIST_ITERATOR,
+    RT_KIND_RANGE,
+    RT_KIND_EXCEPTION,
+    RT_KIND_BYTES,
+    RT_KIND_BYTEARRAY,
+    RT_KIND_HASH_TABLE,
+    RT_KIND_HASH_ITERATOR,
+    RT_KIND_STR_BUILDER,
+    RT_KIND_FILE,
+    RT_KIND_INSTANCE,  // Class instance: every field is scanned conservatively
+} RtObjectKind;
+
+#define RT_NUM_OBJECT_KINDS (RT_KIND_INSTANCE + 1)
+
+// Allocate a runtime object of the given kind (uninitialized payload)
+void* rt_alloc_object(size_t size, RtObjectKind kind);
+
+// Space an object placed in a mapping of its own must leave before it
+#define RT_MAPPED_OBJECT_PREFIX 64
+
+// Hand the runtime an object of `size` bytes that lives inside a private
+// mapping of `total` bytes at `base` (a file read by mmap, see file.h), with at
+// least RT_MAPPED_OBJECT_PREFIX bytes of the mapping before it. The collector
+// unmaps it when the object is swept; without the collector it stays mapped,
+// as every other object stays allocated.
+void rt_adopt_mapped_object(void* obj, size_t size, RtObjectKind kind, void* base, size_t total);
+
+// Release an object early (compiler-proven dead). size is the payload size the
+// object was allocated with, or a lower bound of it (see rt_free).
+void rt_free_object(void* ptr, size_t size);
+
+// ============================================================================
+// Collector control (called from generated code)
+// ============================================================================
+
+// Enable the collector. threshold: bytes allocated between collections
+// (0 = default); growth_percent: after a collection the threshold becomes at
+// least live_bytes * growth_percent / 100 (0 = default). PYC_GC_THRESHOLD and
+// PYC_GC_GROWTH in the environment override both at run time.
+void __pyc_gc_init(int64_t threshold, int64_t growth_percent);
+
+// Register the address of a pointer-sized slot that may hold an object
+void __pyc_gc_add_root(void** slot);
+
+// Run a full collection now (no-op when the collector is disabled or a
+// parallel loop is running)
+void __pyc_gc_collect(void);
+
+// ============================================================================
+// Statistics (printed to stderr at exit when PYC_GC_STATS=1)
+// ============================================================================
+
+typedef struct {
+    int64_t collections;
+    int64_t total_pause_ns;
+    int64_t max_pause_ns;
+    int64_t objects_freed;
+    int64_t bytes_freed;
+    int64_t live_objects;
+    int64_t live_bytes;
+    int64_t threshold;
+} RtGcStats;
+
+void rt_gc_stats(RtGcStats* out);
+
+#endif // GC_H
@@ -0,0 +1,57 @@
+// ============================================================================
+// Empty ICU data package
+//
+// libicuuc refers to the common data package (icudtNN_dat) as soon as any of
+// it is linked, and libicudata.a is one object holding all ~30 MB of it.
+// The character properties, case mapping and NFC/NFD tables the runtime uses
+// are compiled into libicuuc itself, so programs that need nothing else from
+// ICU link this empty package instead (see the compiler's IcuUse). It is
+// built as an object of its own, never into the runtime bitcode, because it
+// defines the same symbol as libicudata.a.
+//
+// The layout follows ICU's stubdata/stubdata.cpp.
+// ============================================================================
+
+#ifndef NO_ICU
+
+#include <unicode/udata.h>
+#include <unicode/utypes.h>
+
+typedef struct {
+    uint16_t header_size;
+    uint8_t magic1;
+    uint8_t magic2;
+    UDataInfo info;
+    char padding[8];
+    uint32_t count;
+    uint32_t reserved;
+    // One table-of-contents entry, though count says there are none
+    uint32_t toc[4];
+} StubDataHeader;
+
+U_CAPI const StubDataHeader U_ICUDATA_ENTRY_POINT = {
+    32,  // header_size
+    0xda,
+    0x27,
+    {
+        sizeof(UDataInfo),
+        0,  // reserved
+#if U_IS_BIG_ENDIAN
+        1,
+#else
+        0,
+#endif
+        U_CHARSET_FAMILY,
+        sizeof(UChar),
+        0,                         // reserved
+        {0x43, 0x6d, 0x6e, 0x44},  // data format "CmnD"
+        {1, 0, 0, 0},              // format version
+        {0, 0, 0, 0},              // data version
+    },
+    {0, 0, 0, 0, 0, 0, 0, 0},
+    0,
+    0,
+    {0, 0, 0, 0},
+};
+
+#endif
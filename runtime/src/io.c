@@ -0,0 +1,85 @@
+#include "io.h"
+#include "memory.h"
+#include <errno.h>
+#include <pthread.h>
+#include <unistd.h>
+
+// ============================================================================
+// Buffered stdout
+// ============================================================================
+
+char rt_stdout_buffer[RT_STDOUT_BUFFER_SIZE];
+size_t rt_stdout_len = 0;
+int rt_stdout_line_buffered = 0;
+
+int rt_write_all(int fd, const char* data, size_t len) {
+    while (len > 0) {
+        ssize_t written = write(fd, data, len);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return errno;
+        }
+        data += written;
+        len -= (size_t)written;
+    }
+    return 0;
+}
+
+// Output that cannot be written to stdout is dropped
+static void write_all(const char* data, size_t len) {
+    rt_write_all(STDOUT_FILENO, data, len);
+}
+
+void rt_stdout_flush(void) {
+    if (rt_stdout_len > 0) {
+        size_t len = rt_stdout_len;
+        rt_stdout_len = 0;
+        write_all(rt_stdout_buffer, len);
+    }
+}
+
+void rt_stdout_write_slow(const char* str, size_t len) {
+    rt_stdout_flush();
+    if (len >= RT_STDOUT_BUFFER_SIZE) {
+        write_all(str, len);
+        return;
+    }
+    memcpy(rt_stdout_buffer, str, len);
+    rt_stdout_len = len;
+}
+
+static pthread_mutex_t stdout_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// The line being printed by this thread during a parallel loop
+static _Thread_local char* line_data = NULL;
+static _Thread_local size_t line_len = 0;
+static _Thread_local size_t line_cap = 0;
+
+void rt_print_parallel(const char* data, size_t len, int8_t end_line) {
+    // The value and its separator
+    size_t needed = line_len + len + 1;
+    if (needed > line_cap) {
+        size_t cap = line_cap ? line_cap : 256;
+        while (cap < needed) cap *= 2;
+        line_data = (char*)(line_data ? rt_realloc(line_data, line_cap, cap) : rt_alloc(cap));
+        line_cap = cap;
+    }
+    memcpy(line_data + line_len, data, len);
+    line_data[line_len + len] = end_line ? '\n' : ' ';
+    line_len = needed;
+    if (!end_line) return;
+
+    pthread_mutex_lock(&stdout_lock);
+    write_stdout(line_data, line_len);
+    if (rt_stdout_line_buffered) {
+        rt_stdout_flush();
+    }
+    pthread_mutex_unlock(&stdout_lock);
+    line_len = 0;
+}
+
+__attribute__((constructor))
+static void init_stdout(void) {
+    rt_stdout_line_buffered = isatty(STDOUT_FILENO);
+    atexit(rt_stdout_flush);
+}
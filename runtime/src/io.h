@@ -11,21 +11,79 @@
 #include <string.h>
 
 #include "types.h"
+#include "parallel.h"
+
+// ============================================================================
+// Buffered stdout
+//
+// Program output bypasses stdio: it is appended to one runtime-owned buffer
+// and handed to write(2) when the buffer fills, at exit, and before anything
+// is written to stderr (so a panic or an uncaught exception still appears
+// after the output that preceded it). When stdout is a terminal the buffer
+// is also flushed at the end of every line.
+// ============================================================================
+
+#define RT_STDOUT_BUFFER_SIZE (64 * 1024)
+
+extern char rt_stdout_buffer[RT_STDOUT_BUFFER_SIZE];
+extern size_t rt_stdout_len;
+extern int rt_stdout_line_buffered;
+
+// Write out everything buffered so far
+void rt_stdout_flush(void);
+
+// write(2) all of data to fd, retrying short writes; returns 0 or the errno
+// of the write that failed. Files buffer their writes the same way and flush
+// through this (see file.h).
+int rt_write_all(int fd, const char* data, size_t len);
+
+// Make room for at least `len` more bytes; `len` must not exceed the buffer size
+static inline char* rt_stdout_reserve(size_t len) {
+    if (len > RT_STDOUT_BUFFER_SIZE - rt_stdout_len) {
+        rt_stdout_flush();
+    }
+    return rt_stdout_buffer + rt_stdout_len;
+}
+
+// Write larger than the free space: flush, then write through or buffer
+void rt_stdout_write_slow(const char* str, size_t len);
+
+// While a parallel loop runs, a thread collects the line a print() statement
+// writes in a buffer of its own. The last argument appends the value and the
+// newline, then hands the whole line to stdout in one step under the stdout
+// lock, so lines from different threads never interleave.
+void rt_print_parallel(const char* data, size_t len, int8_t end_line);
 
 // ============================================================================
 // Output functions
 // ============================================================================
 
 static inline void write_stdout(const char* str, size_t len) {
-    fwrite(str, 1, len, stdout);
+    if (len > RT_STDOUT_BUFFER_SIZE - rt_stdout_len) {
+        rt_stdout_write_slow(str, len);
+        return;
+    }
+    memcpy(rt_stdout_buffer + rt_stdout_len, str, len);
+    rt_stdout_len += len;
+}
+
+// Terminate a line of print() output
+static inline void write_line_end(void) {
+    *rt_stdout_reserve(1) = '\n';
+    rt_stdout_len++;
+    if (rt_stdout_line_buffered) {
+        rt_stdout_flush();
+    }
 }
 
 static inline void write_stderr(const char* str, size_t len) {
+    rt_stdout_flush();
     fwrite(str, 1, len, stderr);
 }
 
 static inline void write_char(char c) {
-    putchar(c);
+    *rt_stdout_reserve(1) = c;
+    rt_stdout_len++;
 }
 
 // ============================================================================
@@ -33,11 +91,13 @@ static inline void write_char(char c) {
 // ============================================================================
 
 static inline void rt_panic(const char* message) {
+    rt_stdout_flush();
     fprintf(stderr, "Error: %s\n", message);
     exit(1);
 }
 
 static inline void rt_panic_index(const char* message, int64_t index, int64_t length) {
+    rt_stdout_flush();
     fprintf(stderr, "Error: %s: %ld (length: %ld)\n", message, index, length);
     exit(1);
 }
@@ -1,16 +1,23 @@
 #include "runtime.h"
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 
-List* LIST_METHOD(__init__)(void) {
-    List* list = (List*)malloc(sizeof(List));
+// ============================================================================
+// Storage-independent helpers
+// ============================================================================
+
+static List* list_new(ListElemKind kind, int32_t elem_size) {
+    List* list = (List*)rt_alloc_object(sizeof(List), RT_KIND_LIST);
     if (list == NULL) {
         rt_panic("Failed to allocate memory for list");
     }
 
     list->cap = 8;
     list->len = 0;
-    list->data = (int64_t*)malloc(sizeof(int64_t) * list->cap);
+    list->elem_size = elem_size;
+    list->elem_kind = kind;
+    list->data = rt_alloc((size_t)elem_size * list->cap);
 
     if (list->data == NULL) {
         rt_panic("Failed to allocate memory for list data");
@@ -19,41 +26,54 @@ List* LIST_METHOD(__init__)(void) {
     return list;
 }
 
-void LIST_METHOD(append)(List* list, int64_t value) {
-    if (list == NULL) {
-        rt_panic("Cannot append to NULL list");
+static int32_t elem_kind_size(ListElemKind kind) {
+    switch (kind) {
+        case LIST_ELEM_INT: return (int32_t)sizeof(int64_t);
+        case LIST_ELEM_FLOAT: return (int32_t)sizeof(double);
+        case LIST_ELEM_BOOL: return (int32_t)sizeof(int8_t);
+        case LIST_ELEM_STR:
+        case LIST_ELEM_OBJECT: return (int32_t)sizeof(void*);
     }
+    return (int32_t)sizeof(int64_t);
+}
 
+// Make room for one more element
+static inline void list_grow(List* list) {
     if (list->len == list->cap) {
+        size_t elem_size = (size_t)list->elem_size;
+        list->data = rt_realloc(list->data, elem_size * list->cap, elem_size * list->cap * 2);
         list->cap *= 2;
-        int64_t* new_data = (int64_t*)realloc(list->data, sizeof(int64_t) * list->cap);
-        if (new_data == NULL) {
-            rt_panic("Failed to reallocate memory for list");
-        }
-        list->data = new_data;
     }
-
-    list->data[list->len++] = value;
 }
 
-int64_t LIST_METHOD(__getitem__)(List* list, int64_t index) {
-    if (list == NULL) {
-        rt_panic("Cannot get from NULL list");
-    }
+static inline void list_check_index(List* list, int64_t index) {
     if (index < 0 || index >= list->len) {
         rt_panic_index("Index out of bounds", index, list->len);
     }
-    return list->data[index];
 }
 
-void LIST_METHOD(__setitem__)(List* list, int64_t index, int64_t value) {
-    if (list == NULL) {
-        rt_panic("Cannot set in NULL list");
-    }
-    if (index < 0 || index >= list->len) {
-        rt_panic_index("Index out of bounds", index, list->len);
+List* rt_list_new(ListElemKind kind) {
+    return list_new(kind, elem_kind_size(kind));
+}
+
+void rt_list_append_slot(List* list, uint64_t slot) {
+    list_grow(list);
+    switch ((ListElemKind)list->elem_kind) {
+        case LIST_ELEM_INT:
+            ((int64_t*)list->data)[list->len] = (int64_t)slot;
+            break;
+        case LIST_ELEM_FLOAT:
+            memcpy((double*)list->data + list->len, &slot, sizeof(double));
+            break;
+        case LIST_ELEM_BOOL:
+            ((int8_t*)list->data)[list->len] = (int8_t)slot;
+            break;
+        case LIST_ELEM_STR:
+        case LIST_ELEM_OBJECT:
+            ((void**)list->data)[list->len] = (void*)(uintptr_t)slot;
+            break;
     }
-    list->data[index] = value;
+    list->len++;
 }
 
 int64_t LIST_METHOD(__len__)(List* list) {
@@ -65,19 +85,182 @@ int64_t LIST_METHOD(__len__)(List* list) {
 
 void LIST_METHOD(free)(List* list) {
     if (list != NULL) {
-        free(list->data);
-        free(list);
+        rt_free(list->data, (size_t)list->elem_size * list->cap);
+        rt_free_object(list, sizeof(List));
+    }
+}
+
+// ============================================================================
+// Typed kernels
+// One set per element storage; SUFFIX is empty for list[int] so those keep the
+// plain LIST_METHOD names.
+// ============================================================================
+
+#define LIST_KERNELS(SUFFIX, T, KIND) \
+    List* __pyc___builtin___list##SUFFIX##___init__(void) { \
+        return list_new(KIND, (int32_t)sizeof(T)); \
+    } \
+    \
+    void __pyc___builtin___list##SUFFIX##_append(List* list, T value) { \
+        if (list == NULL) { \
+            rt_panic("Cannot append to NULL list"); \
+        } \
+        list_grow(list); \
+        ((T*)list->data)[list->len++] = value; \
+    } \
+    \
+    T __pyc___builtin___list##SUFFIX##___getitem__(List* list, int64_t index) { \
+        if (list == NULL) { \
+            rt_panic("Cannot get from NULL list"); \
+        } \
+        list_check_index(list, index); \
+        return ((T*)list->data)[index]; \
+    } \
+    \
+    void __pyc___builtin___list##SUFFIX##___setitem__(List* list, int64_t index, T value) { \
+        if (list == NULL) { \
+            rt_panic("Cannot set in NULL list"); \
+        } \
+        list_check_index(list, index); \
+        ((T*)list->data)[index] = value; \
+    } \
+    \
+    T __pyc___builtin___list_iterator##SUFFIX##___next__(ListIterator* iter) { \
+        if (iter == NULL) { \
+            rt_panic("Cannot iterate with NULL iterator"); \
+        } \
+        if (iter->list == NULL) { \
+            rt_panic("Cannot iterate over NULL list"); \
+        } \
+        if (iter->index >= iter->list->len) { \
+            __pyc_raise(__pyc_stop_iteration()); \
+            return (T)0; \
+        } \
+        return ((T*)iter->list->data)[iter->index++]; \
+    }
+
+LIST_KERNELS(, int64_t, LIST_ELEM_INT)
+LIST_KERNELS(_f64, double, LIST_ELEM_FLOAT)
+LIST_KERNELS(_bool, int8_t, LIST_ELEM_BOOL)
+LIST_KERNELS(_str, String*, LIST_ELEM_STR)
+LIST_KERNELS(_ptr, void*, LIST_ELEM_OBJECT)
+
+// ============================================================================
+// repr / str
+// ============================================================================
+
+void rt_repr_init(ReprBuffer* buf) {
+    buf->cap = 64;
+    buf->len = 0;
+    buf->data = (char*)rt_alloc(buf->cap);
+}
+
+// Make room for `len` more bytes, returning where they go
+static char* repr_reserve(ReprBuffer* buf, size_t len) {
+    if (buf->len + len > buf->cap) {
+        size_t cap = buf->cap * 2;
+        while (buf->len + len > cap) cap *= 2;
+        buf->data = (char*)rt_realloc(buf->data, buf->cap, cap);
+        buf->cap = cap;
+    }
+    return buf->data + buf->len;
+}
+
+void rt_repr_append(ReprBuffer* buf, const char* text, size_t len) {
+    memcpy(repr_reserve(buf, len), text, len);
+    buf->len += len;
+}
+
+void rt_repr_append_slot(ReprBuffer* buf, ListElemKind kind, uint64_t slot) {
+    char text[40];
+    int len;
+    switch (kind) {
+        case LIST_ELEM_INT:
+            buf->len += rt_format_int64((int64_t)slot, repr_reserve(buf, RT_INT64_MAX_CHARS));
+            break;
+        case LIST_ELEM_FLOAT: {
+            double value;
+            memcpy(&value, &slot, sizeof(value));
+            buf->len += rt_format_float(value, repr_reserve(buf, RT_FLOAT_MAX_CHARS));
+            break;
+        }
+        case LIST_ELEM_BOOL:
+            if ((int8_t)slot) {
+                rt_repr_append(buf, "True", 4);
+            } else {
+                rt_repr_append(buf, "False", 5);
+            }
+            break;
+        case LIST_ELEM_STR: {
+            String* repr = STR_METHOD(__repr__)((String*)(uintptr_t)slot);
+            rt_repr_append(buf, repr->data, (size_t)repr->len);
+            STR_METHOD(free)(repr);
+            break;
+        }
+        case LIST_ELEM_OBJECT:
+            len = snprintf(text, sizeof(text), "<object at %p>", (void*)(uintptr_t)slot);
+            rt_repr_append(buf, text, (size_t)len);
+            break;
     }
 }
 
+String* rt_repr_finish(ReprBuffer* buf) {
+    String* result = STR_METHOD(from_literal)(buf->data, (int64_t)buf->len);
+    rt_free(buf->data, buf->cap);
+    return result;
+}
+
+// Element i of the list, widened to an 8-byte slot
+static uint64_t list_slot(List* list, int64_t i) {
+    switch ((ListElemKind)list->elem_kind) {
+        case LIST_ELEM_INT:
+            return (uint64_t)((int64_t*)list->data)[i];
+        case LIST_ELEM_FLOAT: {
+            uint64_t slot;
+            memcpy(&slot, (double*)list->data + i, sizeof(slot));
+            return slot;
+        }
+        case LIST_ELEM_BOOL:
+            return (uint64_t)(uint8_t)((int8_t*)list->data)[i];
+        case LIST_ELEM_STR:
+        case LIST_ELEM_OBJECT:
+            return (uint64_t)(uintptr_t)((void**)list->data)[i];
+    }
+    return 0;
+}
+
+// Shared printer: "[" + elements separated by ", " + "]"
+static String* list_repr_slots(List* list) {
+    if (list == NULL || list->len == 0) {
+        return STR_METHOD(from_literal)("[]", 2);
+    }
+
+    ReprBuffer buf;
+    rt_repr_init(&buf);
+    rt_repr_append(&buf, "[", 1);
+    for (int64_t i = 0; i < list->len; i++) {
+        if (i > 0) {
+            rt_repr_append(&buf, ", ", 2);
+        }
+        rt_repr_append_slot(&buf, (ListElemKind)list->elem_kind, list_slot(list, i));
+    }
+    rt_repr_append(&buf, "]", 1);
+    return rt_repr_finish(&buf);
+}
+
 String* LIST_METHOD(__repr__)(List* list) {
     if (list == NULL || list->len == 0) {
         return STR_METHOD(from_literal)("[]", 2);
     }
 
-    // Max: "[" + 21 chars per int + ", " separators + "]"
-    int64_t max_len = 2 + (21 * list->len) + (2 * (list->len - 1));
-    String* result = (String*)malloc(sizeof(String) + max_len + 1);
+    // Measure first so the result is allocated at its exact size:
+    // "[" + the digits + ", " separators + "]"
+    int64_t* data = (int64_t*)list->data;
+    int64_t total = 2 + 2 * (list->len - 1);
+    for (int64_t i = 0; i < list->len; i++) {
+        total += (int64_t)rt_int64_len(data[i]);
+    }
+    String* result = string_alloc(total);
     if (result == NULL) return NULL;
 
     int64_t pos = 0;
@@ -88,26 +271,60 @@ String* LIST_METHOD(__repr__)(List* list) {
             result->data[pos++] = ',';
             result->data[pos++] = ' ';
         }
-        pos += snprintf(result->data + pos, 22, "%ld", list->data[i]);
+        pos += (int64_t)rt_format_int64(data[i], result->data + pos);
     }
 
     result->data[pos++] = ']';
     result->data[pos] = '\0';
     result->len = pos;
+    result->flags = STR_FLAG_ASCII_ONLY | STR_FLAG_VALID_UTF8;
+    result->cp_count = (int32_t)pos;
 
     return result;
 }
 
+String* __pyc___builtin___list_f64___repr__(List* list) {
+    return list_repr_slots(list);
+}
+
+String* __pyc___builtin___list_bool___repr__(List* list) {
+    return list_repr_slots(list);
+}
+
+String* __pyc___builtin___list_str___repr__(List* list) {
+    return list_repr_slots(list);
+}
+
+String* __pyc___builtin___list_ptr___repr__(List* list) {
+    return list_repr_slots(list);
+}
+
 String* LIST_METHOD(__str__)(List* list) {
     return LIST_METHOD(__repr__)(list);
 }
 
+String* __pyc___builtin___list_f64___str__(List* list) {
+    return __pyc___builtin___list_f64___repr__(list);
+}
+
+String* __pyc___builtin___list_bool___str__(List* list) {
+    return __pyc___builtin___list_bool___repr__(list);
+}
+
+String* __pyc___builtin___list_str___str__(List* list) {
+    return __pyc___builtin___list_str___repr__(list);
+}
+
+String* __pyc___builtin___list_ptr___str__(List* list) {
+    return __pyc___builtin___list_ptr___repr__(list);
+}
+
 // ============================================================================
 // List Iterator
 // ============================================================================
 
 ListIterator* LIST_METHOD(__iter__)(List* list) {
-    ListIterator* iter = (ListIterator*)malloc(sizeof(ListIterator));
+    ListIterator* iter = (ListIterator*)rt_alloc_object(sizeof(ListIterator), RT_KIND_LIST_ITERATOR);
     if (iter == NULL) {
         rt_panic("Failed to allocate memory for list iterator");
     }
@@ -120,22 +337,6 @@ ListIterator* LIST_ITERATOR_METHOD(__iter__)(ListIterator* iter) {
     return iter;
 }
 
-int64_t LIST_ITERATOR_METHOD(__next__)(ListIterator* iter) {
-    if (iter == NULL) {
-        rt_panic("Cannot iterate with NULL iterator");
-    }
-    if (iter->list == NULL) {
-        rt_panic("Cannot iterate over NULL list");
-    }
-
-    if (iter->index >= iter->list->len) {
-        __pyc_raise(__pyc_stop_iteration());
-        return 0;
-    }
-
-    return iter->list->data[iter->index++];
-}
-
 void LIST_ITERATOR_METHOD(__dealloc__)(ListIterator* iter) {
-    free(iter);
+    rt_free_object(iter, sizeof(ListIterator));
 }
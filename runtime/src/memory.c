@@ -0,0 +1,253 @@
+#include "memory.h"
+#include "io.h"
+#include "parallel.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <sys/resource.h>
+
+// ============================================================================
+// Statistics
+// Counted per thread, without atomics, and summed on request. The peak is of
+// the bytes live over all threads: outside parallel loops only the calling
+// thread allocates and updates it plainly, and inside one every thread
+// updates it atomically.
+// ============================================================================
+
+static _Thread_local RtAllocStats stats;
+static RtAllocStats* thread_stats[RT_MAX_THREADS];
+static int thread_stats_len = 0;
+static int64_t process_live_bytes = 0;
+static int64_t process_peak_bytes = 0;
+
+void rt_alloc_register_thread(void) {
+    int slot = __atomic_fetch_add(&thread_stats_len, 1, __ATOMIC_ACQ_REL);
+    if (slot >= RT_MAX_THREADS) {
+        rt_panic("Too many runtime threads");
+    }
+    __atomic_store_n(&thread_stats[slot], &stats, __ATOMIC_RELEASE);
+}
+
+static inline void stats_on_resize(int64_t delta) {
+    stats.live_bytes += delta;
+    if (!rt_parallel_running()) {
+        process_live_bytes += delta;
+        if (process_live_bytes > process_peak_bytes) {
+            process_peak_bytes = process_live_bytes;
+        }
+        return;
+    }
+    int64_t live = __atomic_add_fetch(&process_live_bytes, delta, __ATOMIC_RELAXED);
+    int64_t peak = __atomic_load_n(&process_peak_bytes, __ATOMIC_RELAXED);
+    while (live > peak && !__atomic_compare_exchange_n(&process_peak_bytes, &peak, live, 1,
+                                                       __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+static inline void stats_on_alloc(size_t size) {
+    stats.allocs++;
+    stats_on_resize((int64_t)size);
+}
+
+static inline void stats_on_free(size_t size) {
+    stats.frees++;
+    stats_on_resize(-(int64_t)size);
+}
+
+void rt_alloc_stats(RtAllocStats* out) {
+    memset(out, 0, sizeof(*out));
+    int len = __atomic_load_n(&thread_stats_len, __ATOMIC_ACQUIRE);
+    for (int i = 0; i < len && i < RT_MAX_THREADS; i++) {
+        RtAllocStats* t = __atomic_load_n(&thread_stats[i], __ATOMIC_ACQUIRE);
+        if (t == NULL) continue;
+        out->allocs += t->allocs;
+        out->frees += t->frees;
+        out->pool_reuses += t->pool_reuses;
+        out->arena_chunks += t->arena_chunks;
+        out->live_bytes += t->live_bytes;
+    }
+    out->peak_bytes = __atomic_load_n(&process_peak_bytes, __ATOMIC_RELAXED);
+}
+
+int64_t rt_peak_rss_kb(void) {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+    return (int64_t)usage.ru_maxrss;  // Linux reports KiB
+}
+
+static void print_alloc_stats(void) {
+    RtAllocStats total;
+    rt_alloc_stats(&total);
+    fprintf(stderr,
+            "=== Allocator Stats ===\n"
+            "allocs:       %ld\n"
+            "frees:        %ld\n"
+            "pool reuses:  %ld\n"
+            "arena chunks: %ld\n"
+            "live bytes:   %ld\n"
+            "peak bytes:   %ld\n"
+            "peak rss:     %ld KiB\n",
+            total.allocs, total.frees, total.pool_reuses, total.arena_chunks,
+            total.live_bytes, total.peak_bytes, rt_peak_rss_kb());
+}
+
+__attribute__((constructor))
+static void register_alloc_stats(void) {
+    rt_alloc_register_thread();
+    const char* env = getenv("PYC_ALLOC_STATS");
+    if (env != NULL && env[0] != '\0' && env[0] != '0') {
+        atexit(print_alloc_stats);
+    }
+}
+
+#ifdef PYC_ALLOCATOR_SYSTEM
+
+// ============================================================================
+// System allocator: plain malloc/free
+// ============================================================================
+
+void* rt_alloc(size_t size) {
+    void* ptr = malloc(size);
+    if (ptr == NULL) {
+        rt_panic("Out of memory");
+    }
+    stats_on_alloc(size);
+    return ptr;
+}
+
+void* rt_realloc(void* ptr, size_t old_size, size_t new_size) {
+    void* new_ptr = realloc(ptr, new_size);
+    if (new_ptr == NULL) {
+        rt_panic("Out of memory");
+    }
+    stats_on_resize((int64_t)new_size - (int64_t)old_size);
+    return new_ptr;
+}
+
+void rt_free(void* ptr, size_t size) {
+    if (ptr == NULL) return;
+    stats_on_free(size);
+    free(ptr);
+}
+
+#else
+
+// ============================================================================
+// Size-class pools backed by a bump arena
+// ============================================================================
+
+typedef struct FreeBlock {
+    struct FreeBlock* next;
+} FreeBlock;
+
+// Every thread has its own pools, so allocation never takes a lock. A block
+// freed on another thread than the one that allocated it joins the freeing
+// thread's pool.
+static _Thread_local FreeBlock* free_lists[RT_NUM_SIZE_CLASSES];
+static _Thread_local char* arena_ptr;
+static _Thread_local char* arena_end;
+
+static inline size_t size_class_index(size_t size) {
+    if (size == 0) size = 1;
+    return (size + RT_SIZE_CLASS_GRANULE - 1) / RT_SIZE_CLASS_GRANULE - 1;
+}
+
+static inline size_t size_class_bytes(size_t index) {
+    return (index + 1) * RT_SIZE_CLASS_GRANULE;
+}
+
+// Carve a block from the current arena chunk, starting a new chunk when full.
+// The tail of an exhausted chunk is abandoned; it is always smaller than the
+// largest size class.
+static void* arena_bump(size_t bytes) {
+    if ((size_t)(arena_end - arena_ptr) < bytes) {
+        char* chunk = (char*)malloc(RT_ARENA_CHUNK_SIZE);
+        if (chunk == NULL) {
+            rt_panic("Out of memory");
+        }
+        stats.arena_chunks++;
+        arena_ptr = chunk;
+        arena_end = chunk + RT_ARENA_CHUNK_SIZE;
+    }
+    void* block = arena_ptr;
+    arena_ptr += bytes;
+    return block;
+}
+
+void* rt_alloc(size_t size) {
+    if (size > RT_SMALL_MAX) {
+        void* ptr = malloc(size);
+        if (ptr == NULL) {
+            rt_panic("Out of memory");
+        }
+        stats_on_alloc(size);
+        return ptr;
+    }
+
+    size_t index = size_class_index(size);
+    size_t bytes = size_class_bytes(index);
+    stats_on_alloc(bytes);
+
+    FreeBlock* block = free_lists[index];
+    if (block != NULL) {
+        free_lists[index] = block->next;
+        stats.pool_reuses++;
+        return block;
+    }
+    return arena_bump(bytes);
+}
+
+void* rt_realloc(void* ptr, size_t old_size, size_t new_size) {
+    if (ptr == NULL) {
+        return rt_alloc(new_size);
+    }
+
+    // Both large: let malloc grow in place when it can
+    if (old_size > RT_SMALL_MAX && new_size > RT_SMALL_MAX) {
+        void* new_ptr = realloc(ptr, new_size);
+        if (new_ptr == NULL) {
+            rt_panic("Out of memory");
+        }
+        stats_on_resize((int64_t)new_size - (int64_t)old_size);
+        return new_ptr;
+    }
+
+    // Same small size class: the block already fits
+    if (old_size <= RT_SMALL_MAX && new_size <= RT_SMALL_MAX &&
+        size_class_index(old_size) == size_class_index(new_size)) {
+        return ptr;
+    }
+
+    void* new_ptr = rt_alloc(new_size);
+    memcpy(new_ptr, ptr, old_size < new_size ? old_size : new_size);
+    rt_free(ptr, old_size);
+    return new_ptr;
+}
+
+void rt_free(void* ptr, size_t size) {
+    if (ptr == NULL) return;
+
+    if (size > RT_SMALL_MAX) {
+        stats_on_free(size);
+        free(ptr);
+        return;
+    }
+
+    // A block is filed under the class of the size it is freed with, which is
+    // never larger than the class it was allocated from
+    size_t index = size_class_index(size);
+    stats_on_free(size_class_bytes(index));
+    FreeBlock* block = (FreeBlock*)ptr;
+    block->next = free_lists[index];
+    free_lists[index] = block;
+}
+
+#endif // PYC_ALLOCATOR_SYSTEM
+
+void* rt_alloc_zeroed(size_t size) {
+    void* ptr = rt_alloc(size);
+    memset(ptr, 0, size);
+    return ptr;
+}
@@ -0,0 +1,68 @@
+#ifndef MEMORY_H
+#define MEMORY_H
+
+// ============================================================================
+// Runtime allocator
+// Every runtime object (List, String, Range, ListIterator, Exception, class
+// instances) is allocated through this layer.
+//
+// Default: requests up to RT_SMALL_MAX bytes are rounded up to a 16-byte size
+// class and served from a per-class free list; empty free lists are refilled
+// by bumping through 64 KiB arena chunks. Larger requests go to malloc. The
+// free lists and arena are per thread, so parallel loop workers allocate
+// without locking.
+//
+// Build with PYC_ALLOCATOR_SYSTEM defined to route everything straight to
+// malloc/free (useful for comparing against the system allocator or running
+// under external leak checkers).
+// ============================================================================
+
+#include "types.h"
+
+#define RT_SIZE_CLASS_GRANULE 16
+#define RT_SMALL_MAX          256
+#define RT_NUM_SIZE_CLASSES   (RT_SMALL_MAX / RT_SIZE_CLASS_GRANULE)
+#define RT_ARENA_CHUNK_SIZE   (64 * 1024)
+
+// Allocate size bytes (panics on out-of-memory, never returns NULL)
+void* rt_alloc(size_t size);
+
+// Allocate size zeroed bytes
+void* rt_alloc_zeroed(size_t size);
+
+// Grow or shrink an allocation of old_size bytes to new_size bytes
+void* rt_realloc(void* ptr, size_t old_size, size_t new_size);
+
+// Release an allocation. size may be smaller than the requested size (e.g. a
+// String whose buffer was over-allocated) but must never exceed it. NULL is ignored.
+void rt_free(void* ptr, size_t size);
+
+// ============================================================================
+// Statistics
+// Set PYC_ALLOC_STATS=1 in the environment of a compiled program to print
+// these, together with the process peak RSS, to stderr at exit.
+// ============================================================================
+
+typedef struct {
+    int64_t allocs;       // Total rt_alloc calls
+    int64_t frees;        // Total rt_free calls on non-NULL pointers
+    int64_t pool_reuses;  // Small allocations served from a free list
+    int64_t arena_chunks; // Arena chunks obtained from malloc
+    int64_t live_bytes;   // Bytes currently allocated (by size class)
+    int64_t peak_bytes;   // High-water mark of live_bytes over all threads at once
+} RtAllocStats;
+
+// Totals over every thread that has allocated
+void rt_alloc_stats(RtAllocStats* out);
+
+// Count the calling thread's allocations in rt_alloc_stats; every runtime
+// thread calls this once before allocating
+void rt_alloc_register_thread(void);
+
+// Peak resident set size of the process in KiB (0 if unavailable)
+int64_t rt_peak_rss_kb(void);
+
+// Runtime objects and the optional collector
+#include "gc.h"
+
+#endif // MEMORY_H
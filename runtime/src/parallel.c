@@ -0,0 +1,297 @@
+#include "parallel.h"
+#include "runtime.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+// Ranges a deque can hold: one per halving of the longest splittable range,
+// plus the initial piece
+#define DEQUE_CAP 66
+
+// Chunks per worker the range is split into at most; more give stealing room
+// to balance uneven iterations, fewer amortize the per-chunk overhead
+#define CHUNKS_PER_WORKER 8
+
+int rt_parallel_active = 0;
+
+typedef struct {
+    int64_t lo;
+    int64_t hi;
+} Span;
+
+// Owner pushes and pops at bottom, thieves take from top
+typedef struct {
+    pthread_mutex_t lock;
+    int top;
+    int bottom;
+    Span ranges[DEQUE_CAP];
+} Deque;
+
+typedef struct {
+    RtParallelBody body;
+    void* env;
+    int64_t grain;
+    ExceptionFrame* frame;  // Handler of the thread that started the loop
+    int64_t remaining;      // Iterations not yet run or skipped
+    int cancelled;          // Set once a chunk raised
+    Exception* exception;   // The first exception raised
+    pthread_mutex_t exception_lock;
+} Job;
+
+static int num_workers = 0;  // Including the calling thread; 0 until started
+static Deque* deques = NULL;
+
+// Job hand-off: a new generation wakes the workers, busy_workers tells the
+// calling thread when they have all let go of the job
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t job_ready = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t job_done = PTHREAD_COND_INITIALIZER;
+static Job* current_job = NULL;
+static uint64_t generation = 0;
+static int busy_workers = 0;
+
+// Set on a thread while it runs chunks, so nested loops run inline
+static _Thread_local int in_parallel = 0;
+
+// The job whose chunks the thread is running, for __pyc_parallel_poll
+static _Thread_local Job* running_job = NULL;
+
+// ============================================================================
+// Deques
+// ============================================================================
+
+static int deque_push(Deque* d, Span r) {
+    pthread_mutex_lock(&d->lock);
+    int pushed = d->bottom < DEQUE_CAP;
+    if (pushed) {
+        d->ranges[d->bottom++] = r;
+    }
+    pthread_mutex_unlock(&d->lock);
+    return pushed;
+}
+
+static int deque_pop(Deque* d, Span* out) {
+    pthread_mutex_lock(&d->lock);
+    int popped = d->bottom > d->top;
+    if (popped) {
+        *out = d->ranges[--d->bottom];
+        if (d->bottom == d->top) {
+            d->top = d->bottom = 0;
+        }
+    }
+    pthread_mutex_unlock(&d->lock);
+    return popped;
+}
+
+static int deque_steal(Deque* d, Span* out) {
+    pthread_mutex_lock(&d->lock);
+    int stolen = d->bottom > d->top;
+    if (stolen) {
+        *out = d->ranges[d->top++];
+        if (d->bottom == d->top) {
+            d->top = d->bottom = 0;
+        }
+    }
+    pthread_mutex_unlock(&d->lock);
+    return stolen;
+}
+
+// ============================================================================
+// Workers
+// ============================================================================
+
+static int steal(int self, Span* out) {
+    for (int i = 1; i < num_workers; i++) {
+        if (deque_steal(&deques[(self + i) % num_workers], out)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void run_chunk(Job* job, int64_t lo, int64_t hi) {
+    if (!__atomic_load_n(&job->cancelled, __ATOMIC_RELAXED)) {
+        job->body(job->env, lo, hi);
+        if (__pyc_has_exception()) {
+            pthread_mutex_lock(&job->exception_lock);
+            if (job->exception == NULL) {
+                job->exception = __pyc_get_exception();
+            }
+            pthread_mutex_unlock(&job->exception_lock);
+            __pyc_clear_exception();
+            __atomic_store_n(&job->cancelled, 1, __ATOMIC_RELAXED);
+        }
+    }
+    __atomic_fetch_sub(&job->remaining, hi - lo, __ATOMIC_ACQ_REL);
+}
+
+static void run_job(Job* job, int self) {
+    ExceptionFrame* saved_frame = __pyc_get_exception_frame();
+    rt_exception_set_frame(job->frame);
+    in_parallel = 1;
+    running_job = job;
+
+    Deque* own = &deques[self];
+    Span r;
+    while (__atomic_load_n(&job->remaining, __ATOMIC_ACQUIRE) > 0) {
+        if (!deque_pop(own, &r) && !steal(self, &r)) {
+            // Every range left is running on another worker
+            sched_yield();
+            continue;
+        }
+        // Once cancelled, ranges are taken off the deques whole and skipped
+        if (__atomic_load_n(&job->cancelled, __ATOMIC_RELAXED)) {
+            __atomic_fetch_sub(&job->remaining, r.hi - r.lo, __ATOMIC_ACQ_REL);
+            continue;
+        }
+        // Leave the upper halves for this worker's later pops and for thieves
+        while (r.hi - r.lo > job->grain) {
+            int64_t mid = r.lo + (r.hi - r.lo) / 2;
+            if (!deque_push(own, (Span){mid, r.hi})) break;
+            r.hi = mid;
+        }
+        run_chunk(job, r.lo, r.hi);
+    }
+
+    running_job = NULL;
+    in_parallel = 0;
+    rt_exception_set_frame(saved_frame);
+}
+
+static void* worker_main(void* arg) {
+    int self = (int)(intptr_t)arg;
+    rt_alloc_register_thread();
+
+    uint64_t seen = 0;
+    for (;;) {
+        pthread_mutex_lock(&pool_lock);
+        while (generation == seen) {
+            pthread_cond_wait(&job_ready, &pool_lock);
+        }
+        seen = generation;
+        Job* job = current_job;
+        pthread_mutex_unlock(&pool_lock);
+
+        run_job(job, self);
+
+        pthread_mutex_lock(&pool_lock);
+        if (--busy_workers == 0) {
+            pthread_cond_signal(&job_done);
+        }
+        pthread_mutex_unlock(&pool_lock);
+    }
+    return NULL;
+}
+
+static int pool_size(void) {
+    const char* env = getenv("PYC_THREADS");
+    long n = 0;
+    if (env != NULL && env[0] != '\0') {
+        n = strtol(env, NULL, 10);
+    }
+    if (n <= 0) {
+        n = sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    if (n <= 0) n = 1;
+    if (n > RT_MAX_THREADS) n = RT_MAX_THREADS;
+    return (int)n;
+}
+
+// Start the workers; returns the number of threads, the caller included
+static int start_pool(void) {
+    if (num_workers > 0) return num_workers;
+
+    int n = pool_size();
+    deques = (Deque*)calloc((size_t)n, sizeof(Deque));
+    if (deques == NULL) {
+        rt_panic("Out of memory");
+    }
+    for (int i = 0; i < n; i++) {
+        pthread_mutex_init(&deques[i].lock, NULL);
+    }
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    // musl's default thread stack is small; loop bodies may recurse deeply
+    pthread_attr_setstacksize(&attr, 8 * 1024 * 1024);
+    int started = 1;
+    for (int i = 1; i < n; i++) {
+        pthread_t thread;
+        if (pthread_create(&thread, &attr, worker_main, (void*)(intptr_t)i) != 0) {
+            break;
+        }
+        pthread_detach(thread);
+        started++;
+    }
+    pthread_attr_destroy(&attr);
+
+    num_workers = started;
+    return num_workers;
+}
+
+// ============================================================================
+// Entry point
+// ============================================================================
+
+int __pyc_parallel_poll(void) {
+    if (__pyc_has_exception()) return 1;
+    return running_job != NULL && __atomic_load_n(&running_job->cancelled, __ATOMIC_RELAXED);
+}
+
+void __pyc_parallel_for(int64_t start, int64_t stop, RtParallelBody body, void* env) {
+    if (stop <= start) return;
+    int64_t n = stop - start;
+
+    if (in_parallel || n == 1 || start_pool() == 1) {
+        body(env, start, stop);
+        return;
+    }
+
+    Job job = {
+        .body = body,
+        .env = env,
+        .grain = n / ((int64_t)num_workers * CHUNKS_PER_WORKER),
+        .frame = __pyc_get_exception_frame(),
+        .remaining = n,
+        .cancelled = 0,
+        .exception = NULL,
+    };
+    if (job.grain < 1) job.grain = 1;
+    pthread_mutex_init(&job.exception_lock, NULL);
+
+    // One contiguous piece per worker to start with
+    int pieces = n < num_workers ? (int)n : num_workers;
+    int64_t base = n / pieces;
+    int64_t extra = n % pieces;
+    int64_t lo = start;
+    for (int i = 0; i < pieces; i++) {
+        int64_t hi = lo + base + (i < extra ? 1 : 0);
+        deque_push(&deques[i], (Span){lo, hi});
+        lo = hi;
+    }
+
+    __atomic_store_n(&rt_parallel_active, 1, __ATOMIC_RELEASE);
+    pthread_mutex_lock(&pool_lock);
+    current_job = &job;
+    busy_workers = num_workers - 1;
+    generation++;
+    pthread_cond_broadcast(&job_ready);
+    pthread_mutex_unlock(&pool_lock);
+
+    run_job(&job, 0);
+
+    // The job lives on this stack: wait until no worker can still touch it
+    pthread_mutex_lock(&pool_lock);
+    while (busy_workers > 0) {
+        pthread_cond_wait(&job_done, &pool_lock);
+    }
+    current_job = NULL;
+    pthread_mutex_unlock(&pool_lock);
+    __atomic_store_n(&rt_parallel_active, 0, __ATOMIC_RELEASE);
+
+    pthread_mutex_destroy(&job.exception_lock);
+    if (job.exception != NULL) {
+        __pyc_raise(job.exception);
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+// ============================================================================
+// Parallel loops
+//
+// `for i in prange(start, stop)` runs its iterations on a pool of worker
+// threads. The compiler outlines the loop body into a function that runs the
+// iterations [lo, hi) of one chunk, and __pyc_parallel_for returns once every
+// iteration has run.
+//
+// Scheduling is work stealing with lazy binary splitting: the range starts
+// cut into one piece per worker, each on that worker's deque. A worker pops
+// the newest range off its own deque, pushes back the upper half while the
+// range is longer than the grain, and runs what is left. A worker whose deque
+// is empty steals the oldest range from another worker's deque, so the big
+// pieces move and the small ones stay local.
+//
+// The calling thread takes part as worker 0. A prange inside the body of
+// another runs sequentially on the thread that reaches it.
+//
+// The first exception a chunk leaves pending stops the loop: the chunk that
+// raised returns at once, running chunks return at their next poll, chunks
+// that have not started are skipped, and once the workers are idle the
+// exception is pending on the calling thread, as if the loop had raised it.
+//
+// The pool has PYC_THREADS worker threads (default: one per online CPU, at
+// most RT_MAX_THREADS) and is started on first use.
+// ============================================================================
+
+#include "types.h"
+
+#define RT_MAX_THREADS 256
+
+// Runs iterations [lo, hi) of an outlined loop body
+typedef void (*RtParallelBody)(void* env, int64_t lo, int64_t hi);
+
+// Run body over [start, stop) on the worker pool
+void __pyc_parallel_for(int64_t start, int64_t stop, RtParallelBody body, void* env);
+
+// Whether a chunk should stop: an exception is pending on this thread, or
+// another chunk of the loop it belongs to has raised
+int __pyc_parallel_poll(void);
+
+// Nonzero while a parallel loop runs. The collector and stdout only take
+// their locks then.
+extern int rt_parallel_active;
+
+static inline int rt_parallel_running(void) {
+    return __atomic_load_n(&rt_parallel_active, __ATOMIC_ACQUIRE);
+}
+
+#endif // PARALLEL_H
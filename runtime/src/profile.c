@@ -0,0 +1,425 @@
+#include "profile.h"
+#include "runtime.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+int rt_profile_enabled = 0;
+
+static const char* const* site_names = NULL;
+static int64_t site_count = 0;
+
+// ============================================================================
+// Ticks
+// ============================================================================
+
+#if defined(__x86_64__)
+#define TICKS_UNIT "tsc cycles"
+static inline uint64_t ticks_now(void) {
+    return __builtin_ia32_rdtsc();
+}
+#else
+// rdcycle is not readable from user mode on recent RISC-V kernels
+#define TICKS_UNIT "ns"
+static inline uint64_t ticks_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+#endif
+
+// ============================================================================
+// Calling-context tree
+// ============================================================================
+
+typedef struct ProfileRaise {
+    String* type_name;
+    uint64_t count;
+    struct ProfileRaise* next;
+} ProfileRaise;
+
+typedef struct ProfileNode {
+    int32_t site;  // -1 for the root
+    struct ProfileNode* parent;
+    struct ProfileNode* children;
+    struct ProfileNode* next_sibling;
+    uint64_t calls;
+    uint64_t ticks;  // Inclusive of the children
+    uint64_t allocs[RT_NUM_OBJECT_KINDS];
+    uint64_t alloc_bytes[RT_NUM_OBJECT_KINDS];
+    ProfileRaise* raises;
+} ProfileNode;
+
+typedef struct {
+    ProfileNode* node;
+    uint64_t start;
+} ProfileFrame;
+
+// Each thread builds its own tree, without locking; the trees are only read
+// at exit
+typedef struct ProfileThread {
+    ProfileNode root;
+    ProfileFrame frames[RT_PROFILE_MAX_DEPTH];
+    int64_t depth;  // May exceed RT_PROFILE_MAX_DEPTH
+    struct ProfileThread* next;
+} ProfileThread;
+
+static _Thread_local ProfileThread* current_thread = NULL;
+static ProfileThread* threads = NULL;
+static pthread_mutex_t threads_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void* profile_calloc(size_t size) {
+    // Plain calloc: the profile's own memory is not a program allocation
+    void* ptr = calloc(1, size);
+    if (ptr == NULL) {
+        rt_panic("Out of memory");
+    }
+    return ptr;
+}
+
+static ProfileThread* profile_thread(void) {
+    ProfileThread* t = current_thread;
+    if (t == NULL) {
+        t = (ProfileThread*)profile_calloc(sizeof(ProfileThread));
+        t->root.site = -1;
+        pthread_mutex_lock(&threads_lock);
+        t->next = threads;
+        threads = t;
+        pthread_mutex_unlock(&threads_lock);
+        current_thread = t;
+    }
+    return t;
+}
+
+static inline ProfileNode* top_node(ProfileThread* t) {
+    if (t->depth == 0) return &t->root;
+    int64_t top = t->depth < RT_PROFILE_MAX_DEPTH ? t->depth : RT_PROFILE_MAX_DEPTH;
+    return t->frames[top - 1].node;
+}
+
+static ProfileNode* child_node(ProfileNode* parent, int32_t site) {
+    ProfileNode** link = &parent->children;
+    for (ProfileNode* child = *link; child != NULL; child = *link) {
+        if (child->site == site) {
+            // Keep the most recently entered child first
+            *link = child->next_sibling;
+            child->next_sibling = parent->children;
+            parent->children = child;
+            return child;
+        }
+        link = &child->next_sibling;
+    }
+    ProfileNode* child = (ProfileNode*)profile_calloc(sizeof(ProfileNode));
+    child->site = site;
+    child->parent = parent;
+    child->next_sibling = parent->children;
+    parent->children = child;
+    return child;
+}
+
+int64_t __pyc_profile_enter(int32_t site) {
+    ProfileThread* t = profile_thread();
+    int64_t depth = t->depth;
+    if (depth < RT_PROFILE_MAX_DEPTH) {
+        ProfileNode* node = child_node(top_node(t), site);
+        node->calls++;
+        t->frames[depth].node = node;
+        t->frames[depth].start = ticks_now();
+    }
+    t->depth = depth + 1;
+    return depth;
+}
+
+void __pyc_profile_leave(int64_t depth) {
+    ProfileThread* t = profile_thread();
+    uint64_t now = ticks_now();
+    while (t->depth > depth) {
+        t->depth--;
+        if (t->depth < RT_PROFILE_MAX_DEPTH) {
+            ProfileFrame* frame = &t->frames[t->depth];
+            frame->node->ticks += now - frame->start;
+        }
+    }
+}
+
+void rt_profile_alloc(RtObjectKind kind, size_t size) {
+    ProfileNode* node = top_node(profile_thread());
+    node->allocs[kind]++;
+    node->alloc_bytes[kind] += size;
+}
+
+void rt_profile_raise(Exception* exc) {
+    ProfileNode* node = top_node(profile_thread());
+    String* type_name = exc ? exc->type_name : NULL;
+    ProfileRaise* raise = node->raises;
+    while (raise != NULL && raise->type_name != type_name) {
+        raise = raise->next;
+    }
+    if (raise == NULL) {
+        raise = (ProfileRaise*)profile_calloc(sizeof(ProfileRaise));
+        raise->type_name = type_name;
+        raise->next = node->raises;
+        node->raises = raise;
+    }
+    raise->count++;
+}
+
+// ============================================================================
+// Report
+// ============================================================================
+
+static const char* const kind_names[RT_NUM_OBJECT_KINDS] = {
+    [RT_KIND_STRING] = "String",
+    [RT_KIND_LIST] = "List",
+    [RT_KIND_LIST_ITERATOR] = "ListIterator",
+    [RT_KIND_RANGE] = "Range",
+    [RT_KIND_EXCEPTION] = "Exception",
+    [RT_KIND_BYTES] = "Bytes",
+    [RT_KIND_BYTEARRAY] = "ByteArray",
+    [RT_KIND_HASH_TABLE] = "HashTable",
+    [RT_KIND_HASH_ITERATOR] = "HashTableIterator",
+    [RT_KIND_STR_BUILDER] = "StrBuilder",
+    [RT_KIND_FILE] = "File",
+    [RT_KIND_INSTANCE] = "class_new",
+};
+
+// Sites are indexed by site id; index site_count collects what happens
+// outside every site (e.g. allocations in module constructors)
+typedef struct {
+    uint64_t calls;
+    uint64_t self_ticks;
+    uint64_t total_ticks;  // Outermost activations only, so recursion counts once
+    uint64_t allocs[RT_NUM_OBJECT_KINDS];
+    uint64_t alloc_bytes[RT_NUM_OBJECT_KINDS];
+    ProfileRaise* raises;  // Merged by exception name
+} SiteTotals;
+
+typedef struct {
+    SiteTotals* sites;
+    int64_t* active;  // Per site: activations on the current path
+    FILE* folded;
+    FILE* alloc_folded;
+    char* path;
+    size_t path_len;
+    size_t path_cap;
+    uint64_t total_ticks;
+} Report;
+
+static int64_t site_index(const ProfileNode* node) {
+    return node->site >= 0 && node->site < site_count ? node->site : site_count;
+}
+
+static const char* site_name(int64_t site) {
+    return site < site_count ? site_names[site] : "<runtime>";
+}
+
+static uint64_t self_ticks(const ProfileNode* node) {
+    uint64_t children = 0;
+    for (ProfileNode* child = node->children; child != NULL; child = child->next_sibling) {
+        children += child->ticks;
+    }
+    return node->ticks > children ? node->ticks - children : 0;
+}
+
+static int same_name(const String* a, const String* b) {
+    if (a == b) return 1;
+    if (a == NULL || b == NULL) return 0;
+    return a->len == b->len && memcmp(a->data, b->data, (size_t)a->len) == 0;
+}
+
+static void merge_raises(SiteTotals* site, const ProfileRaise* raises) {
+    for (const ProfileRaise* raise = raises; raise != NULL; raise = raise->next) {
+        ProfileRaise* merged = site->raises;
+        while (merged != NULL && !same_name(merged->type_name, raise->type_name)) {
+            merged = merged->next;
+        }
+        if (merged == NULL) {
+            merged = (ProfileRaise*)profile_calloc(sizeof(ProfileRaise));
+            merged->type_name = raise->type_name;
+            merged->next = site->raises;
+            site->raises = merged;
+        }
+        merged->count += raise->count;
+    }
+}
+
+static void path_push(Report* r, const char* name) {
+    size_t len = strlen(name);
+    if (r->path_len + len + 2 > r->path_cap) {
+        r->path_cap = (r->path_len + len + 2) * 2;
+        r->path = (char*)realloc(r->path, r->path_cap);
+        if (r->path == NULL) rt_panic("Out of memory");
+    }
+    if (r->path_len > 0) r->path[r->path_len++] = ';';
+    memcpy(r->path + r->path_len, name, len);
+    r->path_len += len;
+    r->path[r->path_len] = '\0';
+}
+
+// Add a node's subtree to the site totals and write its stacks
+static void collect_node(Report* r, const ProfileNode* node) {
+    size_t saved_len = r->path_len;
+    int64_t index = site_index(node);
+    SiteTotals* s = &r->sites[index];
+    uint64_t self = self_ticks(node);
+    s->calls += node->calls;
+    s->self_ticks += self;
+    if (r->active[index] == 0) {
+        s->total_ticks += node->ticks;
+    }
+    r->active[index]++;
+    r->total_ticks += self;
+    if (node->site >= 0) {
+        path_push(r, site_name(index));
+    }
+
+    uint64_t allocs = 0;
+    for (int k = 0; k < RT_NUM_OBJECT_KINDS; k++) {
+        allocs += node->allocs[k];
+        s->allocs[k] += node->allocs[k];
+        s->alloc_bytes[k] += node->alloc_bytes[k];
+    }
+    merge_raises(s, node->raises);
+
+    const char* path = r->path_len > 0 ? r->path : "<runtime>";
+    if (self > 0 && r->folded) {
+        fprintf(r->folded, "%s %llu\n", path, (unsigned long long)self);
+    }
+    if (allocs > 0 && r->alloc_folded) {
+        fprintf(r->alloc_folded, "%s %llu\n", path, (unsigned long long)allocs);
+    }
+
+    for (ProfileNode* child = node->children; child != NULL; child = child->next_sibling) {
+        collect_node(r, child);
+    }
+    r->active[index]--;
+    r->path_len = saved_len;
+    if (r->path) r->path[saved_len] = '\0';
+}
+
+static const SiteTotals* sort_sites;
+
+static int by_self_ticks(const void* a, const void* b) {
+    const SiteTotals* x = &sort_sites[*(const int64_t*)a];
+    const SiteTotals* y = &sort_sites[*(const int64_t*)b];
+    if (x->self_ticks != y->self_ticks) return x->self_ticks < y->self_ticks ? 1 : -1;
+    if (x->calls != y->calls) return x->calls < y->calls ? 1 : -1;
+    return *(const int64_t*)a < *(const int64_t*)b ? -1 : 1;
+}
+
+static FILE* open_output(const char* prefix, const char* suffix) {
+    size_t len = strlen(prefix) + strlen(suffix) + 1;
+    char* path = (char*)malloc(len);
+    if (path == NULL) return NULL;
+    snprintf(path, len, "%s%s", prefix, suffix);
+    FILE* file = fopen(path, "w");
+    if (file == NULL) {
+        fprintf(stderr, "profile: cannot write %s\n", path);
+    }
+    free(path);
+    return file;
+}
+
+static void write_profile(void) {
+    // Close the sites still open on this thread (e.g. on exit from a raise)
+    if (current_thread != NULL) {
+        __pyc_profile_leave(0);
+    }
+
+    const char* prefix = getenv("PYC_PROFILE");
+    if (prefix == NULL || prefix[0] == '\0') prefix = "pyc-profile";
+    FILE* flat = open_output(prefix, ".txt");
+    if (flat == NULL) return;
+
+    Report r = {0};
+    r.sites = (SiteTotals*)profile_calloc(sizeof(SiteTotals) * (size_t)(site_count + 1));
+    r.active = (int64_t*)profile_calloc(sizeof(int64_t) * (size_t)(site_count + 1));
+    r.folded = open_output(prefix, ".folded");
+    r.alloc_folded = open_output(prefix, ".alloc.folded");
+
+    pthread_mutex_lock(&threads_lock);
+    for (ProfileThread* t = threads; t != NULL; t = t->next) {
+        collect_node(&r, &t->root);
+    }
+
+    pthread_mutex_unlock(&threads_lock);
+
+    // Sites by self ticks, then the pseudo-site of code outside every site
+    int64_t* order = (int64_t*)profile_calloc(sizeof(int64_t) * (size_t)(site_count + 1));
+    for (int64_t i = 0; i <= site_count; i++) order[i] = i;
+    sort_sites = r.sites;
+    qsort(order, (size_t)site_count, sizeof(int64_t), by_self_ticks);
+
+    fprintf(flat, "# pyc profile\n# ticks: %s\n", TICKS_UNIT);
+    fprintf(flat, "# %10s  %14s  %14s  %6s  %s\n", "calls", "self ticks", "total ticks", "self%",
+            "site");
+    for (int64_t i = 0; i < site_count; i++) {
+        const SiteTotals* s = &r.sites[order[i]];
+        double share = r.total_ticks ? 100.0 * (double)s->self_ticks / (double)r.total_ticks : 0.0;
+        fprintf(flat, "%12llu  %14llu  %14llu  %6.2f  %s\n", (unsigned long long)s->calls,
+                (unsigned long long)s->self_ticks, (unsigned long long)s->total_ticks, share,
+                site_name(order[i]));
+    }
+
+    fprintf(flat, "\n# allocations by type\n# %10s  %14s  %s\n", "count", "bytes", "type");
+    for (int k = 0; k < RT_NUM_OBJECT_KINDS; k++) {
+        uint64_t count = 0, bytes = 0;
+        for (int64_t i = 0; i <= site_count; i++) {
+            count += r.sites[i].allocs[k];
+            bytes += r.sites[i].alloc_bytes[k];
+        }
+        if (count > 0) {
+            fprintf(flat, "%12llu  %14llu  %s\n", (unsigned long long)count,
+                    (unsigned long long)bytes, kind_names[k]);
+        }
+    }
+
+    fprintf(flat, "\n# allocations by site\n# %10s  %14s  %-17s  %s\n", "count", "bytes", "type",
+            "site");
+    for (int64_t i = 0; i <= site_count; i++) {
+        const SiteTotals* s = &r.sites[order[i]];
+        for (int k = 0; k < RT_NUM_OBJECT_KINDS; k++) {
+            if (s->allocs[k] > 0) {
+                fprintf(flat, "%12llu  %14llu  %-17s  %s\n", (unsigned long long)s->allocs[k],
+                        (unsigned long long)s->alloc_bytes[k], kind_names[k],
+                        site_name(order[i]));
+            }
+        }
+    }
+
+    fprintf(flat, "\n# raised exceptions by site\n# %10s  %s  %s\n", "count", "exception", "site");
+    for (int64_t i = 0; i <= site_count; i++) {
+        for (ProfileRaise* raise = r.sites[order[i]].raises; raise != NULL; raise = raise->next) {
+            int len = raise->type_name ? (int)raise->type_name->len : 1;
+            const char* name = raise->type_name ? raise->type_name->data : "?";
+            fprintf(flat, "%12llu  %.*s  %s\n", (unsigned long long)raise->count, len, name,
+                    site_name(order[i]));
+        }
+    }
+
+    fclose(flat);
+    if (r.folded) fclose(r.folded);
+    if (r.alloc_folded) fclose(r.alloc_folded);
+    for (int64_t i = 0; i <= site_count; i++) {
+        for (ProfileRaise* raise = r.sites[i].raises; raise != NULL;) {
+            ProfileRaise* next = raise->next;
+            free(raise);
+            raise = next;
+        }
+    }
+    free(order);
+    free(r.sites);
+    free(r.active);
+    free(r.path);
+}
+
+void __pyc_profile_init(const char* const* sites, int64_t count) {
+    if (rt_profile_enabled) return;
+    site_names = sites;
+    site_count = count;
+    profile_thread();
+    rt_profile_enabled = 1;
+    atexit(write_profile);
+}
@@ -0,0 +1,56 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+// ============================================================================
+// Profiling (pycc --profile)
+//
+// The compiler numbers every function, module body and loop of the program
+// as a profile site. A profiled program calls __pyc_profile_enter on entry to
+// each site and __pyc_profile_leave when it leaves, and the runtime keeps a
+// per-thread calling-context tree: one node per distinct stack of sites, with
+// its entry count and the ticks spent in it (TSC cycles on x86_64,
+// nanoseconds elsewhere). Object allocations (by RtObjectKind) and raised
+// exceptions are charged to the node on top of the stack.
+//
+// At exit the tree is written to three files named after PYC_PROFILE
+// (default "pyc-profile"):
+//   <prefix>.txt           flat profile: calls, self and total ticks per site,
+//                          then allocations by kind and by site, then raised
+//                          exceptions by site
+//   <prefix>.folded        collapsed stacks weighted by self ticks, one line
+//                          per stack (`a;b;c 1234`), for flamegraph tools
+//   <prefix>.alloc.folded  the same stacks weighted by objects allocated
+// The flat profile can be passed back to `pycc --profile-use` (see the
+// compiler's codegen/profile.rs).
+// ============================================================================
+
+#include "types.h"
+#include "gc.h"
+#include "exception.h"
+
+// Deepest site stack recorded per thread; deeper sites are counted against
+// the deepest recorded one
+#define RT_PROFILE_MAX_DEPTH 4096
+
+// Nonzero once the program has called __pyc_profile_init
+extern int rt_profile_enabled;
+
+// Start profiling: sites[i] is the name of site i. Registers the report with
+// atexit.
+void __pyc_profile_init(const char* const* sites, int64_t count);
+
+// Enter a site; returns the depth of the site stack before entering, for
+// __pyc_profile_leave
+int64_t __pyc_profile_enter(int32_t site);
+
+// Leave every site entered at or above depth (a return leaves the loops of
+// its function along with the function)
+void __pyc_profile_leave(int64_t depth);
+
+// Charge an allocation to the current site (called by rt_alloc_object)
+void rt_profile_alloc(RtObjectKind kind, size_t size);
+
+// Charge a raised exception to the current site (called by __pyc_raise)
+void rt_profile_raise(Exception* exc);
+
+#endif // PROFILE_H
@@ -1,51 +1,50 @@
 #include "runtime.h"
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 
-Range* __pyc___builtin___range_1(int64_t stop) {
-    Range* r = (Range*)malloc(sizeof(Range));
-    if (r == NULL) {
-        rt_panic("Failed to allocate memory for range");
+void __pyc___builtin___range_init(Range* r, int64_t start, int64_t stop, int64_t step) {
+    if (step == 0) {
+        rt_panic("range() step argument must not be zero");
     }
-    r->start = 0;
+    r->start = start;
     r->stop = stop;
-    r->step = 1;
-    r->current = 0;
+    r->step = step;
+    r->current = start;
+}
+
+Range* __pyc___builtin___range_1(int64_t stop) {
+    Range* r = (Range*)rt_alloc_object(sizeof(Range), RT_KIND_RANGE);
+    __pyc___builtin___range_init(r, 0, stop, 1);
     return r;
 }
 
 Range* __pyc___builtin___range_2(int64_t start, int64_t stop) {
-    Range* r = (Range*)malloc(sizeof(Range));
-    if (r == NULL) {
-        rt_panic("Failed to allocate memory for range");
-    }
-    r->start = start;
-    r->stop = stop;
-    r->step = 1;
-    r->current = start;
+    Range* r = (Range*)rt_alloc_object(sizeof(Range), RT_KIND_RANGE);
+    __pyc___builtin___range_init(r, start, stop, 1);
     return r;
 }
 
 Range* __pyc___builtin___range_3(int64_t start, int64_t stop, int64_t step) {
-    if (step == 0) {
-        rt_panic("range() step argument must not be zero");
-    }
-    Range* r = (Range*)malloc(sizeof(Range));
-    if (r == NULL) {
-        rt_panic("Failed to allocate memory for range");
-    }
-    r->start = start;
-    r->stop = stop;
-    r->step = step;
-    r->current = start;
+    Range* r = (Range*)rt_alloc_object(sizeof(Range), RT_KIND_RANGE);
+    __pyc___builtin___range_init(r, start, stop, step);
     return r;
 }
 
+void __pyc___builtin___range_iter_init(Range* it, Range* r) {
+    *it = *r;
+    it->current = r->start;
+}
+
+// Each iteration gets its own cursor, so a range can be iterated repeatedly or
+// nested over itself; the for-loop releases it with __dealloc__.
 Range* RANGE_METHOD(__iter__)(Range* r) {
-    if (r != NULL) {
-        r->current = r->start;
+    if (r == NULL) {
+        return NULL;
     }
-    return r;
+    Range* it = (Range*)rt_alloc_object(sizeof(Range), RT_KIND_RANGE);
+    __pyc___builtin___range_iter_init(it, r);
+    return it;
 }
 
 int64_t RANGE_METHOD(__next__)(Range* r) {
@@ -65,7 +64,7 @@ int64_t RANGE_METHOD(__next__)(Range* r) {
 }
 
 void RANGE_METHOD(__dealloc__)(Range* r) {
-    free(r);
+    rt_free_object(r, sizeof(Range));
 }
 
 int64_t RANGE_METHOD(__len__)(Range* r) {
@@ -85,15 +84,23 @@ String* RANGE_METHOD(__str__)(Range* r) {
         return STR_METHOD(from_literal)("range()", 7);
     }
 
-    char buffer[128];
-    int len;
+    // "range(" + up to three ints with ", " between them + ")"
+    char buffer[6 + 3 * RT_INT64_MAX_CHARS + 4 + 1];
+    size_t len = 0;
+    memcpy(buffer, "range(", 6);
+    len += 6;
+    len += rt_format_int64(r->start, buffer + len);
+    buffer[len++] = ',';
+    buffer[len++] = ' ';
+    len += rt_format_int64(r->stop, buffer + len);
     if (r->step != 1) {
-        len = snprintf(buffer, sizeof(buffer), "range(%ld, %ld, %ld)", r->start, r->stop, r->step);
-    } else {
-        len = snprintf(buffer, sizeof(buffer), "range(%ld, %ld)", r->start, r->stop);
+        buffer[len++] = ',';
+        buffer[len++] = ' ';
+        len += rt_format_int64(r->step, buffer + len);
     }
+    buffer[len++] = ')';
 
-    return STR_METHOD(from_literal)(buffer, len);
+    return STR_METHOD(from_literal)(buffer, (int64_t)len);
 }
 
 String* RANGE_METHOD(__repr__)(Range* r) {
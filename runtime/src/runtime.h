@@ -8,44 +8,101 @@
 // ============================================================================
 
 #include "types.h"
+#include "memory.h"
 #include "io.h"
+#include "format.h"
 #include "str.h"
 #include "bytes.h"
 #include "exception.h"
+#include "file.h"
+#include "parallel.h"
+#include "profile.h"
 
 // ============================================================================
-// List structure for list[int]
+// List structure for list[T]
+// Elements are stored unboxed: list[int] as int64_t, list[float] as double,
+// list[bool] as one byte and every other element type as a pointer. The
+// typed kernels below are generated per storage by LIST_KERNELS in list.c;
+// the suffix-free names are the list[int] kernels.
 // ============================================================================
 
+typedef enum {
+    LIST_ELEM_INT,     // int64_t
+    LIST_ELEM_FLOAT,   // double
+    LIST_ELEM_BOOL,    // int8_t
+    LIST_ELEM_STR,     // String*
+    LIST_ELEM_OBJECT,  // Class instance or other runtime object pointer
+} ListElemKind;
+
 typedef struct {
-    int64_t* data;
+    void* data;
     int64_t len;
     int64_t cap;
+    int32_t elem_size;
+    int32_t elem_kind;  // ListElemKind
 } List;
 
-List* LIST_METHOD(__init__)(void);
-void LIST_METHOD(append)(List* list, int64_t value);
-int64_t LIST_METHOD(__getitem__)(List* list, int64_t index);
-void LIST_METHOD(__setitem__)(List* list, int64_t index, int64_t value);
+typedef struct {
+    List* list;
+    int64_t index;
+} ListIterator;
+
+#define LIST_KERNEL_DECLS(SUFFIX, T) \
+    List* __pyc___builtin___list##SUFFIX##___init__(void); \
+    void __pyc___builtin___list##SUFFIX##_append(List* list, T value); \
+    T __pyc___builtin___list##SUFFIX##___getitem__(List* list, int64_t index); \
+    void __pyc___builtin___list##SUFFIX##___setitem__(List* list, int64_t index, T value); \
+    String* __pyc___builtin___list##SUFFIX##___repr__(List* list); \
+    String* __pyc___builtin___list##SUFFIX##___str__(List* list); \
+    T __pyc___builtin___list_iterator##SUFFIX##___next__(ListIterator* iter);
+
+LIST_KERNEL_DECLS(, int64_t)
+LIST_KERNEL_DECLS(_f64, double)
+LIST_KERNEL_DECLS(_bool, int8_t)
+LIST_KERNEL_DECLS(_str, String*)
+LIST_KERNEL_DECLS(_ptr, void*)
+
+// Storage-independent operations
 int64_t LIST_METHOD(__len__)(List* list);
 void LIST_METHOD(free)(List* list);
-String* LIST_METHOD(__str__)(List* list);
-String* LIST_METHOD(__repr__)(List* list);
 
 // ============================================================================
-// ListIterator structure
+// ListIterator
 // ============================================================================
 
-typedef struct {
-    List* list;
-    int64_t index;
-} ListIterator;
-
 ListIterator* LIST_METHOD(__iter__)(List* list);
 ListIterator* LIST_ITERATOR_METHOD(__iter__)(ListIterator* iter);
-int64_t LIST_ITERATOR_METHOD(__next__)(ListIterator* iter);
 void LIST_ITERATOR_METHOD(__dealloc__)(ListIterator* iter);
 
+// ============================================================================
+// Slot helpers shared with dict and set
+// A slot is one element widened to 8 bytes: the int64_t, the bits of the
+// double, 0/1, or the pointer.
+// ============================================================================
+
+List* rt_list_new(ListElemKind kind);
+void rt_list_append_slot(List* list, uint64_t slot);
+
+// Growable text buffer for repr of containers
+typedef struct {
+    char* data;
+    size_t len;
+    size_t cap;
+} ReprBuffer;
+
+void rt_repr_init(ReprBuffer* buf);
+void rt_repr_append(ReprBuffer* buf, const char* text, size_t len);
+// Append the repr of one element, as list.__repr__ prints it
+void rt_repr_append_slot(ReprBuffer* buf, ListElemKind kind, uint64_t slot);
+// Build the result string and release the buffer
+String* rt_repr_finish(ReprBuffer* buf);
+
+// str.join over a list[str] (needs List above)
+String* STR_METHOD(join)(String* sep, List* items);
+
+// dict and set (needs List and ListElemKind above)
+#include "dict.h"
+
 // ============================================================================
 // Range structure
 // ============================================================================
@@ -61,6 +118,10 @@ Range* __pyc___builtin___range_1(int64_t stop);
 Range* __pyc___builtin___range_2(int64_t start, int64_t stop);
 Range* __pyc___builtin___range_3(int64_t start, int64_t stop, int64_t step);
 
+// Fill caller-provided storage (stack ranges that escape analysis kept off the heap)
+void __pyc___builtin___range_init(Range* r, int64_t start, int64_t stop, int64_t step);
+void __pyc___builtin___range_iter_init(Range* it, Range* r);
+
 Range* RANGE_METHOD(__iter__)(Range* r);
 int64_t RANGE_METHOD(__next__)(Range* r);
 int64_t RANGE_METHOD(__len__)(Range* r);
@@ -79,7 +140,16 @@ typedef struct {
 } ByteArray;
 
 ByteArray* BYTEARRAY_METHOD(__init__)(void);
+// bytearray(b): a copy of b, with no spare capacity
+ByteArray* BYTEARRAY_METHOD(from_bytes)(Bytes* b);
+// bytearray(n): n zero bytes
+ByteArray* BYTEARRAY_METHOD(zeros)(int64_t len);
 void BYTEARRAY_METHOD(append)(ByteArray* ba, int64_t value);
+// Append all of b with one copy
+void BYTEARRAY_METHOD(extend)(ByteArray* ba, Bytes* b);
+// ba[lo:hi] as a new bytearray, bounds as rt_slice_bounds takes them
+ByteArray* BYTEARRAY_METHOD(__getslice__)(ByteArray* ba, int64_t lo, int64_t hi);
+int64_t BYTEARRAY_METHOD(find)(ByteArray* ba, Bytes* sub);
 int64_t BYTEARRAY_METHOD(__getitem__)(ByteArray* ba, int64_t index);
 void BYTEARRAY_METHOD(__setitem__)(ByteArray* ba, int64_t index, int64_t value);
 int64_t BYTEARRAY_METHOD(__len__)(ByteArray* ba);
@@ -104,7 +174,19 @@ void write_newline_impl(void);
 void write_space_impl(void);
 char* int64_to_str_impl(int64_t value, char* buffer);
 
-void __pyc___builtin___int___print__(int64_t value);
-void __pyc___builtin___bool___print__(int8_t value);
+// str(), int() and float() between primitives, and of text
+String* __pyc___builtin___int___str__(int64_t value);
+String* __pyc___builtin___float___str__(double value);
+String* __pyc___builtin___bool___str__(int8_t value);
+int64_t STR_METHOD(__int__)(String* s);
+double STR_METHOD(__float__)(String* s);
+int64_t __pyc___builtin___float___int__(double value);
+double __pyc___builtin___int___float__(int64_t value);
+
+// Print one print() argument followed by a space, or by a newline if end_line
+void __pyc___builtin___int___print__(int64_t value, int8_t end_line);
+void __pyc___builtin___bool___print__(int8_t value, int8_t end_line);
+void __pyc___builtin___float___print__(double value, int8_t end_line);
+void __pyc___builtin___str___print__(String* str, int8_t end_line);
 
 #endif // RUNTIME_H
@@ -1,4 +1,5 @@
-#include "str.h"
+#include "runtime.h"
+#include "strkernel.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdint.h>
@@ -7,28 +8,23 @@
 // String operations with Unicode support (ICU)
 // ============================================================================
 
-// Helper: Check if a string is ASCII-only
+// Classify a string's bytes: ASCII-only strings are found a vector at a time,
+// and only the part after the first non-ASCII byte needs UTF-8 validation
 static inline uint16_t detect_flags(const char* data, int64_t len) {
-    uint16_t flags = STR_FLAG_VALID_UTF8;  // Assume valid UTF-8
-    int8_t is_ascii = 1;
-
-    for (int64_t i = 0; i < len; i++) {
-        if ((unsigned char)data[i] > 127) {
-            is_ascii = 0;
-            break;
-        }
-    }
-
-    if (is_ascii) {
-        flags |= STR_FLAG_ASCII_ONLY;
+    size_t ascii = rt_ascii_prefix(data, (size_t)len);
+    if (ascii == (size_t)len) {
+        return STR_FLAG_ASCII_ONLY | STR_FLAG_VALID_UTF8;
     }
+    return rt_utf8_valid(data + ascii, (size_t)len - ascii) ? STR_FLAG_VALID_UTF8 : 0;
+}
 
-    return flags;
+uint16_t rt_str_detect_flags(const char* data, int64_t len) {
+    return detect_flags(data, len);
 }
 
 String* STR_METHOD(__init__)(const char* cstr) {
     if (cstr == NULL) {
-        String* s = (String*)malloc(sizeof(String) + 1);
+        String* s = string_alloc(0);
         if (s == NULL) return NULL;
         s->len = 0;
         s->cp_count = 0;
@@ -38,7 +34,7 @@ String* STR_METHOD(__init__)(const char* cstr) {
     }
 
     size_t len = strlen(cstr);
-    String* s = (String*)malloc(sizeof(String) + len + 1);
+    String* s = string_alloc(len);
     if (s == NULL) return NULL;
 
     s->len = (int64_t)len;
@@ -49,7 +45,7 @@ String* STR_METHOD(__init__)(const char* cstr) {
 }
 
 String* STR_METHOD(from_literal)(const char* cstr, int64_t len) {
-    String* s = (String*)malloc(sizeof(String) + len + 1);
+    String* s = string_alloc(len);
     if (s == NULL) return NULL;
 
     s->len = len;
@@ -60,52 +56,102 @@ String* STR_METHOD(from_literal)(const char* cstr, int64_t len) {
     return s;
 }
 
+void rt_string_release(String* s) {
+    if (s->cp_index != NULL) {
+        rt_free(s->cp_index, sizeof(int64_t) * (size_t)str_index_entries(s->cp_count));
+        s->cp_index = NULL;
+    }
+}
+
 void STR_METHOD(free)(String* s) {
-    free(s);
+    if (s != NULL) {
+        rt_string_release(s);
+        rt_free_object(s, sizeof(String) + (size_t)s->len + 1);
+    }
 }
 
-int64_t STR_METHOD(__len__)(String* str) {
-    if (!str) return 0;
+// ============================================================================
+// Codepoint indexing
+// ============================================================================
 
-    // If already computed, return cached value
-    if (str->cp_count >= 0) {
-        return str->cp_count;
-    }
+// Byte length of the UTF-8 sequence starting with `lead` (1 for invalid bytes)
+static inline int64_t utf8_sequence_len(unsigned char lead) {
+    if (lead < 0xC0) return 1;
+    if (lead < 0xE0) return 2;
+    if (lead < 0xF0) return 3;
+    return lead < 0xF8 ? 4 : 1;
+}
 
-    // Fast path for ASCII strings
-    if (str->flags & STR_FLAG_ASCII_ONLY) {
-        // For ASCII strings, byte length == character count
-        // Note: Don't cache for literals (they're read-only)
-        return str->len;
+// Byte offset `count` codepoints after byte offset `pos`
+static inline int64_t skip_codepoints(const String* s, int64_t pos, int64_t count) {
+    while (count > 0 && pos < s->len) {
+        pos += utf8_sequence_len((unsigned char)s->data[pos]);
+        count--;
     }
+    return pos;
+}
 
-#ifdef NO_ICU
-    // Without ICU, count UTF-8 codepoints manually
-    int32_t count = 0;
-    int32_t byte_idx = 0;
-    while (byte_idx < str->len) {
-        unsigned char c = (unsigned char)str->data[byte_idx];
-        if ((c & 0x80) == 0) byte_idx += 1;           // 0xxxxxxx - ASCII
-        else if ((c & 0xE0) == 0xC0) byte_idx += 2;   // 110xxxxx
-        else if ((c & 0xF0) == 0xE0) byte_idx += 3;   // 1110xxxx
-        else if ((c & 0xF8) == 0xF0) byte_idx += 4;   // 11110xxx
-        else byte_idx += 1;  // Invalid, skip
-        count++;
+int64_t str_cp_count(String* s) {
+    if (s->cp_count >= 0) {
+        return s->cp_count;
     }
-    return count;
-#else
-    // Count Unicode codepoints to match Python's len() behavior
-    // Note: Python counts codepoints, not grapheme clusters
-    // So len("👋🏽") == 2 in Python (two codepoints: wave + skin tone modifier)
-    int32_t count = 0;
-    int32_t byte_idx = 0;
-    while (byte_idx < str->len) {
-        UChar32 c;
-        U8_NEXT(str->data, byte_idx, str->len, c);
-        if (c >= 0) count++;
+    if (s->flags & STR_FLAG_ASCII_ONLY) {
+        s->cp_count = s->len <= INT32_MAX ? (int32_t)s->len : -1;
+        return s->len;
+    }
+    // Python counts codepoints, not grapheme clusters: len("👋🏽") == 2.
+    // Every codepoint has exactly one byte that is not a continuation byte.
+    int64_t count = 0;
+    for (int64_t i = 0; i < s->len; i++) {
+        count += ((unsigned char)s->data[i] & 0xC0) != 0x80;
+    }
+    if (count <= INT32_MAX) {
+        s->cp_count = (int32_t)count;
     }
     return count;
-#endif
+}
+
+// Record the byte offset of every STR_INDEX_STRIDE-th codepoint. Iterations
+// of a parallel loop may race to index the same shared string; the first
+// index published wins and the others are dropped.
+static int64_t* build_codepoint_index(String* s) {
+    int64_t entries = str_index_entries(s->cp_count);
+    int64_t* index = (int64_t*)rt_alloc(sizeof(int64_t) * (size_t)entries);
+    int64_t pos = 0;
+    for (int64_t i = 0; i < entries; i++) {
+        index[i] = pos;
+        pos = skip_codepoints(s, pos, STR_INDEX_STRIDE);
+    }
+    int64_t* expected = NULL;
+    if (!__atomic_compare_exchange_n(&s->cp_index, &expected, index, 0,
+                                     __ATOMIC_RELEASE, __ATOMIC_ACQUIRE)) {
+        rt_free(index, sizeof(int64_t) * (size_t)entries);
+        return expected;
+    }
+    return index;
+}
+
+int64_t str_codepoint_offset(String* s, int64_t index) {
+    if (s->flags & STR_FLAG_ASCII_ONLY) {
+        return index;
+    }
+    int64_t count = str_cp_count(s);
+    if (count <= STR_INDEX_STRIDE || s->cp_count < 0) {
+        return skip_codepoints(s, 0, index);
+    }
+    int64_t* cp_index = __atomic_load_n(&s->cp_index, __ATOMIC_ACQUIRE);
+    if (cp_index == NULL) {
+        cp_index = build_codepoint_index(s);
+    }
+    if (index >= count) {
+        return s->len;
+    }
+    return skip_codepoints(s, cp_index[index / STR_INDEX_STRIDE], index % STR_INDEX_STRIDE);
+}
+
+int64_t STR_METHOD(__len__)(String* str) {
+    if (!str) return 0;
+    return str_cp_count(str);
 }
 
 int64_t STR_METHOD(__getitem__)(String* s, int64_t index) {
@@ -121,62 +167,31 @@ int64_t STR_METHOD(__getitem__)(String* s, int64_t index) {
         return (int64_t)(unsigned char)s->data[index];
     }
 
-#ifdef NO_ICU
-    // Without ICU, manually decode UTF-8 codepoints
-    int32_t byte_idx = 0;
-    int64_t current_idx = 0;
-
-    while (byte_idx < s->len) {
-        unsigned char c = (unsigned char)s->data[byte_idx];
-        int32_t codepoint = 0;
-        int bytes = 0;
-
-        if ((c & 0x80) == 0) {
-            codepoint = c;
-            bytes = 1;
-        } else if ((c & 0xE0) == 0xC0) {
-            codepoint = c & 0x1F;
-            bytes = 2;
-        } else if ((c & 0xF0) == 0xE0) {
-            codepoint = c & 0x0F;
-            bytes = 3;
-        } else if ((c & 0xF8) == 0xF0) {
-            codepoint = c & 0x07;
-            bytes = 4;
-        } else {
-            return -1;  // Invalid UTF-8
-        }
-
-        for (int i = 1; i < bytes && (byte_idx + i) < s->len; i++) {
-            codepoint = (codepoint << 6) | (s->data[byte_idx + i] & 0x3F);
-        }
-
-        if (current_idx == index) {
-            return (int64_t)codepoint;
-        }
-        byte_idx += bytes;
-        current_idx++;
+    if (index >= str_cp_count(s)) {
+        return -1;  // Out of bounds
     }
+    int64_t byte_idx = str_codepoint_offset(s, index);
 
-    return -1;  // Index out of bounds
+#ifdef NO_ICU
+    // Without ICU, manually decode the UTF-8 sequence
+    unsigned char c = (unsigned char)s->data[byte_idx];
+    int64_t bytes = utf8_sequence_len(c);
+    if (bytes == 1 && c >= 0x80) {
+        return -1;  // Invalid UTF-8
+    }
+    int32_t codepoint = bytes == 1 ? c : c & (0x7F >> bytes);
+    for (int64_t i = 1; i < bytes && (byte_idx + i) < s->len; i++) {
+        codepoint = (codepoint << 6) | (s->data[byte_idx + i] & 0x3F);
+    }
+    return (int64_t)codepoint;
 #else
-    // For Unicode strings, navigate to the index-th codepoint
-    int32_t byte_idx = 0;
+    int32_t offset = (int32_t)byte_idx;
     UChar32 codepoint = 0;
-    int64_t current_idx = 0;
-
-    while (byte_idx < s->len) {
-        U8_NEXT(s->data, byte_idx, s->len, codepoint);
-        if (codepoint < 0) {
-            return -1;  // Invalid UTF-8
-        }
-        if (current_idx == index) {
-            return (int64_t)codepoint;
-        }
-        current_idx++;
+    U8_NEXT(s->data, offset, s->len, codepoint);
+    if (codepoint < 0) {
+        return -1;  // Invalid UTF-8
     }
-
-    return -1;  // Index out of bounds
+    return (int64_t)codepoint;
 #endif
 }
 
@@ -202,7 +217,7 @@ String* STR_METHOD(__repr__)(String* str) {
         }
     }
 
-    String* result = (String*)malloc(sizeof(String) + out_len + 1);
+    String* result = string_alloc(out_len);
     if (result == NULL) return NULL;
     result->len = out_len;
     result->cp_count = -1;  // Not computed
@@ -242,27 +257,26 @@ String* STR_METHOD(__repr__)(String* str) {
 // String concatenation (CRITICAL - was broken before)
 // ============================================================================
 
+// Always returns a new string (a NULL operand acts as ""), so the compiler can
+// free the result of an intermediate concatenation such as (a + b) in a + b + c.
 String* STR_METHOD(__add__)(String* a, String* b) {
-    if (a == NULL && b == NULL) {
-        return STR_METHOD(__init__)(NULL);  // Empty string
-    }
-    if (a == NULL) return b;
-    if (b == NULL) return a;
-
-    int64_t total_len = a->len + b->len;
-    String* result = (String*)malloc(sizeof(String) + total_len + 1);
-    if (result == NULL) return NULL;
+    int64_t a_len = a ? a->len : 0;
+    int64_t b_len = b ? b->len : 0;
+    int64_t total_len = a_len + b_len;
+    String* result = string_alloc(total_len);
 
     result->len = total_len;
     result->cp_count = -1;  // Will be computed on demand
 
     // Copy both strings
-    memcpy(result->data, a->data, a->len);
-    memcpy(result->data + a->len, b->data, b->len);
+    if (a_len > 0) memcpy(result->data, a->data, a_len);
+    if (b_len > 0) memcpy(result->data + a_len, b->data, b_len);
     result->data[total_len] = '\0';
 
     // Set flags: ASCII only if both are ASCII
-    if ((a->flags & STR_FLAG_ASCII_ONLY) && (b->flags & STR_FLAG_ASCII_ONLY)) {
+    int a_ascii = a == NULL || (a->flags & STR_FLAG_ASCII_ONLY);
+    int b_ascii = b == NULL || (b->flags & STR_FLAG_ASCII_ONLY);
+    if (a_ascii && b_ascii) {
         result->flags = STR_FLAG_ASCII_ONLY | STR_FLAG_VALID_UTF8;
         result->cp_count = (int32_t)total_len;  // ASCII: byte count == char count
     } else {
@@ -272,6 +286,110 @@ String* STR_METHOD(__add__)(String* a, String* b) {
     return result;
 }
 
+// ============================================================================
+// String builder and str.join
+// ============================================================================
+
+// A String of `len` bytes, to be filled in by the caller. ascii: every piece
+// copied into it is ASCII.
+static String* string_of_pieces(int64_t len, int ascii) {
+    String* s = string_alloc(len);
+    s->len = len;
+    if (ascii) {
+        s->flags = STR_FLAG_ASCII_ONLY | STR_FLAG_VALID_UTF8;
+        s->cp_count = len <= INT32_MAX ? (int32_t)len : -1;
+    } else {
+        s->flags = STR_FLAG_VALID_UTF8;
+        s->cp_count = -1;
+    }
+    s->data[len] = '\0';
+    return s;
+}
+
+static inline int piece_is_ascii(String* s) {
+    return s == NULL || (s->flags & STR_FLAG_ASCII_ONLY);
+}
+
+StrBuilder* __pyc_str_builder_new(String* base) {
+    StrBuilder* b = (StrBuilder*)rt_alloc_object(sizeof(StrBuilder), RT_KIND_STR_BUILDER);
+    b->base = base;
+    b->data = NULL;
+    b->len = 0;
+    b->cap = 0;
+    b->ascii = 1;
+    return b;
+}
+
+void __pyc_str_builder_append(StrBuilder* b, String* piece) {
+    int64_t piece_len = piece ? piece->len : 0;
+    if (b->data == NULL) {
+        // First append: move the starting value into a buffer of our own
+        int64_t base_len = b->base ? b->base->len : 0;
+        int64_t cap = 2 * (base_len + piece_len);
+        b->cap = cap < STR_BUILDER_MIN_CAP ? STR_BUILDER_MIN_CAP : cap;
+        b->data = (char*)rt_alloc((size_t)b->cap);
+        if (base_len > 0) memcpy(b->data, b->base->data, (size_t)base_len);
+        b->len = base_len;
+        b->ascii = piece_is_ascii(b->base);
+        b->base = NULL;
+    } else if (b->len + piece_len > b->cap) {
+        int64_t cap = 2 * b->cap;
+        if (cap < b->len + piece_len) cap = b->len + piece_len;
+        b->data = (char*)rt_realloc(b->data, (size_t)b->cap, (size_t)cap);
+        b->cap = cap;
+    }
+    if (piece_len > 0) memcpy(b->data + b->len, piece->data, (size_t)piece_len);
+    b->len += piece_len;
+    b->ascii &= piece_is_ascii(piece);
+}
+
+String* __pyc_str_builder_finish(StrBuilder* b) {
+    String* result = b->base;
+    if (b->data != NULL) {
+        result = string_of_pieces(b->len, b->ascii);
+        memcpy(result->data, b->data, (size_t)b->len);
+    }
+    rt_str_builder_release(b);
+    rt_free_object(b, sizeof(StrBuilder));
+    return result;
+}
+
+void rt_str_builder_release(StrBuilder* b) {
+    rt_free(b->data, (size_t)b->cap);
+    b->data = NULL;
+}
+
+String* STR_METHOD(join)(String* sep, List* items) {
+    int64_t count = LIST_METHOD(__len__)(items);
+    String** pieces = (String**)items->data;
+    if (count == 1 && pieces[0] != NULL) {
+        return pieces[0];
+    }
+
+    // Size the result once, then copy every piece into place
+    int64_t sep_len = sep ? sep->len : 0;
+    int64_t total = count > 1 ? sep_len * (count - 1) : 0;
+    int ascii = count < 2 || piece_is_ascii(sep);
+    for (int64_t i = 0; i < count; i++) {
+        total += pieces[i] ? pieces[i]->len : 0;
+        ascii &= piece_is_ascii(pieces[i]);
+    }
+
+    String* result = string_of_pieces(total, ascii);
+    char* out = result->data;
+    for (int64_t i = 0; i < count; i++) {
+        if (i > 0 && sep_len > 0) {
+            memcpy(out, sep->data, (size_t)sep_len);
+            out += sep_len;
+        }
+        if (pieces[i] != NULL && pieces[i]->len > 0) {
+            memcpy(out, pieces[i]->data, (size_t)pieces[i]->len);
+            out += pieces[i]->len;
+        }
+    }
+    return result;
+}
+
 // ============================================================================
 // String comparison operators
 // ============================================================================
@@ -318,12 +436,112 @@ int8_t STR_METHOD(__ge__)(String* a, String* b) {
 // ============================================================================
 
 // Case conversion methods
+#ifndef NO_ICU
+
+// ============================================================================
+// ICU handles
+//
+// Opening ICU services is expensive, so each one is opened on first use and
+// kept for the life of the process. The case-mapping and normalization calls
+// only read their handle, so one handle can serve every thread; threads that
+// race to create one keep whichever is published first.
+// ============================================================================
+
+static UCaseMap* cached_case_map = NULL;
+
+static const UCaseMap* case_map(void) {
+    UCaseMap* csm = __atomic_load_n(&cached_case_map, __ATOMIC_ACQUIRE);
+    if (csm != NULL) return csm;
+
+    UErrorCode status = U_ZERO_ERROR;
+    csm = ucasemap_open("en_US", 0, &status);
+    if (U_FAILURE(status)) return NULL;
+
+    UCaseMap* published = NULL;
+    if (!__atomic_compare_exchange_n(&cached_case_map, &published, csm, 0,
+                                     __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        ucasemap_close(csm);
+        return published;
+    }
+    return csm;
+}
+
+// Normalizer instances belong to ICU and are never closed
+typedef const UNormalizer2* (*NormalizerGetter)(UErrorCode* status);
+
+static const UNormalizer2* cached_normalizer(const UNormalizer2** slot, NormalizerGetter get) {
+    const UNormalizer2* norm = __atomic_load_n(slot, __ATOMIC_ACQUIRE);
+    if (norm == NULL) {
+        UErrorCode status = U_ZERO_ERROR;
+        norm = get(&status);
+        if (U_FAILURE(status)) return NULL;
+        __atomic_store_n(slot, norm, __ATOMIC_RELEASE);
+    }
+    return norm;
+}
+
+// Scratch space on the stack when `size` fits, on the heap otherwise
+static void* scratch_alloc(void* stack, size_t stack_size, size_t size) {
+    return size <= stack_size ? stack : rt_alloc(size);
+}
+
+static void scratch_free(void* buffer, void* stack, size_t size) {
+    if (buffer != stack) {
+        rt_free(buffer, size);
+    }
+}
+
+// ============================================================================
+// Case mapping
+// ============================================================================
+
+#define CASE_MAP_STACK_BYTES 1024
+
+typedef int32_t (*CaseMapFn)(const UCaseMap* csm, char* dest, int32_t dest_capacity,
+                             const char* src, int32_t src_length, UErrorCode* status);
+
+// Map into scratch space with room for the usual growth, then copy the
+// result into an exactly sized String. Only text that grows past the guess
+// is mapped a second time.
+static String* icu_case_map(String* str, CaseMapFn map) {
+    const UCaseMap* csm = case_map();
+    if (csm == NULL || str->len > INT32_MAX / 2) return NULL;
+
+    char stack_buffer[CASE_MAP_STACK_BYTES];
+    int32_t cap = (int32_t)(str->len + str->len / 2 + 16);
+    char* buffer = scratch_alloc(stack_buffer, sizeof(stack_buffer), (size_t)cap);
+
+    UErrorCode status = U_ZERO_ERROR;
+    int32_t len = map(csm, buffer, cap, str->data, (int32_t)str->len, &status);
+    if (status == U_BUFFER_OVERFLOW_ERROR) {
+        scratch_free(buffer, stack_buffer, (size_t)cap);
+        cap = len;
+        buffer = scratch_alloc(stack_buffer, sizeof(stack_buffer), (size_t)cap);
+        status = U_ZERO_ERROR;
+        len = map(csm, buffer, cap, str->data, (int32_t)str->len, &status);
+    }
+
+    String* result = NULL;
+    if (U_SUCCESS(status)) {
+        result = string_alloc(len);
+        result->len = len;
+        result->cp_count = -1;  // Not computed
+        result->flags = detect_flags(buffer, len);
+        memcpy(result->data, buffer, (size_t)len);
+        result->data[len] = '\0';
+    }
+    scratch_free(buffer, stack_buffer, (size_t)cap);
+    return result;
+}
+
+#endif
+
 String* STR_METHOD(lower)(String* str) {
     if (str == NULL) return NULL;
 
     // Fast path for ASCII strings
     if (str->flags & STR_FLAG_ASCII_ONLY) {
-        String* result = (String*)malloc(sizeof(String) + str->len + 1);
+        String* result = string_alloc(str->len);
         if (result == NULL) return NULL;
 
         result->len = str->len;
@@ -340,7 +558,7 @@ String* STR_METHOD(lower)(String* str) {
 
 #ifdef NO_ICU
     // Without ICU, only handle ASCII (already done above), return copy for non-ASCII
-    String* result = (String*)malloc(sizeof(String) + str->len + 1);
+    String* result = string_alloc(str->len);
     if (result == NULL) return NULL;
     result->len = str->len;
     result->cp_count = str->cp_count;
@@ -348,44 +566,7 @@ String* STR_METHOD(lower)(String* str) {
     memcpy(result->data, str->data, str->len + 1);
     return result;
 #else
-    // Unicode case conversion using ICU
-    UErrorCode status = U_ZERO_ERROR;
-    UCaseMap* csm = ucasemap_open("en_US", 0, &status);
-    if (U_FAILURE(status)) return NULL;
-
-    // Calculate required buffer size
-    int32_t dest_len = ucasemap_utf8ToLower(csm, NULL, 0,
-        str->data, str->len, &status);
-
-    if (status != U_BUFFER_OVERFLOW_ERROR && U_FAILURE(status)) {
-        ucasemap_close(csm);
-        return NULL;
-    }
-
-    // Allocate and convert
-    String* result = (String*)malloc(sizeof(String) + dest_len + 1);
-    if (result == NULL) {
-        ucasemap_close(csm);
-        return NULL;
-    }
-
-    status = U_ZERO_ERROR;
-    dest_len = ucasemap_utf8ToLower(csm, result->data, dest_len + 1,
-        str->data, str->len, &status);
-
-    ucasemap_close(csm);
-
-    if (U_FAILURE(status)) {
-        free(result);
-        return NULL;
-    }
-
-    result->len = dest_len;
-    result->cp_count = -1;  // Not computed
-    result->flags = STR_FLAG_VALID_UTF8;
-    result->data[dest_len] = '\0';
-
-    return result;
+    return icu_case_map(str, ucasemap_utf8ToLower);
 #endif
 }
 
@@ -394,7 +575,7 @@ String* STR_METHOD(upper)(String* str) {
 
     // Fast path for ASCII strings
     if (str->flags & STR_FLAG_ASCII_ONLY) {
-        String* result = (String*)malloc(sizeof(String) + str->len + 1);
+        String* result = string_alloc(str->len);
         if (result == NULL) return NULL;
 
         result->len = str->len;
@@ -411,7 +592,7 @@ String* STR_METHOD(upper)(String* str) {
 
 #ifdef NO_ICU
     // Without ICU, only handle ASCII (already done above), return copy for non-ASCII
-    String* result = (String*)malloc(sizeof(String) + str->len + 1);
+    String* result = string_alloc(str->len);
     if (result == NULL) return NULL;
     result->len = str->len;
     result->cp_count = str->cp_count;
@@ -419,69 +600,35 @@ String* STR_METHOD(upper)(String* str) {
     memcpy(result->data, str->data, str->len + 1);
     return result;
 #else
-    // Unicode case conversion using ICU
-    UErrorCode status = U_ZERO_ERROR;
-    UCaseMap* csm = ucasemap_open("en_US", 0, &status);
-    if (U_FAILURE(status)) return NULL;
-
-    // Calculate required buffer size
-    int32_t dest_len = ucasemap_utf8ToUpper(csm, NULL, 0,
-        str->data, str->len, &status);
-
-    if (status != U_BUFFER_OVERFLOW_ERROR && U_FAILURE(status)) {
-        ucasemap_close(csm);
-        return NULL;
-    }
-
-    // Allocate and convert
-    String* result = (String*)malloc(sizeof(String) + dest_len + 1);
-    if (result == NULL) {
-        ucasemap_close(csm);
-        return NULL;
-    }
-
-    status = U_ZERO_ERROR;
-    dest_len = ucasemap_utf8ToUpper(csm, result->data, dest_len + 1,
-        str->data, str->len, &status);
-
-    ucasemap_close(csm);
-
-    if (U_FAILURE(status)) {
-        free(result);
-        return NULL;
-    }
-
-    result->len = dest_len;
-    result->cp_count = -1;  // Not computed
-    result->flags = STR_FLAG_VALID_UTF8;
-    result->data[dest_len] = '\0';
-
-    return result;
+    return icu_case_map(str, ucasemap_utf8ToUpper);
 #endif
 }
 
-// Whitespace operations
+static inline int is_strip_space(char c) {
+    return rt_ascii_is((unsigned char)c, RT_CLASS_SPACE);
+}
+
+STATIC_STRING(empty_string, "");
+
 String* STR_METHOD(strip)(String* str) {
     if (str == NULL) return NULL;
     if (str->len == 0) return str;
 
     // Find first non-whitespace character
     int64_t start = 0;
-    while (start < str->len && (str->data[start] == ' ' || str->data[start] == '\t' ||
-                                 str->data[start] == '\n' || str->data[start] == '\r')) {
+    while (start < str->len && is_strip_space(str->data[start])) {
         start++;
     }
 
     // Find last non-whitespace character
     int64_t end = str->len - 1;
-    while (end >= start && (str->data[end] == ' ' || str->data[end] == '\t' ||
-                            str->data[end] == '\n' || str->data[end] == '\r')) {
+    while (end >= start && is_strip_space(str->data[end])) {
         end--;
     }
 
     if (start > end) {
         // All whitespace - return empty string
-        return STR_METHOD(from_literal)("", 0);
+        return empty_string;
     }
 
     int64_t new_len = end - start + 1;
@@ -490,7 +637,7 @@ String* STR_METHOD(strip)(String* str) {
         return str;
     }
 
-    String* result = (String*)malloc(sizeof(String) + new_len + 1);
+    String* result = string_alloc(new_len);
     if (result == NULL) return NULL;
 
     result->len = new_len;
@@ -503,20 +650,30 @@ String* STR_METHOD(strip)(String* str) {
     return result;
 }
 
+// Codepoints in the first `offset` bytes of a string
+static int64_t codepoints_before(String* s, int64_t offset) {
+    if (s->flags & STR_FLAG_ASCII_ONLY) {
+        return offset;
+    }
+    int64_t count = 0;
+    for (int64_t i = 0; i < offset; i++) {
+        count += ((unsigned char)s->data[i] & 0xC0) != 0x80;
+    }
+    return count;
+}
+
 // String search methods
 int64_t STR_METHOD(find)(String* str, String* substr) {
     if (str == NULL || substr == NULL) return -1;
-    if (substr->len == 0) return 0;
-    if (substr->len > str->len) return -1;
-
-    // Simple Boyer-Moore-like search
-    for (int64_t i = 0; i <= str->len - substr->len; i++) {
-        if (memcmp(str->data + i, substr->data, substr->len) == 0) {
-            return i;
-        }
-    }
+    int64_t found = rt_find(str->data, (size_t)str->len, substr->data, (size_t)substr->len);
+    return found < 0 ? -1 : codepoints_before(str, found);
+}
 
-    return -1;
+int64_t STR_METHOD(count)(String* str, String* substr) {
+    if (str == NULL || substr == NULL) return 0;
+    // The empty string matches between every pair of codepoints and at both ends
+    if (substr->len == 0) return str_cp_count(str) + 1;
+    return rt_count(str->data, (size_t)str->len, substr->data, (size_t)substr->len);
 }
 
 int8_t STR_METHOD(startswith)(String* str, String* prefix) {
@@ -536,18 +693,35 @@ int8_t STR_METHOD(endswith)(String* str, String* suffix) {
                   suffix->data, suffix->len) == 0 ? 1 : 0;
 }
 
+// Matches recorded on the stack before replace() moves to the heap
+#define REPLACE_INLINE_MATCHES 32
+
 // String modification
 String* STR_METHOD(replace)(String* str, String* old, String* new_str) {
     if (str == NULL || old == NULL || new_str == NULL) return str;
     if (old->len == 0) return str;  // Can't replace empty string
 
-    // Count occurrences
+    // Find every occurrence once, remembering where it starts
+    int64_t inline_matches[REPLACE_INLINE_MATCHES];
+    int64_t* matches = inline_matches;
+    int64_t cap = REPLACE_INLINE_MATCHES;
     int64_t count = 0;
-    for (int64_t i = 0; i <= str->len - old->len; i++) {
-        if (memcmp(str->data + i, old->data, old->len) == 0) {
-            count++;
-            i += old->len - 1;  // Skip past this occurrence
+    int64_t pos = 0;
+    int64_t found;
+    while ((found = rt_find(str->data + pos, (size_t)(str->len - pos), old->data,
+                            (size_t)old->len)) >= 0) {
+        if (count == cap) {
+            if (matches == inline_matches) {
+                matches = (int64_t*)rt_alloc(sizeof(int64_t) * (size_t)cap * 2);
+                memcpy(matches, inline_matches, sizeof(inline_matches));
+            } else {
+                matches = (int64_t*)rt_realloc(matches, sizeof(int64_t) * (size_t)cap,
+                                               sizeof(int64_t) * (size_t)cap * 2);
+            }
+            cap *= 2;
         }
+        matches[count++] = pos + found;
+        pos += found + old->len;
     }
 
     if (count == 0) return str;  // No replacements needed
@@ -555,106 +729,179 @@ String* STR_METHOD(replace)(String* str, String* old, String* new_str) {
     // Calculate new length
     int64_t new_len = str->len + count * (new_str->len - old->len);
 
-    String* result = (String*)malloc(sizeof(String) + new_len + 1);
+    String* result = string_alloc(new_len);
     if (result == NULL) return NULL;
 
     result->len = new_len;
     result->cp_count = -1;
     result->flags = (str->flags & new_str->flags);  // ASCII only if both are ASCII
 
-    // Perform replacements
+    // Copy the text between matches and the replacements in whole runs
     int64_t src_pos = 0;
-    int64_t dst_pos = 0;
-
-    while (src_pos < str->len) {
-        if (src_pos <= str->len - old->len &&
-            memcmp(str->data + src_pos, old->data, old->len) == 0) {
-            // Found match - copy replacement
-            memcpy(result->data + dst_pos, new_str->data, new_str->len);
-            dst_pos += new_str->len;
-            src_pos += old->len;
-        } else {
-            // No match - copy character
-            result->data[dst_pos++] = str->data[src_pos++];
-        }
-    }
-
+    char* dst = result->data;
+    for (int64_t i = 0; i < count; i++) {
+        int64_t run = matches[i] - src_pos;
+        memcpy(dst, str->data + src_pos, (size_t)run);
+        dst += run;
+        memcpy(dst, new_str->data, (size_t)new_str->len);
+        dst += new_str->len;
+        src_pos = matches[i] + old->len;
+    }
+    memcpy(dst, str->data + src_pos, (size_t)(str->len - src_pos));
     result->data[new_len] = '\0';
+
+    if (matches != inline_matches) {
+        rt_free(matches, sizeof(int64_t) * (size_t)cap);
+    }
     return result;
 }
 
 // Character classification methods
-int8_t STR_METHOD(isalpha)(String* str) {
+//
+// ASCII text is tested a vector at a time. With ICU, other text is tested
+// one codepoint at a time against the Unicode property of the class; without
+// ICU a non-ASCII character is never in the class.
+
+#ifndef NO_ICU
+static UBool codepoint_in_class(UChar32 c, RtCharClass cls) {
+    switch (cls) {
+        case RT_CLASS_ALPHA: return u_isalpha(c);
+        case RT_CLASS_DIGIT: return u_isdigit(c);
+        case RT_CLASS_SPACE: return u_isspace(c);
+    }
+    return 0;
+}
+#endif
+
+static int8_t str_all_in_class(String* str, RtCharClass cls) {
     if (str == NULL || str->len == 0) return 0;
 
-#ifdef NO_ICU
-    // ASCII-only fallback
-    for (int64_t i = 0; i < str->len; i++) {
-        char c = str->data[i];
-        if (!((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z'))) {
-            return 0;
-        }
+    const char* data = str->data;
+    size_t len = (size_t)str->len;
+    if (str->flags & STR_FLAG_ASCII_ONLY) {
+        return (int8_t)rt_ascii_all(data, len, cls);
     }
-    return 1;
+
+#ifdef NO_ICU
+    // The flag can be clear on ASCII text: "é1".replace("é", "") keeps it clear
+    return rt_ascii_prefix(data, len) == len && rt_ascii_all(data, len, cls);
 #else
     for (int64_t i = 0; i < str->len; ) {
         UChar32 c;
-        U8_NEXT(str->data, i, str->len, c);
-        if (c < 0 || !u_isalpha(c)) {
+        U8_NEXT(data, i, str->len, c);
+        if (c < 0 || !codepoint_in_class(c, cls)) {
             return 0;
         }
     }
-
     return 1;
 #endif
 }
 
-int8_t STR_METHOD(isdigit)(String* str) {
-    if (str == NULL || str->len == 0) return 0;
-
-#ifdef NO_ICU
-    // ASCII-only fallback
-    for (int64_t i = 0; i < str->len; i++) {
-        char c = str->data[i];
-        if (c < '0' || c > '9') {
-            return 0;
-        }
-    }
-    return 1;
-#else
-    for (int64_t i = 0; i < str->len; ) {
-        UChar32 c;
-        U8_NEXT(str->data, i, str->len, c);
-        if (c < 0 || !u_isdigit(c)) {
-            return 0;
-        }
-    }
+int8_t STR_METHOD(isalpha)(String* str) {
+    return str_all_in_class(str, RT_CLASS_ALPHA);
+}
 
-    return 1;
-#endif
+int8_t STR_METHOD(isdigit)(String* str) {
+    return str_all_in_class(str, RT_CLASS_DIGIT);
 }
 
 int8_t STR_METHOD(isspace)(String* str) {
-    if (str == NULL || str->len == 0) return 0;
+    return str_all_in_class(str, RT_CLASS_SPACE);
+}
+
+// ============================================================================
+// Unicode normalization
+//
+// Every form leaves ASCII text unchanged, and most other text is already
+// normalized: the quick check finds the longest prefix that certainly is,
+// and when that covers the whole string the input is returned as is.
+// Otherwise only the rest is normalized and appended to that prefix. ICU
+// normalizes UTF-16, so the text is converted on the way in and out.
+// ============================================================================
 
 #ifdef NO_ICU
-    // ASCII-only fallback
-    for (int64_t i = 0; i < str->len; i++) {
-        char c = str->data[i];
-        if (c != ' ' && c != '\t' && c != '\n' && c != '\r' && c != '\f' && c != '\v') {
-            return 0;
-        }
+
+// Without ICU, non-ASCII text is returned unnormalized
+#define DEFINE_NORMALIZE(form, getter)                      \
+    String* STR_METHOD(normalize_##form)(String* str) {     \
+        return str;                                         \
     }
-    return 1;
+
 #else
-    for (int64_t i = 0; i < str->len; ) {
-        UChar32 c;
-        U8_NEXT(str->data, i, str->len, c);
-        if (c < 0 || !u_isspace(c)) {
-            return 0;
+
+#define NORMALIZE_STACK_UNITS 512
+
+static String* normalize(String* str, const UNormalizer2** slot, NormalizerGetter get) {
+    if (str == NULL) return NULL;
+    if (str->flags & STR_FLAG_ASCII_ONLY) return str;
+    const UNormalizer2* norm = cached_normalizer(slot, get);
+    if (norm == NULL || str->len > INT32_MAX / 4) return NULL;
+
+    // UTF-16 never needs more code units than UTF-8 has bytes
+    UChar stack_src[NORMALIZE_STACK_UNITS];
+    size_t src_size = sizeof(UChar) * (size_t)str->len;
+    UChar* src = scratch_alloc(stack_src, sizeof(stack_src), src_size);
+    int32_t src_len = 0;
+    UErrorCode status = U_ZERO_ERROR;
+    u_strFromUTF8(src, (int32_t)str->len, &src_len, str->data, (int32_t)str->len, &status);
+
+    int32_t prefix = 0;
+    if (U_SUCCESS(status)) {
+        prefix = unorm2_spanQuickCheckYes(norm, src, src_len, &status);
+    }
+    if (U_FAILURE(status) || prefix == src_len) {
+        scratch_free(src, stack_src, src_size);
+        return U_SUCCESS(status) ? str : NULL;
+    }
+
+    // Room for the usual growth; decompositions that need more are redone
+    UChar stack_dst[NORMALIZE_STACK_UNITS];
+    int32_t dst_cap = src_len * 2 + 16;
+    UChar* dst = scratch_alloc(stack_dst, sizeof(stack_dst), sizeof(UChar) * (size_t)dst_cap);
+    memcpy(dst, src, sizeof(UChar) * (size_t)prefix);
+    int32_t dst_len = unorm2_normalizeSecondAndAppend(norm, dst, prefix, dst_cap, src + prefix,
+                                                      src_len - prefix, &status);
+    if (status == U_BUFFER_OVERFLOW_ERROR) {
+        scratch_free(dst, stack_dst, sizeof(UChar) * (size_t)dst_cap);
+        dst_cap = dst_len;
+        dst = scratch_alloc(stack_dst, sizeof(stack_dst), sizeof(UChar) * (size_t)dst_cap);
+        memcpy(dst, src, sizeof(UChar) * (size_t)prefix);
+        status = U_ZERO_ERROR;
+        dst_len = unorm2_normalizeSecondAndAppend(norm, dst, prefix, dst_cap, src + prefix,
+                                                  src_len - prefix, &status);
+    }
+    scratch_free(src, stack_src, src_size);
+
+    String* result = NULL;
+    int32_t len = 0;
+    if (U_SUCCESS(status)) {
+        // Measure the UTF-8 form, then write it
+        u_strToUTF8(NULL, 0, &len, dst, dst_len, &status);
+        if (status == U_BUFFER_OVERFLOW_ERROR) {
+            status = U_ZERO_ERROR;
         }
     }
+    if (U_SUCCESS(status)) {
+        result = string_alloc(len);
+        u_strToUTF8(result->data, len + 1, NULL, dst, dst_len, &status);
+        result->len = len;
+        result->cp_count = -1;  // Not computed
+        result->flags = STR_FLAG_VALID_UTF8;
+        result->data[len] = '\0';
+    }
+    scratch_free(dst, stack_dst, sizeof(UChar) * (size_t)dst_cap);
+    return result;
+}
+
+#define DEFINE_NORMALIZE(form, getter)                  \
+    static const UNormalizer2* form##_instance = NULL;  \
+    String* STR_METHOD(normalize_##form)(String* str) { \
+        return normalize(str, &form##_instance, getter); \
+    }
 
-    return 1;
 #endif
-}
+
+DEFINE_NORMALIZE(nfc, unorm2_getNFCInstance)
+DEFINE_NORMALIZE(nfd, unorm2_getNFDInstance)
+DEFINE_NORMALIZE(nfkc, unorm2_getNFKCInstance)
+DEFINE_NORMALIZE(nfkd, unorm2_getNFKDInstance)
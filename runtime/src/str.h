@@ -2,6 +2,7 @@
 #define STR_H
 
 #include "types.h"
+#include "memory.h"
 
 #ifndef NO_ICU
 #include <unicode/ubrk.h>
@@ -20,13 +21,88 @@
 #define STR_FLAG_ASCII_ONLY  0x01  // All characters are ASCII (0-127)
 #define STR_FLAG_VALID_UTF8  0x02  // String is valid UTF-8
 
+// Codepoints between entries of a string's codepoint index
+#define STR_INDEX_STRIDE 64
+
+// Indexing a non-ASCII string needs the byte offset of a codepoint. Strings
+// of more than STR_INDEX_STRIDE codepoints carry a sparse index for this: the
+// byte offset of every STR_INDEX_STRIDE-th codepoint, built on first use, so
+// a lookup decodes at most STR_INDEX_STRIDE - 1 codepoints. ASCII strings
+// never need one. String literals are read-only, so the compiler emits their
+// exact cp_count and, when they need one, their index.
 typedef struct {
     int64_t len;             // Byte length (excluding null terminator)
     int32_t cp_count;        // Cached Unicode codepoint count (-1 = not computed)
     uint16_t flags;          // STR_FLAG_ASCII_ONLY | STR_FLAG_VALID_UTF8
+    uint32_t hash;           // Cached str_hash_bytes of data (0 = not computed)
+    int64_t* cp_index;       // Codepoint index, or NULL until built
     char data[];             // UTF-8 encoded data
 } String;
 
+// Allocate a String with room for len bytes plus the null terminator. The
+// hash and index start uncomputed; the caller fills in every other field.
+static inline String* string_alloc(int64_t len) {
+    String* s = (String*)rt_alloc_object(sizeof(String) + (size_t)len + 1, RT_KIND_STRING);
+    s->hash = 0;
+    s->cp_index = NULL;
+    return s;
+}
+
+// Define `name` as a String* to a statically allocated ASCII string, for the
+// runtime's fixed texts (exception type names, "" and the like). These are
+// never freed, so they must not be returned where the compiler frees results
+// (the FRESH_STRING_RUNTIME_FUNCS). The storage stays writable so the hash can
+// be cached on first use, as for heap strings.
+#define STATIC_STRING(name, text)                                               \
+    static struct {                                                             \
+        int64_t len;                                                            \
+        int32_t cp_count;                                                       \
+        uint16_t flags;                                                         \
+        uint32_t hash;                                                          \
+        int64_t* cp_index;                                                      \
+        char data[sizeof(text)];                                                \
+    } name##_storage = {sizeof(text) - 1, sizeof(text) - 1,                     \
+                        STR_FLAG_ASCII_ONLY | STR_FLAG_VALID_UTF8,              \
+                        0, NULL, text};                                         \
+    static String* const name = (String*)&name##_storage
+
+// Number of entries in the codepoint index of a string of cp_count codepoints
+static inline int64_t str_index_entries(int64_t cp_count) {
+    return (cp_count + STR_INDEX_STRIDE - 1) / STR_INDEX_STRIDE;
+}
+
+// FNV-1a over the bytes, folded to 32 bits and never 0. The compiler computes
+// the same function for string literals, which live in read-only memory.
+static inline uint32_t str_hash_bytes(const char* data, int64_t len) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (int64_t i = 0; i < len; i++) {
+        h ^= (uint8_t)data[i];
+        h *= 0x100000001b3ULL;
+    }
+    uint32_t folded = (uint32_t)(h ^ (h >> 32));
+    return folded ? folded : 1;
+}
+
+// Hash of a string, computed on first use and cached in the header
+static inline uint32_t string_hash(String* s) {
+    if (s->hash == 0) {
+        s->hash = str_hash_bytes(s->data, s->len);
+    }
+    return s->hash;
+}
+
+// Codepoint count, computed once and cached
+int64_t str_cp_count(String* s);
+
+// Byte offset of codepoint `index` (0 <= index <= cp count)
+int64_t str_codepoint_offset(String* s, int64_t index);
+
+// Release the buffers owned by a string (the collector's finalizer)
+void rt_string_release(String* s);
+
+// STR_FLAG_* of the bytes, for code that fills in a String itself
+uint16_t rt_str_detect_flags(const char* data, int64_t len);
+
 // String creation
 String* STR_METHOD(__init__)(const char* cstr);
 String* STR_METHOD(from_literal)(const char* cstr, int64_t len);
@@ -39,6 +115,35 @@ int64_t STR_METHOD(__getitem__)(String* s, int64_t index);  // Returns Unicode c
 // String concatenation
 String* STR_METHOD(__add__)(String* a, String* b);
 
+// ============================================================================
+// String builder
+//
+// A loop that only ever extends a local string (`s = s + t` or `s += t`, with
+// s not otherwise read in the loop) is compiled to append to a StrBuilder
+// instead, and s is assigned the finished string after the loop. The buffer
+// grows geometrically, so building an n-byte string costs O(n) rather than the
+// O(n^2) of copying the whole prefix on every concatenation.
+// ============================================================================
+
+// Smallest buffer a builder allocates
+#define STR_BUILDER_MIN_CAP 64
+
+typedef struct {
+    String* base;  // Starting value, until the first append copies it
+    char* data;    // Buffer (rt_alloc), NULL until the first append
+    int64_t len;
+    int64_t cap;
+    int32_t ascii; // Every piece appended so far is ASCII
+} StrBuilder;
+
+StrBuilder* __pyc_str_builder_new(String* base);
+void __pyc_str_builder_append(StrBuilder* b, String* piece);
+// The built string (base itself if nothing was appended); frees the builder
+String* __pyc_str_builder_finish(StrBuilder* b);
+
+// Release the buffer owned by a builder (the collector's finalizer)
+void rt_str_builder_release(StrBuilder* b);
+
 // String comparison operators
 int8_t STR_METHOD(__eq__)(String* a, String* b);
 int8_t STR_METHOD(__ne__)(String* a, String* b);
@@ -76,6 +181,7 @@ String* STR_METHOD(strip)(String* str);
 
 // String search
 int64_t STR_METHOD(find)(String* str, String* substr);
+int64_t STR_METHOD(count)(String* str, String* substr);
 int8_t STR_METHOD(startswith)(String* str, String* prefix);
 int8_t STR_METHOD(endswith)(String* str, String* suffix);
 
@@ -0,0 +1,506 @@
+// memmem is a GNU/BSD extension
+#define _GNU_SOURCE
+#include "strkernel.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define ALPHA (1 << RT_CLASS_ALPHA)
+#define DIGIT (1 << RT_CLASS_DIGIT)
+#define SPACE (1 << RT_CLASS_SPACE)
+
+const uint8_t rt_ascii_classes[256] = {
+    ['\t' ... '\r'] = SPACE,
+    [0x1c ... ' '] = SPACE,
+    ['0' ... '9'] = DIGIT,
+    ['A' ... 'Z'] = ALPHA,
+    ['a' ... 'z'] = ALPHA,
+};
+
+// ============================================================================
+// Portable kernels: eight bytes at a time in a 64-bit word
+// ============================================================================
+
+#define LSBS 0x0101010101010101ULL
+#define MSBS 0x8080808080808080ULL
+#define LOW7 0x7f7f7f7f7f7f7f7fULL
+
+// Bytes in memory order, lowest address in the low byte
+static inline uint64_t load_word(const char* p) {
+    uint64_t w;
+    memcpy(&w, p, sizeof(w));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    w = __builtin_bswap64(w);
+#endif
+    return w;
+}
+
+// The high bit of every zero byte of x, and no other bits
+static inline uint64_t word_zero_bytes(uint64_t x) {
+    return ~(((x & LOW7) + LOW7) | x | LOW7);
+}
+
+static inline uint64_t word_match(uint64_t w, uint8_t c) {
+    return word_zero_bytes(w ^ (LSBS * c));
+}
+
+static size_t ascii_prefix_portable(const char* data, size_t len) {
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+        uint64_t high = load_word(data + i) & MSBS;
+        if (high) {
+            return i + (size_t)__builtin_ctzll(high) / 8;
+        }
+    }
+    while (i < len && (unsigned char)data[i] < 0x80) {
+        i++;
+    }
+    return i;
+}
+
+static int64_t find_byte_portable(const char* data, size_t len, char c) {
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+        uint64_t mask = word_match(load_word(data + i), (uint8_t)c);
+        if (mask) {
+            return (int64_t)(i + (size_t)__builtin_ctzll(mask) / 8);
+        }
+    }
+    for (; i < len; i++) {
+        if (data[i] == c) return (int64_t)i;
+    }
+    return -1;
+}
+
+static int64_t count_byte_portable(const char* data, size_t len, char c) {
+    int64_t count = 0;
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+        count += __builtin_popcountll(word_match(load_word(data + i), (uint8_t)c));
+    }
+    for (; i < len; i++) {
+        count += data[i] == c;
+    }
+    return count;
+}
+
+static int ascii_all_portable(const char* data, size_t len, RtCharClass cls) {
+    for (size_t i = 0; i < len; i++) {
+        if (!rt_ascii_is((unsigned char)data[i], cls)) return 0;
+    }
+    return 1;
+}
+
+// ============================================================================
+// Substring search
+//
+// Candidates are the positions where both the first and the last byte of the
+// needle match, found a word or vector at a time; each is confirmed with
+// memcmp. Inputs that keep producing false candidates ("aaaa...") would make
+// this quadratic, so once confirmations fail more often than one per 16
+// bytes scanned, the rest of the search goes to libc's memmem (two-way,
+// linear time).
+// ============================================================================
+
+#define SEARCH_MISS_ALLOWANCE 64
+
+typedef struct {
+    const char* haystack;
+    size_t len;
+    const char* needle;
+    size_t needle_len;
+    size_t misses;
+} Search;
+
+// Confirm the candidates in `mask`, lowest first. Candidate k sits at byte
+// base + (bit index >> shift).
+static inline int64_t search_confirm(Search* s, size_t base, uint64_t mask, int shift) {
+    while (mask) {
+        size_t pos = base + ((size_t)__builtin_ctzll(mask) >> shift);
+        // The first and last bytes already match
+        if (memcmp(s->haystack + pos + 1, s->needle + 1, s->needle_len - 2) == 0) {
+            return (int64_t)pos;
+        }
+        s->misses++;
+        mask &= mask - 1;
+    }
+    return -1;
+}
+
+static inline int search_degenerate(const Search* s, size_t scanned) {
+    return s->misses > SEARCH_MISS_ALLOWANCE + scanned / 16;
+}
+
+static int64_t search_two_way(const Search* s, size_t from) {
+    const char* found = memmem(s->haystack + from, s->len - from, s->needle, s->needle_len);
+    return found ? (int64_t)(found - s->haystack) : -1;
+}
+
+// Positions the block loop could not reach
+static int64_t search_tail(const Search* s, size_t from) {
+    for (size_t i = from; i + s->needle_len <= s->len; i++) {
+        if (s->haystack[i] == s->needle[0] &&
+            memcmp(s->haystack + i + 1, s->needle + 1, s->needle_len - 1) == 0) {
+            return (int64_t)i;
+        }
+    }
+    return -1;
+}
+
+static int64_t find_portable(Search* s) {
+    const uint64_t first = LSBS * (uint8_t)s->needle[0];
+    const uint64_t last = LSBS * (uint8_t)s->needle[s->needle_len - 1];
+    size_t i = 0;
+    for (; i + s->needle_len - 1 + 8 <= s->len; i += 8) {
+        uint64_t mask = word_zero_bytes(load_word(s->haystack + i) ^ first) &
+                        word_zero_bytes(load_word(s->haystack + i + s->needle_len - 1) ^ last);
+        if (mask) {
+            int64_t found = search_confirm(s, i, mask, 3);
+            if (found >= 0) return found;
+            if (search_degenerate(s, i)) return search_two_way(s, i);
+        }
+    }
+    return search_tail(s, i);
+}
+
+#if defined(__SSE2__)
+
+// ============================================================================
+// SSE2 kernels
+//
+// -nostdinc keeps the intrinsics headers out of reach, so vectors are GCC
+// vector extensions and movemask is reached through its builtin.
+// ============================================================================
+
+typedef char Vec16 __attribute__((vector_size(16)));
+typedef unsigned char UVec16 __attribute__((vector_size(16)));
+
+static inline Vec16 load16(const char* p) {
+    Vec16 v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline Vec16 splat16(char c) {
+    Vec16 v;
+    memset(&v, c, sizeof(v));
+    return v;
+}
+
+static inline uint32_t mask16(Vec16 v) {
+    return (uint32_t)__builtin_ia32_pmovmskb128(v);
+}
+
+static size_t ascii_prefix_sse2(const char* data, size_t len) {
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        uint32_t high = mask16(load16(data + i));
+        if (high) {
+            return i + (size_t)__builtin_ctz(high);
+        }
+    }
+    return i + ascii_prefix_portable(data + i, len - i);
+}
+
+static int64_t find_byte_sse2(const char* data, size_t len, char c) {
+    const Vec16 needle = splat16(c);
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        uint32_t mask = mask16((Vec16)(load16(data + i) == needle));
+        if (mask) {
+            return (int64_t)(i + (size_t)__builtin_ctz(mask));
+        }
+    }
+    int64_t found = find_byte_portable(data + i, len - i, c);
+    return found < 0 ? -1 : (int64_t)i + found;
+}
+
+// Matches are tallied per lane (a match lane is -1, so subtracting adds one)
+// and the lanes summed before any of them can wrap. Baseline x86_64 has no
+// popcnt instruction to count movemask bits with.
+static int64_t count_byte_sse2(const char* data, size_t len, char c) {
+    const Vec16 needle = splat16(c);
+    int64_t count = 0;
+    size_t i = 0;
+    while (i + 16 <= len) {
+        UVec16 lanes = (UVec16)splat16(0);
+        for (int round = 0; round < 255 && i + 16 <= len; round++, i += 16) {
+            lanes -= (UVec16)(load16(data + i) == needle);
+        }
+        for (int k = 0; k < 16; k++) {
+            count += lanes[k];
+        }
+    }
+    return count + count_byte_portable(data + i, len - i, c);
+}
+
+// Lanes of v in [lo, lo + n)
+static inline Vec16 in_range16(Vec16 v, char lo, unsigned char n) {
+    UVec16 offset = (UVec16)v - (UVec16)splat16(lo);
+    return (Vec16)(offset < (UVec16)splat16((char)n));
+}
+
+static inline Vec16 class_lanes16(Vec16 v, RtCharClass cls) {
+    switch (cls) {
+        case RT_CLASS_ALPHA:
+            return in_range16(v | splat16(0x20), 'a', 26);
+        case RT_CLASS_DIGIT:
+            return in_range16(v, '0', 10);
+        case RT_CLASS_SPACE:
+            return in_range16(v, '\t', 5) | in_range16(v, 0x1c, 5);
+    }
+    return splat16(0);
+}
+
+static int ascii_all_sse2(const char* data, size_t len, RtCharClass cls) {
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        if (mask16(class_lanes16(load16(data + i), cls)) != 0xFFFF) return 0;
+    }
+    return ascii_all_portable(data + i, len - i, cls);
+}
+
+static int64_t find_sse2(Search* s) {
+    const Vec16 first = splat16(s->needle[0]);
+    const Vec16 last = splat16(s->needle[s->needle_len - 1]);
+    size_t i = 0;
+    for (; i + s->needle_len - 1 + 16 <= s->len; i += 16) {
+        Vec16 hit = (Vec16)(load16(s->haystack + i) == first) &
+                    (Vec16)(load16(s->haystack + i + s->needle_len - 1) == last);
+        uint32_t mask = mask16(hit);
+        if (mask) {
+            int64_t found = search_confirm(s, i, mask, 0);
+            if (found >= 0) return found;
+            if (search_degenerate(s, i)) return search_two_way(s, i);
+        }
+    }
+    return search_tail(s, i);
+}
+
+// ============================================================================
+// AVX2 kernels, compiled for AVX2 whatever the target CPU and only called
+// once cpuid has confirmed it
+// ============================================================================
+
+#define AVX2 __attribute__((target("avx2")))
+
+typedef char Vec32 __attribute__((vector_size(32)));
+
+AVX2 static inline Vec32 load32(const char* p) {
+    Vec32 v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+AVX2 static inline Vec32 splat32(char c) {
+    Vec32 v;
+    memset(&v, c, sizeof(v));
+    return v;
+}
+
+AVX2 static inline uint32_t mask32(Vec32 v) {
+    return (uint32_t)__builtin_ia32_pmovmskb256(v);
+}
+
+AVX2 static size_t ascii_prefix_avx2(const char* data, size_t len) {
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32) {
+        uint32_t high = mask32(load32(data + i));
+        if (high) {
+            return i + (size_t)__builtin_ctz(high);
+        }
+    }
+    return i + ascii_prefix_sse2(data + i, len - i);
+}
+
+AVX2 static int64_t find_byte_avx2(const char* data, size_t len, char c) {
+    const Vec32 needle = splat32(c);
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32) {
+        uint32_t mask = mask32((Vec32)(load32(data + i) == needle));
+        if (mask) {
+            return (int64_t)(i + (size_t)__builtin_ctz(mask));
+        }
+    }
+    int64_t found = find_byte_sse2(data + i, len - i, c);
+    return found < 0 ? -1 : (int64_t)i + found;
+}
+
+AVX2 static int64_t count_byte_avx2(const char* data, size_t len, char c) {
+    const Vec32 needle = splat32(c);
+    int64_t count = 0;
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32) {
+        count += __builtin_popcount(mask32((Vec32)(load32(data + i) == needle)));
+    }
+    return count + count_byte_sse2(data + i, len - i, c);
+}
+
+AVX2 static int64_t find_avx2(Search* s) {
+    const Vec32 first = splat32(s->needle[0]);
+    const Vec32 last = splat32(s->needle[s->needle_len - 1]);
+    size_t i = 0;
+    for (; i + s->needle_len - 1 + 32 <= s->len; i += 32) {
+        Vec32 hit = (Vec32)(load32(s->haystack + i) == first) &
+                    (Vec32)(load32(s->haystack + i + s->needle_len - 1) == last);
+        uint32_t mask = mask32(hit);
+        if (mask) {
+            int64_t found = search_confirm(s, i, mask, 0);
+            if (found >= 0) return found;
+            if (search_degenerate(s, i)) return search_two_way(s, i);
+        }
+    }
+    return search_tail(s, i);
+}
+
+static void cpuid(uint32_t leaf, uint32_t subleaf, uint32_t regs[4]) {
+    __asm__ volatile("cpuid"
+                     : "=a"(regs[0]), "=b"(regs[1]), "=c"(regs[2]), "=d"(regs[3])
+                     : "a"(leaf), "c"(subleaf));
+}
+
+// AVX2 needs the instructions (leaf 7) and OS support for the YMM state
+static int cpu_has_avx2(void) {
+    uint32_t regs[4];
+    cpuid(0, 0, regs);
+    if (regs[0] < 7) return 0;
+    cpuid(1, 0, regs);
+    const uint32_t osxsave_avx = (1u << 27) | (1u << 28);
+    if ((regs[2] & osxsave_avx) != osxsave_avx) return 0;
+    uint32_t xcr0_lo, xcr0_hi;
+    __asm__ volatile("xgetbv" : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0));
+    (void)xcr0_hi;
+    if ((xcr0_lo & 0x6) != 0x6) return 0;
+    cpuid(7, 0, regs);
+    return (regs[1] >> 5) & 1;
+}
+
+RtSimdLevel rt_simd_level = RT_SIMD_SSE2;
+
+#else
+
+static int cpu_has_avx2(void) {
+    return 0;
+}
+
+RtSimdLevel rt_simd_level = RT_SIMD_PORTABLE;
+
+#endif
+
+__attribute__((constructor))
+static void init_simd_level(void) {
+    if (cpu_has_avx2()) {
+        rt_simd_level = RT_SIMD_AVX2;
+    }
+    const char* cap = getenv("PYC_SIMD");
+    if (cap == NULL) return;
+    RtSimdLevel limit = rt_simd_level;
+    if (strcmp(cap, "portable") == 0) {
+        limit = RT_SIMD_PORTABLE;
+    } else if (strcmp(cap, "sse2") == 0) {
+        limit = RT_SIMD_SSE2;
+    }
+    if (limit < rt_simd_level) {
+        rt_simd_level = limit;
+    }
+}
+
+// ============================================================================
+// Dispatch
+// ============================================================================
+
+#if defined(__SSE2__)
+#define DISPATCH(kernel, ...)                                       \
+    switch (rt_simd_level) {                                        \
+        case RT_SIMD_AVX2: return kernel##_avx2(__VA_ARGS__);       \
+        case RT_SIMD_SSE2: return kernel##_sse2(__VA_ARGS__);       \
+        case RT_SIMD_PORTABLE: break;                               \
+    }                                                               \
+    return kernel##_portable(__VA_ARGS__)
+#else
+#define DISPATCH(kernel, ...) return kernel##_portable(__VA_ARGS__)
+#endif
+
+size_t rt_ascii_prefix(const char* data, size_t len) {
+    DISPATCH(ascii_prefix, data, len);
+}
+
+int64_t rt_find_byte(const char* data, size_t len, char c) {
+    DISPATCH(find_byte, data, len, c);
+}
+
+int rt_ascii_all(const char* data, size_t len, RtCharClass cls) {
+#if defined(__SSE2__)
+    // Classification is a handful of compares per vector; SSE2 is enough
+    if (rt_simd_level != RT_SIMD_PORTABLE) {
+        return ascii_all_sse2(data, len, cls);
+    }
+#endif
+    return ascii_all_portable(data, len, cls);
+}
+
+int64_t rt_find(const char* haystack, size_t len, const char* needle, size_t needle_len) {
+    if (needle_len == 0) return 0;
+    if (needle_len > len) return -1;
+    if (needle_len == 1) return rt_find_byte(haystack, len, needle[0]);
+    Search s = {haystack, len, needle, needle_len, 0};
+    DISPATCH(find, &s);
+}
+
+static int64_t count_byte(const char* data, size_t len, char c) {
+    DISPATCH(count_byte, data, len, c);
+}
+
+int64_t rt_count(const char* haystack, size_t len, const char* needle, size_t needle_len) {
+    if (needle_len == 1) return count_byte(haystack, len, needle[0]);
+    int64_t count = 0;
+    size_t pos = 0;
+    int64_t found;
+    while ((found = rt_find(haystack + pos, len - pos, needle, needle_len)) >= 0) {
+        count++;
+        pos += (size_t)found + needle_len;
+    }
+    return count;
+}
+
+// ============================================================================
+// UTF-8 validation
+// ============================================================================
+
+static inline int is_continuation(unsigned char c) {
+    return (c & 0xC0) == 0x80;
+}
+
+int rt_utf8_valid(const char* data, size_t len) {
+    const unsigned char* p = (const unsigned char*)data;
+    size_t i = 0;
+    while (i < len) {
+        if (p[i] < 0x80) {
+            i += rt_ascii_prefix(data + i, len - i);
+            continue;
+        }
+        unsigned char c = p[i];
+        // The allowed range of the second byte rules out overlong forms,
+        // surrogates (ED A0..BF) and codepoints past U+10FFFF (F4 90..)
+        unsigned char lo = 0x80, hi = 0xBF;
+        size_t n;
+        if (c >= 0xC2 && c <= 0xDF) {
+            n = 2;
+        } else if (c >= 0xE0 && c <= 0xEF) {
+            n = 3;
+            if (c == 0xE0) lo = 0xA0;
+            if (c == 0xED) hi = 0x9F;
+        } else if (c >= 0xF0 && c <= 0xF4) {
+            n = 4;
+            if (c == 0xF0) lo = 0x90;
+            if (c == 0xF4) hi = 0x8F;
+        } else {
+            return 0;
+        }
+        if (len - i < n || p[i + 1] < lo || p[i + 1] > hi) return 0;
+        for (size_t k = 2; k < n; k++) {
+            if (!is_continuation(p[i + k])) return 0;
+        }
+        i += n;
+    }
+    return 1;
+}
@@ -0,0 +1,56 @@
+#ifndef STRKERNEL_H
+#define STRKERNEL_H
+
+// ============================================================================
+// String kernels
+//
+// The byte-level loops behind str: ASCII detection, UTF-8 validation, byte
+// and substring search, counting and ASCII character classes. Each kernel
+// has a portable word-at-a-time version and, on x86_64, SSE2 and AVX2
+// versions; the widest one the CPU supports is picked at startup.
+// PYC_SIMD=portable|sse2|avx2 caps the choice, for benchmarking.
+// ============================================================================
+
+#include "types.h"
+
+typedef enum {
+    RT_SIMD_PORTABLE,
+    RT_SIMD_SSE2,
+    RT_SIMD_AVX2,
+} RtSimdLevel;
+
+extern RtSimdLevel rt_simd_level;
+
+typedef enum {
+    RT_CLASS_ALPHA,  // A-Z, a-z
+    RT_CLASS_DIGIT,  // 0-9
+    RT_CLASS_SPACE,  // \t \n \v \f \r, \x1c-\x1f and ' ' (Python's ASCII whitespace)
+} RtCharClass;
+
+// Bit (1 << class) of rt_ascii_classes[c] is set when byte c is in the class
+extern const uint8_t rt_ascii_classes[256];
+
+static inline int rt_ascii_is(unsigned char c, RtCharClass cls) {
+    return (rt_ascii_classes[c] >> cls) & 1;
+}
+
+// Length of the leading run of ASCII bytes
+size_t rt_ascii_prefix(const char* data, size_t len);
+
+// Whether data is well-formed UTF-8 (no overlong forms, surrogates or
+// codepoints past U+10FFFF)
+int rt_utf8_valid(const char* data, size_t len);
+
+// Whether every byte is in `cls`; the bytes must all be ASCII
+int rt_ascii_all(const char* data, size_t len, RtCharClass cls);
+
+// Offset of the first `c` in data, or -1
+int64_t rt_find_byte(const char* data, size_t len, char c);
+
+// Offset of the first occurrence of needle in haystack, or -1
+int64_t rt_find(const char* haystack, size_t len, const char* needle, size_t needle_len);
+
+// Number of non-overlapping occurrences of needle; needle_len must be > 0
+int64_t rt_count(const char* haystack, size_t len, const char* needle, size_t needle_len);
+
+#endif // STRKERNEL_H
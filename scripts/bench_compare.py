@@ -0,0 +1,82 @@
+#!/usr/bin/env python3
+"""Compare two pybench reports and flag the benchmarks that got slower.
+
+Each benchmark present in both reports gets a row with its median wall
+time, instruction count, peak RSS and binary size before and after. A
+benchmark whose median time (or instruction count, when both reports have
+one) grew by more than the threshold is a regression, and so is one whose
+output changed.
+
+Usage: scripts/bench_compare.py BEFORE.json AFTER.json [--threshold PERCENT]
+"""
+
+import argparse
+import json
+import sys
+
+
+def load(path):
+    """Benchmarks of a report, by name."""
+    with open(path) as f:
+        report = json.load(f)
+    return report, {bench["name"]: bench for bench in report["benchmarks"]}
+
+
+def change(before, after):
+    """Relative change in percent, or None when either side is missing."""
+    if before is None or after is None or before == 0:
+        return None
+    return (after - before) / before * 100.0
+
+
+def format_change(percent):
+    return f"{'n/a':>8}" if percent is None else f"{percent:>+7.1f}%"
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("before")
+    parser.add_argument("after")
+    parser.add_argument("--threshold", type=float, default=5.0,
+                        help="slowdown in percent that counts as a regression")
+    args = parser.parse_args()
+
+    before_report, before = load(args.before)
+    after_report, after = load(args.after)
+    for key in ["target", "opt_level"]:
+        if before_report.get(key) != after_report.get(key):
+            print(f"warning: {key} differs: {before_report.get(key)} vs "
+                  f"{after_report.get(key)}", file=sys.stderr)
+
+    print(f"{'benchmark':<14}{'median (s)':>22}{'time':>9}{'instrs':>9}"
+          f"{'rss':>9}{'size':>9}")
+    status = 0
+    for name in sorted(before.keys() & after.keys()):
+        old, new = before[name], after[name]
+        time = change(old["wall_seconds_median"], new["wall_seconds_median"])
+        instructions = change(old.get("instructions"), new.get("instructions"))
+        rss = change(old["peak_rss_kib"], new["peak_rss_kib"])
+        size = change(old["binary_bytes"], new["binary_bytes"])
+        row = f"{name:<14}"
+        row += f"{old['wall_seconds_median']:>11.4f}{new['wall_seconds_median']:>11.4f}"
+        row += "".join(format_change(c) + " " for c in [time, instructions, rss, size])
+
+        # Instruction counts are far less noisy than wall time, so they decide
+        # when both reports have them
+        slowdown = instructions if instructions is not None else time
+        if slowdown is not None and slowdown > args.threshold:
+            row += " REGRESSION"
+            status = 1
+        if old["output_hash"] != new["output_hash"]:
+            row += " OUTPUT CHANGED"
+            status = 1
+        print(row)
+
+    for name in sorted(before.keys() ^ after.keys()):
+        side = "before" if name in before else "after"
+        print(f"{name:<14} only in {side}")
+    return status
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,74 @@
+#!/usr/bin/env python3
+"""Compare exception models by compiling a benchmark with each and timing it.
+
+Usage: scripts/bench_exception_models.py [program.py] [--runs N] [--pycc PATH]
+"""
+
+import argparse
+import os
+import subprocess
+import sys
+import tempfile
+import time
+
+MODELS = ["polling", "may-raise"]
+
+
+def compile_program(pycc, source, output, model):
+    """Compile source with the given exception model."""
+    subprocess.run(
+        [pycc, source, "-o", output, "--exception-model", model],
+        check=True,
+    )
+
+
+def time_program(executable, runs):
+    """Run an executable several times, returning (best seconds, stdout)."""
+    best = None
+    stdout = None
+    for _ in range(runs):
+        start = time.perf_counter()
+        result = subprocess.run([executable], check=True, capture_output=True, text=True)
+        elapsed = time.perf_counter() - start
+        best = elapsed if best is None else min(best, elapsed)
+        stdout = result.stdout
+    return best, stdout
+
+
+def main():
+    repo_root = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument(
+        "program",
+        nargs="?",
+        default=os.path.join(repo_root, "bench", "exception_models.py"),
+    )
+    parser.add_argument("--runs", type=int, default=5)
+    parser.add_argument(
+        "--pycc",
+        default=os.path.join(repo_root, "target", "release", "pycc"),
+    )
+    args = parser.parse_args()
+
+    results = {}
+    with tempfile.TemporaryDirectory() as tmp:
+        for model in MODELS:
+            exe = os.path.join(tmp, model)
+            compile_program(args.pycc, args.program, exe, model)
+            results[model] = time_program(exe, args.runs)
+
+    outputs = {out for _, out in results.values()}
+    if len(outputs) != 1:
+        print("error: exception models produced different output", file=sys.stderr)
+        return 1
+
+    baseline = results["polling"][0]
+    print(f"{'model':<12} {'best (s)':>10} {'speedup':>8}")
+    for model in MODELS:
+        best = results[model][0]
+        print(f"{model:<12} {best:>10.4f} {baseline / best:>7.2f}x")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,99 @@
+#!/usr/bin/env python3
+"""Time each string kernel benchmark at every SIMD level the CPU supports.
+
+Every bench_* function in the benchmark module gets its own executable,
+which is run under PYC_SIMD=portable, sse2 and avx2 in turn (a level the
+CPU lacks runs at the best one it has).
+
+Usage: scripts/bench_str_kernels.py [module.py] [--iterations N] [--runs N]
+                                    [--pycc PATH] [--python]
+"""
+
+import argparse
+import os
+import re
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+
+LEVELS = ["portable", "sse2", "avx2"]
+
+
+def bench_functions(source):
+    """Names of the bench_* functions defined in a module."""
+    with open(source) as f:
+        return re.findall(r"^def (bench_\w+)\(", f.read(), re.MULTILINE)
+
+
+def write_driver(directory, module, function, iterations):
+    """Write a program that runs one benchmark, returning its path."""
+    path = os.path.join(directory, f"{function}.py")
+    with open(path, "w") as f:
+        f.write(f"from {module} import {function}\n")
+        f.write(f"print({function}({iterations}))\n")
+    return path
+
+
+def time_command(command, runs, env=None):
+    """Run a command several times, returning (best seconds, stdout)."""
+    best = None
+    stdout = None
+    for _ in range(runs):
+        start = time.perf_counter()
+        result = subprocess.run(command, check=True, capture_output=True, text=True, env=env)
+        elapsed = time.perf_counter() - start
+        best = elapsed if best is None else min(best, elapsed)
+        stdout = result.stdout
+    return best, stdout
+
+
+def main():
+    repo_root = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument(
+        "module",
+        nargs="?",
+        default=os.path.join(repo_root, "bench", "str_kernels.py"),
+    )
+    parser.add_argument("--iterations", type=int, default=20000)
+    parser.add_argument("--runs", type=int, default=5)
+    parser.add_argument(
+        "--pycc",
+        default=os.path.join(repo_root, "target", "release", "pycc"),
+    )
+    parser.add_argument("--python", action="store_true", help="also time CPython")
+    args = parser.parse_args()
+
+    module = os.path.splitext(os.path.basename(args.module))[0]
+    columns = LEVELS + (["cpython"] if args.python else [])
+    print(f"{'kernel':<18}" + "".join(f"{c + ' (s)':>16}" for c in columns))
+
+    status = 0
+    with tempfile.TemporaryDirectory() as tmp:
+        shutil.copy(args.module, tmp)
+        for function in bench_functions(args.module):
+            driver = write_driver(tmp, module, function, args.iterations)
+            exe = os.path.join(tmp, function)
+            subprocess.run([args.pycc, driver, "-o", exe], check=True)
+
+            results = {}
+            for level in LEVELS:
+                env = dict(os.environ, PYC_SIMD=level)
+                results[level] = time_command([exe], args.runs, env)
+            if args.python:
+                results["cpython"] = time_command([sys.executable, driver], args.runs)
+
+            row = f"{function[len('bench_'):]:<18}"
+            row += "".join(f"{results[c][0]:>16.4f}" for c in columns)
+            print(row)
+
+            if len({out for _, out in results.values()}) != 1:
+                print(f"error: {function} produced different output", file=sys.stderr)
+                status = 1
+    return status
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,369 @@
+//! pybench - Benchmark the compiler's generated code
+//!
+//! Compiles every program of the benchmark suite once, runs each one a few
+//! times after warming up, and prints the results as JSON:
+//! `pybench > before.json`, then `scripts/bench_compare.py before.json after.json`
+
+use anyhow::{bail, Context, Result};
+use clap::Parser;
+use compiler::{Compiler, CompilerOptions, OptLevel, Target};
+use std::fmt::Write as _;
+use std::fs;
+use std::io::Read;
+use std::os::unix::process::ExitStatusExt;
+use std::path::{Path, PathBuf};
+use std::process::{Command, ExitStatus, Stdio};
+use std::time::Instant;
+
+#[derive(Parser)]
+#[command(name = "pybench")]
+#[command(about = "Benchmark compiled programs and report the results as JSON")]
+#[command(version)]
+struct Args {
+    /// Benchmark programs, or directories of them
+    /// (default: the bench/suite directory of this repository)
+    inputs: Vec<PathBuf>,
+
+    /// Only run the benchmarks whose name contains this
+    #[arg(long)]
+    filter: Option<String>,
+
+    /// Measured runs of each benchmark
+    #[arg(long, default_value = "5")]
+    runs: u32,
+
+    /// Unmeasured runs before the measured ones
+    #[arg(long, default_value = "1")]
+    warmup: u32,
+
+    /// Target architecture (x86_64 or riscv64); a foreign target runs under qemu
+    #[arg(long, default_value = "x86_64")]
+    target: String,
+
+    /// Optimization level (0-3)
+    #[arg(short = 'O', default_value = "2")]
+    opt_level: String,
+
+    /// CPU to generate code for (`native` for the host machine)
+    #[arg(long, visible_alias = "march")]
+    target_cpu: Option<String>,
+
+    /// Extra target features, e.g. +avx2 on x86_64 or +v on riscv64
+    #[arg(long)]
+    target_features: Option<String>,
+
+    /// Write the JSON report to this file instead of stdout
+    #[arg(short, long)]
+    output: Option<PathBuf>,
+
+    /// Do not count instructions with `perf stat`
+    #[arg(long)]
+    no_perf: bool,
+}
+
+/// Measurements of one benchmark
+struct BenchResult {
+    name: String,
+    compile_seconds: f64,
+    binary_bytes: u64,
+    /// Wall time of each measured run
+    wall_seconds: Vec<f64>,
+    /// Largest peak RSS over the measured runs
+    peak_rss_kib: u64,
+    /// User-space instructions of one extra run, when perf can count them
+    instructions: Option<u64>,
+    /// FNV-1a of the output, the same for every run
+    output_hash: u64,
+}
+
+/// One finished run of a benchmark
+struct Run {
+    seconds: f64,
+    peak_rss_kib: u64,
+    stdout: Vec<u8>,
+}
+
+fn main() -> Result<()> {
+    let args = Args::parse();
+
+    let target: Target = args.target.parse().map_err(|e| anyhow::anyhow!("{}", e))?;
+    let opt_level: OptLevel = args
+        .opt_level
+        .parse()
+        .map_err(|e| anyhow::anyhow!("{}", e))?;
+    if args.runs == 0 {
+        bail!("--runs must be at least 1");
+    }
+
+    let benchmarks = find_benchmarks(&args)?;
+    if benchmarks.is_empty() {
+        bail!("no benchmarks to run");
+    }
+
+    let options = CompilerOptions {
+        target,
+        opt_level,
+        target_cpu: args.target_cpu.clone(),
+        target_features: args.target_features.clone(),
+        // Every benchmark is parsed from scratch, so compile times compare
+        cache_dir: None,
+        ..Default::default()
+    };
+    let compiler = Compiler::new(options);
+    let perf = !args.no_perf && target.is_host() && perf_available();
+
+    let work_dir = std::env::temp_dir().join(format!("pybench-{}", std::process::id()));
+    fs::create_dir_all(&work_dir)?;
+    let results: Result<Vec<_>> = benchmarks
+        .iter()
+        .map(|path| run_benchmark(&compiler, target, path, &work_dir, &args, perf))
+        .collect();
+    let _ = fs::remove_dir_all(&work_dir);
+
+    let report = report_json(&args, target, &results?);
+    match &args.output {
+        Some(path) => fs::write(path, report)?,
+        None => print!("{report}"),
+    }
+    Ok(())
+}
+
+/// The benchmark programs to run, sorted by name
+fn find_benchmarks(args: &Args) -> Result<Vec<PathBuf>> {
+    let inputs = if args.inputs.is_empty() {
+        vec![Path::new(env!("CARGO_MANIFEST_DIR")).join("bench/suite")]
+    } else {
+        args.inputs.clone()
+    };
+    let mut benchmarks = Vec::new();
+    for input in inputs {
+        if input.is_dir() {
+            let entries =
+                fs::read_dir(&input).with_context(|| format!("cannot read {}", input.display()))?;
+            for entry in entries {
+                let path = entry?.path();
+                if path.extension().is_some_and(|ext| ext == "py") {
+                    benchmarks.push(path);
+                }
+            }
+        } else {
+            benchmarks.push(input);
+        }
+    }
+    if let Some(filter) = &args.filter {
+        benchmarks.retain(|path| bench_name(path).contains(filter.as_str()));
+    }
+    benchmarks.sort_by_key(|path| bench_name(path));
+    Ok(benchmarks)
+}
+
+fn bench_name(path: &Path) -> String {
+    path.file_stem()
+        .map(|stem| stem.to_string_lossy().into_owned())
+        .unwrap_or_default()
+}
+
+fn run_benchmark(
+    compiler: &Compiler,
+    target: Target,
+    path: &Path,
+    work_dir: &Path,
+    args: &Args,
+    perf: bool,
+) -> Result<BenchResult> {
+    let name = bench_name(path);
+    eprintln!("pybench: {name}");
+    let exe = work_dir.join(&name);
+    let start = Instant::now();
+    compiler
+        .compile(path, &exe)
+        .with_context(|| format!("cannot compile {}", path.display()))?;
+    let compile_seconds = start.elapsed().as_secs_f64();
+    let binary_bytes = fs::metadata(&exe)?.len();
+
+    let command = run_command(target, &exe);
+    let mut expected = None;
+    let mut wall_seconds = Vec::new();
+    let mut peak_rss_kib = 0;
+    for i in 0..args.warmup + args.runs {
+        let run = run_once(&command).with_context(|| format!("benchmark {name} failed"))?;
+        let hash = fnv1a(&run.stdout);
+        if *expected.get_or_insert(hash) != hash {
+            bail!("benchmark {name} printed different output on run {}", i + 1);
+        }
+        if i >= args.warmup {
+            wall_seconds.push(run.seconds);
+            peak_rss_kib = peak_rss_kib.max(run.peak_rss_kib);
+        }
+    }
+    // Counted separately so that perf does not slow down the timed runs
+    let instructions = if perf {
+        count_instructions(&command, work_dir)
+    } else {
+        None
+    };
+
+    Ok(BenchResult {
+        name,
+        compile_seconds,
+        binary_bytes,
+        wall_seconds,
+        peak_rss_kib,
+        instructions,
+        output_hash: expected.unwrap_or_default(),
+    })
+}
+
+/// The program and arguments that run an executable of the target
+fn run_command(target: Target, exe: &Path) -> Vec<String> {
+    let exe = exe.to_string_lossy().into_owned();
+    match target.qemu_command() {
+        Some(qemu) if !target.is_host() => vec![qemu.to_string(), exe],
+        _ => vec![exe],
+    }
+}
+
+/// Run a command to completion, measuring its wall time and peak RSS
+fn run_once(command: &[String]) -> Result<Run> {
+    let start = Instant::now();
+    let mut child = Command::new(&command[0])
+        .args(&command[1..])
+        .stdin(Stdio::null())
+        .stdout(Stdio::piped())
+        .spawn()
+        .with_context(|| format!("cannot run {}", command[0]))?;
+    let mut stdout = Vec::new();
+    child.stdout.take().unwrap().read_to_end(&mut stdout)?;
+
+    // Reap the child with wait4 rather than Child::wait to get its rusage
+    let mut status = 0;
+    let mut usage: libc::rusage = unsafe { std::mem::zeroed() };
+    let pid = unsafe { libc::wait4(child.id() as libc::pid_t, &mut status, 0, &mut usage) };
+    let seconds = start.elapsed().as_secs_f64();
+    if pid < 0 {
+        return Err(std::io::Error::last_os_error().into());
+    }
+    let status = ExitStatus::from_raw(status);
+    if !status.success() {
+        bail!("{} exited with {status}", command[0]);
+    }
+    Ok(Run {
+        seconds,
+        // ru_maxrss is in KiB on Linux
+        peak_rss_kib: usage.ru_maxrss as u64,
+        stdout,
+    })
+}
+
+fn perf_available() -> bool {
+    Command::new("perf")
+        .arg("--version")
+        .stdout(Stdio::null())
+        .stderr(Stdio::null())
+        .status()
+        .is_ok_and(|status| status.success())
+}
+
+/// User-space instructions retired by one run, or None when the counter is
+/// not supported (e.g. in a VM or with a restrictive perf_event_paranoid)
+fn count_instructions(command: &[String], work_dir: &Path) -> Option<u64> {
+    let counts = work_dir.join("perf.csv");
+    let status = Command::new("perf")
+        .args(["stat", "-x", ",", "-e", "instructions:u", "-o"])
+        .arg(&counts)
+        .arg("--")
+        .args(command)
+        .stdin(Stdio::null())
+        .stdout(Stdio::null())
+        .status()
+        .ok()?;
+    if !status.success() {
+        return None;
+    }
+    // CSV rows: value,unit,event,...; the value is `<not supported>` or
+    // `<not counted>` when perf could not count it
+    let counts = fs::read_to_string(counts).ok()?;
+    counts
+        .lines()
+        .find(|line| line.contains("instructions"))
+        .and_then(|line| line.split(',').next())
+        .and_then(|value| value.trim().parse().ok())
+}
+
+/// 64-bit FNV-1a, stable across runs and compiler versions
+fn fnv1a(bytes: &[u8]) -> u64 {
+    bytes.iter().fold(0xcbf2_9ce4_8422_2325, |hash, &byte| {
+        (hash ^ u64::from(byte)).wrapping_mul(0x0100_0000_01b3)
+    })
+}
+
+fn median(values: &[f64]) -> f64 {
+    let mut sorted = values.to_vec();
+    sorted.sort_by(f64::total_cmp);
+    let mid = sorted.len() / 2;
+    if sorted.len() % 2 == 0 {
+        (sorted[mid - 1] + sorted[mid]) / 2.0
+    } else {
+        sorted[mid]
+    }
+}
+
+/// The report, one field per line so that two reports diff cleanly
+fn report_json(args: &Args, target: Target, results: &[BenchResult]) -> String {
+    let mut json = String::new();
+    let _ = writeln!(json, "{{");
+    let _ = writeln!(
+        json,
+        "  \"compiler_version\": \"{}\",",
+        env!("CARGO_PKG_VERSION")
+    );
+    let _ = writeln!(json, "  \"target\": \"{}\",", target.triple());
+    let _ = writeln!(json, "  \"host\": \"{}\",", std::env::consts::ARCH);
+    let _ = writeln!(json, "  \"opt_level\": \"{}\",", args.opt_level);
+    let _ = writeln!(json, "  \"runs\": {},", args.runs);
+    let _ = writeln!(json, "  \"warmup\": {},", args.warmup);
+    let _ = writeln!(json, "  \"benchmarks\": [");
+    for (i, result) in results.iter().enumerate() {
+        let wall = &result.wall_seconds;
+        let min = wall.iter().copied().fold(f64::INFINITY, f64::min);
+        let mean = wall.iter().sum::<f64>() / wall.len() as f64;
+        let instructions = result
+            .instructions
+            .map_or_else(|| "null".to_string(), |count| count.to_string());
+        let runs: Vec<String> = wall.iter().map(|s| format!("{s:.6}")).collect();
+        let _ = writeln!(json, "    {{");
+        let _ = writeln!(json, "      \"name\": \"{}\",", escape(&result.name));
+        let _ = writeln!(
+            json,
+            "      \"compile_seconds\": {:.6},",
+            result.compile_seconds
+        );
+        let _ = writeln!(json, "      \"binary_bytes\": {},", result.binary_bytes);
+        let _ = writeln!(json, "      \"wall_seconds_min\": {min:.6},");
+        let _ = writeln!(json, "      \"wall_seconds_median\": {:.6},", median(wall));
+        let _ = writeln!(json, "      \"wall_seconds_mean\": {mean:.6},");
+        let _ = writeln!(json, "      \"wall_seconds\": [{}],", runs.join(", "));
+        let _ = writeln!(json, "      \"instructions\": {instructions},");
+        let _ = writeln!(json, "      \"peak_rss_kib\": {},", result.peak_rss_kib);
+        let _ = writeln!(
+            json,
+            "      \"output_hash\": \"{:016x}\"",
+            result.output_hash
+        );
+        let comma = if i + 1 < results.len() { "," } else { "" };
+        let _ = writeln!(json, "    }}{comma}");
+    }
+    let _ = writeln!(json, "  ]");
+    let _ = writeln!(json, "}}");
+    json
+}
+
+fn escape(s: &str) -> String {
+    s.chars()
+        .flat_map(|c| match c {
+            '"' | '\\' => vec!['\\', c],
+            c if c.is_control() => format!("\\u{:04x}", c as u32).chars().collect(),
+            c => vec![c],
+        })
+        .collect()
+}
@@ -4,7 +4,10 @@
 
 use anyhow::Result;
 use clap::Parser;
-use compiler::{Compiler, CompilerOptions, Target};
+use compiler::{
+    default_cache_dir, Compiler, CompilerOptions, ExceptionModel, GcConfig, GcMode, OptLevel,
+    Target,
+};
 use std::path::PathBuf;
 
 #[derive(Parser)]
@@ -22,15 +25,110 @@ struct Args {
     /// Target architecture (x86_64 or riscv64)
     #[arg(long, default_value = "x86_64")]
     target: String,
+
+    /// Exception checking in try blocks (may-raise or polling)
+    #[arg(long, default_value = "may-raise")]
+    exception_model: String,
+
+    /// Report which hot runtime calls were not inlined (to stderr)
+    #[arg(long)]
+    inline_report: bool,
+
+    /// Optimization level (0-3)
+    #[arg(short = 'O', default_value = "2")]
+    opt_level: String,
+
+    /// CPU to generate code for (`native` for the host machine)
+    #[arg(long, visible_alias = "march")]
+    target_cpu: Option<String>,
+
+    /// Extra target features, e.g. +avx2 on x86_64 or +v on riscv64
+    #[arg(long)]
+    target_features: Option<String>,
+
+    /// Instrument for PGO, writing raw profiles into this directory
+    #[arg(long, value_name = "DIR", conflicts_with = "profile_use")]
+    profile_generate: Option<PathBuf>,
+
+    /// Optimize with a profile merged by llvm-profdata, or the flat profile of a --profile run
+    #[arg(long, value_name = "FILE")]
+    profile_use: Option<PathBuf>,
+
+    /// Write a function and loop profile at exit (PYC_PROFILE names the files)
+    #[arg(long)]
+    profile: bool,
+
+    /// Print the time spent in each compilation phase
+    #[arg(long)]
+    time_passes: bool,
+
+    /// Garbage collector for runtime objects (none or mark-sweep)
+    #[arg(long, default_value = "none")]
+    gc: String,
+
+    /// Bytes allocated between collections
+    #[arg(long, value_name = "BYTES")]
+    gc_threshold: Option<u64>,
+
+    /// Heap growth after a collection, as a percentage of live bytes
+    #[arg(long, value_name = "PERCENT")]
+    gc_growth: Option<u32>,
+
+    /// Leave out list and bytearray index checks (out-of-range access is undefined)
+    #[arg(long)]
+    unchecked: bool,
+
+    /// Order class fields by size and use to shrink instances
+    #[arg(long)]
+    reorder_fields: bool,
+
+    /// Directory caching parsed modules between builds
+    /// (default: $XDG_CACHE_HOME/typepython)
+    #[arg(long, value_name = "DIR", conflicts_with = "no_cache")]
+    cache_dir: Option<PathBuf>,
+
+    /// Parse every module, without reading or writing the module cache
+    #[arg(long)]
+    no_cache: bool,
 }
 
 fn main() -> Result<()> {
     let args = Args::parse();
 
     let target: Target = args.target.parse().map_err(|e| anyhow::anyhow!("{}", e))?;
+    let exception_model: ExceptionModel = args
+        .exception_model
+        .parse()
+        .map_err(|e| anyhow::anyhow!("{}", e))?;
+    let opt_level: OptLevel = args
+        .opt_level
+        .parse()
+        .map_err(|e| anyhow::anyhow!("{}", e))?;
+    let gc_mode: GcMode = args.gc.parse().map_err(|e| anyhow::anyhow!("{}", e))?;
 
     let options = CompilerOptions {
         target,
+        exception_model,
+        inline_report: args.inline_report,
+        opt_level,
+        target_cpu: args.target_cpu,
+        target_features: args.target_features,
+        profile_generate: args.profile_generate,
+        profile_use: args.profile_use,
+        profile: args.profile,
+        time_passes: args.time_passes,
+        gc: GcConfig {
+            mode: gc_mode,
+            threshold: args.gc_threshold,
+            growth_percent: args.gc_growth,
+        },
+        unchecked: args.unchecked,
+        reorder_fields: args.reorder_fields,
+        cache_dir: if args.no_cache {
+            None
+        } else {
+            args.cache_dir.or_else(default_cache_dir)
+        },
         ..Default::default()
     };
 
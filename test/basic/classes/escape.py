@@ -0,0 +1,104 @@
+# Escape analysis test cases: objects that stay in their frame and objects that leave it
+
+class Counter:
+    count: int
+    step: int
+
+    def __init__(self, step: int) -> None:
+        self.count = 0
+        self.step = step
+
+    def tick(self) -> None:
+        self.count = self.count + self.step
+
+    def value(self) -> int:
+        return self.count
+
+
+class Pair:
+    first: int
+    second: int
+
+    def __init__(self, a: int, b: int) -> None:
+        self.first = a
+        self.second = b
+
+
+class Node:
+    value: int
+    pair: Pair
+
+    def __init__(self, v: int, p: Pair) -> None:
+        self.value = v
+        self.pair = p
+
+
+def total_with(c: Counter) -> int:
+    return c.count * 2
+
+
+def make_pair(a: int, b: int) -> Pair:
+    p: Pair = Pair(a, b)
+    return p
+
+
+# Test 1: Object only used through methods and field reads
+def test_local_counter() -> int:
+    c: Counter = Counter(3)
+    for i in range(10):
+        c.tick()
+    return c.value() + total_with(c)  # 30 + 60 = 90
+
+
+# Test 2: A fresh object per iteration, each dead before the next
+def test_object_per_iteration() -> int:
+    total: int = 0
+    for i in range(100):
+        p: Pair = Pair(i, i * 2)
+        total = total + p.first + p.second
+    return total  # 3 * 4950 = 14850
+
+
+# Test 3: Objects stored in a list must stay distinct
+def test_escape_into_list() -> int:
+    pairs: list[Pair] = []
+    for i in range(5):
+        p: Pair = Pair(i, i + 10)
+        pairs.append(p)
+    result: int = 0
+    for q in pairs:
+        result = result * 10 + q.first
+    return result  # 1234
+
+
+# Test 4: Objects returned from their creating function
+def test_escape_by_return() -> int:
+    a: Pair = make_pair(1, 2)
+    b: Pair = make_pair(3, 4)
+    return a.first + a.second * 10 + b.first * 100 + b.second * 1000  # 4321
+
+
+# Test 5: Object stored in a field of another object
+def test_escape_into_field() -> int:
+    nodes: list[Node] = []
+    for i in range(4):
+        p: Pair = Pair(i, i * i)
+        n: Node = Node(i, p)
+        nodes.append(n)
+    result: int = 0
+    for node in nodes:
+        result = result + node.pair.second
+    return result  # 0 + 1 + 4 + 9 = 14
+
+
+# Test 6: Range objects and range iteration with a runtime step
+def test_local_range(step: int) -> int:
+    r = range(1, 20, step)
+    total: int = 0
+    for x in r:
+        total = total + x
+    for y in r:
+        total = total + y
+    for z in range(0, 10, step):
+        total = total + z
+    return total  # step=3: 2 * 70 + 18 = 158
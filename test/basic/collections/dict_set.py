@@ -0,0 +1,100 @@
+# dict and set: literals, updates, membership, iteration and KeyError
+
+class Tag:
+    name: str
+
+    def __init__(self, n: str) -> None:
+        self.name = n
+
+
+def test_dict_int_keys() -> int:
+    squares: dict[int, int] = {}
+    for i in range(100):
+        squares[i] = i * i
+    squares[7] = 0
+    total: int = 0
+    for k in squares:
+        total = total + squares[k]
+    return total + len(squares)  # 328350 - 49 + 100 = 328401
+
+
+def test_dict_str_keys() -> int:
+    counts: dict[str, int] = {"a": 1, "b": 2}
+    words: list[str] = ["b", "c", "a", "b"]
+    for w in words:
+        counts[w] = counts.get(w, 0) + 1
+    return counts["a"] * 100 + counts["b"] * 10 + counts["c"]  # 241
+
+
+def test_dict_membership() -> int:
+    d: dict[str, float] = {"pi": 3.5, "e": 2.5}
+    result: int = 0
+    if "pi" in d:
+        result = result + 1
+    if "tau" not in d:
+        result = result + 10
+    if d["pi"] + d["e"] == 6.0:
+        result = result + 100
+    return result  # 111
+
+
+def test_dict_pop_and_views() -> int:
+    d: dict[int, str] = {3: "three", 1: "one", 2: "two"}
+    removed: str = d.pop(1)
+    d[4] = "four"
+    keys: list[int] = d.keys()
+    values: list[str] = d.values()
+    total: int = 0
+    for k in keys:
+        total = total * 10 + k
+    return total * 100 + len(removed) * 10 + len(values)  # 324 * 100 + 30 + 3
+
+
+def test_dict_key_error() -> int:
+    d: dict[str, int] = {"x": 1}
+    try:
+        return d["y"]
+    except KeyError:
+        return 42
+    return 0
+
+
+def test_dict_object_values() -> int:
+    tags: dict[int, Tag] = {}
+    tags[1] = Tag("one")
+    tags[2] = Tag("three")
+    return len(tags[1].name) + len(tags[2].name) * 10  # 53
+
+
+def test_set_ops() -> int:
+    seen: set[int] = set()
+    for i in range(20):
+        seen.add(i % 7)
+    seen.discard(3)
+    seen.discard(100)
+    result: int = len(seen)  # 6
+    if 5 in seen:
+        result = result + 10
+    if 3 not in seen:
+        result = result + 100
+    return result  # 116
+
+
+def test_set_str_iteration() -> int:
+    names: set[str] = {"ann", "bob", "ann", "cy"}
+    total: int = 0
+    for n in names:
+        total = total + len(n)
+    try:
+        names.remove("dan")
+    except KeyError:
+        total = total + 1000
+    return total  # 1008
+
+
+def test_print_dicts() -> int:
+    print({1: True, 2: False})
+    print({"k": "v", "n": "m"})
+    empty: dict[str, int] = {}
+    print(empty)
+    return 1
@@ -32,3 +32,32 @@ def nested_access(nums: list[int], idx: int) -> int:
     element: int = nums[idx]
     print("Element:", element)
     return element
+
+def guarded_subscripts() -> int:
+    # Each subscript is under a guard that keeps its index in range
+    nums: list[int] = [3, 1, 4, 1, 5, 9, 2, 6]
+    for i in range(len(nums)):
+        nums[i] = nums[i] * 2
+    rev: list[int] = []
+    for j in range(len(nums) - 1, -1, -1):
+        rev.append(nums[j])
+    k: int = 0
+    while k < len(rev) and rev[k] != 2:
+        k += 1
+    data: bytearray = bytearray(b"abc")
+    checksum: int = 0
+    for b in range(1, len(data)):
+        data[b] = data[b] + 1
+        checksum += data[b]
+    if k < len(rev):
+        return rev[0] + rev[k] * 100 + checksum * 1000
+    return -1
+
+def rebound_subscripts() -> int:
+    # Rebinding the list inside the loop ends the guard on the old one
+    nums: list[int] = [1, 2, 3]
+    total: int = 0
+    for i in range(len(nums)):
+        total += nums[i]
+        nums = [10, 20, 30, 40]
+    return total + nums[3]
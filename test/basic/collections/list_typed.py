@@ -0,0 +1,64 @@
+# Lists of float, bool, str and class elements (each stored unboxed)
+
+class Cell:
+    value: int
+
+    def __init__(self, v: int) -> None:
+        self.value = v
+
+
+def test_float_list_ops() -> int:
+    xs: list[float] = [0.5, 1.25]
+    for i in range(4):
+        xs.append(i * 0.5)
+    xs[0] = xs[0] + 2.0
+    total: float = 0.0
+    for x in xs:
+        total = total + x
+    if total + xs[1] == 8.0:  # 2.5 + 1.25 + 0.0 + 0.5 + 1.0 + 1.5 + 1.25
+        return 1
+    return 0
+
+
+def test_bool_list_ops() -> int:
+    flags: list[bool] = []
+    for i in range(10):
+        flags.append(i % 3 == 0)
+    flags[1] = True
+    count: int = 0
+    for f in flags:
+        if f:
+            count = count + 1
+    if flags[2]:
+        count = count + 100
+    return count  # 0, 1, 3, 6, 9 = 5
+
+
+def test_str_list_ops() -> int:
+    words: list[str] = ["alpha", "beta"]
+    words.append("gamma")
+    words[1] = "delta"
+    total: int = 0
+    for w in words:
+        total = total * 10 + len(w)
+    return total + len(words[2]) * 1000  # 555 + 5000 = 5555
+
+
+def test_class_list_ops() -> int:
+    cells: list[Cell] = []
+    for i in range(5):
+        cells.append(Cell(i * i))
+    cells[0] = Cell(7)
+    total: int = 0
+    for c in cells:
+        total = total + c.value
+    return total + cells[4].value  # 7 + 1 + 4 + 9 + 16 + 16 = 53
+
+
+def test_print_typed_lists() -> int:
+    print([1.5, 0.25])
+    print([True, False, True])
+    print(["a", "bc"])
+    empty: list[float] = []
+    print(empty)
+    return 1
@@ -99,3 +99,137 @@ def test_for_triple_nested() -> int:
     if count == 24:
         return 1
     return 0
+
+def test_for_range_negative_step() -> int:
+    """Test for loop with range and a negative literal step"""
+    total: int = 0
+    for i in range(10, 0, -3):
+        total += i
+    # 10+7+4+1 = 22
+    if total == 22:
+        return 1
+    return 0
+
+def test_for_range_empty() -> int:
+    """Test for loop over an empty range never runs the body"""
+    count: int = 0
+    for i in range(5, 5):
+        count += 1
+    for j in range(0, 5, -1):
+        count += 1
+    if count == 0:
+        return 1
+    return 0
+
+def test_for_range_rebind_target() -> int:
+    """Test that assigning to the loop variable does not change iteration"""
+    count: int = 0
+    for i in range(4):
+        i = 100
+        count += 1
+    if count == 4:
+        return 1
+    return 0
+
+def test_for_range_stop_evaluated_once() -> int:
+    """Test that the range bound is fixed when the loop starts"""
+    n: int = 3
+    count: int = 0
+    for i in range(n):
+        n += 1
+        count += 1
+    if count == 3:
+        return 1
+    return 0
+
+def find_first_multiple(k: int) -> int:
+    for i in range(1, 100):
+        if i % k == 0:
+            return i
+    return 0
+
+def test_for_range_early_return() -> int:
+    """Test returning from inside a range loop"""
+    if find_first_multiple(7) == 7:
+        return 1
+    return 0
+
+def test_for_range_variable_step() -> int:
+    """Test for loop with a non-literal step (iterator fallback)"""
+    step: int = 3
+    total: int = 0
+    for i in range(0, 10, step):
+        total += i
+    # 0+3+6+9 = 18
+    if total == 18:
+        return 1
+    return 0
+
+def test_for_range_near_int_limits() -> int:
+    """Test that a step larger than 1 does not wrap around near the int limits"""
+    top: int = 9223372036854775807
+    count: int = 0
+    for i in range(top - 7, top, 3):
+        count += 1
+    for j in range(-top + 7, -top, -3):
+        count += 1
+    # three iterations each: one more step would overflow
+    if count == 6:
+        return 1
+    return 0
+
+def test_for_list_str() -> int:
+    """Test for loop over a list of strings"""
+    words: list[str] = ["ab", "cde", "f"]
+    total: int = 0
+    for w in words:
+        total += len(w)
+    if total == 6:
+        return 1
+    return 0
+
+def test_for_list_float() -> int:
+    """Test for loop over a list of floats"""
+    values: list[float] = [1.5, 2.5, 3.0]
+    total: float = 0.0
+    for v in values:
+        total = total + v
+    if total == 7.0:
+        return 1
+    return 0
+
+def test_for_list_bool() -> int:
+    """Test for loop over a list of bools"""
+    flags: list[bool] = [True, False, True, True]
+    count: int = 0
+    for f in flags:
+        if f:
+            count += 1
+    if count == 3:
+        return 1
+    return 0
+
+def test_for_list_empty() -> int:
+    """Test for loop over an empty list never runs the body"""
+    count: int = 0
+    items: list[int] = []
+    if count > 0:
+        items.append(1)
+    for x in items:
+        count += 1
+    if count == 0:
+        return 1
+    return 0
+
+def test_for_list_append_during() -> int:
+    """Test that elements appended inside the loop are visited"""
+    items: list[int] = [1]
+    total: int = 0
+    for x in items:
+        if x < 4:
+            items.append(x + 1)
+        total += x
+    # 1+2+3+4 = 10
+    if total == 10:
+        return 1
+    return 0
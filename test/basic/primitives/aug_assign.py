@@ -25,3 +25,9 @@ def test_compound_aug() -> int:
     x *= 2
     x -= 5
     return x
+
+def test_str_add_assign() -> str:
+    s: str = "ab"
+    s += "cd"
+    s += s
+    return s
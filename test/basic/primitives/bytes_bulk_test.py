@@ -0,0 +1,56 @@
+# Test bulk bytes and bytearray operations
+
+def test_bytes_concat() -> int:
+    b: bytes = b"ab" + b"cde"
+    return len(b) * 1000 + b[2]  # 5099 (5 bytes, 'c')
+
+def test_bytes_slice() -> int:
+    b: bytes = b"hello world"
+    s: bytes = b[6:11]
+    return len(s) * 1000 + s[0]  # 5119 (5 bytes, 'w')
+
+def test_bytes_slice_open() -> int:
+    b: bytes = b"hello"
+    return len(b[:2]) * 100 + len(b[3:]) * 10 + len(b[:])  # 225
+
+def test_bytes_slice_negative() -> int:
+    b: bytes = b"hello"
+    s: bytes = b[-3:-1]
+    return len(s) * 1000 + s[0]  # 2108 (2 bytes, 'l')
+
+def test_bytes_slice_clamped() -> int:
+    b: bytes = b"abc"
+    return len(b[1:100]) * 10 + len(b[5:9])  # 20
+
+def test_bytes_find() -> int:
+    b: bytes = b"GET /index.html HTTP/1.1"
+    return b.find(b"HTTP") * 100 + b.find(b"x") + b.find(b"POST")  # 1608
+
+def test_bytes_count() -> int:
+    b: bytes = b"a,b,,c"
+    return b.count(b",") * 10 + b.count(b"")  # 37
+
+def test_bytearray_extend() -> int:
+    ba: bytearray = bytearray()
+    ba.extend(b"head")
+    i: int = 0
+    while i < 100:
+        ba.extend(b"0123456789")
+        i = i + 1
+    ba.append(33)
+    return len(ba) * 1000 + ba[4]  # 1005048 (1005 bytes, '0')
+
+def test_bytearray_zeros() -> int:
+    ba: bytearray = bytearray(16)
+    ba[15] = 7
+    return len(ba) * 100 + ba[0] + ba[15]  # 1607
+
+def test_bytearray_slice() -> int:
+    ba: bytearray = bytearray(b"abcdef")
+    s: bytearray = ba[1:3]
+    s[0] = 90
+    return len(s) * 1000 + s[0] + ba[1]  # 2188 (copy: ba[1] stays 'b')
+
+def test_bytearray_find() -> int:
+    ba: bytearray = bytearray(b"key=value")
+    return ba.find(b"=") * 10 + ba.find(b"value")  # 34
@@ -0,0 +1,55 @@
+# Expressions and pure calls that are evaluated at compile time
+
+def fib(n: int) -> int:
+    if n < 2:
+        return n
+    return fib(n - 1) + fib(n - 2)
+
+def sum_squares(n: int) -> int:
+    total: int = 0
+    for i in range(n):
+        total += i * i
+    return total
+
+def collatz_steps(n: int) -> int:
+    steps: int = 0
+    while n != 1:
+        if n % 2 == 0:
+            n = n // 2
+        else:
+            n = 3 * n + 1
+        steps += 1
+    return steps
+
+def banner(name: str) -> str:
+    return "<" + name + ">"
+
+def scale(x: float) -> float:
+    return x * 2.5
+
+TABLE_SIZE: int = fib(20)
+SQUARES: int = sum_squares(10)
+
+def test_fold_arith() -> int:
+    return (7 * 6 - 2) // 4 + (1 << 10) % 1000
+
+def test_fold_fib() -> int:
+    return fib(25)
+
+def test_fold_global() -> int:
+    return TABLE_SIZE + SQUARES
+
+def test_fold_loops() -> int:
+    return collatz_steps(27)
+
+def test_fold_str() -> str:
+    return banner("fold" + "ed")
+
+def test_fold_float() -> float:
+    return scale(4.0)
+
+def test_fold_bool() -> bool:
+    return fib(10) == 55 and not 3 > 4
+
+def test_fold_runtime_arg(n: int) -> int:
+    return fib(n) + sum_squares(3)
@@ -0,0 +1,61 @@
+# str(), int() and float() conversions, and how numbers print
+
+
+def test_int_to_str() -> int:
+    text: str = str(-9223372036854775807 - 1) + "|" + str(0) + "|" + str(1234567)
+    print(text)
+    return len(text)  # 30
+
+
+def test_float_to_str() -> int:
+    print(str(0.1), str(1.0), str(-2.5e-7), str(1e16), str(123456789.125))
+    print(0.1 + 0.2, 3.0, 1e22, 1.0 / 3.0, -0.0)
+    return len(str(0.1 + 0.2))  # 19
+
+
+def test_str_to_int() -> int:
+    a: int = int("42")
+    b: int = int("  -1_000 ")
+    c: int = int("9223372036854775807")
+    return a + b + (c - 9223372036854775800)  # -951
+
+
+def test_str_to_float() -> int:
+    x: float = float("2.5")
+    y: float = float(" -1e3 ")
+    z: float = float("0.1")
+    if x + y == -997.5 and z + 0.2 == 0.30000000000000004:
+        return 1
+    return 0  # 1
+
+
+def test_numeric_casts() -> int:
+    f: float = float(7)
+    n: int = int(-3.9)
+    if f == 7.0:
+        return n + int(str(12)) + int(float("2.75"))  # -3 + 12 + 2 = 11
+    return 0
+
+
+def test_conversion_errors() -> int:
+    result: int = 0
+    try:
+        int("12a")
+    except ValueError:
+        result = result + 1
+    try:
+        float("one")
+    except ValueError:
+        result = result + 10
+    try:
+        int(float("inf"))
+    except Exception:
+        result = result + 100
+    return result  # 111
+
+
+def test_print_number_lists() -> int:
+    floats: list[float] = [1.0, 0.5, 1e-5, 2.0 ** 60]
+    ints: list[int] = [-1, 0, 10, 1000000]
+    print(floats, ints)
+    return 1
@@ -28,6 +28,24 @@ def test_lower_mixed() -> str:
     s: str = "Hello МИРHELLO"
     return s.lower()  # Expected: hello мирhello
 
+def test_upper_grows() -> str:
+    """Test upper() when the result is longer than the input"""
+    s: str = "straße"
+    return s.upper()  # Expected: STRASSE
+
+def test_lower_long() -> int:
+    """Test lower() on non-ASCII text longer than the scratch buffer"""
+    s: str = ""
+    expected: str = ""
+    i: int = 0
+    while i < 400:
+        s = s + "ÀÉÎ"
+        expected = expected + "àéî"
+        i = i + 1
+    if s.lower() == expected:
+        return len(s.lower())  # Expected: 1200
+    return 0
+
 # ============ Whitespace Operations ============
 
 def test_strip_both() -> str:
@@ -77,6 +95,31 @@ def test_find_empty() -> int:
     s: str = "hello"
     return s.find("")  # Expected: 0
 
+def test_find_unicode() -> int:
+    """Test find() counts codepoints, not bytes"""
+    s: str = "héllo wörld"
+    return s.find("wö")  # Expected: 6
+
+def test_find_long() -> int:
+    """Test find() past the first vector of a long string"""
+    s: str = "abcabcabcabcabcabcabcabcabcabcabcabcabcabcabcabcabcabcabcabcabcabcabd"
+    return s.find("abd")  # Expected: 66
+
+def test_count_char() -> int:
+    """Test count() with a one-character substring"""
+    s: str = "a,b,,c,d,,,e,f,g,h,i,j,k,l,m,n,o,p"
+    return s.count(",")  # Expected: 18
+
+def test_count_overlapping() -> int:
+    """Test count() only counts non-overlapping occurrences"""
+    s: str = "aaaaaaa"
+    return s.count("aa")  # Expected: 3
+
+def test_count_empty() -> int:
+    """Test count() with an empty substring"""
+    s: str = "héllo"
+    return s.count("")  # Expected: 6
+
 def test_startswith_true() -> bool:
     """Test startswith() returns true"""
     s: str = "hello world"
@@ -129,6 +172,16 @@ def test_replace_unicode() -> str:
     s: str = "你好世界"
     return s.replace("世界", "朋友")  # Expected: 你好朋友
 
+def test_replace_many() -> str:
+    """Test replace() with more matches than fit on the stack"""
+    s: str = "x.x.x.x.x.x.x.x.x.x.x.x.x.x.x.x.x.x.x.x.x.x.x.x.x.x.x.x.x.x.x.x.x.x.x.x.x.x.x.x"
+    return s.replace(".", "")  # Expected: 40 x's
+
+def test_strip_form_feed() -> str:
+    """Test strip() removes every ASCII whitespace character"""
+    s: str = "\v\f hello \f\v"
+    return s.strip()  # Expected: hello
+
 # ============ Character Classification Tests ============
 
 def test_isalpha_true_ascii() -> bool:
@@ -171,6 +224,80 @@ def test_isspace_true_tabs() -> bool:
     """Test isspace() on tabs and newlines"""
     return "\t\n ".isspace()  # Expected: True
 
+def test_isdigit_long() -> bool:
+    """Test isdigit() on a string longer than one vector"""
+    s: str = "0123456789012345678901234567890123456789"
+    return s.isdigit()  # Expected: True
+
+def test_isalpha_long_false() -> bool:
+    """Test isalpha() finds a non-letter deep in a long string"""
+    s: str = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ[abc"
+    return s.isalpha()  # Expected: False
+
+# ============ String Building Tests ============
+
+def test_join_words() -> str:
+    """Test join() puts the separator between elements only"""
+    words: list[str] = ["alpha", "beta", "gamma"]
+    return ", ".join(words)  # Expected: alpha, beta, gamma
+
+def test_join_empty() -> str:
+    """Test join() of an empty list"""
+    words: list[str] = []
+    return "-".join(words)  # Expected: (empty)
+
+def test_join_unicode() -> int:
+    """Test join() with non-ASCII pieces and separator"""
+    words: list[str] = ["été", "", "ü"]
+    return len("·".join(words))  # Expected: 6
+
+def test_accumulate_range() -> int:
+    """Test a for-range loop that only appends to a string"""
+    s: str = "["
+    for i in range(1000):
+        s = s + str(i) + ","
+    s = s + "]"
+    return len(s)  # Expected: 3892
+
+def test_accumulate_aug_assign() -> str:
+    """Test += on a string inside a for-list loop"""
+    words: list[str] = ["a", "bb", "ccc"]
+    s: str = ""
+    for w in words:
+        s += w
+        s += "."
+    return s  # Expected: a.bb.ccc.
+
+def test_accumulate_nested() -> str:
+    """Test appends in a nested loop and a branch"""
+    s: str = ""
+    i: int = 0
+    while i < 4:
+        for j in range(i):
+            if j % 2 == 0:
+                s = s + "e"
+            else:
+                s = s + "o"
+        s = s + "|"
+        i = i + 1
+    return s  # Expected: |e|eo|eoe|
+
+def test_accumulate_read_in_loop() -> int:
+    """Test a loop that also reads the string it extends"""
+    s: str = ""
+    total: int = 0
+    for i in range(50):
+        s = s + "xy"
+        total = total + len(s)
+    return total  # Expected: 2550
+
+def test_accumulate_unicode() -> int:
+    """Test searching a non-ASCII string built in a loop"""
+    s: str = ""
+    for i in range(100):
+        s = s + "aé"
+    return s.find("éé") + s.count("éa") + len(s)  # Expected: -1 + 99 + 200
+
 def main() -> int:
     failed: int = 0
 
@@ -286,6 +413,65 @@ def main() -> int:
         print(34)
         failed = failed + 1
 
+    if test_upper_grows() != "STRASSE":
+        print(44)
+        failed = failed + 1
+    if test_lower_long() != 1200:
+        print(45)
+        failed = failed + 1
+    if test_find_unicode() != 6:
+        print(35)
+        failed = failed + 1
+    if test_find_long() != 66:
+        print(36)
+        failed = failed + 1
+    if test_count_char() != 18:
+        print(37)
+        failed = failed + 1
+    if test_count_overlapping() != 3:
+        print(38)
+        failed = failed + 1
+    if test_count_empty() != 6:
+        print(39)
+        failed = failed + 1
+    if test_replace_many() != "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx":
+        print(40)
+        failed = failed + 1
+    if test_strip_form_feed() != "hello":
+        print(41)
+        failed = failed + 1
+    if test_isdigit_long() != True:
+        print(42)
+        failed = failed + 1
+    if test_isalpha_long_false() != False:
+        print(43)
+        failed = failed + 1
+
+    if test_join_words() != "alpha, beta, gamma":
+        print(46)
+        failed = failed + 1
+    if test_join_empty() != "":
+        print(47)
+        failed = failed + 1
+    if test_join_unicode() != 6:
+        print(48)
+        failed = failed + 1
+    if test_accumulate_range() != 3892:
+        print(49)
+        failed = failed + 1
+    if test_accumulate_aug_assign() != "a.bb.ccc.":
+        print(50)
+        failed = failed + 1
+    if test_accumulate_nested() != "|e|eo|eoe|":
+        print(51)
+        failed = failed + 1
+    if test_accumulate_read_in_loop() != 2550:
+        print(52)
+        failed = failed + 1
+    if test_accumulate_unicode() != 298:
+        print(53)
+        failed = failed + 1
+
     if failed == 0:
         print(0)
     else:
@@ -149,6 +149,33 @@ def test_unicode_programming() -> int:
     print(s)
     return len(s)  # Expected: 7
 
+# ============ Long string indexing tests ============
+
+def test_unicode_index_long() -> int:
+    """Test indexing a long non-ASCII string built at runtime"""
+    piece: str = "aé€😀"
+    s: str = ""
+    i: int = 0
+    while i < 50:
+        s = s + piece
+        i = i + 1
+    # Every index agrees with the same string written as a literal
+    lit: str = "aé€😀aé€😀aé€😀aé€😀aé€😀aé€😀aé€😀aé€😀aé€😀aé€😀aé€😀aé€😀aé€😀aé€😀aé€😀aé€😀aé€😀aé€😀aé€😀aé€😀"
+    matches: int = 0
+    i = len(s) - 1
+    while i >= 0:
+        if s[i] == piece[i % 4]:
+            matches = matches + 1
+        if i < len(lit) and lit[i] == s[i]:
+            matches = matches + 1
+        i = i - 7
+    return matches  # Expected: 40 (29 + 11)
+
+def test_unicode_len_long() -> int:
+    """Test len() on a long non-ASCII string"""
+    s: str = "Привет, мир! Привет, мир! Привет, мир! Привет, мир! Привет, мир! Привет, мир!"
+    return len(s) + len(s)  # Expected: 154
+
 def main() -> int:
     failed: int = 0
 
@@ -232,6 +259,14 @@ def main() -> int:
         print(22)
         failed = failed + 1
 
+    # Long strings
+    if test_unicode_index_long() != 40:
+        print(23)
+        failed = failed + 1
+    if test_unicode_len_long() != 154:
+        print(24)
+        failed = failed + 1
+
     if failed == 0:
         print(0)
     else:
@@ -8,7 +8,17 @@ from basic.classes.class_simple import Point
 from basic.primitives.operators import test_add, test_sub, test_mult, test_mod
 from basic.primitives.operators import test_eq, test_neq, test_lt, test_lte, test_gt, test_gte
 from basic.primitives.aug_assign import test_add_assign, test_sub_assign, test_mult_assign, test_mod_assign, test_compound_aug
+from basic.primitives.aug_assign import test_str_add_assign
 from basic.collections.list_advanced import list_len, list_sum, create_and_access, nested_access
+from basic.collections.list_advanced import guarded_subscripts, rebound_subscripts
+from basic.collections.list_typed import test_float_list_ops, test_bool_list_ops, test_str_list_ops
+from basic.collections.list_typed import test_class_list_ops, test_print_typed_lists
+from basic.collections.dict_set import test_dict_int_keys, test_dict_str_keys, test_dict_membership
+from basic.collections.dict_set import test_dict_pop_and_views, test_dict_key_error, test_dict_object_values
+from basic.collections.dict_set import test_set_ops, test_set_str_iteration, test_print_dicts
+from basic.primitives.conversions import test_int_to_str, test_float_to_str, test_str_to_int
+from basic.primitives.conversions import test_str_to_float, test_numeric_casts, test_conversion_errors
+from basic.primitives.conversions import test_print_number_lists
 from basic.control_flow.edge_cases import expr_stmt, nested_if, count_to_limit, in_range, chained_compare
 from basic.classes.complex_types import test_class_in_class, test_chained_assign, test_nested_method
 from basic.classes.complex_types import test_multiple_chained, test_list_set, test_list_of_class
@@ -16,6 +26,8 @@ from basic.classes.complex_types import test_list_element_modify, test_deep_nest
 from basic.classes.string_repr import test_str_only, test_repr_only, test_both_str_and_repr
 from basic.classes.string_repr import test_str_with_internal_print, test_repr_with_internal_print
 from basic.classes.string_repr import test_nested_with_str, test_multiple_instances, test_str_in_expression
+from basic.classes.escape import test_local_counter, test_object_per_iteration, test_escape_into_list
+from basic.classes.escape import test_escape_by_return, test_escape_into_field, test_local_range
 from datastructure.hashmap import test_hashmap_basic, test_hashmap_update, test_hashmap_contains
 from datastructure.hashset import test_hashset_basic, test_hashset_contains
 from datastructure.bst import test_bst_insert, test_bst_contains
@@ -52,13 +64,23 @@ from basic.primitives.magic_methods_test import test_custom_str_len, test_custom
 from basic.iterators.iterator_tests import test_for_range_one_arg, test_for_range_two_args, test_for_range_three_args
 from basic.iterators.iterator_tests import test_for_list_basic, test_for_list_modify
 from basic.iterators.iterator_tests import test_for_nested_range, test_for_nested_list, test_for_nested_mixed, test_for_triple_nested
+from basic.iterators.iterator_tests import test_for_range_negative_step, test_for_range_empty, test_for_range_rebind_target
+from basic.iterators.iterator_tests import test_for_range_stop_evaluated_once, test_for_range_early_return, test_for_range_variable_step
+from basic.iterators.iterator_tests import test_for_range_near_int_limits
+from basic.iterators.iterator_tests import test_for_list_str, test_for_list_float, test_for_list_bool
+from basic.iterators.iterator_tests import test_for_list_empty, test_for_list_append_during
 from basic.iterators.iter_next_tests import test_iter_next_basic, test_iter_next_all_elements, test_iter_range
 from basic.primitives.bytearray_empty import test_bytearray_empty_constructor, test_bytearray_empty_then_append
+from basic.primitives.bytes_bulk_test import test_bytes_concat, test_bytes_slice, test_bytes_slice_open
+from basic.primitives.bytes_bulk_test import test_bytes_slice_negative, test_bytes_slice_clamped, test_bytes_find, test_bytes_count
+from basic.primitives.bytes_bulk_test import test_bytearray_extend, test_bytearray_zeros, test_bytearray_slice, test_bytearray_find
 from basic.primitives.float_test import test_float_literal, test_float_add, test_float_sub, test_float_mult
 from basic.primitives.float_test import test_float_div, test_int_div_returns_float, test_mixed_add, test_float_neg
 from basic.primitives.float_test import test_float_gt, test_float_lt, test_float_eq
 from basic.primitives.float_test import test_float_truthy, test_float_falsy
 from basic.primitives.float_test import test_float_floordiv, test_float_mod, test_float_pow, test_print_float
+from basic.primitives.const_fold import test_fold_arith, test_fold_fib, test_fold_global, test_fold_loops
+from basic.primitives.const_fold import test_fold_str, test_fold_float, test_fold_bool, test_fold_runtime_arg
 from basic.primitives.str_methods_test import main as str_methods_main
 from basic.primitives.str_unicode_test import main as str_unicode_main
 
@@ -105,6 +127,7 @@ def test() -> int:
     print(test_mult_assign())  # 20
     print(test_mod_assign())   # 1
     print(test_compound_aug()) # 25
+    print(test_str_add_assign())  # abcdabcd
 
     # Advanced list operations
     nums: list[int] = [1, 2, 3, 4, 5]
@@ -112,6 +135,33 @@ def test() -> int:
     print(list_sum(nums))        # 15
     print(create_and_access())   # 60
     print(nested_access(nums, 2)) # 3
+    print(guarded_subscripts())   # 199212
+    print(rebound_subscripts())   # 91
+
+    # Unboxed list storage per element type
+    print(test_float_list_ops())    # 1
+    print(test_bool_list_ops())     # 5
+    print(test_str_list_ops())      # 5555
+    print(test_class_list_ops())    # 53
+    print(test_print_typed_lists()) # 1
+    print(test_dict_int_keys())      # 328401
+    print(test_dict_str_keys())      # 241
+    print(test_dict_membership())    # 111
+    print(test_dict_pop_and_views()) # 32433
+    print(test_dict_key_error())     # 42
+    print(test_dict_object_values()) # 53
+    print(test_set_ops())            # 116
+    print(test_set_str_iteration())  # 1008
+    print(test_print_dicts())        # 1
+
+    # Number formatting and parsing
+    print(test_int_to_str())         # 30
+    print(test_float_to_str())       # 19
+    print(test_str_to_int())         # -951
+    print(test_str_to_float())       # 1
+    print(test_numeric_casts())      # 11
+    print(test_conversion_errors())  # 111
+    print(test_print_number_lists()) # 1
 
     # Edge case tests
     print(expr_stmt())           # 5
@@ -146,6 +196,14 @@ def test() -> int:
     print(test_multiple_instances()) # 2 (prints two Point instances)
     print(test_str_in_expression())  # 1 (prints Point and field value)
 
+    # Escape analysis tests - stack-allocated and escaping objects
+    print(test_local_counter())          # 90
+    print(test_object_per_iteration())   # 14850
+    print(test_escape_into_list())       # 1234
+    print(test_escape_by_return())       # 4321
+    print(test_escape_into_field())      # 14
+    print(test_local_range(3))           # 158
+
     # Data structure tests - HashMap
     print(test_hashmap_basic())      # 200
     print(test_hashmap_update())     # 999
@@ -307,6 +365,22 @@ def test() -> int:
     print(test_for_nested_mixed())       # 1
     print(test_for_triple_nested())      # 1
 
+    # Iterator tests - counted range loops
+    print(test_for_range_negative_step())       # 1
+    print(test_for_range_empty())               # 1
+    print(test_for_range_rebind_target())       # 1
+    print(test_for_range_stop_evaluated_once()) # 1
+    print(test_for_range_early_return())        # 1
+    print(test_for_range_variable_step())       # 1
+    print(test_for_range_near_int_limits())     # 1
+
+    # Iterator tests - indexed list loops
+    print(test_for_list_str())           # 1
+    print(test_for_list_float())         # 1
+    print(test_for_list_bool())          # 1
+    print(test_for_list_empty())         # 1
+    print(test_for_list_append_during()) # 1
+
     # iter() and next() builtin tests
     print(test_iter_next_basic())        # 30
     print(test_iter_next_all_elements()) # 15
@@ -316,6 +390,19 @@ def test() -> int:
     print(test_bytearray_empty_constructor()) # 0
     print(test_bytearray_empty_then_append()) # 2
 
+    # Bulk bytes and bytearray tests
+    print(test_bytes_concat())           # 5099
+    print(test_bytes_slice())            # 5119
+    print(test_bytes_slice_open())       # 225
+    print(test_bytes_slice_negative())   # 2108
+    print(test_bytes_slice_clamped())    # 20
+    print(test_bytes_find())             # 1608
+    print(test_bytes_count())            # 37
+    print(test_bytearray_extend())       # 1005048
+    print(test_bytearray_zeros())        # 1607
+    print(test_bytearray_slice())        # 2188
+    print(test_bytearray_find())         # 34
+
     # Float type tests
     print(test_float_literal())              # 1
     print(test_float_add())                  # 1
@@ -335,7 +422,17 @@ def test() -> int:
     print(test_float_pow())                  # 1
     print(test_print_float())                # prints 3.14, returns 1
 
+    # Constant folding tests
+    print(test_fold_arith())                 # 34
+    print(test_fold_fib())                   # 75025
+    print(test_fold_global())                # 7050 (fib(20) + sum_squares(10))
+    print(test_fold_loops())                 # 111
+    print(test_fold_str())                   # <folded>
+    print(test_fold_float())                 # 10.0
+    print(test_fold_bool())                  # True
+    print(test_fold_runtime_arg(12))         # 149 (not folded: n is unknown)
+
     # String methods tests (Phase 3: Unicode support)
-    print(str_methods_main())                # 0 (all 34 tests pass)
+    print(str_methods_main())                # 0 (all 53 tests pass)
     print(str_unicode_main())                # 0 (all 15 tests pass)
     return 0
@@ -17,6 +17,10 @@ class NetworkError(Exception):
 class TimeoutError(NetworkError):
     code: int
 
+# Subclass of an exception the runtime raises
+class ParseError(ValueError):
+    code: int
+
 def test_exception_no_message() -> int:
     """Exception raised with no message (empty args)"""
     try:
@@ -106,6 +110,42 @@ def test_multiple_handlers_same_level() -> int:
     print(2)
     return 0
 
+def test_sibling_hierarchy_skipped() -> int:
+    """Handlers for another hierarchy do not catch"""
+    try:
+        raise LeafError("leaf")
+    except NetworkError:
+        print(0)
+    except TimeoutError:
+        print(0)
+    except MiddleError:
+        print(1)
+    print(2)
+    return 0
+
+def test_catch_builtin_subclass() -> int:
+    """Subclass of a builtin error is caught by the builtin"""
+    try:
+        raise ParseError("parse")
+    except KeyError:
+        print(0)
+    except ValueError:
+        print(1)
+    print(2)
+    return 0
+
+def test_runtime_error_skips_subclass() -> int:
+    """Error raised by the runtime is not caught by a subclass handler"""
+    try:
+        n: int = int("abc")
+        print(n)
+    except ParseError:
+        print(0)
+    except ValueError:
+        print(1)
+    print(2)
+    return 0
+
 def test() -> int:
     print("=== Exception Types Tests ===")
 
@@ -136,5 +176,14 @@ def test() -> int:
     print("Test: multiple handlers same level")
     test_multiple_handlers_same_level()
 
+    print("Test: sibling hierarchy skipped")
+    test_sibling_hierarchy_skipped()
+
+    print("Test: catch builtin subclass")
+    test_catch_builtin_subclass()
+
+    print("Test: runtime error skips subclass")
+    test_runtime_error_skips_subclass()
+
     print("=== Exception Types Tests Complete ===")
     return 0
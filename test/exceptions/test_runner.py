@@ -153,6 +153,47 @@ def test_nested_finally() -> int:
     print(4)
     return 0
 
+def test_raise_in_range_loop() -> int:
+    """Test that a raise in a range loop stops the loop"""
+    try:
+        for i in range(10):
+            if i == 3:
+                raise ValueError("three")
+            print(i)
+    except ValueError:
+        print(-1)
+    print(4)
+    return 0
+
+def count_until_raise(n: int) -> int:
+    for i in range(0, n * 2, 2):
+        if i == n:
+            raise MyError("half")
+        print(i)
+    return 0
+
+def test_raise_in_callee_range_loop() -> int:
+    """Test that a raise in a callee's range loop stops the loop"""
+    try:
+        count_until_raise(6)
+    except MyError:
+        print(-1)
+    print(7)
+    return 0
+
+def test_raise_in_list_loop() -> int:
+    """Test that a raise in a list loop stops the loop"""
+    items: list[int] = [5, 6, 7, 8]
+    try:
+        for item in items:
+            if item == 7:
+                raise ErrorA("seven")
+            print(item)
+    except ErrorA:
+        print(-1)
+    print(9)
+    return 0
+
 def test() -> int:
     print("=== Exception Handling Tests ===")
 
@@ -195,6 +236,15 @@ def test() -> int:
     print("Test: nested finally")
     test_nested_finally()
 
+    print("Test: raise in range loop")
+    test_raise_in_range_loop()
+
+    print("Test: raise in callee range loop")
+    test_raise_in_callee_range_loop()
+
+    print("Test: raise in list loop")
+    test_raise_in_list_loop()
+
     # Run additional test modules
     nested_try.test()
     exception_reraise.test()
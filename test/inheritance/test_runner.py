@@ -16,6 +16,9 @@ from inheritance.complex_inherit import test_list_of_derived
 from inheritance.complex_inherit import test_derived_uses_parent_method
 from inheritance.complex_inherit import test_modify_inherited_field
 from inheritance.super_method_call import test_super_method_call, test_super_paramless_method, test_super_preserves_self
+from inheritance.virtual_dispatch import test_override_through_self, test_override_two_levels
+from inheritance.virtual_dispatch import test_partial_override, test_base_instance
+from inheritance.virtual_dispatch import test_dispatch_in_loop
 
 
 def test() -> int:
@@ -76,4 +79,12 @@ def test() -> int:
     print(test_super_paramless_method())   # 21
     print(test_super_preserves_self())     # 20
 
+    # Virtual dispatch tests
+    print("=== Virtual Dispatch Tests ===")
+    print(test_override_through_self())    # 94
+    print(test_override_two_levels())      # 244
+    print(test_partial_override())         # 3
+    print(test_base_instance())            # 0
+    print(test_dispatch_in_loop())         # 640
+
     return 0
@@ -0,0 +1,78 @@
+# Tests for overridden methods called through self in a base class method
+
+class Shape:
+    scale: int
+
+    def __init__(self, scale: int) -> None:
+        self.scale = scale
+
+    def area(self) -> int:
+        return 0
+
+    def sides(self) -> int:
+        return 0
+
+    def describe(self) -> int:
+        # Template method: area() and sides() are the subclass's
+        return self.area() * 10 + self.sides()
+
+
+class Square(Shape):
+    def __init__(self, scale: int) -> None:
+        super().__init__(scale)
+
+    def area(self) -> int:
+        return self.scale * self.scale
+
+    def sides(self) -> int:
+        return 4
+
+
+class Cube(Square):
+    def __init__(self, scale: int) -> None:
+        super().__init__(scale)
+
+    def area(self) -> int:
+        # The square's area, six times over
+        return super().area() * 6
+
+
+class Triangle(Shape):
+    def __init__(self, scale: int) -> None:
+        super().__init__(scale)
+
+    def sides(self) -> int:
+        return 3
+
+
+def test_override_through_self() -> int:
+    """Test that a base method calls the subclass override"""
+    s: Square = Square(3)
+    # area 9, 4 sides
+    return s.describe()
+
+def test_override_two_levels() -> int:
+    """Test that the most derived override wins"""
+    c: Cube = Cube(2)
+    # area 4 * 6 = 24, 4 sides from Square
+    return c.describe()
+
+def test_partial_override() -> int:
+    """Test that methods a subclass does not override come from the base"""
+    t: Triangle = Triangle(5)
+    # area 0 from Shape, 3 sides
+    return t.describe()
+
+def test_base_instance() -> int:
+    """Test that base instances still run the base methods"""
+    s: Shape = Shape(7)
+    return s.describe()
+
+def test_dispatch_in_loop() -> int:
+    """Test overridden calls repeated through self"""
+    c: Cube = Cube(1)
+    total: int = 0
+    for i in range(10):
+        total = total + c.describe()
+    # describe is 6 * 10 + 4 = 64
+    return total
@@ -1,3 +1,3 @@
 # bytearray() with wrong argument type
 def main() -> None:
-    ba = bytearray(42)  # bytearray() argument must be bytes
+    ba = bytearray(1.5)  # bytearray() argument must be bytes or int
@@ -0,0 +1,4 @@
+# range() in a for loop with a literal zero step
+def main() -> None:
+    for i in range(0, 10, 0):  # range() step argument must not be zero
+        print(i)
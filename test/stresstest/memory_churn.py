@@ -0,0 +1,58 @@
+# Allocation churn - temporaries that the compiler frees as it goes
+from rng.random import RNG
+
+def churn_concat(iterations: int) -> int:
+    # Intermediate results of chained concatenation are temporaries
+    total: int = 0
+    i: int = 0
+    while i < iterations:
+        s: str = "ab" + "cd" + "ef" + "gh"
+        total = total + len(s)
+        i = i + 1
+    return total
+
+
+def churn_compare(iterations: int) -> int:
+    # Concatenations consumed by a comparison are temporaries too
+    hits: int = 0
+    i: int = 0
+    while i < iterations:
+        if "foo" + "bar" == "foobar":
+            hits = hits + 1
+        i = i + 1
+    return hits
+
+
+def churn_range_iterators(iterations: int) -> int:
+    # Iterating a range variable allocates (and frees) an iterator per loop
+    r = range(10)
+    total: int = 0
+    i: int = 0
+    while i < iterations:
+        for x in r:
+            total = total + x
+        i = i + 1
+    return total
+
+
+def churn_nested_range(n: int) -> int:
+    # The same range iterated inside itself keeps independent cursors
+    r = range(n)
+    total: int = 0
+    for a in r:
+        for b in r:
+            total = total + a * b
+    return total
+
+
+def churn_lists(iterations: int, seed: int) -> int:
+    # Short-lived lists built and summed in a loop
+    rng: RNG = RNG(seed)
+    checksum: int = 0
+    i: int = 0
+    while i < iterations:
+        items: list[int] = [rng.rand_range(0, 100), rng.rand_range(0, 100), rng.rand_range(0, 100)]
+        for v in items:
+            checksum = (checksum + v) % 1000000007
+        i = i + 1
+    return checksum
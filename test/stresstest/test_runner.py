@@ -6,6 +6,8 @@ from stresstest.deep_nesting import test_four_level_access, test_four_level_modi
 from stresstest.deep_nesting import test_list_in_list_in_class, test_list_in_list_modify
 from stresstest.deep_nesting import test_complex_expression, test_nested_loop_access, test_modify_in_loop
 from stresstest.stress_test import run_all_stress_tests
+from stresstest.memory_churn import churn_concat, churn_compare, churn_range_iterators
+from stresstest.memory_churn import churn_nested_range, churn_lists
 
 def test() -> int:
     # Deep nesting tests - 3-level class nesting (Container->Box->Item)
@@ -38,4 +40,11 @@ def test() -> int:
     # Stress tests - large scale random testing
     print(run_all_stress_tests())        # 26 (number of stress tests passed)
 
+    # Allocation churn - temporaries freed by the compiler
+    print(churn_concat(100000))          # 800000
+    print(churn_compare(100000))         # 100000
+    print(churn_range_iterators(10000))  # 450000
+    print(churn_nested_range(20))        # 36100
+    print(churn_lists(10000, 7))
+
     return 0
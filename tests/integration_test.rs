@@ -168,6 +168,184 @@ fn test_pyrun_main_program() {
         .expect("Failed to run pyrun");
 }
 
+#[test]
+fn test_pyrun_exception_model_polling() {
+    let main_py = test_dir().join("main.py");
+
+    // Both exception models must produce identical program output
+    let polling_output = cargo_bin_cmd!("pyrun")
+        .args([main_py.to_str().unwrap(), "--exception-model", "polling"])
+        .output()
+        .expect("Failed to run pyrun with polling exception model");
+    assert!(
+        polling_output.status.success(),
+        "pyrun --exception-model polling failed: {}",
+        String::from_utf8_lossy(&polling_output.stderr)
+    );
+
+    let may_raise_output = cargo_bin_cmd!("pyrun")
+        .args([main_py.to_str().unwrap(), "--exception-model", "may-raise"])
+        .output()
+        .expect("Failed to run pyrun with may-raise exception model");
+    assert!(may_raise_output.status.success());
+
+    assert_eq!(
+        String::from_utf8_lossy(&polling_output.stdout),
+        String::from_utf8_lossy(&may_raise_output.stdout),
+        "Exception models disagree on main.py output"
+    );
+}
+
+#[test]
+fn test_pyrun_invalid_exception_model() {
+    let simple_py = test_dir().join("exceptions/simple.py");
+
+    cargo_bin_cmd!("pyrun")
+        .args([simple_py.to_str().unwrap(), "--exception-model", "setjmp"])
+        .assert()
+        .failure()
+        .stderr(predicate::str::contains("Unknown exception model"));
+}
+
+#[test]
+fn test_pyrun_inline_report() {
+    let main_py = test_dir().join("main.py");
+
+    let output = cargo_bin_cmd!("pyrun")
+        .args([main_py.to_str().unwrap(), "--inline-report"])
+        .output()
+        .expect("Failed to run pyrun with --inline-report");
+    assert!(
+        output.status.success(),
+        "pyrun --inline-report failed: {}",
+        String::from_utf8_lossy(&output.stderr)
+    );
+
+    // The report goes to stderr, leaving stdout to the program
+    let stdout = String::from_utf8_lossy(&output.stdout);
+    assert!(!stdout.contains("=== Inline Report ==="));
+    let stderr = String::from_utf8_lossy(&output.stderr);
+    assert!(stderr.contains("=== Inline Report ==="));
+
+    // The list accessors are trivial and must never survive as calls
+    for accessor in [
+        "__pyc___builtin___list___len__",
+        "__pyc___builtin___list___getitem__",
+    ] {
+        let line = stderr
+            .lines()
+            .find(|line| line.ends_with(accessor))
+            .unwrap_or_else(|| panic!("{accessor} missing from inline report"));
+        assert!(line.starts_with("inlined"), "not inlined: {line}");
+    }
+}
+
+#[test]
+fn test_pyrun_opt_levels() {
+    let main_py = test_dir().join("main.py");
+
+    // Unoptimized and aggressively optimized builds must agree
+    let mut outputs = Vec::new();
+    for level in ["-O0", "-O3"] {
+        let output = cargo_bin_cmd!("pyrun")
+            .args([main_py.to_str().unwrap(), level])
+            .output()
+            .expect("Failed to run pyrun");
+        assert!(
+            output.status.success(),
+            "pyrun {level} failed: {}",
+            String::from_utf8_lossy(&output.stderr)
+        );
+        outputs.push(String::from_utf8_lossy(&output.stdout).to_string());
+    }
+    assert_eq!(
+        outputs[0], outputs[1],
+        "-O0 and -O3 disagree on main.py output"
+    );
+}
+
+#[test]
+fn test_pyrun_invalid_opt_level() {
+    let simple_py = test_dir().join("exceptions/simple.py");
+
+    cargo_bin_cmd!("pyrun")
+        .args([simple_py.to_str().unwrap(), "-O7"])
+        .assert()
+        .failure()
+        .stderr(predicate::str::contains("Unknown optimization level"));
+}
+
+#[test]
+fn test_pyrun_time_passes() {
+    let simple_py = test_dir().join("exceptions/simple.py");
+
+    cargo_bin_cmd!("pyrun")
+        .args([simple_py.to_str().unwrap(), "--time-passes"])
+        .assert()
+        .success()
+        .stderr(predicate::str::contains("=== Time Report ==="))
+        .stderr(predicate::str::contains("optimize"));
+}
+
+#[test]
+fn test_pyrun_module_cache() {
+    let main_py = test_dir().join("main.py");
+    let cache_dir = TempDir::new().unwrap();
+
+    // The cold run fills the cache, the warm run reuses the executable
+    let mut outputs = Vec::new();
+    for _ in 0..2 {
+        let output = cargo_bin_cmd!("pyrun")
+            .arg(&main_py)
+            .arg("--cache-dir")
+            .arg(cache_dir.path())
+            .arg("--cache-stats")
+            .output()
+            .expect("Failed to run pyrun");
+        assert!(output.status.success(), "pyrun failed to execute main.py");
+        outputs.push(output);
+    }
+    assert_eq!(outputs[0].stdout, outputs[1].stdout);
+    let stats = String::from_utf8_lossy(&outputs[1].stderr);
+    assert!(stats.contains("1 hits, 1 misses, 1 executables"), "{stats}");
+
+    let modules = std::fs::read_dir(cache_dir.path().join("modules"))
+        .unwrap()
+        .count();
+    assert!(
+        modules > 1,
+        "expected one cache entry per module, found {modules}"
+    );
+}
+
+#[test]
+fn test_pyrun_profile_flags_conflict() {
+    let simple_py = test_dir().join("exceptions/simple.py");
+
+    cargo_bin_cmd!("pyrun")
+        .args([
+            simple_py.to_str().unwrap(),
+            "--profile-generate",
+            "prof",
+            "--profile-use",
+            "app.profdata",
+        ])
+        .assert()
+        .failure()
+        .stderr(predicate::str::contains("cannot be used with"));
+}
+
+#[test]
+fn test_pyrun_invalid_gc_mode() {
+    let simple_py = test_dir().join("exceptions/simple.py");
+
+    cargo_bin_cmd!("pyrun")
+        .args([simple_py.to_str().unwrap(), "--gc", "refcount"])
+        .assert()
+        .failure()
+        .stderr(predicate::str::contains("Unknown GC mode"));
+}
+
 #[test]
 fn test_pyrun_riscv64() {
     // Skip if QEMU is not available
@@ -325,6 +503,748 @@ fn test_pycc_compile_x86_64() {
     assert!(stdout.contains("1") && stdout.contains("2"));
 }
 
+#[test]
+fn test_pycc_stress_peak_rss() {
+    let temp_dir = TempDir::new().unwrap();
+    let output_path = temp_dir.path().join("main");
+
+    cargo_bin_cmd!("pycc")
+        .args([
+            test_dir().join("main.py").to_str().unwrap(),
+            "-o",
+            output_path.to_str().unwrap(),
+        ])
+        .assert()
+        .success();
+
+    let output = std::process::Command::new(&output_path)
+        .env("PYC_ALLOC_STATS", "1")
+        .output()
+        .expect("Failed to run compiled executable");
+    assert!(output.status.success());
+
+    let stderr = String::from_utf8_lossy(&output.stderr);
+    let stat = |name: &str| -> i64 {
+        stderr
+            .lines()
+            .find_map(|line| line.strip_prefix(name))
+            .and_then(|rest| rest.split_whitespace().next())
+            .and_then(|value| value.parse().ok())
+            .unwrap_or_else(|| panic!("'{name}' missing from allocator stats:\n{stderr}"))
+    };
+
+    // Reported for tracking; the churn tests must actually recycle memory
+    eprintln!("stress test peak RSS: {} KiB", stat("peak rss:"));
+    assert!(stat("frees:") > 0);
+    assert!(stat("pool reuses:") > 0);
+}
+
+#[test]
+fn test_pycc_links_icu_only_when_used() {
+    let temp_dir = TempDir::new().unwrap();
+    let build = |name: &str, source: &str| -> (String, Vec<u8>) {
+        let source_path = temp_dir.path().join(format!("{name}.py"));
+        std::fs::write(&source_path, source).unwrap();
+        let output_path = temp_dir.path().join(name);
+        cargo_bin_cmd!("pycc")
+            .args([
+                source_path.to_str().unwrap(),
+                "-o",
+                output_path.to_str().unwrap(),
+            ])
+            .assert()
+            .success();
+        let output = std::process::Command::new(&output_path)
+            .output()
+            .expect("Failed to run compiled executable");
+        assert!(output.status.success());
+        let stdout = String::from_utf8_lossy(&output.stdout).into_owned();
+        (stdout, std::fs::read(&output_path).unwrap())
+    };
+    let has_icu = |binary: &[u8]| binary.windows(5).any(|w| w == b"icudt");
+
+    // No string operation reaches ICU: none of it is linked
+    let (stdout, hello) = build("hello", "print(\"hello\")\n");
+    assert_eq!(stdout, "hello\n");
+    assert!(!has_icu(&hello));
+
+    // Case mapping needs libicuuc, but not the ICU data library
+    let (stdout, upper) = build(
+        "upper",
+        "def main() -> None:\n\
+         \x20   word: str = \"straße\"\n\
+         \x20   print(word.upper())\n\
+         \n\
+         main()\n",
+    );
+    if has_icu(&upper) {
+        assert_eq!(stdout, "STRASSE\n");
+        assert!(
+            upper.len() < 8 << 20,
+            "{} bytes: the ICU data was linked",
+            upper.len()
+        );
+    }
+}
+
+#[test]
+fn test_pycc_profile_guided_optimization() {
+    // Skip if llvm-profdata is not available
+    if std::process::Command::new("llvm-profdata")
+        .arg("--version")
+        .output()
+        .is_err()
+    {
+        eprintln!("Skipping PGO test: llvm-profdata not available");
+        return;
+    }
+
+    let temp_dir = TempDir::new().unwrap();
+    let source = temp_dir.path().join("collatz.py");
+    std::fs::write(
+        &source,
+        "def steps(n: int) -> int:\n\
+         \x20   count: int = 0\n\
+         \x20   while n != 1:\n\
+         \x20       if n % 2 == 0:\n\
+         \x20           n = n // 2\n\
+         \x20       else:\n\
+         \x20           n = 3 * n + 1\n\
+         \x20       count += 1\n\
+         \x20   return count\n\
+         \n\
+         def main() -> None:\n\
+         \x20   total: int = 0\n\
+         \x20   for i in range(1, 20000):\n\
+         \x20       total += steps(i)\n\
+         \x20   print(total)\n\
+         \n\
+         main()\n",
+    )
+    .unwrap();
+    let build = |name: &str, flags: &[&std::ffi::OsStr]| -> (String, Vec<u8>) {
+        let output_path = temp_dir.path().join(name);
+        cargo_bin_cmd!("pycc")
+            .arg(&source)
+            .args(flags)
+            .arg("-o")
+            .arg(&output_path)
+            .assert()
+            .success();
+        let output = std::process::Command::new(&output_path)
+            .current_dir(temp_dir.path())
+            .output()
+            .expect("Failed to run compiled executable");
+        assert!(output.status.success());
+        let stdout = String::from_utf8_lossy(&output.stdout).into_owned();
+        (stdout, std::fs::read(&output_path).unwrap())
+    };
+
+    // The instrumented build writes a raw profile into the directory
+    let raw_dir = temp_dir.path().join("prof");
+    let (stdout, _) = build(
+        "collatz_gen",
+        &["--profile-generate".as_ref(), raw_dir.as_os_str()],
+    );
+    assert_eq!(stdout, "1834604\n");
+    let raw_profiles = std::fs::read_dir(&raw_dir)
+        .expect("no raw profile directory")
+        .filter(|entry| {
+            entry
+                .as_ref()
+                .is_ok_and(|entry| entry.path().extension().is_some_and(|ext| ext == "profraw"))
+        })
+        .count();
+    assert!(raw_profiles > 0, "the instrumented build wrote no profile");
+
+    let profdata = temp_dir.path().join("collatz.profdata");
+    let status = std::process::Command::new("llvm-profdata")
+        .arg("merge")
+        .arg("-o")
+        .arg(&profdata)
+        .arg(&raw_dir)
+        .status()
+        .expect("Failed to run llvm-profdata");
+    assert!(status.success());
+
+    // The profile changes the optimized code but not what it computes
+    let (plain_stdout, plain) = build("collatz", &[]);
+    let (pgo_stdout, pgo) = build(
+        "collatz_pgo",
+        &["--profile-use".as_ref(), profdata.as_os_str()],
+    );
+    assert_eq!(plain_stdout, "1834604\n");
+    assert_eq!(pgo_stdout, plain_stdout);
+    assert_ne!(plain, pgo, "--profile-use did not change the executable");
+}
+
+#[test]
+fn test_pycc_gc_mark_sweep() {
+    let temp_dir = TempDir::new().unwrap();
+    let default_path = temp_dir.path().join("main_nogc");
+    let gc_path = temp_dir.path().join("main_gc");
+    let main_py = test_dir().join("main.py");
+
+    cargo_bin_cmd!("pycc")
+        .args([
+            main_py.to_str().unwrap(),
+            "-o",
+            default_path.to_str().unwrap(),
+        ])
+        .assert()
+        .success();
+
+    // A small threshold forces many collections while the test suite runs
+    cargo_bin_cmd!("pycc")
+        .args([
+            main_py.to_str().unwrap(),
+            "-o",
+            gc_path.to_str().unwrap(),
+            "--gc",
+            "mark-sweep",
+            "--gc-threshold",
+            "65536",
+        ])
+        .assert()
+        .success();
+
+    let default_output = std::process::Command::new(&default_path)
+        .output()
+        .expect("Failed to run compiled executable");
+    assert!(default_output.status.success());
+
+    let gc_output = std::process::Command::new(&gc_path)
+        .env("PYC_GC_STATS", "1")
+        .output()
+        .expect("Failed to run compiled executable");
+    assert!(
+        gc_output.status.success(),
+        "GC build failed: {}",
+        String::from_utf8_lossy(&gc_output.stderr)
+    );
+
+    assert_eq!(
+        String::from_utf8_lossy(&default_output.stdout),
+        String::from_utf8_lossy(&gc_output.stdout),
+        "Collector changed main.py output"
+    );
+
+    let stderr = String::from_utf8_lossy(&gc_output.stderr);
+    let collections: i64 = stderr
+        .lines()
+        .find_map(|line| line.strip_prefix("collections:"))
+        .and_then(|rest| rest.trim().parse().ok())
+        .unwrap_or_else(|| panic!("'collections:' missing from GC stats:\n{stderr}"));
+    assert!(collections > 0);
+}
+
+#[test]
+fn test_pycc_unchecked() {
+    let temp_dir = TempDir::new().unwrap();
+    let main_py = test_dir().join("main.py");
+    let checked_path = temp_dir.path().join("main_checked");
+    let unchecked_path = temp_dir.path().join("main_unchecked");
+
+    for (path, extra) in [
+        (&checked_path, None),
+        (&unchecked_path, Some("--unchecked")),
+    ] {
+        cargo_bin_cmd!("pycc")
+            .args([main_py.to_str().unwrap(), "-o", path.to_str().unwrap()])
+            .args(extra)
+            .assert()
+            .success();
+    }
+
+    let checked = std::process::Command::new(&checked_path)
+        .output()
+        .expect("Failed to run compiled executable");
+    let unchecked = std::process::Command::new(&unchecked_path)
+        .output()
+        .expect("Failed to run compiled executable");
+    assert!(checked.status.success() && unchecked.status.success());
+    assert_eq!(
+        String::from_utf8_lossy(&checked.stdout),
+        String::from_utf8_lossy(&unchecked.stdout),
+        "--unchecked changed main.py output"
+    );
+
+    // A subscript the compiler cannot prove in range keeps its check by default
+    let source = temp_dir.path().join("out_of_range.py");
+    let exe = temp_dir.path().join("out_of_range");
+    std::fs::write(
+        &source,
+        "def main() -> None:\n\
+         \x20   nums: list[int] = [1, 2, 3]\n\
+         \x20   for i in range(len(nums) + 1):\n\
+         \x20       print(nums[i])\n\
+         \n\
+         main()\n",
+    )
+    .unwrap();
+    cargo_bin_cmd!("pycc")
+        .args([source.to_str().unwrap(), "-o", exe.to_str().unwrap()])
+        .assert()
+        .success();
+    let output = std::process::Command::new(&exe)
+        .output()
+        .expect("Failed to run compiled executable");
+    assert!(!output.status.success());
+    assert!(String::from_utf8_lossy(&output.stderr).contains("Index out of bounds: 3"));
+
+    // A product of non-negative values can wrap negative, so a guard on it
+    // keeps the check
+    std::fs::write(
+        &source,
+        "def main() -> None:\n\
+         \x20   nums: list[int] = [1, 2, 3]\n\
+         \x20   h: int = 1\n\
+         \x20   for i in range(13):\n\
+         \x20       h = h * 31 + 7\n\
+         \x20   if h < len(nums):\n\
+         \x20       print(nums[h])\n\
+         \n\
+         main()\n",
+    )
+    .unwrap();
+    cargo_bin_cmd!("pycc")
+        .args([source.to_str().unwrap(), "-o", exe.to_str().unwrap()])
+        .assert()
+        .success();
+    let output = std::process::Command::new(&exe)
+        .output()
+        .expect("Failed to run compiled executable");
+    assert!(!output.status.success());
+    assert!(String::from_utf8_lossy(&output.stderr)
+        .contains("Index out of bounds: -6778514380570217370"));
+}
+
+#[test]
+fn test_pyrun_reorder_fields() {
+    let temp_dir = TempDir::new().unwrap();
+    let source = temp_dir.path().join("layout.py");
+    std::fs::write(
+        &source,
+        "class Node:\n\
+         \x20   red: bool\n\
+         \x20   key: int\n\
+         \x20   seen: bool\n\
+         \x20   count: int\n\
+         \n\
+         \x20   def __init__(self, key: int) -> None:\n\
+         \x20       self.red = True\n\
+         \x20       self.key = key\n\
+         \x20       self.seen = False\n\
+         \x20       self.count = 0\n\
+         \n\
+         def main() -> None:\n\
+         \x20   node: Node = Node(7)\n\
+         \x20   for i in range(10):\n\
+         \x20       node.count = node.count + i\n\
+         \x20   print(node.key + node.count)\n\
+         \x20   print(node.red)\n\
+         \n\
+         main()\n",
+    )
+    .unwrap();
+
+    let output = cargo_bin_cmd!("pyrun")
+        .args([source.to_str().unwrap(), "--reorder-fields", "--emit-llvm"])
+        .output()
+        .expect("Failed to run pyrun with --reorder-fields");
+    assert!(output.status.success());
+    let stdout = String::from_utf8_lossy(&output.stdout);
+    assert!(
+        stdout.ends_with("52\nTrue\n"),
+        "unexpected output:\n{stdout}"
+    );
+
+    // Words first, the field used in the loop leading, then the bools packed
+    let report = stdout
+        .split("=== Class Layouts ===\n")
+        .nth(1)
+        .expect("--emit-llvm prints the class layouts");
+    let node: Vec<&str> = report
+        .lines()
+        .skip_while(|line| !line.contains("Node: "))
+        .take(5)
+        .collect();
+    assert!(
+        node[0].ends_with("Node: 24 bytes (declaration order: 32 bytes)"),
+        "{report}"
+    );
+    let fields: Vec<&str> = node[1..].iter().map(|line| line.trim()).collect();
+    assert_eq!(
+        fields,
+        [
+            "0  count: int",
+            "8  key: int",
+            "16  red: bool",
+            "17  seen: bool"
+        ]
+    );
+}
+
+#[test]
+fn test_pyrun_profile() {
+    let temp_dir = TempDir::new().unwrap();
+    let source = temp_dir.path().join("prof.py");
+    std::fs::write(
+        &source,
+        "def square(x: int) -> int:\n\
+         \x20   return x * x\n\
+         \n\
+         def never(x: int) -> int:\n\
+         \x20   return x + 1\n\
+         \n\
+         def main() -> None:\n\
+         \x20   total: int = 0\n\
+         \x20   for i in range(1000):\n\
+         \x20       total = total + square(i)\n\
+         \x20   words: list[str] = []\n\
+         \x20   while len(words) < 3:\n\
+         \x20       words.append(str(total))\n\
+         \x20   try:\n\
+         \x20       raise ValueError(\"bad\")\n\
+         \x20   except ValueError:\n\
+         \x20       total = total + 1\n\
+         \x20   print(total)\n\
+         \n\
+         main()\n",
+    )
+    .unwrap();
+    let prefix = temp_dir.path().join("run");
+
+    let output = cargo_bin_cmd!("pyrun")
+        .args([source.to_str().unwrap(), "--profile", "--no-cache"])
+        .env("PYC_PROFILE", &prefix)
+        .output()
+        .expect("Failed to run pyrun with --profile");
+    assert!(output.status.success());
+    assert_eq!(String::from_utf8_lossy(&output.stdout), "332833501\n");
+
+    let flat = std::fs::read_to_string(prefix.with_extension("txt")).unwrap();
+    assert!(flat.starts_with("# pyc profile\n"), "{flat}");
+    let calls = |site: &str| -> Option<u64> {
+        flat.lines()
+            .take_while(|line| !line.is_empty())
+            .find(|line| line.split_whitespace().last() == Some(site))
+            .and_then(|line| line.split_whitespace().next()?.parse().ok())
+    };
+    assert_eq!(calls("prof.square"), Some(1000), "{flat}");
+    assert_eq!(calls("prof.never"), Some(0), "{flat}");
+    assert_eq!(calls("prof.main:for1"), Some(1), "{flat}");
+    assert_eq!(calls("prof.main:while1"), Some(1), "{flat}");
+    assert!(flat.contains("# allocations by type"), "{flat}");
+    assert!(flat.contains("ValueError"), "{flat}");
+
+    let folded = std::fs::read_to_string(prefix.with_extension("folded")).unwrap();
+    assert!(
+        folded
+            .lines()
+            .any(|line| line.starts_with("prof.<module>;prof.main;prof.main:for1;prof.square ")),
+        "{folded}"
+    );
+
+    // Fed back, the flat profile marks the function the run never entered cold
+    let output = cargo_bin_cmd!("pyrun")
+        .arg(source.to_str().unwrap())
+        .arg("--profile-use")
+        .arg(prefix.with_extension("txt"))
+        .arg("--emit-llvm")
+        .output()
+        .expect("Failed to run pyrun with --profile-use");
+    assert!(output.status.success());
+    let stdout = String::from_utf8_lossy(&output.stdout);
+    assert!(stdout.ends_with("332833501\n"), "{stdout}");
+    let never = stdout
+        .lines()
+        .find(|line| line.starts_with("define") && line.contains("@__pyc_prof_never("))
+        .expect("never is defined");
+    let group = never.rsplit('#').next().unwrap().trim_end_matches(" {");
+    let attributes = stdout
+        .lines()
+        .find(|line| line.starts_with(&format!("attributes #{group} ")))
+        .unwrap();
+    assert!(attributes.contains("cold"), "{attributes}");
+}
+
+#[test]
+fn test_pycc_prange() {
+    let temp_dir = TempDir::new().unwrap();
+    let source = temp_dir.path().join("prange.py");
+    let exe = temp_dir.path().join("prange");
+    std::fs::write(
+        &source,
+        "def square_sum(n: int) -> int:\n\
+         \x20   total: int = 0\n\
+         \x20   for i in prange(n):\n\
+         \x20       total += i * i\n\
+         \x20   return total\n\
+         \n\
+         def main() -> None:\n\
+         \x20   n: int = 100000\n\
+         \x20   out: list[int] = []\n\
+         \x20   for i in range(n):\n\
+         \x20       out.append(0)\n\
+         \x20   for i in prange(n):\n\
+         \x20       out[i] = i * 2\n\
+         \x20   check: int = 0\n\
+         \x20   for v in out:\n\
+         \x20       check += v\n\
+         \x20   print(check)\n\
+         \x20   print(square_sum(n))\n\
+         \x20   words: list[str] = [\"a\", \"bb\", \"ccc\"]\n\
+         \x20   letters: int = 0\n\
+         \x20   for w in prange(words):\n\
+         \x20       letters += len(w)\n\
+         \x20   print(letters)\n\
+         \x20   try:\n\
+         \x20       for i in prange(1000):\n\
+         \x20           if i == 500:\n\
+         \x20               raise Exception(\"stop\")\n\
+         \x20   except Exception:\n\
+         \x20       print(\"caught\")\n\
+         \n\
+         main()\n",
+    )
+    .unwrap();
+    cargo_bin_cmd!("pycc")
+        .args([source.to_str().unwrap(), "-o", exe.to_str().unwrap()])
+        .assert()
+        .success();
+
+    for threads in ["1", "4"] {
+        let output = std::process::Command::new(&exe)
+            .env("PYC_THREADS", threads)
+            .output()
+            .expect("Failed to run compiled executable");
+        assert!(output.status.success());
+        assert_eq!(
+            String::from_utf8_lossy(&output.stdout),
+            "9999900000\n333328333350000\n6\ncaught\n",
+            "wrong prange output with PYC_THREADS={}",
+            threads
+        );
+    }
+
+    // Iterations may not share a plain assignment or grow a shared list
+    for body in ["last = i", "out.append(i)"] {
+        let rejected = temp_dir.path().join("rejected.py");
+        std::fs::write(
+            &rejected,
+            format!(
+                "def main() -> None:\n\
+                 \x20   last: int = 0\n\
+                 \x20   out: list[int] = []\n\
+                 \x20   for i in prange(10):\n\
+                 \x20       {}\n\
+                 \x20   print(last, len(out))\n\
+                 \n\
+                 main()\n",
+                body
+            ),
+        )
+        .unwrap();
+        cargo_bin_cmd!("pycc")
+            .args([rejected.to_str().unwrap(), "-o", exe.to_str().unwrap()])
+            .assert()
+            .failure()
+            .stderr(predicate::str::contains("prange loop"));
+    }
+}
+
+#[test]
+fn test_pycc_prange_exception() {
+    let temp_dir = TempDir::new().unwrap();
+    let source = temp_dir.path().join("prange_raise.py");
+    let exe = temp_dir.path().join("prange_raise");
+    std::fs::write(
+        &source,
+        "class ErrorA(Exception):\n\
+         \x20   code: int\n\
+         \n\
+         class ErrorB(Exception):\n\
+         \x20   code: int\n\
+         \n\
+         def main() -> None:\n\
+         \x20   n: int = 100000\n\
+         \x20   out: list[int] = []\n\
+         \x20   for i in range(n):\n\
+         \x20       out.append(0)\n\
+         \x20   try:\n\
+         \x20       for i in prange(n):\n\
+         \x20           out[i] = 1\n\
+         \x20           if i == 500:\n\
+         \x20               raise ErrorA(\"first\")\n\
+         \x20           if i > 500:\n\
+         \x20               raise ErrorB(\"later\")\n\
+         \x20           out[i] = 2\n\
+         \x20   except ErrorA:\n\
+         \x20       print(\"A\")\n\
+         \x20   except ErrorB:\n\
+         \x20       print(\"B\")\n\
+         \x20   print(out[500])\n\
+         \x20   ran: int = 0\n\
+         \x20   for v in out:\n\
+         \x20       ran += v\n\
+         \x20   print(ran)\n\
+         \n\
+         main()\n",
+    )
+    .unwrap();
+    cargo_bin_cmd!("pycc")
+        .args([source.to_str().unwrap(), "-o", exe.to_str().unwrap()])
+        .assert()
+        .success();
+
+    // Sequentially the loop stops at the first raise: 0..499 ran to the end,
+    // 500 stopped at its raise, and no later iteration ran
+    let output = std::process::Command::new(&exe)
+        .env("PYC_THREADS", "1")
+        .output()
+        .expect("Failed to run compiled executable");
+    assert!(output.status.success());
+    assert_eq!(String::from_utf8_lossy(&output.stdout), "A\n1\n1001\n");
+
+    // In parallel another chunk may raise first, but each chunk stops at its
+    // first raise and chunks not yet started are skipped: past the first
+    // 501 iterations, only the first iteration of each chunk ran
+    let output = std::process::Command::new(&exe)
+        .env("PYC_THREADS", "4")
+        .output()
+        .expect("Failed to run compiled executable");
+    assert!(output.status.success());
+    let stdout = String::from_utf8_lossy(&output.stdout);
+    let lines: Vec<&str> = stdout.lines().collect();
+    assert_eq!(lines.len(), 3, "{stdout}");
+    assert!(lines[0] == "A" || lines[0] == "B", "{stdout}");
+    assert!(lines[1] == "0" || lines[1] == "1", "{stdout}");
+    let ran: i64 = lines[2].parse().unwrap();
+    assert!(ran <= 1001 + 4 * 8 * 2, "{stdout}");
+}
+
+#[test]
+fn test_pycc_file_io() {
+    let temp_dir = TempDir::new().unwrap();
+    let source = temp_dir.path().join("files.py");
+    let exe = temp_dir.path().join("files");
+    let data = temp_dir.path().join("data.txt");
+    let log = temp_dir.path().join("log.txt");
+    let missing = temp_dir.path().join("missing.txt");
+
+    // data.txt is large enough for read() to map it; log.txt is left open and
+    // must be flushed at exit
+    std::fs::write(
+        &source,
+        format!(
+            "def count_lines(f: TextIO) -> int:\n\
+             \x20   count: int = 0\n\
+             \x20   for line in f:\n\
+             \x20       if line.startswith(\"line 1\"):\n\
+             \x20           count += 1\n\
+             \x20   return count\n\
+             \n\
+             def main() -> None:\n\
+             \x20   out: TextIO = open(\"{data}\", \"w\")\n\
+             \x20   for i in range(20000):\n\
+             \x20       out.write(\"line \" + str(i) + \"\\n\")\n\
+             \x20   out.close()\n\
+             \x20   f: TextIO = open(\"{data}\")\n\
+             \x20   print(count_lines(f))\n\
+             \x20   f.close()\n\
+             \x20   text: str = open(\"{data}\").read()\n\
+             \x20   print(len(text))\n\
+             \x20   b: BinaryIO = open(\"{data}\", \"rb\")\n\
+             \x20   data: bytes = b.read()\n\
+             \x20   print(len(data), data[0])\n\
+             \x20   b.close()\n\
+             \x20   try:\n\
+             \x20       m: TextIO = open(\"{missing}\")\n\
+             \x20   except FileNotFoundError:\n\
+             \x20       print(\"not found\")\n\
+             \x20   try:\n\
+             \x20       m2: TextIO = open(\"{missing}\", \"r\")\n\
+             \x20   except OSError:\n\
+             \x20       print(\"os error\")\n\
+             \x20   log: TextIO = open(\"{log}\", \"a\")\n\
+             \x20   log.write(\"done\\n\")\n\
+             \n\
+             main()\n",
+            data = data.display(),
+            log = log.display(),
+            missing = missing.display(),
+        ),
+    )
+    .unwrap();
+    cargo_bin_cmd!("pycc")
+        .args([source.to_str().unwrap(), "-o", exe.to_str().unwrap()])
+        .assert()
+        .success();
+
+    let output = std::process::Command::new(&exe)
+        .output()
+        .expect("Failed to run compiled executable");
+    assert!(output.status.success());
+    assert_eq!(
+        String::from_utf8_lossy(&output.stdout),
+        "11111\n208890\n208890 108\nnot found\nos error\n"
+    );
+    assert_eq!(std::fs::read_to_string(&log).unwrap(), "done\n");
+
+    // The mode must be a literal the runtime supports
+    let rejected = temp_dir.path().join("rejected.py");
+    std::fs::write(
+        &rejected,
+        "def main() -> None:\n\
+         \x20   f: TextIO = open(\"data.txt\", \"r+\")\n\
+         \n\
+         main()\n",
+    )
+    .unwrap();
+    cargo_bin_cmd!("pycc")
+        .args([rejected.to_str().unwrap(), "-o", exe.to_str().unwrap()])
+        .assert()
+        .failure()
+        .stderr(predicate::str::contains("open() mode"));
+}
+
+#[test]
+fn test_pycc_output_flushed_on_uncaught_exception() {
+    let temp_dir = TempDir::new().unwrap();
+    let source = temp_dir.path().join("uncaught.py");
+    let exe = temp_dir.path().join("uncaught");
+
+    // Enough lines to fill the stdout buffer more than once before the raise
+    std::fs::write(
+        &source,
+        "def main() -> None:\n\
+         \x20   i: int = 0\n\
+         \x20   while i < 20000:\n\
+         \x20       print(\"line\", i)\n\
+         \x20       i = i + 1\n\
+         \x20   raise Exception(\"stop\")\n\
+         \n\
+         main()\n",
+    )
+    .unwrap();
+
+    cargo_bin_cmd!("pycc")
+        .args([source.to_str().unwrap(), "-o", exe.to_str().unwrap()])
+        .assert()
+        .success();
+
+    let output = std::process::Command::new(&exe)
+        .output()
+        .expect("Failed to run compiled executable");
+    assert!(!output.status.success());
+
+    let stdout = String::from_utf8_lossy(&output.stdout);
+    let expected: String = (0..20000).map(|i| format!("line {i}\n")).collect();
+    assert!(stdout == expected, "buffered output lost or reordered");
+    assert!(String::from_utf8_lossy(&output.stderr).contains("Uncaught exception"));
+}
+
 #[test]
 fn test_pycc_compile_riscv64() {
     let temp_dir = TempDir::new().unwrap();